@@ -8,11 +8,20 @@
 #include <hwinfo/utils/unit.h>
 
 #include <cassert>
+#include <string_view>
 #include <vector>
 
 using hwinfo::unit::bytes_to_MiB;
 
 int main(int argc, char** argv) {
+  if (argc > 1 && std::string_view(argv[1]) == "--json") {
+    // one JSON document of all subsystems on stdout, terminated by a newline
+    hwinfo::JsonWriter json(1, hwinfo::JsonWriter::Format::Ndjson);
+    hwinfo::to_json(json, hwinfo::collect());
+    json.flush();
+    return json.ok() ? 0 : 1;
+  }
+
   fmt::print(
       "hwinfo is an open source, MIT licensed project that implements a platform independent "
       "hardware and system information gathering API for C++.\n\n"
@@ -240,5 +249,17 @@ int main(int argc, char** argv) {
     fmt::print("No Monitors detected\n");
   }
 
+  const auto pci_devices = hwinfo::getAllPCIDevices();
+  fmt::print("------------------------------- PCI Devices ---------------------------------\n");
+  if (!pci_devices.empty()) {
+    for (const auto& device : pci_devices) {
+      fmt::print("{} [{:04x}:{:04x}] class {:06x}: {} {} (driver: {})\n", device.address(), device.vendor_id(),
+                 device.device_id(), device.class_code(), device.vendor(), device.name(),
+                 device.driver().empty() ? "none" : device.driver());
+    }
+  } else {
+    fmt::print("No PCI devices detected\n");
+  }
+
   return EXIT_SUCCESS;
 }
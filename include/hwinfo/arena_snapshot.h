@@ -0,0 +1,185 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "hwinfo/platform.h"
+#include "hwinfo/serialization.h"
+#include "hwinfo/snapshot.h"
+#include "hwinfo/utils/arena.h"
+
+namespace hwinfo {
+
+/**
+ * Inventory records of an ArenaSnapshot, one per device. They hold the same attributes as the serialized snapshot
+ * (see serialization.h), strings are views into the arena of the snapshot and -1 marks unknown numbers.
+ */
+struct CpuRecord {
+  int id{-1};
+  std::string_view vendor;
+  std::string_view model;
+  int num_physical_cores{-1};
+  int num_logical_cores{-1};
+  int64_t max_clock_speed_MHz{-1};
+  int64_t regular_clock_speed_MHz{-1};
+  int64_t L1_cache_size_Bytes{-1};
+  int64_t L2_cache_size_Bytes{-1};
+  int64_t L3_cache_size_Bytes{-1};
+  utils::Span<std::string_view> flags;
+};
+
+struct OsRecord {
+  std::string_view name;
+  std::string_view version;
+  std::string_view kernel;
+  bool is_64bit{false};
+  bool little_endian{false};
+};
+
+struct GpuRecord {
+  int id{-1};
+  std::string_view vendor;
+  std::string_view name;
+  std::string_view driver_version;
+  int64_t memory_Bytes{-1};
+  int64_t frequency_MHz{-1};
+  int num_cores{-1};
+  std::string_view vendor_id;
+  std::string_view device_id;
+  std::string_view pci_bus_id;
+};
+
+struct MemoryModuleRecord {
+  int id{-1};
+  std::string_view vendor;
+  std::string_view name;
+  std::string_view model;
+  std::string_view serial_number;
+  int64_t total_Bytes{-1};
+  int64_t frequency_Hz{-1};
+};
+
+struct MemoryRecord {
+  int64_t total_Bytes{-1};
+  utils::Span<MemoryModuleRecord> modules;
+};
+
+struct MainBoardRecord {
+  std::string_view vendor;
+  std::string_view name;
+  std::string_view version;
+  std::string_view serial_number;
+};
+
+struct BatteryRecord {
+  std::string_view vendor;
+  std::string_view model;
+  std::string_view serial_number;
+  std::string_view technology;
+  int64_t energy_full{-1};
+};
+
+struct DiskRecord {
+  int id{-1};
+  std::string_view vendor;
+  std::string_view model;
+  std::string_view serial_number;
+  int64_t size_Bytes{-1};
+  utils::Span<std::string_view> volumes;
+};
+
+struct NetworkRecord {
+  std::string_view interface_index;
+  std::string_view description;
+  std::string_view mac;
+  std::string_view ip4;
+  utils::Span<std::string_view> ip6_addresses;
+  std::string_view type;
+  int mtu{-1};
+  int64_t link_speed_Mbps{-1};
+};
+
+struct MonitorRecord {
+  std::string_view vendor;
+  std::string_view model;
+  std::string_view resolution;
+  std::string_view refresh_rate;
+  std::string_view serial_number;
+};
+
+struct PciRecord {
+  std::string_view address;
+  uint16_t vendor_id{0};
+  uint16_t device_id{0};
+  uint16_t subvendor_id{0};
+  uint16_t subdevice_id{0};
+  uint32_t class_code{0};
+  std::string_view vendor;
+  std::string_view name;
+  std::string_view subsystem;
+  std::string_view driver;
+  int numa_node{-1};
+  std::string_view link_speed;
+  int link_width{-1};
+};
+
+/**
+ * Inventory of a Snapshot (or of a serialized one) in a single arena: the record arrays and all strings live in a few
+ * large blocks, identifiers, vendor and model names, flags and constants::UNKNOWN are interned. Copying records is
+ * cheap, destroying the snapshot frees everything at once. For 500 network interfaces this is a handful of
+ * allocations instead of thousands of std::strings.
+ *
+ * Records and views stay valid while the snapshot exists, including after it was moved.
+ */
+class HWINFO_API ArenaSnapshot {
+ public:
+  ArenaSnapshot() = default;
+  explicit ArenaSnapshot(const Snapshot& snapshot, size_t block_size_Bytes = 16 * 1024);
+  // decodes a buffer of serializeSnapshot() (e.g. InventoryCache::view()), the buffer is not referenced afterwards
+  explicit ArenaSnapshot(const SnapshotView& view, size_t block_size_Bytes = 16 * 1024);
+
+  ArenaSnapshot(const ArenaSnapshot&) = delete;
+  ArenaSnapshot& operator=(const ArenaSnapshot&) = delete;
+  ArenaSnapshot(ArenaSnapshot&&) noexcept = default;
+  ArenaSnapshot& operator=(ArenaSnapshot&&) noexcept = default;
+
+  HWI_NODISCARD utils::Span<CpuRecord> cpus() const { return _cpus; }
+  // nullptr if the subsystem was not collected
+  HWI_NODISCARD const OsRecord* os() const { return _os; }
+  HWI_NODISCARD utils::Span<GpuRecord> gpus() const { return _gpus; }
+  // nullptr if the subsystem was not collected
+  HWI_NODISCARD const MemoryRecord* ram() const { return _ram; }
+  // nullptr if the subsystem was not collected
+  HWI_NODISCARD const MainBoardRecord* mainboard() const { return _mainboard; }
+  HWI_NODISCARD utils::Span<BatteryRecord> batteries() const { return _batteries; }
+  HWI_NODISCARD utils::Span<DiskRecord> disks() const { return _disks; }
+  HWI_NODISCARD utils::Span<NetworkRecord> networks() const { return _networks; }
+  HWI_NODISCARD utils::Span<MonitorRecord> monitors() const { return _monitors; }
+  HWI_NODISCARD utils::Span<PciRecord> pci_devices() const { return _pci_devices; }
+
+  HWI_NODISCARD const utils::Arena& arena() const { return _arena; }
+
+ private:
+  utils::Arena _arena;
+  utils::Span<CpuRecord> _cpus;
+  const OsRecord* _os{nullptr};
+  utils::Span<GpuRecord> _gpus;
+  const MemoryRecord* _ram{nullptr};
+  const MainBoardRecord* _mainboard{nullptr};
+  utils::Span<BatteryRecord> _batteries;
+  utils::Span<DiskRecord> _disks;
+  utils::Span<NetworkRecord> _networks;
+  utils::Span<MonitorRecord> _monitors;
+  utils::Span<PciRecord> _pci_devices;
+};
+
+/**
+ * collect() into an ArenaSnapshot. The intermediate Snapshot is released before returning.
+ */
+ArenaSnapshot collectArena(const Options& options = {});
+
+}  // namespace hwinfo
@@ -35,14 +35,37 @@ class HWINFO_API Battery {
   [[nodiscard]] uint32_t energyNow() const;
   [[nodiscard]] bool charging() const;
   [[nodiscard]] bool discharging() const;
+  /**
+   * Power flowing out of (discharging) or into (charging) the battery in watts, never negative. Linux: power_now or
+   * current_now * voltage_now, macOS: current times voltage of the power source.
+   * @return -1 if the platform does not report it
+   */
+  [[nodiscard]] double powerNow_W() const;
+
+  /**
+   * Rereads the dynamic state (energy now, charging status, power) in one go: Linux reads the uevent file of the
+   * power supply once through a handle kept open since the first read. energyNow(), charging() and powerNow_W()
+   * always read the current state, lastEnergyNow(), lastCharging() and lastPower_W() return the state of the last
+   * refresh().
+   * @return false if the battery could not be read
+   */
+  bool refresh();
+  [[nodiscard]] uint32_t lastEnergyNow() const;
+  [[nodiscard]] bool lastCharging() const;
+  [[nodiscard]] double lastPower_W() const;
 
  private:
   int _id = -1;
+  // Linux: name of the power supply in /sys/class/power_supply, "BAT<id>" if empty
+  std::string _name;
   std::string _vendor;
   std::string _model;
   std::string _serialNumber;
   std::string _technology;
   uint32_t _energyFull = 0;
+  uint32_t _energyNow = 0;
+  bool _charging = false;
+  double _power_W = -1.0;
 };
 
 std::vector<Battery> getAllBatteries();
@@ -0,0 +1,222 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+/**
+ * C interface to hwinfo::collect() for bindings (Go, Rust, Python, ...). A snapshot is collected with a single call
+ * and then copied out per subsystem into caller-allocated arrays of flat records. Records contain no pointers: strings
+ * are (offset, length) references into one string buffer of the snapshot, lists of strings are ranges of the shared
+ * list item array. A binding thus needs one call per subsystem, one copy of the string buffer and no per-field calls.
+ *
+ * The layout of the records only changes together with HWINFO_C_ABI_VERSION, compare it against hwinfo_abi_version()
+ * at runtime. Unknown numbers are -1, unknown strings are "<unknown>" like in the C++ API.
+ *
+ * Functions taking a snapshot accept NULL and then behave as for an empty snapshot. Nothing in this interface throws.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hwinfo/platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HWINFO_C_ABI_VERSION 1
+
+/**
+ * Subsystems to collect, combined with |.
+ */
+#define HWINFO_SUBSYSTEM_CPU (1u << 0)
+#define HWINFO_SUBSYSTEM_OS (1u << 1)
+#define HWINFO_SUBSYSTEM_GPU (1u << 2)
+#define HWINFO_SUBSYSTEM_RAM (1u << 3)
+#define HWINFO_SUBSYSTEM_MAINBOARD (1u << 4)
+#define HWINFO_SUBSYSTEM_BATTERY (1u << 5)
+#define HWINFO_SUBSYSTEM_DISK (1u << 6)
+#define HWINFO_SUBSYSTEM_NETWORK (1u << 7)
+#define HWINFO_SUBSYSTEM_MONITOR (1u << 8)
+#define HWINFO_SUBSYSTEM_PCI (1u << 9)
+#define HWINFO_SUBSYSTEM_ALL ((1u << 10) - 1)
+
+/**
+ * A string of the snapshot: length bytes at offset in the buffer of hwinfo_strings(), followed by a null character.
+ */
+typedef struct hwinfo_str {
+  uint32_t offset;
+  uint32_t length;
+} hwinfo_str;
+
+/**
+ * count strings starting at index first of the array filled by hwinfo_get_list_items().
+ */
+typedef struct hwinfo_list {
+  uint32_t first;
+  uint32_t count;
+} hwinfo_list;
+
+typedef struct hwinfo_cpu {
+  int32_t id;
+  int32_t num_physical_cores;
+  int32_t num_logical_cores;
+  int32_t reserved;
+  int64_t max_clock_speed_MHz;
+  int64_t regular_clock_speed_MHz;
+  int64_t L1_cache_size_Bytes;
+  int64_t L2_cache_size_Bytes;
+  int64_t L3_cache_size_Bytes;
+  hwinfo_str vendor;
+  hwinfo_str model;
+  hwinfo_list flags;
+} hwinfo_cpu;
+
+typedef struct hwinfo_os {
+  hwinfo_str name;
+  hwinfo_str version;
+  hwinfo_str kernel;
+  int32_t is_64bit;
+  int32_t little_endian;
+} hwinfo_os;
+
+typedef struct hwinfo_gpu {
+  int32_t id;
+  int32_t num_cores;
+  int64_t memory_Bytes;
+  int64_t frequency_MHz;
+  hwinfo_str vendor;
+  hwinfo_str name;
+  hwinfo_str driver_version;
+  hwinfo_str vendor_id;
+  hwinfo_str device_id;
+  hwinfo_str pci_bus_id;
+} hwinfo_gpu;
+
+typedef struct hwinfo_memory {
+  int64_t total_Bytes;
+  // number of records of hwinfo_get_memory_modules()
+  int64_t num_modules;
+} hwinfo_memory;
+
+typedef struct hwinfo_memory_module {
+  int32_t id;
+  int32_t reserved;
+  int64_t total_Bytes;
+  int64_t frequency_Hz;
+  hwinfo_str vendor;
+  hwinfo_str name;
+  hwinfo_str model;
+  hwinfo_str serial_number;
+} hwinfo_memory_module;
+
+typedef struct hwinfo_mainboard {
+  hwinfo_str vendor;
+  hwinfo_str name;
+  hwinfo_str version;
+  hwinfo_str serial_number;
+} hwinfo_mainboard;
+
+typedef struct hwinfo_battery {
+  int64_t energy_full;
+  hwinfo_str vendor;
+  hwinfo_str model;
+  hwinfo_str serial_number;
+  hwinfo_str technology;
+} hwinfo_battery;
+
+typedef struct hwinfo_disk {
+  int32_t id;
+  int32_t reserved;
+  int64_t size_Bytes;
+  hwinfo_str vendor;
+  hwinfo_str model;
+  hwinfo_str serial_number;
+  hwinfo_list volumes;
+} hwinfo_disk;
+
+typedef struct hwinfo_network {
+  int32_t mtu;
+  int32_t reserved;
+  int64_t link_speed_Mbps;
+  hwinfo_str interface_index;
+  hwinfo_str description;
+  hwinfo_str mac;
+  hwinfo_str ip4;
+  hwinfo_str type;
+  hwinfo_list ip6_addresses;
+} hwinfo_network;
+
+typedef struct hwinfo_monitor {
+  hwinfo_str vendor;
+  hwinfo_str model;
+  hwinfo_str resolution;
+  hwinfo_str refresh_rate;
+  hwinfo_str serial_number;
+} hwinfo_monitor;
+
+typedef struct hwinfo_pci_device {
+  uint16_t vendor_id;
+  uint16_t device_id;
+  uint16_t subvendor_id;
+  uint16_t subdevice_id;
+  uint32_t class_code;
+  int32_t numa_node;
+  int32_t link_width;
+  int32_t reserved;
+  hwinfo_str address;
+  hwinfo_str vendor;
+  hwinfo_str name;
+  hwinfo_str subsystem;
+  hwinfo_str driver;
+  hwinfo_str link_speed;
+} hwinfo_pci_device;
+
+typedef struct hwinfo_snapshot hwinfo_snapshot;
+
+/**
+ * @return HWINFO_C_ABI_VERSION of the library
+ */
+HWINFO_API uint32_t hwinfo_abi_version(void);
+
+/**
+ * Collects the subsystems (HWINFO_SUBSYSTEM_*) concurrently, see hwinfo::collect().
+ * @param num_threads worker threads, 0: one per subsystem but at most the number of hardware threads
+ * @return the snapshot, release it with hwinfo_snapshot_free(), or NULL if it could not be allocated
+ */
+HWINFO_API hwinfo_snapshot* hwinfo_collect(uint32_t subsystems, uint32_t num_threads);
+
+HWINFO_API void hwinfo_snapshot_free(hwinfo_snapshot* snapshot);
+
+/**
+ * The string buffer all hwinfo_str of the snapshot refer to. It is valid until the snapshot is freed.
+ * @param size receives the size of the buffer in bytes, may be NULL
+ */
+HWINFO_API const char* hwinfo_strings(const hwinfo_snapshot* snapshot, size_t* size);
+
+/**
+ * The functions below copy min(capacity, count) records into out and return count, the number of records of the
+ * snapshot. Pass capacity 0 (out may be NULL then) to query the size of the array to allocate.
+ */
+HWINFO_API size_t hwinfo_get_list_items(const hwinfo_snapshot* snapshot, hwinfo_str* out, size_t capacity);
+HWINFO_API size_t hwinfo_get_cpus(const hwinfo_snapshot* snapshot, hwinfo_cpu* out, size_t capacity);
+HWINFO_API size_t hwinfo_get_gpus(const hwinfo_snapshot* snapshot, hwinfo_gpu* out, size_t capacity);
+HWINFO_API size_t hwinfo_get_memory_modules(const hwinfo_snapshot* snapshot, hwinfo_memory_module* out,
+                                            size_t capacity);
+HWINFO_API size_t hwinfo_get_batteries(const hwinfo_snapshot* snapshot, hwinfo_battery* out, size_t capacity);
+HWINFO_API size_t hwinfo_get_disks(const hwinfo_snapshot* snapshot, hwinfo_disk* out, size_t capacity);
+HWINFO_API size_t hwinfo_get_networks(const hwinfo_snapshot* snapshot, hwinfo_network* out, size_t capacity);
+HWINFO_API size_t hwinfo_get_monitors(const hwinfo_snapshot* snapshot, hwinfo_monitor* out, size_t capacity);
+HWINFO_API size_t hwinfo_get_pci_devices(const hwinfo_snapshot* snapshot, hwinfo_pci_device* out, size_t capacity);
+
+/**
+ * Subsystems with a single record.
+ * @return 1 if out was filled, 0 if the subsystem was not collected
+ */
+HWINFO_API int hwinfo_get_os(const hwinfo_snapshot* snapshot, hwinfo_os* out);
+HWINFO_API int hwinfo_get_memory(const hwinfo_snapshot* snapshot, hwinfo_memory* out);
+HWINFO_API int hwinfo_get_mainboard(const hwinfo_snapshot* snapshot, hwinfo_mainboard* out);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
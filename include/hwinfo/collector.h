@@ -0,0 +1,172 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hwinfo/cpu.h"
+#include "hwinfo/disk.h"
+#include "hwinfo/gpu.h"
+#include "hwinfo/network.h"
+#include "hwinfo/perf_counters.h"
+#include "hwinfo/platform.h"
+#include "hwinfo/process.h"
+#include "hwinfo/ram.h"
+#include "hwinfo/utils/ring_buffer.h"
+
+namespace hwinfo {
+
+class TimeSeriesStore;
+
+enum class Metric : uint8_t {
+  // values: utilisation in [0, 1]. index: logical CPU, Record::total for all CPUs
+  CpuUtilisation,
+  // values: MHz (see FrequencySampler). index: logical CPU
+  CpuFrequency,
+  // values: available, total, swap free, swap total (Bytes). index: Record::total
+  Memory,
+  // values: read Bytes/s, write Bytes/s, IOPS (reads + writes), utilisation in [0, 1]. index: disk
+  DiskIO,
+  // values: received Bytes/s, sent Bytes/s, received packets/s, sent packets/s. index: interface
+  Network,
+  // values: utilisation in [0, 1], frequency MHz, used memory Bytes, power W. index: GPU
+  Gpu,
+  // values: CPU utilisation in logical CPUs, resident Bytes, page faults/s, context switches/s of the collecting
+  // process (see ProcessSampler). index: Record::total
+  Process,
+  // values: instructions per cycle, last level cache misses and branch misses per 1000 instructions, stalled backend
+  // cycles per cycle (see PerfCounterSampler). index: logical CPU, Record::total for all CPUs
+  PerfCounters,
+  // The totals are the cumulative counters behind the rates above, pushed with them at the same interval. A
+  // TimeSeriesStore keeps them as Counter series and derives rates over any window with TimeSeriesStore::rate().
+  // values: received Bytes, sent Bytes, received packets, sent packets. index: interface
+  NetworkTotals,
+  // values: read Bytes, written Bytes, completed requests, busy time ms. index: disk
+  DiskIOTotals,
+  // values: CPU time in microseconds (user + system), minor page faults, major page faults, context switches of the
+  // collecting process. index: Record::total
+  ProcessTotals,
+};
+
+/**
+ * One fixed-size sample of one source. Values that are not available are -1, unused values are 0. Use
+ * Collector::sourceName() to map the index of disks, interfaces and GPUs to a name.
+ */
+struct Record {
+  static constexpr uint16_t total = 0xffff;
+
+  std::chrono::steady_clock::time_point timestamp;
+  Metric metric;
+  uint16_t index;
+  double values[4];
+};
+
+/**
+ * Sampling interval per metric, zero disables a metric.
+ */
+struct CollectorOptions {
+  std::chrono::milliseconds cpu_utilisation{1000};
+  std::chrono::milliseconds cpu_frequency{0};
+  std::chrono::milliseconds memory{1000};
+  std::chrono::milliseconds disk_io{1000};
+  std::chrono::milliseconds network{1000};
+  std::chrono::milliseconds gpu{0};
+  std::chrono::milliseconds process{0};
+  std::chrono::milliseconds perf_counters{0};
+  // number of records the ring buffer holds, records are dropped while it is full
+  size_t capacity{4096};
+};
+
+/**
+ * Background telemetry: one thread samples every enabled metric at its interval through the per-subsystem samplers
+ * (CpuSampler, FrequencySampler, MemorySampler, DiskIOSampler, Network::refresh(), GPUMonitor, ProcessSampler,
+ * PerfCounterSampler), which keep their files and handles open, and pushes the records into a lock-free ring buffer.
+ * Networks are refreshed with NetworkFields::Statistics only (one RTM_GETLINK per interface on Linux). Any number of
+ * threads can consume the records with pop() without taking a lock.
+ */
+class HWINFO_API Collector {
+ public:
+  explicit Collector(const CollectorOptions& options = {});
+  ~Collector();
+
+  Collector(const Collector&) = delete;
+  Collector& operator=(const Collector&) = delete;
+
+  void start();
+  void stop();
+  HWI_NODISCARD bool running() const;
+
+  /**
+   * Takes the oldest record. Lock-free, may be called from several threads.
+   * @return false if no record is buffered
+   */
+  bool pop(Record& out);
+  // takes up to max records into out, returns the number of records taken
+  size_t pop(Record* out, size_t max);
+  // takes all buffered records into the columnar store, returns the number of records taken
+  size_t drain(TimeSeriesStore& store);
+
+  // records that were discarded because the ring buffer was full
+  HWI_NODISCARD uint64_t dropped() const;
+
+  /**
+   * @return the device name of a disk ("nvme0n1"), the interface name of a network or the name of a GPU (also for
+   *         the totals of disks and networks), empty for other metrics or unknown indices
+   */
+  HWI_NODISCARD std::string sourceName(Metric metric, uint16_t index) const;
+
+ private:
+  void run();
+  void push(Metric metric, uint16_t index, std::chrono::steady_clock::time_point timestamp,
+            std::initializer_list<double> values);
+  uint16_t diskIndex(const std::string& name);
+
+  void sampleCpu(std::chrono::steady_clock::time_point now);
+  void sampleFrequency(std::chrono::steady_clock::time_point now);
+  void sampleMemory(std::chrono::steady_clock::time_point now);
+  void sampleDisks(std::chrono::steady_clock::time_point now);
+  void sampleNetworks(std::chrono::steady_clock::time_point now);
+  void sampleGpus(std::chrono::steady_clock::time_point now);
+  void sampleProcess(std::chrono::steady_clock::time_point now);
+  void samplePerfCounters(std::chrono::steady_clock::time_point now);
+
+  CollectorOptions _options;
+  utils::RingBuffer<Record> _records;
+  std::atomic<uint64_t> _dropped{0};
+
+  // owned by the collector thread while it runs
+  CpuSampler _cpu;
+  std::unique_ptr<FrequencySampler> _frequency;
+  std::vector<int64_t> _frequencies_MHz;
+  std::unique_ptr<MemorySampler> _memory;
+  DiskIOSampler _disks;
+  std::vector<Network> _networks;
+  std::vector<Network::Statistics> _last_network;
+  std::chrono::steady_clock::time_point _last_network_time;
+  std::vector<std::unique_ptr<GPUMonitor>> _gpus;
+  std::unique_ptr<ProcessSampler> _process;
+  std::unique_ptr<PerfCounterSampler> _perf_counters;
+
+  // names of the sources, written by the collector thread and read by sourceName()
+  mutable std::mutex _names_mutex;
+  std::vector<std::string> _disk_names;
+  std::vector<std::string> _network_names;
+  std::vector<std::string> _gpu_names;
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  bool _stop{false};
+  std::thread _thread;
+};
+
+}  // namespace hwinfo
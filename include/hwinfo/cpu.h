@@ -3,16 +3,28 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "hwinfo/platform.h"
+#include "hwinfo/utils/lazy.h"
 #include "hwinfo/utils/wmi_wrapper.h"
 
 namespace hwinfo {
-#ifdef HWINFO_UNIX
-struct Jiffies {
+
+/**
+ * Cumulative CPU time counters of one logical CPU (or of all CPUs combined). On Linux the values are read from
+ * /proc/stat in USER_HZ ticks, other platforms use their native tick unit. Only deltas between two snapshots are
+ * meaningful.
+ */
+struct HWINFO_API Jiffies {
   Jiffies() {
     working = -1;
     all = -1;
@@ -23,10 +35,275 @@ struct Jiffies {
     working = _working;
   }
 
+  /**
+   * Utilisation in [0, 1] over the period from `last` to this snapshot. Returns -1 if the period is empty or the
+   * counters went backwards.
+   */
+  HWI_NODISCARD double utilisation_since(const Jiffies& last) const;
+
   int64_t working;
   int64_t all;
+
+  // individual counters, filled on Linux (see proc(5), /proc/stat) and Windows (user, system, idle, irq: interrupt
+  // time, softirq: DPC time)
+  int64_t user{0};
+  int64_t nice{0};
+  int64_t system{0};
+  int64_t idle{0};
+  int64_t iowait{0};
+  int64_t irq{0};
+  int64_t softirq{0};
+  int64_t steal{0};
+  int64_t guest{0};
+  int64_t guest_nice{0};
+};
+
+/**
+ * Non-blocking CPU utilisation sampler.
+ *
+ * The baseline snapshot of the CPU time counters is taken on construction. Every call to sample() returns the
+ * utilisation in the period since the previous call (or since construction) and makes the current snapshot the new
+ * baseline. Each sampler owns its state, so several samplers can be used independently at different intervals.
+ */
+class HWINFO_API CpuSampler {
+  friend class CPU;
+
+ public:
+  struct Sample {
+    // utilisation of all logical CPUs combined in [0, 1], -1 if not available
+    double total{-1.0};
+    // utilisation per logical CPU in [0, 1], -1 if not available. Windows numbers the CPUs group * 64 + number like
+    // getCpuTopology(), numbers without a processor in a group report -1.
+    std::vector<double> threads;
+  };
+
+  CpuSampler();
+  ~CpuSampler() = default;
+  // readers may hold a reference while sample() publishes, a moved-from sampler would leave them without state
+  CpuSampler(const CpuSampler&) = delete;
+  CpuSampler& operator=(const CpuSampler&) = delete;
+
+  /**
+   * Takes a sample and publishes it for latest(). Only one thread may call sample() at a time.
+   */
+  Sample sample();
+
+  /**
+   * Copies the most recently published sample into out, reusing its capacity. Any number of threads may call this
+   * concurrently with the thread calling sample(): the sample is published through a sequence lock of atomics, readers
+   * never block the writer and retry if a sample was published while they were copying.
+   * @return false if no sample was published yet
+   */
+  bool latest(Sample& out) const;
+
+  // number of samples published so far
+  HWI_NODISCARD uint64_t sequence() const;
+
+ private:
+  // Platform specific: index 0 holds the counters of all CPUs, index i + 1 those of logical CPU i.
+  static std::vector<Jiffies> snapshot();
+
+  // published values: index 0 is the total, index i + 1 thread i. The number of slots is fixed on construction.
+  struct Published {
+    explicit Published(size_t size) : values(new std::atomic<double>[size]), num_values(size) {}
+    // odd while sample() is writing
+    std::atomic<uint64_t> version{0};
+    std::unique_ptr<std::atomic<double>[]> values;
+    size_t num_values;
+  };
+
+  std::vector<Jiffies> _last;
+  std::unique_ptr<Published> _published;
+};
+
+/**
+ * Per logical CPU frequency for frequent polling (e.g. a DVFS controller at 50 Hz). The counter or attribute files are
+ * opened once on construction and reread with one pread each per sample, no paths are built and nothing is allocated.
+ *
+ * On x86 Linux with a readable /dev/cpu/<N>/msr (msr module loaded, root or CAP_SYS_RAWIO) the effective busy
+ * frequency since the previous sample is reported: TSC rate * dAPERF / dMPERF, like turbostat's Bzy_MHz. Otherwise the
+ * current cpufreq frequency (scaling_cur_freq) is reported. Windows reports CallNtPowerInformation's CurrentMhz.
+ */
+class HWINFO_API FrequencySampler {
+ public:
+  FrequencySampler();
+  ~FrequencySampler();
+  FrequencySampler(const FrequencySampler&) = delete;
+  FrequencySampler& operator=(const FrequencySampler&) = delete;
+
+  /**
+   * Writes the frequency of logical CPU i to out_MHz[i] for i < size. CPUs without a reading (offline, no cpufreq) get
+   * -1, CPUs that were idle during the whole period get 0 in effective mode. The first effective sample reports the
+   * average since boot, a CPU whose counters could not be read before reports -1 once and gets its baseline.
+   * @return the number of logical CPUs, may be larger than size
+   */
+  size_t sample(int64_t* out_MHz, size_t size);
+  // resizes out_MHz to the number of logical CPUs, its capacity is reused between calls
+  void sample(std::vector<int64_t>& out_MHz);
+
+  // true if the effective frequency (APERF/MPERF) is reported
+  HWI_NODISCARD bool effective() const;
+
+ private:
+  struct Counters {
+    uint64_t tsc{0};
+    uint64_t aperf{0};
+    uint64_t mperf{0};
+    // monotonic time of the reading, 0 while the CPU has no baseline
+    int64_t time_ns{0};
+  };
+
+  // one descriptor per logical CPU: the msr device in effective mode, scaling_cur_freq otherwise (-1 if unavailable)
+  std::vector<int> _fds;
+  // one entry per logical CPU on all platforms
+  std::vector<Counters> _last;
+  bool _effective{false};
+};
+
+/**
+ * Instruction set extensions. x86 and ARM features share one enum; a feature of the other architecture is never set.
+ */
+enum class Feature : uint8_t {
+  // x86
+  SSE,
+  SSE2,
+  SSE3,
+  SSSE3,
+  SSE4_1,
+  SSE4_2,
+  POPCNT,
+  AES,
+  PCLMULQDQ,
+  AVX,
+  F16C,
+  FMA,
+  AVX2,
+  BMI1,
+  BMI2,
+  LZCNT,
+  MOVBE,
+  RDRAND,
+  SHA,
+  AVX_VNNI,
+  AVX512F,
+  AVX512DQ,
+  AVX512CD,
+  AVX512BW,
+  AVX512VL,
+  AVX512_VNNI,
+  AVX512_BF16,
+  AVX512_FP16,
+  AMX_TILE,
+  AMX_INT8,
+  AMX_BF16,
+  HYPERVISOR,
+  // ARM (AArch64)
+  NEON,
+  ARM_FP16,
+  ARM_AES,
+  ARM_PMULL,
+  ARM_SHA1,
+  ARM_SHA2,
+  ARM_CRC32,
+  ARM_ATOMICS,
+  ARM_DOTPROD,
+  ARM_I8MM,
+  ARM_BF16,
+  SVE,
+  SVE2,
+  SME,
+
+  COUNT_
+};
+
+/**
+ * Instruction set extensions the CPU supports and the OS enabled (e.g. AVX-512 is only reported if the kernel saves
+ * the ZMM state). Detected once per process: cpuid on x86, getauxval(AT_HWCAP/AT_HWCAP2) on ARM Linux and the
+ * hw.optional sysctls on ARM macOS. has() is a constexpr bit test and cheap enough for every kernel dispatch.
+ */
+class HWINFO_API CpuFeatures {
+ public:
+  constexpr CpuFeatures() = default;
+  constexpr CpuFeatures(std::initializer_list<Feature> features) {
+    for (const Feature feature : features) set(feature);
+  }
+
+  HWI_NODISCARD constexpr bool has(Feature feature) const {
+    const auto index = static_cast<unsigned>(feature);
+    return (_bits[index / 64] >> (index % 64)) & 1u;
+  }
+  constexpr void set(Feature feature) {
+    const auto index = static_cast<unsigned>(feature);
+    _bits[index / 64] |= uint64_t{1} << (index % 64);
+  }
+  // true if every feature of required is supported
+  HWI_NODISCARD constexpr bool has_all(const CpuFeatures& required) const {
+    for (size_t i = 0; i < sizeof(_bits) / sizeof(_bits[0]); ++i) {
+      if ((_bits[i] & required._bits[i]) != required._bits[i]) return false;
+    }
+    return true;
+  }
+
+  /**
+   * @return the lower case name of a feature as used by /proc/cpuinfo (e.g. "avx512f", "asimd" for NEON)
+   */
+  static std::string_view name(Feature feature);
+  // names of all supported features, built on every call
+  HWI_NODISCARD std::vector<std::string_view> names() const;
+
+  // features of the CPU the process runs on, detected on first use (thread-safe)
+  static const CpuFeatures& host();
+
+ private:
+  static CpuFeatures detect();
+
+  uint64_t _bits[(static_cast<unsigned>(Feature::COUNT_) + 63) / 64]{};
+};
+
+/**
+ * Package temperature and power. The sensors are discovered once on construction and their files stay open, so a
+ * reading costs one or two preads:
+ *  - Linux: hwmon coretemp ("Package id N"), k10temp / zenpower (Tdie or Tctl) or the x86_pkg_temp / cpu-thermal
+ *    thermal zones for temperatures, powercap intel-rapl:N (also used by AMD) energy counters for power
+ *  - Windows: the ACPI thermal zones (Win32_PerfFormattedData_Counters_ThermalZoneInformation, else
+ *    MSAcpi_ThermalZoneTemperature, which needs administrator rights), a WMI query per read, all reported as package 0.
+ *    Power comes from the "Energy Meter" performance counters (RAPL_Package<N>_PKG), opened once
+ *  - macOS: the SMC CPU proximity / die keys
+ */
+class HWINFO_API CpuSensors {
+ public:
+  CpuSensors();
+  ~CpuSensors();
+  CpuSensors(const CpuSensors&) = delete;
+  CpuSensors& operator=(const CpuSensors&) = delete;
+
+  // number of packages with at least one sensor
+  HWI_NODISCARD int numPackages() const;
+
+  // temperature of the package in °C, -1 if not available
+  HWI_NODISCARD double packageTemperature_Celsius(int package = 0) const;
+
+  /**
+   * Average power of the package since the previous call (or since construction) in W, -1 if not available. On Linux
+   * the RAPL energy counter (energy_uj) is only readable by root since 5.10.
+   */
+  double packagePower_W(int package = 0);
+
+ private:
+  struct Package {
+    int temperature_fd{-1};
+    int energy_fd{-1};
+    int64_t max_energy_uJ{-1};
+    int64_t last_energy_uJ{-1};
+    int64_t last_time_ns{0};
+    // macOS: SMC key of the temperature
+    uint32_t temperature_key{0};
+  };
+
+  std::vector<Package> _packages;
+  // platform connection (macOS: io_connect_t of the AppleSMC service, Windows: the PDH::EnergyMeter)
+  uintptr_t _handle{0};
 };
-#endif
 
 class HWINFO_API CPU {
   friend std::vector<CPU> getAllCPUs();
@@ -42,6 +319,7 @@ class HWINFO_API CPU {
   int64_t L3CacheSize_Bytes() const;
   int numPhysicalCores() const;
   int numLogicalCores() const;
+  // read on first access of either value (Linux: cpufreq, SMBIOS as fallback), later calls return the cached value
   int64_t maxClockSpeed_MHz() const;
   int64_t regularClockSpeed_MHz() const;
   int64_t currentClockSpeed_MHz(int thread_id) const;
@@ -49,13 +327,13 @@ class HWINFO_API CPU {
   double currentUtilisation() const;
   double threadUtilisation(int thread_index) const;
   std::vector<double> threadsUtilisation() const;
-  // double currentTemperature_Celsius() const;
+  // package temperature of this socket, -1 if not available (see CpuSensors)
+  double currentTemperature_Celsius() const;
+  // flags as listed by the OS (Linux: the "flags" line of /proc/cpuinfo). Use features() to test for an extension.
   const std::vector<std::string>& flags() const;
+  const CpuFeatures& features() const;
 
  private:
-#ifndef HWINFO_WINDOWS
-  void init_jiffies() const;
-#endif
   CPU() = default;
 
   int _id{-1};
@@ -63,15 +341,203 @@ class HWINFO_API CPU {
   std::string _vendor;
   int _numPhysicalCores{-1};
   int _numLogicalCores{-1};
-  int64_t _maxClockSpeed_MHz{-1};
-  int64_t _regularClockSpeed_MHz{-1};
+  struct ClockSpeeds {
+    int64_t max_MHz{-1};
+    int64_t regular_MHz{-1};
+  };
+  // Platform specific, called by the first access of the clock speeds unless getAllCPUs() already set them
+  ClockSpeeds readClockSpeeds() const;
+  utils::Lazy<ClockSpeeds> _clockSpeeds;
   int64_t _L1CacheSize_Bytes{-1};
   int64_t _L2CacheSize_Bytes{-1};
   int64_t _L3CacheSize_Bytes{-1};
   std::vector<std::string> _flags{};
 
-  mutable bool _jiffies_initialized = false;
+  // Baselines of currentUtilisation() (index 0) and threadUtilisation() (index i + 1). Default constructed Jiffies
+  // make the first call report the utilisation since boot. The mutex lets several threads share one CPU object, copies
+  // get a copy of the baselines and their own mutex.
+  struct Baseline {
+    Baseline() = default;
+    Baseline(const Baseline& other);
+    Baseline& operator=(const Baseline& other);
+
+    std::vector<Jiffies> jiffies;
+    mutable std::mutex mutex;
+  };
+  mutable Baseline _baseline;
 };
 
 std::vector<CPU> getAllCPUs();
+
+/**
+ * CPU time the calling process may actually use. Inside containers this is usually much less than the host topology
+ * reported by getAllCPUs(). Values that are not available are -1.
+ */
+struct CpuBudget {
+  // logical CPUs the process may run on (affinity mask, intersected with the cgroup cpuset)
+  std::vector<int> allowed_cpus;
+  // CFS bandwidth quota in CPUs (quota / period, e.g. 2.5), the tightest of the cgroup and its ancestors. Windows: the
+  // CPU rate (or maximum rate) of the job object times the processors of the machine. -1 if unlimited
+  double quota_cpus{-1.0};
+  // min(allowed CPUs, rounded up quota), at least 1. Use this to size thread pools.
+  int effective_cpus{-1};
+
+  // throttling counters of the cgroup (cpu.stat)
+  int64_t nr_periods{-1};
+  int64_t nr_throttled{-1};
+  int64_t throttled_us{-1};
+  // 1 or 2, 0 if the process is not in a cpu cgroup (or on other platforms than Linux)
+  int cgroup_version{0};
+};
+
+/**
+ * Combines the affinity mask (Linux: sched_getaffinity), the cgroup cpuset (cpuset.cpus.effective) and the CFS quota
+ * (cpu.max or cpu.cfs_quota_us / cpu.cfs_period_us). Reads a few small files, cheap enough for thread pool
+ * construction. Windows combines the process affinity mask with the CPU rate control of the job object.
+ */
+CpuBudget getEffectiveCpuBudget();
+
+/**
+ * Hardware topology of the online logical CPUs as a tree package > die > cluster > core > thread, plus the NUMA nodes
+ * and their distances. CPUs are identified by the logical CPU number the OS uses for affinity masks (Linux:
+ * sched_setaffinity, Windows: group * 64 + bit). IDs of packages, dies, clusters and cores are the ones reported by the
+ * OS and are not necessarily consecutive.
+ */
+struct HWINFO_API CpuTopology {
+  struct Core {
+    int id{-1};
+    // logical CPUs of this core (SMT siblings), sorted
+    std::vector<int> cpus;
+    // index into performance_levels
+    int performance_level{0};
+  };
+  struct Cluster {
+    // cores sharing a cache level below the die (e.g. ARM clusters or Intel E-core modules), 0 if not reported
+    int id{0};
+    std::vector<Core> cores;
+  };
+  struct Die {
+    int id{0};
+    std::vector<Cluster> clusters;
+  };
+  struct Package {
+    int id{-1};
+    std::vector<Die> dies;
+  };
+  struct NumaNode {
+    int id{-1};
+    std::vector<int> cpus;
+    int64_t memory_Bytes{-1};
+  };
+  enum class CoreType {
+    // all cores are of the same type
+    Unknown,
+    Performance,
+    Efficiency,
+  };
+  /**
+   * Cores of one class on hybrid CPUs, e.g. the P-cores and E-cores of Apple silicon or Intel Alder Lake. Level 0 is
+   * the fastest class, pin latency-critical threads to its cpus. CPUs with only one class of cores have a single level
+   * with all CPUs.
+   */
+  struct PerformanceLevel {
+    // macOS: hw.perflevel<N>.name ("Performance", "Efficiency"), Linux on Intel hybrid CPUs: "Performance" for
+    // cpu_core and "Efficiency" for cpu_atom, empty otherwise
+    std::string name;
+    // with several levels the slowest one is the efficiency cores and all others are performance cores (e.g. the
+    // prime and big cores of a three-cluster Arm SoC)
+    CoreType type{CoreType::Unknown};
+    int num_physical_cores{0};
+    int num_logical_cores{0};
+    // sizes of one cache instance of this level, only reported on macOS (other platforms: see getCacheHierarchy())
+    int64_t L1_instruction_cache_size_Bytes{-1};
+    int64_t L1_data_cache_size_Bytes{-1};
+    int64_t L2_cache_size_Bytes{-1};
+    // logical CPUs sharing one L2 cache, i.e. the size of a cluster on Apple silicon (macOS only, else -1)
+    int cpus_per_L2{-1};
+    // logical CPUs of this level, sorted
+    std::vector<int> cpus;
+
+    /**
+     * Mean utilisation of the CPUs of this level in a sample of CpuSampler (on macOS a single host_processor_info
+     * call for all CPUs).
+     * @return -1 if the sample holds none of the CPUs
+     */
+    HWI_NODISCARD double utilisation(const CpuSampler::Sample& sample) const;
+  };
+
+  // location of one logical CPU in the tree, indexed by its logical CPU number (-1 for offline CPUs)
+  struct Thread {
+    int package{-1};
+    int die{-1};
+    int cluster{-1};
+    int core{-1};
+    int numa_node{-1};
+    // index into performance_levels
+    int performance_level{0};
+  };
+
+  std::vector<Package> packages;
+  std::vector<Thread> threads;
+  std::vector<NumaNode> numa_nodes;
+  // fastest first. Linux: /sys/devices/cpu_core and cpu_atom, cpuid leaf 0x1a, cpu<N>/cpu_capacity or (not on x86)
+  // cpuinfo_max_freq of the cpufreq policies, Windows: EfficiencyClass, macOS: hw.perflevel<N>.*
+  std::vector<PerformanceLevel> performance_levels;
+  // numa_distances[i][j] is the relative access cost from numa_nodes[i] to numa_nodes[j] (ACPI SLIT, local = 10).
+  // Empty if the platform does not report distances.
+  std::vector<std::vector<int>> numa_distances;
+
+  HWI_NODISCARD int numCores() const;
+  HWI_NODISCARD int numThreads() const;
+
+  // logical CPUs of a package, a NUMA node or of the core cpu belongs to (its SMT siblings including itself)
+  HWI_NODISCARD std::vector<int> packageCpus(int package_id) const;
+  HWI_NODISCARD std::vector<int> numaNodeCpus(int node_id) const;
+  HWI_NODISCARD std::vector<int> siblingCpus(int cpu) const;
+  /**
+   * The first logical CPU of every core (optionally only of one package, -1 for all). Pinning one worker per returned
+   * CPU avoids two workers sharing the execution units of one core.
+   */
+  HWI_NODISCARD std::vector<int> onePerCore(int package_id = -1) const;
+
+  /**
+   * Sorts the cores into performance_levels by their performance_level and fills the level counts, CPU lists, the
+   * levels of the threads and the core types. Used by the platform backends after they assigned the levels of all
+   * cores, names and cache sizes are kept.
+   */
+  void assignPerformanceLevels(int num_levels);
+};
+
+/**
+ * Linux: /sys/devices/system/cpu/cpu<N>/topology and /sys/devices/system/node. Windows:
+ * GetLogicalProcessorInformationEx. Returns an empty topology (no packages) if it cannot be determined.
+ */
+CpuTopology getCpuTopology();
+
+/**
+ * One cache instance. A cache shared by several cores (e.g. the L3 of one AMD CCD) is reported once with all logical
+ * CPUs that share it.
+ */
+struct HWINFO_API CacheInfo {
+  enum class Type { Data, Instruction, Unified };
+
+  int level{-1};
+  Type type{Type::Unified};
+  int64_t size_Bytes{-1};
+  int line_size_Bytes{-1};
+  // ways of associativity, 0 for fully associative caches, -1 if unknown
+  int associativity{-1};
+  int64_t sets{-1};
+  // logical CPUs sharing this cache, sorted
+  std::vector<int> shared_cpus;
+
+  // orders by level, type and first shared CPU
+  bool operator<(const CacheInfo& other) const;
+};
+
+/**
+ * All cache instances sorted by level, type and first shared CPU. Linux: /sys/devices/system/cpu/cpu<N>/cache/index<M>,
+ * Windows: GetLogicalProcessorInformationEx(RelationCache), macOS: hw.* sysctls.
+ */
+std::vector<CacheInfo> getCacheHierarchy();
 }  // namespace hwinfo
@@ -48,6 +48,20 @@ inline void cpuid(uint32_t func_id, uint32_t sub_func_id, uint32_t regs[4]) {
 #endif
 }
 
+/**
+ * Reads the extended control register xcr (0: XCR0, the state components the OS saves on context switches). Only
+ * call it if cpuid leaf 1 reports OSXSAVE (ECX bit 27).
+ */
+inline uint64_t xgetbv(uint32_t xcr) {
+#ifdef _MSC_VER
+  return _xgetbv(xcr);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(xcr));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
 }  // namespace cpuid
 }  // namespace hwinfo
 
@@ -3,18 +3,40 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "hwinfo/platform.h"
+#include "hwinfo/utils/fields.h"
+#include "hwinfo/utils/lazy.h"
 
 namespace hwinfo {
 // Linux always considers sectors to be 512 bytes long independently of the devices real block size.
 const unsigned short block_size = 512;
 
+/**
+ * Attributes read by getAllDisks(). Unrequested attributes that need extra I/O are skipped and keep their default
+ * (empty or -1).
+ */
+enum class DiskFields : uint32_t {
+  Vendor = 1u << 0,
+  Model = 1u << 1,
+  Serial = 1u << 2,
+  Capacity = 1u << 3,
+  Free = 1u << 4,
+  Volumes = 1u << 5,
+  All = (1u << 6) - 1,
+};
+
+template <>
+struct enable_field_mask<DiskFields> : std::true_type {};
+
 class HWINFO_API Disk {
-  friend std::vector<Disk> getAllDisks();
+  friend std::vector<Disk> getAllDisks(DiskFields fields);
 
  public:
   ~Disk() = default;
@@ -23,10 +45,19 @@ class HWINFO_API Disk {
   HWI_NODISCARD const std::string& model() const;
   HWI_NODISCARD const std::string& serialNumber() const;
   HWI_NODISCARD int64_t size_Bytes() const;
+  // Free space and volumes are resolved on first access of either (Linux: mountinfo and statvfs), later calls return
+  // the cached values. Use refresh() to update the free space.
   HWI_NODISCARD int64_t free_size_Bytes() const;
   HWI_NODISCARD const std::vector<std::string>& volumes() const;
   HWI_NODISCARD int id() const;
 
+  /**
+   * Updates the dynamic attributes (free space) in place with one statfs-like call per mount point resolved during
+   * enumeration. Identity attributes stay cached.
+   * @return false if no mount point is known or none could be queried
+   */
+  bool refresh();
+
  private:
   Disk() = default;
 
@@ -34,10 +65,89 @@ class HWINFO_API Disk {
   std::string _model;
   std::string _serialNumber;
   int64_t _size_Bytes{-1};
-  int64_t _free_size_Bytes{-1};
-  std::vector<std::string> _volumes;
   int _id{-1};
+
+  struct Mounts {
+    int64_t free_size_Bytes{-1};
+    std::vector<std::string> volumes;
+    // mount points (Windows: logical drives) used by refresh(), resolved even if Volumes was not requested
+    std::vector<std::string> mount_points;
+  };
+  // "major:minor" -> mount points, parsed once on the first resolveMounts() of the disks of one getAllDisks() call
+  using MountTable = std::unordered_map<std::string, std::vector<std::string>>;
+
+  const Mounts& mounts() const;
+  // Platform specific, called by the first access of the mounts unless getAllDisks() already set them
+  Mounts resolveMounts() const;
+  utils::Lazy<Mounts> _mounts;
+  // Linux: what resolveMounts() needs, the sysfs directory of the disk and the requested fields
+  std::string _sysfs_path;
+  DiskFields _fields{DiskFields::All};
+  std::shared_ptr<const utils::Lazy<MountTable>> _mount_table;
 };
 
-std::vector<Disk> getAllDisks();
+std::vector<Disk> getAllDisks(DiskFields fields = DiskFields::All);
+
+/**
+ * Samples the I/O counters of all block devices (Linux: one pass over /proc/diskstats, Windows: IOCTL_DISK_PERFORMANCE
+ * per physical drive, macOS: IOBlockStorageDriver statistics). Rates are deltas between two consecutive sample()
+ * calls, so call it at a fixed interval.
+ *
+ * A DiskIOSampler is not synchronized, use one instance per thread.
+ */
+class HWINFO_API DiskIOSampler {
+ public:
+  struct DeviceStats {
+    // kernel device name, e.g. "nvme0n1" (Windows: "PhysicalDrive0", macOS: "disk0")
+    std::string name;
+    // all values are -1 on the first sample of a device or if the platform does not report them
+    double read_iops{-1.0};
+    double write_iops{-1.0};
+    double read_Bytes_per_s{-1.0};
+    double write_Bytes_per_s{-1.0};
+    // average number of requests in flight
+    double queue_depth{-1.0};
+    // average time per completed request including queueing
+    double await_ms{-1.0};
+    // fraction of time the device had requests in flight, in [0, 1]
+    double utilisation{-1.0};
+    // the cumulative counters behind the rates, also set on the first sample, -1 if the platform does not report them
+    int64_t read_Bytes{-1};
+    int64_t write_Bytes{-1};
+    // completed reads and writes
+    int64_t operations{-1};
+    double busy_time_ms{-1.0};
+  };
+
+  DiskIOSampler() = default;
+  ~DiskIOSampler() = default;
+
+  /**
+   * Reads the counters of all devices once and returns the rates since the previous call.
+   */
+  std::vector<DeviceStats> sample();
+
+ private:
+  // cumulative counters as reported by the platform, -1 if not available
+  struct Counters {
+    std::string name;
+    int64_t reads{-1};
+    int64_t writes{-1};
+    int64_t read_Bytes{-1};
+    int64_t write_Bytes{-1};
+    // time spent on reads and writes, summed over all requests
+    double read_time_ms{-1.0};
+    double write_time_ms{-1.0};
+    // wall time with requests in flight
+    double busy_time_ms{-1.0};
+    // busy time weighted by the number of requests in flight
+    double weighted_time_ms{-1.0};
+  };
+
+  // implemented per platform, returns an empty vector if the counters are not available
+  static std::vector<Counters> read_counters();
+
+  std::unordered_map<std::string, Counters> _previous;
+  std::chrono::steady_clock::time_point _last{};
+};
 }  // namespace hwinfo
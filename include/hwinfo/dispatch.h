@@ -0,0 +1,67 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <initializer_list>
+#include <utility>
+
+#include "hwinfo/cpu.h"
+
+namespace hwinfo {
+
+/**
+ * One implementation of a dispatched function and the features it needs.
+ */
+template <typename Fn>
+struct DispatchCandidate {
+  CpuFeatures required;
+  Fn fn;
+};
+
+/**
+ * @return the fn of the first candidate whose required features are all in features, fallback if there is none.
+ *         List the candidates from the most to the least specialised.
+ */
+template <typename Fn>
+Fn selectImplementation(std::initializer_list<DispatchCandidate<Fn>> candidates, Fn fallback,
+                        const CpuFeatures& features = CpuFeatures::host()) {
+  for (const auto& candidate : candidates) {
+    if (features.has_all(candidate.required)) return candidate.fn;
+  }
+  return fallback;
+}
+
+/**
+ * Function pointer resolved once on construction from the features of the host CPU. Only CpuFeatures::host() is
+ * queried (cpuid / getauxval, including the XCR0 check for AVX and AVX-512 state), never getAllCPUs(), so a
+ * Dispatcher can be a static variable that is initialised before main:
+ *
+ *   static const hwinfo::Dispatcher<float (*)(const float*, size_t)> sum(
+ *       {{{hwinfo::Feature::AVX512F}, sum_avx512},
+ *        {{hwinfo::Feature::AVX2, hwinfo::Feature::FMA}, sum_avx2},
+ *        {{hwinfo::Feature::NEON}, sum_neon}},
+ *       sum_scalar);
+ *   float s = sum(data, n);
+ *
+ * Calling through the Dispatcher is an indirect call without any further checks.
+ */
+template <typename Fn>
+class Dispatcher {
+ public:
+  Dispatcher(std::initializer_list<DispatchCandidate<Fn>> candidates, Fn fallback,
+             const CpuFeatures& features = CpuFeatures::host())
+      : _fn(selectImplementation(candidates, fallback, features)) {}
+
+  template <typename... Args>
+  decltype(auto) operator()(Args&&... args) const {
+    return _fn(std::forward<Args>(args)...);
+  }
+
+  HWI_NODISCARD Fn get() const { return _fn; }
+
+ private:
+  Fn _fn;
+};
+
+}  // namespace hwinfo
@@ -0,0 +1,84 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+struct DeviceEvent {
+  enum class Class {
+    Disk,     // Linux: block devices of type disk
+    Network,  // interfaces, including link and address changes
+    Monitor,  // Linux: DRM connectors and cards
+    // batteries and AC adapters: attach, detach, charging state and capacity changes (Linux: power_supply uevents,
+    // macOS: IOPS notifications). Re-read the state with Battery::refresh().
+    PowerSource,
+  };
+  enum class Action { Add, Remove, Change };
+
+  Class device_class{Class::Disk};
+  Action action{Action::Change};
+  // kernel name of the device (e.g. "sda", "eth0", "card0", "BAT0") or the device interface path on Windows. Empty
+  // for macOS power source events, which do not name the source that changed.
+  std::string name{};
+};
+
+/**
+ * Delivers hot-plug deltas instead of re-enumerating: on Linux via a NETLINK_KOBJECT_UEVENT socket (block, net, drm)
+ * and a NETLINK_ROUTE socket (RTM_NEWLINK/RTM_DELLINK, RTM_NEWADDR/RTM_DELADDR), on Windows via
+ * RegisterDeviceNotification and NotifyIpInterfaceChange, on macOS (power sources only) via
+ * IOPSNotificationCreateRunLoopSource. Consumers re-query only the device named by an event, e.g. with
+ * Disk::refresh() or getAllDisks().
+ *
+ * The callback is invoked on the watcher thread, it should return quickly.
+ */
+class HWINFO_API DeviceWatcher {
+ public:
+  using Callback = std::function<void(const DeviceEvent&)>;
+
+  explicit DeviceWatcher(Callback callback);
+  ~DeviceWatcher();
+
+  DeviceWatcher(const DeviceWatcher&) = delete;
+  DeviceWatcher& operator=(const DeviceWatcher&) = delete;
+
+  /**
+   * Opens the notification sources and starts the watcher thread.
+   * @return false if the sources could not be opened (e.g. not supported on this platform)
+   */
+  bool start();
+  void stop();
+  HWI_NODISCARD bool running() const;
+
+ private:
+  // platform specific notification sources, see src/<platform>/events.cpp
+  struct Backend;
+  struct BackendDeleter {
+    void operator()(Backend* backend) const;
+  };
+  // called on the watcher thread, returns nullptr if no source could be opened
+  static Backend* open_backend();
+  // blocks until events arrived (appended to events) or interrupt() was called. Returns false on interruption or error
+  static bool wait_events(Backend& backend, std::vector<DeviceEvent>& events);
+  // thread-safe, makes a blocking wait_events() return false
+  static void interrupt(Backend& backend);
+
+  void run(std::promise<bool>* opened);
+
+  Callback _callback;
+  std::unique_ptr<Backend, BackendDeleter> _backend;
+  std::mutex _mutex;
+  std::thread _thread;
+};
+
+}  // namespace hwinfo
@@ -0,0 +1,87 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "hwinfo/collector.h"
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+struct ExporterOptions {
+  // address and port of the HTTP endpoint, port 0 picks a free port (see Exporter::port())
+  std::string address{"127.0.0.1"};
+  uint16_t port{9464};
+  // false: no endpoint is opened, use Exporter::scrape() to get the text
+  bool serve_http{true};
+  // how often the collector is drained and the text rendered
+  std::chrono::milliseconds refresh{1000};
+};
+
+/**
+ * Prometheus/OpenMetrics exposition of the latest collector samples. A background thread drains the records of the
+ * Collector, keeps the latest value per series and renders the exposition text into a reused buffer once per refresh.
+ * Scrapes of GET /metrics only copy the pre-rendered text, they never trigger a collection. Label sets (cpu, device,
+ * interface, gpu) are rendered once when a source is first seen.
+ *
+ * The exporter is the only consumer of the collector's records: do not pop() from it while the exporter runs. Start
+ * the collector separately, the exporter does not configure its intervals.
+ */
+class HWINFO_API Exporter {
+ public:
+  explicit Exporter(Collector& collector, ExporterOptions options = {});
+  ~Exporter();
+
+  Exporter(const Exporter&) = delete;
+  Exporter& operator=(const Exporter&) = delete;
+
+  /**
+   * Opens the endpoint (if enabled) and starts the background thread.
+   * @return false if the address could not be bound
+   */
+  bool start();
+  void stop();
+  HWI_NODISCARD bool running() const;
+  // the bound port, 0 if the endpoint is not open
+  HWI_NODISCARD uint16_t port() const;
+
+  // drains the collector and renders the text once, called by the background thread every refresh interval
+  void update();
+  // copies the most recently rendered text into out, reusing its capacity
+  void scrape(std::string& out) const;
+
+ private:
+  struct Series {
+    // pre-rendered label set including braces, e.g. {cpu="3"}, empty for unlabeled series
+    std::string labels;
+    double values[4];
+  };
+
+  void run();
+  void serve(intptr_t client);
+  void render();
+
+  Collector& _collector;
+  ExporterOptions _options;
+  // latest values keyed by (metric << 16 | index), ordered by metric and index for rendering
+  std::map<uint32_t, Series> _series;
+
+  std::string _render;
+  mutable std::mutex _text_mutex;
+  std::string _text;
+
+  intptr_t _listen{-1};
+  uint16_t _port{0};
+  std::atomic<bool> _stop{false};
+  std::thread _thread;
+};
+
+}  // namespace hwinfo
@@ -3,16 +3,23 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "hwinfo/platform.h"
 
 namespace hwinfo {
 
+class GPUMonitor;
+
 class HWINFO_API GPU {
-  friend std::vector<GPU> getAllGPUs();
+  friend std::vector<GPU> getAllGPUs(bool use_opencl);
 
  public:
   ~GPU() = default;
@@ -26,6 +33,19 @@ class HWINFO_API GPU {
   HWI_NODISCARD int id() const;
   HWI_NODISCARD const std::string& vendor_id() const;
   HWI_NODISCARD const std::string& device_id() const;
+  // PCI address as "domain:bus:device.function", empty if unknown
+  HWI_NODISCARD const std::string& pci_bus_id() const;
+
+  /**
+   * Updates the dynamic attributes below in place. The counter files are opened on the first refresh() (see GPUMonitor)
+   * and reread afterwards, copies of this GPU share them.
+   * @return false if no counter is available for this GPU
+   */
+  bool refresh();
+  // dynamic attributes of the last refresh(), -1 before or if not available
+  HWI_NODISCARD double utilisation() const;
+  HWI_NODISCARD int64_t memory_used_Bytes() const;
+  HWI_NODISCARD int64_t currentFrequency_MHz() const;
 
  private:
   GPU() = default;
@@ -39,7 +59,90 @@ class HWINFO_API GPU {
 
   std::string _vendor_id{};
   std::string _device_id{};
+  std::string _pci_bus_id{};
+
+  std::shared_ptr<GPUMonitor> _monitor;
+  double _utilisation{-1.0};
+  int64_t _memory_used_Bytes{-1};
+  int64_t _current_frequency_MHz{-1};
+};
+
+/**
+ * @param use_opencl complete the information (driver, cores, memory) via OpenCL if hwinfo was built with
+ *                   HWINFO_GPU_OPENCL. Pass false on latency sensitive paths: loading the OpenCL ICDs takes much longer
+ *                   than the sysfs/WMI inventory itself.
+ */
+std::vector<GPU> getAllGPUs(bool use_opencl = true);
+
+/**
+ * Samples live telemetry of a GPU. The underlying counter files (Linux: DRM/hwmon sysfs attributes) are opened once
+ * and reread on every sample. Samples are stored in a ring buffer that is allocated on construction.
+ *
+ * Either call sample() yourself or let a background thread sample at a fixed interval via start().
+ */
+class HWINFO_API GPUMonitor {
+ public:
+  struct Sample {
+    std::chrono::steady_clock::time_point timestamp{};
+    // busy time in [0, 1], -1 if not available
+    double utilisation{-1.0};
+    int64_t memory_used_Bytes{-1};
+    int64_t frequency_MHz{-1};
+    // average power draw, -1 if not available
+    double power_W{-1.0};
+  };
+
+  explicit GPUMonitor(const GPU& gpu, size_t capacity = 128);
+  ~GPUMonitor();
+
+  GPUMonitor(const GPUMonitor&) = delete;
+  GPUMonitor& operator=(const GPUMonitor&) = delete;
+
+  /**
+   * Reads all counters once, stores the sample in the ring buffer and returns it.
+   */
+  Sample sample();
+
+  /**
+   * Starts a background thread that calls sample() every interval. Calling start() on a running monitor changes
+   * the interval right away, the next sample is taken interval after the previous one.
+   */
+  void start(std::chrono::milliseconds interval);
+  void stop();
+  HWI_NODISCARD bool running() const;
+
+  /**
+   * @return the buffered samples, oldest first
+   */
+  HWI_NODISCARD std::vector<Sample> samples() const;
+  /**
+   * @return the most recent sample or a default sample (all -1) if nothing was sampled yet
+   */
+  HWI_NODISCARD Sample latest() const;
+
+ private:
+  // platform specific counter sources, see src/<platform>/gpu.cpp
+  struct Sources;
+  struct SourcesDeleter {
+    void operator()(Sources* sources) const;
+  };
+  static Sources* open_sources(int gpu_id);
+  static void read_sources(Sources& sources, Sample& sample);
+
+  void run();
+
+  std::unique_ptr<Sources, SourcesDeleter> _sources;
+  std::vector<Sample> _ring;
+  size_t _next{0};
+  size_t _size{0};
+  mutable std::mutex _mutex;
+  std::mutex _read_mutex;
+  std::condition_variable _cv;
+  std::chrono::milliseconds _interval{0};
+  // incremented by every start(), wakes the thread to recompute its deadline
+  uint64_t _generation{0};
+  bool _stop{false};
+  std::thread _thread;
 };
 
-std::vector<GPU> getAllGPUs();
 }  // namespace hwinfo
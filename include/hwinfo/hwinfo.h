@@ -3,12 +3,29 @@
 
 #pragma once
 
+#include "hwinfo/arena_snapshot.h"
 #include "hwinfo/battery.h"
+#include "hwinfo/capi.h"
+#include "hwinfo/collector.h"
 #include "hwinfo/cpu.h"
 #include "hwinfo/disk.h"
+#include "hwinfo/dispatch.h"
+#include "hwinfo/events.h"
+#include "hwinfo/exporter.h"
 #include "hwinfo/gpu.h"
+#include "hwinfo/interrupts.h"
+#include "hwinfo/inventory_cache.h"
+#include "hwinfo/json.h"
 #include "hwinfo/mainboard.h"
 #include "hwinfo/monitor.h"
 #include "hwinfo/network.h"
+#include "hwinfo/nvme.h"
 #include "hwinfo/os.h"
+#include "hwinfo/pci.h"
+#include "hwinfo/perf_counters.h"
+#include "hwinfo/process.h"
 #include "hwinfo/ram.h"
+#include "hwinfo/serialization.h"
+#include "hwinfo/snapshot.h"
+#include "hwinfo/stats.h"
+#include "hwinfo/timeseries.h"
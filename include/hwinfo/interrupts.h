@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+/**
+ * Per-CPU interrupt counters for IRQ affinity and RSS/RPS tuning (Linux: /proc/interrupts and /proc/softirqs). The
+ * counters form a dense [source x CPU] matrix. sample() rereads both files with one pread each into buffers kept
+ * between samples and computes the increments since the previous sample.
+ *
+ * Numbered IRQs are mapped to the PCI device raising them (/sys/bus/pci/devices/<address>/msi_irqs and irq) and to the
+ * network interface of that device, so the queue IRQs of a NIC can be matched with getAllNetworks() and
+ * getAllPCIDevices(). The mapping is resolved when the set of IRQs changes, not on every sample.
+ *
+ * An InterruptSampler is not synchronized, use one instance per thread. Other platforms than Linux report nothing.
+ */
+class HWINFO_API InterruptSampler {
+ public:
+  struct Source {
+    enum class Kind {
+      // numbered IRQ of a device
+      Device,
+      // architecture specific counter, e.g. "NMI", "LOC" (local timer) or "RES" (rescheduling IPIs)
+      Architecture,
+      // softirq, e.g. "NET_RX"
+      Softirq,
+    };
+    // first column of the row: "24", "LOC" or "NET_RX"
+    std::string name;
+    Kind kind{Kind::Device};
+    // the columns after the counters: chip, hardware IRQ and handler names, e.g. "IR-PCI-MSI 524288-edge eth0-rx-0"
+    std::string description;
+    // PCI address of the device raising the IRQ (e.g. "0000:01:00.0"), empty if it is not a PCI IRQ
+    std::string pci_address;
+    // network interface of that PCI device or named by a handler ("eth0" or "eth0-<queue>"), empty otherwise
+    std::string interface;
+  };
+
+  InterruptSampler() = default;
+  ~InterruptSampler();
+  InterruptSampler(const InterruptSampler&) = delete;
+  InterruptSampler& operator=(const InterruptSampler&) = delete;
+
+  /**
+   * Reads all counters once. The first sample has all deltas 0.
+   * @return false if the counters are not available
+   */
+  bool sample();
+
+  HWI_NODISCARD const std::vector<Source>& sources() const { return _sources; }
+  // logical CPU numbers of the matrix columns (the CPUs online at the last sample)
+  HWI_NODISCARD const std::vector<int>& cpus() const { return _cpus; }
+  // counters since boot, row major: counts()[source * cpus().size() + column]
+  HWI_NODISCARD const std::vector<uint64_t>& counts() const { return _counts; }
+  // increments since the previous sample in the layout of counts(), 0 for sources or CPUs that were not in it
+  HWI_NODISCARD const std::vector<uint64_t>& deltas() const { return _deltas; }
+  HWI_NODISCARD uint64_t delta(size_t source, size_t column) const;
+  // seconds between the last two samples, 0 after the first one
+  HWI_NODISCARD double interval_s() const { return _interval_s; }
+
+  // deltas per column summed over all sources of one kind, e.g. the device IRQs that landed on each CPU
+  HWI_NODISCARD std::vector<uint64_t> cpuDeltas(Source::Kind kind) const;
+  // deltas per column summed over the IRQs of a network interface (its queue and link IRQs)
+  HWI_NODISCARD std::vector<uint64_t> interfaceDeltas(const std::string& interface) const;
+
+  /**
+   * Load imbalance of per-column values: the maximum divided by the mean, 1 if perfectly balanced and the number of
+   * columns if everything lands on one CPU.
+   * @return -1 if all values are 0
+   */
+  HWI_NODISCARD static double imbalance(const std::vector<uint64_t>& per_cpu);
+
+ private:
+  // platform specific: fills _sources, _cpus and _counts, keeps _sources if the rows did not change
+  bool read_counters();
+
+  std::vector<Source> _sources;
+  std::vector<int> _cpus;
+  std::vector<uint64_t> _counts;
+  std::vector<uint64_t> _deltas;
+  double _interval_s{0.0};
+
+  // state of the previous sample, kept to compute the deltas
+  std::vector<std::string> _previous_names;
+  std::vector<int> _previous_cpus;
+  std::vector<uint64_t> _previous_counts;
+  std::chrono::steady_clock::time_point _last{};
+
+  // Linux: descriptors of /proc/interrupts and /proc/softirqs and the buffer they are read into
+  int _interrupts_fd{-1};
+  int _softirqs_fd{-1};
+  std::vector<char> _buffer;
+};
+
+}  // namespace hwinfo
@@ -0,0 +1,90 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hwinfo/platform.h"
+#include "hwinfo/serialization.h"
+#include "hwinfo/snapshot.h"
+
+namespace hwinfo {
+
+/**
+ * Subsystems whose inventory does not change while the system is running: CPU, OS, GPU, RAM modules, mainboard,
+ * disks (identity and capacity) and monitors. The PCI device list is included, the devices are matched against the
+ * cache fingerprint (see InventoryCacheOptions::revalidate). Networks and batteries are left out.
+ */
+Options staticInventoryOptions();
+
+/**
+ * Identifier of the current boot: /proc/sys/kernel/random/boot_id on Linux, kern.bootsessionuuid on macOS and the
+ * BootId of the memory manager (or the boot time) on Windows.
+ * @return the identifier or an empty string if it is not available
+ */
+std::string bootId();
+
+struct InventoryCacheOptions {
+  // cache file, empty: $XDG_RUNTIME_DIR (/run/user/<uid>) or /tmp on Linux, $TMPDIR on macOS, %LOCALAPPDATA%\hwinfo
+  // on Windows
+  std::string path;
+  // subsystems collected on a miss, part of the cache key
+  Options options{staticInventoryOptions()};
+  // also compare a fingerprint of the PCI, block and DRM device names (a few readdir() calls) on Linux, so that
+  // hot-plugged devices invalidate the cache. false: only a new boot invalidates it.
+  bool revalidate{true};
+};
+
+/**
+ * Persistent, opt-in cache of the static inventory for short-lived processes. The serialized snapshot (see
+ * serializeSnapshot()) of InventoryCacheOptions::options is stored together with the boot ID. load() memory-maps the
+ * file and only checks its key, so neither the collectors nor the PCI ID database are touched on a hit. On a miss the
+ * subsystems are collected and the file is replaced atomically (written to a temporary file and renamed).
+ *
+ * The cache is a plain file of the current user, concurrent processes may race to rewrite it but always read either
+ * the old or the new version.
+ */
+class HWINFO_API InventoryCache {
+ public:
+  explicit InventoryCache(InventoryCacheOptions options = {});
+  ~InventoryCache();
+
+  InventoryCache(const InventoryCache&) = delete;
+  InventoryCache& operator=(const InventoryCache&) = delete;
+
+  /**
+   * Maps the cache file if it belongs to the current boot, options and device fingerprint, collects and rewrites it
+   * otherwise.
+   * @return false if the inventory could neither be loaded nor collected
+   */
+  bool load();
+  // true if the last load() was served from the cache file
+  HWI_NODISCARD bool fromCache() const { return _from_cache; }
+  // the inventory of the last load(), invalid before
+  HWI_NODISCARD const SnapshotView& view() const { return _view; }
+  HWI_NODISCARD const std::string& path() const { return _path; }
+  // removes the cache file, the next load() collects again
+  bool invalidate();
+
+ private:
+  // the key a valid cache file has to start with
+  HWI_NODISCARD std::string key() const;
+  bool map(const std::string& key);
+  void unmap();
+  bool store(const std::string& key, const std::vector<uint8_t>& payload) const;
+
+  InventoryCacheOptions _options;
+  std::string _path;
+  bool _from_cache{false};
+  // either a read-only mapping of the cache file or _buffer holds the serialized snapshot
+  const uint8_t* _mapping{nullptr};
+  size_t _mapping_size{0};
+  std::vector<uint8_t> _buffer;
+  SnapshotView _view{nullptr, 0};
+};
+
+}  // namespace hwinfo
@@ -0,0 +1,131 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "hwinfo/collector.h"
+#include "hwinfo/platform.h"
+#include "hwinfo/snapshot.h"
+
+namespace hwinfo {
+
+/**
+ * Streaming JSON writer: values are formatted on the stack and written straight into the sink, no document is built.
+ * Commas and nesting are tracked by the writer, callers only emit keys and values:
+ *
+ *   JsonWriter json(STDOUT_FILENO);
+ *   json.beginObject().field("name", os.name()).key("cpus").beginArray();
+ *   for (const auto& cpu : cpus) to_json(json, cpu);
+ *   json.endArray().endObject();
+ *
+ * In Ndjson format every complete top-level value is terminated by a newline, e.g. one line per collector Record.
+ * Non-finite doubles are written as null.
+ */
+class HWINFO_API JsonWriter {
+ public:
+  enum class Format : uint8_t { Json, Ndjson };
+
+  // writes to a file descriptor through a fixed internal buffer, flushed when full, by flush() and on destruction
+  explicit JsonWriter(int fd, Format format = Format::Json);
+  // appends to out
+  explicit JsonWriter(std::string& out, Format format = Format::Json);
+  // writes into [buffer, buffer + size). Output that does not fit is discarded and ok() turns false.
+  JsonWriter(char* buffer, size_t size, Format format = Format::Json);
+  ~JsonWriter();
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+  JsonWriter& beginObject();
+  JsonWriter& endObject();
+  JsonWriter& beginArray();
+  JsonWriter& endArray();
+  JsonWriter& key(std::string_view name);
+
+  JsonWriter& value(std::string_view value);
+  JsonWriter& value(const char* value);
+  JsonWriter& value(double value);
+  JsonWriter& value(bool value);
+  template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                                                int>::type = 0>
+  JsonWriter& value(T value) {
+    if (std::is_signed<T>::value) {
+      return integer(static_cast<int64_t>(value));
+    }
+    return unsignedInteger(static_cast<uint64_t>(value));
+  }
+  JsonWriter& null();
+
+  template <typename T>
+  JsonWriter& field(std::string_view name, const T& field_value) {
+    key(name);
+    return value(field_value);
+  }
+
+  // writes the buffered output of a file descriptor writer
+  void flush();
+  // false if a write failed or the output did not fit into a caller provided buffer
+  HWI_NODISCARD bool ok() const;
+  // number of bytes produced so far
+  HWI_NODISCARD size_t size() const;
+
+ private:
+  JsonWriter& integer(int64_t value);
+  JsonWriter& unsignedInteger(uint64_t value);
+  // emits the comma before a value or key and closes a top-level value
+  void separate();
+  void finishValue();
+  void write(const char* data, size_t size);
+  void put(char c) { write(&c, 1); }
+
+  static constexpr int max_depth = 64;
+
+  Format _format;
+  int _fd{-1};
+  std::string* _string{nullptr};
+  char* _buffer{nullptr};
+  size_t _capacity{0};
+  size_t _length{0};
+  size_t _size{0};
+  bool _ok{true};
+
+  // bit i is set while the container at depth i has no element yet
+  uint64_t _empty{0};
+  int _depth{0};
+  bool _after_key{false};
+
+  char _staging[4096];
+};
+
+// Only collected data is written: live CPU values (current clock speeds, utilisation) are left out, serialise the
+// Records of a sampler or Collector for them.
+void to_json(JsonWriter& json, const CPU& cpu);
+void to_json(JsonWriter& json, const CacheInfo& cache);
+void to_json(JsonWriter& json, const CpuBudget& budget);
+void to_json(JsonWriter& json, const OS& os);
+void to_json(JsonWriter& json, const GPU& gpu);
+void to_json(JsonWriter& json, const Memory& memory);
+void to_json(JsonWriter& json, const Memory::Module& module);
+void to_json(JsonWriter& json, const MemoryStats& stats);
+void to_json(JsonWriter& json, const MemoryTopology& topology);
+void to_json(JsonWriter& json, const MemoryNode& node);
+void to_json(JsonWriter& json, const HugePagePool& pool);
+void to_json(JsonWriter& json, const MainBoard& board);
+void to_json(JsonWriter& json, const Battery& battery);
+void to_json(JsonWriter& json, const Disk& disk);
+void to_json(JsonWriter& json, const Network& network);
+void to_json(JsonWriter& json, const Monitor& monitor);
+void to_json(JsonWriter& json, const PCIBusDevice& device);
+// every collected subsystem of the snapshot, subsystems that were not collected are omitted
+void to_json(JsonWriter& json, const Snapshot& snapshot);
+// {"timestamp_ns": <steady clock>, "metric": "cpu_utilisation", "index": 3, "utilisation": 0.25}, one named member per
+// value of the metric (see Metric). index is omitted for totals.
+void to_json(JsonWriter& json, const Record& record);
+
+}  // namespace hwinfo
@@ -26,6 +26,9 @@ class HWINFO_API MainBoard {
   std::string _name;
   std::string _version;
   std::string _serialNumber;
+
+  // fills all attributes from the SMBIOS baseboard structure, returns false if there is none
+  bool fromSMBIOS();
 };
 
 }  // namespace hwinfo
@@ -1,25 +1,122 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "hwinfo/platform.h"
+#include "hwinfo/utils/fields.h"
 
 namespace hwinfo {
 
+/**
+ * Attributes read by getAllNetworks(). Attributes that are not requested stay empty.
+ */
+enum class NetworkFields : uint32_t {
+  Index = 1u << 0,
+  Description = 1u << 1,
+  Mac = 1u << 2,
+  IP4 = 1u << 3,
+  IP6 = 1u << 4,
+  Type = 1u << 5,
+  Statistics = 1u << 6,
+  // MTU, operational state and link speed
+  Link = 1u << 7,
+  // driver, PCI address, NUMA node, queues, rings and offloads (see Network::Hardware)
+  Hardware = 1u << 8,
+  All = (1u << 9) - 1,
+};
+
+template <>
+struct enable_field_mask<NetworkFields> : std::true_type {};
+
 class HWINFO_API Network {
-  friend std::vector<Network> getAllNetworks();
+  friend std::vector<Network> getAllNetworks(NetworkFields fields);
 
  public:
+  // interface counters since the interface was created, -1 if not available
+  struct Statistics {
+    int64_t rx_bytes{-1};
+    int64_t tx_bytes{-1};
+    int64_t rx_packets{-1};
+    int64_t tx_packets{-1};
+    int64_t rx_errors{-1};
+    int64_t tx_errors{-1};
+    int64_t rx_dropped{-1};
+    int64_t tx_dropped{-1};
+  };
+
+  /**
+   * The NIC below an interface, for placing packet workers on its NUMA node and sizing them by its queues. Linux reads
+   * channels, rings and features with one ethtool netlink dump each for all interfaces, other values are -1 or empty
+   * if not available (virtual interfaces, drivers without ethtool support, other platforms).
+   */
+  struct Hardware {
+    // kernel driver, e.g. "ixgbe" or "virtio_net"
+    std::string driver;
+    // PCI function of the device (e.g. "0000:01:00.0"), empty for non-PCI devices
+    std::string pci_address;
+    int numa_node{-1};
+    // queues registered with the network stack (/sys/class/net/<if>/queues), also reported for virtual interfaces
+    int rx_queues{-1};
+    int tx_queues{-1};
+    // ETHTOOL_MSG_CHANNELS_GET: current and maximum RX-only, TX-only and combined channels
+    int rx_channels{-1};
+    int tx_channels{-1};
+    int combined_channels{-1};
+    int max_rx_channels{-1};
+    int max_tx_channels{-1};
+    int max_combined_channels{-1};
+    // ETHTOOL_MSG_RINGS_GET: descriptors per ring
+    int64_t rx_ring_size{-1};
+    int64_t tx_ring_size{-1};
+    int64_t max_rx_ring_size{-1};
+    int64_t max_tx_ring_size{-1};
+    // ETHTOOL_MSG_FEATURES_GET: names of the active features, e.g. "tx-tcp-segmentation" or "rx-gro"
+    std::vector<std::string> features;
+
+    HWI_NODISCARD bool hasFeature(std::string_view name) const;
+    // TCP segmentation offload
+    HWI_NODISCARD bool tso() const { return hasFeature("tx-tcp-segmentation"); }
+    // generic receive offload
+    HWI_NODISCARD bool gro() const { return hasFeature("rx-gro"); }
+    HWI_NODISCARD bool rxChecksum() const { return hasFeature("rx-checksum"); }
+    // IPv4 or protocol independent TX checksum offload
+    HWI_NODISCARD bool txChecksum() const {
+      return hasFeature("tx-checksum-ipv4") || hasFeature("tx-checksum-ip-generic");
+    }
+  };
+
   ~Network() = default;
 
   HWI_NODISCARD const std::string& interfaceIndex() const;
   HWI_NODISCARD const std::string& description() const;
   HWI_NODISCARD const std::string& mac() const;
   HWI_NODISCARD const std::string& ip4() const;
+  // the link-local address if there is one, otherwise the first address
   HWI_NODISCARD const std::string& ip6() const;
+  // all IPv6 addresses (link-local and global) of the interface
+  HWI_NODISCARD const std::vector<std::string>& ip6Addresses() const;
   HWI_NODISCARD const std::string& type() const;
 
+  HWI_NODISCARD const Statistics& statistics() const;
+  HWI_NODISCARD int mtu() const;
+  // RFC 2863 operational state: "up", "down", "dormant", "lowerlayerdown", "notpresent", "testing" or "<unknown>"
+  HWI_NODISCARD const std::string& operState() const;
+  // -1 if unknown or the link is down
+  HWI_NODISCARD int64_t linkSpeed_Mbps() const;
+  HWI_NODISCARD const Hardware& hardware() const;
+
+  /**
+   * Updates the requested dynamic attributes in place: IP4 and IP6 (addresses), Statistics and Link (MTU, operational
+   * state and link speed); identity attributes stay cached. Linux keeps an rtnetlink socket and the speed attribute
+   * open between calls; addresses take one dump of all interfaces, leave them out when polling statistics.
+   * @return false if the interface does not exist anymore
+   */
+  bool refresh(NetworkFields fields = NetworkFields::All);
+
  private:
   Network() = default;
 
@@ -28,9 +125,20 @@ class HWINFO_API Network {
   std::string _mac;
   std::string _ip4;
   std::string _ip6;
+  std::vector<std::string> _ip6_addresses;
   std::string _type;
+  Statistics _statistics;
+  int _mtu{-1};
+  std::string _oper_state;
+  int64_t _link_speed_Mbps{-1};
+  Hardware _hardware;
+  // key used by refresh(): interface name (Linux) or interface index (Windows)
+  std::string _interface;
+  // platform specific handles kept open by refresh() (Linux), shared by copies
+  struct RefreshState;
+  std::shared_ptr<RefreshState> _refresh_state;
 };
 
-std::vector<Network> getAllNetworks();
+std::vector<Network> getAllNetworks(NetworkFields fields = NetworkFields::All);
 
 }  // namespace hwinfo
\ No newline at end of file
@@ -0,0 +1,134 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+/**
+ * An NVMe controller with the data of its Identify pages and its SMART / health log (Linux: NVME_IOCTL_ADMIN_CMD on
+ * /dev/nvme<N>, Windows: IOCTL_STORAGE_QUERY_PROPERTY with the NVMe protocol specific properties of
+ * \\.\PhysicalDrive<N>). getAllNvmeControllers() issues Identify Controller, Identify Namespace per namespace and one
+ * Get Log Page per controller; the identify data stays cached and refresh() rereads only the health log with a single
+ * admin command.
+ *
+ * Admin commands require root (Linux: CAP_SYS_ADMIN, Windows: elevation). Without them controllers are still listed
+ * with the identity that sysfs reports, and health().valid is false. Counters that are not available are -1. Match a
+ * controller with getAllDisks() by its serial number.
+ */
+class HWINFO_API NvmeController {
+  friend std::vector<NvmeController> getAllNvmeControllers();
+
+ public:
+  struct Namespace {
+    uint32_t id{0};
+    // block device, e.g. "nvme0n1" (Windows: "PhysicalDrive1"), as named by DiskIOSampler
+    std::string device;
+    // size, provisioned capacity and allocated space of the namespace
+    int64_t size_Bytes{-1};
+    int64_t capacity_Bytes{-1};
+    int64_t utilization_Bytes{-1};
+    // size of a logical block in the current format
+    int64_t block_size_Bytes{-1};
+    // IEEE EUI-64 as 16 hex digits, empty if the namespace reports none
+    std::string eui64;
+  };
+
+  // SMART / health information log (log page 02h) for all namespaces of the controller
+  struct Health {
+    // false if the log could not be read
+    bool valid{false};
+    // bit field: 0 spare below threshold, 1 temperature, 2 reliability degraded, 3 read only, 4 volatile backup failed,
+    // 5 persistent memory region read only
+    uint8_t critical_warning{0};
+    double temperature_C{-1.0};
+    // temperature sensors 1-8, unimplemented sensors are omitted
+    std::vector<double> sensor_temperatures_C;
+    // spare capacity and the threshold below which critical_warning bit 0 is set, in percent
+    int available_spare_percent{-1};
+    int available_spare_threshold_percent{-1};
+    // vendor estimate of the used endurance in percent, may exceed 100
+    int percentage_used{-1};
+    int64_t read_Bytes{-1};
+    int64_t written_Bytes{-1};
+    int64_t host_read_commands{-1};
+    int64_t host_write_commands{-1};
+    int64_t controller_busy_minutes{-1};
+    int64_t power_cycles{-1};
+    int64_t power_on_hours{-1};
+    int64_t unsafe_shutdowns{-1};
+    int64_t media_errors{-1};
+    int64_t error_log_entries{-1};
+    // minutes spent above the warning and critical composite temperature thresholds
+    int64_t warning_temperature_minutes{-1};
+    int64_t critical_temperature_minutes{-1};
+  };
+
+  ~NvmeController() = default;
+
+  // "nvme0" (Windows: "PhysicalDrive1")
+  HWI_NODISCARD const std::string& name() const;
+  // PCI vendor and subsystem vendor id
+  HWI_NODISCARD uint16_t vendor_id() const;
+  HWI_NODISCARD uint16_t subsystem_vendor_id() const;
+  HWI_NODISCARD const std::string& model() const;
+  HWI_NODISCARD const std::string& serialNumber() const;
+  HWI_NODISCARD const std::string& firmware() const;
+  // NVMe version, e.g. "1.4", empty if the controller does not report it
+  HWI_NODISCARD const std::string& version() const;
+  HWI_NODISCARD int controller_id() const;
+  // total and unallocated NVM capacity, -1 for controllers without namespace management
+  HWI_NODISCARD int64_t capacity_Bytes() const;
+  HWI_NODISCARD int64_t unallocated_Bytes() const;
+  // thresholds for the composite temperature, -1 if not reported
+  HWI_NODISCARD double warning_temperature_C() const;
+  HWI_NODISCARD double critical_temperature_C() const;
+  HWI_NODISCARD const std::vector<Namespace>& namespaces() const;
+  // the health log as of the enumeration or the last refresh()
+  HWI_NODISCARD const Health& health() const;
+
+  /**
+   * Rereads the SMART / health log with one admin command.
+   * @return false if the log could not be read, health() is then no longer valid
+   */
+  bool refresh();
+
+ private:
+  NvmeController() = default;
+
+  // fields of the 4096 byte Identify Controller data structure (CNS 01h)
+  void parseIdentifyController(const uint8_t* data);
+  // the 4096 byte Identify Namespace data structure (CNS 00h)
+  static Namespace parseIdentifyNamespace(const uint8_t* data);
+  // the 512 byte SMART / health information log
+  static Health parseHealth(const uint8_t* data);
+  // platform specific, one admin command on _path
+  bool readHealth(Health& health) const;
+
+  std::string _name;
+  // device the admin commands are issued on
+  std::string _path;
+  uint16_t _vendor_id{0};
+  uint16_t _subsystem_vendor_id{0};
+  std::string _model;
+  std::string _serialNumber;
+  std::string _firmware;
+  std::string _version;
+  int _controller_id{-1};
+  int64_t _capacity_Bytes{-1};
+  int64_t _unallocated_Bytes{-1};
+  double _warning_temperature_C{-1.0};
+  double _critical_temperature_C{-1.0};
+  std::vector<Namespace> _namespaces;
+  Health _health;
+};
+
+std::vector<NvmeController> getAllNvmeControllers();
+
+}  // namespace hwinfo
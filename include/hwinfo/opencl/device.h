@@ -7,10 +7,11 @@
 #define CL_HPP_TARGET_OPENCL_VERSION 200
 #endif
 #define CL_HPP_ENABLE_EXCEPTIONS
+#include <CL/opencl.hpp>
 #include <cstdint>
 #include <iostream>
-
-#include "../../../cmake-build-release/_deps/opencl-src/external/OpenCL-CLHPP/include/CL/opencl.hpp"
+#include <string>
+#include <vector>
 
 namespace opencl_ {
 
@@ -188,8 +189,17 @@ class Device {
 
   [[nodiscard]] bool intel_gt_4gb_buffer_required() const;
 
+  /**
+   * @brief Returns the PCI address of the device as "domain:bus:device.function" (e.g. "0000:01:00.0").
+   *
+   *        Queried once on construction via cl_khr_pci_bus_info (or the NVIDIA specific attributes). Returns an empty
+   *        string if the platform does not report it.
+   */
+  [[nodiscard]] const std::string& pci_bus_id() const;
+
  private:
   uint64_t _compute_cores();
+  std::string _query_pci_bus_id() const;
 
   /// set by constructor
   cl::Device _cl_device;
@@ -197,6 +207,10 @@ class Device {
   /// set by constructor
   uint32_t _id;
   /// set by constructor
+  Type _type;
+  /// set by constructor via _query_pci_bus_id()
+  std::string _pci_bus_id;
+  /// set by constructor
   uint32_t _instructions_per_cycle;
   /// set by constructor via _compute_cores()
   uint64_t _cores;
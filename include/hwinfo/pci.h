@@ -0,0 +1,62 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+/**
+ * A single PCI function as found on the PCI bus (e.g. /sys/bus/pci/devices/0000:00:02.0 on Linux). Names are resolved
+ * via the compiled PCI ID database.
+ */
+class HWINFO_API PCIBusDevice {
+  friend std::vector<PCIBusDevice> getAllPCIDevices();
+
+ public:
+  ~PCIBusDevice() = default;
+
+  // bus address in the form domain:bus:device.function, e.g. "0000:00:02.0"
+  HWI_NODISCARD const std::string& address() const;
+  HWI_NODISCARD uint16_t vendor_id() const;
+  HWI_NODISCARD uint16_t device_id() const;
+  HWI_NODISCARD uint16_t subvendor_id() const;
+  HWI_NODISCARD uint16_t subdevice_id() const;
+  // 24 bit class code: base class << 16 | subclass << 8 | programming interface
+  HWI_NODISCARD uint32_t class_code() const;
+  HWI_NODISCARD const std::string& vendor() const;
+  HWI_NODISCARD const std::string& name() const;
+  HWI_NODISCARD const std::string& subsystem() const;
+  HWI_NODISCARD const std::string& driver() const;
+  // -1 if unknown or the system has no NUMA
+  HWI_NODISCARD int numa_node() const;
+  // e.g. "8.0 GT/s PCIe", empty if the function has no PCIe link
+  HWI_NODISCARD const std::string& link_speed() const;
+  // number of lanes, -1 if the function has no PCIe link
+  HWI_NODISCARD int link_width() const;
+
+ private:
+  PCIBusDevice() = default;
+  std::string _address{};
+  uint16_t _vendor_id{0};
+  uint16_t _device_id{0};
+  uint16_t _subvendor_id{0};
+  uint16_t _subdevice_id{0};
+  uint32_t _class_code{0};
+  std::string _vendor{};
+  std::string _name{};
+  std::string _subsystem{};
+  std::string _driver{};
+  int _numa_node{-1};
+  std::string _link_speed{};
+  int _link_width{-1};
+};
+
+std::vector<PCIBusDevice> getAllPCIDevices();
+
+}  // namespace hwinfo
@@ -0,0 +1,106 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+/**
+ * Hardware performance counters per logical CPU (Linux: perf_event_open()), for detecting noisy neighbours through
+ * drops in IPC and rising cache and branch miss rates. Each online CPU gets one counter group (cycles, instructions,
+ * last level cache misses, branch misses, stalled backend cycles) that is read with a single read() per sample.
+ *
+ * If more events are active than the PMU has counters, the kernel multiplexes the groups and a group only counts for
+ * part of the interval. The counts are scaled by enabled / running time to estimate the full interval and coverage
+ * reports the fraction that was actually measured.
+ *
+ * Counting all tasks of a CPU requires perf_event_paranoid <= 0 or CAP_PERFMON. Without the permission, in virtual
+ * machines without a virtual PMU and on other platforms than Linux the sampler reports available() false with the
+ * reason in error(), and sample() returns empty samples. Events the CPU does not support are -1.
+ *
+ * The groups are opened for the CPUs online at construction. A PerfCounterSampler is not synchronized, use one
+ * instance per thread.
+ */
+class HWINFO_API PerfCounterSampler {
+ public:
+  struct Counters {
+    // logical CPU, -1 for the total over all CPUs
+    int cpu{-1};
+    // events since the previous sample, scaled for multiplexing. -1 if not available
+    int64_t cycles{-1};
+    int64_t instructions{-1};
+    int64_t cache_misses{-1};
+    int64_t branch_misses{-1};
+    int64_t stalled_cycles{-1};
+    // fraction of the interval the group was scheduled on the PMU, 1 without multiplexing
+    double coverage{0.0};
+    // instructions per cycle
+    double ipc{-1.0};
+    // last level cache misses and branch misses per 1000 instructions
+    double cache_mpki{-1.0};
+    double branch_mpki{-1.0};
+    // stalled backend cycles per cycle
+    double stalled_ratio{-1.0};
+  };
+
+  struct Sample {
+    // seconds since the previous sample, 0 for the first one
+    double interval_s{0.0};
+    // one entry per counted CPU (ordered by CPU), empty for the first sample
+    std::vector<Counters> cpus;
+    // sum over all CPUs
+    Counters total;
+  };
+
+  PerfCounterSampler();
+  ~PerfCounterSampler();
+  PerfCounterSampler(const PerfCounterSampler&) = delete;
+  PerfCounterSampler& operator=(const PerfCounterSampler&) = delete;
+
+  // false if no counter could be opened
+  HWI_NODISCARD bool available() const { return _backend != nullptr; }
+  // why the counters are not available, e.g. "perf_event_paranoid is 2 (requires <= 0 or CAP_PERFMON)"
+  HWI_NODISCARD const std::string& error() const { return _error; }
+
+  /**
+   * Reads all groups once and returns the events since the previous call.
+   */
+  Sample sample();
+
+ private:
+  // one cumulative reading of a group: raw counts in the order of Counters (-1 if the event is not counted), enabled
+  // and running time in ns
+  struct Reading {
+    int64_t values[5]{-1, -1, -1, -1, -1};
+    uint64_t enabled_ns{0};
+    uint64_t running_ns{0};
+  };
+
+  // platform specific counter groups, see src/<platform>/perf_counters.cpp
+  struct Backend;
+  struct BackendDeleter {
+    void operator()(Backend* backend) const;
+  };
+  // opens one group per online CPU, returns nullptr and sets error if none could be opened
+  static Backend* open_backend(std::string& error);
+  // fills cpus and one reading per CPU, returns false if nothing was read
+  static bool read_counters(Backend& backend, std::vector<int>& cpus, std::vector<Reading>& readings);
+
+  // declared before _backend, which is opened into it
+  std::string _error;
+  std::unique_ptr<Backend, BackendDeleter> _backend;
+  std::vector<int> _cpus;
+  std::vector<Reading> _readings;
+  std::vector<Reading> _previous;
+  std::chrono::steady_clock::time_point _last{};
+};
+
+}  // namespace hwinfo
@@ -0,0 +1,112 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+/**
+ * Cumulative resource usage of the calling process or of one of its threads. Times and counters count since the
+ * process (thread) started, only deltas between two readings are meaningful. Values that are not available are -1.
+ */
+struct HWINFO_API ProcessStats {
+  // process id, the thread id for the threads of ProcessSampler::Sample
+  int64_t id{-1};
+  // command name of the process (Linux: comm), name of the thread
+  std::string name;
+  int64_t user_time_ns{-1};
+  int64_t system_time_ns{-1};
+  // memory of the process, -1 for threads
+  int64_t rss_Bytes{-1};
+  int64_t peak_rss_Bytes{-1};
+  int64_t virtual_Bytes{-1};
+  // page faults served without I/O (Windows: all page faults) and page faults that required I/O
+  int64_t minor_faults{-1};
+  int64_t major_faults{-1};
+  int64_t voluntary_context_switches{-1};
+  int64_t involuntary_context_switches{-1};
+  // threads of the process, -1 for threads
+  int64_t num_threads{-1};
+  // logical CPU the process (thread) last ran on (Linux)
+  int cpu{-1};
+
+  /**
+   * Reads the counters of the calling process once, without its threads.
+   */
+  static ProcessStats current();
+};
+
+/**
+ * Resource usage of the calling process for self-monitoring of services (Linux: getrusage() and /proc/self/stat,
+ * macOS: getrusage() and task_info(), Windows: GetProcessTimes() and GetProcessMemoryInfo()). Like DiskIOSampler,
+ * rates are deltas between two consecutive sample() calls, so call it at a fixed interval. The first sample reports
+ * the counters with all rates -1.
+ *
+ * With threads enabled every sample also covers each thread of the process (Linux: /proc/self/task/<tid>/stat and
+ * status, macOS: thread_info(), Windows: GetThreadTimes()). The files of a thread are opened on the first sample that
+ * sees it and kept open until it exits.
+ *
+ * A ProcessSampler is not synchronized, use one instance per thread.
+ */
+class HWINFO_API ProcessSampler {
+  friend struct ProcessStats;
+
+ public:
+  struct Usage {
+    // the counters at this sample
+    ProcessStats stats;
+    // CPU time per wall time: 1 is one logical CPU busy for the whole period, a process can exceed 1
+    double cpu_utilisation{-1.0};
+    double user_utilisation{-1.0};
+    double system_utilisation{-1.0};
+    double minor_faults_per_s{-1.0};
+    double major_faults_per_s{-1.0};
+    // voluntary and involuntary context switches
+    double context_switches_per_s{-1.0};
+  };
+
+  struct Sample {
+    // seconds since the previous sample, 0 for the first one
+    double interval_s{0.0};
+    Usage process;
+    // ordered by thread id, empty if threads are disabled
+    std::vector<Usage> threads;
+  };
+
+  explicit ProcessSampler(bool threads = false);
+  ~ProcessSampler();
+  ProcessSampler(const ProcessSampler&) = delete;
+  ProcessSampler& operator=(const ProcessSampler&) = delete;
+
+  /**
+   * Reads the counters once and returns the rates since the previous call.
+   */
+  Sample sample();
+
+ private:
+  // platform specific open files and handles, see src/<platform>/process.cpp
+  struct Backend;
+  struct BackendDeleter {
+    void operator()(Backend* backend) const;
+  };
+  static Backend* open_backend();
+  // fills process and, if threads is not nullptr, appends one entry per thread. Returns false if nothing was read
+  static bool read_counters(Backend& backend, ProcessStats& process, std::vector<ProcessStats>* threads);
+
+  bool _threads;
+  std::unique_ptr<Backend, BackendDeleter> _backend;
+  ProcessStats _previous;
+  std::unordered_map<int64_t, ProcessStats> _previous_threads;
+  std::chrono::steady_clock::time_point _last{};
+};
+
+}  // namespace hwinfo
@@ -3,14 +3,131 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <string>
 #include <vector>
 
 #include "hwinfo/platform.h"
+#include "hwinfo/utils/fields.h"
 
 namespace hwinfo {
 
+/**
+ * Data collected by the Memory constructor. free_Bytes() and available_Bytes() are always read on demand.
+ */
+enum class MemoryFields : uint32_t {
+  Modules = 1u << 0,
+  // NUMA nodes, huge page pools and page sizes, see Memory::topology()
+  Topology = 1u << 1,
+  All = (1u << 2) - 1,
+};
+
+template <>
+struct enable_field_mask<MemoryFields> : std::true_type {};
+
+/**
+ * System wide memory counters read by Memory::snapshot(). Values that the platform does not report are -1.
+ */
+struct MemoryStats {
+  int64_t total_Bytes{-1};
+  int64_t free_Bytes{-1};
+  int64_t available_Bytes{-1};
+  int64_t buffers_Bytes{-1};
+  int64_t cached_Bytes{-1};
+  int64_t shmem_Bytes{-1};
+  int64_t dirty_Bytes{-1};
+  int64_t swap_total_Bytes{-1};
+  int64_t swap_free_Bytes{-1};
+  int64_t huge_pages_total{-1};
+  int64_t huge_pages_free{-1};
+  int64_t huge_page_size_Bytes{-1};
+};
+
+/**
+ * Memory limits of the cgroup the calling process belongs to (Linux). Inside a container these are the effective
+ * limits, the host values of MemoryStats do not apply. Values that are not set are -1.
+ */
+struct MemoryLimits {
+  // 1 or 2, 0 if no memory cgroup controller is mounted
+  int cgroup_version{0};
+  // the tightest memory.max (v2) or memory.limit_in_bytes (v1) of the cgroup and its ancestors, -1 if unlimited
+  int64_t limit_Bytes{-1};
+  // memory.current (v2) or memory.usage_in_bytes (v1)
+  int64_t usage_Bytes{-1};
+  // memory.swap.max (v2) or memory.memsw.limit_in_bytes (v1, memory plus swap), -1 if unlimited
+  int64_t swap_limit_Bytes{-1};
+  // from memory.stat
+  int64_t anon_Bytes{-1};
+  int64_t file_Bytes{-1};
+  int64_t inactive_file_Bytes{-1};
+  // limit - usage + inactive file pages (reclaimable without pressure), -1 if unlimited
+  int64_t available_Bytes{-1};
+};
+
+/**
+ * Memory pressure stall information (PSI, Linux 4.20+): the share of wall time in percent in which some (or all)
+ * non-idle tasks waited for memory, averaged over 10 s, 60 s and 300 s. -1 if not available.
+ */
+struct MemoryPressure {
+  struct Stall {
+    double avg10{-1.0};
+    double avg60{-1.0};
+    double avg300{-1.0};
+    // accumulated stall time
+    int64_t total_us{-1};
+  };
+  Stall some;
+  Stall full;
+};
+
+/**
+ * One pool of huge pages of a single page size (Linux: /sys/kernel/mm/hugepages/hugepages-<size>kB and the per node
+ * copies, Windows: large pages). Counts are in pages, values that are not reported are -1.
+ */
+struct HugePagePool {
+  int64_t page_size_Bytes{-1};
+  // persistent pages of the pool (nr_hugepages) and the unused ones
+  int64_t total{-1};
+  int64_t free{-1};
+  // pages promised to mappings but not faulted in yet, system wide pools only
+  int64_t reserved{-1};
+  // pages allocated beyond total on demand (overcommit)
+  int64_t surplus{-1};
+};
+
+/**
+ * Memory of one NUMA node. Systems without NUMA report a single node 0 holding all memory.
+ */
+struct MemoryNode {
+  int id{-1};
+  // logical CPUs local to the node
+  std::vector<int> cpus;
+  int64_t total_Bytes{-1};
+  // updated by Memory::refresh()
+  int64_t free_Bytes{-1};
+  // one pool per supported huge page size, ordered by page size. Memory::refresh() updates the free pages of the pools
+  // that were not empty when the topology was read
+  std::vector<HugePagePool> huge_pages;
+};
+
+/**
+ * Page sizes and NUMA layout for sizing allocator arenas. Values that the platform does not report are -1 or empty.
+ */
+struct MemoryTopology {
+  int64_t page_size_Bytes{-1};
+  // transparent huge pages (Linux): the selected mode of enabled ("always", "madvise" or "never") and defrag, and the
+  // size of a THP (PMD size)
+  std::string thp_enabled;
+  std::string thp_defrag;
+  int64_t thp_page_size_Bytes{-1};
+  // default huge page size (Hugepagesize) and the system wide pools, ordered by page size
+  int64_t default_huge_page_size_Bytes{-1};
+  std::vector<HugePagePool> huge_pages;
+  // ordered by node id
+  std::vector<MemoryNode> nodes;
+};
+
 class HWINFO_API Memory {
  public:
   struct Module {
@@ -25,15 +142,108 @@ class HWINFO_API Memory {
 
  public:
   Memory();
+  explicit Memory(MemoryFields fields);
   ~Memory() = default;
 
   HWI_NODISCARD const std::vector<Memory::Module>& modules() const;
   HWI_NODISCARD int64_t total_Bytes() const;
   HWI_NODISCARD int64_t free_Bytes() const;
+  // the smaller of the system wide available memory and the available memory of the cgroup (see limits())
   HWI_NODISCARD int64_t available_Bytes() const;
+  /**
+   * Page sizes, THP mode and per NUMA node memory and huge page pools, collected by the constructor in one pass over
+   * sysfs (MemoryFields::Topology). refresh() updates the free memory and free huge pages of each node.
+   */
+  HWI_NODISCARD const MemoryTopology& topology() const;
+
+  /**
+   * Reads all memory counters at once (Linux: one read of /proc/meminfo into a stack buffer, no heap allocation).
+   */
+  static MemoryStats snapshot();
+
+  /**
+   * Limits of the memory cgroup of the calling process (Linux, read on every call). available_Bytes() already takes
+   * them into account.
+   */
+  static MemoryLimits limits();
+
+  /**
+   * Pressure stall information of the memory cgroup of the calling process (cgroup v2) or of the whole system.
+   */
+  static MemoryPressure pressure();
+
+  /**
+   * Reads free and available memory in a single pass (e.g. one read of /proc/meminfo) and, if the topology was
+   * collected, the free memory of every NUMA node (one read per node). free_Bytes() and available_Bytes() query the
+   * system on every call, lastFree_Bytes() and lastAvailable_Bytes() return the values of the last refresh() (-1
+   * before).
+   * @return false if the values could not be read
+   */
+  bool refresh();
+  HWI_NODISCARD int64_t lastFree_Bytes() const;
+  HWI_NODISCARD int64_t lastAvailable_Bytes() const;
 
  private:
   std::vector<Memory::Module> _modules;
+  int64_t _free_Bytes{-1};
+  int64_t _available_Bytes{-1};
+  MemoryTopology _topology;
+
+  // fills _modules from the SMBIOS memory devices, returns false if there are none (see utils::SMBIOS::tables())
+  bool modulesFromSMBIOS();
+  // platform specific: fills _topology, and updates the free memory and free huge pages of its nodes
+  void readTopology();
+  void refreshNodes();
+};
+
+/**
+ * Memory::snapshot() for polling: Linux keeps /proc/meminfo open and rereads it with one pread per sample. The other
+ * platforms query the system like Memory::snapshot(), which needs no handle there.
+ */
+class HWINFO_API MemorySampler {
+ public:
+  MemorySampler();
+  ~MemorySampler();
+
+  MemorySampler(const MemorySampler&) = delete;
+  MemorySampler& operator=(const MemorySampler&) = delete;
+
+  MemoryStats sample();
+
+ private:
+  // /proc/meminfo (Linux), -1 if it could not be opened and on other platforms
+  int _fd{-1};
+};
+
+/**
+ * PSI trigger (Linux 5.2+) that fires as soon as tasks stalled on memory for more than stall within window. Use one
+ * trigger per thread: wait() blocks until the threshold is crossed, fd() can be added to an own poll() loop (POLLPRI).
+ * The trigger is registered for the memory cgroup of the calling process if it has one (cgroup v2).
+ */
+class HWINFO_API MemoryPressureTrigger {
+ public:
+  /**
+   * @param window between 500 ms and 10 s
+   * @param full track the time in which all non-idle tasks stalled instead of at least one
+   */
+  MemoryPressureTrigger(std::chrono::microseconds stall, std::chrono::microseconds window, bool full = false);
+  ~MemoryPressureTrigger();
+
+  MemoryPressureTrigger(const MemoryPressureTrigger&) = delete;
+  MemoryPressureTrigger& operator=(const MemoryPressureTrigger&) = delete;
+
+  // false if PSI triggers are not supported (kernel, permissions or platform)
+  HWI_NODISCARD bool valid() const;
+  HWI_NODISCARD int fd() const;
+
+  /**
+   * Blocks until the trigger fires or timeout elapsed.
+   * @return true if the stall threshold was crossed
+   */
+  bool wait(std::chrono::milliseconds timeout);
+
+ private:
+  int _fd{-1};
 };
 
 }  // namespace hwinfo
@@ -0,0 +1,228 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hwinfo/platform.h"
+#include "hwinfo/snapshot.h"
+
+namespace hwinfo {
+
+/**
+ * Sections of a serialized snapshot, one record per device. The values are part of the format and never reused.
+ */
+enum class SnapshotSection : uint16_t {
+  Cpu = 1,
+  Os = 2,
+  Gpu = 3,
+  Memory = 4,
+  MemoryModule = 5,
+  MainBoard = 6,
+  Battery = 7,
+  Disk = 8,
+  Network = 9,
+  Monitor = 10,
+  Pci = 11,
+};
+
+/**
+ * Field IDs of the records per section. New attributes get new IDs, readers skip IDs they do not know and report
+ * missing fields as absent, so the format stays readable in both directions. Fields marked as repeated occur once per
+ * element. Only the inventory (identity and static attributes) is serialized, load and usage values are not.
+ */
+enum class CpuField : uint16_t {
+  Id = 1,
+  Vendor = 2,
+  Model = 3,
+  NumPhysicalCores = 4,
+  NumLogicalCores = 5,
+  MaxClockSpeed_MHz = 6,
+  RegularClockSpeed_MHz = 7,
+  L1CacheSize_Bytes = 8,
+  L2CacheSize_Bytes = 9,
+  L3CacheSize_Bytes = 10,
+  // repeated
+  Flag = 11,
+};
+
+enum class OsField : uint16_t { Name = 1, Version = 2, Kernel = 3, Bits = 4, LittleEndian = 5 };
+
+enum class GpuField : uint16_t {
+  Id = 1,
+  Vendor = 2,
+  Name = 3,
+  DriverVersion = 4,
+  Memory_Bytes = 5,
+  Frequency_MHz = 6,
+  NumCores = 7,
+  VendorId = 8,
+  DeviceId = 9,
+  PciBusId = 10,
+};
+
+enum class MemoryField : uint16_t { Total_Bytes = 1 };
+
+enum class MemoryModuleField : uint16_t {
+  Id = 1,
+  Vendor = 2,
+  Name = 3,
+  Model = 4,
+  SerialNumber = 5,
+  Total_Bytes = 6,
+  Frequency_Hz = 7,
+};
+
+enum class MainBoardField : uint16_t { Vendor = 1, Name = 2, Version = 3, SerialNumber = 4 };
+
+enum class BatteryField : uint16_t { Vendor = 1, Model = 2, SerialNumber = 3, Technology = 4, EnergyFull = 5 };
+
+enum class DiskField : uint16_t {
+  Id = 1,
+  Vendor = 2,
+  Model = 3,
+  SerialNumber = 4,
+  Size_Bytes = 5,
+  // repeated
+  Volume = 6,
+};
+
+enum class NetworkField : uint16_t {
+  InterfaceIndex = 1,
+  Description = 2,
+  Mac = 3,
+  IP4 = 4,
+  // repeated
+  IP6 = 5,
+  Type = 6,
+  Mtu = 7,
+  LinkSpeed_Mbps = 8,
+  Driver = 9,
+  PciAddress = 10,
+  NumaNode = 11,
+  RxQueues = 12,
+  TxQueues = 13,
+  CombinedChannels = 14,
+  RxRingSize = 15,
+  TxRingSize = 16,
+  // repeated
+  Feature = 17,
+};
+
+enum class MonitorField : uint16_t { Vendor = 1, Model = 2, Resolution = 3, RefreshRate = 4, SerialNumber = 5 };
+
+enum class PciField : uint16_t {
+  Address = 1,
+  VendorId = 2,
+  DeviceId = 3,
+  SubvendorId = 4,
+  SubdeviceId = 5,
+  ClassCode = 6,
+  Vendor = 7,
+  Name = 8,
+  Subsystem = 9,
+  Driver = 10,
+  NumaNode = 11,
+  LinkSpeed = 12,
+  LinkWidth = 13,
+};
+
+/**
+ * Zero-copy view of one record of a SnapshotView. Strings point into the serialized buffer, fields are looked up by a
+ * scan over the (few) encoded fields of the record.
+ */
+class HWINFO_API RecordView {
+ public:
+  RecordView(const uint8_t* data, size_t size, const std::string_view* strings, size_t num_strings);
+
+  template <typename F>
+  HWI_NODISCARD bool has(F field) const {
+    return find(static_cast<uint16_t>(field), 0) != nullptr;
+  }
+  // the value of an integer field or fallback if the field is absent
+  template <typename F>
+  HWI_NODISCARD int64_t integer(F field, int64_t fallback = -1) const {
+    return integer(static_cast<uint16_t>(field), fallback);
+  }
+  // empty if the field is absent
+  template <typename F>
+  HWI_NODISCARD std::string_view string(F field) const {
+    return string(static_cast<uint16_t>(field));
+  }
+  // all values of a repeated string field
+  template <typename F>
+  HWI_NODISCARD std::vector<std::string_view> strings(F field) const {
+    return strings(static_cast<uint16_t>(field));
+  }
+
+  HWI_NODISCARD const uint8_t* data() const { return _data; }
+  HWI_NODISCARD size_t size() const { return _size; }
+  // resolves an index into the string table of the buffer, empty if out of range
+  HWI_NODISCARD std::string_view stringAt(uint64_t index) const;
+
+ private:
+  HWI_NODISCARD const uint8_t* find(uint16_t id, size_t occurrence) const;
+  HWI_NODISCARD int64_t integer(uint16_t id, int64_t fallback) const;
+  HWI_NODISCARD std::string_view string(uint16_t id) const;
+  HWI_NODISCARD std::vector<std::string_view> strings(uint16_t id) const;
+
+  const uint8_t* _data;
+  size_t _size;
+  const std::string_view* _strings;
+  size_t _num_strings;
+};
+
+/**
+ * Parses a buffer created by serializeSnapshot() without copying it: the string table and the record boundaries are
+ * indexed once, strings are views into data. data must outlive the view and its records.
+ */
+class HWINFO_API SnapshotView {
+ public:
+  SnapshotView(const uint8_t* data, size_t size);
+  explicit SnapshotView(const std::vector<uint8_t>& data);
+
+  SnapshotView(const SnapshotView&) = delete;
+  SnapshotView& operator=(const SnapshotView&) = delete;
+  SnapshotView(SnapshotView&&) noexcept = default;
+  SnapshotView& operator=(SnapshotView&&) noexcept = default;
+
+  // false if the buffer is truncated, malformed, a diff or of an unsupported version
+  HWI_NODISCARD bool valid() const;
+  HWI_NODISCARD uint32_t version() const;
+  // the records of section, empty if the snapshot does not contain the section
+  HWI_NODISCARD const std::vector<RecordView>& records(SnapshotSection section) const;
+
+ private:
+  bool _valid{false};
+  uint32_t _version{0};
+  std::vector<std::string_view> _strings;
+  std::vector<std::pair<SnapshotSection, std::vector<RecordView>>> _sections;
+};
+
+/**
+ * Serializes the inventory of a snapshot into a versioned binary format: varints for integers, one table of unique
+ * strings that records refer to by index (vendor and model names repeat across devices), and sections that carry
+ * their length so unknown sections are skipped.
+ */
+std::vector<uint8_t> serializeSnapshot(const Snapshot& snapshot);
+
+/**
+ * Encodes current against previous (both created by serializeSnapshot()): unchanged sections are a single marker,
+ * unchanged records a reference to their position in previous, and only changed records and their strings are
+ * stored. Records are compared by position, which matches the sorted device lists of the collectors.
+ * @return the diff or an empty vector if one of the inputs is invalid
+ */
+std::vector<uint8_t> diffSnapshots(const std::vector<uint8_t>& previous, const std::vector<uint8_t>& current);
+
+/**
+ * Rebuilds the serialized current snapshot from previous and a diff created by diffSnapshots().
+ * @return the snapshot or an empty vector if one of the inputs is invalid or the diff does not belong to previous
+ */
+std::vector<uint8_t> applySnapshotDiff(const std::vector<uint8_t>& previous, const std::vector<uint8_t>& diff);
+
+}  // namespace hwinfo
@@ -0,0 +1,69 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "hwinfo/battery.h"
+#include "hwinfo/cpu.h"
+#include "hwinfo/disk.h"
+#include "hwinfo/gpu.h"
+#include "hwinfo/mainboard.h"
+#include "hwinfo/monitor.h"
+#include "hwinfo/network.h"
+#include "hwinfo/os.h"
+#include "hwinfo/pci.h"
+#include "hwinfo/platform.h"
+#include "hwinfo/ram.h"
+
+namespace hwinfo {
+
+/**
+ * Selects the subsystems collected by collect().
+ */
+struct Options {
+  bool cpu{true};
+  bool os{true};
+  bool gpu{true};
+  bool gpu_opencl{true};
+  bool ram{true};
+  bool mainboard{true};
+  bool battery{true};
+  bool disk{true};
+  bool network{true};
+  bool monitor{true};
+  bool pci{true};
+  // attributes to read of the selected subsystems
+  DiskFields disk_fields{DiskFields::All};
+  NetworkFields network_fields{NetworkFields::All};
+  MemoryFields ram_fields{MemoryFields::All};
+  // number of worker threads, 0: one per selected subsystem but at most std::thread::hardware_concurrency()
+  size_t num_threads{0};
+};
+
+/**
+ * Aggregate of all subsystems collected by collect(). Subsystems that were not selected (or failed) are empty.
+ */
+struct Snapshot {
+  std::vector<CPU> cpus;
+  std::optional<OS> os;
+  std::vector<GPU> gpus;
+  std::optional<Memory> ram;
+  std::optional<MainBoard> mainboard;
+  std::vector<Battery> batteries;
+  std::vector<Disk> disks;
+  std::vector<Network> networks;
+  std::vector<Monitor> monitors;
+  std::vector<PCIBusDevice> pci_devices;
+};
+
+/**
+ * Collects the selected subsystems concurrently on a small thread pool. Every worker thread keeps its own platform
+ * state (e.g. the COM apartment and WMI connection on Windows), which is released when the workers exit.
+ */
+Snapshot collect(const Options& options = {});
+
+}  // namespace hwinfo
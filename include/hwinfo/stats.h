@@ -0,0 +1,48 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+/**
+ * Accumulated cost of one probe, e.g. "monitor.drm" for the DRM ioctls of getAllMonitors() or "disk.mountinfo" for
+ * parsing /proc/self/mountinfo. Wall time includes nested probes, the counters only count the work of the innermost
+ * probe active on a thread.
+ */
+struct ProbeStats {
+  std::string name;
+  uint64_t calls{0};
+  uint64_t wall_time_ns{0};
+  uint64_t max_wall_time_ns{0};
+  // system calls other than open and read (ioctl, netlink, statvfs, WMI/COM calls, ...)
+  uint64_t syscalls{0};
+  uint64_t file_opens{0};
+  uint64_t read_Bytes{0};
+};
+
+/**
+ * Per probe statistics since the start of the process or the last resetStats(), sorted by name. Only collected if
+ * hwinfo was built with HWINFO_INSTRUMENTATION, otherwise the result is always empty.
+ */
+std::vector<ProbeStats> stats();
+void resetStats();
+
+/**
+ * Records every probe call as a complete event ("ph": "X") in Chrome trace format until stopTrace() writes them to
+ * path. Load the file in chrome://tracing or https://ui.perfetto.dev.
+ * @return false if hwinfo was built without HWINFO_INSTRUMENTATION or a trace is already running
+ */
+bool startTrace(const std::string& path);
+/**
+ * @return false if no trace was running or the file could not be written
+ */
+bool stopTrace();
+
+}  // namespace hwinfo
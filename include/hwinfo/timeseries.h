@@ -0,0 +1,145 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "hwinfo/collector.h"
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+
+/**
+ * Reduction of a window of samples. All values are -1 if the window is empty. Percentiles use the nearest rank.
+ */
+struct SeriesAggregate {
+  size_t count{0};
+  double min{-1.0};
+  double max{-1.0};
+  double mean{-1.0};
+  double p50{-1.0};
+  double p90{-1.0};
+  double p99{-1.0};
+};
+
+/**
+ * Reduces a contiguous column of values. min, max and the sum are computed in one branch-free pass with independent
+ * accumulators, which the compiler vectorizes.
+ */
+SeriesAggregate aggregate(const double* values, size_t count);
+
+/**
+ * Compressed column of (timestamp, value) samples. Timestamps are stored as delta-of-delta, values either as XOR of
+ * consecutive IEEE doubles (Gauge, e.g. utilisation or temperature) or as delta-of-delta of integers (Counter, e.g.
+ * cumulative bytes or jiffies, values are rounded to integers and saturated to the int64_t range, NaN is stored as 0).
+ * Samples are encoded in blocks of block_size entries that begin with raw values, so windows are decoded from the
+ * first overlapping block and old history is discarded block by block.
+ *
+ * Regularly sampled metrics take a few bits per sample instead of 16 bytes. Timestamps must not decrease.
+ */
+class HWINFO_API TimeSeries {
+ public:
+  enum class Encoding : uint8_t { Gauge, Counter };
+
+  static constexpr uint32_t block_size = 512;
+
+  explicit TimeSeries(Encoding encoding = Encoding::Gauge);
+
+  void append(int64_t timestamp_ms, double value);
+
+  /**
+   * Appends the samples with from_ms <= timestamp < to_ms to the output vectors.
+   * @return the number of samples appended
+   */
+  size_t decode(int64_t from_ms, int64_t to_ms, std::vector<int64_t>& timestamps_ms, std::vector<double>& values) const;
+  HWI_NODISCARD SeriesAggregate aggregate(int64_t from_ms, int64_t to_ms) const;
+
+  // discards the blocks that only contain samples older than timestamp_ms
+  void dropBefore(int64_t timestamp_ms);
+
+  HWI_NODISCARD Encoding encoding() const;
+  HWI_NODISCARD size_t size() const;
+  // -1 if the series is empty
+  HWI_NODISCARD int64_t firstTimestamp_ms() const;
+  HWI_NODISCARD int64_t lastTimestamp_ms() const;
+  // size of the encoded samples
+  HWI_NODISCARD size_t memory_Bytes() const;
+
+ private:
+  struct Block {
+    int64_t first_timestamp_ms{0};
+    int64_t last_timestamp_ms{0};
+    uint32_t count{0};
+    uint64_t num_bits{0};
+    std::vector<uint64_t> bits;
+  };
+
+  // encoder state of the last block
+  struct State {
+    int64_t timestamp_ms{0};
+    int64_t delta_ms{0};
+    uint64_t value_bits{0};
+    // two's complement, the deltas wrap instead of overflowing
+    uint64_t counter{0};
+    uint64_t counter_delta{0};
+    int leading{-1};
+    int trailing{0};
+  };
+
+  Encoding _encoding;
+  std::deque<Block> _blocks;
+  State _state;
+  size_t _size{0};
+};
+
+/**
+ * Columnar store of collector records: every (metric, index, value) triple of a Record, e.g. the utilisation of CPU
+ * 17, is kept in its own TimeSeries. Levels and rates are Gauge series, the cumulative counters of the *Totals metrics
+ * are Counter series (see encoding()). Unavailable values (-1) are not stored. Fill it with Collector::drain().
+ */
+class HWINFO_API TimeSeriesStore {
+ public:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  // samples older than retention are discarded while appending, zero keeps everything
+  explicit TimeSeriesStore(std::chrono::milliseconds retention = std::chrono::milliseconds(0));
+
+  void append(const Record& record);
+
+  /**
+   * @param value position in Record::values (see Metric)
+   * @return the series or nullptr if nothing was stored for it
+   */
+  HWI_NODISCARD const TimeSeries* series(Metric metric, uint16_t index, uint8_t value) const;
+  HWI_NODISCARD SeriesAggregate aggregate(Metric metric, uint16_t index, uint8_t value, TimePoint from,
+                                          TimePoint to) const;
+  /**
+   * Per second increase of a counter series over the samples in [from, to), e.g. the received Bytes/s of an interface
+   * from Metric::NetworkTotals. A counter that decreased was reset, the increase counts from zero again.
+   * @return -1 if the window holds fewer than two samples
+   */
+  HWI_NODISCARD double rate(Metric metric, uint16_t index, uint8_t value, TimePoint from, TimePoint to) const;
+
+  // Counter for the cumulative *Totals metrics, Gauge for all others
+  static TimeSeries::Encoding encoding(Metric metric);
+
+  // indices that have a series for metric, e.g. all CPUs
+  HWI_NODISCARD std::vector<uint16_t> indices(Metric metric) const;
+  HWI_NODISCARD size_t memory_Bytes() const;
+
+  static int64_t toTimestamp_ms(TimePoint time);
+
+ private:
+  static uint32_t key(Metric metric, uint16_t index, uint8_t value);
+
+  std::chrono::milliseconds _retention;
+  std::map<uint32_t, TimeSeries> _series;
+};
+
+}  // namespace hwinfo
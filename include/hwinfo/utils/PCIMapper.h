@@ -11,50 +11,142 @@
 
 #ifdef HWINFO_UNIX
 
-#include <map>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace hwinfo {
 
+/**
+ * Subsystem (board/card level) entry of the PCI ID database, identified by subvendor and subdevice ID.
+ */
+struct PCISubsystem {
+  uint16_t subvendor_id{0};
+  uint16_t subdevice_id{0};
+  std::string_view subsystem_name{"invalid"};
+};
+
+/**
+ * Lightweight view of a device entry of the PCI ID database (see PCI::useDatabase()). Copying is cheap, the name
+ * points into the embedded tables or the mapped database file, both stay valid for the rest of the process.
+ */
 struct PCIDevice {
-  PCIDevice(std::string d_id, std::string d_name);
+  PCIDevice() = default;
+  PCIDevice(uint16_t d_id, std::string_view d_name);
+
+  /**
+   * @return the subsystem or an invalid subsystem (name "invalid") if the pair is unknown for this device
+   */
+  PCISubsystem subsystem(uint16_t subvendor_id, uint16_t subdevice_id) const;
+
+  uint16_t device_id{0};
+  std::string_view device_name{"invalid"};
 
-  const std::string device_id{};
-  const std::string device_name{};
-  std::map<std::string, std::string> subsystems{};
+ private:
+  friend class PCIMapper;
+  uint32_t _first_subsystem{0};
+  uint32_t _num_subsystems{0};
 };
 
+/**
+ * Lightweight view of a vendor entry of the PCI ID database. Device lookups are binary searches.
+ */
 struct PCIVendor {
-  PCIVendor(std::string v_id, std::string v_name);
+  PCIVendor() = default;
+  PCIVendor(uint16_t v_id, std::string_view v_name);
 
-  const PCIDevice& operator[](const std::string& device_id) const;
+  /**
+   * @param device_id hexadecimal device ID with or without "0x" prefix (e.g. "0x2484" as read from sysfs)
+   * @return the device or an invalid device (name "invalid") if the ID is unknown
+   */
+  PCIDevice operator[](const std::string& device_id) const;
+  PCIDevice operator[](uint16_t device_id) const;
 
-  const std::string vendor_id{};
-  const std::string vendor_name{};
-  std::map<std::string, PCIDevice> devices{};
+  uint16_t vendor_id{0};
+  std::string_view vendor_name{"invalid"};
 
  private:
-  PCIDevice _invalid_device{"0000", "invalid"};
+  friend class PCIMapper;
+  uint32_t _first_device{0};
+  uint32_t _num_devices{0};
+};
+
+/**
+ * IDs of a PCI function to resolve with PCIMapper::resolve(). The subsystem is only resolved if subvendor_id is set.
+ */
+struct PCIId {
+  uint16_t vendor_id{0};
+  uint16_t device_id{0};
+  uint16_t subvendor_id{0};
+  uint16_t subdevice_id{0};
+};
+
+struct PCIResolved {
+  PCIVendor vendor;
+  PCIDevice device;
+  PCISubsystem subsystem;
 };
 
 class PCIMapper {
  public:
-  explicit PCIMapper();
+  explicit PCIMapper() = default;
   ~PCIMapper() = default;
 
-  const PCIVendor& vendor_from_id(const std::string& vendor_id) const;
+  /**
+   * Parses a hexadecimal PCI ID with or without "0x" prefix. Surrounding whitespace and a trailing newline are ignored.
+   * @return false if id is not a valid 16 bit hexadecimal number
+   */
+  static bool parse_id(const std::string& id, uint16_t& out);
+
+  /**
+   * Resolves count (vendor, device) pairs in one call and writes the results to out[0, count). Pairs are processed in
+   * vendor order, so every vendor is looked up only once.
+   */
+  void resolve(const PCIId* ids, size_t count, PCIResolved* out) const;
+  std::vector<PCIResolved> resolve(const std::vector<PCIId>& ids) const;
+
+  /**
+   * @param vendor_id hexadecimal vendor ID with or without "0x" prefix (e.g. "0x10de" as read from sysfs)
+   * @return the vendor or an invalid vendor (name "invalid") if the ID is unknown
+   */
+  PCIVendor vendor_from_id(const std::string& vendor_id) const;
+
+  PCIVendor operator[](const std::string& vendor_id) const;
 
-  const PCIVendor& operator[](const std::string& vendor_id) const;
+  PCIVendor vendor_from_id(uint16_t vendor_id) const;
+  PCIVendor operator[](uint16_t vendor_id) const;
 
  private:
-  std::map<std::string, PCIVendor> _vendors{};
-  PCIVendor _invalid_vendor{"0000", "invalid"};
+  friend struct PCIVendor;
+  static PCIVendor vendor_of(uint16_t vendor_id);
+  static PCIDevice device_of(const PCIVendor& vendor, uint16_t device_id);
 };
 
 struct PCI {
-  static PCIMapper getMapper();
+  /**
+   * @return the process wide mapper. It is initialized on first use (thread-safe) and never copied.
+   */
+  static const PCIMapper& getMapper();
+
+  /**
+   * Selects the database of all mappers instead of the tables embedded at build time (include/hwinfo/utils/pci.ids.h):
+   * a pci.ids file or a binary index written by `scripts/pci_builder.py --binary`. The file is memory-mapped and
+   * searched in place, only the pages of the vendors actually looked up are read. An empty path selects the first of
+   * /usr/share/hwdata/pci.ids, /usr/share/misc/pci.ids and /usr/share/pci.ids (below filesystem::root()).
+   *
+   * Without a call the HWINFO_PCI_IDS environment variable is used the same way, falling back to the embedded tables
+   * (or to the system files if hwinfo was built with HWINFO_PCI_EMBEDDED=OFF).
+   * @return false if the file could not be mapped or a lookup already selected the database
+   */
+  static bool useDatabase(const std::string& path = "");
+
+  /**
+   * @return "embedded", the path of the mapped database or "none"
+   */
+  static std::string databaseSource();
 };
 
 }  // namespace hwinfo
 
-#endif  // HWINFO_UNIX
\ No newline at end of file
+#endif  // HWINFO_UNIX
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hwinfo/platform.h"
+#include "hwinfo/utils/constants.h"
+
+namespace hwinfo {
+namespace utils {
+
+/**
+ * Read-only view of count elements in an Arena. Like the arena it is trivially copyable and never owns its elements.
+ */
+template <typename T>
+struct Span {
+  const T* data{nullptr};
+  size_t count{0};
+
+  HWI_NODISCARD const T* begin() const { return data; }
+  HWI_NODISCARD const T* end() const { return data + count; }
+  HWI_NODISCARD size_t size() const { return count; }
+  HWI_NODISCARD bool empty() const { return count == 0; }
+  const T& operator[](size_t i) const { return data[i]; }
+};
+
+/**
+ * Monotonic memory arena: allocations are carved out of a few large blocks and released all at once by clear() or
+ * the destructor, nothing is freed individually. Only trivially destructible objects may live in it.
+ *
+ * intern() deduplicates strings through an open addressing table of views into the arena, so repeated vendor names or
+ * constants::UNKNOWN are stored once. The empty string and constants::UNKNOWN are preset and point to static storage.
+ * The arena is not thread-safe.
+ */
+class Arena {
+ public:
+  explicit Arena(size_t block_size_Bytes = 16 * 1024) : _block_size(block_size_Bytes) {}
+  ~Arena() { release(); }
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  // blocks are moved, not copied: views into the arena stay valid
+  Arena(Arena&& other) noexcept { *this = std::move(other); }
+  Arena& operator=(Arena&& other) noexcept {
+    if (this != &other) {
+      release();
+      _block_size = other._block_size;
+      _blocks = std::exchange(other._blocks, nullptr);
+      _pos = std::exchange(other._pos, nullptr);
+      _end = std::exchange(other._end, nullptr);
+      _num_blocks = std::exchange(other._num_blocks, 0);
+      _used_Bytes = std::exchange(other._used_Bytes, 0);
+      _interned = std::move(other._interned);
+      _num_interned = std::exchange(other._num_interned, 0);
+      other._interned.clear();
+    }
+    return *this;
+  }
+
+  /**
+   * @return size bytes aligned to alignment (a power of two), valid until clear() or the destruction of the arena
+   */
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    auto pos = (reinterpret_cast<uintptr_t>(_pos) + alignment - 1) & ~(uintptr_t{alignment} - 1);
+    if (_pos == nullptr || pos + size > reinterpret_cast<uintptr_t>(_end)) {
+      // oversized requests get a block of their own
+      grow(size + alignment);
+      pos = (reinterpret_cast<uintptr_t>(_pos) + alignment - 1) & ~(uintptr_t{alignment} - 1);
+    }
+    _pos = reinterpret_cast<char*>(pos + size);
+    _used_Bytes += size;
+    return reinterpret_cast<void*>(pos);
+  }
+
+  // count default constructed elements
+  template <typename T>
+  T* allocateArray(size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+    if (count == 0) {
+      return nullptr;
+    }
+    T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    for (size_t i = 0; i < count; ++i) {
+      new (data + i) T();
+    }
+    return data;
+  }
+
+  // copies value into the arena
+  std::string_view copy(std::string_view value) {
+    if (value.empty()) {
+      return {};
+    }
+    char* data = static_cast<char*>(allocate(value.size(), 1));
+    std::memcpy(data, value.data(), value.size());
+    return {data, value.size()};
+  }
+
+  // copies value into the arena unless an equal string was interned before
+  std::string_view intern(std::string_view value) {
+    if (value.empty()) {
+      return {};
+    }
+    if (_interned.empty()) {
+      _interned.resize(256);
+      insert(constants::UNKNOWN);
+    }
+    if (2 * (_num_interned + 1) > _interned.size()) {
+      rehash(2 * _interned.size());
+    }
+    const size_t mask = _interned.size() - 1;
+    for (size_t i = hash(value) & mask;; i = (i + 1) & mask) {
+      if (_interned[i].data() == nullptr) {
+        _interned[i] = copy(value);
+        ++_num_interned;
+        return _interned[i];
+      }
+      if (_interned[i] == value) {
+        return _interned[i];
+      }
+    }
+  }
+
+  // releases all blocks, every view into the arena becomes invalid
+  void clear() {
+    release();
+    _interned.clear();
+    _num_interned = 0;
+  }
+
+  HWI_NODISCARD size_t numBlocks() const { return _num_blocks; }
+  // bytes handed out by allocate(), excluding alignment padding and unused block space
+  HWI_NODISCARD size_t used_Bytes() const { return _used_Bytes; }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  // FNV-1a
+  static size_t hash(std::string_view value) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char c : value) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+    }
+    return static_cast<size_t>(hash);
+  }
+
+  // adds a view that is known to be absent without copying it
+  void insert(std::string_view value) {
+    const size_t mask = _interned.size() - 1;
+    size_t i = hash(value) & mask;
+    while (_interned[i].data() != nullptr) i = (i + 1) & mask;
+    _interned[i] = value;
+    ++_num_interned;
+  }
+
+  void rehash(size_t size) {
+    std::vector<std::string_view> old(size);
+    old.swap(_interned);
+    _num_interned = 0;
+    for (const auto& value : old) {
+      if (value.data() != nullptr) {
+        insert(value);
+      }
+    }
+  }
+
+  void grow(size_t min_size) {
+    const size_t size = std::max(_block_size, min_size) + sizeof(Block);
+    auto* block = static_cast<Block*>(std::malloc(size));
+    if (block == nullptr) {
+      throw std::bad_alloc();
+    }
+    block->next = _blocks;
+    _blocks = block;
+    _pos = reinterpret_cast<char*>(block + 1);
+    _end = reinterpret_cast<char*>(block) + size;
+    ++_num_blocks;
+  }
+
+  void release() {
+    while (_blocks != nullptr) {
+      std::free(std::exchange(_blocks, _blocks->next));
+    }
+    _pos = nullptr;
+    _end = nullptr;
+    _num_blocks = 0;
+    _used_Bytes = 0;
+  }
+
+  size_t _block_size{16 * 1024};
+  Block* _blocks{nullptr};
+  char* _pos{nullptr};
+  char* _end{nullptr};
+  size_t _num_blocks{0};
+  size_t _used_Bytes{0};
+  // views into the arena (or static storage), empty slots have a null data pointer
+  std::vector<std::string_view> _interned;
+  size_t _num_interned{0};
+};
+
+}  // namespace utils
+}  // namespace hwinfo
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <cstdint>
+#include <string>
+
+namespace hwinfo {
+namespace cgroup {
+
+// cgroup v1 reports "no limit" as the largest page aligned 64 bit value
+constexpr int64_t v1_unlimited = int64_t{1} << 62;
+
+/**
+ * Directory of one controller in the cgroup of the calling process.
+ */
+struct Controller {
+  // 1 or 2, 0 if the controller is not mounted
+  int version{0};
+  // mount point of the hierarchy, e.g. /sys/fs/cgroup or /sys/fs/cgroup/memory
+  std::string mount_point;
+  // cgroup directory of the calling process below mount_point (equal to it for the root cgroup)
+  std::string path;
+
+  HWI_NODISCARD bool is_root() const { return path == mount_point; }
+};
+
+/**
+ * Locates the cgroup of the calling process for controller (e.g. "memory", "cpu", "cpuset") from /proc/self/cgroup and
+ * /proc/self/mountinfo. A controller that is attached to a v1 hierarchy is reported as v1 even if the unified
+ * hierarchy is mounted as well (hybrid setups); otherwise the cgroup2 directory is returned if the controller is
+ * enabled there.
+ */
+Controller find(const char* controller);
+
+/**
+ * Reads a single value cgroup file.
+ * @return the value, -1 for "max", the v1 "no limit" value or on failure
+ */
+int64_t readValue(const std::string& path);
+
+}  // namespace cgroup
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
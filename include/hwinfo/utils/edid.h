@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+namespace utils {
+namespace EDID {
+
+// One video timing. Pixel counts are per frame, also for interlaced modes.
+struct Timing {
+  int h_active{0};
+  int v_active{0};
+  int h_blank{0};
+  int v_blank{0};
+  int64_t pixel_clock_Hz{0};
+  bool interlaced{false};
+
+  HWI_NODISCARD bool valid() const { return h_active > 0 && v_active > 0; }
+  // rounded to the nearest millihertz, 0 if the pixel clock is unknown
+  HWI_NODISCARD int64_t refresh_rate_mHz() const;
+};
+
+/**
+ * Attributes of a display decoded from its EDID. Text fields are null terminated and empty if the display does not
+ * report them, numbers are 0 then.
+ */
+struct Info {
+  // PNP manufacturer id, e.g. "DEL"
+  char manufacturer[4]{};
+  uint16_t product_code{0};
+  uint32_t serial_number{0};
+  // monitor name and serial number descriptors (at most 13 characters in EDID, longer in DisplayID)
+  char name[32]{};
+  char serial_string[32]{};
+  int manufacture_year{0};
+  uint8_t version{0};
+  uint8_t revision{0};
+  int num_extensions{0};
+  // physical size of the active area; from the preferred timing, else from the screen size in cm
+  int width_mm{0};
+  int height_mm{0};
+  // first detailed timing of the base block (EDID 1.4: the native mode), else of a CTA-861 or DisplayID extension
+  Timing preferred;
+};
+
+/**
+ * Decodes an EDID 1.x base block and its CTA-861 and DisplayID (1.3 and 2.x) extension blocks in one pass, or a bare
+ * DisplayID section. Nothing is allocated. Truncated extensions and extension blocks with a wrong checksum
+ * are ignored.
+ * @return false if data does not start with an EDID header or a DisplayID section
+ */
+bool parse(const uint8_t* data, size_t size, Info& info);
+
+}  // namespace EDID
+}  // namespace utils
+}  // namespace hwinfo
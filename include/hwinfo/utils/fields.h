@@ -0,0 +1,39 @@
+#pragma once
+
+#include <type_traits>
+
+namespace hwinfo {
+
+/**
+ * Specialize for a scoped enum to enable the bitwise operators below, so that its values can be combined into field
+ * masks (e.g. DiskFields::Capacity | DiskFields::Free).
+ */
+template <typename E>
+struct enable_field_mask : std::false_type {};
+
+template <typename E, typename = std::enable_if_t<enable_field_mask<E>::value>>
+constexpr E operator|(E lhs, E rhs) {
+  using T = std::underlying_type_t<E>;
+  return static_cast<E>(static_cast<T>(lhs) | static_cast<T>(rhs));
+}
+
+template <typename E, typename = std::enable_if_t<enable_field_mask<E>::value>>
+constexpr E operator&(E lhs, E rhs) {
+  using T = std::underlying_type_t<E>;
+  return static_cast<E>(static_cast<T>(lhs) & static_cast<T>(rhs));
+}
+
+template <typename E, typename = std::enable_if_t<enable_field_mask<E>::value>>
+constexpr E& operator|=(E& lhs, E rhs) {
+  return lhs = lhs | rhs;
+}
+
+/**
+ * @return true if mask contains any bit of fields
+ */
+template <typename E, typename = std::enable_if_t<enable_field_mask<E>::value>>
+constexpr bool has_field(E mask, E fields) {
+  return static_cast<std::underlying_type_t<E>>(mask & fields) != 0;
+}
+
+}  // namespace hwinfo
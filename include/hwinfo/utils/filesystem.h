@@ -17,7 +17,31 @@ int64_t get_specs_by_file_path(const std::string& path);
 #endif  // HWINFO_UNIX || HWINFO_APPLE
 
 #if defined(HWINFO_UNIX)
+/**
+ * Directory prepended to every absolute path (/proc, /sys, /dev, /etc) read by the Linux backends. Empty, the
+ * default, reads the live system. Pointing it at a tree captured with scripts/capture_fixture.sh replays that machine,
+ * e.g. to benchmark the parsers for a 448 thread host on a laptop. The initial value is taken from the HWINFO_ROOT
+ * environment variable.
+ *
+ * Set the root before the first query: it is not synchronized, and samplers and cached readers keep the files they
+ * already opened.
+ */
+void setRoot(std::string root);
+const std::string& root();
+
+// root() + path for an absolute path
+std::string rooted(const std::string& path);
+std::string rooted(const char* path);
+
 Jiffies get_jiffies(int index);
+
+/**
+ * Reads /proc/stat once and parses all cpu lines. out[0] holds the aggregated counters, out[i + 1] those of logical
+ * CPU i. Offline CPUs keep default constructed Jiffies. The read buffer is reused between calls of the same thread.
+ * @return false if /proc/stat could not be read
+ */
+bool get_all_jiffies(std::vector<Jiffies>& out);
+std::vector<Jiffies> get_all_jiffies();
 #endif  // HWINFO_UNIX
 
 }  // namespace filesystem
@@ -0,0 +1,89 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#pragma once
+
+// Probes and counters behind hwinfo::stats(). All macros expand to nothing unless hwinfo is built with
+// HWINFO_INSTRUMENTATION, so they can stay in hot paths:
+//
+//   HWINFO_PROBE("disk.mountinfo");     times the enclosing scope as probe "disk.mountinfo"
+//   HWINFO_COUNT_OPEN();                one file or device opened
+//   HWINFO_COUNT_READ(bytes);           bytes read from a file (negative values are ignored)
+//   HWINFO_COUNT_SYSCALL();             any other system or COM call
+//
+// Counters are attributed to the innermost probe of the calling thread and dropped outside of any probe.
+
+#ifdef HWINFO_INSTRUMENTATION
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace hwinfo {
+namespace instrumentation {
+
+struct Probe {
+  const char* name;
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> wall_time_ns{0};
+  std::atomic<uint64_t> max_wall_time_ns{0};
+  std::atomic<uint64_t> syscalls{0};
+  std::atomic<uint64_t> file_opens{0};
+  std::atomic<uint64_t> read_Bytes{0};
+};
+
+// returns the probe registered for name, registering it on the first call. name must be a string literal.
+Probe& probe(const char* name);
+
+// innermost probe of the calling thread or nullptr
+Probe*& current();
+
+class Scope {
+ public:
+  explicit Scope(Probe& probe);
+  ~Scope();
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+ private:
+  Probe& _probe;
+  Probe* _parent;
+  std::chrono::steady_clock::time_point _start;
+};
+
+inline void count(std::atomic<uint64_t> Probe::*counter, uint64_t value) {
+  if (Probe* probe = current()) {
+    (probe->*counter).fetch_add(value, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace instrumentation
+}  // namespace hwinfo
+
+#define HWINFO_INSTRUMENTATION_CONCAT_(a, b) a##b
+#define HWINFO_INSTRUMENTATION_CONCAT(a, b) HWINFO_INSTRUMENTATION_CONCAT_(a, b)
+#define HWINFO_PROBE(name)                                                                                        \
+  static ::hwinfo::instrumentation::Probe& HWINFO_INSTRUMENTATION_CONCAT(hwinfo_probe_, __LINE__) =               \
+      ::hwinfo::instrumentation::probe(name);                                                                     \
+  const ::hwinfo::instrumentation::Scope HWINFO_INSTRUMENTATION_CONCAT(hwinfo_probe_scope_, __LINE__)(            \
+      HWINFO_INSTRUMENTATION_CONCAT(hwinfo_probe_, __LINE__))
+#define HWINFO_COUNT_OPEN() ::hwinfo::instrumentation::count(&::hwinfo::instrumentation::Probe::file_opens, 1)
+#define HWINFO_COUNT_SYSCALL() ::hwinfo::instrumentation::count(&::hwinfo::instrumentation::Probe::syscalls, 1)
+#define HWINFO_COUNT_READ(bytes)                                                                                  \
+  do {                                                                                                            \
+    const auto hwinfo_read_bytes = (bytes);                                                                       \
+    if (hwinfo_read_bytes > 0) {                                                                                  \
+      ::hwinfo::instrumentation::count(&::hwinfo::instrumentation::Probe::read_Bytes,                             \
+                                       static_cast<uint64_t>(hwinfo_read_bytes));                                 \
+    }                                                                                                             \
+  } while (false)
+
+#else
+
+#define HWINFO_PROBE(name) static_cast<void>(0)
+#define HWINFO_COUNT_OPEN() static_cast<void>(0)
+#define HWINFO_COUNT_SYSCALL() static_cast<void>(0)
+#define HWINFO_COUNT_READ(bytes) static_cast<void>(0)
+
+#endif  // HWINFO_INSTRUMENTATION
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+namespace utils {
+
+/**
+ * A value that is computed on first access and memoised, for attributes that need extra I/O (sysfs probes, statvfs,
+ * mount tables) while the object itself is cheap to enumerate. The first get() runs the computation under a mutex,
+ * concurrent callers wait for it and later calls are a single acquire load.
+ *
+ * Copies take the value if it was already computed, otherwise they compute their own on first access. The computation
+ * must not access the same Lazy.
+ */
+template <typename T>
+class Lazy {
+ public:
+  Lazy() = default;
+
+  Lazy(const Lazy& other) {
+    std::lock_guard<std::mutex> lock(other._mutex);
+    _value = other._value;
+    _ready.store(other._ready.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+
+  Lazy& operator=(const Lazy& other) {
+    if (this != &other) {
+      T copy;
+      bool ready;
+      {
+        std::lock_guard<std::mutex> lock(other._mutex);
+        copy = other._value;
+        ready = other._ready.load(std::memory_order_relaxed);
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      _value = std::move(copy);
+      _ready.store(ready, std::memory_order_release);
+    }
+    return *this;
+  }
+
+  // moved-from objects are not shared between threads, no locking needed
+  Lazy(Lazy&& other) noexcept
+      : _value(std::move(other._value)), _ready(other._ready.load(std::memory_order_relaxed)) {}
+
+  Lazy& operator=(Lazy&& other) noexcept {
+    if (this != &other) {
+      _value = std::move(other._value);
+      _ready.store(other._ready.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    return *this;
+  }
+
+  /**
+   * @return the value, computed by compute() (a callable returning T) if this is the first access
+   */
+  template <typename Compute>
+  const T& get(Compute&& compute) const {
+    if (!_ready.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_ready.load(std::memory_order_relaxed)) {
+        _value = compute();
+        _ready.store(true, std::memory_order_release);
+      }
+    }
+    return _value;
+  }
+
+  // mutable access for updates in place (e.g. refresh()), must not run concurrently with other accesses
+  template <typename Compute>
+  T& get(Compute&& compute) {
+    static_cast<const Lazy&>(*this).get(std::forward<Compute>(compute));
+    return _value;
+  }
+
+  // stores a value that was computed eagerly, get() returns it without computing
+  void set(T value) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _value = std::move(value);
+    _ready.store(true, std::memory_order_release);
+  }
+
+  HWI_NODISCARD bool ready() const { return _ready.load(std::memory_order_acquire); }
+
+ private:
+  mutable T _value{};
+  mutable std::atomic<bool> _ready{false};
+  mutable std::mutex _mutex;
+};
+
+}  // namespace utils
+}  // namespace hwinfo
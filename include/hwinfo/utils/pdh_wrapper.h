@@ -0,0 +1,86 @@
+#pragma once
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_WINDOWS
+
+#include <Pdh.h>
+
+#include <cstdint>
+#include <vector>
+#pragma comment(lib, "pdh.lib")
+
+namespace hwinfo {
+namespace utils {
+namespace PDH {
+
+/**
+ * Performance counters of all logical processors ("\Processor Information(*)\..."), opened once per thread and
+ * collected with a single PdhCollectQueryData call. Reading them costs microseconds instead of a WMI round trip.
+ *
+ * Performance is a rate counter: every collect() yields the values since the previous collect(). The utilisation is
+ * not read from PDH, CpuSampler::snapshot() gets the processor times of all CPUs with one system call per group.
+ */
+class ProcessorCounters {
+ public:
+  ~ProcessorCounters();
+  ProcessorCounters(const ProcessorCounters&) = delete;
+  ProcessorCounters& operator=(const ProcessorCounters&) = delete;
+
+  /**
+   * @return the counters of the calling thread or nullptr if PDH is not available
+   */
+  static ProcessorCounters* get();
+
+  /**
+   * Samples all counters.
+   * @return false if the sample could not be taken
+   */
+  bool collect();
+
+  /**
+   * Current performance relative to the nominal frequency ("% Processor Performance") / 100 per logical processor,
+   * indexed group * 64 + number like the CPUs of getCpuTopology().
+   */
+  bool performance(std::vector<double>& per_thread) const;
+
+ private:
+  ProcessorCounters() = default;
+  bool open();
+
+  PDH_HQUERY _query = nullptr;
+  PDH_HCOUNTER _performance = nullptr;
+};
+
+/**
+ * Package energy from the "Energy Meter" performance counters, which Windows 10 and later publish for platforms with
+ * an energy meter interface (RAPL on Intel and AMD): one instance "RAPL_Package<N>_PKG" per package. The cumulative
+ * Energy counter is reported in picowatt-hours. Without the meter (most virtual machines, older Windows) no package is
+ * found.
+ */
+class EnergyMeter {
+ public:
+  EnergyMeter();
+  ~EnergyMeter();
+  EnergyMeter(const EnergyMeter&) = delete;
+  EnergyMeter& operator=(const EnergyMeter&) = delete;
+
+  // false if PDH or the Energy Meter counter set is not available
+  HWI_NODISCARD bool valid() const { return _query != nullptr; }
+
+  /**
+   * Samples the counters and stores the energy of package N in energy_uJ[N] (-1 for packages without a meter).
+   * @return false if the sample could not be taken
+   */
+  bool collect(std::vector<int64_t>& energy_uJ);
+
+ private:
+  PDH_HQUERY _query = nullptr;
+  PDH_HCOUNTER _energy = nullptr;
+};
+
+}  // namespace PDH
+}  // namespace utils
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+namespace utils {
+
+/**
+ * Bounded lock-free multi-producer multi-consumer queue (D. Vyukov's algorithm): every cell carries a sequence number
+ * that tells producers and consumers whether it is free or filled, so push() and pop() are a CAS on the head or tail
+ * plus a copy of the element. The capacity is rounded up to a power of two and allocated once.
+ *
+ * push() fails instead of overwriting when the queue is full, elements must be trivially copyable.
+ */
+template <typename T>
+class RingBuffer {
+  static_assert(std::is_trivially_copyable<T>::value, "RingBuffer elements are copied without synchronization");
+
+ public:
+  explicit RingBuffer(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    _mask = size - 1;
+    _cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  /**
+   * @return false if the queue is full
+   */
+  bool push(const T& value) {
+    size_t position = _tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = _cells[position & _mask];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+      if (diff == 0) {
+        if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = _tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @return false if the queue is empty
+   */
+  bool pop(T& out) {
+    size_t position = _head.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = _cells[position & _mask];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+      if (diff == 0) {
+        if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          out = cell.value;
+          cell.sequence.store(position + _mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = _head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  HWI_NODISCARD size_t capacity() const { return _mask + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> _cells;
+  size_t _mask{0};
+  // producers and consumers work on different cache lines
+  alignas(64) std::atomic<size_t> _tail{0};
+  alignas(64) std::atomic<size_t> _head{0};
+};
+
+}  // namespace utils
+}  // namespace hwinfo
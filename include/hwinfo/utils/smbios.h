@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hwinfo/platform.h"
+
+namespace hwinfo {
+namespace utils {
+namespace SMBIOS {
+
+// SMBIOS type 17 structure, one per memory slot
+struct MemoryDevice {
+  // slot label, e.g. "DIMM_A1"
+  std::string locator;
+  std::string bank_locator;
+  std::string manufacturer;
+  std::string serial_number;
+  std::string part_number;
+  // 0 for empty slots, -1 if unknown
+  int64_t size_Bytes{-1};
+  // maximum and configured transfer rate in MT/s, -1 if unknown
+  int64_t speed_MTs{-1};
+  int64_t configured_speed_MTs{-1};
+};
+
+// SMBIOS type 4 structure, one per processor socket
+struct Processor {
+  std::string socket;
+  std::string manufacturer;
+  std::string version;
+  int64_t max_speed_MHz{-1};
+  int64_t current_speed_MHz{-1};
+  int num_cores{-1};
+  int num_threads{-1};
+  bool populated{false};
+};
+
+// SMBIOS type 2 structure
+struct Baseboard {
+  std::string manufacturer;
+  std::string product;
+  std::string version;
+  std::string serial_number;
+};
+
+struct Tables {
+  std::vector<MemoryDevice> memory_devices;
+  std::vector<Processor> processors;
+  std::vector<Baseboard> baseboards;
+};
+
+/**
+ * Parses the memory device, processor and baseboard structures of a raw SMBIOS structure table in one pass. Strings
+ * that are not set are constants::UNKNOWN.
+ */
+Tables parse(const uint8_t* data, size_t size);
+
+/**
+ * The tables of this machine. The raw table (Linux: /sys/firmware/dmi/tables/DMI, Windows:
+ * GetSystemFirmwareTable('RSMB')) is read and parsed once per process (thread-safe). All vectors are empty if the table
+ * is not available, e.g. on Linux without root privileges or on macOS.
+ */
+const Tables& tables();
+
+/**
+ * Reads the raw structure table (without entry point or RawSMBIOSData header). Implemented per platform.
+ * @return an empty buffer if the table is not available
+ */
+std::vector<uint8_t> read_table();
+
+}  // namespace SMBIOS
+}  // namespace utils
+}  // namespace hwinfo
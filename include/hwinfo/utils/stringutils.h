@@ -4,16 +4,24 @@
 #pragma once
 
 #include <algorithm>
-#include <clocale>
+#include <charconv>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+#include "hwinfo/platform.h"
+
 namespace hwinfo {
 namespace utils {
 
+// The allocating helpers are defined in src/stringutils.cpp, which every component compiles, so that includers only
+// parse their declarations.
+
 /**
  * Replaces an occurence once in the entire string. Stops at first match
  *
@@ -21,15 +29,7 @@ namespace utils {
  * @param from The token to match
  * @param to The token to use as a replace with matched ones
  */
-inline bool replaceOnce(std::string& input, const std::string& from, const std::string& to) {
-  size_t start_pos = input.find(from);
-
-  if (start_pos == std::string::npos) return false;
-
-  input.replace(start_pos, from.length(), to);
-
-  return true;
-}
+bool replaceOnce(std::string& input, const std::string& from, const std::string& to);
 
 /**
  * Replaces all occurences in the entire string.
@@ -38,50 +38,14 @@ inline bool replaceOnce(std::string& input, const std::string& from, const std::
  * @param from The token to match
  * @param to The token to use as a replace with matched ones
  */
-inline void replaceAll(std::string& input, const char from, const char to) {
-  std::replace(input.begin(), input.end(), from, to);
-}
+void replaceAll(std::string& input, const char from, const char to);
 
 /**
  * remove all white spaces (' ', '\t', '\n') from start and end of input
  * inplace!
  * @param input
  */
-inline void strip(std::string& input) {
-  if (input.empty()) {
-    return;
-  }
-  // optimization for input size == 1
-  if (input.size() == 1) {
-    if (input[0] == ' ' || input[0] == '\t' || input[0] == '\n') {
-      input = "";
-      return;
-    } else {
-      return;
-    }
-  }
-  size_t start_index = 0;
-  while (true) {
-    char c = input[start_index];
-    if (c != ' ' && c != '\t' && c != '\n') {
-      break;
-    }
-    start_index++;
-  }
-  size_t end_index = input.size() - 1;
-  while (true) {
-    char c = input[end_index];
-    if (c != ' ' && c != '\t' && c != '\n') {
-      break;
-    }
-    end_index--;
-  }
-  if (end_index < start_index) {
-    input.assign("");
-    return;
-  }
-  input.assign(input.begin() + start_index, input.begin() + end_index + 1);
-}
+void strip(std::string& input);
 
 /**
  * Count occurrences of a substring in input
@@ -89,15 +53,7 @@ inline void strip(std::string& input) {
  * @param substring
  * @return
  */
-inline unsigned count_substring(const std::string& input, const std::string& substring) {
-  unsigned occurrences = 0;
-  std::string::size_type shift = 0;
-  while ((shift = input.find(substring, shift)) != std::string::npos) {
-    occurrences++;
-    shift += substring.size();
-  }
-  return occurrences;
-}
+unsigned count_substring(const std::string& input, const std::string& substring);
 
 /**
  * Split input string at delimiter and return result
@@ -105,19 +61,7 @@ inline unsigned count_substring(const std::string& input, const std::string& sub
  * @param delimiter
  * @return
  */
-inline std::vector<std::string> split(const std::string& input, const std::string& delimiter) {
-  std::vector<std::string> result;
-  size_t shift = 0;
-  while (true) {
-    size_t match = input.find(delimiter, shift);
-    result.emplace_back(input.substr(shift, match - shift));
-    if (match == std::string::npos) {
-      break;
-    }
-    shift = match + delimiter.size();
-  }
-  return result;
-}
+std::vector<std::string> split(const std::string& input, const std::string& delimiter);
 
 /**
  * Split input string at delimiter (char) and return result
@@ -125,19 +69,7 @@ inline std::vector<std::string> split(const std::string& input, const std::strin
  * @param delimiter
  * @return
  */
-inline std::vector<std::string> split(const std::string& input, const char delimiter) {
-  std::vector<std::string> result;
-  size_t shift = 0;
-  while (true) {
-    size_t match = input.find(delimiter, shift);
-    if (match == std::string::npos) {
-      break;
-    }
-    result.emplace_back(input.substr(shift, match - shift));
-    shift = match + 1;
-  }
-  return result;
-}
+std::vector<std::string> split(const std::string& input, const char delimiter);
 
 /**
  * split input at delimiter and return substring at position index.
@@ -147,68 +79,34 @@ inline std::vector<std::string> split(const std::string& input, const char delim
  * @param index
  * @return
  */
-inline std::string split_get_index(const std::string& input, const std::string& delimiter, int index) {
-  unsigned occ = count_substring(input, delimiter) + 1;
-  index = index < 0 ? static_cast<int>(occ + index) : index;
-  if (static_cast<int>(occ) <= index) {
-    return "";
-  }
+std::string split_get_index(const std::string& input, const std::string& delimiter, int index);
 
-  std::string::size_type start_index = 0;
-  while (true) {
-    if (index == 0) {
-      break;
-    }
-    start_index = input.find(delimiter, start_index) + delimiter.size();
-    index--;
-  }
-  std::string::size_type end_index = input.find(delimiter, start_index);
-  if (end_index == std::string::npos) {
-    return {input.begin() + static_cast<int64_t>(start_index), input.end()};
-  }
-  return {input.begin() + static_cast<int64_t>(start_index), input.begin() + static_cast<int64_t>(end_index)};
-}
+/**
+ * Parse a Linux cpu list like "0-3,8,10-11" (sysfs cpulist, cpuset and online files). Parsing stops at the first
+ * malformed entry.
+ * @param list
+ * @return the listed cpus in the order of the list
+ */
+std::vector<int> parseCpuList(std::string_view list);
+
+/**
+ * Formats value so that it parses back to the same double, always with '.' as decimal point: unlike snprintf() the
+ * result does not depend on the LC_NUMERIC locale of the host application (JSON and OpenMetrics must not get "1,5").
+ * @return number of characters written to buffer (not null terminated), 0 if size is too small
+ */
+size_t formatDouble(double value, char* buffer, size_t size);
 
 /**
  * Convert windows wstring to string
  * @return
  */
-inline std::string wstring_to_string() { return ""; }
+std::string wstring_to_string();
 
 /**
  * Convert wstring to string
  * @return
  */
-inline std::string wstring_to_std_string(const std::wstring& ws) {
-  std::string str_locale = std::setlocale(LC_ALL, "");
-  const wchar_t* wch_src = ws.c_str();
-
-#ifdef _MSC_VER
-  size_t n_dest_size;
-  wcstombs_s(&n_dest_size, nullptr, 0, wch_src, 0);
-  n_dest_size++;  // Increase by one for null terminator
-
-  char* ch_dest = new char[n_dest_size];
-  memset(ch_dest, 0, n_dest_size);
-
-  size_t n_convert_size;
-  wcstombs_s(&n_convert_size, ch_dest, n_dest_size, wch_src,
-             n_dest_size - 1);  // subtract one to ignore null terminator
-
-  std::string result_text = ch_dest;
-  delete[] ch_dest;
-#else
-  size_t n_dest_size = std::wcstombs(NULL, wch_src, 0) + 1;
-  char* ch_dest = new char[n_dest_size];
-  std::memset(ch_dest, 0, n_dest_size);
-  std::wcstombs(ch_dest, wch_src, n_dest_size);
-  std::string result_text = ch_dest;
-  delete[] ch_dest;
-#endif
-
-  std::setlocale(LC_ALL, str_locale.c_str());
-  return result_text;
-}
+std::string wstring_to_std_string(const std::wstring& ws);
 
 /**
  * Replace the std::string::starts_with function only available in C++20 and above.
@@ -225,5 +123,160 @@ inline bool starts_with(const string_type& str, const prefix_type& prefix) {
 #endif
 }
 
+// === Non-allocating parsing ==========================================================================================
+//
+// The helpers below work on std::string_view and std::from_chars: they neither allocate nor throw, malformed or out of
+// range input yields an empty std::optional. Use them instead of std::stoll() and string streams in code that runs
+// while polling.
+
+/**
+ * @return value without leading and trailing characters (spaces, tabs, carriage returns and newlines by default)
+ */
+inline std::string_view trim(std::string_view value, std::string_view characters = " \t\r\n") {
+  const size_t first = value.find_first_not_of(characters);
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  return value.substr(first, value.find_last_not_of(characters) - first + 1);
+}
+
+/**
+ * Parses the integer at the start of input (after spaces and tabs) and removes it from input. A "0x" prefix is
+ * accepted for base 16, a leading '+' for every base.
+ * @return no value if input does not start with a number of type T, input is unchanged then
+ */
+template <typename T>
+std::optional<T> consumeNumber(std::string_view& input, int base = 10) {
+  static_assert(std::is_integral<T>::value, "consumeNumber() parses integers, see toDouble()");
+  std::string_view rest = input.substr(std::min(input.find_first_not_of(" \t"), input.size()));
+  if (!rest.empty() && rest.front() == '+') {
+    rest.remove_prefix(1);
+  }
+  if (base == 16 && rest.size() > 2 && rest[0] == '0' && (rest[1] == 'x' || rest[1] == 'X')) {
+    rest.remove_prefix(2);
+  }
+  T value{};
+  const auto result = std::from_chars(rest.data(), rest.data() + rest.size(), value, base);
+  if (result.ec != std::errc()) {
+    return std::nullopt;
+  }
+  input.remove_prefix(static_cast<size_t>(result.ptr - input.data()));
+  return value;
+}
+
+/**
+ * Parses value as a whole (surrounding whitespace is ignored), e.g. the content of a sysfs attribute.
+ * @return no value if value is not exactly one number of type T
+ */
+template <typename T>
+std::optional<T> toNumber(std::string_view value, int base = 10) {
+  value = trim(value);
+  const auto number = consumeNumber<T>(value, base);
+  if (!number || !value.empty()) {
+    return std::nullopt;
+  }
+  return number;
+}
+
+/**
+ * Floating point counterpart of toNumber(). std::from_chars for double is missing in older standard libraries (e.g.
+ * of Apple clang), the value is copied to a stack buffer and parsed with strtod() instead.
+ */
+inline std::optional<double> toDouble(std::string_view value) {
+  value = trim(value);
+  char buffer[64];
+  if (value.empty() || value.size() >= sizeof(buffer)) {
+    return std::nullopt;
+  }
+  std::memcpy(buffer, value.data(), value.size());
+  buffer[value.size()] = '\0';
+  char* end = nullptr;
+  const double result = std::strtod(buffer, &end);
+  if (end != buffer + value.size()) {
+    return std::nullopt;
+  }
+  return result;
+}
+
+/**
+ * Removes prefix from input if input starts with it.
+ */
+inline bool consumePrefix(std::string_view& input, std::string_view prefix) {
+  if (input.substr(0, prefix.size()) != prefix) {
+    return false;
+  }
+  input.remove_prefix(prefix.size());
+  return true;
+}
+
+/**
+ * Removes the first line (without its newline) from input and stores it in line.
+ * @return false if input is empty
+ */
+inline bool nextLine(std::string_view& input, std::string_view& line) {
+  if (input.empty()) {
+    return false;
+  }
+  const size_t newline = input.find('\n');
+  line = input.substr(0, newline);
+  input.remove_prefix(newline == std::string_view::npos ? input.size() : newline + 1);
+  return true;
+}
+
+/**
+ * Splits a string_view into tokens without copying. Runs of delimiters count as one and leading delimiters are
+ * skipped, like whitespace separated columns of /proc files:
+ *
+ *   Tokenizer columns("   8       0 sda 1234 ...");
+ *   std::string_view token;
+ *   while (columns.next(token)) { ... }
+ */
+class Tokenizer {
+ public:
+  explicit Tokenizer(std::string_view input, std::string_view delimiters = " \t\r\n")
+      : _input(input), _delimiters(delimiters) {}
+
+  // the next token, false if there is none left
+  bool next(std::string_view& token) {
+    const size_t first = _input.find_first_not_of(_delimiters);
+    if (first == std::string_view::npos) {
+      _input = {};
+      return false;
+    }
+    const size_t last = _input.find_first_of(_delimiters, first);
+    token = _input.substr(first, last == std::string_view::npos ? std::string_view::npos : last - first);
+    _input.remove_prefix(last == std::string_view::npos ? _input.size() : last);
+    return true;
+  }
+
+  // skips count tokens, false if there were fewer
+  bool skip(size_t count) {
+    std::string_view token;
+    for (size_t i = 0; i < count; ++i) {
+      if (!next(token)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // parses the next token as a number of type T, no value if there is no token or it is not a number
+  template <typename T>
+  std::optional<T> nextNumber(int base = 10) {
+    std::string_view token;
+    if (!next(token)) {
+      return std::nullopt;
+    }
+    return toNumber<T>(token, base);
+  }
+
+  // the unprocessed remainder of the input
+  HWI_NODISCARD std::string_view rest() const { return _input; }
+
+ private:
+  std::string_view _input;
+  std::string_view _delimiters;
+};
+
 }  // namespace utils
 }  // namespace hwinfo
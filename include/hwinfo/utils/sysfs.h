@@ -0,0 +1,78 @@
+#pragma once
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+
+namespace hwinfo {
+namespace filesystem {
+
+/**
+ * Keeps a sysfs/procfs attribute file open and rereads it with pread(fd, buf, 0) into a stack buffer. The file is
+ * opened lazily on the first read and reopened only if a read fails with ENODEV (e.g. the device was re-plugged).
+ * Copies share the path but open their own descriptor, moves transfer the descriptor.
+ *
+ * A SysfsReader is not synchronized, use one instance per thread.
+ */
+class SysfsReader {
+ public:
+  SysfsReader() = default;
+  explicit SysfsReader(std::string path);
+  ~SysfsReader();
+
+  SysfsReader(const SysfsReader& other);
+  SysfsReader(SysfsReader&& other) noexcept;
+  SysfsReader& operator=(const SysfsReader& other);
+  SysfsReader& operator=(SysfsReader&& other) noexcept;
+
+  /**
+   * Reads the first line of the attribute (without the trailing newline) into out.
+   * @return false if the file could not be opened or read
+   */
+  bool read(std::string& out);
+
+  /**
+   * Reads the attribute as a decimal integer.
+   * @return the parsed value or -1 on failure
+   */
+  int64_t readInt();
+
+  /**
+   * Reads the whole attribute (e.g. a multi-line uevent file) into buffer. The content is not null terminated.
+   * @return the number of bytes read or -1 on failure
+   */
+  int64_t read(char* buffer, size_t size) { return readRaw(buffer, size); }
+
+  HWI_NODISCARD const std::string& path() const { return _path; }
+
+ private:
+  // reads the whole attribute into buffer and returns the number of bytes read or -1
+  int64_t readRaw(char* buffer, size_t size);
+  void close();
+
+  std::string _path;
+  int _fd{-1};
+};
+
+/**
+ * Reads the attribute name relative to the directory dir_fd (openat) into buffer. The content is null terminated and
+ * trailing newlines are removed. Use this to read several attributes of one device without building a path per file.
+ * @return the length of the content or -1 if the attribute does not exist or could not be read
+ */
+ssize_t readAttributeAt(int dir_fd, const char* name, char* buffer, size_t size);
+
+/**
+ * Like readAttributeAt() but parses the content as integer in the given base ("0x" prefixes are accepted for 16).
+ * @return the parsed value or fallback on failure
+ */
+int64_t readIntAttributeAt(int dir_fd, const char* name, int base, int64_t fallback = -1);
+
+}  // namespace filesystem
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
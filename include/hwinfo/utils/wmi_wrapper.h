@@ -7,8 +7,13 @@
 #include <WbemIdl.h>
 #include <comdef.h>
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <string>
+#include <variant>
 #include <vector>
 #pragma comment(lib, "wbemuuid.lib")
 
@@ -17,16 +22,128 @@ namespace hwinfo {
 namespace utils {
 namespace WMI {
 
+/**
+ * Namespace of the Win32_ classes. Some hardware classes live in others, e.g. MSAcpi_ThermalZoneTemperature in
+ * ROOT\WMI.
+ */
+constexpr const wchar_t* default_namespace = L"ROOT\\CIMV2";
+
+/**
+ * Per-thread connections to WMI namespaces (ROOT\CIMV2 unless stated otherwise). COM initialization,
+ * CoCreateInstance(CLSID_WbemLocator) and ConnectServer are expensive, so every thread connects once per namespace and
+ * reuses the connection for all following queries. A broken connection (e.g. the WMI service was restarted) is dropped
+ * via reset() and reestablished on the next use.
+ */
+class Session {
+ public:
+  ~Session();
+  Session(const Session&) = delete;
+  Session& operator=(const Session&) = delete;
+
+  /**
+   * @return the session of the calling thread
+   */
+  static Session& get();
+
+  /**
+   * @return the connected service of the namespace or nullptr if no connection could be established
+   */
+  IWbemServices* service(const wchar_t* name_space = default_namespace);
+
+  /**
+   * Drops all connections, the next call to service() reconnects.
+   */
+  void reset();
+
+ private:
+  struct Connection {
+    std::wstring name_space;
+    IWbemServices* service;
+  };
+
+  Session();
+  IWbemServices* connect(const wchar_t* name_space);
+
+  bool _com_initialized = false;
+  IWbemLocator* _locator = nullptr;
+  // usually one or two namespaces, searched linearly
+  std::vector<Connection> _connections;
+};
+
+/**
+ * @return true if hr indicates a broken connection to the WMI service (RPC failures) rather than a failing query
+ */
+bool is_connection_error(HRESULT hr);
+
+/**
+ * A single query on the pooled Session of the calling thread. Destroying a _WMI releases its enumerator only, the
+ * connection stays open.
+ */
 struct _WMI {
-  _WMI();
+  explicit _WMI(const wchar_t* name_space = default_namespace);
   ~_WMI();
   bool execute_query(const std::wstring& query);
 
-  IWbemLocator* locator = nullptr;
+  const wchar_t* name_space;
   IWbemServices* service = nullptr;
   IEnumWbemClassObject* enumerator = nullptr;
 };
 
+/**
+ * A single property value of a row returned by query_rows(). std::monostate represents NULL and unsupported types.
+ * Note that WMI returns 64 bit integers (uint64/sint64) as strings, use as_int64() to read them.
+ */
+using Value = std::variant<std::monostate, bool, int64_t, uint64_t, double, std::string>;
+// values in the order of the requested fields
+using Row = std::vector<Value>;
+
+/**
+ * Selects all fields of wmi_class in a single query and returns one Row per object. Objects are pulled from the
+ * enumerator in batches.
+ */
+std::vector<Row> query_rows(const std::wstring& wmi_class, const std::vector<std::wstring>& fields,
+                            const std::wstring& filter = L"", const wchar_t* name_space = default_namespace);
+
+/**
+ * Default per-query timeout of the asynchronous queries.
+ */
+constexpr std::chrono::milliseconds default_query_timeout{10000};
+
+/**
+ * Called once an asynchronous query finished. complete is false if the query failed or ran into its timeout, rows then
+ * contains the objects delivered until then.
+ */
+using RowsCallback = std::function<void(std::vector<Row> rows, bool complete)>;
+
+/**
+ * Like query_rows() but runs the query with IWbemServices::ExecQueryAsync on the one long-lived worker thread of the
+ * process, which owns a pooled Session. The worker issues all queued queries at once, so independent queries (e.g. the
+ * inventory sections of a snapshot) run concurrently over one connection, and a slow provider can neither block the
+ * caller nor other queries. The query is cancelled after timeout.
+ */
+std::future<std::vector<Row>> query_rows_async(const std::wstring& wmi_class, const std::vector<std::wstring>& fields,
+                                               const std::wstring& filter = L"",
+                                               std::chrono::milliseconds timeout = default_query_timeout);
+
+/**
+ * Callback variant of query_rows_async(). callback is invoked on the worker thread: it delays the other queries while
+ * it runs and must not wait for another asynchronous query.
+ */
+void query_rows_async(const std::wstring& wmi_class, const std::vector<std::wstring>& fields,
+                      const std::wstring& filter, std::chrono::milliseconds timeout, RowsCallback callback);
+
+/**
+ * Cancels the running asynchronous queries and joins the worker thread, e.g. before the host application uninitializes
+ * COM or unloads the library. The callbacks of cancelled and queued queries report incomplete results. The next
+ * asynchronous query starts a new worker. Called at exit as well.
+ */
+void shutdown_async_queries();
+
+std::string as_string(const Value& value, const std::string& fallback = "");
+int64_t as_int64(const Value& value, int64_t fallback = -1);
+double as_double(const Value& value, double fallback = -1.0);
+bool as_bool(const Value& value, bool fallback = false);
+
 template <typename T>
 std::vector<T> query(const std::wstring& wmi_class, const std::wstring& field, const std::wstring& filter = L"");
 
@@ -0,0 +1,78 @@
+#!/usr/bin/env bash
+# Captures the procfs/sysfs files read by the Linux backends of hwinfo into a directory that can be replayed with
+# HWINFO_ROOT=<dir> (or hwinfo::filesystem::setRoot()), e.g. to benchmark the parsers for a large host elsewhere:
+#
+#   scripts/capture_fixture.sh /tmp/host-448
+#   tar -C /tmp -czf host-448.tar.gz host-448
+#   HWINFO_ROOT=/tmp/host-448 build/bin/hwinfo_bench
+#
+# sysfs symlinks are relative and kept, so the fixture can be moved and checked in. Not part of a fixture and always
+# read from the live system: rtnetlink (network interfaces), DRM ioctls (monitors), statvfs (free disk space), CPU
+# affinity, sysconf() and cpuid.
+# Run as root to include /sys/firmware/dmi/tables and the serial numbers of /sys/class/dmi.
+set -euo pipefail
+
+if [ $# -ne 1 ]; then
+    echo "Usage: $(basename "$0") <output directory>" >&2
+    exit 1
+fi
+OUT="$1"
+mkdir -p "$OUT"
+
+# copy_file <path>: copies the content of one pseudo file (their st_size is meaningless, so cp cannot be used)
+copy_file() {
+    local src="$1"
+    [ -f "$src" ] && [ -r "$src" ] || return 0
+    mkdir -p "$OUT$(dirname "$src")"
+    head -c 1048576 "$src" > "$OUT$src" 2>/dev/null || rm -f "$OUT$src"
+}
+
+# mirror <path> <depth>: copies path into the fixture, descending depth directory levels. sysfs symlinks are relative
+# and kept as they are, their targets are mirrored as well so that realpath() and readlink() behave like on the host.
+mirror() {
+    local src="$1" depth="$2"
+    if [ -L "$src" ]; then
+        if [ ! -L "$OUT$src" ]; then
+            mkdir -p "$OUT$(dirname "$src")"
+            ln -s "$(readlink "$src")" "$OUT$src"
+        fi
+        case "$(basename "$src")" in
+            # back links into the device tree would duplicate (or loop through) large parts of /sys
+            subsystem|driver|firmware_node|of_node|iommu|iommu_group|module) return 0 ;;
+        esac
+        mirror "$(readlink -f "$src")" "$depth"
+    elif [ -d "$src" ]; then
+        [ "$depth" -gt 0 ] || return 0
+        mkdir -p "$OUT$src"
+        local entry
+        for entry in "$src"/*; do
+            case "$(basename "$entry")" in
+                power|msi_irqs|holders|slaves|queues|trace|uevent|"*") continue ;;
+            esac
+            mirror "$entry" $((depth - 1))
+        done
+    else
+        copy_file "$src"
+    fi
+}
+
+for file in /proc/stat /proc/cpuinfo /proc/meminfo /proc/diskstats /proc/self/cgroup /proc/self/mountinfo \
+            /proc/pressure/memory /etc/os-release /sys/firmware/dmi/tables/DMI; do
+    copy_file "$file"
+done
+
+mirror /sys/devices/system/cpu 4
+mirror /sys/devices/system/node 2
+mirror /sys/bus/pci/devices 2
+mirror /sys/class/block 3
+mirror /sys/class/net 2
+mirror /sys/class/drm 3
+mirror /sys/class/hwmon 2
+mirror /sys/class/thermal 2
+mirror /sys/class/powercap 2
+mirror /sys/class/power_supply 2
+mirror /sys/devices/virtual/dmi 2
+mirror /sys/class/dmi 2
+mirror /sys/fs/cgroup 2
+
+echo "captured $(find "$OUT" -type f | wc -l) files into $OUT"
@@ -4,29 +4,40 @@ Author: Leon Freist <freist.leon@gmail.com>
 
 This script is used to build a compile time PCI ID mapper in C++.
 We use the pci.ids file (https://pci-ids.ucw.cz/v2.2/pci.ids) licenced under BSD3.
+
+The generated source (src/pci.ids.cpp) defines the tables declared in include/hwinfo/utils/pci.ids.h: sorted tables
+keyed by the numeric IDs and a single string pool. Table entries reference names by (offset, length) into the pool, so
+the data needs no relocations and lookups are binary searches without any startup cost.
+
+With --binary the same tables are written as a little endian binary index instead, which PCIMapper memory-maps at
+runtime (hwinfo::PCI::useDatabase() or HWINFO_PCI_IDS=<path>): a 32 byte header ("HWPCIIDX", format version,
+number of vendors, devices and subsystems, pool size, reserved), the vendor, device and subsystem tables and the pool.
+
+Usage: python3 scripts/pci_builder.py [--binary] [path/to/pci.ids] [path/to/output]
 """
 
+import os
+import struct
 import sys
 from dataclasses import dataclass, field
-from typing import Generator, Optional
-from collections import OrderedDict
+from typing import Dict, Generator, List, Optional, Tuple
 
 
 @dataclass
 class PCIDevice:
-    id: str = field(default_factory=str)
+    id: int = 0
     name: str = field(default_factory=str)
-    subsystems: OrderedDict[str, str] = field(default_factory=OrderedDict)
+    subsystems: Dict[Tuple[int, int], str] = field(default_factory=dict)
 
     def __repr__(self):
-        return f"{'{'}{self.id}, {self.name}"
+        return f"{'{'}{self.id:04x}, {self.name}{'}'}"
 
 
 @dataclass
 class PCIVendor:
-    id: str = field(default_factory=str)
+    id: int = 0
     name: str = field(default_factory=str)
-    devices: OrderedDict[str, PCIDevice] = field(default_factory=OrderedDict)
+    devices: Dict[int, PCIDevice] = field(default_factory=dict)
 
 
 class PCIParser:
@@ -36,45 +47,212 @@ class PCIParser:
 
     def parse(self) -> Generator[PCIVendor, None, None]:
         last_vendor: Optional[PCIVendor] = None
-        last_device_id: str = ""
+        last_device: Optional[PCIDevice] = None
+        in_class_section = False
         for line in self.read_lines():
+            if line.startswith("C "):
+                # device classes are listed after all vendors: "C xx  name" followed by indented subclasses
+                in_class_section = True
+                continue
+            if in_class_section and line.startswith('\t'):
+                continue
+            in_class_section = False
             processed_line = line.strip()
             _id, _info = processed_line.split("  ", maxsplit=1)
             if line.startswith('\t'):
                 # device or subsystem
                 if line.startswith("\t\t"):
-                    # subsystem
-                    last_vendor.devices[last_device_id].subsystems[_id] = _info
+                    # subsystem: "subvendor subdevice  name"
+                    if last_device is None:
+                        continue
+                    subvendor, subdevice = _id.split(" ")
+                    last_device.subsystems.setdefault((int(subvendor, 16), int(subdevice, 16)), _info)
                 else:
                     # device
-                    last_vendor.devices[_id] = PCIDevice(_id, _info)
-                    last_device_id = _id
+                    if last_vendor is None:
+                        continue
+                    last_device = last_vendor.devices.setdefault(int(_id, 16), PCIDevice(int(_id, 16), _info))
             else:
                 if last_vendor:
                     yield last_vendor
                 # vendor
-                last_vendor = PCIVendor(_id, _info)
+                last_vendor = PCIVendor(int(_id, 16), _info)
+                last_device = None
+        if last_vendor:
+            yield last_vendor
 
     def read_lines(self) -> Generator[str, None, None]:
-        with open(self.in_path) as f:
+        with open(self.in_path, encoding="utf-8") as f:
             for line in f.readlines():
                 # skip all nonsense lines (comments and empty lines)
-                if line.startswith("#") or len(line) == 0 or line == '\n':
+                line = line.rstrip("\n")
+                if line.startswith("#") or len(line.strip()) == 0:
                     continue
                 yield line
 
+    def version(self) -> str:
+        with open(self.in_path, encoding="utf-8") as f:
+            for line in f:
+                if line.startswith("#\tVersion:"):
+                    return line.split(":", maxsplit=1)[1].strip()
+        return "unknown"
+
+
+class StringPool:
+    """Deduplicating pool of UTF-8 encoded names."""
+
+    def __init__(self):
+        self.data = bytearray()
+        self._offsets: Dict[str, Tuple[int, int]] = {}
+
+    def add(self, s: str) -> Tuple[int, int]:
+        if s not in self._offsets:
+            encoded = s.encode("utf-8")
+            self._offsets[s] = (len(self.data), len(encoded))
+            self.data += encoded
+        return self._offsets[s]
+
+
+def c_string_literals(data: bytes, width: int = 100) -> Generator[str, None, None]:
+    """Yields the pool as a sequence of adjacent string literals with at most `width` characters each."""
+    chunk = ""
+    for byte in data:
+        c = chr(byte)
+        if c == '"' or c == '\\':
+            esc = "\\" + c
+        elif 0x20 <= byte < 0x7f and c != '?':
+            esc = c
+        else:
+            # always three octal digits, so the next character can never extend the escape sequence
+            esc = f"\\{byte:03o}"
+        if len(chunk) + len(esc) > width:
+            yield f'"{chunk}"'
+            chunk = ""
+        chunk += esc
+    if chunk:
+        yield f'"{chunk}"'
+
+
+HEADER = """\
+/**
+ * This file is generated by scripts/pci_builder.py from scripts/pci.ids (version {version}). Do not edit it by hand,
+ * rerun the script instead once scripts/pci.ids was updated.
+ *
+ * The tables are declared in hwinfo/utils/pci.ids.h. They live in this translation unit so that they are compiled once
+ * and linked into a single library instead of being parsed by every includer.
+ */
+
+#include "hwinfo/platform.h"
+
+#if defined(HWINFO_UNIX) && !defined(HWINFO_NO_EMBEDDED_PCI_IDS)
+
+#include "hwinfo/utils/pci.ids.h"
+
+namespace hwinfo {{
+namespace pci_db {{
+"""
+
+FOOTER = """
+}  // namespace pci_db
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX && !HWINFO_NO_EMBEDDED_PCI_IDS
+"""
+
+
+def build_tables(vendors: List[PCIVendor]):
+    """Returns the string pool and the vendor, device and subsystem rows as tuples in table order."""
+    pool = StringPool()
+    vendor_rows, device_rows, subsystem_rows = [], [], []
+    for vendor in sorted(vendors, key=lambda v: v.id):
+        offset, length = pool.add(vendor.name)
+        vendor_rows.append((vendor.id, offset, length, len(device_rows), len(vendor.devices)))
+        for device_id in sorted(vendor.devices):
+            device = vendor.devices[device_id]
+            offset, length = pool.add(device.name)
+            device_rows.append((device.id, offset, length, len(subsystem_rows), len(device.subsystems)))
+            for (subvendor, subdevice) in sorted(device.subsystems):
+                offset, length = pool.add(device.subsystems[(subvendor, subdevice)])
+                subsystem_rows.append((subvendor, subdevice, offset, length))
+    return pool, vendor_rows, device_rows, subsystem_rows
+
+
+def generate_binary(vendors: List[PCIVendor]) -> bytes:
+    pool, vendor_rows, device_rows, subsystem_rows = build_tables(vendors)
+    out = bytearray(struct.pack("<8s6I", b"HWPCIIDX", 1, len(vendor_rows), len(device_rows), len(subsystem_rows),
+                                len(pool.data), 0))
+    for row in vendor_rows:
+        out += struct.pack("<H2xIIII", *row)
+    for row in device_rows:
+        out += struct.pack("<H2xIIII", *row)
+    for row in subsystem_rows:
+        out += struct.pack("<HHII", *row)
+    out += pool.data
+    return bytes(out)
+
+
+def generate(vendors: List[PCIVendor], version: str) -> str:
+    pool, vendors_t, devices_t, subsystems_t = build_tables(vendors)
+    # PCIMapper has no compile time view of the tables anymore, catch a broken pci.ids here instead
+    if not any(row[0] == 0x10de for row in vendors_t):
+        raise ValueError("NVIDIA (0x10de) is missing from the parsed pci.ids")
+    vendor_rows = [f"    {{0x{v:04x}, {{{o}, {n}}}, {first}, {count}}}," for (v, o, n, first, count) in vendors_t]
+    device_rows = [f"    {{0x{d:04x}, {{{o}, {n}}}, {first}, {count}}}," for (d, o, n, first, count) in devices_t]
+    subsystem_rows = [f"    {{0x{sv:04x}, 0x{sd:04x}, {{{o}, {n}}}}}," for (sv, sd, o, n) in subsystems_t]
+
+    out = [HEADER.format(version=version)]
+    out.append("// clang-format off")
+    out.append("const char pci_string_pool[] =")
+    out.extend(f"    {literal}" for literal in c_string_literals(bytes(pool.data)))
+    out.append(";")
+    out.append("")
+    out.append(f"const VendorEntry pci_vendors[{len(vendor_rows)}] = {{")
+    out.extend(vendor_rows)
+    out.append("};")
+    out.append("")
+    out.append(f"const DeviceEntry pci_devices[{len(device_rows)}] = {{")
+    out.extend(device_rows)
+    out.append("};")
+    out.append("")
+    out.append(f"const SubsystemEntry pci_subsystems[{max(len(subsystem_rows), 1)}] = {{")
+    out.extend(subsystem_rows if subsystem_rows else ["    {0, 0, {0, 0}},"])
+    out.append("};")
+    out.append("// clang-format on")
+    out.append("")
+    out.append(f"const uint32_t pci_num_vendors = {len(vendor_rows)};")
+    out.append(f"const uint32_t pci_num_devices = {len(device_rows)};")
+    out.append(f"const uint32_t pci_num_subsystems = {len(subsystem_rows)};")
+    out.append(f"const uint32_t pci_string_pool_size = {len(pool.data)};")
+    out.append(FOOTER)
+    return "\n".join(out)
+
+
+def find_pci_ids() -> Optional[str]:
+    for path in ("pci.ids", "scripts/pci.ids", "hwinfo/scripts/pci.ids"):
+        if os.path.isfile(path):
+            return path
+    return None
+
 
 if __name__ == "__main__":
-    import os
-    path = "pci.ids"
-    if not os.path.isfile(path):
-        path = "scripts/pci.ids"
-    if not os.path.isfile(path):
-        path = "hwinfo/scripts/pci.ids"
-    else:
+    args = sys.argv[1:]
+    binary = "--binary" in args
+    args = [arg for arg in args if arg != "--binary"]
+    in_path = args[0] if len(args) > 0 else find_pci_ids()
+    if in_path is None or not os.path.isfile(in_path):
         print("pci.ids file could not be found")
         exit(1)
-    parser = PCIParser(path)
-    for vendor in parser.parse():
-        print(f"{'{'}{vendor.id}")
-
+    if len(args) > 1:
+        out_path = args[1]
+    elif binary:
+        out_path = "pci.ids.bin"
+    else:
+        out_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "pci.ids.cpp")
+    parser = PCIParser(in_path)
+    if binary:
+        with open(out_path, "wb") as f:
+            f.write(generate_binary(list(parser.parse())))
+    else:
+        with open(out_path, "w", encoding="utf-8") as f:
+            f.write(generate(list(parser.parse()), parser.version()))
+    print(f"wrote {out_path}")
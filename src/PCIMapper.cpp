@@ -9,112 +9,660 @@
 
 #ifdef HWINFO_UNIX
 
-#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+
+#ifndef HWINFO_NO_EMBEDDED_PCI_IDS
 #include "hwinfo/utils/pci.ids.h"
-#include "hwinfo/utils/stringutils.h"
+#endif  // HWINFO_NO_EMBEDDED_PCI_IDS
 
 namespace hwinfo {
 
-// _____________________________________________________________________________________________________________________
-PCIDevice::PCIDevice(std::string d_id, std::string d_name)
-    : device_id(std::move(d_id)), device_name(std::move(d_name)) {}
+namespace {
+
+// Binary search over table[first, first + count) for an entry with the given id. Returns nullptr if there is none.
+template <typename Entry>
+constexpr const Entry* find_entry(const Entry* table, uint32_t first, uint32_t count, uint16_t id) {
+  uint32_t lo = first;
+  uint32_t hi = first + count;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (table[mid].id < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo < first + count && table[lo].id == id) ? &table[lo] : nullptr;
+}
+
+// Binary search for (subvendor, subdevice) over the subsystems of one device.
+template <typename Entry>
+constexpr const Entry* find_subsystem(const Entry* table, uint32_t first, uint32_t count, uint16_t subvendor_id,
+                                      uint16_t subdevice_id) {
+  const uint32_t key = (static_cast<uint32_t>(subvendor_id) << 16) | subdevice_id;
+  uint32_t lo = first;
+  uint32_t hi = first + count;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const auto& entry = table[mid];
+    if (((static_cast<uint32_t>(entry.subvendor) << 16) | entry.subdevice) < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < first + count && table[lo].subvendor == subvendor_id && table[lo].subdevice == subdevice_id) {
+    return &table[lo];
+  }
+  return nullptr;
+}
+
+// Result of a vendor or device lookup. first and count address the devices of a vendor or the subsystems of a device
+// in the database that produced the entry.
+struct Entry {
+  bool found{false};
+  uint16_t id{0};
+  std::string_view name;
+  uint32_t first{0};
+  uint32_t count{0};
+};
+
+class Database {
+ public:
+  virtual ~Database() = default;
+  HWI_NODISCARD virtual Entry vendor(uint16_t vendor_id) const = 0;
+  HWI_NODISCARD virtual Entry device(uint32_t first, uint32_t count, uint16_t device_id) const = 0;
+  HWI_NODISCARD virtual PCISubsystem subsystem(uint32_t first, uint32_t count, uint16_t subvendor_id,
+                                               uint16_t subdevice_id) const = 0;
+};
+
+// Sorted tables with names stored as (offset, length) into a string pool: the embedded header or a mapped binary
+// index. Ranges are checked on lookup, so a truncated or corrupt index never reads out of bounds.
+template <typename VendorEntry, typename DeviceEntry, typename SubsystemEntry>
+class TableDatabase : public Database {
+ public:
+  TableDatabase(const VendorEntry* vendors, uint32_t num_vendors, const DeviceEntry* devices, uint32_t num_devices,
+                const SubsystemEntry* subsystems, uint32_t num_subsystems, const char* pool, uint32_t pool_size)
+      : _vendors(vendors),
+        _num_vendors(num_vendors),
+        _devices(devices),
+        _num_devices(num_devices),
+        _subsystems(subsystems),
+        _num_subsystems(num_subsystems),
+        _pool(pool),
+        _pool_size(pool_size) {}
+
+  HWI_NODISCARD Entry vendor(uint16_t vendor_id) const override {
+    const auto* entry = find_entry(_vendors, 0, _num_vendors, vendor_id);
+    if (entry == nullptr || !in_range(entry->first_device, entry->num_devices, _num_devices)) {
+      return {};
+    }
+    return {true, entry->id, string(entry->name), entry->first_device, entry->num_devices};
+  }
+
+  HWI_NODISCARD Entry device(uint32_t first, uint32_t count, uint16_t device_id) const override {
+    const auto* entry = find_entry(_devices, first, count, device_id);
+    if (entry == nullptr || !in_range(entry->first_subsystem, entry->num_subsystems, _num_subsystems)) {
+      return {};
+    }
+    return {true, entry->id, string(entry->name), entry->first_subsystem, entry->num_subsystems};
+  }
+
+  HWI_NODISCARD PCISubsystem subsystem(uint32_t first, uint32_t count, uint16_t subvendor_id,
+                                       uint16_t subdevice_id) const override {
+    const auto* entry = find_subsystem(_subsystems, first, count, subvendor_id, subdevice_id);
+    if (entry == nullptr) {
+      return {};
+    }
+    return {entry->subvendor, entry->subdevice, string(entry->name)};
+  }
+
+ private:
+  static bool in_range(uint32_t first, uint32_t count, uint32_t size) { return first <= size && count <= size - first; }
+
+  template <typename Ref>
+  std::string_view string(const Ref& ref) const {
+    if (!in_range(ref.offset, ref.length, _pool_size)) {
+      return {};
+    }
+    return {_pool + ref.offset, ref.length};
+  }
+
+  const VendorEntry* _vendors;
+  uint32_t _num_vendors;
+  const DeviceEntry* _devices;
+  uint32_t _num_devices;
+  const SubsystemEntry* _subsystems;
+  uint32_t _num_subsystems;
+  const char* _pool;
+  uint32_t _pool_size;
+};
+
+// Layout of the binary index written by scripts/pci_builder.py --binary: the header, the vendor, device and subsystem
+// tables and the string pool, back to back. All integers are little endian.
+struct IndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_vendors;
+  uint32_t num_devices;
+  uint32_t num_subsystems;
+  uint32_t pool_size;
+  uint32_t reserved;
+};
+
+struct IndexStringRef {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct IndexVendor {
+  uint16_t id;
+  IndexStringRef name;
+  uint32_t first_device;
+  uint32_t num_devices;
+};
+
+struct IndexDevice {
+  uint16_t id;
+  IndexStringRef name;
+  uint32_t first_subsystem;
+  uint32_t num_subsystems;
+};
+
+struct IndexSubsystem {
+  uint16_t subvendor;
+  uint16_t subdevice;
+  IndexStringRef name;
+};
+
+static_assert(sizeof(IndexHeader) == 32 && sizeof(IndexVendor) == 20 && sizeof(IndexDevice) == 20 &&
+                  sizeof(IndexSubsystem) == 12,
+              "the binary index layout must match scripts/pci_builder.py");
+
+constexpr char index_magic[8] = {'H', 'W', 'P', 'C', 'I', 'I', 'D', 'X'};
+constexpr uint32_t index_version = 1;
+
+using IndexDatabase = TableDatabase<IndexVendor, IndexDevice, IndexSubsystem>;
 
 // _____________________________________________________________________________________________________________________
-PCIVendor::PCIVendor(std::string v_id, std::string v_name)
-    : vendor_id(std::move(v_id)), vendor_name(std::move(v_name)) {}
+const char* next_line(const char* pos, const char* end) {
+  const auto* newline = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+  return newline == nullptr ? end : newline + 1;
+}
 
 // _____________________________________________________________________________________________________________________
-const PCIDevice& PCIVendor::operator[](const std::string& device_id) const {
-  std::string d_id =
-      utils::starts_with(device_id, "0x") ? std::string(device_id.begin() + 2, device_id.end()) : device_id;
-  if (devices.find(d_id) == devices.end()) {
-    return _invalid_device;
+bool parse_hex(const char* pos, const char* end, uint16_t& out) {
+  if (end - pos < 4) {
+    return false;
+  }
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    const char c = pos[i];
+    uint32_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return false;
+    }
+    value = (value << 4) | digit;
   }
-  return devices.at(d_id);
+  out = static_cast<uint16_t>(value);
+  return true;
 }
 
-// _____________________________________________________________________________________________________________________
-PCIMapper::PCIMapper() {
-  std::stringstream s_pciid(get_pci_ids());
-  PCIVendor* current_vendor = nullptr;
-  PCIDevice* current_device = nullptr;
-  while (true) {
-    std::string line;
-    if (!std::getline(s_pciid, line)) {
-      break;
+/**
+ * Parses the line starting at line if it is an entry of the given nesting level: "vvvv  name" (0), "\tdddd  name" (1)
+ * or "\t\tssss dddd  name" (2, key is subvendor << 16 | subdevice). The device class list ("C xx  name") follows the
+ * vendors, its header lines are reported as keys greater than any vendor ID at level 0.
+ * @return false for comments, empty lines and lines of other levels
+ */
+bool parse_line(const char* line, const char* end, int level, uint32_t& key, std::string_view& name) {
+  if (level == 0 && end - line >= 2 && line[0] == 'C' && line[1] == ' ') {
+    key = UINT32_MAX;
+    return true;
+  }
+  const char* pos = line;
+  for (int i = 0; i < level; ++i, ++pos) {
+    if (pos == end || *pos != '\t') {
+      return false;
     }
-    if (utils::starts_with(line, "#") || utils::starts_with(line, "\n") || line.empty()) {
-      // empty line or comment
-      continue;
+  }
+  uint16_t id;
+  if (!parse_hex(pos, end, id)) {
+    return false;
+  }
+  key = id;
+  pos += 4;
+  if (level == 2) {
+    uint16_t subdevice;
+    if (pos == end || *pos != ' ' || !parse_hex(pos + 1, end, subdevice)) {
+      return false;
     }
-    if (utils::starts_with(line, "\t\t")) {
-      // subsystem entry
-      utils::strip(line);
-      auto split_line = utils::split(line, "  ");
-      if (split_line.size() != 2 || current_device == nullptr) {
-        // parse error
-        continue;
+    key = (key << 16) | subdevice;
+    pos += 5;
+  }
+  if (end - pos < 2 || pos[0] != ' ' || pos[1] != ' ') {
+    return false;
+  }
+  pos += 2;
+  const char* name_end = next_line(pos, end);
+  while (name_end > pos && (name_end[-1] == '\n' || name_end[-1] == '\r')) --name_end;
+  name = {pos, static_cast<size_t>(name_end - pos)};
+  return true;
+}
+
+/**
+ * Binary search over the lines starting in [begin, end) for the entry of the given level and key. Probes land on
+ * arbitrary bytes and move forward to the next entry line, so only the pages around O(log n) probes are read. This
+ * relies on pci.ids listing vendors, devices and subsystems sorted by their IDs, as the upstream file does.
+ * @return the start of the line or nullptr
+ */
+const char* find_line(const char* begin, const char* end, int level, uint32_t key, std::string_view& name) {
+  const char* lo = begin;
+  const char* hi = end;
+  while (lo < hi) {
+    const char* mid = lo + (hi - lo) / 2;
+    const char* line = (mid == begin || mid[-1] == '\n') ? mid : next_line(mid, hi);
+    uint32_t line_key = 0;
+    while (line < hi && !parse_line(line, end, level, line_key, name)) {
+      line = next_line(line, hi);
+    }
+    if (line >= hi) {
+      // no entry starts in [mid, hi)
+      hi = mid;
+    } else if (line_key == key) {
+      return line;
+    } else if (line_key < key) {
+      lo = next_line(line, hi);
+    } else {
+      hi = mid;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * End of the nested block (devices of a vendor: level 1, subsystems of a device: level 2) starting at begin: the first
+ * line indented by less than level tabs. Comments and empty lines do not end a block.
+ */
+const char* block_end(const char* begin, const char* end, int level) {
+  const char* line = begin;
+  while (line < end) {
+    if (*line != '#' && *line != '\n' && *line != '\r') {
+      int tabs = 0;
+      while (tabs < level && line + tabs < end && line[tabs] == '\t') ++tabs;
+      if (tabs < level) {
+        break;
       }
-      current_device->subsystems.insert({split_line[0], split_line[1]});
-    } else if (utils::starts_with(line, "\t")) {
-      // device
-      utils::strip(line);
-      auto split_line = utils::split(line, "  ");
-      if (split_line.size() != 2 || current_vendor == nullptr) {
-        // parse error
-        continue;
+    }
+    line = next_line(line, end);
+  }
+  return line;
+}
+
+// The pci.ids text file (https://pci-ids.ucw.cz) as installed by hwdata or pciutils. Nothing is parsed up front:
+// vendors and devices are binary searches over byte ranges (first/count of an Entry are byte offsets) that are
+// remembered once found, so the block of a vendor is only scanned by its first lookup.
+class TextDatabase : public Database {
+ public:
+  TextDatabase(const char* data, size_t size) : _data(data), _end(data + size) {}
+
+  HWI_NODISCARD Entry vendor(uint16_t vendor_id) const override {
+    return entry(0, static_cast<uint32_t>(_end - _data), 0, vendor_id);
+  }
+
+  HWI_NODISCARD Entry device(uint32_t first, uint32_t count, uint16_t device_id) const override {
+    return entry(first, count, 1, device_id);
+  }
+
+  HWI_NODISCARD PCISubsystem subsystem(uint32_t first, uint32_t count, uint16_t subvendor_id,
+                                       uint16_t subdevice_id) const override {
+    std::string_view name;
+    const uint32_t key = (static_cast<uint32_t>(subvendor_id) << 16) | subdevice_id;
+    if (find_line(_data + first, _data + first + count, 2, key, name) == nullptr) {
+      return {};
+    }
+    return {subvendor_id, subdevice_id, name};
+  }
+
+ private:
+  Entry entry(uint32_t first, uint32_t count, int level, uint16_t id) const {
+    // devices are keyed by the offset of their vendor block, which is unique per vendor
+    const uint64_t key = (uint64_t{first} << 17) | (uint64_t(level) << 16) | id;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const auto it = _entries.find(key);
+      if (it != _entries.end()) {
+        return it->second;
       }
-      current_vendor->devices.insert({split_line[0], {split_line[0], split_line[1]}});
-      current_device = &current_vendor->devices.at(split_line[0]);
+    }
+    const char* begin = _data + first;
+    const char* end = begin + count;
+    Entry result;
+    std::string_view name;
+    if (const char* line = find_line(begin, end, level, id, name)) {
+      const char* block = next_line(line, end);
+      const char* block_stop = block_end(block, end, level + 1);
+      result = {true, id, name, static_cast<uint32_t>(block - _data), static_cast<uint32_t>(block_stop - block)};
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.emplace(key, result);
+    return result;
+  }
+
+  const char* _data;
+  const char* _end;
+  mutable std::mutex _mutex;
+  mutable std::unordered_map<uint64_t, Entry> _entries;
+};
+
+// pci.ids locations of hwdata (Fedora, Arch), pciutils (Debian, Ubuntu) and older distributions
+constexpr const char* system_paths[] = {"/usr/share/hwdata/pci.ids", "/usr/share/misc/pci.ids", "/usr/share/pci.ids"};
+
+/**
+ * Maps a binary index or a pci.ids file read-only. The mapping is never released: the names handed out by the mapper
+ * point into it for the rest of the process. Pages are only read when a lookup touches them (MADV_RANDOM disables
+ * read-ahead).
+ * @return nullptr if the file can not be mapped or is neither a valid index nor text
+ */
+const Database* open_database(const std::string& path) {
+  HWINFO_PROBE("pci.database");
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  HWINFO_COUNT_OPEN();
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || st.st_size >= UINT32_MAX) {
+    close(fd);
+    return nullptr;
+  }
+  const auto size = static_cast<size_t>(st.st_size);
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  HWINFO_COUNT_SYSCALL();
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  madvise(mapping, size, MADV_RANDOM);
+  const auto* data = static_cast<const char*>(mapping);
+
+  IndexHeader header{};
+  if (size >= sizeof(header) && std::memcmp(data, index_magic, sizeof(index_magic)) == 0) {
+    std::memcpy(&header, data, sizeof(header));
+    const uint64_t tables = sizeof(IndexHeader) + uint64_t{header.num_vendors} * sizeof(IndexVendor) +
+                            uint64_t{header.num_devices} * sizeof(IndexDevice) +
+                            uint64_t{header.num_subsystems} * sizeof(IndexSubsystem);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const bool native = false;
+#else
+    const bool native = true;
+#endif
+    if (!native || header.version != index_version || tables + header.pool_size > size) {
+      munmap(mapping, size);
+      return nullptr;
+    }
+    const auto* vendors = reinterpret_cast<const IndexVendor*>(data + sizeof(IndexHeader));
+    const auto* devices = reinterpret_cast<const IndexDevice*>(vendors + header.num_vendors);
+    const auto* subsystems = reinterpret_cast<const IndexSubsystem*>(devices + header.num_devices);
+    const auto* pool = reinterpret_cast<const char*>(subsystems + header.num_subsystems);
+    return new IndexDatabase(vendors, header.num_vendors, devices, header.num_devices, subsystems,
+                             header.num_subsystems, pool, header.pool_size);
+  }
+  return new TextDatabase(data, size);
+}
+
+// _____________________________________________________________________________________________________________________
+const Database* open_system_database(std::string& source) {
+  for (const char* path : system_paths) {
+    const std::string rooted = filesystem::rooted(path);
+    if (const Database* database = open_database(rooted)) {
+      source = rooted;
+      return database;
+    }
+  }
+  return nullptr;
+}
+
+// _____________________________________________________________________________________________________________________
+const Database* open_default_database(std::string& source) {
+  if (const char* path = std::getenv("HWINFO_PCI_IDS")) {
+    const Database* database = nullptr;
+    if (*path == '\0') {
+      database = open_system_database(source);
+    } else if ((database = open_database(path)) != nullptr) {
+      source = path;
+    }
+    if (database != nullptr) {
+      return database;
+    }
+  }
+#ifndef HWINFO_NO_EMBEDDED_PCI_IDS
+  static const TableDatabase<pci_db::VendorEntry, pci_db::DeviceEntry, pci_db::SubsystemEntry> embedded(
+      pci_db::pci_vendors, pci_db::pci_num_vendors, pci_db::pci_devices, pci_db::pci_num_devices,
+      pci_db::pci_subsystems, pci_db::pci_num_subsystems, pci_db::pci_string_pool, pci_db::pci_string_pool_size);
+  source = "embedded";
+  return &embedded;
+#else
+  if (const Database* database = open_system_database(source)) {
+    return database;
+  }
+  static const IndexDatabase empty(nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 0);
+  source = "none";
+  return &empty;
+#endif  // HWINFO_NO_EMBEDDED_PCI_IDS
+}
+
+struct Selection {
+  std::mutex mutex;
+  std::atomic<const Database*> database{nullptr};
+  // written once before database is published
+  std::string source;
+};
+
+Selection& selection() {
+  static Selection instance;
+  return instance;
+}
+
+// _____________________________________________________________________________________________________________________
+const Database& database() {
+  auto& selected = selection();
+  if (const Database* database = selected.database.load(std::memory_order_acquire)) {
+    return *database;
+  }
+  std::lock_guard<std::mutex> lock(selected.mutex);
+  if (selected.database.load(std::memory_order_relaxed) == nullptr) {
+    selected.database.store(open_default_database(selected.source), std::memory_order_release);
+  }
+  return *selected.database.load(std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+PCIDevice::PCIDevice(uint16_t d_id, std::string_view d_name) : device_id(d_id), device_name(d_name) {}
+
+// _____________________________________________________________________________________________________________________
+PCISubsystem PCIDevice::subsystem(uint16_t subvendor_id, uint16_t subdevice_id) const {
+  if (_num_subsystems == 0) {
+    return {};
+  }
+  return database().subsystem(_first_subsystem, _num_subsystems, subvendor_id, subdevice_id);
+}
+
+// _____________________________________________________________________________________________________________________
+PCIVendor::PCIVendor(uint16_t v_id, std::string_view v_name) : vendor_id(v_id), vendor_name(v_name) {}
+
+// _____________________________________________________________________________________________________________________
+PCIDevice PCIVendor::operator[](const std::string& device_id) const {
+  uint16_t id;
+  if (!PCIMapper::parse_id(device_id, id)) {
+    return {};
+  }
+  return PCIMapper::device_of(*this, id);
+}
+
+// _____________________________________________________________________________________________________________________
+PCIDevice PCIVendor::operator[](uint16_t device_id) const { return PCIMapper::device_of(*this, device_id); }
+
+// _____________________________________________________________________________________________________________________
+bool PCIMapper::parse_id(const std::string& id, uint16_t& out) {
+  size_t pos = 0;
+  size_t end = id.size();
+  while (pos < end && (id[pos] == ' ' || id[pos] == '\t')) ++pos;
+  while (end > pos && (id[end - 1] == ' ' || id[end - 1] == '\t' || id[end - 1] == '\n')) --end;
+  if (end - pos > 2 && id[pos] == '0' && (id[pos + 1] == 'x' || id[pos + 1] == 'X')) {
+    pos += 2;
+  }
+  if (pos == end || end - pos > 4) {
+    return false;
+  }
+  uint32_t value = 0;
+  for (; pos < end; ++pos) {
+    const char c = id[pos];
+    uint32_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
     } else {
-      // vendor
-      utils::strip(line);
-      auto split_line = utils::split(line, "  ");
-      if (split_line.size() != 2) {
-        // parse error
-        continue;
-      }
-      _vendors.insert({split_line[0], {split_line[0], split_line[1]}});
-      current_vendor = &_vendors.at(split_line[0]);
+      return false;
     }
+    value = (value << 4) | digit;
   }
+  out = static_cast<uint16_t>(value);
+  return true;
 }
 
 // _____________________________________________________________________________________________________________________
-const PCIVendor& PCIMapper::vendor_from_id(const std::string& vendor_id) const {
-  std::string v_id =
-      utils::starts_with(vendor_id, "0x") ? std::string(vendor_id.begin() + 2, vendor_id.end()) : vendor_id;
-  if (_vendors.find(v_id) == _vendors.end()) {
-    return _invalid_vendor;
+PCIVendor PCIMapper::vendor_of(uint16_t vendor_id) {
+  const Entry entry = database().vendor(vendor_id);
+  if (!entry.found) {
+    return {};
   }
-  return _vendors.at(v_id);
+  PCIVendor vendor(entry.id, entry.name);
+  vendor._first_device = entry.first;
+  vendor._num_devices = entry.count;
+  return vendor;
 }
 
 // _____________________________________________________________________________________________________________________
-const PCIVendor& PCIMapper::operator[](const std::string& vendor_id) const { return vendor_from_id(vendor_id); }
+PCIDevice PCIMapper::device_of(const PCIVendor& vendor, uint16_t device_id) {
+  if (vendor._num_devices == 0) {
+    return {};
+  }
+  const Entry entry = database().device(vendor._first_device, vendor._num_devices, device_id);
+  if (!entry.found) {
+    return {};
+  }
+  PCIDevice device(entry.id, entry.name);
+  device._first_subsystem = entry.first;
+  device._num_subsystems = entry.count;
+  return device;
+}
 
 // _____________________________________________________________________________________________________________________
-PCIMapper PCI::getMapper() {
-  const auto getenv = [](const char* name) -> std::string {
+void PCIMapper::resolve(const PCIId* ids, size_t count, PCIResolved* out) const {
+  // visit the pairs sorted by vendor so that consecutive pairs of the same vendor share one vendor lookup
+  std::vector<uint32_t> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [ids](uint32_t a, uint32_t b) { return ids[a].vendor_id < ids[b].vendor_id; });
 
-#ifdef _MSC_VER
-    char* value;
-    size_t size;
-    _dupenv_s(&value, &size, name);
-    std::string ret(value);
-    free(value);
-#else
-    std::string ret(std::getenv(name));
-#endif
-    return ret;
-  };
+  PCIVendor vendor;
+  uint32_t last_vendor_id = UINT32_MAX;
+  for (const uint32_t i : order) {
+    if (ids[i].vendor_id != last_vendor_id) {
+      vendor = vendor_of(ids[i].vendor_id);
+      last_vendor_id = ids[i].vendor_id;
+    }
+    out[i].vendor = vendor;
+    out[i].device = device_of(vendor, ids[i].device_id);
+    out[i].subsystem = ids[i].subvendor_id != 0 ? out[i].device.subsystem(ids[i].subvendor_id, ids[i].subdevice_id)
+                                                : PCISubsystem{};
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<PCIResolved> PCIMapper::resolve(const std::vector<PCIId>& ids) const {
+  std::vector<PCIResolved> resolved(ids.size());
+  resolve(ids.data(), ids.size(), resolved.data());
+  return resolved;
+}
+
+// _____________________________________________________________________________________________________________________
+PCIVendor PCIMapper::vendor_from_id(const std::string& vendor_id) const {
+  uint16_t id;
+  if (!parse_id(vendor_id, id)) {
+    return {};
+  }
+  return vendor_of(id);
+}
+
+// _____________________________________________________________________________________________________________________
+PCIVendor PCIMapper::operator[](const std::string& vendor_id) const { return vendor_from_id(vendor_id); }
+
+// _____________________________________________________________________________________________________________________
+PCIVendor PCIMapper::vendor_from_id(uint16_t vendor_id) const { return vendor_of(vendor_id); }
+
+// _____________________________________________________________________________________________________________________
+PCIVendor PCIMapper::operator[](uint16_t vendor_id) const { return vendor_of(vendor_id); }
 
-  static std::string path = getenv("HOME");
-  static PCIMapper mapper;
+// _____________________________________________________________________________________________________________________
+const PCIMapper& PCI::getMapper() {
+  // function local statics are initialized thread-safe
+  static const PCIMapper mapper;
   return mapper;
 }
 
+// _____________________________________________________________________________________________________________________
+bool PCI::useDatabase(const std::string& path) {
+  auto& selected = selection();
+  std::lock_guard<std::mutex> lock(selected.mutex);
+  if (selected.database.load(std::memory_order_relaxed) != nullptr) {
+    return false;
+  }
+  std::string source = path;
+  const Database* database = path.empty() ? open_system_database(source) : open_database(path);
+  if (database == nullptr) {
+    return false;
+  }
+  selected.source = std::move(source);
+  selected.database.store(database, std::memory_order_release);
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+std::string PCI::databaseSource() {
+  database();
+  auto& selected = selection();
+  std::lock_guard<std::mutex> lock(selected.mutex);
+  return selected.source;
+}
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_UNIX
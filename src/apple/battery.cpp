@@ -8,158 +8,210 @@
 #include <IOKit/ps/IOPSKeys.h>
 #include <IOKit/ps/IOPowerSources.h>
 
-#include <iostream>
+#include <cmath>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "hwinfo/battery.h"
 #include "hwinfo/utils/constants.h"
+#include "hwinfo/utils/instrumentation.h"
 
 namespace hwinfo {
 
-// =====================================================================================================================
-CFDictionaryRef getPowerSource(const int id) {
-  const CFTypeRef powerInfo = IOPSCopyPowerSourcesInfo();
-  if (!powerInfo) {
-    return nullptr;
-  }
+namespace {
 
-  const CFArrayRef powerSources = IOPSCopyPowerSourcesList(powerInfo);
-  if (!powerSources) {
-    CFRelease(powerInfo);
-    return nullptr;
-  }
+// the attributes of one IOPS power source description
+struct PowerSourceState {
+  std::string serial_number{constants::UNKNOWN};
+  uint32_t max_capacity{0};
+  uint32_t current_capacity{0};
+  bool charging{false};
+  double power_W{-1.0};
+};
 
-  const CFDictionaryRef powerSource =
-      IOPSGetPowerSourceDescription(powerInfo, CFArrayGetValueAtIndex(powerSources, id));
+bool get_int(CFDictionaryRef description, CFStringRef key, int& out) {
+  const auto value = static_cast<CFNumberRef>(CFDictionaryGetValue(description, key));
+  return value && CFGetTypeID(value) == CFNumberGetTypeID() && CFNumberGetValue(value, kCFNumberIntType, &out);
+}
 
-  if (!powerSource) {
-    CFRelease(powerSources);
-    CFRelease(powerInfo);
-    return nullptr;
+PowerSourceState read_state(CFDictionaryRef description) {
+  PowerSourceState state;
+  // this key is recommended. it may be empty
+  const auto serial_number =
+      static_cast<CFStringRef>(CFDictionaryGetValue(description, CFSTR(kIOPSHardwareSerialNumberKey)));
+  char buffer[256];
+  if (serial_number && CFGetTypeID(serial_number) == CFStringGetTypeID() &&
+      CFStringGetCString(serial_number, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
+    state.serial_number = buffer;
   }
-
-  CFRetain(powerSource);
-
-  CFRelease(powerSources);
-  CFRelease(powerInfo);
-
-  return powerSource;
+  int value = 0;
+  if (get_int(description, CFSTR(kIOPSMaxCapacityKey), value) && value > 0) {
+    state.max_capacity = static_cast<uint32_t>(value);
+  }
+  if (get_int(description, CFSTR(kIOPSCurrentCapacityKey), value) && value > 0) {
+    state.current_capacity = static_cast<uint32_t>(value);
+  }
+  state.charging = CFDictionaryGetValue(description, CFSTR(kIOPSIsChargingKey)) == kCFBooleanTrue;
+  // current in mA (negative while discharging) and voltage in mV
+  int current_mA = 0;
+  int voltage_mV = 0;
+  if (get_int(description, CFSTR(kIOPSCurrentKey), current_mA) &&
+      get_int(description, CFSTR(kIOPSVoltageKey), voltage_mV)) {
+    state.power_W = std::abs(static_cast<double>(current_mA)) * voltage_mV / 1e6;
+  }
+  return state;
 }
 
-// _____________________________________________________________________________________________________________________
-std::string Battery::getVendor() const { return constants::UNKNOWN; }
+/**
+ * Cache of all power sources. The sources are read once and then only when IOKit posts a power source notification
+ * (IOPSNotificationCreateRunLoopSource), which it does on attach/detach, charging state changes and at most about
+ * once a minute for capacity changes. The notification run loop runs on a thread of its own that sleeps in between,
+ * getters only copy the cached values.
+ */
+class PowerSources {
+ public:
+  static PowerSources& instance() {
+    static PowerSources sources;
+    return sources;
+  }
 
-// _____________________________________________________________________________________________________________________
-std::string Battery::getModel() const { return constants::UNKNOWN; }
+  ~PowerSources() {
+    if (_run_loop) {
+      CFRunLoopStop(_run_loop);
+    }
+    if (_thread.joinable()) {
+      _thread.join();
+    }
+  }
 
-// _____________________________________________________________________________________________________________________
-std::string Battery::getSerialNumber() const {
-  const CFDictionaryRef powerSource = getPowerSource(_id);
-  if (!powerSource) {
-    return constants::UNKNOWN;
+  PowerSources(const PowerSources&) = delete;
+  PowerSources& operator=(const PowerSources&) = delete;
+
+  // @return false if there is no source with this index
+  bool get(int id, PowerSourceState& state) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (id < 0 || static_cast<size_t>(id) >= _states.size()) {
+      return false;
+    }
+    state = _states[id];
+    return true;
   }
 
-  // this key is recommended. it may be empty
-  const auto serialNumber =
-      static_cast<CFStringRef>(CFDictionaryGetValue(powerSource, CFSTR(kIOPSHardwareSerialNumberKey)));
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _states.size();
+  }
 
-  if (!serialNumber) {
-    CFRelease(powerSource);
-    return constants::UNKNOWN;
+ private:
+  PowerSources() {
+    reload();
+    std::promise<CFRunLoopRef> started;
+    auto run_loop = started.get_future();
+    _thread = std::thread([this, &started] {
+      const CFRunLoopSourceRef source = IOPSNotificationCreateRunLoopSource(&PowerSources::changed, this);
+      if (!source) {
+        started.set_value(nullptr);
+        return;
+      }
+      CFRunLoopAddSource(CFRunLoopGetCurrent(), source, kCFRunLoopDefaultMode);
+      started.set_value(CFRunLoopGetCurrent());
+      CFRunLoopRun();
+      CFRunLoopRemoveSource(CFRunLoopGetCurrent(), source, kCFRunLoopDefaultMode);
+      CFRelease(source);
+    });
+    _run_loop = run_loop.get();
   }
 
-  char serialNumberStr[256];
+  static void changed(void* context) { static_cast<PowerSources*>(context)->reload(); }
+
+  void reload() {
+    HWINFO_PROBE("battery.iops");
+    std::vector<PowerSourceState> states;
+    HWINFO_COUNT_SYSCALL();
+    const CFTypeRef info = IOPSCopyPowerSourcesInfo();
+    if (info) {
+      const CFArrayRef list = IOPSCopyPowerSourcesList(info);
+      if (list) {
+        const CFIndex count = CFArrayGetCount(list);
+        for (CFIndex i = 0; i < count; ++i) {
+          const CFDictionaryRef description = IOPSGetPowerSourceDescription(info, CFArrayGetValueAtIndex(list, i));
+          states.push_back(description ? read_state(description) : PowerSourceState());
+        }
+        CFRelease(list);
+      }
+      CFRelease(info);
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _states = std::move(states);
+  }
 
-  CFStringGetCString(serialNumber, serialNumberStr, sizeof(serialNumberStr), kCFStringEncodingUTF8);
-  CFRelease(powerSource);
+  mutable std::mutex _mutex;
+  std::vector<PowerSourceState> _states;
+  std::thread _thread;
+  CFRunLoopRef _run_loop{nullptr};
+};
 
-  return serialNumberStr;
+PowerSourceState state_of(int id) {
+  PowerSourceState state;
+  PowerSources::instance().get(id, state);
+  return state;
 }
 
+}  // namespace
+
 // _____________________________________________________________________________________________________________________
-std::string Battery::getTechnology() const { return constants::UNKNOWN; }
+std::string Battery::getVendor() const { return constants::UNKNOWN; }
 
 // _____________________________________________________________________________________________________________________
-uint32_t Battery::getEnergyFull() const {
-  const CFDictionaryRef powerSource = getPowerSource(_id);
-  if (!powerSource) {
-    return 0;
-  }
+std::string Battery::getModel() const { return constants::UNKNOWN; }
 
-  const auto maxCapacityNum = static_cast<CFNumberRef>(CFDictionaryGetValue(powerSource, CFSTR(kIOPSMaxCapacityKey)));
-  CFRelease(powerSource);
-  if (!maxCapacityNum) {
-    return 0;
-  }
+// _____________________________________________________________________________________________________________________
+std::string Battery::getSerialNumber() const { return state_of(_id).serial_number; }
 
-  uint32_t maxCapacity;
-  CFNumberGetValue(maxCapacityNum, kCFNumberIntType, &maxCapacity);
+// _____________________________________________________________________________________________________________________
+std::string Battery::getTechnology() const { return constants::UNKNOWN; }
 
-  return maxCapacity;
-}
+// _____________________________________________________________________________________________________________________
+uint32_t Battery::getEnergyFull() const { return state_of(_id).max_capacity; }
 
 // _____________________________________________________________________________________________________________________
-uint32_t Battery::energyNow() const {
-  const CFDictionaryRef powerSource = getPowerSource(_id);
-  if (!powerSource) {
-    return 0;
-  }
+uint32_t Battery::energyNow() const { return state_of(_id).current_capacity; }
 
-  const auto currentCapacityNum =
-      static_cast<CFNumberRef>(CFDictionaryGetValue(powerSource, CFSTR(kIOPSCurrentCapacityKey)));
-  CFRelease(powerSource);
-  if (!currentCapacityNum) {
-    return 0;
-  }
+// _____________________________________________________________________________________________________________________
+bool Battery::charging() const { return state_of(_id).charging; }
 
-  uint32_t currentCapacity;
-  CFNumberGetValue(currentCapacityNum, kCFNumberIntType, &currentCapacity);
+// _____________________________________________________________________________________________________________________
+bool Battery::discharging() const { return !charging(); }
 
-  return currentCapacity;
-}
+// _____________________________________________________________________________________________________________________
+double Battery::powerNow_W() const { return state_of(_id).power_W; }
 
 // _____________________________________________________________________________________________________________________
-bool Battery::charging() const {
-  const CFDictionaryRef powerSource = getPowerSource(_id);
-  if (!powerSource) {
-    return constants::UNKNOWN;
+bool Battery::refresh() {
+  PowerSourceState state;
+  if (!PowerSources::instance().get(_id, state)) {
+    return false;
   }
-
-  const auto isCharging = static_cast<CFBooleanRef>(CFDictionaryGetValue(powerSource, CFSTR(kIOPSIsChargingKey)));
-
-  return isCharging == kCFBooleanTrue;
+  _energyNow = state.current_capacity;
+  _charging = state.charging;
+  _power_W = state.power_W;
+  return true;
 }
 
-// _____________________________________________________________________________________________________________________
-bool Battery::discharging() const { return !charging(); }
-
 // =====================================================================================================================
 // _____________________________________________________________________________________________________________________
 std::vector<Battery> getAllBatteries() {
   std::vector<Battery> batteries;
-
-  const CFTypeRef powerInfo = IOPSCopyPowerSourcesInfo();
-  if (!powerInfo) {
-    return batteries;
+  const size_t count = PowerSources::instance().size();
+  for (size_t i = 0; i < count; ++i) {
+    batteries.emplace_back(static_cast<int8_t>(i));
   }
-
-  const CFArrayRef powerSources = IOPSCopyPowerSourcesList(powerInfo);
-  if (!powerSources) {
-    CFRelease(powerInfo);
-    return batteries;
-  }
-
-  const int numSources = static_cast<int>(CFArrayGetCount(powerSources));
-
-  CFRelease(powerSources);
-  CFRelease(powerInfo);
-
-  for (int i = 0; i < numSources; ++i) {
-    batteries.emplace_back(i);
-  }
-
   return batteries;
 }
 
 }  // namespace hwinfo
 
-#endif
\ No newline at end of file
+#endif
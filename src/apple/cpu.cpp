@@ -5,12 +5,15 @@
 
 #ifdef HWINFO_APPLE
 
+#include <IOKit/IOKitLib.h>
 #include <mach/mach.h>
 #include <mach/mach_time.h>
 #include <sys/sysctl.h>
 
 #include <algorithm>
+#include <cstring>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "hwinfo/cpu.h"
@@ -19,6 +22,80 @@
 
 namespace hwinfo {
 
+namespace {
+
+// A sysctl whose name is resolved to its MIB once with sysctlnametomib, reads skip the name lookup of sysctlbyname.
+class Sysctl {
+ public:
+  explicit Sysctl(const char* name) {
+    if (sysctlnametomib(name, _mib, &_length) != 0) _length = 0;
+  }
+
+  // @return false if the sysctl does not exist or its value does not fit into size bytes, size is set to its size
+  bool read(void* value, size_t& size) const {
+    return _length > 0 && sysctl(const_cast<int*>(_mib), static_cast<u_int>(_length), value, &size, nullptr, 0) == 0;
+  }
+
+  // integer sysctls are 32 or 64 bit wide
+  HWI_NODISCARD int64_t readInt(int64_t fallback = -1) const {
+    int64_t value = 0;
+    size_t size = sizeof(value);
+    if (!read(&value, size)) {
+      return fallback;
+    }
+    if (size == sizeof(int32_t)) {
+      int32_t value32 = 0;
+      std::memcpy(&value32, &value, sizeof(value32));
+      return value32;
+    }
+    return size == sizeof(int64_t) ? value : fallback;
+  }
+
+  HWI_NODISCARD std::string readString() const {
+    char buffer[256];
+    size_t size = sizeof(buffer);
+    if (!read(buffer, size) || size == 0) {
+      return {};
+    }
+    return std::string(buffer, strnlen(buffer, size));
+  }
+
+ private:
+  int _mib[CTL_MAXNAME]{};
+  size_t _length{CTL_MAXNAME};
+};
+
+/**
+ * The core classes of Apple silicon from hw.nperflevels and hw.perflevel<N>.* (macOS 12+), level 0 are the
+ * performance cores. Empty on Intel Macs and older systems. Read once, the values do not change at runtime.
+ */
+const std::vector<CpuTopology::PerformanceLevel>& perfLevels() {
+  static const std::vector<CpuTopology::PerformanceLevel> levels = [] {
+    std::vector<CpuTopology::PerformanceLevel> result;
+    const int64_t num_levels = Sysctl("hw.nperflevels").readInt(0);
+    for (int64_t i = 0; i < num_levels; ++i) {
+      const std::string prefix = "hw.perflevel" + std::to_string(i) + ".";
+      const auto get = [&prefix](const char* name) { return Sysctl((prefix + name).c_str()).readInt(-1); };
+      CpuTopology::PerformanceLevel level;
+      level.name = Sysctl((prefix + "name").c_str()).readString();
+      level.num_physical_cores = static_cast<int>(get("physicalcpu"));
+      level.num_logical_cores = static_cast<int>(get("logicalcpu"));
+      level.L1_instruction_cache_size_Bytes = get("l1icachesize");
+      level.L1_data_cache_size_Bytes = get("l1dcachesize");
+      level.L2_cache_size_Bytes = get("l2cachesize");
+      level.cpus_per_L2 = static_cast<int>(get("cpusperl2"));
+      if (level.num_physical_cores <= 0 || level.num_logical_cores <= 0) {
+        return std::vector<CpuTopology::PerformanceLevel>();
+      }
+      result.push_back(std::move(level));
+    }
+    return result;
+  }();
+  return levels;
+}
+
+}  // namespace
+
 // _____________________________________________________________________________________________________________________
 int64_t getMaxClockSpeed_MHz(const int& core_id) {
   // TODO
@@ -37,6 +114,9 @@ int64_t getMinClockSpeed_MHz(const int& core_id) {
   return -1;
 }
 
+// _____________________________________________________________________________________________________________________
+CPU::ClockSpeeds CPU::readClockSpeeds() const { return {getMaxClockSpeed_MHz(0), getRegularClockSpeed_MHz(0)}; }
+
 // _____________________________________________________________________________________________________________________
 std::vector<int64_t> CPU::currentClockSpeed_MHz() const {
   // TODO: implement
@@ -60,23 +140,210 @@ std::string getVendor() {
 #endif
 }
 
+int getNumLogicalCores();
+
+// _____________________________________________________________________________________________________________________
+FrequencySampler::FrequencySampler() { _last.resize(std::max(getNumLogicalCores(), 0)); }
+
+// _____________________________________________________________________________________________________________________
+FrequencySampler::~FrequencySampler() = default;
+
+// _____________________________________________________________________________________________________________________
+size_t FrequencySampler::sample(int64_t* out_MHz, size_t size) {
+  // TODO: macOS only exposes per-CPU frequencies through IOReport (powermetrics), which is private API
+  std::fill(out_MHz, out_MHz + std::min(size, _last.size()), -1);
+  return _last.size();
+}
+
+namespace {
+
+// parameter block of the AppleSMC user client (AppleSMC.kext, SMCParamStruct)
+struct SMCParam {
+  uint32_t key;
+  struct {
+    char major, minor, build, reserved;
+    uint16_t release;
+  } version;
+  struct {
+    uint16_t version, length;
+    uint32_t cpu_limit, gpu_limit, mem_limit;
+  } limit;
+  struct {
+    uint32_t size;
+    uint32_t type;
+    char attributes;
+  } info;
+  char result;
+  char status;
+  char command;
+  uint32_t data32;
+  uint8_t bytes[32];
+};
+
+constexpr uint32_t smc_handle_event = 2;
+constexpr char smc_read_bytes = 5;
+constexpr char smc_read_key_info = 9;
+
+constexpr uint32_t fourcc(const char* key) {
+  return (static_cast<uint32_t>(key[0]) << 24) | (static_cast<uint32_t>(key[1]) << 16) |
+         (static_cast<uint32_t>(key[2]) << 8) | static_cast<uint32_t>(key[3]);
+}
+
+bool smcCall(io_connect_t connection, SMCParam& param) {
+  size_t size = sizeof(SMCParam);
+  SMCParam out{};
+  const kern_return_t result =
+      IOConnectCallStructMethod(connection, smc_handle_event, &param, sizeof(SMCParam), &out, &size);
+  if (result != kIOReturnSuccess || out.result != 0) {
+    return false;
+  }
+  param = out;
+  return true;
+}
+
+// reads a temperature key of type sp78 (signed fixed point 7.8, big endian) or flt (float, Apple silicon)
+bool readSMCTemperature(io_connect_t connection, uint32_t key, double& value) {
+  SMCParam param{};
+  param.key = key;
+  param.command = smc_read_key_info;
+  if (!smcCall(connection, param)) {
+    return false;
+  }
+  const uint32_t type = param.info.type;
+  const uint32_t size = param.info.size;
+  SMCParam read{};
+  read.key = key;
+  read.info.size = size;
+  read.command = smc_read_bytes;
+  if (!smcCall(connection, read)) {
+    return false;
+  }
+  if (type == fourcc("sp78") && size == 2) {
+    value = static_cast<int16_t>((read.bytes[0] << 8) | read.bytes[1]) / 256.0;
+    return true;
+  }
+  if (type == fourcc("flt ") && size == 4) {
+    float f;
+    std::memcpy(&f, read.bytes, sizeof(f));
+    value = f;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+CpuSensors::CpuSensors() {
+  // kIOMasterPortDefault/kIOMainPortDefault is 0
+  const io_service_t service = IOServiceGetMatchingService(0, IOServiceMatching("AppleSMC"));
+  if (service == IO_OBJECT_NULL) {
+    return;
+  }
+  io_connect_t connection = IO_OBJECT_NULL;
+  const kern_return_t result = IOServiceOpen(service, mach_task_self(), 0, &connection);
+  IOObjectRelease(service);
+  if (result != kIOReturnSuccess) {
+    return;
+  }
+  _handle = connection;
+  // Intel: CPU die and proximity, Apple silicon: performance core clusters. The first key that reads is used.
+  for (const char* key : {"TC0D", "TC0E", "TC0F", "TC0P", "Tp09", "Tp0T", "Tp01", "Tp05"}) {
+    double value = 0;
+    if (readSMCTemperature(connection, fourcc(key), value) && value > 0) {
+      _packages.emplace_back();
+      _packages.back().temperature_key = fourcc(key);
+      break;
+    }
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+CpuSensors::~CpuSensors() {
+  if (_handle != 0) IOServiceClose(static_cast<io_connect_t>(_handle));
+}
+
+// _____________________________________________________________________________________________________________________
+double CpuSensors::packageTemperature_Celsius(int package) const {
+  if (package < 0 || static_cast<size_t>(package) >= _packages.size()) {
+    return -1.0;
+  }
+  double value = -1.0;
+  if (!readSMCTemperature(static_cast<io_connect_t>(_handle), _packages[package].temperature_key, value)) {
+    return -1.0;
+  }
+  return value;
+}
+
+// _____________________________________________________________________________________________________________________
+double CpuSensors::packagePower_W(int package) {
+  // TODO: package power is only available through IOReport (private) or the Intel-only PCPC SMC key
+  return -1.0;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<Jiffies> CpuSampler::snapshot() {
+  natural_t num_cpus = 0;
+  processor_info_array_t info = nullptr;
+  mach_msg_type_number_t info_count = 0;
+  if (host_processor_info(mach_host_self(), PROCESSOR_CPU_LOAD_INFO, &num_cpus, &info, &info_count) != KERN_SUCCESS) {
+    return {};
+  }
+  std::vector<Jiffies> jiffies(num_cpus + 1, Jiffies(0, 0));
+  for (natural_t i = 0; i < num_cpus; ++i) {
+    const integer_t* ticks = &info[CPU_STATE_MAX * i];
+    const int64_t working =
+        static_cast<int64_t>(ticks[CPU_STATE_USER]) + ticks[CPU_STATE_SYSTEM] + ticks[CPU_STATE_NICE];
+    const int64_t all = working + ticks[CPU_STATE_IDLE];
+    jiffies[i + 1] = Jiffies(all, working);
+    jiffies[0].all += all;
+    jiffies[0].working += working;
+  }
+  vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(info), info_count * sizeof(integer_t));
+  return jiffies;
+}
+
 // _____________________________________________________________________________________________________________________
 double CPU::currentUtilisation() const {
-  // TODO: implement
-  return -1;
+  auto current = CpuSampler::snapshot();
+  if (current.empty()) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  _baseline.jiffies.resize(current.size());
+  const double utilisation = current[0].utilisation_since(_baseline.jiffies[0]);
+  _baseline.jiffies[0] = current[0];
+  return utilisation;
 }
 
 // _____________________________________________________________________________________________________________________
 double CPU::threadUtilisation(int thread_index) const {
-  // TODO: implement
-  return -1;
+  auto current = CpuSampler::snapshot();
+  if (thread_index < 0 || static_cast<size_t>(thread_index) + 1 >= current.size()) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  _baseline.jiffies.resize(current.size());
+  const double utilisation = current[thread_index + 1].utilisation_since(_baseline.jiffies[thread_index + 1]);
+  _baseline.jiffies[thread_index + 1] = current[thread_index + 1];
+  return utilisation;
 }
 
 // _____________________________________________________________________________________________________________________
 std::vector<double> CPU::threadsUtilisation() const {
-  std::vector<double> thread_utiliy;
-  // TODO: implement
-  return thread_utiliy;
+  auto current = CpuSampler::snapshot();
+  std::vector<double> thread_utility;
+  if (current.empty()) {
+    return thread_utility;
+  }
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  _baseline.jiffies.resize(current.size());
+  thread_utility.reserve(current.size() - 1);
+  for (size_t i = 1; i < current.size(); ++i) {
+    thread_utility.push_back(current[i].utilisation_since(_baseline.jiffies[i]));
+    _baseline.jiffies[i] = current[i];
+  }
+  return thread_utility;
 }
 
 // _____________________________________________________________________________________________________________________
@@ -109,21 +376,12 @@ std::string getModelName() {
   }
   return model;
 #else
-  size_t size = 1024;
-  std::string model;
-  model.resize(size);
-  if (sysctlbyname("machdep.cpu.brand_string", static_cast<void*>(const_cast<char*>(model.data())), &size, nullptr,
-                   0) == 0) {
-    model.resize(size);
-    model.pop_back();
-    return model;
-  }
-  return constants::UNKNOWN;
+  static const Sysctl brand_string("machdep.cpu.brand_string");
+  std::string model = brand_string.readString();
+  return model.empty() ? constants::UNKNOWN : model;
 #endif
 }
 
-int getNumLogicalCores();
-
 // _____________________________________________________________________________________________________________________
 int getNumPhysicalCores() {
 #if defined(HWINFO_X86)
@@ -169,12 +427,8 @@ int getNumPhysicalCores() {
   }
   return -1;
 #else
-  int physical = 0;
-  size_t physical_size = sizeof(physical);
-  if (sysctlbyname("hw.physicalcpu", &physical, &physical_size, nullptr, 0) != 0) {
-    return -1;
-  }
-  return physical;
+  static const Sysctl physical("hw.physicalcpu");
+  return static_cast<int>(physical.readInt(-1));
 #endif
 }
 
@@ -206,12 +460,8 @@ int getNumLogicalCores() {
   }
   return -1;
 #else
-  int logical = 0;
-  size_t logical_size = sizeof(logical);
-  if (sysctlbyname("hw.logicalcpu", &logical, &logical_size, nullptr, 0) != 0) {
-    return -1;
-  }
-  return logical;
+  static const Sysctl logical("hw.logicalcpu");
+  return static_cast<int>(logical.readInt(-1));
 #endif
 }
 
@@ -224,14 +474,155 @@ std::vector<CPU> getAllCPUs() {
   cpu._modelName = getModelName();
   cpu._numPhysicalCores = getNumPhysicalCores();
   cpu._numLogicalCores = getNumLogicalCores();
-  cpu._maxClockSpeed_MHz = getMaxClockSpeed_MHz(0);
-  cpu._regularClockSpeed_MHz = getRegularClockSpeed_MHz(0);
+  for (const auto& cache : getCacheHierarchy()) {
+    if (cache.shared_cpus.empty() || cache.shared_cpus.front() != 0) continue;
+    if (cache.level == 1 && cache.type == CacheInfo::Type::Data) cpu._L1CacheSize_Bytes = cache.size_Bytes;
+    if (cache.level == 2) cpu._L2CacheSize_Bytes = cache.size_Bytes;
+    if (cache.level == 3) cpu._L3CacheSize_Bytes = cache.size_Bytes;
+  }
 
   cpus.push_back(cpu);
 
   return cpus;
 }
 
+// _____________________________________________________________________________________________________________________
+CpuBudget getEffectiveCpuBudget() {
+  // macOS has neither affinity masks nor CPU quotas for processes
+  CpuBudget budget;
+  const int online = getNumLogicalCores();
+  for (int cpu = 0; cpu < online; ++cpu) {
+    budget.allowed_cpus.push_back(cpu);
+  }
+  budget.effective_cpus = std::max(online, 1);
+  return budget;
+}
+
+// _____________________________________________________________________________________________________________________
+CpuTopology getCpuTopology() {
+  // macOS only reports counts: assume a single package and NUMA node and consecutive CPU numbers per core. On Apple
+  // silicon the CPUs are numbered by performance level starting with the slowest one (the efficiency cores first),
+  // every group of CPUs sharing an L2 cache is a cluster.
+  CpuTopology topology;
+  const int physical = getNumPhysicalCores();
+  const int logical = getNumLogicalCores();
+  if (physical <= 0 || logical <= 0) {
+    return topology;
+  }
+  auto levels = perfLevels();
+  if (levels.empty()) {
+    levels.emplace_back();
+    levels.back().num_physical_cores = physical;
+    levels.back().num_logical_cores = logical;
+  }
+  CpuTopology::Package package;
+  package.id = 0;
+  package.dies.emplace_back();
+  auto& clusters = package.dies.back().clusters;
+  topology.threads.resize(logical);
+  CpuTopology::NumaNode node;
+  node.id = 0;
+  int cpu = 0;
+  int core = 0;
+  for (int level = static_cast<int>(levels.size()) - 1; level >= 0; --level) {
+    const auto& info = levels[level];
+    const int threads_per_core = std::max(info.num_logical_cores / info.num_physical_cores, 1);
+    const int cpus_per_cluster = info.cpus_per_L2 > 0 ? info.cpus_per_L2 : info.num_logical_cores;
+    const int end = std::min(cpu + info.num_logical_cores, logical);
+    for (int first = cpu; cpu < end; ++cpu) {
+      if ((cpu - first) % cpus_per_cluster == 0) {
+        clusters.push_back({static_cast<int>(clusters.size()), {}});
+      }
+      auto& cores = clusters.back().cores;
+      if ((cpu - first) % threads_per_core == 0) {
+        cores.push_back({core++, {}, level});
+      }
+      cores.back().cpus.push_back(cpu);
+      topology.threads[cpu] = {0, 0, clusters.back().id, cores.back().id, 0};
+      node.cpus.push_back(cpu);
+    }
+  }
+  topology.packages.push_back(std::move(package));
+  topology.numa_nodes.push_back(std::move(node));
+  topology.numa_distances = {{10}};
+  topology.performance_levels = std::move(levels);
+  topology.assignPerformanceLevels(static_cast<int>(topology.performance_levels.size()));
+  return topology;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<CacheInfo> getCacheHierarchy() {
+  std::vector<CacheInfo> caches;
+  // hw.cacheconfig[level] is the number of logical CPUs sharing a cache of that level (index 0 is the memory)
+  static const Sysctl cache_config("hw.cacheconfig");
+  static const Sysctl cache_line_size("hw.cachelinesize");
+  static const Sysctl l1d_cache_size("hw.l1dcachesize");
+  static const Sysctl l1i_cache_size("hw.l1icachesize");
+  static const Sysctl l2_cache_size("hw.l2cachesize");
+  static const Sysctl l3_cache_size("hw.l3cachesize");
+  uint64_t sharing[8]{};
+  size_t sharing_size = sizeof(sharing);
+  if (!cache_config.read(sharing, sharing_size)) {
+    return caches;
+  }
+  const int64_t line_size = cache_line_size.readInt(-1);
+  const int logical = getNumLogicalCores();
+
+  // on Apple silicon these are the sizes of the performance cores, CpuTopology::performance_levels has all of them
+  const auto add = [&](const Sysctl& sysctl_size, int level, CacheInfo::Type type) {
+    const int64_t size = sysctl_size.readInt(-1);
+    if (size <= 0 || sharing[level] == 0) {
+      return;
+    }
+    // the sharing CPUs are assumed to be numbered consecutively
+    const int shared = static_cast<int>(sharing[level]);
+    for (int first = 0; first < logical; first += shared) {
+      CacheInfo cache;
+      cache.level = level;
+      cache.type = type;
+      cache.size_Bytes = size;
+      cache.line_size_Bytes = static_cast<int>(line_size > 0 ? line_size : -1);
+      for (int cpu = first; cpu < std::min(first + shared, logical); ++cpu) {
+        cache.shared_cpus.push_back(cpu);
+      }
+      caches.push_back(std::move(cache));
+    }
+  };
+  add(l1d_cache_size, 1, CacheInfo::Type::Data);
+  add(l1i_cache_size, 1, CacheInfo::Type::Instruction);
+  add(l2_cache_size, 2, CacheInfo::Type::Unified);
+  add(l3_cache_size, 3, CacheInfo::Type::Unified);
+  // TODO: associativity is not exposed, cpuid leaf 4 could provide it on x86
+  std::sort(caches.begin(), caches.end());
+  return caches;
+}
+
+#if !defined(HWINFO_X86)
+// _____________________________________________________________________________________________________________________
+CpuFeatures CpuFeatures::detect() {
+  CpuFeatures features;
+  const std::pair<const char*, Feature> sysctls[] = {
+      {"hw.optional.AdvSIMD", Feature::NEON},
+      {"hw.optional.arm.FEAT_FP16", Feature::ARM_FP16},
+      {"hw.optional.arm.FEAT_AES", Feature::ARM_AES},
+      {"hw.optional.arm.FEAT_PMULL", Feature::ARM_PMULL},
+      {"hw.optional.arm.FEAT_SHA1", Feature::ARM_SHA1},
+      {"hw.optional.arm.FEAT_SHA256", Feature::ARM_SHA2},
+      {"hw.optional.armv8_crc32", Feature::ARM_CRC32},
+      {"hw.optional.arm.FEAT_LSE", Feature::ARM_ATOMICS},
+      {"hw.optional.arm.FEAT_DotProd", Feature::ARM_DOTPROD},
+      {"hw.optional.arm.FEAT_I8MM", Feature::ARM_I8MM},
+      {"hw.optional.arm.FEAT_BF16", Feature::ARM_BF16},
+      {"hw.optional.arm.FEAT_SME", Feature::SME}};
+  for (const auto& [name, feature] : sysctls) {
+    int value = 0;
+    size_t size = sizeof(value);
+    if (sysctlbyname(name, &value, &size, nullptr, 0) == 0 && value != 0) features.set(feature);
+  }
+  return features;
+}
+#endif  // !HWINFO_X86
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_APPLE
@@ -7,6 +7,7 @@
 #include <CoreFoundation/CoreFoundation.h>
 #include <IOKit/IOBSD.h>
 #include <IOKit/IOKitLib.h>
+#include <IOKit/storage/IOBlockStorageDriver.h>
 #include <IOKit/storage/IOMedia.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
@@ -14,6 +15,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "hwinfo/disk.h"
 #include "hwinfo/utils/constants.h"
@@ -105,61 +107,83 @@ std::string parseBaseDiskName(const std::string& bsdName) {
   return bsdName;
 }
 
+// mounted file systems of one BSD disk (e.g. "disk3"), in getfsstat() order
+struct DiskMounts {
+  std::vector<std::string> mount_points;
+  // free space of the first file system, taken from the statfs data getfsstat() already returned
+  int64_t free_Bytes{-1};
+};
+
 /**
- * Builds a mapping from BSD device names to mount points using getfsstat().
- *
- * For each mounted device (e.g. "/dev/disk3s1s1" -> "/"), we:
- *   1. Strip "/dev/" -> "disk3s1s1".
- *   2. Extract the base disk name (e.g. "disk3").
- *   3. Store "disk3s1s1" -> "/" in mountMap.
- *   4. Also link "disk3" to the same mount point if not already linked.
- *
- * This lets us find a container disk's mount (e.g. "disk3" -> "/").
+ * Groups all mounted file systems by their base disk with one getfsstat() call (e.g. "/dev/disk3s1s1" on "/" is
+ * listed under "disk3"). MNT_NOWAIT returns the cached file system statistics, no file system is queried.
  */
-std::unordered_map<std::string, std::string> getBSDToMountPointMapping() {
-  std::unordered_map<std::string, std::string> mountMap;             // partition -> mount point
-  std::unordered_map<std::string, std::string> baseDiskToPartition;  // diskX -> first found "diskXsY"
+std::unordered_map<std::string, DiskMounts> getDiskMounts() {
+  std::unordered_map<std::string, DiskMounts> mounts;
 
   int mountCount = getfsstat(nullptr, 0, MNT_NOWAIT);
   if (mountCount <= 0) {
-    return mountMap;
+    return mounts;
   }
 
   std::vector<struct statfs> mountInfo(mountCount);
-  if (getfsstat(mountInfo.data(), mountCount * sizeof(struct statfs), MNT_NOWAIT) == -1) {
-    return mountMap;
+  mountCount = getfsstat(mountInfo.data(), static_cast<int>(mountCount * sizeof(struct statfs)), MNT_NOWAIT);
+  if (mountCount <= 0) {
+    return mounts;
   }
 
-  for (const auto& entry : mountInfo) {
-    std::string fullBSDName = entry.f_mntfromname;  // e.g. "/dev/disk3s1s1"
-    std::string mountPath = entry.f_mntonname;      // e.g. "/"
-
-    // Remove the "/dev/" prefix if present
-    if (fullBSDName.rfind("/dev/", 0) == 0) {
-      fullBSDName.erase(0, 5);
+  for (int i = 0; i < mountCount; ++i) {
+    const auto& entry = mountInfo[i];
+    std::string bsdName = entry.f_mntfromname;  // e.g. "/dev/disk3s1s1"
+    if (bsdName.rfind("/dev/", 0) != 0) {
+      // devfs, autofs, network file systems, ...
+      continue;
+    }
+    bsdName.erase(0, 5);
+    auto& disk = mounts[parseBaseDiskName(bsdName)];
+    if (disk.mount_points.empty()) {
+      disk.free_Bytes = static_cast<int64_t>(entry.f_bavail) * static_cast<int64_t>(entry.f_bsize);
     }
+    disk.mount_points.emplace_back(entry.f_mntonname);
+  }
 
-    // Extract the base disk (e.g. "disk3") from e.g. "disk3s1s1"
-    std::string baseDisk = parseBaseDiskName(fullBSDName);
+  return mounts;
+}
 
-    // Store partition -> mount
-    mountMap[fullBSDName] = mountPath;
+/**
+ * Properties of one whole-disk IOMedia service, read with a single IORegistryEntryCreateCFProperties call.
+ */
+struct MediaProperties {
+  std::string bsd_name;
+  std::string name;
+  std::string uuid;
+  int64_t size_Bytes{-1};
+};
+
+std::string dictionaryString(CFDictionaryRef properties, CFStringRef key) {
+  auto value = static_cast<CFStringRef>(CFDictionaryGetValue(properties, key));
+  return value != nullptr && CFGetTypeID(value) == CFStringGetTypeID() ? cf_to_std(value) : constants::UNKNOWN;
+}
 
-    // Link "disk3" to the first partition we see, if not already linked
-    if (baseDiskToPartition.find(baseDisk) == baseDiskToPartition.end()) {
-      baseDiskToPartition[baseDisk] = fullBSDName;
-    }
-  }
+int64_t dictionaryNumber(CFDictionaryRef properties, CFStringRef key) {
+  auto value = static_cast<CFNumberRef>(CFDictionaryGetValue(properties, key));
+  return value != nullptr && CFGetTypeID(value) == CFNumberGetTypeID() ? cf_to_std(value) : -1;
+}
 
-  // Link each base disk "diskX" to the same mount as its first partition "diskXsY"
-  for (const auto& [disk, partition] : baseDiskToPartition) {
-    auto it = mountMap.find(partition);
-    if (it != mountMap.end()) {
-      mountMap[disk] = it->second;
-    }
+bool readMediaProperties(io_registry_entry_t service, MediaProperties& media) {
+  CFMutableDictionaryRef properties = nullptr;
+  if (IORegistryEntryCreateCFProperties(service, &properties, kCFAllocatorDefault, 0) != KERN_SUCCESS ||
+      properties == nullptr) {
+    return false;
   }
-
-  return mountMap;
+  media.bsd_name = dictionaryString(properties, CFSTR(kIOBSDNameKey));
+  media.uuid = dictionaryString(properties, CFSTR(kIOMediaUUIDKey));
+  media.size_Bytes = dictionaryNumber(properties, CFSTR(kIOMediaSizeKey));
+  CFRelease(properties);
+
+  io_name_t name;
+  media.name = IORegistryEntryGetName(service, name) == KERN_SUCCESS ? name : constants::UNKNOWN;
+  return true;
 }
 
 /**
@@ -180,71 +204,127 @@ uint64_t getFreeDiskSpace(const std::string& mountPoint) {
   }
 }
 
-// Retrieves disk information using I/O Kit
-std::vector<Disk> getAllDisks() {
-  std::vector<Disk> disks;
+// _____________________________________________________________________________________________________________________
+Disk::Mounts Disk::resolveMounts() const {
+  // getAllDisks() sets the mounts of the disks it found in the mount table
+  return {};
+}
 
-  // Build a map from BSD devices (diskXsY) and base disks (diskX) to mount points
-  auto mountMap = getBSDToMountPointMapping();
+// _____________________________________________________________________________________________________________________
+bool Disk::refresh() {
+  Mounts& mounts = _mounts.get([this] { return resolveMounts(); });
+  if (mounts.mount_points.empty()) {
+    return false;
+  }
+  const uint64_t free_space = getFreeDiskSpace(mounts.mount_points.front());
+  if (free_space == static_cast<uint64_t>(-1)) {
+    return false;
+  }
+  mounts.free_size_Bytes = static_cast<int64_t>(free_space);
+  return true;
+}
 
+// _____________________________________________________________________________________________________________________
+std::vector<Disk> getAllDisks(DiskFields fields) {
+  // collect the plain properties of all whole disks first and release the registry entries right away
+  std::vector<MediaProperties> media;
   CFMutableDictionaryRef matchingDict = IOServiceMatching(kIOMediaClass);
   CFDictionaryAddValue(matchingDict, CFSTR(kIOMediaWholeKey), kCFBooleanTrue);
-
   io_iterator_t iter;
-  if (IOServiceGetMatchingServices(0, matchingDict, &iter) == KERN_SUCCESS) {
-    int i_disk = 0;
-    while (true) {
-      auto service = IOIteratorNext(iter);
-      if (service == 0) {
-        break;
-      }
-
-      Disk disk;
-      disk._id = i_disk;
+  if (IOServiceGetMatchingServices(hc_IOMasterPortDefault, matchingDict, &iter) != KERN_SUCCESS) {
+    return {};
+  }
+  while (io_object_t service = IOIteratorNext(iter)) {
+    MediaProperties properties;
+    if (readMediaProperties(service, properties)) {
+      media.push_back(std::move(properties));
+    }
+    IOObjectRelease(service);
+  }
+  IOObjectRelease(iter);
 
-      // Retrieve the BSD name (e.g. "disk3")
-      std::string bsdName = getIORegistryProperty<std::string, CFStringRef>(service, CFSTR(kIOBSDNameKey));
+  // mount points and free space are only resolved if requested
+  const bool need_mounts = has_field(fields, DiskFields::Free | DiskFields::Volumes);
+  const auto mounts = need_mounts ? getDiskMounts() : std::unordered_map<std::string, DiskMounts>{};
 
-      // Get disk name
-      char model[128];
-      if (IORegistryEntryGetName(service, model) != KERN_SUCCESS) {
-        disk._model = constants::UNKNOWN;
-      } else {
-        disk._model = model;
+  std::vector<Disk> disks;
+  disks.reserve(media.size());
+  for (size_t i = 0; i < media.size(); ++i) {
+    auto& properties = media[i];
+    Disk disk;
+    disk._id = static_cast<int>(i);
+    disk._model = std::move(properties.name);
+    // Guess vendor based on model
+    if (disk._model.find("APPLE") != std::string::npos || disk._model.find("Apple") != std::string::npos) {
+      disk._vendor = "Apple";
+    } else {
+      disk._vendor = constants::UNKNOWN;
+    }
+    if (has_field(fields, DiskFields::Serial)) {
+      disk._serialNumber = std::move(properties.uuid);
+    }
+    if (has_field(fields, DiskFields::Capacity)) {
+      disk._size_Bytes = properties.size_Bytes;
+    }
+    if (const auto it = mounts.find(properties.bsd_name); it != mounts.end()) {
+      Disk::Mounts disk_mounts;
+      disk_mounts.mount_points = it->second.mount_points;
+      if (has_field(fields, DiskFields::Free)) {
+        disk_mounts.free_size_Bytes = it->second.free_Bytes;
       }
-
-      // Guess vendor based on model
-      if (disk._model.find("APPLE") != std::string::npos || disk._model.find("Apple") != std::string::npos) {
-        disk._vendor = "Apple";
-      } else {
-        disk._vendor = constants::UNKNOWN;
+      if (has_field(fields, DiskFields::Volumes)) {
+        disk_mounts.volumes = it->second.mount_points;
       }
+      disk._mounts.set(std::move(disk_mounts));
+    }
+    disks.push_back(std::move(disk));
+  }
+  return disks;
+}
 
-      disk._serialNumber = getIORegistryProperty<std::string, CFStringRef>(service, CFSTR(kIOMediaUUIDKey));
-
-      disk._size_Bytes = getIORegistryProperty<int64_t, CFNumberRef>(service, CFSTR(kIOMediaSizeKey));
-
-      // If there's no BSD name, we can't look it up in the mount map
-      if (!bsdName.empty()) {
-        // Look up this BSD device in the mountMap
-        if (auto it = mountMap.find(bsdName); it != mountMap.end()) {
-          // Get free space for the found mount point
-          const std::string& mountPoint = it->second;
-          disk._free_size_Bytes = getFreeDiskSpace(mountPoint);
-
-          disk._volumes.push_back(mountPoint);
-        }
+// _____________________________________________________________________________________________________________________
+std::vector<DiskIOSampler::Counters> DiskIOSampler::read_counters() {
+  std::vector<Counters> counters;
+  io_iterator_t iter;
+  if (IOServiceGetMatchingServices(0, IOServiceMatching(kIOBlockStorageDriverClass), &iter) != KERN_SUCCESS) {
+    return counters;
+  }
+  while (io_object_t driver = IOIteratorNext(iter)) {
+    // the whole disk IOMedia below the driver carries the BSD name
+    io_registry_entry_t media = 0;
+    auto statistics = static_cast<CFDictionaryRef>(IORegistryEntryCreateCFProperty(
+        driver, CFSTR(kIOBlockStorageDriverStatisticsKey), kCFAllocatorDefault, 0));
+    if (statistics != nullptr && IORegistryEntryGetChildEntry(driver, kIOServicePlane, &media) == KERN_SUCCESS) {
+      const auto number = [statistics](CFStringRef key) {
+        auto value = static_cast<CFNumberRef>(CFDictionaryGetValue(statistics, key));
+        return value != nullptr ? cf_to_std(value) : int64_t{-1};
+      };
+      Counters device;
+      device.name = getIORegistryProperty<std::string, CFStringRef>(media, CFSTR(kIOBSDNameKey));
+      device.reads = number(CFSTR(kIOBlockStorageDriverStatisticsReadsKey));
+      device.writes = number(CFSTR(kIOBlockStorageDriverStatisticsWritesKey));
+      device.read_Bytes = number(CFSTR(kIOBlockStorageDriverStatisticsBytesReadKey));
+      device.write_Bytes = number(CFSTR(kIOBlockStorageDriverStatisticsBytesWrittenKey));
+      // total times are reported in nanoseconds, there is no busy time counter
+      const int64_t read_time = number(CFSTR(kIOBlockStorageDriverStatisticsTotalReadTimeKey));
+      const int64_t write_time = number(CFSTR(kIOBlockStorageDriverStatisticsTotalWriteTimeKey));
+      device.read_time_ms = read_time >= 0 ? static_cast<double>(read_time) / 1e6 : -1.0;
+      device.write_time_ms = write_time >= 0 ? static_cast<double>(write_time) / 1e6 : -1.0;
+      if (read_time >= 0 && write_time >= 0) {
+        device.weighted_time_ms = device.read_time_ms + device.write_time_ms;
       }
-
-      disks.push_back(std::move(disk));
-
-      IOObjectRelease(service);
-
-      i_disk++;
+      if (!device.name.empty() && device.name != constants::UNKNOWN) {
+        counters.push_back(std::move(device));
+      }
+      IOObjectRelease(media);
     }
-    IOObjectRelease(iter);
+    if (statistics != nullptr) {
+      CFRelease(statistics);
+    }
+    IOObjectRelease(driver);
   }
-  return disks;
+  IOObjectRelease(iter);
+  return counters;
 }
 
 }  // namespace hwinfo
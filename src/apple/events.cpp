@@ -0,0 +1,79 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_APPLE
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/ps/IOPowerSources.h>
+
+#include <atomic>
+#include <vector>
+
+#include "hwinfo/events.h"
+
+namespace hwinfo {
+
+// TODO: disks and monitors via IOServiceAddMatchingNotification (kIOMediaClass, IODisplayConnect), networks via
+//       SCDynamicStore
+struct DeviceWatcher::Backend {
+  CFRunLoopRef run_loop{nullptr};
+  CFRunLoopSourceRef power_source{nullptr};
+  // set by the notification callback during a run of the run loop
+  bool power_source_changed{false};
+  std::atomic<bool> interrupted{false};
+};
+
+// _____________________________________________________________________________________________________________________
+void DeviceWatcher::BackendDeleter::operator()(Backend* backend) const {
+  if (backend->power_source) {
+    CFRunLoopRemoveSource(backend->run_loop, backend->power_source, kCFRunLoopDefaultMode);
+    CFRelease(backend->power_source);
+  }
+  delete backend;
+}
+
+// _____________________________________________________________________________________________________________________
+DeviceWatcher::Backend* DeviceWatcher::open_backend() {
+  auto* backend = new Backend;
+  // the notifications are delivered through the run loop of the watcher thread
+  backend->run_loop = CFRunLoopGetCurrent();
+  backend->power_source = IOPSNotificationCreateRunLoopSource(
+      [](void* context) { static_cast<Backend*>(context)->power_source_changed = true; }, backend);
+  if (!backend->power_source) {
+    delete backend;
+    return nullptr;
+  }
+  CFRunLoopAddSource(backend->run_loop, backend->power_source, kCFRunLoopDefaultMode);
+  return backend;
+}
+
+// _____________________________________________________________________________________________________________________
+bool DeviceWatcher::wait_events(Backend& backend, std::vector<DeviceEvent>& events) {
+  while (!backend.interrupted) {
+    // sleeps until a source fired or CFRunLoopStop() was called from interrupt()
+    const auto result = CFRunLoopRunInMode(kCFRunLoopDefaultMode, 1e10, true);
+    if (result == kCFRunLoopRunFinished) {
+      return false;
+    }
+    if (backend.power_source_changed) {
+      backend.power_source_changed = false;
+      events.push_back({DeviceEvent::Class::PowerSource, DeviceEvent::Action::Change, {}});
+      return true;
+    }
+  }
+  return false;
+}
+
+// _____________________________________________________________________________________________________________________
+void DeviceWatcher::interrupt(Backend& backend) {
+  backend.interrupted = true;
+  // a stop request made while the run loop is not running makes its next run return immediately
+  CFRunLoopStop(backend.run_loop);
+  CFRunLoopWakeUp(backend.run_loop);
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_APPLE
@@ -14,12 +14,26 @@
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
-std::vector<GPU> getAllGPUs() {
+std::vector<GPU> getAllGPUs([[maybe_unused]] bool use_opencl) {
   std::vector<GPU> gpus{};
   // TODO: implement
   return gpus;
 }
 
+// =====================================================================================================================
+struct GPUMonitor::Sources {};
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::SourcesDeleter::operator()(Sources* sources) const { delete sources; }
+
+// _____________________________________________________________________________________________________________________
+GPUMonitor::Sources* GPUMonitor::open_sources(int gpu_id) { return new Sources; }
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::read_sources(Sources& sources, Sample& sample) {
+  // TODO: implement
+}
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_APPLE
\ No newline at end of file
@@ -0,0 +1,23 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_APPLE
+
+#include "hwinfo/interrupts.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+InterruptSampler::~InterruptSampler() = default;
+
+// _____________________________________________________________________________________________________________________
+bool InterruptSampler::read_counters() {
+  // macOS does not expose per-CPU interrupt counters to user space
+  return false;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_APPLE
@@ -6,7 +6,14 @@
 #include "hwinfo/network.h"
 
 namespace hwinfo {
-std::vector<Network> getAllNetworks() {
+// _____________________________________________________________________________________________________________________
+bool Network::refresh(NetworkFields fields) {
+  // TODO: implement
+  return false;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<Network> getAllNetworks(NetworkFields fields) {
   std::vector<Network> networks;
   return networks;
 }
@@ -0,0 +1,25 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_APPLE
+
+#include <vector>
+
+#include "hwinfo/nvme.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+bool NvmeController::readHealth(Health&) const { return false; }
+
+// _____________________________________________________________________________________________________________________
+std::vector<NvmeController> getAllNvmeControllers() {
+  // TODO: the SMART log is exposed by the NVMeSMARTLib IOKit plugin (IONVMeController), the Identify pages are not
+  return {};
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_APPLE
@@ -0,0 +1,32 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_APPLE
+
+#include <string>
+#include <vector>
+
+#include "hwinfo/perf_counters.h"
+
+namespace hwinfo {
+
+struct PerfCounterSampler::Backend {};
+
+// _____________________________________________________________________________________________________________________
+void PerfCounterSampler::BackendDeleter::operator()(Backend* backend) const { delete backend; }
+
+// _____________________________________________________________________________________________________________________
+PerfCounterSampler::Backend* PerfCounterSampler::open_backend(std::string& error) {
+  // TODO: the PMU is only reachable through the private kperf/kpc frameworks, which require root
+  error = "hardware counters are not available on macOS";
+  return nullptr;
+}
+
+// _____________________________________________________________________________________________________________________
+bool PerfCounterSampler::read_counters(Backend&, std::vector<int>&, std::vector<Reading>&) { return false; }
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_APPLE
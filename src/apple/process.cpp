@@ -0,0 +1,103 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_APPLE
+
+#include <mach/mach.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "hwinfo/process.h"
+#include "hwinfo/utils/instrumentation.h"
+
+namespace hwinfo {
+
+namespace {
+
+int64_t toNs(const timeval& time) { return time.tv_sec * 1000000000LL + time.tv_usec * 1000LL; }
+
+// thread id, name and CPU times of one thread port of the task
+bool readThread(thread_act_t port, ProcessStats& thread) {
+  thread_identifier_info_data_t identifier;
+  mach_msg_type_number_t count = THREAD_IDENTIFIER_INFO_COUNT;
+  if (thread_info(port, THREAD_IDENTIFIER_INFO, reinterpret_cast<thread_info_t>(&identifier), &count) != KERN_SUCCESS) {
+    return false;
+  }
+  thread.id = static_cast<int64_t>(identifier.thread_id);
+  thread_extended_info_data_t extended;
+  count = THREAD_EXTENDED_INFO_COUNT;
+  if (thread_info(port, THREAD_EXTENDED_INFO, reinterpret_cast<thread_info_t>(&extended), &count) == KERN_SUCCESS) {
+    thread.name = extended.pth_name;
+    thread.user_time_ns = static_cast<int64_t>(extended.pth_user_time);
+    thread.system_time_ns = static_cast<int64_t>(extended.pth_system_time);
+  }
+  return true;
+}
+
+}  // namespace
+
+// getrusage() and task_info() need no open handles
+struct ProcessSampler::Backend {};
+
+// _____________________________________________________________________________________________________________________
+void ProcessSampler::BackendDeleter::operator()(Backend* backend) const { delete backend; }
+
+// _____________________________________________________________________________________________________________________
+ProcessSampler::Backend* ProcessSampler::open_backend() { return new Backend; }
+
+// _____________________________________________________________________________________________________________________
+bool ProcessSampler::read_counters(Backend&, ProcessStats& process, std::vector<ProcessStats>* threads) {
+  HWINFO_PROBE("process.self");
+  process.id = getpid();
+  process.name = getprogname();
+  bool read = false;
+  rusage usage{};
+  HWINFO_COUNT_SYSCALL();
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    process.user_time_ns = toNs(usage.ru_utime);
+    process.system_time_ns = toNs(usage.ru_stime);
+    process.minor_faults = usage.ru_minflt;
+    process.major_faults = usage.ru_majflt;
+    process.voluntary_context_switches = usage.ru_nvcsw;
+    process.involuntary_context_switches = usage.ru_nivcsw;
+    read = true;
+  }
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  HWINFO_COUNT_SYSCALL();
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) ==
+      KERN_SUCCESS) {
+    process.rss_Bytes = static_cast<int64_t>(info.resident_size);
+    process.peak_rss_Bytes = static_cast<int64_t>(info.resident_size_max);
+    process.virtual_Bytes = static_cast<int64_t>(info.virtual_size);
+    read = true;
+  }
+
+  thread_act_array_t list = nullptr;
+  mach_msg_type_number_t num_threads = 0;
+  HWINFO_COUNT_SYSCALL();
+  if (task_threads(mach_task_self(), &list, &num_threads) != KERN_SUCCESS) {
+    return read;
+  }
+  process.num_threads = num_threads;
+  for (mach_msg_type_number_t i = 0; i < num_threads; ++i) {
+    ProcessStats thread;
+    if (threads != nullptr && readThread(list[i], thread)) {
+      threads->push_back(std::move(thread));
+    }
+    mach_port_deallocate(mach_task_self(), list[i]);
+  }
+  vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(list), num_threads * sizeof(thread_act_t));
+  return read;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_APPLE
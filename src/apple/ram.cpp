@@ -5,9 +5,11 @@
 
 #ifdef HWINFO_APPLE
 
+#include <mach/mach.h>
 #include <sys/sysctl.h>
 
 #include <string>
+#include <utility>
 
 #include "hwinfo/ram.h"
 #include "hwinfo/utils/constants.h"
@@ -27,7 +29,25 @@ int64_t getMemSize() {
 }
 
 // _____________________________________________________________________________________________________________________
-Memory::Memory() {
+int64_t getUsableMemSize() {
+  int64_t usableMemSize;
+  size_t size = sizeof(usableMemSize);
+
+  if (sysctlbyname("hw.memsize_usable", &usableMemSize, &size, nullptr, 0) == 0) {
+    return usableMemSize;
+  }
+
+  return -1;
+}
+
+// _____________________________________________________________________________________________________________________
+Memory::Memory(MemoryFields fields) {
+  if (has_field(fields, MemoryFields::Topology)) {
+    readTopology();
+  }
+  if (!has_field(fields, MemoryFields::Modules)) {
+    return;
+  }
   // TODO: get information for actual memory modules (DIMM)
   Module module;
   module.vendor = constants::UNKNOWN;
@@ -47,17 +67,99 @@ int64_t Memory::free_Bytes() const {
 }
 
 // _____________________________________________________________________________________________________________________
-int64_t Memory::available_Bytes() const {
-  int64_t usableMemSize;
-  size_t size = sizeof(usableMemSize);
+int64_t Memory::available_Bytes() const { return getUsableMemSize(); }
 
-  if (sysctlbyname("hw.memsize_usable", &usableMemSize, &size, nullptr, 0) == 0) {
-    return usableMemSize;
+// _____________________________________________________________________________________________________________________
+MemoryStats Memory::snapshot() {
+  MemoryStats stats;
+  stats.total_Bytes = getMemSize();
+  stats.available_Bytes = getUsableMemSize();
+
+  vm_statistics64_data_t vm_stats;
+  mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+  vm_size_t page_size = 0;
+  if (host_page_size(mach_host_self(), &page_size) == KERN_SUCCESS &&
+      host_statistics64(mach_host_self(), HOST_VM_INFO64, reinterpret_cast<host_info64_t>(&vm_stats), &count) ==
+          KERN_SUCCESS) {
+    stats.free_Bytes = static_cast<int64_t>(vm_stats.free_count) * static_cast<int64_t>(page_size);
+    // file backed pages are what the page cache is on Linux
+    stats.cached_Bytes = static_cast<int64_t>(vm_stats.external_page_count) * static_cast<int64_t>(page_size);
   }
 
-  return -1;
+  xsw_usage swap{};
+  size_t size = sizeof(swap);
+  if (sysctlbyname("vm.swapusage", &swap, &size, nullptr, 0) == 0) {
+    stats.swap_total_Bytes = static_cast<int64_t>(swap.xsu_total);
+    stats.swap_free_Bytes = static_cast<int64_t>(swap.xsu_avail);
+  }
+  return stats;
+}
+
+// _____________________________________________________________________________________________________________________
+bool Memory::refresh() {
+  _free_Bytes = free_Bytes();
+  _available_Bytes = available_Bytes();
+  if (!_topology.nodes.empty()) {
+    refreshNodes();
+  }
+  return _available_Bytes >= 0;
+}
+
+// _____________________________________________________________________________________________________________________
+void Memory::readTopology() {
+  // 16 KiB on Apple silicon. Superpages (VM_FLAGS_SUPERPAGE_SIZE_2MB, x86 only) are not pooled and there is no THP
+  vm_size_t page_size = 0;
+  if (host_page_size(mach_host_self(), &page_size) == KERN_SUCCESS) {
+    _topology.page_size_Bytes = static_cast<int64_t>(page_size);
+  }
+  // macOS has no NUMA, all memory and CPUs belong to node 0
+  MemoryNode node;
+  node.id = 0;
+  int cpus = 0;
+  size_t size = sizeof(cpus);
+  if (sysctlbyname("hw.logicalcpu", &cpus, &size, nullptr, 0) == 0) {
+    for (int cpu = 0; cpu < cpus; ++cpu) {
+      node.cpus.push_back(cpu);
+    }
+  }
+  node.total_Bytes = getMemSize();
+  _topology.nodes.push_back(std::move(node));
+  refreshNodes();
+}
+
+// _____________________________________________________________________________________________________________________
+void Memory::refreshNodes() { _topology.nodes.front().free_Bytes = snapshot().free_Bytes; }
+
+// _____________________________________________________________________________________________________________________
+MemoryLimits Memory::limits() {
+  // TODO: implement
+  return {};
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryPressure Memory::pressure() {
+  // pressure stall information is Linux specific
+  return {};
 }
 
+// _____________________________________________________________________________________________________________________
+MemorySampler::MemorySampler() = default;
+
+// _____________________________________________________________________________________________________________________
+MemorySampler::~MemorySampler() = default;
+
+// _____________________________________________________________________________________________________________________
+MemoryStats MemorySampler::sample() { return Memory::snapshot(); }
+
+// _____________________________________________________________________________________________________________________
+MemoryPressureTrigger::MemoryPressureTrigger(std::chrono::microseconds, std::chrono::microseconds, bool) {}
+
+// _____________________________________________________________________________________________________________________
+MemoryPressureTrigger::~MemoryPressureTrigger() = default;
+
+// _____________________________________________________________________________________________________________________
+bool MemoryPressureTrigger::wait(std::chrono::milliseconds) { return false; }
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_APPLE
\ No newline at end of file
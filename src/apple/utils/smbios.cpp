@@ -0,0 +1,24 @@
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_APPLE
+
+#include <cstdint>
+#include <vector>
+
+#include "hwinfo/utils/smbios.h"
+
+namespace hwinfo {
+namespace utils {
+namespace SMBIOS {
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint8_t> read_table() {
+  // TODO: implement (Intel Macs expose the table as "SMBIOS" property of AppleSMBIOS, Apple silicon has none)
+  return {};
+}
+
+}  // namespace SMBIOS
+}  // namespace utils
+}  // namespace hwinfo
+
+#endif  // HWINFO_APPLE
@@ -0,0 +1,289 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/arena_snapshot.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hwinfo/utils/constants.h"
+
+namespace hwinfo {
+
+namespace {
+
+// Strings that repeat across devices (vendors, models, drivers, flags, ...) are interned, identifiers such as serial
+// numbers and addresses are copied unless they are constants::UNKNOWN.
+class Builder {
+ public:
+  explicit Builder(utils::Arena& arena) : _arena(arena) {}
+
+  std::string_view shared(std::string_view value) { return _arena.intern(value); }
+
+  std::string_view unique(std::string_view value) {
+    return value == constants::UNKNOWN ? _arena.intern(value) : _arena.copy(value);
+  }
+
+  template <typename T, typename Container>
+  utils::Span<std::string_view> list(const Container& values, bool interned) {
+    auto* data = _arena.allocateArray<std::string_view>(values.size());
+    size_t i = 0;
+    for (const T& value : values) {
+      data[i++] = interned ? shared(value) : unique(value);
+    }
+    return {data, values.size()};
+  }
+
+  template <typename Record, typename Container, typename Fill>
+  utils::Span<Record> records(const Container& items, Fill fill) {
+    auto* data = _arena.allocateArray<Record>(items.size());
+    size_t i = 0;
+    for (const auto& item : items) {
+      fill(item, data[i++]);
+    }
+    return {data, items.size()};
+  }
+
+  template <typename Record>
+  Record* single() {
+    return _arena.allocateArray<Record>(1);
+  }
+
+ private:
+  utils::Arena& _arena;
+};
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+ArenaSnapshot::ArenaSnapshot(const Snapshot& snapshot, size_t block_size_Bytes) : _arena(block_size_Bytes) {
+  Builder builder(_arena);
+  _cpus = builder.records<CpuRecord>(snapshot.cpus, [&](const CPU& cpu, CpuRecord& record) {
+    record.id = cpu.id();
+    record.vendor = builder.shared(cpu.vendor());
+    record.model = builder.shared(cpu.modelName());
+    record.num_physical_cores = cpu.numPhysicalCores();
+    record.num_logical_cores = cpu.numLogicalCores();
+    record.max_clock_speed_MHz = cpu.maxClockSpeed_MHz();
+    record.regular_clock_speed_MHz = cpu.regularClockSpeed_MHz();
+    record.L1_cache_size_Bytes = cpu.L1CacheSize_Bytes();
+    record.L2_cache_size_Bytes = cpu.L2CacheSize_Bytes();
+    record.L3_cache_size_Bytes = cpu.L3CacheSize_Bytes();
+    record.flags = builder.list<std::string>(cpu.flags(), true);
+  });
+  if (snapshot.os) {
+    auto* record = builder.single<OsRecord>();
+    record->name = builder.shared(snapshot.os->name());
+    record->version = builder.shared(snapshot.os->version());
+    record->kernel = builder.shared(snapshot.os->kernel());
+    record->is_64bit = snapshot.os->is64bit();
+    record->little_endian = snapshot.os->isLittleEndian();
+    _os = record;
+  }
+  _gpus = builder.records<GpuRecord>(snapshot.gpus, [&](const GPU& gpu, GpuRecord& record) {
+    record.id = gpu.id();
+    record.vendor = builder.shared(gpu.vendor());
+    record.name = builder.shared(gpu.name());
+    record.driver_version = builder.shared(gpu.driverVersion());
+    record.memory_Bytes = gpu.memory_Bytes();
+    record.frequency_MHz = gpu.frequency_MHz();
+    record.num_cores = gpu.num_cores();
+    record.vendor_id = builder.shared(gpu.vendor_id());
+    record.device_id = builder.shared(gpu.device_id());
+    record.pci_bus_id = builder.unique(gpu.pci_bus_id());
+  });
+  if (snapshot.ram) {
+    auto* record = builder.single<MemoryRecord>();
+    record->total_Bytes = snapshot.ram->total_Bytes();
+    record->modules = builder.records<MemoryModuleRecord>(
+        snapshot.ram->modules(), [&](const Memory::Module& module, MemoryModuleRecord& entry) {
+          entry.id = module.id;
+          entry.vendor = builder.shared(module.vendor);
+          entry.name = builder.shared(module.name);
+          entry.model = builder.shared(module.model);
+          entry.serial_number = builder.unique(module.serial_number);
+          entry.total_Bytes = module.total_Bytes;
+          entry.frequency_Hz = module.frequency_Hz;
+        });
+    _ram = record;
+  }
+  if (snapshot.mainboard) {
+    auto* record = builder.single<MainBoardRecord>();
+    record->vendor = builder.shared(snapshot.mainboard->vendor());
+    record->name = builder.shared(snapshot.mainboard->name());
+    record->version = builder.shared(snapshot.mainboard->version());
+    record->serial_number = builder.unique(snapshot.mainboard->serialNumber());
+    _mainboard = record;
+  }
+  _batteries = builder.records<BatteryRecord>(snapshot.batteries, [&](const Battery& battery, BatteryRecord& record) {
+    record.vendor = builder.shared(battery.getVendor());
+    record.model = builder.shared(battery.getModel());
+    record.serial_number = builder.unique(battery.getSerialNumber());
+    record.technology = builder.shared(battery.getTechnology());
+    record.energy_full = battery.getEnergyFull();
+  });
+  _disks = builder.records<DiskRecord>(snapshot.disks, [&](const Disk& disk, DiskRecord& record) {
+    record.id = disk.id();
+    record.vendor = builder.shared(disk.vendor());
+    record.model = builder.shared(disk.model());
+    record.serial_number = builder.unique(disk.serialNumber());
+    record.size_Bytes = disk.size_Bytes();
+    record.volumes = builder.list<std::string>(disk.volumes(), false);
+  });
+  _networks = builder.records<NetworkRecord>(snapshot.networks, [&](const Network& network, NetworkRecord& record) {
+    record.interface_index = builder.unique(network.interfaceIndex());
+    record.description = builder.unique(network.description());
+    record.mac = builder.unique(network.mac());
+    record.ip4 = builder.unique(network.ip4());
+    record.ip6_addresses = builder.list<std::string>(network.ip6Addresses(), false);
+    record.type = builder.shared(network.type());
+    record.mtu = network.mtu();
+    record.link_speed_Mbps = network.linkSpeed_Mbps();
+  });
+  _monitors = builder.records<MonitorRecord>(snapshot.monitors, [&](const Monitor& monitor, MonitorRecord& record) {
+    record.vendor = builder.shared(monitor.vendor());
+    record.model = builder.shared(monitor.model());
+    record.resolution = builder.shared(monitor.resolution());
+    record.refresh_rate = builder.shared(monitor.refreshRate());
+    record.serial_number = builder.unique(monitor.serialNumber());
+  });
+  _pci_devices =
+      builder.records<PciRecord>(snapshot.pci_devices, [&](const PCIBusDevice& device, PciRecord& record) {
+        record.address = builder.unique(device.address());
+        record.vendor_id = device.vendor_id();
+        record.device_id = device.device_id();
+        record.subvendor_id = device.subvendor_id();
+        record.subdevice_id = device.subdevice_id();
+        record.class_code = device.class_code();
+        record.vendor = builder.shared(device.vendor());
+        record.name = builder.shared(device.name());
+        record.subsystem = builder.shared(device.subsystem());
+        record.driver = builder.shared(device.driver());
+        record.numa_node = device.numa_node();
+        record.link_speed = builder.shared(device.link_speed());
+        record.link_width = device.link_width();
+      });
+}
+
+// _____________________________________________________________________________________________________________________
+ArenaSnapshot::ArenaSnapshot(const SnapshotView& view, size_t block_size_Bytes) : _arena(block_size_Bytes) {
+  if (!view.valid()) {
+    return;
+  }
+  Builder builder(_arena);
+  _cpus = builder.records<CpuRecord>(view.records(SnapshotSection::Cpu), [&](const RecordView& in, CpuRecord& record) {
+    record.id = static_cast<int>(in.integer(CpuField::Id));
+    record.vendor = builder.shared(in.string(CpuField::Vendor));
+    record.model = builder.shared(in.string(CpuField::Model));
+    record.num_physical_cores = static_cast<int>(in.integer(CpuField::NumPhysicalCores));
+    record.num_logical_cores = static_cast<int>(in.integer(CpuField::NumLogicalCores));
+    record.max_clock_speed_MHz = in.integer(CpuField::MaxClockSpeed_MHz);
+    record.regular_clock_speed_MHz = in.integer(CpuField::RegularClockSpeed_MHz);
+    record.L1_cache_size_Bytes = in.integer(CpuField::L1CacheSize_Bytes);
+    record.L2_cache_size_Bytes = in.integer(CpuField::L2CacheSize_Bytes);
+    record.L3_cache_size_Bytes = in.integer(CpuField::L3CacheSize_Bytes);
+    record.flags = builder.list<std::string_view>(in.strings(CpuField::Flag), true);
+  });
+  for (const auto& in : view.records(SnapshotSection::Os)) {
+    auto* record = builder.single<OsRecord>();
+    record->name = builder.shared(in.string(OsField::Name));
+    record->version = builder.shared(in.string(OsField::Version));
+    record->kernel = builder.shared(in.string(OsField::Kernel));
+    record->is_64bit = in.integer(OsField::Bits) == 64;
+    record->little_endian = in.integer(OsField::LittleEndian) == 1;
+    _os = record;
+  }
+  _gpus = builder.records<GpuRecord>(view.records(SnapshotSection::Gpu), [&](const RecordView& in, GpuRecord& record) {
+    record.id = static_cast<int>(in.integer(GpuField::Id));
+    record.vendor = builder.shared(in.string(GpuField::Vendor));
+    record.name = builder.shared(in.string(GpuField::Name));
+    record.driver_version = builder.shared(in.string(GpuField::DriverVersion));
+    record.memory_Bytes = in.integer(GpuField::Memory_Bytes);
+    record.frequency_MHz = in.integer(GpuField::Frequency_MHz);
+    record.num_cores = static_cast<int>(in.integer(GpuField::NumCores));
+    record.vendor_id = builder.shared(in.string(GpuField::VendorId));
+    record.device_id = builder.shared(in.string(GpuField::DeviceId));
+    record.pci_bus_id = builder.unique(in.string(GpuField::PciBusId));
+  });
+  for (const auto& in : view.records(SnapshotSection::Memory)) {
+    auto* record = builder.single<MemoryRecord>();
+    record->total_Bytes = in.integer(MemoryField::Total_Bytes);
+    record->modules = builder.records<MemoryModuleRecord>(
+        view.records(SnapshotSection::MemoryModule), [&](const RecordView& module, MemoryModuleRecord& entry) {
+          entry.id = static_cast<int>(module.integer(MemoryModuleField::Id));
+          entry.vendor = builder.shared(module.string(MemoryModuleField::Vendor));
+          entry.name = builder.shared(module.string(MemoryModuleField::Name));
+          entry.model = builder.shared(module.string(MemoryModuleField::Model));
+          entry.serial_number = builder.unique(module.string(MemoryModuleField::SerialNumber));
+          entry.total_Bytes = module.integer(MemoryModuleField::Total_Bytes);
+          entry.frequency_Hz = module.integer(MemoryModuleField::Frequency_Hz);
+        });
+    _ram = record;
+  }
+  for (const auto& in : view.records(SnapshotSection::MainBoard)) {
+    auto* record = builder.single<MainBoardRecord>();
+    record->vendor = builder.shared(in.string(MainBoardField::Vendor));
+    record->name = builder.shared(in.string(MainBoardField::Name));
+    record->version = builder.shared(in.string(MainBoardField::Version));
+    record->serial_number = builder.unique(in.string(MainBoardField::SerialNumber));
+    _mainboard = record;
+  }
+  _batteries = builder.records<BatteryRecord>(
+      view.records(SnapshotSection::Battery), [&](const RecordView& in, BatteryRecord& record) {
+        record.vendor = builder.shared(in.string(BatteryField::Vendor));
+        record.model = builder.shared(in.string(BatteryField::Model));
+        record.serial_number = builder.unique(in.string(BatteryField::SerialNumber));
+        record.technology = builder.shared(in.string(BatteryField::Technology));
+        record.energy_full = in.integer(BatteryField::EnergyFull);
+      });
+  _disks = builder.records<DiskRecord>(
+      view.records(SnapshotSection::Disk), [&](const RecordView& in, DiskRecord& record) {
+        record.id = static_cast<int>(in.integer(DiskField::Id));
+        record.vendor = builder.shared(in.string(DiskField::Vendor));
+        record.model = builder.shared(in.string(DiskField::Model));
+        record.serial_number = builder.unique(in.string(DiskField::SerialNumber));
+        record.size_Bytes = in.integer(DiskField::Size_Bytes);
+        record.volumes = builder.list<std::string_view>(in.strings(DiskField::Volume), false);
+      });
+  _networks = builder.records<NetworkRecord>(
+      view.records(SnapshotSection::Network), [&](const RecordView& in, NetworkRecord& record) {
+        record.interface_index = builder.unique(in.string(NetworkField::InterfaceIndex));
+        record.description = builder.unique(in.string(NetworkField::Description));
+        record.mac = builder.unique(in.string(NetworkField::Mac));
+        record.ip4 = builder.unique(in.string(NetworkField::IP4));
+        record.ip6_addresses = builder.list<std::string_view>(in.strings(NetworkField::IP6), false);
+        record.type = builder.shared(in.string(NetworkField::Type));
+        record.mtu = static_cast<int>(in.integer(NetworkField::Mtu));
+        record.link_speed_Mbps = in.integer(NetworkField::LinkSpeed_Mbps);
+      });
+  _monitors = builder.records<MonitorRecord>(
+      view.records(SnapshotSection::Monitor), [&](const RecordView& in, MonitorRecord& record) {
+        record.vendor = builder.shared(in.string(MonitorField::Vendor));
+        record.model = builder.shared(in.string(MonitorField::Model));
+        record.resolution = builder.shared(in.string(MonitorField::Resolution));
+        record.refresh_rate = builder.shared(in.string(MonitorField::RefreshRate));
+        record.serial_number = builder.unique(in.string(MonitorField::SerialNumber));
+      });
+  _pci_devices =
+      builder.records<PciRecord>(view.records(SnapshotSection::Pci), [&](const RecordView& in, PciRecord& record) {
+        record.address = builder.unique(in.string(PciField::Address));
+        record.vendor_id = static_cast<uint16_t>(in.integer(PciField::VendorId, 0));
+        record.device_id = static_cast<uint16_t>(in.integer(PciField::DeviceId, 0));
+        record.subvendor_id = static_cast<uint16_t>(in.integer(PciField::SubvendorId, 0));
+        record.subdevice_id = static_cast<uint16_t>(in.integer(PciField::SubdeviceId, 0));
+        record.class_code = static_cast<uint32_t>(in.integer(PciField::ClassCode, 0));
+        record.vendor = builder.shared(in.string(PciField::Vendor));
+        record.name = builder.shared(in.string(PciField::Name));
+        record.subsystem = builder.shared(in.string(PciField::Subsystem));
+        record.driver = builder.shared(in.string(PciField::Driver));
+        record.numa_node = static_cast<int>(in.integer(PciField::NumaNode));
+        record.link_speed = builder.shared(in.string(PciField::LinkSpeed));
+        record.link_width = static_cast<int>(in.integer(PciField::LinkWidth));
+      });
+}
+
+// _____________________________________________________________________________________________________________________
+ArenaSnapshot collectArena(const Options& options) { return ArenaSnapshot(collect(options)); }
+
+}  // namespace hwinfo
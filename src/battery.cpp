@@ -52,4 +52,13 @@ uint32_t Battery::energyFull() {
 // _____________________________________________________________________________________________________________________
 double Battery::capacity() { return static_cast<double>(energyNow()) / energyFull(); }
 
+// _____________________________________________________________________________________________________________________
+uint32_t Battery::lastEnergyNow() const { return _energyNow; }
+
+// _____________________________________________________________________________________________________________________
+bool Battery::lastCharging() const { return _charging; }
+
+// _____________________________________________________________________________________________________________________
+double Battery::lastPower_W() const { return _power_W; }
+
 }  // namespace hwinfo
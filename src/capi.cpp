@@ -0,0 +1,332 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/capi.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hwinfo/snapshot.h"
+#include "hwinfo/utils/arena.h"
+
+struct hwinfo_snapshot {
+  // every string is followed by a null character
+  std::string strings;
+  std::vector<hwinfo_str> list_items;
+  std::vector<hwinfo_cpu> cpus;
+  hwinfo_os os{};
+  bool has_os{false};
+  std::vector<hwinfo_gpu> gpus;
+  hwinfo_memory memory{};
+  bool has_memory{false};
+  std::vector<hwinfo_memory_module> memory_modules;
+  hwinfo_mainboard mainboard{};
+  bool has_mainboard{false};
+  std::vector<hwinfo_battery> batteries;
+  std::vector<hwinfo_disk> disks;
+  std::vector<hwinfo_network> networks;
+  std::vector<hwinfo_monitor> monitors;
+  std::vector<hwinfo_pci_device> pci_devices;
+};
+
+namespace hwinfo {
+
+namespace {
+
+// Appends the strings of a Snapshot to the buffer of a hwinfo_snapshot. Equal strings (vendors, UNKNOWN, flags, ...)
+// are stored once: the arena interns them, so equal strings share one address that maps to their offset. Some getters
+// return temporaries, their views can not be used as keys.
+class Builder {
+ public:
+  explicit Builder(hwinfo_snapshot& target) : _target(target) {}
+
+  hwinfo_str string(std::string_view value) {
+    const std::string_view interned = _interned.intern(value);
+    const auto it = _offsets.find(interned.data());
+    if (it != _offsets.end()) {
+      return it->second;
+    }
+    const hwinfo_str result{static_cast<uint32_t>(_target.strings.size()), static_cast<uint32_t>(value.size())};
+    _target.strings.append(value);
+    _target.strings.push_back('\0');
+    _offsets.emplace(interned.data(), result);
+    return result;
+  }
+
+  template <typename Container>
+  hwinfo_list list(const Container& values) {
+    const hwinfo_list result{static_cast<uint32_t>(_target.list_items.size()), static_cast<uint32_t>(values.size())};
+    for (const auto& value : values) {
+      _target.list_items.push_back(string(value));
+    }
+    return result;
+  }
+
+ private:
+  hwinfo_snapshot& _target;
+  utils::Arena _interned;
+  std::unordered_map<const char*, hwinfo_str> _offsets;
+};
+
+Options toOptions(uint32_t subsystems, uint32_t num_threads) {
+  Options options;
+  options.cpu = (subsystems & HWINFO_SUBSYSTEM_CPU) != 0;
+  options.os = (subsystems & HWINFO_SUBSYSTEM_OS) != 0;
+  options.gpu = (subsystems & HWINFO_SUBSYSTEM_GPU) != 0;
+  options.ram = (subsystems & HWINFO_SUBSYSTEM_RAM) != 0;
+  options.mainboard = (subsystems & HWINFO_SUBSYSTEM_MAINBOARD) != 0;
+  options.battery = (subsystems & HWINFO_SUBSYSTEM_BATTERY) != 0;
+  options.disk = (subsystems & HWINFO_SUBSYSTEM_DISK) != 0;
+  options.network = (subsystems & HWINFO_SUBSYSTEM_NETWORK) != 0;
+  options.monitor = (subsystems & HWINFO_SUBSYSTEM_MONITOR) != 0;
+  options.pci = (subsystems & HWINFO_SUBSYSTEM_PCI) != 0;
+  options.num_threads = num_threads;
+  return options;
+}
+
+void flatten(const Snapshot& snapshot, hwinfo_snapshot& out) {
+  Builder builder(out);
+  out.cpus.reserve(snapshot.cpus.size());
+  for (const CPU& cpu : snapshot.cpus) {
+    hwinfo_cpu record{};
+    record.id = cpu.id();
+    record.num_physical_cores = cpu.numPhysicalCores();
+    record.num_logical_cores = cpu.numLogicalCores();
+    record.max_clock_speed_MHz = cpu.maxClockSpeed_MHz();
+    record.regular_clock_speed_MHz = cpu.regularClockSpeed_MHz();
+    record.L1_cache_size_Bytes = cpu.L1CacheSize_Bytes();
+    record.L2_cache_size_Bytes = cpu.L2CacheSize_Bytes();
+    record.L3_cache_size_Bytes = cpu.L3CacheSize_Bytes();
+    record.vendor = builder.string(cpu.vendor());
+    record.model = builder.string(cpu.modelName());
+    record.flags = builder.list(cpu.flags());
+    out.cpus.push_back(record);
+  }
+  if (snapshot.os) {
+    out.os.name = builder.string(snapshot.os->name());
+    out.os.version = builder.string(snapshot.os->version());
+    out.os.kernel = builder.string(snapshot.os->kernel());
+    out.os.is_64bit = snapshot.os->is64bit() ? 1 : 0;
+    out.os.little_endian = snapshot.os->isLittleEndian() ? 1 : 0;
+    out.has_os = true;
+  }
+  out.gpus.reserve(snapshot.gpus.size());
+  for (const GPU& gpu : snapshot.gpus) {
+    hwinfo_gpu record{};
+    record.id = gpu.id();
+    record.num_cores = gpu.num_cores();
+    record.memory_Bytes = gpu.memory_Bytes();
+    record.frequency_MHz = gpu.frequency_MHz();
+    record.vendor = builder.string(gpu.vendor());
+    record.name = builder.string(gpu.name());
+    record.driver_version = builder.string(gpu.driverVersion());
+    record.vendor_id = builder.string(gpu.vendor_id());
+    record.device_id = builder.string(gpu.device_id());
+    record.pci_bus_id = builder.string(gpu.pci_bus_id());
+    out.gpus.push_back(record);
+  }
+  if (snapshot.ram) {
+    out.memory.total_Bytes = snapshot.ram->total_Bytes();
+    out.memory.num_modules = static_cast<int64_t>(snapshot.ram->modules().size());
+    out.has_memory = true;
+    out.memory_modules.reserve(snapshot.ram->modules().size());
+    for (const Memory::Module& module : snapshot.ram->modules()) {
+      hwinfo_memory_module record{};
+      record.id = module.id;
+      record.total_Bytes = module.total_Bytes;
+      record.frequency_Hz = module.frequency_Hz;
+      record.vendor = builder.string(module.vendor);
+      record.name = builder.string(module.name);
+      record.model = builder.string(module.model);
+      record.serial_number = builder.string(module.serial_number);
+      out.memory_modules.push_back(record);
+    }
+  }
+  if (snapshot.mainboard) {
+    out.mainboard.vendor = builder.string(snapshot.mainboard->vendor());
+    out.mainboard.name = builder.string(snapshot.mainboard->name());
+    out.mainboard.version = builder.string(snapshot.mainboard->version());
+    out.mainboard.serial_number = builder.string(snapshot.mainboard->serialNumber());
+    out.has_mainboard = true;
+  }
+  out.batteries.reserve(snapshot.batteries.size());
+  for (const Battery& battery : snapshot.batteries) {
+    hwinfo_battery record{};
+    record.energy_full = battery.getEnergyFull();
+    record.vendor = builder.string(battery.getVendor());
+    record.model = builder.string(battery.getModel());
+    record.serial_number = builder.string(battery.getSerialNumber());
+    record.technology = builder.string(battery.getTechnology());
+    out.batteries.push_back(record);
+  }
+  out.disks.reserve(snapshot.disks.size());
+  for (const Disk& disk : snapshot.disks) {
+    hwinfo_disk record{};
+    record.id = disk.id();
+    record.size_Bytes = disk.size_Bytes();
+    record.vendor = builder.string(disk.vendor());
+    record.model = builder.string(disk.model());
+    record.serial_number = builder.string(disk.serialNumber());
+    record.volumes = builder.list(disk.volumes());
+    out.disks.push_back(record);
+  }
+  out.networks.reserve(snapshot.networks.size());
+  for (const Network& network : snapshot.networks) {
+    hwinfo_network record{};
+    record.mtu = network.mtu();
+    record.link_speed_Mbps = network.linkSpeed_Mbps();
+    record.interface_index = builder.string(network.interfaceIndex());
+    record.description = builder.string(network.description());
+    record.mac = builder.string(network.mac());
+    record.ip4 = builder.string(network.ip4());
+    record.type = builder.string(network.type());
+    record.ip6_addresses = builder.list(network.ip6Addresses());
+    out.networks.push_back(record);
+  }
+  out.monitors.reserve(snapshot.monitors.size());
+  for (const Monitor& monitor : snapshot.monitors) {
+    hwinfo_monitor record{};
+    record.vendor = builder.string(monitor.vendor());
+    record.model = builder.string(monitor.model());
+    record.resolution = builder.string(monitor.resolution());
+    record.refresh_rate = builder.string(monitor.refreshRate());
+    record.serial_number = builder.string(monitor.serialNumber());
+    out.monitors.push_back(record);
+  }
+  out.pci_devices.reserve(snapshot.pci_devices.size());
+  for (const PCIBusDevice& device : snapshot.pci_devices) {
+    hwinfo_pci_device record{};
+    record.vendor_id = device.vendor_id();
+    record.device_id = device.device_id();
+    record.subvendor_id = device.subvendor_id();
+    record.subdevice_id = device.subdevice_id();
+    record.class_code = device.class_code();
+    record.numa_node = device.numa_node();
+    record.link_width = device.link_width();
+    record.address = builder.string(device.address());
+    record.vendor = builder.string(device.vendor());
+    record.name = builder.string(device.name());
+    record.subsystem = builder.string(device.subsystem());
+    record.driver = builder.string(device.driver());
+    record.link_speed = builder.string(device.link_speed());
+    out.pci_devices.push_back(record);
+  }
+}
+
+template <typename Record>
+size_t copyRecords(const std::vector<Record>& records, Record* out, size_t capacity) {
+  if (out != nullptr && capacity > 0 && !records.empty()) {
+    std::memcpy(out, records.data(), std::min(capacity, records.size()) * sizeof(Record));
+  }
+  return records.size();
+}
+
+template <typename Record>
+int copyRecord(const Record& record, bool present, Record* out) {
+  if (!present) {
+    return 0;
+  }
+  if (out != nullptr) {
+    *out = record;
+  }
+  return 1;
+}
+
+}  // namespace
+
+}  // namespace hwinfo
+
+extern "C" {
+
+// _____________________________________________________________________________________________________________________
+uint32_t hwinfo_abi_version(void) { return HWINFO_C_ABI_VERSION; }
+
+// _____________________________________________________________________________________________________________________
+hwinfo_snapshot* hwinfo_collect(uint32_t subsystems, uint32_t num_threads) {
+  // exceptions (std::bad_alloc) must not cross the C boundary
+  try {
+    auto snapshot = std::make_unique<hwinfo_snapshot>();
+    hwinfo::flatten(hwinfo::collect(hwinfo::toOptions(subsystems, num_threads)), *snapshot);
+    return snapshot.release();
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void hwinfo_snapshot_free(hwinfo_snapshot* snapshot) { delete snapshot; }
+
+// _____________________________________________________________________________________________________________________
+const char* hwinfo_strings(const hwinfo_snapshot* snapshot, size_t* size) {
+  if (size != nullptr) {
+    *size = snapshot == nullptr ? 0 : snapshot->strings.size();
+  }
+  return snapshot == nullptr ? "" : snapshot->strings.c_str();
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_list_items(const hwinfo_snapshot* snapshot, hwinfo_str* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->list_items, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_cpus(const hwinfo_snapshot* snapshot, hwinfo_cpu* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->cpus, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_gpus(const hwinfo_snapshot* snapshot, hwinfo_gpu* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->gpus, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_memory_modules(const hwinfo_snapshot* snapshot, hwinfo_memory_module* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->memory_modules, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_batteries(const hwinfo_snapshot* snapshot, hwinfo_battery* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->batteries, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_disks(const hwinfo_snapshot* snapshot, hwinfo_disk* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->disks, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_networks(const hwinfo_snapshot* snapshot, hwinfo_network* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->networks, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_monitors(const hwinfo_snapshot* snapshot, hwinfo_monitor* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->monitors, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+size_t hwinfo_get_pci_devices(const hwinfo_snapshot* snapshot, hwinfo_pci_device* out, size_t capacity) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecords(snapshot->pci_devices, out, capacity);
+}
+
+// _____________________________________________________________________________________________________________________
+int hwinfo_get_os(const hwinfo_snapshot* snapshot, hwinfo_os* out) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecord(snapshot->os, snapshot->has_os, out);
+}
+
+// _____________________________________________________________________________________________________________________
+int hwinfo_get_memory(const hwinfo_snapshot* snapshot, hwinfo_memory* out) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecord(snapshot->memory, snapshot->has_memory, out);
+}
+
+// _____________________________________________________________________________________________________________________
+int hwinfo_get_mainboard(const hwinfo_snapshot* snapshot, hwinfo_mainboard* out) {
+  return snapshot == nullptr ? 0 : hwinfo::copyRecord(snapshot->mainboard, snapshot->has_mainboard, out);
+}
+
+}  // extern "C"
@@ -0,0 +1,332 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/collector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hwinfo/timeseries.h"
+
+namespace hwinfo {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// rate of a cumulative counter, -1 if one of the readings is not available or the counter was reset
+double counterRate(int64_t last, int64_t current, double seconds) {
+  if (last < 0 || current < last || seconds <= 0.0) {
+    return -1.0;
+  }
+  return static_cast<double>(current - last) / seconds;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+Collector::Collector(const CollectorOptions& options) : _options(options), _records(options.capacity) {}
+
+// _____________________________________________________________________________________________________________________
+Collector::~Collector() { stop(); }
+
+// _____________________________________________________________________________________________________________________
+void Collector::start() {
+  if (_thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = false;
+  }
+  // the sources are opened once here and kept open by the samplers, the loop only rereads them
+  if (_options.cpu_frequency.count() > 0 && !_frequency) {
+    _frequency = std::make_unique<FrequencySampler>();
+  }
+  if (_options.memory.count() > 0 && !_memory) {
+    _memory = std::make_unique<MemorySampler>();
+  }
+  if (_options.network.count() > 0 && _networks.empty()) {
+    _networks = getAllNetworks(NetworkFields::Description | NetworkFields::Statistics);
+    _last_network.assign(_networks.size(), Network::Statistics{});
+    std::lock_guard<std::mutex> lock(_names_mutex);
+    _network_names.clear();
+    for (const auto& network : _networks) {
+      _network_names.push_back(network.description());
+    }
+  }
+  if (_options.gpu.count() > 0 && _gpus.empty()) {
+    std::lock_guard<std::mutex> lock(_names_mutex);
+    _gpu_names.clear();
+    for (const auto& gpu : getAllGPUs(false)) {
+      _gpus.push_back(std::make_unique<GPUMonitor>(gpu, 1));
+      _gpu_names.push_back(gpu.name());
+    }
+  }
+  if (_options.process.count() > 0 && !_process) {
+    _process = std::make_unique<ProcessSampler>();
+  }
+  if (_options.perf_counters.count() > 0 && !_perf_counters) {
+    _perf_counters = std::make_unique<PerfCounterSampler>();
+  }
+  _thread = std::thread(&Collector::run, this);
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool Collector::running() const { return _thread.joinable(); }
+
+// _____________________________________________________________________________________________________________________
+bool Collector::pop(Record& out) { return _records.pop(out); }
+
+// _____________________________________________________________________________________________________________________
+size_t Collector::pop(Record* out, size_t max) {
+  size_t count = 0;
+  while (count < max && _records.pop(out[count])) {
+    ++count;
+  }
+  return count;
+}
+
+// _____________________________________________________________________________________________________________________
+size_t Collector::drain(TimeSeriesStore& store) {
+  size_t count = 0;
+  Record record{};
+  while (_records.pop(record)) {
+    store.append(record);
+    ++count;
+  }
+  return count;
+}
+
+// _____________________________________________________________________________________________________________________
+uint64_t Collector::dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+// _____________________________________________________________________________________________________________________
+std::string Collector::sourceName(Metric metric, uint16_t index) const {
+  std::lock_guard<std::mutex> lock(_names_mutex);
+  const std::vector<std::string>* names = nullptr;
+  switch (metric) {
+    case Metric::DiskIO:
+    case Metric::DiskIOTotals:
+      names = &_disk_names;
+      break;
+    case Metric::Network:
+    case Metric::NetworkTotals:
+      names = &_network_names;
+      break;
+    case Metric::Gpu:
+      names = &_gpu_names;
+      break;
+    default:
+      return {};
+  }
+  return index < names->size() ? (*names)[index] : std::string();
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::run() {
+  struct Task {
+    std::chrono::milliseconds interval;
+    void (Collector::*sample)(Clock::time_point);
+    Clock::time_point due;
+  };
+  std::vector<Task> tasks;
+  const auto schedule = [&](std::chrono::milliseconds interval, void (Collector::*sample)(Clock::time_point)) {
+    if (interval.count() > 0) {
+      tasks.push_back({interval, sample, Clock::now()});
+    }
+  };
+  schedule(_options.cpu_utilisation, &Collector::sampleCpu);
+  schedule(_options.cpu_frequency, &Collector::sampleFrequency);
+  schedule(_options.memory, &Collector::sampleMemory);
+  schedule(_options.disk_io, &Collector::sampleDisks);
+  schedule(_options.network, &Collector::sampleNetworks);
+  schedule(_options.gpu, &Collector::sampleGpus);
+  schedule(_options.process, &Collector::sampleProcess);
+  // without permission for the counters the metric is skipped, PerfCounterSampler::error() tells why
+  if (_perf_counters && _perf_counters->available()) {
+    schedule(_options.perf_counters, &Collector::samplePerfCounters);
+  }
+  if (tasks.empty()) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_stop) {
+    lock.unlock();
+    const auto now = Clock::now();
+    auto next = Clock::time_point::max();
+    for (auto& task : tasks) {
+      if (task.due <= now) {
+        (this->*task.sample)(now);
+        task.due += task.interval;
+        // skip the intervals that were missed (e.g. a slow sensor or a suspended system) instead of catching up
+        if (task.due <= now) {
+          task.due = now + task.interval;
+        }
+      }
+      next = std::min(next, task.due);
+    }
+    lock.lock();
+    _cv.wait_until(lock, next, [this] { return _stop; });
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::push(Metric metric, uint16_t index, Clock::time_point timestamp, std::initializer_list<double> values) {
+  Record record{timestamp, metric, index, {0.0, 0.0, 0.0, 0.0}};
+  std::copy_n(values.begin(), std::min<size_t>(values.size(), 4), record.values);
+  if (!_records.push(record)) {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+uint16_t Collector::diskIndex(const std::string& name) {
+  std::lock_guard<std::mutex> lock(_names_mutex);
+  const auto it = std::find(_disk_names.begin(), _disk_names.end(), name);
+  if (it != _disk_names.end()) {
+    return static_cast<uint16_t>(it - _disk_names.begin());
+  }
+  _disk_names.push_back(name);
+  return static_cast<uint16_t>(_disk_names.size() - 1);
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::sampleCpu(Clock::time_point now) {
+  const auto sample = _cpu.sample();
+  push(Metric::CpuUtilisation, Record::total, now, {sample.total});
+  for (size_t i = 0; i < sample.threads.size(); ++i) {
+    push(Metric::CpuUtilisation, static_cast<uint16_t>(i), now, {sample.threads[i]});
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::sampleFrequency(Clock::time_point now) {
+  _frequency->sample(_frequencies_MHz);
+  for (size_t i = 0; i < _frequencies_MHz.size(); ++i) {
+    push(Metric::CpuFrequency, static_cast<uint16_t>(i), now, {static_cast<double>(_frequencies_MHz[i])});
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::sampleMemory(Clock::time_point now) {
+  const auto stats = _memory->sample();
+  push(Metric::Memory, Record::total, now,
+       {static_cast<double>(stats.available_Bytes), static_cast<double>(stats.total_Bytes),
+        static_cast<double>(stats.swap_free_Bytes), static_cast<double>(stats.swap_total_Bytes)});
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::sampleDisks(Clock::time_point now) {
+  for (const auto& device : _disks.sample()) {
+    double iops = -1.0;
+    if (device.read_iops >= 0.0 && device.write_iops >= 0.0) {
+      iops = device.read_iops + device.write_iops;
+    }
+    const uint16_t index = diskIndex(device.name);
+    push(Metric::DiskIO, index, now, {device.read_Bytes_per_s, device.write_Bytes_per_s, iops, device.utilisation});
+    push(Metric::DiskIOTotals, index, now,
+         {static_cast<double>(device.read_Bytes), static_cast<double>(device.write_Bytes),
+          static_cast<double>(device.operations), device.busy_time_ms});
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::sampleNetworks(Clock::time_point now) {
+  const double seconds = std::chrono::duration<double>(now - _last_network_time).count();
+  const bool first = _last_network_time == Clock::time_point{};
+  _last_network_time = now;
+  for (size_t i = 0; i < _networks.size(); ++i) {
+    // interfaces that disappeared keep their index but do not report anymore
+    if (!_networks[i].refresh(NetworkFields::Statistics)) {
+      continue;
+    }
+    const auto& current = _networks[i].statistics();
+    push(Metric::NetworkTotals, static_cast<uint16_t>(i), now,
+         {static_cast<double>(current.rx_bytes), static_cast<double>(current.tx_bytes),
+          static_cast<double>(current.rx_packets), static_cast<double>(current.tx_packets)});
+    auto& last = _last_network[i];
+    if (!first) {
+      push(Metric::Network, static_cast<uint16_t>(i), now,
+           {counterRate(last.rx_bytes, current.rx_bytes, seconds),
+            counterRate(last.tx_bytes, current.tx_bytes, seconds),
+            counterRate(last.rx_packets, current.rx_packets, seconds),
+            counterRate(last.tx_packets, current.tx_packets, seconds)});
+    }
+    last = current;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::sampleGpus(Clock::time_point now) {
+  for (size_t i = 0; i < _gpus.size(); ++i) {
+    const auto sample = _gpus[i]->sample();
+    push(Metric::Gpu, static_cast<uint16_t>(i), now,
+         {sample.utilisation, static_cast<double>(sample.frequency_MHz), static_cast<double>(sample.memory_used_Bytes),
+          sample.power_W});
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::sampleProcess(Clock::time_point now) {
+  const auto sample = _process->sample();
+  const auto& usage = sample.process;
+  const auto& stats = usage.stats;
+  double cpu_time_us = -1.0;
+  if (stats.user_time_ns >= 0 && stats.system_time_ns >= 0) {
+    cpu_time_us = static_cast<double>((stats.user_time_ns + stats.system_time_ns) / 1000);
+  }
+  double context_switches = -1.0;
+  if (stats.voluntary_context_switches >= 0) {
+    context_switches = static_cast<double>(stats.voluntary_context_switches +
+                                           std::max<int64_t>(stats.involuntary_context_switches, 0));
+  }
+  push(Metric::ProcessTotals, Record::total, now,
+       {cpu_time_us, static_cast<double>(stats.minor_faults), static_cast<double>(stats.major_faults),
+        context_switches});
+  // the first sample has no rates yet
+  if (sample.interval_s <= 0.0) {
+    return;
+  }
+  double faults = -1.0;
+  if (usage.minor_faults_per_s >= 0.0) {
+    faults = usage.minor_faults_per_s + std::max(usage.major_faults_per_s, 0.0);
+  }
+  push(Metric::Process, Record::total, now,
+       {usage.cpu_utilisation, static_cast<double>(stats.rss_Bytes), faults, usage.context_switches_per_s});
+}
+
+// _____________________________________________________________________________________________________________________
+void Collector::samplePerfCounters(Clock::time_point now) {
+  const auto sample = _perf_counters->sample();
+  if (sample.interval_s <= 0.0) {
+    return;
+  }
+  const auto push_counters = [&](uint16_t index, const PerfCounterSampler::Counters& counters) {
+    push(Metric::PerfCounters, index, now,
+         {counters.ipc, counters.cache_mpki, counters.branch_mpki, counters.stalled_ratio});
+  };
+  push_counters(Record::total, sample.total);
+  for (const auto& counters : sample.cpus) {
+    push_counters(static_cast<uint16_t>(counters.cpu), counters);
+  }
+}
+
+}  // namespace hwinfo
@@ -3,11 +3,122 @@
 
 #include "hwinfo/cpu.h"
 
+#include <algorithm>
+#include <cmath>
 #include <string>
+#include <tuple>
 #include <vector>
 
+#include "hwinfo/cpuid.h"
+
 namespace hwinfo {
 
+// _____________________________________________________________________________________________________________________
+double Jiffies::utilisation_since(const Jiffies& last) const {
+  const auto total_over_period = static_cast<double>(all - last.all);
+  const auto work_over_period = static_cast<double>(working - last.working);
+  const double utilisation = work_over_period / total_over_period;
+  if (utilisation < 0 || utilisation > 1 || std::isnan(utilisation)) {
+    return -1.0;
+  }
+  return utilisation;
+}
+
+// _____________________________________________________________________________________________________________________
+CpuSampler::CpuSampler() : _last(snapshot()), _published(std::make_unique<Published>(_last.size())) {
+  for (size_t i = 0; i < _published->num_values; ++i) {
+    _published->values[i].store(-1.0, std::memory_order_relaxed);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+CpuSampler::Sample CpuSampler::sample() {
+  Sample result;
+  std::vector<Jiffies> current = snapshot();
+  if (current.empty()) {
+    return result;
+  }
+  // CPUs that came online since the last sample get a since-boot baseline
+  _last.resize(current.size());
+  result.total = current[0].utilisation_since(_last[0]);
+  result.threads.reserve(current.size() - 1);
+  for (size_t i = 1; i < current.size(); ++i) {
+    result.threads.push_back(current[i].utilisation_since(_last[i]));
+  }
+  _last = std::move(current);
+
+  // publish: an odd version marks the write in progress, the release store of the even version makes the values
+  // visible to readers that load it with acquire
+  Published& published = *_published;
+  const uint64_t version = published.version.load(std::memory_order_relaxed);
+  published.version.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < published.num_values; ++i) {
+    const double value = i == 0 ? result.total : (i - 1 < result.threads.size() ? result.threads[i - 1] : -1.0);
+    published.values[i].store(value, std::memory_order_relaxed);
+  }
+  published.version.store(version + 2, std::memory_order_release);
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+bool CpuSampler::latest(Sample& out) const {
+  const Published& published = *_published;
+  if (published.num_values == 0) {
+    return false;
+  }
+  out.threads.resize(published.num_values - 1);
+  for (;;) {
+    const uint64_t before = published.version.load(std::memory_order_acquire);
+    if (before == 0) {
+      return false;
+    }
+    if (before & 1) {
+      continue;
+    }
+    out.total = published.values[0].load(std::memory_order_relaxed);
+    for (size_t i = 1; i < published.num_values; ++i) {
+      out.threads[i - 1] = published.values[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (published.version.load(std::memory_order_relaxed) == before) {
+      return true;
+    }
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+uint64_t CpuSampler::sequence() const { return _published->version.load(std::memory_order_acquire) / 2; }
+
+// _____________________________________________________________________________________________________________________
+CPU::Baseline::Baseline(const Baseline& other) {
+  std::lock_guard<std::mutex> lock(other.mutex);
+  jiffies = other.jiffies;
+}
+
+// _____________________________________________________________________________________________________________________
+CPU::Baseline& CPU::Baseline::operator=(const Baseline& other) {
+  if (this != &other) {
+    std::vector<Jiffies> copy;
+    {
+      std::lock_guard<std::mutex> lock(other.mutex);
+      copy = other.jiffies;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    jiffies = std::move(copy);
+  }
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+void FrequencySampler::sample(std::vector<int64_t>& out_MHz) {
+  out_MHz.resize(_last.size());
+  sample(out_MHz.data(), out_MHz.size());
+}
+
+// _____________________________________________________________________________________________________________________
+bool FrequencySampler::effective() const { return _effective; }
+
 // _____________________________________________________________________________________________________________________
 int CPU::id() const { return _id; }
 
@@ -33,12 +144,274 @@ int CPU::numPhysicalCores() const { return _numPhysicalCores; }
 int CPU::numLogicalCores() const { return _numLogicalCores; }
 
 // _____________________________________________________________________________________________________________________
-int64_t CPU::maxClockSpeed_MHz() const { return _maxClockSpeed_MHz; }
+int64_t CPU::maxClockSpeed_MHz() const {
+  return _clockSpeeds.get([this] { return readClockSpeeds(); }).max_MHz;
+}
 
 // _____________________________________________________________________________________________________________________
-int64_t CPU::regularClockSpeed_MHz() const { return _regularClockSpeed_MHz; }
+int64_t CPU::regularClockSpeed_MHz() const {
+  return _clockSpeeds.get([this] { return readClockSpeeds(); }).regular_MHz;
+}
 
 // _____________________________________________________________________________________________________________________
 const std::vector<std::string>& CPU::flags() const { return _flags; }
 
+// _____________________________________________________________________________________________________________________
+const CpuFeatures& CPU::features() const { return CpuFeatures::host(); }
+
+// _____________________________________________________________________________________________________________________
+double CPU::currentTemperature_Celsius() const {
+  // reading a temperature is stateless, one set of sensors serves all CPU objects and threads
+  static const CpuSensors sensors;
+  return sensors.packageTemperature_Celsius(std::max(_id, 0));
+}
+
+// _____________________________________________________________________________________________________________________
+int CpuSensors::numPackages() const { return static_cast<int>(_packages.size()); }
+
+// _____________________________________________________________________________________________________________________
+int CpuTopology::numCores() const {
+  int cores = 0;
+  for (const auto& package : packages) {
+    for (const auto& die : package.dies) {
+      for (const auto& cluster : die.clusters) {
+        cores += static_cast<int>(cluster.cores.size());
+      }
+    }
+  }
+  return cores;
+}
+
+// _____________________________________________________________________________________________________________________
+int CpuTopology::numThreads() const {
+  return static_cast<int>(std::count_if(threads.begin(), threads.end(), [](const Thread& t) { return t.core >= 0; }));
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<int> CpuTopology::packageCpus(int package_id) const {
+  std::vector<int> cpus;
+  for (size_t cpu = 0; cpu < threads.size(); ++cpu) {
+    if (threads[cpu].core >= 0 && threads[cpu].package == package_id) cpus.push_back(static_cast<int>(cpu));
+  }
+  return cpus;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<int> CpuTopology::numaNodeCpus(int node_id) const {
+  for (const auto& node : numa_nodes) {
+    if (node.id == node_id) return node.cpus;
+  }
+  return {};
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<int> CpuTopology::siblingCpus(int cpu) const {
+  std::vector<int> cpus;
+  if (cpu < 0 || static_cast<size_t>(cpu) >= threads.size() || threads[cpu].core < 0) {
+    return cpus;
+  }
+  const Thread& self = threads[cpu];
+  for (size_t other = 0; other < threads.size(); ++other) {
+    const Thread& t = threads[other];
+    if (t.package == self.package && t.die == self.die && t.cluster == self.cluster && t.core == self.core) {
+      cpus.push_back(static_cast<int>(other));
+    }
+  }
+  return cpus;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<int> CpuTopology::onePerCore(int package_id) const {
+  std::vector<int> cpus;
+  for (const auto& package : packages) {
+    if (package_id >= 0 && package.id != package_id) continue;
+    for (const auto& die : package.dies) {
+      for (const auto& cluster : die.clusters) {
+        for (const auto& core : cluster.cores) {
+          if (!core.cpus.empty()) cpus.push_back(core.cpus.front());
+        }
+      }
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  return cpus;
+}
+
+// _____________________________________________________________________________________________________________________
+void CpuTopology::assignPerformanceLevels(int num_levels) {
+  performance_levels.resize(std::max(num_levels, 1));
+  const int last_level = static_cast<int>(performance_levels.size()) - 1;
+  for (auto& level : performance_levels) {
+    level.num_physical_cores = 0;
+    level.num_logical_cores = 0;
+    level.cpus.clear();
+  }
+  for (auto& package : packages) {
+    for (auto& die : package.dies) {
+      for (auto& cluster : die.clusters) {
+        for (auto& core : cluster.cores) {
+          core.performance_level = std::clamp(core.performance_level, 0, last_level);
+          auto& level = performance_levels[core.performance_level];
+          level.num_physical_cores++;
+          level.num_logical_cores += static_cast<int>(core.cpus.size());
+          level.cpus.insert(level.cpus.end(), core.cpus.begin(), core.cpus.end());
+          for (const int cpu : core.cpus) {
+            if (cpu < 0 || static_cast<size_t>(cpu) >= threads.size()) continue;
+            threads[cpu].performance_level = core.performance_level;
+          }
+        }
+      }
+    }
+  }
+  for (size_t i = 0; i < performance_levels.size(); ++i) {
+    auto& level = performance_levels[i];
+    std::sort(level.cpus.begin(), level.cpus.end());
+    if (performance_levels.size() > 1) {
+      level.type = i + 1 == performance_levels.size() ? CoreType::Efficiency : CoreType::Performance;
+    }
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+double CpuTopology::PerformanceLevel::utilisation(const CpuSampler::Sample& sample) const {
+  double sum = 0;
+  int count = 0;
+  for (const int cpu : cpus) {
+    if (cpu >= 0 && static_cast<size_t>(cpu) < sample.threads.size() && sample.threads[cpu] >= 0) {
+      sum += sample.threads[cpu];
+      count++;
+    }
+  }
+  return count > 0 ? sum / count : -1.0;
+}
+
+// _____________________________________________________________________________________________________________________
+bool CacheInfo::operator<(const CacheInfo& other) const {
+  const int first_cpu = shared_cpus.empty() ? -1 : shared_cpus.front();
+  const int other_first_cpu = other.shared_cpus.empty() ? -1 : other.shared_cpus.front();
+  return std::tie(level, type, first_cpu) < std::tie(other.level, other.type, other_first_cpu);
+}
+
+namespace {
+
+// indexed by Feature
+constexpr std::string_view feature_names[] = {
+    "sse",          "sse2",         "pni",          "ssse3",        "sse4_1",       "sse4_2",       "popcnt",
+    "aes",          "pclmulqdq",    "avx",          "f16c",         "fma",          "avx2",         "bmi1",
+    "bmi2",         "abm",          "movbe",        "rdrand",       "sha_ni",       "avx_vnni",     "avx512f",
+    "avx512dq",     "avx512cd",     "avx512bw",     "avx512vl",     "avx512_vnni",  "avx512_bf16",  "avx512_fp16",
+    "amx_tile",     "amx_int8",     "amx_bf16",     "hypervisor",   "asimd",        "asimdhp",      "aes",
+    "pmull",        "sha1",         "sha2",         "crc32",        "atomics",      "asimddp",      "i8mm",
+    "bf16",         "sve",          "sve2",         "sme"};
+
+static_assert(sizeof(feature_names) / sizeof(feature_names[0]) == static_cast<size_t>(Feature::COUNT_),
+              "every Feature needs a name");
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+std::string_view CpuFeatures::name(Feature feature) {
+  const auto index = static_cast<size_t>(feature);
+  return index < static_cast<size_t>(Feature::COUNT_) ? feature_names[index] : std::string_view{};
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<std::string_view> CpuFeatures::names() const {
+  std::vector<std::string_view> result;
+  for (unsigned i = 0; i < static_cast<unsigned>(Feature::COUNT_); ++i) {
+    if (has(static_cast<Feature>(i))) result.push_back(feature_names[i]);
+  }
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+const CpuFeatures& CpuFeatures::host() {
+  static const CpuFeatures features = detect();
+  return features;
+}
+
+#if defined(HWINFO_X86)
+// _____________________________________________________________________________________________________________________
+CpuFeatures CpuFeatures::detect() {
+  CpuFeatures features;
+  uint32_t regs[4]{};
+  cpuid::cpuid(0, 0, regs);
+  const uint32_t max_leaf = regs[0];
+  if (max_leaf < 1) {
+    return features;
+  }
+  const auto set_if = [&features](uint32_t reg, uint32_t mask, Feature feature) {
+    if (reg & mask) features.set(feature);
+  };
+
+  cpuid::cpuid(1, 0, regs);
+  const uint32_t ecx1 = regs[2];
+  const uint32_t edx1 = regs[3];
+  set_if(edx1, SSE_POS, Feature::SSE);
+  set_if(edx1, SSE2_POS, Feature::SSE2);
+  set_if(ecx1, SSE3_POS, Feature::SSE3);
+  set_if(ecx1, 1u << 9, Feature::SSSE3);
+  set_if(ecx1, SSE41_POS, Feature::SSE4_1);
+  set_if(ecx1, SSE42_POS, Feature::SSE4_2);
+  set_if(ecx1, 1u << 23, Feature::POPCNT);
+  set_if(ecx1, 1u << 25, Feature::AES);
+  set_if(ecx1, 1u << 1, Feature::PCLMULQDQ);
+  set_if(ecx1, 1u << 22, Feature::MOVBE);
+  set_if(ecx1, 1u << 30, Feature::RDRAND);
+  set_if(ecx1, 1u << 31, Feature::HYPERVISOR);
+
+  // AVX and later need the OS to save the extended register state (XCR0): XMM|YMM, opmask|ZMM_Hi256|Hi16_ZMM and
+  // XTILECFG|XTILEDATA
+  const uint64_t xcr0 = (ecx1 & (1u << 27)) ? cpuid::xgetbv(0) : 0;
+  const bool avx_state = (xcr0 & 0x6) == 0x6;
+  const bool avx512_state = avx_state && (xcr0 & 0xe0) == 0xe0;
+  const bool amx_state = (xcr0 & 0x60000) == 0x60000;
+  if (avx_state) {
+    set_if(ecx1, AVX_POS, Feature::AVX);
+    set_if(ecx1, 1u << 29, Feature::F16C);
+    set_if(ecx1, 1u << 12, Feature::FMA);
+  }
+
+  if (max_leaf >= 7) {
+    cpuid::cpuid(7, 0, regs);
+    const uint32_t max_subleaf = regs[0];
+    const uint32_t ebx7 = regs[1];
+    const uint32_t edx7 = regs[3];
+    const uint32_t ecx7 = regs[2];
+    set_if(ebx7, 1u << 3, Feature::BMI1);
+    set_if(ebx7, 1u << 8, Feature::BMI2);
+    set_if(ebx7, 1u << 29, Feature::SHA);
+    if (avx_state) {
+      set_if(ebx7, AVX2_POS, Feature::AVX2);
+    }
+    if (avx512_state) {
+      set_if(ebx7, 1u << 16, Feature::AVX512F);
+      set_if(ebx7, 1u << 17, Feature::AVX512DQ);
+      set_if(ebx7, 1u << 28, Feature::AVX512CD);
+      set_if(ebx7, 1u << 30, Feature::AVX512BW);
+      set_if(ebx7, 1u << 31, Feature::AVX512VL);
+      set_if(ecx7, 1u << 11, Feature::AVX512_VNNI);
+      set_if(edx7, 1u << 23, Feature::AVX512_FP16);
+    }
+    if (amx_state) {
+      set_if(edx7, 1u << 24, Feature::AMX_TILE);
+      set_if(edx7, 1u << 25, Feature::AMX_INT8);
+      set_if(edx7, 1u << 22, Feature::AMX_BF16);
+    }
+    if (max_subleaf >= 1) {
+      cpuid::cpuid(7, 1, regs);
+      if (avx_state) set_if(regs[0], 1u << 4, Feature::AVX_VNNI);
+      if (avx512_state) set_if(regs[0], 1u << 5, Feature::AVX512_BF16);
+    }
+  }
+
+  cpuid::cpuid(0x80000000, 0, regs);
+  if (regs[0] >= 0x80000001) {
+    cpuid::cpuid(0x80000001, 0, regs);
+    set_if(regs[2], 1u << 5, Feature::LZCNT);
+  }
+  return features;
+}
+#endif  // HWINFO_X86
+
 }  // namespace hwinfo
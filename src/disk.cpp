@@ -3,6 +3,9 @@
 
 #include "hwinfo/disk.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace hwinfo {
 // _____________________________________________________________________________________________________________________
 const std::string& Disk::vendor() const { return _vendor; }
@@ -17,11 +20,69 @@ const std::string& Disk::serialNumber() const { return _serialNumber; }
 int64_t Disk::size_Bytes() const { return _size_Bytes; }
 
 // _____________________________________________________________________________________________________________________
-int64_t Disk::free_size_Bytes() const { return _free_size_Bytes; }
+int64_t Disk::free_size_Bytes() const { return mounts().free_size_Bytes; }
 
 // _____________________________________________________________________________________________________________________
 int Disk::id() const { return _id; }
 
 // _____________________________________________________________________________________________________________________
-const std::vector<std::string>& Disk::volumes() const { return _volumes; }
+const std::vector<std::string>& Disk::volumes() const { return mounts().volumes; }
+
+// _____________________________________________________________________________________________________________________
+const Disk::Mounts& Disk::mounts() const {
+  return _mounts.get([this] { return resolveMounts(); });
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<DiskIOSampler::DeviceStats> DiskIOSampler::sample() {
+  const auto now = std::chrono::steady_clock::now();
+  auto counters = read_counters();
+  const double elapsed_s = std::chrono::duration<double>(now - _last).count();
+
+  const auto rate = [elapsed_s](double current, double previous) {
+    return (current < 0 || previous < 0 || current < previous) ? -1.0 : (current - previous) / elapsed_s;
+  };
+
+  std::vector<DeviceStats> stats;
+  stats.reserve(counters.size());
+  std::unordered_map<std::string, Counters> previous;
+  previous.reserve(counters.size());
+  for (auto& current : counters) {
+    DeviceStats device;
+    device.name = current.name;
+    device.read_Bytes = current.read_Bytes;
+    device.write_Bytes = current.write_Bytes;
+    if (current.reads >= 0 && current.writes >= 0) {
+      device.operations = current.reads + current.writes;
+    }
+    device.busy_time_ms = current.busy_time_ms;
+    const auto it = _previous.find(current.name);
+    if (it != _previous.end() && elapsed_s > 0) {
+      const Counters& last = it->second;
+      device.read_iops = rate(current.reads, last.reads);
+      device.write_iops = rate(current.writes, last.writes);
+      device.read_Bytes_per_s = rate(current.read_Bytes, last.read_Bytes);
+      device.write_Bytes_per_s = rate(current.write_Bytes, last.write_Bytes);
+      const double busy = rate(current.busy_time_ms, last.busy_time_ms);
+      if (busy >= 0) {
+        device.utilisation = std::min(1.0, busy / 1000.0);
+      }
+      const double weighted = rate(current.weighted_time_ms, last.weighted_time_ms);
+      if (weighted >= 0) {
+        device.queue_depth = weighted / 1000.0;
+      }
+      const double ios = rate(current.reads + current.writes, last.reads + last.writes);
+      const double time = rate(current.read_time_ms + current.write_time_ms, last.read_time_ms + last.write_time_ms);
+      if (ios >= 0 && time >= 0 && current.read_time_ms >= 0 && current.write_time_ms >= 0) {
+        // both rates share elapsed_s, their ratio is the time per request
+        device.await_ms = ios > 0 ? time / ios : 0.0;
+      }
+    }
+    stats.push_back(std::move(device));
+    previous.emplace(current.name, std::move(current));
+  }
+  _previous = std::move(previous);
+  _last = now;
+  return stats;
+}
 }  // namespace hwinfo
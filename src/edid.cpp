@@ -0,0 +1,276 @@
+#include "hwinfo/utils/edid.h"
+
+#include <cstring>
+
+namespace hwinfo {
+namespace utils {
+namespace EDID {
+
+namespace {
+
+constexpr size_t block_size = 128;
+constexpr size_t descriptor_size = 18;
+constexpr uint8_t header[8] = {0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00};
+
+constexpr uint8_t extension_cta = 0x02;
+constexpr uint8_t extension_displayid = 0x70;
+
+constexpr uint8_t descriptor_serial = 0xff;
+constexpr uint8_t descriptor_name = 0xfc;
+
+// sources of the preferred timing, a lower value wins
+enum Rank : int {
+  rank_base_detailed = 0,
+  rank_displayid_preferred,
+  rank_cta_detailed,
+  rank_displayid_first,
+  rank_cta_native_vic,
+  rank_cta_first_vic,
+  rank_none,
+};
+
+// CTA-861 video identification codes that are commonly the only timing of TVs and AV receivers
+struct VideoCode {
+  uint8_t vic;
+  uint16_t h_active, v_active, h_total, v_total;
+  uint32_t pixel_clock_kHz;
+};
+constexpr VideoCode video_codes[] = {
+    {1, 640, 480, 800, 525, 25175},        {4, 1280, 720, 1650, 750, 74250},    {16, 1920, 1080, 2200, 1125, 148500},
+    {19, 1280, 720, 1980, 750, 74250},     {31, 1920, 1080, 2640, 1125, 148500}, {32, 1920, 1080, 2750, 1125, 74250},
+    {34, 1920, 1080, 2200, 1125, 74250},   {93, 3840, 2160, 5500, 2250, 297000}, {94, 3840, 2160, 5280, 2250, 297000},
+    {95, 3840, 2160, 4400, 2250, 297000},  {96, 3840, 2160, 5280, 2250, 594000}, {97, 3840, 2160, 4400, 2250, 594000},
+};
+
+struct State {
+  Info& info;
+  int rank{rank_none};
+  // physical size candidates, the first non-zero one is used
+  int timing_width_mm{0}, timing_height_mm{0};
+  int displayid_width_mm{0}, displayid_height_mm{0};
+  int screen_width_mm{0}, screen_height_mm{0};
+
+  void offer(const Timing& timing, int timing_rank) {
+    if (timing.valid() && timing_rank < rank) {
+      info.preferred = timing;
+      rank = timing_rank;
+    }
+  }
+};
+
+uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+uint32_t le32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool checksumValid(const uint8_t* data, size_t size) {
+  uint8_t sum = 0;
+  for (size_t i = 0; i < size; ++i) sum = static_cast<uint8_t>(sum + data[i]);
+  return sum == 0;
+}
+
+// copies printable characters up to a newline or null into out unless out is set already, trailing spaces are dropped
+template <size_t N>
+void copyText(char (&out)[N], const uint8_t* text, size_t size) {
+  if (out[0] != '\0') return;
+  size_t length = 0;
+  for (size_t i = 0; i < size && length + 1 < N && text[i] != 0x0a && text[i] != 0x00; ++i) {
+    if (text[i] >= 0x20 && text[i] < 0x7f) out[length++] = static_cast<char>(text[i]);
+  }
+  while (length > 0 && out[length - 1] == ' ') --length;
+  out[length] = '\0';
+}
+
+void decodeManufacturer(const uint8_t* p, char (&out)[4]) {
+  const uint16_t id = static_cast<uint16_t>((p[0] << 8) | p[1]);
+  const char letters[3] = {static_cast<char>('A' - 1 + ((id >> 10) & 0x1f)),
+                           static_cast<char>('A' - 1 + ((id >> 5) & 0x1f)), static_cast<char>('A' - 1 + (id & 0x1f))};
+  for (const char c : letters) {
+    if (c < 'A' || c > 'Z') return;
+  }
+  std::memcpy(out, letters, 3);
+  out[3] = '\0';
+}
+
+// 18 byte detailed timing descriptor or display descriptor of the base block or a CTA-861 extension
+void decodeDescriptor(State& state, const uint8_t* p, int timing_rank) {
+  const uint16_t pixel_clock = le16(p);
+  if (pixel_clock == 0) {
+    if (p[2] != 0) return;
+    if (p[3] == descriptor_name) copyText(state.info.name, p + 5, 13);
+    if (p[3] == descriptor_serial) copyText(state.info.serial_string, p + 5, 13);
+    return;
+  }
+  Timing timing;
+  timing.pixel_clock_Hz = int64_t{pixel_clock} * 10000;
+  timing.h_active = p[2] | ((p[4] & 0xf0) << 4);
+  timing.h_blank = p[3] | ((p[4] & 0x0f) << 8);
+  timing.v_active = p[5] | ((p[7] & 0xf0) << 4);
+  timing.v_blank = p[6] | ((p[7] & 0x0f) << 8);
+  timing.interlaced = (p[17] & 0x80) != 0;
+  if (timing.interlaced) {
+    // the descriptor holds the lines of one field
+    timing.v_active *= 2;
+    timing.v_blank *= 2;
+  }
+  if (timing.valid() && timing_rank < state.rank) {
+    state.timing_width_mm = p[12] | ((p[14] & 0xf0) << 4);
+    state.timing_height_mm = p[13] | ((p[14] & 0x0f) << 8);
+  }
+  state.offer(timing, timing_rank);
+}
+
+void decodeBase(State& state, const uint8_t* p) {
+  Info& info = state.info;
+  decodeManufacturer(p + 8, info.manufacturer);
+  info.product_code = le16(p + 10);
+  info.serial_number = le32(p + 12);
+  // byte 16 = 0xff marks byte 17 as model year instead of year of manufacture
+  if (p[17] != 0) info.manufacture_year = 1990 + p[17];
+  info.version = p[18];
+  info.revision = p[19];
+  // both zero or one of them zero (aspect ratio) means the size is undefined
+  if (p[21] != 0 && p[22] != 0) {
+    state.screen_width_mm = p[21] * 10;
+    state.screen_height_mm = p[22] * 10;
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    decodeDescriptor(state, p + 54 + i * descriptor_size, i == 0 ? rank_base_detailed : rank_none);
+  }
+  info.num_extensions = p[126];
+}
+
+void decodeCta(State& state, const uint8_t* p) {
+  const uint8_t dtd_offset = p[2];
+  if (dtd_offset >= 4 && dtd_offset < block_size) {
+    // data block collection between byte 4 and the first detailed timing
+    for (size_t i = 4; i < dtd_offset;) {
+      const uint8_t tag = p[i] >> 5;
+      const size_t length = p[i] & 0x1f;
+      if (i + 1 + length > dtd_offset) break;
+      // video data block: short video descriptors, bit 7 marks native codes 1-64
+      for (size_t j = 0; tag == 2 && j < length; ++j) {
+        const uint8_t svd = p[i + 1 + j];
+        const bool native = (svd & 0x80) != 0 && (svd & 0x7f) <= 64;
+        const uint8_t vic = native ? svd & 0x7f : svd;
+        for (const auto& code : video_codes) {
+          if (code.vic != vic) continue;
+          Timing timing;
+          timing.h_active = code.h_active;
+          timing.v_active = code.v_active;
+          timing.h_blank = code.h_total - code.h_active;
+          timing.v_blank = code.v_total - code.v_active;
+          timing.pixel_clock_Hz = int64_t{code.pixel_clock_kHz} * 1000;
+          state.offer(timing, native ? rank_cta_native_vic : rank_cta_first_vic);
+        }
+      }
+      i += 1 + length;
+    }
+    for (size_t i = dtd_offset; i + descriptor_size < block_size && le16(p + i) != 0; i += descriptor_size) {
+      decodeDescriptor(state, p + i, rank_cta_detailed);
+    }
+  }
+}
+
+// DisplayID type I (1.x, 10 kHz) and type VII (2.x, 1 kHz) detailed timings, 20 bytes each
+void decodeDisplayIdTimings(State& state, const uint8_t* p, size_t length, int64_t clock_unit_Hz) {
+  for (size_t i = 0; i + 20 <= length; i += 20) {
+    const uint8_t* d = p + i;
+    Timing timing;
+    timing.pixel_clock_Hz = (int64_t{d[0] | (d[1] << 8) | (d[2] << 16)} + 1) * clock_unit_Hz;
+    timing.interlaced = (d[3] & 0x10) != 0;
+    timing.h_active = le16(d + 4) + 1;
+    timing.h_blank = le16(d + 6) + 1;
+    timing.v_active = le16(d + 12) + 1;
+    timing.v_blank = le16(d + 14) + 1;
+    state.offer(timing, (d[3] & 0x80) != 0 ? rank_displayid_preferred : rank_displayid_first);
+  }
+}
+
+// a DisplayID section: 4 byte header, data blocks and a checksum
+bool decodeDisplayId(State& state, const uint8_t* p, size_t size) {
+  if (size < 5 || p[1] + size_t{5} > size || !checksumValid(p, p[1] + size_t{5})) return false;
+  const bool v2 = p[0] >= 0x20;
+  const size_t end = 4 + p[1];
+  for (size_t i = 4; i + 3 <= end;) {
+    const uint8_t tag = p[i];
+    const uint8_t revision = p[i + 1];
+    const size_t length = p[i + 2];
+    const uint8_t* payload = p + i + 3;
+    if (i + 3 + length > end) break;
+    if ((tag == 0x00 || tag == 0x20) && length >= 12) {
+      // product identification: manufacturer (PNP id in 1.x, IEEE OUI in 2.x), product code, serial, week, year, name
+      if (!v2 && state.info.manufacturer[0] == '\0') copyText(state.info.manufacturer, payload, 3);
+      if (state.info.product_code == 0) state.info.product_code = le16(payload + 3);
+      if (state.info.serial_number == 0) state.info.serial_number = le32(payload + 5);
+      if (state.info.manufacture_year == 0 && payload[10] != 0) state.info.manufacture_year = 2000 + payload[10];
+      const size_t name_length = payload[11];
+      if (12 + name_length <= length) copyText(state.info.name, payload + 12, name_length);
+    } else if ((tag == 0x01 || tag == 0x21) && length >= 4) {
+      // display parameters: image size in 0.1 mm, DisplayID 2.x sets bit 7 of the revision for 1 mm units
+      const int scale = (tag == 0x21 && (revision & 0x80) != 0) ? 10 : 1;
+      state.displayid_width_mm = le16(payload) * scale / 10;
+      state.displayid_height_mm = le16(payload + 2) * scale / 10;
+    } else if (tag == 0x03) {
+      decodeDisplayIdTimings(state, payload, length, 10000);
+    } else if (tag == 0x22) {
+      decodeDisplayIdTimings(state, payload, length, 1000);
+    }
+    i += 3 + length;
+  }
+  return true;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+int64_t Timing::refresh_rate_mHz() const {
+  const int64_t total = int64_t{h_active + h_blank} * (v_active + v_blank);
+  if (pixel_clock_Hz <= 0 || total <= 0) {
+    return 0;
+  }
+  // interlaced modes are named after their field rate (1080i60)
+  const int64_t rate = pixel_clock_Hz * 1000 * (interlaced ? 2 : 1);
+  return (rate + total / 2) / total;
+}
+
+// _____________________________________________________________________________________________________________________
+bool parse(const uint8_t* data, size_t size, Info& info) {
+  info = Info();
+  State state{info};
+  if (data == nullptr) {
+    return false;
+  }
+  if (size >= block_size && std::memcmp(data, header, sizeof(header)) == 0) {
+    decodeBase(state, data);
+    for (size_t offset = block_size; offset + block_size <= size; offset += block_size) {
+      const uint8_t* block = data + offset;
+      if (!checksumValid(block, block_size)) continue;
+      if (block[0] == extension_cta) {
+        decodeCta(state, block);
+      } else if (block[0] == extension_displayid) {
+        decodeDisplayId(state, block + 1, block_size - 1);
+      }
+    }
+  } else if (size == 0 || (data[0] & 0xf0) == 0 || !decodeDisplayId(state, data, size)) {
+    return false;
+  }
+
+  if (state.timing_width_mm > 0 && state.timing_height_mm > 0) {
+    info.width_mm = state.timing_width_mm;
+    info.height_mm = state.timing_height_mm;
+  } else if (state.displayid_width_mm > 0 && state.displayid_height_mm > 0) {
+    info.width_mm = state.displayid_width_mm;
+    info.height_mm = state.displayid_height_mm;
+  } else {
+    info.width_mm = state.screen_width_mm;
+    info.height_mm = state.screen_height_mm;
+  }
+  return true;
+}
+
+}  // namespace EDID
+}  // namespace utils
+}  // namespace hwinfo
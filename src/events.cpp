@@ -0,0 +1,74 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/events.h"
+
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+DeviceWatcher::DeviceWatcher(Callback callback) : _callback(std::move(callback)) {}
+
+// _____________________________________________________________________________________________________________________
+DeviceWatcher::~DeviceWatcher() { stop(); }
+
+// _____________________________________________________________________________________________________________________
+bool DeviceWatcher::start() {
+  if (_thread.joinable()) {
+    return true;
+  }
+  // the backend is opened on the watcher thread: on Windows the notifications are bound to the thread's window
+  std::promise<bool> opened;
+  auto result = opened.get_future();
+  _thread = std::thread(&DeviceWatcher::run, this, &opened);
+  if (!result.get()) {
+    _thread.join();
+    return false;
+  }
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void DeviceWatcher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_backend) {
+      interrupt(*_backend);
+    }
+  }
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool DeviceWatcher::running() const { return _thread.joinable(); }
+
+// _____________________________________________________________________________________________________________________
+void DeviceWatcher::run(std::promise<bool>* opened) {
+  Backend* backend = open_backend();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _backend.reset(backend);
+  }
+  opened->set_value(backend != nullptr);
+  if (backend == nullptr) {
+    return;
+  }
+  std::vector<DeviceEvent> events;
+  while (wait_events(*backend, events)) {
+    for (const auto& event : events) {
+      if (_callback) {
+        _callback(event);
+      }
+    }
+    events.clear();
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  _backend.reset();
+}
+
+}  // namespace hwinfo
@@ -0,0 +1,384 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/exporter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#ifdef HWINFO_WINDOWS
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "hwinfo/utils/stringutils.h"
+
+namespace hwinfo {
+
+namespace {
+
+#ifdef HWINFO_WINDOWS
+using Socket = SOCKET;
+const Socket invalid_socket = INVALID_SOCKET;
+void closeSocket(Socket socket) { closesocket(socket); }
+int pollSockets(pollfd* fds, unsigned count, int timeout_ms) { return WSAPoll(fds, count, timeout_ms); }
+#else
+using Socket = int;
+const Socket invalid_socket = -1;
+void closeSocket(Socket socket) { close(socket); }
+int pollSockets(pollfd* fds, unsigned count, int timeout_ms) { return poll(fds, count, timeout_ms); }
+#endif
+
+#ifdef MSG_NOSIGNAL
+constexpr int send_flags = MSG_NOSIGNAL;
+#else
+constexpr int send_flags = 0;
+#endif
+
+Socket toSocket(intptr_t handle) { return static_cast<Socket>(handle); }
+
+// one exposed metric family: value `value` of the records of `metric`, multiplied by scale. Counter families are
+// exposed with the OpenMetrics "_total" suffix on their samples
+struct Family {
+  Metric metric;
+  int value;
+  double scale;
+  const char* name;
+  const char* help;
+  bool counter{false};
+};
+
+constexpr Family families[] = {
+    {Metric::CpuUtilisation, 0, 1.0, "hwinfo_cpu_utilisation_ratio", "Fraction of time the CPU was busy."},
+    {Metric::CpuFrequency, 0, 1e6, "hwinfo_cpu_frequency_hertz", "Current frequency of the logical CPU."},
+    {Metric::Memory, 0, 1.0, "hwinfo_memory_available_bytes", "Memory available for new allocations."},
+    {Metric::Memory, 1, 1.0, "hwinfo_memory_total_bytes", "Usable physical memory."},
+    {Metric::Memory, 2, 1.0, "hwinfo_swap_free_bytes", "Unused swap space."},
+    {Metric::Memory, 3, 1.0, "hwinfo_swap_total_bytes", "Total swap space."},
+    {Metric::DiskIO, 0, 1.0, "hwinfo_disk_read_bytes_per_second", "Bytes read from the disk."},
+    {Metric::DiskIO, 1, 1.0, "hwinfo_disk_written_bytes_per_second", "Bytes written to the disk."},
+    {Metric::DiskIO, 2, 1.0, "hwinfo_disk_operations_per_second", "Completed read and write requests."},
+    {Metric::DiskIO, 3, 1.0, "hwinfo_disk_utilisation_ratio", "Fraction of time the disk had requests in flight."},
+    {Metric::Network, 0, 1.0, "hwinfo_network_receive_bytes_per_second", "Bytes received by the interface."},
+    {Metric::Network, 1, 1.0, "hwinfo_network_transmit_bytes_per_second", "Bytes sent by the interface."},
+    {Metric::Network, 2, 1.0, "hwinfo_network_receive_packets_per_second", "Packets received by the interface."},
+    {Metric::Network, 3, 1.0, "hwinfo_network_transmit_packets_per_second", "Packets sent by the interface."},
+    {Metric::Gpu, 0, 1.0, "hwinfo_gpu_utilisation_ratio", "Fraction of time the GPU was busy."},
+    {Metric::Gpu, 1, 1e6, "hwinfo_gpu_frequency_hertz", "Current core frequency of the GPU."},
+    {Metric::Gpu, 2, 1.0, "hwinfo_gpu_memory_used_bytes", "Used GPU memory."},
+    {Metric::Gpu, 3, 1.0, "hwinfo_gpu_power_watts", "Average power draw of the GPU."},
+    {Metric::Process, 0, 1.0, "hwinfo_process_cpu_ratio", "CPU time of the process per wall time, in logical CPUs."},
+    {Metric::Process, 1, 1.0, "hwinfo_process_resident_memory_bytes", "Resident set size of the process."},
+    {Metric::Process, 2, 1.0, "hwinfo_process_page_faults_per_second", "Minor and major page faults of the process."},
+    {Metric::Process, 3, 1.0, "hwinfo_process_context_switches_per_second", "Context switches of the process."},
+    {Metric::PerfCounters, 0, 1.0, "hwinfo_cpu_instructions_per_cycle", "Retired instructions per CPU cycle."},
+    {Metric::PerfCounters, 1, 1.0, "hwinfo_cpu_cache_misses_per_kilo_instruction",
+     "Last level cache misses per 1000 instructions."},
+    {Metric::PerfCounters, 2, 1.0, "hwinfo_cpu_branch_misses_per_kilo_instruction",
+     "Mispredicted branches per 1000 instructions."},
+    {Metric::PerfCounters, 3, 1.0, "hwinfo_cpu_stalled_cycles_ratio", "Fraction of cycles the backend was stalled."},
+    {Metric::NetworkTotals, 0, 1.0, "hwinfo_network_receive_bytes", "Bytes received by the interface.", true},
+    {Metric::NetworkTotals, 1, 1.0, "hwinfo_network_transmit_bytes", "Bytes sent by the interface.", true},
+    {Metric::NetworkTotals, 2, 1.0, "hwinfo_network_receive_packets", "Packets received by the interface.", true},
+    {Metric::NetworkTotals, 3, 1.0, "hwinfo_network_transmit_packets", "Packets sent by the interface.", true},
+    {Metric::DiskIOTotals, 0, 1.0, "hwinfo_disk_read_bytes", "Bytes read from the disk.", true},
+    {Metric::DiskIOTotals, 1, 1.0, "hwinfo_disk_written_bytes", "Bytes written to the disk.", true},
+    {Metric::DiskIOTotals, 2, 1.0, "hwinfo_disk_operations", "Completed read and write requests.", true},
+    {Metric::DiskIOTotals, 3, 1e-3, "hwinfo_disk_busy_seconds", "Time the disk had requests in flight.", true},
+    {Metric::ProcessTotals, 0, 1e-6, "hwinfo_process_cpu_seconds", "CPU time of the process.", true},
+    {Metric::ProcessTotals, 1, 1.0, "hwinfo_process_minor_page_faults", "Page faults served without I/O.", true},
+    {Metric::ProcessTotals, 2, 1.0, "hwinfo_process_major_page_faults", "Page faults that required I/O.", true},
+    {Metric::ProcessTotals, 3, 1.0, "hwinfo_process_context_switches", "Context switches of the process.", true},
+};
+
+uint32_t seriesKey(Metric metric, uint16_t index) { return static_cast<uint32_t>(metric) << 16 | index; }
+
+// _____________________________________________________________________________________________________________________
+void appendLabel(std::string& out, const char* name, const std::string& value) {
+  out += out.empty() ? "{" : ",";
+  out += name;
+  out += "=\"";
+  for (const char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+}
+
+// _____________________________________________________________________________________________________________________
+std::string renderLabels(const Collector& collector, Metric metric, uint16_t index) {
+  std::string labels;
+  switch (metric) {
+    case Metric::CpuUtilisation:
+    case Metric::CpuFrequency:
+    case Metric::PerfCounters:
+      appendLabel(labels, "cpu", index == Record::total ? std::string("total") : std::to_string(index));
+      break;
+    case Metric::Memory:
+    case Metric::Process:
+    case Metric::ProcessTotals:
+      break;
+    case Metric::DiskIO:
+    case Metric::DiskIOTotals:
+      appendLabel(labels, "device", collector.sourceName(metric, index));
+      break;
+    case Metric::Network:
+    case Metric::NetworkTotals:
+      appendLabel(labels, "interface", collector.sourceName(metric, index));
+      break;
+    case Metric::Gpu:
+      appendLabel(labels, "gpu", std::to_string(index));
+      appendLabel(labels, "name", collector.sourceName(metric, index));
+      break;
+  }
+  if (!labels.empty()) {
+    labels += '}';
+  }
+  return labels;
+}
+
+// _____________________________________________________________________________________________________________________
+bool sendAll(Socket socket, const char* data, size_t size) {
+  while (size > 0) {
+    const auto sent = send(socket, data, static_cast<int>(size), send_flags);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+Exporter::Exporter(Collector& collector, ExporterOptions options)
+    : _collector(collector), _options(std::move(options)) {}
+
+// _____________________________________________________________________________________________________________________
+Exporter::~Exporter() { stop(); }
+
+// _____________________________________________________________________________________________________________________
+bool Exporter::start() {
+  if (_thread.joinable()) {
+    return true;
+  }
+  if (_options.serve_http) {
+#ifdef HWINFO_WINDOWS
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+      return false;
+    }
+#endif
+    const Socket listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_socket == invalid_socket) {
+#ifdef HWINFO_WINDOWS
+      WSACleanup();
+#endif
+      return false;
+    }
+    const int enable = 1;
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&enable), sizeof(enable));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(_options.port);
+    socklen_t length = sizeof(address);
+    if (inet_pton(AF_INET, _options.address.c_str(), &address.sin_addr) != 1 ||
+        bind(listen_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_socket, 16) != 0 ||
+        getsockname(listen_socket, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+      closeSocket(listen_socket);
+#ifdef HWINFO_WINDOWS
+      WSACleanup();
+#endif
+      return false;
+    }
+    _listen = static_cast<intptr_t>(listen_socket);
+    _port = ntohs(address.sin_port);
+  }
+  render();
+  _stop = false;
+  _thread = std::thread(&Exporter::run, this);
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void Exporter::stop() {
+  _stop = true;
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+  if (_listen != -1) {
+    closeSocket(toSocket(_listen));
+    _listen = -1;
+    _port = 0;
+#ifdef HWINFO_WINDOWS
+    WSACleanup();
+#endif
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool Exporter::running() const { return _thread.joinable(); }
+
+// _____________________________________________________________________________________________________________________
+uint16_t Exporter::port() const { return _port; }
+
+// _____________________________________________________________________________________________________________________
+void Exporter::update() {
+  Record records[256];
+  bool changed = false;
+  for (size_t count; (count = _collector.pop(records, 256)) > 0;) {
+    for (size_t i = 0; i < count; ++i) {
+      const Record& record = records[i];
+      auto it = _series.find(seriesKey(record.metric, record.index));
+      if (it == _series.end()) {
+        // the label set is rendered once per source
+        it = _series.emplace(seriesKey(record.metric, record.index), Series{}).first;
+        it->second.labels = renderLabels(_collector, record.metric, record.index);
+      }
+      std::memcpy(it->second.values, record.values, sizeof(record.values));
+    }
+    changed = true;
+  }
+  if (changed) {
+    render();
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Exporter::scrape(std::string& out) const {
+  std::lock_guard<std::mutex> lock(_text_mutex);
+  out.assign(_text);
+}
+
+// _____________________________________________________________________________________________________________________
+void Exporter::render() {
+  // _render keeps the capacity of the text it was swapped with, steady state rendering does not allocate
+  _render.clear();
+  char number[32];
+  for (const auto& family : families) {
+    const auto begin = _series.lower_bound(seriesKey(family.metric, 0));
+    const auto end = _series.upper_bound(seriesKey(family.metric, 0xffff));
+    if (begin == end) {
+      continue;
+    }
+    _render.append("# TYPE ").append(family.name).append(family.counter ? " counter\n" : " gauge\n");
+    _render.append("# HELP ").append(family.name).append(" ").append(family.help).append("\n");
+    for (auto it = begin; it != end; ++it) {
+      const double value = it->second.values[family.value];
+      // unavailable values (-1) are not exposed
+      if (value < 0.0) {
+        continue;
+      }
+      const size_t length = utils::formatDouble(value * family.scale, number, sizeof(number));
+      _render.append(family.name).append(family.counter ? "_total" : "").append(it->second.labels).append(" ").append(number, length).append("\n");
+    }
+  }
+  _render.append("# EOF\n");
+  std::lock_guard<std::mutex> lock(_text_mutex);
+  _text.swap(_render);
+}
+
+// _____________________________________________________________________________________________________________________
+void Exporter::run() {
+  auto next_update = std::chrono::steady_clock::now() + _options.refresh;
+  while (!_stop) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= next_update) {
+      update();
+      next_update = now + _options.refresh;
+    }
+    // wake up at least every 100 ms to notice stop()
+    const auto wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(next_update - now).count();
+    const int timeout_ms = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(wait_ms, 100)));
+    if (_listen == -1) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+      continue;
+    }
+    pollfd fd{};
+    fd.fd = toSocket(_listen);
+    fd.events = POLLIN;
+    if (pollSockets(&fd, 1, timeout_ms) > 0 && (fd.revents & POLLIN) != 0) {
+      const Socket client = accept(toSocket(_listen), nullptr, nullptr);
+      if (client != invalid_socket) {
+        serve(static_cast<intptr_t>(client));
+      }
+    }
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Exporter::serve(intptr_t handle) {
+  const Socket client = toSocket(handle);
+  // a slow or stalled client must not block the exporter
+#ifdef HWINFO_WINDOWS
+  const DWORD timeout_ms = 1000;
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+  setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+#else
+  const timeval timeout{1, 0};
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+  const int enable = 1;
+  setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+#endif
+  // only the request line matters, the headers are read and ignored
+  char request[2048];
+  size_t length = 0;
+  while (length < sizeof(request) - 1) {
+    const auto received = recv(client, request + length, static_cast<int>(sizeof(request) - 1 - length), 0);
+    if (received <= 0) {
+      break;
+    }
+    length += static_cast<size_t>(received);
+    request[length] = '\0';
+    if (std::strstr(request, "\r\n\r\n") != nullptr) {
+      break;
+    }
+  }
+  request[length] = '\0';
+
+  static constexpr char not_found[] =
+      "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\nConnection: close\r\n\r\n"
+      "Not Found\n";
+  const bool metrics =
+      std::strncmp(request, "GET /metrics ", 13) == 0 || std::strncmp(request, "GET /metrics?", 13) == 0;
+  if (!metrics) {
+    sendAll(client, not_found, sizeof(not_found) - 1);
+  } else {
+    std::lock_guard<std::mutex> lock(_text_mutex);
+    char header[192];
+    const int header_length =
+        std::snprintf(header, sizeof(header),
+                      "HTTP/1.1 200 OK\r\n"
+                      "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                      "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                      _text.size());
+    if (sendAll(client, header, static_cast<size_t>(header_length))) {
+      sendAll(client, _text.data(), _text.size());
+    }
+  }
+  closeSocket(client);
+}
+
+}  // namespace hwinfo
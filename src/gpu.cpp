@@ -3,6 +3,8 @@
 
 #include "hwinfo/gpu.h"
 
+#include <algorithm>
+#include <memory>
 #include <string>
 
 namespace hwinfo {
@@ -34,4 +36,121 @@ const std::string& GPU::vendor_id() const { return _vendor_id; }
 // _____________________________________________________________________________________________________________________
 const std::string& GPU::device_id() const { return _device_id; }
 
+// _____________________________________________________________________________________________________________________
+const std::string& GPU::pci_bus_id() const { return _pci_bus_id; }
+
+// _____________________________________________________________________________________________________________________
+bool GPU::refresh() {
+  if (!_monitor) {
+    _monitor = std::make_shared<GPUMonitor>(*this, 1);
+  }
+  const auto sample = _monitor->sample();
+  _utilisation = sample.utilisation;
+  _memory_used_Bytes = sample.memory_used_Bytes;
+  _current_frequency_MHz = sample.frequency_MHz;
+  return sample.utilisation >= 0 || sample.memory_used_Bytes >= 0 || sample.frequency_MHz >= 0 || sample.power_W >= 0;
+}
+
+// _____________________________________________________________________________________________________________________
+double GPU::utilisation() const { return _utilisation; }
+
+// _____________________________________________________________________________________________________________________
+int64_t GPU::memory_used_Bytes() const { return _memory_used_Bytes; }
+
+// _____________________________________________________________________________________________________________________
+int64_t GPU::currentFrequency_MHz() const { return _current_frequency_MHz; }
+
+// =====================================================================================================================
+// _____________________________________________________________________________________________________________________
+GPUMonitor::GPUMonitor(const GPU& gpu, size_t capacity)
+    : _sources(open_sources(gpu.id())), _ring(capacity > 0 ? capacity : 1) {}
+
+// _____________________________________________________________________________________________________________________
+GPUMonitor::~GPUMonitor() { stop(); }
+
+// _____________________________________________________________________________________________________________________
+GPUMonitor::Sample GPUMonitor::sample() {
+  Sample sample;
+  {
+    // the sources are not synchronized, the read is serialized between the sampler thread and direct callers
+    std::lock_guard<std::mutex> read_lock(_read_mutex);
+    sample.timestamp = std::chrono::steady_clock::now();
+    if (_sources) {
+      read_sources(*_sources, sample);
+    }
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  _ring[_next] = sample;
+  _next = (_next + 1) % _ring.size();
+  _size = std::min(_size + 1, _ring.size());
+  return sample;
+}
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::start(std::chrono::milliseconds interval) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _interval = interval;
+    _generation++;
+    _stop = false;
+  }
+  if (_thread.joinable()) {
+    _cv.notify_all();
+    return;
+  }
+  _thread = std::thread(&GPUMonitor::run, this);
+}
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool GPUMonitor::running() const { return _thread.joinable(); }
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_stop) {
+    lock.unlock();
+    const auto sampled = std::chrono::steady_clock::now();
+    sample();
+    lock.lock();
+    // a start() with a new interval wakes the thread, the deadline is recomputed from the last sample then
+    uint64_t generation = _generation;
+    while (_cv.wait_until(lock, sampled + _interval, [&] { return _stop || _generation != generation; }) && !_stop) {
+      generation = _generation;
+    }
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<GPUMonitor::Sample> GPUMonitor::samples() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<Sample> result;
+  result.reserve(_size);
+  const size_t first = (_next + _ring.size() - _size) % _ring.size();
+  for (size_t i = 0; i < _size; ++i) {
+    result.push_back(_ring[(first + i) % _ring.size()]);
+  }
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+GPUMonitor::Sample GPUMonitor::latest() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_size == 0) {
+    return {};
+  }
+  return _ring[(_next + _ring.size() - 1) % _ring.size()];
+}
+
 }  // namespace hwinfo
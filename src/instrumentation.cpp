@@ -0,0 +1,217 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hwinfo/utils/instrumentation.h"
+
+namespace hwinfo {
+
+#ifdef HWINFO_INSTRUMENTATION
+
+namespace instrumentation {
+
+namespace {
+
+struct Registry {
+  std::mutex mutex;
+  // a deque keeps the probes at stable addresses, they are referenced by static locals of the call sites
+  std::deque<Probe> probes;
+};
+
+struct TraceEvent {
+  const char* name;
+  uint64_t thread;
+  std::chrono::steady_clock::time_point start;
+  uint64_t duration_ns;
+};
+
+struct Trace {
+  std::mutex mutex;
+  std::atomic<bool> active{false};
+  std::string path;
+  std::chrono::steady_clock::time_point start;
+  std::vector<TraceEvent> events;
+};
+
+Registry& registry() {
+  static Registry instance;
+  return instance;
+}
+
+Trace& trace() {
+  static Trace instance;
+  return instance;
+}
+
+uint64_t threadId() {
+  thread_local const uint64_t id = std::hash<std::thread::id>()(std::this_thread::get_id()) & 0xffffffff;
+  return id;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+Probe& probe(const char* name) {
+  auto& instance = registry();
+  std::lock_guard<std::mutex> lock(instance.mutex);
+  // the same name may be used by more than one call site (e.g. an inline helper)
+  for (auto& existing : instance.probes) {
+    if (std::strcmp(existing.name, name) == 0) {
+      return existing;
+    }
+  }
+  instance.probes.emplace_back();
+  instance.probes.back().name = name;
+  return instance.probes.back();
+}
+
+// _____________________________________________________________________________________________________________________
+Probe*& current() {
+  thread_local Probe* probe = nullptr;
+  return probe;
+}
+
+// _____________________________________________________________________________________________________________________
+Scope::Scope(Probe& probe) : _probe(probe), _parent(current()), _start(std::chrono::steady_clock::now()) {
+  current() = &_probe;
+}
+
+// _____________________________________________________________________________________________________________________
+Scope::~Scope() {
+  current() = _parent;
+  const auto duration_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+  _probe.calls.fetch_add(1, std::memory_order_relaxed);
+  _probe.wall_time_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+  uint64_t max = _probe.max_wall_time_ns.load(std::memory_order_relaxed);
+  while (duration_ns > max &&
+         !_probe.max_wall_time_ns.compare_exchange_weak(max, duration_ns, std::memory_order_relaxed)) {
+  }
+  auto& recording = trace();
+  if (recording.active.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(recording.mutex);
+    if (recording.active.load(std::memory_order_relaxed)) {
+      recording.events.push_back({_probe.name, threadId(), _start, duration_ns});
+    }
+  }
+}
+
+}  // namespace instrumentation
+
+// _____________________________________________________________________________________________________________________
+std::vector<ProbeStats> stats() {
+  auto& instance = instrumentation::registry();
+  std::vector<ProbeStats> result;
+  {
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    result.reserve(instance.probes.size());
+    for (const auto& probe : instance.probes) {
+      ProbeStats entry;
+      entry.name = probe.name;
+      entry.calls = probe.calls.load(std::memory_order_relaxed);
+      entry.wall_time_ns = probe.wall_time_ns.load(std::memory_order_relaxed);
+      entry.max_wall_time_ns = probe.max_wall_time_ns.load(std::memory_order_relaxed);
+      entry.syscalls = probe.syscalls.load(std::memory_order_relaxed);
+      entry.file_opens = probe.file_opens.load(std::memory_order_relaxed);
+      entry.read_Bytes = probe.read_Bytes.load(std::memory_order_relaxed);
+      result.push_back(std::move(entry));
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const ProbeStats& a, const ProbeStats& b) { return a.name < b.name; });
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+void resetStats() {
+  auto& instance = instrumentation::registry();
+  std::lock_guard<std::mutex> lock(instance.mutex);
+  for (auto& probe : instance.probes) {
+    probe.calls = 0;
+    probe.wall_time_ns = 0;
+    probe.max_wall_time_ns = 0;
+    probe.syscalls = 0;
+    probe.file_opens = 0;
+    probe.read_Bytes = 0;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool startTrace(const std::string& path) {
+  auto& recording = instrumentation::trace();
+  std::lock_guard<std::mutex> lock(recording.mutex);
+  if (recording.active) {
+    return false;
+  }
+  recording.path = path;
+  recording.start = std::chrono::steady_clock::now();
+  recording.events.clear();
+  recording.active = true;
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+bool stopTrace() {
+  auto& recording = instrumentation::trace();
+  std::vector<instrumentation::TraceEvent> events;
+  std::string path;
+  std::chrono::steady_clock::time_point start;
+  {
+    std::lock_guard<std::mutex> lock(recording.mutex);
+    if (!recording.active) {
+      return false;
+    }
+    recording.active = false;
+    events.swap(recording.events);
+    path.swap(recording.path);
+    start = recording.start;
+  }
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  // probe names are identifiers, they never need to be escaped
+  std::fputs("{\"traceEvents\":[", file);
+  for (size_t i = 0; i < events.size(); ++i) {
+    const auto& event = events[i];
+    const double ts_us =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(event.start - start).count()) / 1e3;
+    std::fprintf(file,
+                 "%s\n{\"name\":\"%s\",\"cat\":\"hwinfo\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,"
+                 "\"tid\":%llu}",
+                 i == 0 ? "" : ",", event.name, ts_us, static_cast<double>(event.duration_ns) / 1e3,
+                 static_cast<unsigned long long>(event.thread));
+  }
+  std::fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+  return std::fclose(file) == 0;
+}
+
+#else
+
+// _____________________________________________________________________________________________________________________
+std::vector<ProbeStats> stats() { return {}; }
+
+// _____________________________________________________________________________________________________________________
+void resetStats() {}
+
+// _____________________________________________________________________________________________________________________
+bool startTrace(const std::string&) { return false; }
+
+// _____________________________________________________________________________________________________________________
+bool stopTrace() { return false; }
+
+#endif  // HWINFO_INSTRUMENTATION
+
+}  // namespace hwinfo
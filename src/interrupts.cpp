@@ -0,0 +1,123 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/interrupts.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hwinfo {
+
+namespace {
+
+// the kernel counts in unsigned int per CPU, a smaller value than before is a wrap around of 32 bit
+uint64_t increment(uint64_t current, uint64_t previous) {
+  if (current >= previous) {
+    return current - previous;
+  }
+  return previous <= UINT32_MAX ? current + (uint64_t{1} << 32) - previous : 0;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+bool InterruptSampler::sample() {
+  const auto now = std::chrono::steady_clock::now();
+  if (!read_counters()) {
+    return false;
+  }
+  const size_t columns = _cpus.size();
+  _deltas.assign(_counts.size(), 0);
+  const bool first = _previous_counts.empty();
+  _interval_s = first ? 0.0 : std::chrono::duration<double>(now - _last).count();
+  bool same_rows = _previous_names.size() == _sources.size();
+  for (size_t row = 0; same_rows && row < _sources.size(); ++row) {
+    same_rows = _previous_names[row] == _sources[row].name;
+  }
+  if (!first && same_rows && _previous_cpus == _cpus) {
+    for (size_t i = 0; i < _counts.size(); ++i) {
+      _deltas[i] = increment(_counts[i], _previous_counts[i]);
+    }
+  } else if (!first) {
+    // IRQs were (un)registered or CPUs went on- or offline: match rows by name and columns by CPU number
+    std::unordered_map<std::string, size_t> previous_rows;
+    for (size_t row = 0; row < _previous_names.size(); ++row) {
+      previous_rows.emplace(_previous_names[row], row);
+    }
+    std::vector<int> previous_columns(columns, -1);
+    for (size_t column = 0; column < columns; ++column) {
+      const auto it = std::find(_previous_cpus.begin(), _previous_cpus.end(), _cpus[column]);
+      if (it != _previous_cpus.end()) previous_columns[column] = static_cast<int>(it - _previous_cpus.begin());
+    }
+    for (size_t row = 0; row < _sources.size(); ++row) {
+      const auto it = previous_rows.find(_sources[row].name);
+      if (it == previous_rows.end()) continue;
+      for (size_t column = 0; column < columns; ++column) {
+        if (previous_columns[column] < 0) continue;
+        const uint64_t previous = _previous_counts[it->second * _previous_cpus.size() + previous_columns[column]];
+        _deltas[row * columns + column] = increment(_counts[row * columns + column], previous);
+      }
+    }
+  }
+  if (!same_rows) {
+    _previous_names.clear();
+    for (const auto& source : _sources) {
+      _previous_names.push_back(source.name);
+    }
+  }
+  _previous_cpus = _cpus;
+  _previous_counts = _counts;
+  _last = now;
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+uint64_t InterruptSampler::delta(size_t source, size_t column) const {
+  if (source >= _sources.size() || column >= _cpus.size()) {
+    return 0;
+  }
+  return _deltas[source * _cpus.size() + column];
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint64_t> InterruptSampler::cpuDeltas(Source::Kind kind) const {
+  std::vector<uint64_t> sums(_cpus.size(), 0);
+  for (size_t row = 0; row < _sources.size(); ++row) {
+    if (_sources[row].kind != kind) continue;
+    for (size_t column = 0; column < sums.size(); ++column) {
+      sums[column] += _deltas[row * sums.size() + column];
+    }
+  }
+  return sums;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint64_t> InterruptSampler::interfaceDeltas(const std::string& interface) const {
+  std::vector<uint64_t> sums(_cpus.size(), 0);
+  for (size_t row = 0; row < _sources.size() && !interface.empty(); ++row) {
+    if (_sources[row].interface != interface) continue;
+    for (size_t column = 0; column < sums.size(); ++column) {
+      sums[column] += _deltas[row * sums.size() + column];
+    }
+  }
+  return sums;
+}
+
+// _____________________________________________________________________________________________________________________
+double InterruptSampler::imbalance(const std::vector<uint64_t>& per_cpu) {
+  uint64_t sum = 0;
+  uint64_t max = 0;
+  for (const uint64_t value : per_cpu) {
+    sum += value;
+    max = std::max(max, value);
+  }
+  if (sum == 0) {
+    return -1.0;
+  }
+  return static_cast<double>(max) * static_cast<double>(per_cpu.size()) / static_cast<double>(sum);
+}
+
+}  // namespace hwinfo
@@ -0,0 +1,315 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/inventory_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef HWINFO_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef HWINFO_APPLE
+#include <sys/sysctl.h>
+#endif
+
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/sysfs.h"
+
+namespace hwinfo {
+
+namespace {
+
+constexpr char cache_magic[4] = {'H', 'W', 'I', 'C'};
+// bump when the header changes, the payload carries its own version (see serializeSnapshot())
+constexpr uint32_t cache_version = 1;
+// magic, version and key length
+constexpr size_t header_size = sizeof(cache_magic) + 2 * sizeof(uint32_t);
+
+uint64_t fnv1a(uint64_t hash, const std::string& value) {
+  for (const char c : value) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// bit mask of the options that change the content of the cache
+uint64_t optionsMask(const Options& options) {
+  uint64_t mask = 0;
+  int bit = 0;
+  for (const bool flag : {options.cpu, options.os, options.gpu, options.gpu_opencl, options.ram, options.mainboard,
+                          options.battery, options.disk, options.network, options.monitor, options.pci}) {
+    mask |= static_cast<uint64_t>(flag) << bit++;
+  }
+  mask |= static_cast<uint64_t>(options.disk_fields) << 16;
+  mask |= static_cast<uint64_t>(options.network_fields) << 32;
+  mask |= static_cast<uint64_t>(options.ram_fields) << 48;
+  return mask;
+}
+
+// hash over the device names that appear or disappear with hot-plugging
+uint64_t deviceFingerprint() {
+  uint64_t hash = 0xcbf29ce484222325ull;
+#ifdef HWINFO_UNIX
+  for (const char* directory : {"/sys/bus/pci/devices", "/sys/class/block", "/sys/class/drm"}) {
+    auto entries = filesystem::getDirectoryEntries(filesystem::rooted(directory));
+    std::sort(entries.begin(), entries.end());
+    for (const auto& entry : entries) {
+      hash = fnv1a(hash, entry + '\n');
+    }
+  }
+#endif
+  return hash;
+}
+
+std::string defaultPath() {
+#if defined(HWINFO_WINDOWS)
+  const char* local_app_data = std::getenv("LOCALAPPDATA");
+  if (local_app_data == nullptr) {
+    return {};
+  }
+  std::string directory = std::string(local_app_data) + "\\hwinfo";
+  CreateDirectoryA(directory.c_str(), nullptr);
+  return directory + "\\inventory.cache";
+#elif defined(HWINFO_APPLE)
+  const char* tmp = std::getenv("TMPDIR");
+  std::string directory = tmp != nullptr ? tmp : "/tmp/";
+  if (directory.back() != '/') directory.push_back('/');
+  return directory + "hwinfo-inventory-" + std::to_string(getuid()) + ".cache";
+#else
+  if (const char* runtime = std::getenv("XDG_RUNTIME_DIR"); runtime != nullptr && runtime[0] != '\0') {
+    return std::string(runtime) + "/hwinfo-inventory.cache";
+  }
+  return "/tmp/hwinfo-inventory-" + std::to_string(getuid()) + ".cache";
+#endif
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+Options staticInventoryOptions() {
+  Options options;
+  options.gpu_opencl = false;
+  options.battery = false;
+  options.network = false;
+  options.disk_fields = DiskFields::Vendor | DiskFields::Model | DiskFields::Serial | DiskFields::Capacity;
+  options.ram_fields = MemoryFields::All;
+  return options;
+}
+
+// _____________________________________________________________________________________________________________________
+std::string bootId() {
+  std::string id;
+#if defined(HWINFO_UNIX)
+  filesystem::SysfsReader(filesystem::rooted("/proc/sys/kernel/random/boot_id")).read(id);
+#elif defined(HWINFO_APPLE)
+  char buffer[64];
+  size_t size = sizeof(buffer);
+  if (sysctlbyname("kern.bootsessionuuid", buffer, &size, nullptr, 0) == 0 && size > 0) {
+    id.assign(buffer, strnlen(buffer, size));
+  }
+#elif defined(HWINFO_WINDOWS)
+  DWORD boot_id = 0;
+  DWORD size = sizeof(boot_id);
+  if (RegGetValueA(HKEY_LOCAL_MACHINE,
+                   "SYSTEM\\CurrentControlSet\\Control\\Session Manager\\Memory Management\\PrefetchParameters",
+                   "BootId", RRF_RT_REG_DWORD, nullptr, &boot_id, &size) == ERROR_SUCCESS) {
+    id = std::to_string(boot_id);
+  } else {
+    // boot time in units of 10 s, the difference of the two clocks jitters by a few milliseconds
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    const uint64_t now_100ns = (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+    id = "boot-time:" + std::to_string((now_100ns - GetTickCount64() * 10000) / 100000000);
+  }
+#endif
+  return id;
+}
+
+// _____________________________________________________________________________________________________________________
+InventoryCache::InventoryCache(InventoryCacheOptions options)
+    : _options(std::move(options)), _path(_options.path.empty() ? defaultPath() : _options.path) {}
+
+// _____________________________________________________________________________________________________________________
+InventoryCache::~InventoryCache() { unmap(); }
+
+// _____________________________________________________________________________________________________________________
+std::string InventoryCache::key() const {
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), ";options=%016llx;devices=%016llx",
+                static_cast<unsigned long long>(optionsMask(_options.options)),
+                static_cast<unsigned long long>(_options.revalidate ? deviceFingerprint() : 0));
+  return "boot=" + bootId() + buffer;
+}
+
+// _____________________________________________________________________________________________________________________
+bool InventoryCache::load() {
+  HWINFO_PROBE("inventory_cache.load");
+  _view = SnapshotView(nullptr, 0);
+  unmap();
+  _buffer.clear();
+  _from_cache = false;
+
+  const std::string cache_key = key();
+  // without a boot ID the cache could be served across reboots
+  const bool usable = !_path.empty() && cache_key.compare(0, 6, "boot=;") != 0;
+  if (usable && map(cache_key)) {
+    _from_cache = true;
+    return true;
+  }
+  _buffer = serializeSnapshot(collect(_options.options));
+  _view = SnapshotView(_buffer);
+  if (usable) {
+    store(cache_key, _buffer);
+  }
+  return _view.valid();
+}
+
+// _____________________________________________________________________________________________________________________
+bool InventoryCache::invalidate() {
+  if (_path.empty()) {
+    return false;
+  }
+  return std::remove(_path.c_str()) == 0;
+}
+
+// _____________________________________________________________________________________________________________________
+bool InventoryCache::map(const std::string& key) {
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+#ifdef HWINFO_WINDOWS
+  HANDLE file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER file_size;
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > static_cast<LONGLONG>(header_size)) {
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+      // the view keeps the mapping alive after both handles are closed
+      data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      size = static_cast<size_t>(file_size.QuadPart);
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+#else
+  const int fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  HWINFO_COUNT_OPEN();
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st{};
+  // a cache file of another user could have been planted in a shared directory
+  if (fstat(fd, &st) == 0 && st.st_uid == getuid() && st.st_size > static_cast<off_t>(header_size)) {
+    HWINFO_COUNT_SYSCALL();
+    void* address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+      data = static_cast<const uint8_t*>(address);
+      size = static_cast<size_t>(st.st_size);
+    }
+  }
+  ::close(fd);
+#endif
+  if (data == nullptr) {
+    return false;
+  }
+  _mapping = data;
+  _mapping_size = size;
+
+  uint32_t version = 0;
+  uint32_t key_size = 0;
+  std::memcpy(&version, data + sizeof(cache_magic), sizeof(version));
+  std::memcpy(&key_size, data + sizeof(cache_magic) + sizeof(version), sizeof(key_size));
+  if (std::memcmp(data, cache_magic, sizeof(cache_magic)) != 0 || version != cache_version ||
+      key_size != key.size() || size - header_size < key_size ||
+      std::memcmp(data + header_size, key.data(), key_size) != 0) {
+    unmap();
+    return false;
+  }
+  _view = SnapshotView(data + header_size + key_size, size - header_size - key_size);
+  if (!_view.valid()) {
+    unmap();
+    return false;
+  }
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void InventoryCache::unmap() {
+  if (_mapping == nullptr) {
+    return;
+  }
+  _view = SnapshotView(nullptr, 0);
+#ifdef HWINFO_WINDOWS
+  UnmapViewOfFile(_mapping);
+#else
+  munmap(const_cast<uint8_t*>(_mapping), _mapping_size);
+#endif
+  _mapping = nullptr;
+  _mapping_size = 0;
+}
+
+// _____________________________________________________________________________________________________________________
+bool InventoryCache::store(const std::string& key, const std::vector<uint8_t>& payload) const {
+  std::vector<uint8_t> content(header_size + key.size() + payload.size());
+  const auto key_size = static_cast<uint32_t>(key.size());
+  std::memcpy(content.data(), cache_magic, sizeof(cache_magic));
+  std::memcpy(content.data() + sizeof(cache_magic), &cache_version, sizeof(cache_version));
+  std::memcpy(content.data() + sizeof(cache_magic) + sizeof(cache_version), &key_size, sizeof(key_size));
+  std::memcpy(content.data() + header_size, key.data(), key.size());
+  std::memcpy(content.data() + header_size + key.size(), payload.data(), payload.size());
+
+  // readers either map the old or the new file, never a partially written one
+#ifdef HWINFO_WINDOWS
+  const std::string temporary = _path + "." + std::to_string(GetCurrentProcessId()) + ".tmp";
+  HANDLE file =
+      CreateFileA(temporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  DWORD written = 0;
+  const bool ok = WriteFile(file, content.data(), static_cast<DWORD>(content.size()), &written, nullptr) &&
+                  written == content.size();
+  CloseHandle(file);
+  if (!ok || !MoveFileExA(temporary.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+    DeleteFileA(temporary.c_str());
+    return false;
+  }
+  return true;
+#else
+  std::string temporary = _path + ".XXXXXX";
+  const int fd = mkstemp(&temporary[0]);
+  if (fd < 0) {
+    return false;
+  }
+  size_t offset = 0;
+  while (offset < content.size()) {
+    const ssize_t n = ::write(fd, content.data() + offset, content.size() - offset);
+    if (n <= 0) {
+      break;
+    }
+    offset += static_cast<size_t>(n);
+  }
+  ::close(fd);
+  if (offset != content.size() || std::rename(temporary.c_str(), _path.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+#endif
+}
+
+}  // namespace hwinfo
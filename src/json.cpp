@@ -0,0 +1,663 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/json.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#ifdef HWINFO_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "hwinfo/utils/stringutils.h"
+
+namespace hwinfo {
+
+namespace {
+
+// _____________________________________________________________________________________________________________________
+const char* metricName(Metric metric) {
+  switch (metric) {
+    case Metric::CpuUtilisation:
+      return "cpu_utilisation";
+    case Metric::CpuFrequency:
+      return "cpu_frequency";
+    case Metric::Memory:
+      return "memory";
+    case Metric::DiskIO:
+      return "disk_io";
+    case Metric::Network:
+      return "network";
+    case Metric::Gpu:
+      return "gpu";
+    case Metric::Process:
+      return "process";
+    case Metric::PerfCounters:
+      return "perf_counters";
+    case Metric::NetworkTotals:
+      return "network_totals";
+    case Metric::DiskIOTotals:
+      return "disk_io_totals";
+    case Metric::ProcessTotals:
+      return "process_totals";
+  }
+  return "unknown";
+}
+
+// _____________________________________________________________________________________________________________________
+template <typename T, typename Fn>
+void writeArray(JsonWriter& json, std::string_view name, const std::vector<T>& items, Fn&& write) {
+  json.key(name).beginArray();
+  for (const auto& item : items) {
+    write(item);
+  }
+  json.endArray();
+}
+
+// _____________________________________________________________________________________________________________________
+template <typename T>
+void writeArray(JsonWriter& json, std::string_view name, const std::vector<T>& items) {
+  writeArray(json, name, items, [&](const T& item) { to_json(json, item); });
+}
+
+// _____________________________________________________________________________________________________________________
+template <typename T>
+void writeValues(JsonWriter& json, std::string_view name, const std::vector<T>& items) {
+  writeArray(json, name, items, [&](const T& item) { json.value(item); });
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+JsonWriter::JsonWriter(int fd, Format format)
+    : _format(format), _fd(fd), _buffer(_staging), _capacity(sizeof(_staging)) {}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter::JsonWriter(std::string& out, Format format) : _format(format), _string(&out) {}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter::JsonWriter(char* buffer, size_t size, Format format) : _format(format), _buffer(buffer), _capacity(size) {}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter::~JsonWriter() { flush(); }
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::beginObject() {
+  separate();
+  put('{');
+  if (_depth < max_depth) {
+    _empty |= uint64_t{1} << _depth;
+  }
+  ++_depth;
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::endObject() {
+  --_depth;
+  put('}');
+  finishValue();
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::beginArray() {
+  separate();
+  put('[');
+  if (_depth < max_depth) {
+    _empty |= uint64_t{1} << _depth;
+  }
+  ++_depth;
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::endArray() {
+  --_depth;
+  put(']');
+  finishValue();
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::key(std::string_view name) {
+  value(name);
+  put(':');
+  _after_key = true;
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::value(std::string_view value) {
+  separate();
+  static constexpr char hex[] = "0123456789abcdef";
+  put('"');
+  size_t begin = 0;
+  for (size_t i = 0; i < value.size(); ++i) {
+    const auto c = static_cast<unsigned char>(value[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    // runs of characters that need no escaping are written at once
+    write(value.data() + begin, i - begin);
+    begin = i + 1;
+    char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+    switch (c) {
+      case '"':
+      case '\\':
+        escape[1] = static_cast<char>(c);
+        write(escape, 2);
+        break;
+      case '\n':
+        write("\\n", 2);
+        break;
+      case '\r':
+        write("\\r", 2);
+        break;
+      case '\t':
+        write("\\t", 2);
+        break;
+      default:
+        write(escape, sizeof(escape));
+    }
+  }
+  write(value.data() + begin, value.size() - begin);
+  put('"');
+  finishValue();
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::value(const char* value) { return this->value(std::string_view(value)); }
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::value(double value) {
+  if (!std::isfinite(value)) {
+    return null();
+  }
+  separate();
+  char buffer[32];
+  write(buffer, utils::formatDouble(value, buffer, sizeof(buffer)));
+  finishValue();
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::value(bool value) {
+  separate();
+  if (value) {
+    write("true", 4);
+  } else {
+    write("false", 5);
+  }
+  finishValue();
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::null() {
+  separate();
+  write("null", 4);
+  finishValue();
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::integer(int64_t value) {
+  separate();
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  write(buffer, static_cast<size_t>(result.ptr - buffer));
+  finishValue();
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+JsonWriter& JsonWriter::unsignedInteger(uint64_t value) {
+  separate();
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  write(buffer, static_cast<size_t>(result.ptr - buffer));
+  finishValue();
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+void JsonWriter::separate() {
+  if (_after_key) {
+    _after_key = false;
+    return;
+  }
+  if (_depth == 0 || _depth > max_depth) {
+    return;
+  }
+  const uint64_t bit = uint64_t{1} << (_depth - 1);
+  if ((_empty & bit) != 0) {
+    _empty &= ~bit;
+  } else {
+    put(',');
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void JsonWriter::finishValue() {
+  if (_depth == 0 && !_after_key && _format == Format::Ndjson) {
+    put('\n');
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void JsonWriter::write(const char* data, size_t size) {
+  _size += size;
+  if (_string != nullptr) {
+    _string->append(data, size);
+    return;
+  }
+  while (size > 0) {
+    if (_length == _capacity) {
+      if (_fd < 0) {
+        _ok = false;
+        return;
+      }
+      flush();
+    }
+    const size_t chunk = std::min(size, _capacity - _length);
+    std::memcpy(_buffer + _length, data, chunk);
+    _length += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void JsonWriter::flush() {
+  if (_fd < 0) {
+    return;
+  }
+  size_t written = 0;
+  while (written < _length) {
+#ifdef HWINFO_WINDOWS
+    const int result = _write(_fd, _buffer + written, static_cast<unsigned int>(_length - written));
+#else
+    const ssize_t result = ::write(_fd, _buffer + written, _length - written);
+#endif
+    if (result <= 0) {
+      _ok = false;
+      break;
+    }
+    written += static_cast<size_t>(result);
+  }
+  _length = 0;
+}
+
+// _____________________________________________________________________________________________________________________
+bool JsonWriter::ok() const { return _ok; }
+
+// _____________________________________________________________________________________________________________________
+size_t JsonWriter::size() const { return _size; }
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const CPU& cpu) {
+  json.beginObject()
+      .field("id", cpu.id())
+      .field("vendor", cpu.vendor())
+      .field("model", cpu.modelName())
+      .field("physical_cores", cpu.numPhysicalCores())
+      .field("logical_cores", cpu.numLogicalCores())
+      .field("max_clock_speed_MHz", cpu.maxClockSpeed_MHz())
+      .field("regular_clock_speed_MHz", cpu.regularClockSpeed_MHz())
+      .field("L1_cache_size_Bytes", cpu.L1CacheSize_Bytes())
+      .field("L2_cache_size_Bytes", cpu.L2CacheSize_Bytes())
+      .field("L3_cache_size_Bytes", cpu.L3CacheSize_Bytes());
+  writeValues(json, "flags", cpu.flags());
+  json.endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const CacheInfo& cache) {
+  const char* type = cache.type == CacheInfo::Type::Data          ? "data"
+                     : cache.type == CacheInfo::Type::Instruction ? "instruction"
+                                                                  : "unified";
+  json.beginObject()
+      .field("level", cache.level)
+      .field("type", type)
+      .field("size_Bytes", cache.size_Bytes)
+      .field("line_size_Bytes", cache.line_size_Bytes)
+      .field("associativity", cache.associativity)
+      .field("sets", cache.sets);
+  writeValues(json, "shared_cpus", cache.shared_cpus);
+  json.endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const CpuBudget& budget) {
+  json.beginObject();
+  writeValues(json, "allowed_cpus", budget.allowed_cpus);
+  json.field("quota_cpus", budget.quota_cpus)
+      .field("effective_cpus", budget.effective_cpus)
+      .field("nr_periods", budget.nr_periods)
+      .field("nr_throttled", budget.nr_throttled)
+      .field("throttled_us", budget.throttled_us)
+      .field("cgroup_version", budget.cgroup_version)
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const OS& os) {
+  json.beginObject()
+      .field("name", os.name())
+      .field("version", os.version())
+      .field("kernel", os.kernel())
+      .field("bits", os.is64bit() ? 64 : 32)
+      .field("endianness", os.isLittleEndian() ? "little" : "big")
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const GPU& gpu) {
+  json.beginObject()
+      .field("id", gpu.id())
+      .field("vendor", gpu.vendor())
+      .field("name", gpu.name())
+      .field("driver_version", gpu.driverVersion())
+      .field("memory_Bytes", gpu.memory_Bytes())
+      .field("frequency_MHz", gpu.frequency_MHz())
+      .field("num_cores", gpu.num_cores())
+      .field("vendor_id", gpu.vendor_id())
+      .field("device_id", gpu.device_id())
+      .field("pci_bus_id", gpu.pci_bus_id())
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const Memory& memory) {
+  json.beginObject()
+      .field("total_Bytes", memory.total_Bytes())
+      .field("free_Bytes", memory.free_Bytes())
+      .field("available_Bytes", memory.available_Bytes());
+  writeArray(json, "modules", memory.modules());
+  json.key("topology");
+  to_json(json, memory.topology());
+  json.endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const Memory::Module& module) {
+  json.beginObject()
+      .field("id", module.id)
+      .field("vendor", module.vendor)
+      .field("name", module.name)
+      .field("model", module.model)
+      .field("serial_number", module.serial_number)
+      .field("total_Bytes", module.total_Bytes)
+      .field("frequency_Hz", module.frequency_Hz)
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const MemoryStats& stats) {
+  json.beginObject()
+      .field("total_Bytes", stats.total_Bytes)
+      .field("free_Bytes", stats.free_Bytes)
+      .field("available_Bytes", stats.available_Bytes)
+      .field("buffers_Bytes", stats.buffers_Bytes)
+      .field("cached_Bytes", stats.cached_Bytes)
+      .field("shmem_Bytes", stats.shmem_Bytes)
+      .field("dirty_Bytes", stats.dirty_Bytes)
+      .field("swap_total_Bytes", stats.swap_total_Bytes)
+      .field("swap_free_Bytes", stats.swap_free_Bytes)
+      .field("huge_pages_total", stats.huge_pages_total)
+      .field("huge_pages_free", stats.huge_pages_free)
+      .field("huge_page_size_Bytes", stats.huge_page_size_Bytes)
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const MemoryTopology& topology) {
+  json.beginObject()
+      .field("page_size_Bytes", topology.page_size_Bytes)
+      .field("thp_enabled", topology.thp_enabled)
+      .field("thp_defrag", topology.thp_defrag)
+      .field("thp_page_size_Bytes", topology.thp_page_size_Bytes)
+      .field("default_huge_page_size_Bytes", topology.default_huge_page_size_Bytes);
+  writeArray(json, "huge_pages", topology.huge_pages);
+  writeArray(json, "nodes", topology.nodes);
+  json.endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const MemoryNode& node) {
+  json.beginObject().field("id", node.id);
+  writeValues(json, "cpus", node.cpus);
+  json.field("total_Bytes", node.total_Bytes).field("free_Bytes", node.free_Bytes);
+  writeArray(json, "huge_pages", node.huge_pages);
+  json.endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const HugePagePool& pool) {
+  json.beginObject()
+      .field("page_size_Bytes", pool.page_size_Bytes)
+      .field("total", pool.total)
+      .field("free", pool.free)
+      .field("reserved", pool.reserved)
+      .field("surplus", pool.surplus)
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const MainBoard& board) {
+  json.beginObject()
+      .field("vendor", board.vendor())
+      .field("name", board.name())
+      .field("version", board.version())
+      .field("serial_number", board.serialNumber())
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const Battery& battery) {
+  json.beginObject()
+      .field("vendor", battery.getVendor())
+      .field("model", battery.getModel())
+      .field("serial_number", battery.getSerialNumber())
+      .field("technology", battery.getTechnology())
+      .field("energy_full", battery.getEnergyFull())
+      .field("energy_now", battery.energyNow())
+      .field("charging", battery.charging())
+      .field("power_W", battery.powerNow_W())
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const Disk& disk) {
+  json.beginObject()
+      .field("id", disk.id())
+      .field("vendor", disk.vendor())
+      .field("model", disk.model())
+      .field("serial_number", disk.serialNumber())
+      .field("size_Bytes", disk.size_Bytes())
+      .field("free_size_Bytes", disk.free_size_Bytes());
+  writeValues(json, "volumes", disk.volumes());
+  json.endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const Network& network) {
+  const auto& statistics = network.statistics();
+  json.beginObject()
+      .field("index", network.interfaceIndex())
+      .field("description", network.description())
+      .field("mac", network.mac())
+      .field("ip4", network.ip4());
+  writeValues(json, "ip6", network.ip6Addresses());
+  json.field("type", network.type())
+      .field("mtu", network.mtu())
+      .field("oper_state", network.operState())
+      .field("link_speed_Mbps", network.linkSpeed_Mbps())
+      .key("statistics")
+      .beginObject()
+      .field("rx_bytes", statistics.rx_bytes)
+      .field("tx_bytes", statistics.tx_bytes)
+      .field("rx_packets", statistics.rx_packets)
+      .field("tx_packets", statistics.tx_packets)
+      .field("rx_errors", statistics.rx_errors)
+      .field("tx_errors", statistics.tx_errors)
+      .field("rx_dropped", statistics.rx_dropped)
+      .field("tx_dropped", statistics.tx_dropped)
+      .endObject();
+  const auto& hardware = network.hardware();
+  json.key("hardware")
+      .beginObject()
+      .field("driver", hardware.driver)
+      .field("pci_address", hardware.pci_address)
+      .field("numa_node", hardware.numa_node)
+      .field("rx_queues", hardware.rx_queues)
+      .field("tx_queues", hardware.tx_queues)
+      .field("rx_channels", hardware.rx_channels)
+      .field("tx_channels", hardware.tx_channels)
+      .field("combined_channels", hardware.combined_channels)
+      .field("max_combined_channels", hardware.max_combined_channels)
+      .field("rx_ring_size", hardware.rx_ring_size)
+      .field("tx_ring_size", hardware.tx_ring_size)
+      .field("max_rx_ring_size", hardware.max_rx_ring_size)
+      .field("max_tx_ring_size", hardware.max_tx_ring_size);
+  writeValues(json, "features", hardware.features);
+  json.endObject().endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const Monitor& monitor) {
+  json.beginObject()
+      .field("vendor", monitor.vendor())
+      .field("model", monitor.model())
+      .field("resolution", monitor.resolution())
+      .field("refresh_rate", monitor.refreshRate())
+      .field("serial_number", monitor.serialNumber())
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const PCIBusDevice& device) {
+  json.beginObject()
+      .field("address", device.address())
+      .field("vendor_id", device.vendor_id())
+      .field("device_id", device.device_id())
+      .field("subvendor_id", device.subvendor_id())
+      .field("subdevice_id", device.subdevice_id())
+      .field("class_code", device.class_code())
+      .field("vendor", device.vendor())
+      .field("name", device.name())
+      .field("subsystem", device.subsystem())
+      .field("driver", device.driver())
+      .field("numa_node", device.numa_node())
+      .field("link_speed", device.link_speed())
+      .field("link_width", device.link_width())
+      .endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const Snapshot& snapshot) {
+  json.beginObject();
+  writeArray(json, "cpus", snapshot.cpus);
+  if (snapshot.os) {
+    json.key("os");
+    to_json(json, *snapshot.os);
+  }
+  writeArray(json, "gpus", snapshot.gpus);
+  if (snapshot.ram) {
+    json.key("ram");
+    to_json(json, *snapshot.ram);
+  }
+  if (snapshot.mainboard) {
+    json.key("mainboard");
+    to_json(json, *snapshot.mainboard);
+  }
+  writeArray(json, "batteries", snapshot.batteries);
+  writeArray(json, "disks", snapshot.disks);
+  writeArray(json, "networks", snapshot.networks);
+  writeArray(json, "monitors", snapshot.monitors);
+  writeArray(json, "pci_devices", snapshot.pci_devices);
+  json.endObject();
+}
+
+// _____________________________________________________________________________________________________________________
+void to_json(JsonWriter& json, const Record& record) {
+  const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(record.timestamp.time_since_epoch());
+  json.beginObject().field("timestamp_ns", timestamp.count()).field("metric", metricName(record.metric));
+  if (record.index != Record::total) {
+    json.field("index", record.index);
+  }
+  const double* values = record.values;
+  switch (record.metric) {
+    case Metric::CpuUtilisation:
+      json.field("utilisation", values[0]);
+      break;
+    case Metric::CpuFrequency:
+      json.field("frequency_MHz", values[0]);
+      break;
+    case Metric::Memory:
+      json.field("available_Bytes", values[0])
+          .field("total_Bytes", values[1])
+          .field("swap_free_Bytes", values[2])
+          .field("swap_total_Bytes", values[3]);
+      break;
+    case Metric::DiskIO:
+      json.field("read_Bytes_per_s", values[0])
+          .field("write_Bytes_per_s", values[1])
+          .field("iops", values[2])
+          .field("utilisation", values[3]);
+      break;
+    case Metric::Network:
+      json.field("rx_Bytes_per_s", values[0])
+          .field("tx_Bytes_per_s", values[1])
+          .field("rx_packets_per_s", values[2])
+          .field("tx_packets_per_s", values[3]);
+      break;
+    case Metric::Gpu:
+      json.field("utilisation", values[0])
+          .field("frequency_MHz", values[1])
+          .field("memory_used_Bytes", values[2])
+          .field("power_W", values[3]);
+      break;
+    case Metric::Process:
+      json.field("cpu_utilisation", values[0])
+          .field("rss_Bytes", values[1])
+          .field("page_faults_per_s", values[2])
+          .field("context_switches_per_s", values[3]);
+      break;
+    case Metric::PerfCounters:
+      json.field("ipc", values[0])
+          .field("cache_mpki", values[1])
+          .field("branch_mpki", values[2])
+          .field("stalled_ratio", values[3]);
+      break;
+    case Metric::NetworkTotals:
+      json.field("rx_Bytes", values[0])
+          .field("tx_Bytes", values[1])
+          .field("rx_packets", values[2])
+          .field("tx_packets", values[3]);
+      break;
+    case Metric::DiskIOTotals:
+      json.field("read_Bytes", values[0])
+          .field("write_Bytes", values[1])
+          .field("operations", values[2])
+          .field("busy_time_ms", values[3]);
+      break;
+    case Metric::ProcessTotals:
+      json.field("cpu_time_us", values[0])
+          .field("minor_faults", values[1])
+          .field("major_faults", values[2])
+          .field("context_switches", values[3]);
+      break;
+  }
+  json.endObject();
+}
+
+}  // namespace hwinfo
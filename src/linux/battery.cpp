@@ -5,133 +5,236 @@
 
 #ifdef HWINFO_UNIX
 
-#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "hwinfo/battery.h"
 #include "hwinfo/utils/constants.h"
 #include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
 
 namespace hwinfo {
 
-static std::string base_path = "/sys/class/power_supply/";
+namespace {
+
+std::string base_path() { return filesystem::rooted("/sys/class/power_supply/"); }
+
+/**
+ * The POWER_SUPPLY_* keys of one read of /sys/class/power_supply/<name>/uevent. Strings are views into the buffer,
+ * numbers are -1 if the driver does not report them. Units are those of sysfs: µWh, µAh, µW, µA and µV.
+ */
+struct Uevent {
+  char buffer[4096];
+  std::string_view manufacturer;
+  std::string_view model_name;
+  std::string_view serial_number;
+  std::string_view technology;
+  std::string_view status;
+  int64_t energy_full{-1};
+  int64_t energy_now{-1};
+  int64_t charge_full{-1};
+  int64_t charge_now{-1};
+  int64_t power_now{-1};
+  int64_t current_now{-1};
+  int64_t voltage_now{-1};
+  int64_t voltage_min_design{-1};
+
+  // drivers of coulomb counters only report charge, it is converted with the design voltage (or the current one)
+  HWI_NODISCARD int64_t toEnergy_uWh(int64_t charge_uAh) const {
+    const int64_t voltage_uV = voltage_min_design > 0 ? voltage_min_design : voltage_now;
+    return charge_uAh < 0 || voltage_uV <= 0 ? -1 : charge_uAh * (voltage_uV / 1000) / 1000;
+  }
+  HWI_NODISCARD int64_t energyFull_uWh() const { return energy_full >= 0 ? energy_full : toEnergy_uWh(charge_full); }
+  HWI_NODISCARD int64_t energyNow_uWh() const { return energy_now >= 0 ? energy_now : toEnergy_uWh(charge_now); }
+  HWI_NODISCARD double power_W() const {
+    if (power_now >= 0) {
+      return static_cast<double>(power_now) / 1e6;
+    }
+    if (current_now == -1 || voltage_now < 0) {
+      return -1.0;
+    }
+    // some drivers report the discharge current as negative value
+    return static_cast<double>(std::llabs(current_now)) * static_cast<double>(voltage_now) / 1e12;
+  }
+};
+
+std::string supply_name(const std::string& name, int id) { return name.empty() ? "BAT" + std::to_string(id) : name; }
+
+/**
+ * Reads and parses the uevent file of the power supply in one pass. The file is kept open per thread, so polling a
+ * battery is a single pread per refresh.
+ * @return false if the power supply does not exist (anymore)
+ */
+bool read_uevent(const std::string& name, Uevent& uevent) {
+  thread_local std::unordered_map<std::string, filesystem::SysfsReader> readers;
+  auto it = readers.find(name);
+  if (it == readers.end()) {
+    it = readers.emplace(name, filesystem::SysfsReader(base_path() + name + "/uevent")).first;
+  }
+  const int64_t size = it->second.read(uevent.buffer, sizeof(uevent.buffer));
+  if (size < 0) {
+    return false;
+  }
+
+  std::string_view content(uevent.buffer, static_cast<size_t>(size));
+  std::string_view line;
+  while (utils::nextLine(content, line)) {
+    if (!utils::consumePrefix(line, "POWER_SUPPLY_")) continue;
+    const size_t separator = line.find('=');
+    if (separator == std::string_view::npos) continue;
+    const std::string_view key = line.substr(0, separator);
+    const std::string_view value = line.substr(separator + 1);
+    const auto number = [&value] { return utils::toNumber<int64_t>(value).value_or(-1); };
+    if (key == "MANUFACTURER") {
+      uevent.manufacturer = value;
+    } else if (key == "MODEL_NAME") {
+      uevent.model_name = value;
+    } else if (key == "SERIAL_NUMBER") {
+      uevent.serial_number = value;
+    } else if (key == "TECHNOLOGY") {
+      uevent.technology = value;
+    } else if (key == "STATUS") {
+      uevent.status = value;
+    } else if (key == "ENERGY_FULL") {
+      uevent.energy_full = number();
+    } else if (key == "ENERGY_NOW") {
+      uevent.energy_now = number();
+    } else if (key == "CHARGE_FULL") {
+      uevent.charge_full = number();
+    } else if (key == "CHARGE_NOW") {
+      uevent.charge_now = number();
+    } else if (key == "POWER_NOW") {
+      uevent.power_now = number();
+    } else if (key == "CURRENT_NOW") {
+      uevent.current_now = number();
+    } else if (key == "VOLTAGE_NOW") {
+      uevent.voltage_now = number();
+    } else if (key == "VOLTAGE_MIN_DESIGN") {
+      uevent.voltage_min_design = number();
+    }
+  }
+  return true;
+}
+
+std::string or_unknown(std::string_view value) { return value.empty() ? constants::UNKNOWN : std::string(value); }
+
+uint32_t to_uint(int64_t value) { return value < 0 ? 0 : static_cast<uint32_t>(value); }
+
+}  // namespace
 
 // =====================================================================================================================
 // _____________________________________________________________________________________________________________________
 std::string Battery::getVendor() const {
-  if (_id < 0) {
+  Uevent uevent;
+  if (_id < 0 || !read_uevent(supply_name(_name, _id), uevent)) {
     return constants::UNKNOWN;
   }
-  std::ifstream vendor_file(base_path + "BAT" + std::to_string(_id) + "/" + "manufacturer");
-  std::string vendor;
-  if (vendor_file.is_open()) {
-    getline(vendor_file, vendor);
-    return vendor;
-  }
-  return constants::UNKNOWN;
+  return or_unknown(uevent.manufacturer);
 }
 
 // _____________________________________________________________________________________________________________________
 std::string Battery::getModel() const {
-  if (_id < 0) {
+  Uevent uevent;
+  if (_id < 0 || !read_uevent(supply_name(_name, _id), uevent)) {
     return constants::UNKNOWN;
   }
-  std::ifstream vendor_file(base_path + "BAT" + std::to_string(_id) + "/" + "model_name");
-  std::string value;
-  if (vendor_file.is_open()) {
-    getline(vendor_file, value);
-    return value;
-  }
-  return constants::UNKNOWN;
+  return or_unknown(uevent.model_name);
 }
 
 // _____________________________________________________________________________________________________________________
 std::string Battery::getSerialNumber() const {
-  if (_id < 0) {
+  Uevent uevent;
+  if (_id < 0 || !read_uevent(supply_name(_name, _id), uevent)) {
     return constants::UNKNOWN;
   }
-  std::ifstream vendor_file(base_path + "BAT" + std::to_string(_id) + "/" + "serial_number");
-  std::string value;
-  if (vendor_file.is_open()) {
-    getline(vendor_file, value);
-    return value;
-  }
-  return constants::UNKNOWN;
+  return or_unknown(uevent.serial_number);
 }
 
 // _____________________________________________________________________________________________________________________
 std::string Battery::getTechnology() const {
-  if (_id < 0) {
+  Uevent uevent;
+  if (_id < 0 || !read_uevent(supply_name(_name, _id), uevent)) {
     return constants::UNKNOWN;
   }
-  std::ifstream vendor_file(base_path + "BAT" + std::to_string(_id) + "/" + "technology");
-  std::string value;
-  if (vendor_file.is_open()) {
-    getline(vendor_file, value);
-    return value;
-  }
-  return constants::UNKNOWN;
+  return or_unknown(uevent.technology);
 }
 
 // _____________________________________________________________________________________________________________________
 uint32_t Battery::getEnergyFull() const {
-  if (_id < 0) {
+  Uevent uevent;
+  if (_id < 0 || !read_uevent(supply_name(_name, _id), uevent)) {
     return 0;
   }
-  std::ifstream vendor_file(base_path + "BAT" + std::to_string(_id) + "/" + "energy_full");
-  std::string value;
-  if (vendor_file.is_open()) {
-    getline(vendor_file, value);
-    try {
-      return std::stoi(value);
-    } catch (const std::invalid_argument& e) {
-      return 0;
-    }
-  }
-  return 0;
+  return to_uint(uevent.energyFull_uWh());
 }
 
 // _____________________________________________________________________________________________________________________
 uint32_t Battery::energyNow() const {
-  if (_id < 0) {
+  Uevent uevent;
+  if (_id < 0 || !read_uevent(supply_name(_name, _id), uevent)) {
     return 0;
   }
-  std::ifstream vendor_file(base_path + "BAT" + std::to_string(_id) + "/" + "energy_now");
-  std::string value;
-  if (vendor_file.is_open()) {
-    getline(vendor_file, value);
-    try {
-      return std::stoi(value);
-    } catch (const std::invalid_argument& e) {
-      return 0;
-    }
-  }
-  return 0;
+  return to_uint(uevent.energyNow_uWh());
 }
 
 // _____________________________________________________________________________________________________________________
 bool Battery::charging() const {
-  if (_id < 0) {
-    return false;
-  }
-  std::ifstream vendor_file(base_path + "BAT" + std::to_string(_id) + "/" + "status");
-  std::string value;
-  if (vendor_file.is_open()) {
-    getline(vendor_file, value);
-    return value == "Charging";
-  }
-  return false;
+  Uevent uevent;
+  return _id >= 0 && read_uevent(supply_name(_name, _id), uevent) && uevent.status == "Charging";
 }
 
 // _____________________________________________________________________________________________________________________
 bool Battery::discharging() const { return !charging(); }
 
+// _____________________________________________________________________________________________________________________
+double Battery::powerNow_W() const {
+  Uevent uevent;
+  if (_id < 0 || !read_uevent(supply_name(_name, _id), uevent)) {
+    return -1.0;
+  }
+  return uevent.power_W();
+}
+
+// _____________________________________________________________________________________________________________________
+bool Battery::refresh() {
+  Uevent uevent;
+  if (_id < 0 || !read_uevent(supply_name(_name, _id), uevent)) {
+    return false;
+  }
+  _energyNow = to_uint(uevent.energyNow_uWh());
+  _charging = uevent.status == "Charging";
+  _power_W = uevent.power_W();
+  return true;
+}
+
 // =====================================================================================================================
 // _____________________________________________________________________________________________________________________
 std::vector<Battery> getAllBatteries() {
+  HWINFO_PROBE("battery.sysfs");
+  // any power supply of type Battery (BAT0, CMB0, macsmc-battery, ...), not only BAT<id>. Batteries of peripherals
+  // (scope Device, e.g. wireless mice) are skipped.
+  std::vector<std::string> names;
+  for (const auto& entry : filesystem::getDirectoryEntries(base_path())) {
+    std::string type;
+    std::string scope;
+    if (!filesystem::SysfsReader(base_path() + entry + "/type").read(type) || type != "Battery") continue;
+    if (filesystem::SysfsReader(base_path() + entry + "/scope").read(scope) && scope == "Device") continue;
+    names.push_back(entry);
+  }
+  std::sort(names.begin(), names.end());
+
   std::vector<Battery> batteries;
-  int8_t id = 0;
-  while (filesystem::exists(base_path + "BAT" + std::to_string(id))) {
-    batteries.emplace_back(id++);
+  batteries.reserve(names.size());
+  for (auto& name : names) {
+    Battery battery(static_cast<int8_t>(batteries.size()));
+    battery._name = std::move(name);
+    batteries.push_back(std::move(battery));
   }
   return batteries;
 }
@@ -5,19 +5,33 @@
 
 #ifdef HWINFO_UNIX
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/auxv.h>
+#include <time.h>
 #include <unistd.h>
 
-#include <chrono>
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
-#include <fstream>
+#include <cstring>
+#include <functional>
 #include <map>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "hwinfo/cpu.h"
+#include "hwinfo/cpuid.h"
+#include "hwinfo/utils/cgroup.h"
 #include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/smbios.h"
 #include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
 
 namespace hwinfo {
 
@@ -35,8 +49,10 @@ int64_t getFrequencyFromPaths(const std::vector<std::string>& paths) {
 // _____________________________________________________________________________________________________________________
 // Get Max Clock Speed (MHz)
 int64_t getMaxClockSpeed_MHz(const int& core_id) {
-  const std::string basePath = "/sys/devices/system/cpu/cpu" + std::to_string(core_id) + "/cpufreq/";
-  const std::string policyPath = "/sys/devices/system/cpu/cpufreq/policy" + std::to_string(core_id) + "/";
+  const std::string basePath =
+      filesystem::rooted("/sys/devices/system/cpu/cpu") + std::to_string(core_id) + "/cpufreq/";
+  const std::string policyPath =
+      filesystem::rooted("/sys/devices/system/cpu/cpufreq/policy") + std::to_string(core_id) + "/";
 
   const std::vector maxFrequencyPaths = {
       basePath + "scaling_max_freq",    // Intel & ARM (individual cores)
@@ -51,8 +67,10 @@ int64_t getMaxClockSpeed_MHz(const int& core_id) {
 // _____________________________________________________________________________________________________________________
 // Get Regular (Base) Clock Speed (MHz)
 int64_t getRegularClockSpeed_MHz(const int& core_id) {
-  const std::string basePath = "/sys/devices/system/cpu/cpu" + std::to_string(core_id) + "/cpufreq/";
-  const std::string policyPath = "/sys/devices/system/cpu/cpufreq/policy" + std::to_string(core_id) + "/";
+  const std::string basePath =
+      filesystem::rooted("/sys/devices/system/cpu/cpu") + std::to_string(core_id) + "/cpufreq/";
+  const std::string policyPath =
+      filesystem::rooted("/sys/devices/system/cpu/cpufreq/policy") + std::to_string(core_id) + "/";
 
   const std::vector regularFrequencyPaths = {
       basePath + "base_frequency",      // Intel (individual cores)
@@ -68,8 +86,10 @@ int64_t getRegularClockSpeed_MHz(const int& core_id) {
 // _____________________________________________________________________________________________________________________
 // Get Min Clock Speed (MHz)
 int64_t getMinClockSpeed_MHz(const int& core_id) {
-  const std::string basePath = "/sys/devices/system/cpu/cpu" + std::to_string(core_id) + "/cpufreq/";
-  const std::string policyPath = "/sys/devices/system/cpu/cpufreq/policy" + std::to_string(core_id) + "/";
+  const std::string basePath =
+      filesystem::rooted("/sys/devices/system/cpu/cpu") + std::to_string(core_id) + "/cpufreq/";
+  const std::string policyPath =
+      filesystem::rooted("/sys/devices/system/cpu/cpufreq/policy") + std::to_string(core_id) + "/";
 
   const std::vector minFrequencyPaths = {
       basePath + "scaling_min_freq",    // Intel & ARM (individual cores)
@@ -81,6 +101,23 @@ int64_t getMinClockSpeed_MHz(const int& core_id) {
   return getFrequencyFromPaths(minFrequencyPaths);
 }
 
+// _____________________________________________________________________________________________________________________
+CPU::ClockSpeeds CPU::readClockSpeeds() const {
+  HWINFO_PROBE("cpu.clock_speeds");
+  ClockSpeeds speeds{getMaxClockSpeed_MHz(_id), getRegularClockSpeed_MHz(_id)};
+  if (speeds.max_MHz < 0 || speeds.regular_MHz < 0) {
+    // without cpufreq (e.g. in VMs) fall back to the speeds of the socket in the SMBIOS table
+    int socket = 0;
+    for (const auto& processor : utils::SMBIOS::tables().processors) {
+      if (!processor.populated || socket++ != _id) continue;
+      if (speeds.max_MHz < 0) speeds.max_MHz = processor.max_speed_MHz;
+      if (speeds.regular_MHz < 0) speeds.regular_MHz = processor.current_speed_MHz;
+      break;
+    }
+  }
+  return speeds;
+}
+
 // _____________________________________________________________________________________________________________________
 // Get Current Clock Speeds (MHz) for All Cores
 std::vector<int64_t> CPU::currentClockSpeed_MHz() const {
@@ -92,15 +129,17 @@ std::vector<int64_t> CPU::currentClockSpeed_MHz() const {
 
   res.reserve(numLogicalCores());
 
-  for (int core_id = 0; core_id < numLogicalCores(); ++core_id) {
-    std::string freqPath = "/sys/devices/system/cpu/cpu" + std::to_string(core_id) + "/cpufreq/scaling_cur_freq";
-    int64_t frequency_Hz = filesystem::get_specs_by_file_path(freqPath);
-
-    if (frequency_Hz == -1) {
-      continue;  // Continue checking other cores, don't break
-    }
+  // scaling_cur_freq is polled frequently: keep the files open and reread them with a single pread per core
+  thread_local std::vector<filesystem::SysfsReader> readers;
+  while (readers.size() < static_cast<size_t>(numLogicalCores())) {
+    readers.emplace_back(filesystem::rooted("/sys/devices/system/cpu/cpu") + std::to_string(readers.size()) +
+                         "/cpufreq/scaling_cur_freq");
+  }
 
-    res.push_back(frequency_Hz / 1000);
+  for (int core_id = 0; core_id < numLogicalCores(); ++core_id) {
+    const int64_t frequency_Hz = readers[core_id].readInt();
+    // keep the index aligned with the core id, -1 marks cores without cpufreq
+    res.push_back(frequency_Hz == -1 ? -1 : frequency_Hz / 1000);
   }
 
   return res;
@@ -108,112 +147,364 @@ std::vector<int64_t> CPU::currentClockSpeed_MHz() const {
 
 // _____________________________________________________________________________________________________________________
 double CPU::currentUtilisation() const {
-  init_jiffies();
   // TODO: Leon Freist a socket max num and a socket id inside the CPU could make it work with all sockets
   //       I will not support it because I only have a 1 socket target device
-  static Jiffies last = Jiffies();
+  const Jiffies current = filesystem::get_jiffies(0);
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  if (_baseline.jiffies.empty()) {
+    _baseline.jiffies.resize(_numLogicalCores + 1);
+  }
+  const double utilisation = current.utilisation_since(_baseline.jiffies[0]);
+  _baseline.jiffies[0] = current;
+  return utilisation;
+}
+
+// _____________________________________________________________________________________________________________________
+double CPU::threadUtilisation(int thread_index) const {
+  // TODO: Leon Freist a socket max num and a socket id inside the CPU could make it work with all sockets
+  //       I will not support it because I only have a 1 socket target device
+  if (thread_index < 0 || thread_index >= _numLogicalCores) {
+    return -1.0;
+  }
+  // thread_index works only with 1 socket right now
+  const Jiffies current = filesystem::get_jiffies(thread_index + 1);
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  if (_baseline.jiffies.empty()) {
+    _baseline.jiffies.resize(_numLogicalCores + 1);
+  }
+  const double utilisation = current.utilisation_since(_baseline.jiffies[thread_index + 1]);
+  _baseline.jiffies[thread_index + 1] = current;
+  return utilisation;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<double> CPU::threadsUtilisation() const {
+  std::vector<double> thread_utility(CPU::_numLogicalCores, -1.0);
+  // one read of /proc/stat for all threads instead of one per thread
+  thread_local std::vector<Jiffies> current;
+  if (!filesystem::get_all_jiffies(current)) {
+    return thread_utility;
+  }
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  if (_baseline.jiffies.empty()) {
+    _baseline.jiffies.resize(_numLogicalCores + 1);
+  }
+  for (int thread_idx = 0; thread_idx < CPU::_numLogicalCores; ++thread_idx) {
+    const size_t slot = static_cast<size_t>(thread_idx) + 1;
+    if (slot >= current.size() || current[slot].all < 0) {
+      continue;  // offline
+    }
+    thread_utility[thread_idx] = current[slot].utilisation_since(_baseline.jiffies[slot]);
+    _baseline.jiffies[slot] = current[slot];
+  }
+  return thread_utility;
+}
 
-  Jiffies current = filesystem::get_jiffies(0);
+namespace {
 
-  auto total_over_period = static_cast<double>(current.all - last.all);
-  auto work_over_period = static_cast<double>(current.working - last.working);
+// IA32_TIME_STAMP_COUNTER, IA32_MPERF and IA32_APERF
+constexpr off_t msr_tsc = 0x10;
+constexpr off_t msr_mperf = 0xe7;
+constexpr off_t msr_aperf = 0xe8;
 
-  last = current;
+bool readMsr(int fd, off_t msr, uint64_t& value) {
+  const ssize_t n = ::pread(fd, &value, sizeof(value), msr);
+  HWINFO_COUNT_READ(n);
+  return n == static_cast<ssize_t>(sizeof(value));
+}
 
-  const double utilization = work_over_period / total_over_period;
-  if (utilization < 0 || utilization > 1 || std::isnan(utilization)) {
-    return -1.0;
+int64_t monotonicTime_ns() {
+  timespec now{};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+FrequencySampler::FrequencySampler() {
+  const long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+  if (num_cpus <= 0) {
+    return;
+  }
+  _fds.assign(static_cast<size_t>(num_cpus), -1);
+  _last.resize(static_cast<size_t>(num_cpus));
+#if defined(HWINFO_X86)
+  uint64_t aperf = 0;
+  for (long cpu = 0; cpu < num_cpus; ++cpu) {
+    const std::string path = filesystem::rooted("/dev/cpu/") + std::to_string(cpu) + "/msr";
+    _fds[cpu] = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (cpu == 0 && (_fds[0] < 0 || !readMsr(_fds[0], msr_aperf, aperf))) {
+      break;
+    }
+    _effective = true;
+  }
+  if (_effective) {
+    // baseline: the first sample reports the average since the counters started (usually boot)
+    const int64_t now_ns = monotonicTime_ns();
+    for (size_t cpu = 0; cpu < _fds.size(); ++cpu) {
+      Counters& last = _last[cpu];
+      if (_fds[cpu] >= 0 && readMsr(_fds[cpu], msr_tsc, last.tsc) && readMsr(_fds[cpu], msr_mperf, last.mperf) &&
+          readMsr(_fds[cpu], msr_aperf, last.aperf)) {
+        last.time_ns = now_ns;
+      }
+    }
+    return;
+  }
+  if (_fds[0] >= 0) {
+    ::close(_fds[0]);
+    _fds[0] = -1;
+  }
+#endif
+  for (long cpu = 0; cpu < num_cpus; ++cpu) {
+    const std::string path =
+        filesystem::rooted("/sys/devices/system/cpu/cpu") + std::to_string(cpu) + "/cpufreq/scaling_cur_freq";
+    _fds[cpu] = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
   }
-  return utilization;
 }
 
 // _____________________________________________________________________________________________________________________
-double CPU::threadUtilisation(int thread_index) const {
-  init_jiffies();
-  // TODO: Leon Freist a socket max num and a socket id inside the CPU could make it work with all sockets
-  //       I will not support it because I only have a 1 socket target device
-  static std::vector<Jiffies> last(0);
-  if (last.empty()) {
-    last.resize(_numLogicalCores);
+FrequencySampler::~FrequencySampler() {
+  for (const int fd : _fds) {
+    if (fd >= 0) ::close(fd);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+size_t FrequencySampler::sample(int64_t* out_MHz, size_t size) {
+  HWINFO_PROBE("cpu.frequency");
+  const size_t count = std::min(size, _fds.size());
+  if (!_effective) {
+    char buffer[32];
+    for (size_t cpu = 0; cpu < count; ++cpu) {
+      const ssize_t n = _fds[cpu] < 0 ? -1 : ::pread(_fds[cpu], buffer, sizeof(buffer) - 1, 0);
+      HWINFO_COUNT_READ(n);
+      if (n <= 0) {
+        out_MHz[cpu] = -1;
+        continue;
+      }
+      std::string_view value(buffer, static_cast<size_t>(n));
+      const auto kHz = utils::consumeNumber<int64_t>(value);
+      out_MHz[cpu] = kHz ? *kHz / 1000 : -1;
+    }
+    return _fds.size();
   }
 
-  Jiffies current = filesystem::get_jiffies(thread_index + 1);  // thread_index works only with 1 socket right now
+  const int64_t now_ns = monotonicTime_ns();
+  // every CPU keeps the time of its own baseline: CPUs that are not sampled or whose read fails keep their baseline,
+  // so their next delta spans a longer period than that of the others
+  for (size_t cpu = 0; cpu < count; ++cpu) {
+    Counters current;
+    if (_fds[cpu] < 0 || !readMsr(_fds[cpu], msr_tsc, current.tsc) || !readMsr(_fds[cpu], msr_mperf, current.mperf) ||
+        !readMsr(_fds[cpu], msr_aperf, current.aperf)) {
+      out_MHz[cpu] = -1;
+      continue;
+    }
+    current.time_ns = now_ns;
+    const Counters& last = _last[cpu];
+    const int64_t elapsed_ns = now_ns - last.time_ns;
+    const uint64_t tsc = current.tsc - last.tsc;
+    const uint64_t mperf = current.mperf - last.mperf;
+    const uint64_t aperf = current.aperf - last.aperf;
+    if (last.time_ns == 0 || elapsed_ns <= 0 || tsc == 0) {
+      out_MHz[cpu] = -1;
+    } else if (mperf == 0) {
+      out_MHz[cpu] = 0;
+    } else {
+      // TSC ticks per microsecond is the TSC rate in MHz
+      const double tsc_MHz = static_cast<double>(tsc) * 1000.0 / static_cast<double>(elapsed_ns);
+      out_MHz[cpu] = static_cast<int64_t>(tsc_MHz * static_cast<double>(aperf) / static_cast<double>(mperf));
+    }
+    _last[cpu] = current;
+  }
+  return _fds.size();
+}
 
-  auto total_over_period = static_cast<double>(current.all - last[thread_index].all);
-  auto work_over_period = static_cast<double>(current.working - last[thread_index].working);
+// _____________________________________________________________________________________________________________________
+std::vector<Jiffies> CpuSampler::snapshot() {
+  // index 0 is the aggregated "cpu" line, index i + 1 is the "cpuN" line of logical CPU i
+  return filesystem::get_all_jiffies();
+}
 
-  last[thread_index] = current;
+namespace {
 
-  const double percentage = work_over_period / total_over_period;
-  if (percentage < 0 || percentage > 100 || std::isnan(percentage)) {
-    return -1.0;
+// sorted entries of a sysfs class directory below filesystem::root(), so that devices of the same kind are numbered in
+// a stable order
+std::vector<std::string> classEntries(const char* path, const char* prefix) {
+  std::vector<std::string> entries;
+  DIR* dir = opendir(filesystem::rooted(path).c_str());
+  if (dir == nullptr) {
+    return entries;
+  }
+  const size_t prefix_length = std::strlen(prefix);
+  while (const dirent* entry = readdir(dir)) {
+    if (std::strncmp(entry->d_name, prefix, prefix_length) == 0) entries.emplace_back(entry->d_name);
   }
-  return percentage;
+  closedir(dir);
+  // "hwmon10" after "hwmon9"
+  std::sort(entries.begin(), entries.end(), [](const std::string& a, const std::string& b) {
+    return a.size() != b.size() ? a.size() < b.size() : a < b;
+  });
+  return entries;
 }
 
+int openAt(int dir_fd, const std::string& name) { return ::openat(dir_fd, name.c_str(), O_RDONLY | O_CLOEXEC); }
+
+// opens temp<N>_input of the first label in labels (in order of preference), -1 if the hwmon device has none of them
+int openLabeledInput(int hwmon_fd, const std::vector<std::string>& labels) {
+  char buffer[64];
+  for (const auto& label : labels) {
+    for (int index = 1; index < 64; ++index) {
+      const std::string prefix = "temp" + std::to_string(index);
+      if (filesystem::readAttributeAt(hwmon_fd, (prefix + "_label").c_str(), buffer, sizeof(buffer)) < 0) {
+        if (filesystem::readAttributeAt(hwmon_fd, (prefix + "_input").c_str(), buffer, sizeof(buffer)) < 0) break;
+        continue;
+      }
+      if (label == buffer) return openAt(hwmon_fd, prefix + "_input");
+    }
+  }
+  return -1;
+}
+
+int64_t preadInt(int fd) {
+  char buffer[32];
+  const ssize_t n = ::pread(fd, buffer, sizeof(buffer) - 1, 0);
+  if (n <= 0) {
+    return -1;
+  }
+  std::string_view value(buffer, static_cast<size_t>(n));
+  return utils::consumeNumber<int64_t>(value).value_or(-1);
+}
+
+// "package-0" -> 0, -1 for the other zones (core, uncore, dram, psys)
+int packageZoneId(std::string_view name) {
+  if (!utils::consumePrefix(name, "package-")) {
+    return -1;
+  }
+  return utils::toNumber<int>(name).value_or(-1);
+}
+
+}  // namespace
+
 // _____________________________________________________________________________________________________________________
-std::vector<double> CPU::threadsUtilisation() const {
-  std::vector<double> thread_utility(CPU::_numLogicalCores);
-  for (int thread_idx = 0; thread_idx < CPU::_numLogicalCores; ++thread_idx) {
-    thread_utility[thread_idx] = threadUtilisation(thread_idx);
+CpuSensors::CpuSensors() {
+  const auto package = [this](size_t index) -> Package& {
+    if (_packages.size() <= index) _packages.resize(index + 1);
+    return _packages[index];
+  };
+
+  // coretemp has one device per package with a "Package id N" input, k10temp and zenpower one device per package
+  size_t amd_packages = 0;
+  for (const auto& entry : classEntries("/sys/class/hwmon", "hwmon")) {
+    const int hwmon_fd =
+        ::open(filesystem::rooted("/sys/class/hwmon/" + entry).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (hwmon_fd < 0) {
+      continue;
+    }
+    char name[64];
+    if (filesystem::readAttributeAt(hwmon_fd, "name", name, sizeof(name)) > 0) {
+      if (std::strcmp(name, "coretemp") == 0) {
+        for (size_t id = 0; id < 256; ++id) {
+          const int fd = openLabeledInput(hwmon_fd, {"Package id " + std::to_string(id)});
+          if (fd < 0) break;
+          package(id).temperature_fd = fd;
+        }
+      } else if (std::strcmp(name, "k10temp") == 0 || std::strcmp(name, "zenpower") == 0) {
+        // Tctl may carry a fan control offset on older Ryzen parts, prefer Tdie
+        const int fd = openLabeledInput(hwmon_fd, {"Tdie", "Tctl"});
+        if (fd >= 0) package(amd_packages++).temperature_fd = fd;
+      }
+    }
+    ::close(hwmon_fd);
+  }
+
+  // without hwmon drivers (VMs, ARM boards) fall back to the thermal zones
+  if (_packages.empty()) {
+    size_t zone_packages = 0;
+    for (const auto& entry : classEntries("/sys/class/thermal", "thermal_zone")) {
+      const int zone_fd =
+          ::open(filesystem::rooted("/sys/class/thermal/" + entry).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (zone_fd < 0) {
+        continue;
+      }
+      char type[64];
+      if (filesystem::readAttributeAt(zone_fd, "type", type, sizeof(type)) > 0 &&
+          (std::strcmp(type, "x86_pkg_temp") == 0 || std::strcmp(type, "cpu-thermal") == 0 ||
+           std::strcmp(type, "cpu_thermal") == 0)) {
+        const int fd = openAt(zone_fd, "temp");
+        if (fd >= 0) package(zone_packages++).temperature_fd = fd;
+      }
+      ::close(zone_fd);
+    }
+  }
+
+  // top level RAPL zones are the packages ("package-N"), their subzones (intel-rapl:N:M) are cores, uncore and dram
+  for (const auto& entry : classEntries("/sys/class/powercap", "intel-rapl:")) {
+    if (entry.find(':') != entry.rfind(':')) {
+      continue;
+    }
+    const int zone_fd =
+        ::open(filesystem::rooted("/sys/class/powercap/" + entry).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (zone_fd < 0) {
+      continue;
+    }
+    char name[64];
+    const int id = filesystem::readAttributeAt(zone_fd, "name", name, sizeof(name)) > 0 ? packageZoneId(name) : -1;
+    if (id >= 0) {
+      const int fd = openAt(zone_fd, "energy_uj");
+      if (fd >= 0) {
+        auto& p = package(static_cast<size_t>(id));
+        p.energy_fd = fd;
+        p.max_energy_uJ = filesystem::readIntAttributeAt(zone_fd, "max_energy_range_uj", 10, -1);
+        p.last_energy_uJ = preadInt(fd);
+        p.last_time_ns = monotonicTime_ns();
+      }
+    }
+    ::close(zone_fd);
   }
-  return thread_utility;
 }
 
 // _____________________________________________________________________________________________________________________
-void CPU::init_jiffies() const {
-  if (!_jiffies_initialized) {
-    // Sleep 1 sec just for the start cause the usage needs to have a delta value which is depending on the unix file
-    // read it's just for the init, you don't need to wait if the delta is already created ...
-    std::this_thread::sleep_for(std::chrono::duration<double>(1));
-    _jiffies_initialized = true;
-  }
-}
-
-// CPU Temp -> Works | But requires Im_sensors
-// double CPU::currentTemperature_Celsius() const {
-//     if (!std::ifstream("/etc/sensors3.conf"))
-//     {
-//       std::cout << "The lm-sensors, the tool for monitoring your system's temperature, needs to be configured. Please
-//       set it up." << '\n';
-//       // Configure lm-sensors if not already configured
-//       std::string detect_command = "sudo sensors-detect";
-//       std::system(detect_command.c_str());
-//     }
-
-//     // TODO: Leon Freist a socket max num and a socket id inside the CPU could make it work with all sockets
-//     //       I will not support it because I only have a 1 socket target device
-//     const int Socked_id = 0;
-
-//     // Command to get temperature data using 'sensors' command
-//     std::string command = "sensors | grep 'Package id " + std::to_string(Socked_id) + "' | awk '{print $4}'";
-
-//     // Open a pipe to execute the command and capture its output
-//     FILE* pipe = popen(command.c_str(), "r");
-//     if (!pipe) {
-//         std::cerr << "Error executing command." << '\n';
-//         return -1.0; // Return a negative value to indicate an error
-//     }
-
-//     char buffer[128];
-//     std::string result = "";
-
-//     // Read the output of the command into 'result'
-//     while (!feof(pipe)) {
-//         if (fgets(buffer, sizeof(buffer), pipe) != NULL) {
-//             result += buffer;
-//         }
-//     }
-
-//     // Close the pipe
-//     pclose(pipe);
-
-//     // Convert the result (string) to a double
-//     double temperature = -1.0; // Default value in case of conversion failure
-//     std::istringstream(result) >> temperature;
-
-//     return temperature;
-// }
+CpuSensors::~CpuSensors() {
+  for (const auto& package : _packages) {
+    if (package.temperature_fd >= 0) ::close(package.temperature_fd);
+    if (package.energy_fd >= 0) ::close(package.energy_fd);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+double CpuSensors::packageTemperature_Celsius(int package) const {
+  if (package < 0 || static_cast<size_t>(package) >= _packages.size() || _packages[package].temperature_fd < 0) {
+    return -1.0;
+  }
+  // millidegree Celsius
+  const int64_t value = preadInt(_packages[package].temperature_fd);
+  return value < 0 ? -1.0 : static_cast<double>(value) / 1000.0;
+}
+
+// _____________________________________________________________________________________________________________________
+double CpuSensors::packagePower_W(int package) {
+  if (package < 0 || static_cast<size_t>(package) >= _packages.size() || _packages[package].energy_fd < 0) {
+    return -1.0;
+  }
+  auto& p = _packages[package];
+  const int64_t energy_uJ = preadInt(p.energy_fd);
+  const int64_t now_ns = monotonicTime_ns();
+  if (energy_uJ < 0 || p.last_energy_uJ < 0 || now_ns <= p.last_time_ns) {
+    p.last_energy_uJ = energy_uJ;
+    p.last_time_ns = now_ns;
+    return -1.0;
+  }
+  int64_t delta_uJ = energy_uJ - p.last_energy_uJ;
+  if (delta_uJ < 0 && p.max_energy_uJ > 0) {
+    // the counter wrapped around
+    delta_uJ += p.max_energy_uJ;
+  }
+  const double power_W = static_cast<double>(delta_uJ) * 1000.0 / static_cast<double>(now_ns - p.last_time_ns);
+  p.last_energy_uJ = energy_uJ;
+  p.last_time_ns = now_ns;
+  return delta_uJ < 0 ? -1.0 : power_W;
+}
 
 // =====================================================================================================================
 // _____________________________________________________________________________________________________________________
@@ -362,147 +653,181 @@ std::string getARMModelName(const std::string& implementer, const std::string& p
   return "Unknown Model";
 }
 
-std::vector<CPU> getAllCPUs() {
-  std::vector<CPU> cpus;
-
-  // This map tracks ARM cores based on unique (implementer, variant, part) keys.
-  // The int stored is used later to adjust the core counts in a post-processing step.
-  std::map<std::tuple<std::string, std::string, std::string>, int> armCoreMap;
+namespace {
 
-  // Open /proc/cpuinfo
-  std::ifstream cpuinfo("/proc/cpuinfo");
-  if (!cpuinfo.is_open()) {
-    return {};  // Could not open
+// reads a procfs file (st_size is 0) below filesystem::root() with as few read() calls as possible
+std::string readProcFile(const char* path) {
+  std::string content;
+  const int fd = ::open(filesystem::rooted(path).c_str(), O_RDONLY | O_CLOEXEC);
+  HWINFO_COUNT_OPEN();
+  if (fd < 0) {
+    return content;
   }
-
-  // Read entire file into a string
-  std::string file((std::istreambuf_iterator<char>(cpuinfo)), std::istreambuf_iterator<char>());
-  cpuinfo.close();
-
-  // If file content is empty, no data to parse
-  if (file.empty()) {
-    return {};
+  size_t size = 0;
+  content.resize(64 * 1024);
+  for (;;) {
+    if (size == content.size()) content.resize(content.size() * 2);
+    const ssize_t n = ::read(fd, &content[size], content.size() - size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    size += static_cast<size_t>(n);
   }
+  ::close(fd);
+  HWINFO_COUNT_READ(size);
+  content.resize(size);
+  return content;
+}
 
-  // Split content into blocks, each block typically corresponds to a "processor" section
-  auto cpuBlocks = utils::split(file, "\n\n");
+// the leading number of value, e.g. 512 of "512 KB"
+int toInt(std::string_view value, int fallback = -1) { return utils::consumeNumber<int>(value).value_or(fallback); }
+
+// the fields of one "processor" block of /proc/cpuinfo, pointing into the file content
+struct CpuInfoBlock {
+  std::string_view vendor;
+  std::string_view model_name;
+  std::string_view cache_size;
+  std::string_view flags;
+  std::string_view implementer;
+  std::string_view part;
+  std::string_view variant;
+  int processor{0};
+  int physical_id{-1};
+  int siblings{-1};
+  int cores{-1};
+};
+
+}  // namespace
 
-  // Remove truly empty blocks (after trimming)
-  cpuBlocks.erase(
-      std::remove_if(cpuBlocks.begin(), cpuBlocks.end(),
-                     [](const std::string& blk) { return blk.find_first_not_of(" \n\r\t") == std::string::npos; }),
-      cpuBlocks.end());
+// _____________________________________________________________________________________________________________________
+std::vector<CPU> getAllCPUs() {
+  HWINFO_PROBE("cpu.cpuinfo");
+  std::vector<CPU> cpus;
+
+  // ARM: one CPU object per core type, i.e. per unique (implementer, variant, part). The logical CPUs of every type are
+  // collected to count its cores from the topology afterwards. armKeys holds the key of every entry of cpus.
+  using ArmKey = std::tuple<std::string_view, std::string_view, std::string_view>;
+  std::map<ArmKey, std::vector<int>> armCoreMap;
+  std::vector<ArmKey> armKeys;
 
-  // If there are no blocks, nothing to parse
-  if (cpuBlocks.empty()) {
+  // one pass over the file without copying lines: all values are views into file. Blocks of a socket that was already
+  // added are skipped as soon as their "physical id" line is seen.
+  const std::string file = readProcFile("/proc/cpuinfo");
+  if (file.empty()) {
     return {};
   }
 
-  bool isARM = false;         // Will set to true if we detect ARM implementer
-  int maxProcessorIndex = 0;  // Tracks how many "processor" entries we've seen
-  int cpuId = 0;              // Temporary for the current block's CPU ID
-
-  // Parse each block
-  for (const auto& block : cpuBlocks) {
-    CPU cpu;
-
-    // Temporary strings used to identify ARM hardware
-    std::string implementer;
-    std::string partHex;
-    std::string variant;
-
-    // Split block into lines
-    auto lines = utils::split(block, "\n");
-    for (auto& line : lines) {
-      // Key-value split by ':'
-      auto kv = utils::split(line, ":");
-      if (kv.size() < 2) {
+  bool isARM = false;  // Will set to true if we detect ARM implementer
+
+  const std::string_view content(file);
+  size_t pos = 0;
+  while (pos < content.size()) {
+    CpuInfoBlock block;
+    bool duplicate = false;
+    bool has_fields = false;
+    // parse the lines up to the next empty line
+    while (pos < content.size()) {
+      size_t end = content.find('\n', pos);
+      if (end == std::string_view::npos) end = content.size();
+      const std::string_view line = content.substr(pos, end - pos);
+      pos = end + 1;
+      if (utils::trim(line).empty()) {
+        if (has_fields) break;
         continue;
       }
+      const size_t colon = line.find(':');
+      if (colon == std::string_view::npos) {
+        continue;
+      }
+      has_fields = true;
+      const std::string_view name = utils::trim(line.substr(0, colon));
+      const std::string_view value = utils::trim(line.substr(colon + 1));
 
-      std::string name = kv[0];
-      std::string value = kv[1];
-      utils::strip(name);
-      utils::strip(value);
-
-      if (name == "vendor_id") {
-        // Intel vendor
-        cpu._vendor = value;
-      } else if (name == "CPU implementer") {
-        // ARM vendor
-        implementer = value;
-        // Remove "0x" prefix if present
-        if (implementer.rfind("0x", 0) == 0) {
-          implementer = implementer.substr(2);
-        }
-
-        // Check if we know this implementer
-        std::string implementerKey = "0x" + implementer;
-        auto it = ARM_IMPLEMENTERS.find(implementerKey);
-        if (it != ARM_IMPLEMENTERS.end()) {
-          isARM = true;
-          cpu._vendor = it->second;
-        } else {
-          cpu._vendor = "Unknown Vendor (" + implementerKey + ")";
-        }
-      } else if (name == "processor") {
+      if (name == "processor") {
         // The "processor" line should uniquely identify each logical CPU index
-        cpuId = std::stoi(value);
-        maxProcessorIndex++;  // Count how many logical processors we see
+        block.processor = toInt(value, 0);
+      } else if (name == "physical id") {
+        // Intel physical package ID
+        block.physical_id = toInt(value);
+        if (std::any_of(cpus.begin(), cpus.end(), [&](const CPU& c) { return c._id == block.physical_id; })) {
+          // the socket is complete, skip the rest of the block
+          duplicate = true;
+          // pos - 1 is the newline of this line, so an empty line right after it is found as well
+          const size_t block_end = content.find("\n\n", pos - 1);
+          pos = block_end == std::string_view::npos ? content.size() : block_end + 2;
+          break;
+        }
+      } else if (name == "vendor_id") {
+        // Intel vendor
+        block.vendor = value;
       } else if (name == "model name" || name == "Processor") {
-        cpu._modelName = value;
+        block.model_name = value;
       } else if (name == "cache size") {
         // Intel format: e.g. "4096 KB"
-        try {
-          auto tokens = utils::split(value, " ");
-          cpu._L3CacheSize_Bytes = std::stol(tokens[0]) * 1024;
-        } catch (...) {
-          // Ignore parse errors
-        }
+        block.cache_size = value;
       } else if (name == "siblings") {
         // Intel: number of logical cores
-        cpu._numLogicalCores = std::stoi(value);
+        block.siblings = toInt(value);
       } else if (name == "cpu cores") {
         // Intel: number of physical cores
-        cpu._numPhysicalCores = std::stoi(value);
+        block.cores = toInt(value);
       } else if (name == "flags" || name == "Features") {
         // CPU flags/features (Intel "flags", ARM "Features")
-        cpu._flags = utils::split(value, " ");
-      } else if (name == "physical id") {
-        // Intel physical package ID
-        cpu._id = std::stoi(value);
+        block.flags = value;
+      } else if (name == "CPU implementer") {
+        // ARM vendor, without "0x" prefix
+        block.implementer = value.substr(0, 2) == "0x" ? value.substr(2) : value;
       } else if (name == "CPU part") {
         // ARM CPU part (e.g., 0xd03)
-        partHex = value;
-        if (!implementer.empty()) {
-          cpu._modelName = getARMModelName("0x" + implementer, partHex);
-        }
+        block.part = value;
       } else if (name == "CPU variant") {
         // ARM CPU variant (e.g., 0x0)
-        variant = value;
+        block.variant = value;
       }
     }
+    if (duplicate || !has_fields) {
+      continue;
+    }
 
-    // If we detected ARM in at least one block, handle the ARM core map logic
-    if (isARM) {
-      // Make a unique key for this ARM's implementer + variant + part
-      auto armKey = std::make_tuple(implementer, variant, partHex);
-
-      // If we haven't seen this triple, assign new "count" and set ID
-      if (armCoreMap.find(armKey) == armCoreMap.end()) {
-        // In the original code, this sets maxProcessorIndex to 1, then uses cpuId as the ID.
-        // This may or may not match your intended logic, but is preserved from the original.
-        maxProcessorIndex = 1;
-        cpu._id = cpuId;
+    CPU cpu;
+    cpu._id = block.physical_id;
+    cpu._vendor = std::string(block.vendor);
+    cpu._modelName = std::string(block.model_name);
+    cpu._numLogicalCores = block.siblings;
+    cpu._numPhysicalCores = block.cores;
+    if (!block.cache_size.empty()) {
+      const int cache_kB = toInt(block.cache_size);
+      if (cache_kB > 0) cpu._L3CacheSize_Bytes = static_cast<int64_t>(cache_kB) * 1024;
+    }
+    for (size_t first = 0; first < block.flags.size();) {
+      size_t last = block.flags.find(' ', first);
+      if (last == std::string_view::npos) last = block.flags.size();
+      if (last > first) cpu._flags.emplace_back(block.flags.substr(first, last - first));
+      first = last + 1;
+    }
+    if (!block.implementer.empty()) {
+      // Check if we know this implementer
+      const std::string implementerKey = "0x" + std::string(block.implementer);
+      auto it = ARM_IMPLEMENTERS.find(implementerKey);
+      if (it != ARM_IMPLEMENTERS.end()) {
+        isARM = true;
+        cpu._vendor = it->second;
       } else {
-        // If we already saw this triple, reuse the previous CPU's _id
-        // (the code does it by referencing the last CPU in 'cpus')
-        if (!cpus.empty()) {
-          cpu._id = cpus.back()._id;
-        }
+        cpu._vendor = "Unknown Vendor (" + implementerKey + ")";
+      }
+      if (!block.part.empty()) {
+        cpu._modelName = getARMModelName(implementerKey, std::string(block.part));
+      }
+    }
+
+    // ARM: the id of a core type is its first logical CPU, further CPUs of the type are only recorded
+    const ArmKey armKey(block.implementer, block.variant, block.part);
+    if (isARM) {
+      auto& type_cpus = armCoreMap[armKey];
+      type_cpus.push_back(block.processor);
+      if (type_cpus.size() > 1) {
+        continue;
       }
-      // Update the map. The int stored is `maxProcessorIndex`.
-      armCoreMap[armKey] = maxProcessorIndex;
+      cpu._id = block.processor;
     }
 
     // Check if we've already inserted a CPU with the same _id (avoid duplicates)
@@ -512,25 +837,62 @@ std::vector<CPU> getAllCPUs() {
       continue;
     }
 
-    // Set clock speeds for this CPU (replace with your actual logic)
-    cpu._maxClockSpeed_MHz = getMaxClockSpeed_MHz(cpu._id);
-    cpu._regularClockSpeed_MHz = getRegularClockSpeed_MHz(cpu._id);
-
     // Finally, add this CPU to the list
     cpus.push_back(std::move(cpu));
+    armKeys.push_back(armKey);
   }
 
-  // If we detected ARM, adjust physical/logical core counts based on armCoreMap
+  const auto topology = getCpuTopology();
+
+  // ARM: the cores of a type are the distinct topology cores of its logical CPUs
   if (isARM) {
-    // The original code tries to set _numPhysicalCores and _numLogicalCores
-    // according to the values stored in armCoreMap. This is simplistic and
-    // may not match real hardware topologies.
-    std::size_t idx = 0;
-    for (const auto& [key, count] : armCoreMap) {
-      if (idx < cpus.size()) {
-        cpus[idx]._numPhysicalCores = count;
-        cpus[idx]._numLogicalCores = count;
-        ++idx;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+      const auto it = armCoreMap.find(armKeys[i]);
+      if (it == armCoreMap.end()) continue;
+      const auto& type_cpus = it->second;
+      std::vector<std::tuple<int, int, int, int>> cores;
+      for (const int cpu : type_cpus) {
+        if (cpu < 0 || static_cast<size_t>(cpu) >= topology.threads.size() || topology.threads[cpu].core < 0) {
+          cores.emplace_back(-1, -1, -1, cpu);
+          continue;
+        }
+        const auto& thread = topology.threads[cpu];
+        cores.emplace_back(thread.package, thread.die, thread.cluster, thread.core);
+      }
+      std::sort(cores.begin(), cores.end());
+      cpus[i]._numPhysicalCores = static_cast<int>(std::unique(cores.begin(), cores.end()) - cores.begin());
+      cpus[i]._numLogicalCores = static_cast<int>(type_cpus.size());
+    }
+  }
+
+  // "cache size" of /proc/cpuinfo is the L2 on AMD and the whole L3 on Intel: take the cache sizes seen by the first
+  // CPU of each package (ARM: of each core type) from sysfs instead
+  const auto caches = getCacheHierarchy();
+  for (auto& cpu : cpus) {
+    const auto package_cpus = topology.packageCpus(std::max(cpu._id, 0));
+    const int first_cpu = isARM || package_cpus.empty() ? cpu._id : package_cpus.front();
+    for (const auto& cache : caches) {
+      if (std::find(cache.shared_cpus.begin(), cache.shared_cpus.end(), first_cpu) == cache.shared_cpus.end()) {
+        continue;
+      }
+      if (cache.level == 1 && cache.type != CacheInfo::Type::Instruction) {
+        cpu._L1CacheSize_Bytes = cache.size_Bytes;
+      } else if (cache.level == 2) {
+        cpu._L2CacheSize_Bytes = cache.size_Bytes;
+      } else if (cache.level == 3) {
+        cpu._L3CacheSize_Bytes = cache.size_Bytes;
+      }
+    }
+  }
+
+  // /proc/cpuinfo has no "physical id", "siblings" or "cpu cores" on some VMs and architectures, sysfs always has the
+  // package of every CPU
+  if (!isARM) {
+    for (auto& cpu : cpus) {
+      for (const auto& package : topology.packages) {
+        if (package.id != std::max(cpu._id, 0)) continue;
+        cpu._numLogicalCores = static_cast<int>(topology.packageCpus(package.id).size());
+        cpu._numPhysicalCores = static_cast<int>(topology.onePerCore(package.id).size());
       }
     }
   }
@@ -538,6 +900,455 @@ std::vector<CPU> getAllCPUs() {
   return cpus;
 }
 
+namespace {
+
+// CPUs of the affinity mask of the calling thread, sized for any number of configured CPUs
+std::vector<int> getAffinityCpus() {
+  std::vector<int> cpus;
+  for (int num_cpus = std::max<long>(sysconf(_SC_NPROCESSORS_CONF), 1024); num_cpus <= (1 << 20); num_cpus *= 2) {
+    cpu_set_t* set = CPU_ALLOC(num_cpus);
+    if (set == nullptr) {
+      break;
+    }
+    const size_t size = CPU_ALLOC_SIZE(num_cpus);
+    CPU_ZERO_S(size, set);
+    if (sched_getaffinity(0, size, set) == 0) {
+      for (int cpu = 0; cpu < num_cpus; ++cpu) {
+        if (CPU_ISSET_S(cpu, size, set)) cpus.push_back(cpu);
+      }
+      CPU_FREE(set);
+      break;
+    }
+    CPU_FREE(set);
+    // EINVAL: the kernel mask is larger than ours
+    if (errno != EINVAL) {
+      break;
+    }
+  }
+  return cpus;
+}
+
+// quota / period of one cgroup in CPUs, -1 if unlimited
+double readQuota(const cgroup::Controller& cpu, const std::string& dir) {
+  if (cpu.version == 2) {
+    // "max 100000" or "<quota> <period>"
+    std::string value;
+    filesystem::SysfsReader(dir + "/cpu.max").read(value);
+    utils::Tokenizer tokens(value);
+    const int64_t quota = tokens.nextNumber<int64_t>().value_or(-1);
+    const int64_t period = tokens.nextNumber<int64_t>().value_or(-1);
+    if (quota > 0 && period > 0) {
+      return static_cast<double>(quota) / static_cast<double>(period);
+    }
+    return -1.0;
+  }
+  const int64_t quota = cgroup::readValue(dir + "/cpu.cfs_quota_us");
+  const int64_t period = cgroup::readValue(dir + "/cpu.cfs_period_us");
+  return (quota > 0 && period > 0) ? static_cast<double>(quota) / static_cast<double>(period) : -1.0;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+CpuBudget getEffectiveCpuBudget() {
+  HWINFO_PROBE("cpu.budget");
+  CpuBudget budget;
+  budget.allowed_cpus = getAffinityCpus();
+
+  // the affinity mask already honours the cpuset, but a process may have been moved to a smaller cpuset since it was
+  // forked, so intersect with the effective cpuset of its cgroup
+  const auto cpuset = cgroup::find("cpuset");
+  if (cpuset.version != 0) {
+    std::string list;
+    filesystem::SysfsReader(cpuset.path + (cpuset.version == 2 ? "/cpuset.cpus.effective" : "/cpuset.effective_cpus"))
+        .read(list);
+    const auto effective = utils::parseCpuList(list);
+    if (!effective.empty() && !budget.allowed_cpus.empty()) {
+      std::vector<int> intersection;
+      std::set_intersection(budget.allowed_cpus.begin(), budget.allowed_cpus.end(), effective.begin(), effective.end(),
+                            std::back_inserter(intersection));
+      if (!intersection.empty()) budget.allowed_cpus = std::move(intersection);
+    } else if (budget.allowed_cpus.empty()) {
+      budget.allowed_cpus = effective;
+    }
+  }
+
+  const auto cpu = cgroup::find("cpu");
+  budget.cgroup_version = cpu.version;
+  if (cpu.version != 0) {
+    // a cgroup is throttled by the tightest quota of itself and its ancestors
+    for (std::string dir = cpu.path; dir.size() > cpu.mount_point.size(); dir.erase(dir.rfind('/'))) {
+      const double quota = readQuota(cpu, dir);
+      if (quota > 0 && (budget.quota_cpus < 0 || quota < budget.quota_cpus)) {
+        budget.quota_cpus = quota;
+      }
+    }
+    char buffer[4096];
+    if (filesystem::readAttributeAt(AT_FDCWD, (cpu.path + "/cpu.stat").c_str(), buffer, sizeof(buffer)) < 0) {
+      buffer[0] = '\0';
+    }
+    utils::Tokenizer tokens(buffer);
+    std::string_view key;
+    while (tokens.next(key)) {
+      const auto parsed = tokens.nextNumber<int64_t>();
+      if (!parsed) {
+        break;
+      }
+      const int64_t value = *parsed;
+      if (key == "nr_periods") {
+        budget.nr_periods = value;
+      } else if (key == "nr_throttled") {
+        budget.nr_throttled = value;
+      } else if (key == "throttled_usec") {
+        budget.throttled_us = value;
+      } else if (key == "throttled_time") {
+        // v1 reports nanoseconds
+        budget.throttled_us = value / 1000;
+      }
+    }
+  }
+
+  int effective = budget.allowed_cpus.empty() ? static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN))
+                                              : static_cast<int>(budget.allowed_cpus.size());
+  if (budget.quota_cpus > 0) {
+    effective = std::min(effective, static_cast<int>(std::ceil(budget.quota_cpus)));
+  }
+  budget.effective_cpus = std::max(effective, 1);
+  return budget;
+}
+
+namespace {
+
+// reads a cpu list attribute like "0-3,8" relative to dir_fd
+std::vector<int> readCpuListAt(int dir_fd, const char* name) {
+  char buffer[4096];
+  if (filesystem::readAttributeAt(dir_fd, name, buffer, sizeof(buffer)) <= 0) {
+    return {};
+  }
+  return utils::parseCpuList(buffer);
+}
+
+template <typename Node>
+Node& findOrAdd(std::vector<Node>& nodes, int id) {
+  for (auto& node : nodes) {
+    if (node.id == id) return node;
+  }
+  nodes.emplace_back();
+  nodes.back().id = id;
+  return nodes.back();
+}
+
+// "Node 0 MemTotal:       16318512 kB"
+int64_t readNodeMemory_Bytes(int node_fd) {
+  char buffer[4096];
+  if (filesystem::readAttributeAt(node_fd, "meminfo", buffer, sizeof(buffer)) <= 0) {
+    return -1;
+  }
+  utils::Tokenizer tokens(buffer);
+  std::string_view label;
+  if (!tokens.next(label) || label != "Node" || !tokens.skip(1) || !tokens.next(label) || label != "MemTotal:") {
+    return -1;
+  }
+  const auto total_kB = tokens.nextNumber<int64_t>();
+  return total_kB ? *total_kB * 1024 : -1;
+}
+
+void readNumaNodes(CpuTopology& topology) {
+  const int nodes_fd =
+      ::open(filesystem::rooted("/sys/devices/system/node").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (nodes_fd < 0) {
+    // kernels without CONFIG_NUMA: all CPUs are local to one node
+    return;
+  }
+  for (const int id : readCpuListAt(nodes_fd, "online")) {
+    const std::string name = "node" + std::to_string(id);
+    const int node_fd = ::openat(nodes_fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (node_fd < 0) {
+      continue;
+    }
+    CpuTopology::NumaNode node;
+    node.id = id;
+    node.cpus = readCpuListAt(node_fd, "cpulist");
+    node.memory_Bytes = readNodeMemory_Bytes(node_fd);
+    // one distance per online node in the order of the node ids
+    char buffer[4096];
+    std::vector<int> distances;
+    if (filesystem::readAttributeAt(node_fd, "distance", buffer, sizeof(buffer)) > 0) {
+      utils::Tokenizer tokens(buffer);
+      while (const auto distance = tokens.nextNumber<int>()) {
+        distances.push_back(*distance);
+      }
+    }
+    ::close(node_fd);
+    for (const int cpu : node.cpus) {
+      if (static_cast<size_t>(cpu) < topology.threads.size()) topology.threads[cpu].numa_node = id;
+    }
+    topology.numa_nodes.push_back(std::move(node));
+    topology.numa_distances.push_back(std::move(distances));
+  }
+  ::close(nodes_fd);
+  // offline or memory-less nodes shift the columns, only keep a square matrix
+  for (const auto& row : topology.numa_distances) {
+    if (row.size() != topology.numa_nodes.size()) {
+      topology.numa_distances.clear();
+      break;
+    }
+  }
+}
+
+#if defined(HWINFO_X86)
+// Atom CPUs of an Intel hybrid CPU by the core type of cpuid leaf 0x1a (EAX[31:24]: 0x20 Atom, 0x40 Core), which
+// describes the CPU executing it: the calling thread is moved to every online CPU once and its affinity restored
+// afterwards. Only needed on kernels older than 5.13, which lack the cpu_core/cpu_atom PMUs. Empty if not hybrid.
+std::vector<int> readCpuidAtomCpus(const std::vector<CpuTopology::Thread>& threads) {
+  std::vector<int> atom_cpus;
+  uint32_t regs[4]{};
+  cpuid::cpuid(0, 0, regs);
+  if (regs[0] < 0x1a) {
+    return atom_cpus;
+  }
+  // leaf 7 EDX bit 15: hybrid part
+  cpuid::cpuid(7, 0, regs);
+  if (!(regs[3] & (1u << 15))) {
+    return atom_cpus;
+  }
+  const auto previous = getAffinityCpus();
+  if (previous.empty()) {
+    return atom_cpus;
+  }
+  const int num_cpus = std::max(static_cast<int>(threads.size()), previous.back() + 1);
+  cpu_set_t* set = CPU_ALLOC(num_cpus);
+  if (set == nullptr) {
+    return atom_cpus;
+  }
+  const size_t size = CPU_ALLOC_SIZE(num_cpus);
+  const auto pin = [&](const int* cpus, size_t count) {
+    CPU_ZERO_S(size, set);
+    for (size_t i = 0; i < count; ++i) CPU_SET_S(cpus[i], size, set);
+    return sched_setaffinity(0, size, set) == 0;
+  };
+  for (int cpu = 0; cpu < static_cast<int>(threads.size()); ++cpu) {
+    // CPUs outside of the cpuset of the process can not be visited and count as performance cores
+    if (threads[cpu].core < 0 || !pin(&cpu, 1)) continue;
+    cpuid::cpuid(0x1a, 0, regs);
+    if ((regs[0] >> 24) == 0x20) atom_cpus.push_back(cpu);
+  }
+  pin(previous.data(), previous.size());
+  CPU_FREE(set);
+  return atom_cpus;
+}
+#endif  // HWINFO_X86
+
+// one value per CPU, -1 for offline CPUs and CPUs without the attribute (name is relative to cpu<N>/)
+std::vector<int64_t> readPerCpuAttribute(const std::vector<CpuTopology::Thread>& threads, int cpus_fd,
+                                         const char* name) {
+  std::vector<int64_t> values(threads.size(), -1);
+  for (size_t cpu = 0; cpu < values.size(); ++cpu) {
+    if (threads[cpu].core < 0) continue;
+    const std::string path = "cpu" + std::to_string(cpu) + "/" + name;
+    values[cpu] = filesystem::readIntAttributeAt(cpus_fd, path.c_str(), 10, -1);
+  }
+  return values;
+}
+
+// Sorts the cores into performance levels. Intel hybrid CPUs register one PMU per core type, whose cpus attribute lists
+// its CPUs, older kernels only have cpuid. Otherwise (arm big.LITTLE, AMD/Intel with ITMT on recent kernels) cores with
+// a larger cpu_capacity, the scheduler's relative performance, are faster. Arm kernels without capacities (no
+// capacity-dmips-mhz in the device tree) have one cpufreq policy per cluster, the faster ones have a higher maximum
+// frequency. x86 does not use the frequencies: single cores of homogeneous CPUs boost higher (Turbo Boost Max 3.0).
+void readPerformanceLevels(CpuTopology& topology, int cpus_fd) {
+  std::vector<int> level_of(topology.threads.size(), 0);
+  int num_levels = 1;
+  const int pmus_fd = ::open(filesystem::rooted("/sys/devices").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  auto atom_cpus = pmus_fd < 0 ? std::vector<int>() : readCpuListAt(pmus_fd, "cpu_atom/cpus");
+  bool hybrid = !atom_cpus.empty() && !readCpuListAt(pmus_fd, "cpu_core/cpus").empty();
+  if (pmus_fd >= 0) {
+    ::close(pmus_fd);
+  }
+#if defined(HWINFO_X86)
+  if (!hybrid) {
+    atom_cpus = readCpuidAtomCpus(topology.threads);
+    hybrid = !atom_cpus.empty() && static_cast<int>(atom_cpus.size()) < topology.numThreads();
+  }
+#endif
+  if (hybrid) {
+    for (const int cpu : atom_cpus) {
+      if (static_cast<size_t>(cpu) < level_of.size()) level_of[cpu] = 1;
+    }
+    num_levels = 2;
+  } else {
+    auto capacities = readPerCpuAttribute(topology.threads, cpus_fd, "cpu_capacity");
+#if !defined(HWINFO_X86)
+    if (std::none_of(capacities.begin(), capacities.end(), [](int64_t capacity) { return capacity > 0; })) {
+      capacities = readPerCpuAttribute(topology.threads, cpus_fd, "cpufreq/cpuinfo_max_freq");
+    }
+#endif
+    std::vector<int64_t> distinct;
+    for (const int64_t capacity : capacities) {
+      if (capacity > 0) distinct.push_back(capacity);
+    }
+    std::sort(distinct.begin(), distinct.end(), std::greater<>());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    for (size_t cpu = 0; cpu < capacities.size(); ++cpu) {
+      const auto it = std::find(distinct.begin(), distinct.end(), capacities[cpu]);
+      if (it != distinct.end()) level_of[cpu] = static_cast<int>(it - distinct.begin());
+    }
+    num_levels = std::max(static_cast<int>(distinct.size()), 1);
+  }
+
+  for (auto& package : topology.packages) {
+    for (auto& die : package.dies) {
+      for (auto& cluster : die.clusters) {
+        for (auto& core : cluster.cores) {
+          core.performance_level = core.cpus.empty() ? 0 : level_of[core.cpus.front()];
+        }
+      }
+    }
+  }
+  topology.assignPerformanceLevels(num_levels);
+  if (hybrid) {
+    topology.performance_levels[0].name = "Performance";
+    topology.performance_levels[1].name = "Efficiency";
+  }
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+CpuTopology getCpuTopology() {
+  HWINFO_PROBE("cpu.topology");
+  CpuTopology topology;
+  const int cpus_fd = ::open(filesystem::rooted("/sys/devices/system/cpu").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (cpus_fd < 0) {
+    return topology;
+  }
+  const auto online = readCpuListAt(cpus_fd, "online");
+  if (!online.empty()) {
+    topology.threads.resize(static_cast<size_t>(online.back()) + 1);
+  }
+  for (const int cpu : online) {
+    const std::string name = "cpu" + std::to_string(cpu) + "/topology";
+    const int topology_fd = ::openat(cpus_fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (topology_fd < 0) {
+      continue;
+    }
+    auto& thread = topology.threads[cpu];
+    // die_id (5.2) and cluster_id (5.16) are missing on older kernels, -1 is reported if the firmware has no value
+    thread.package =
+        std::max(static_cast<int>(filesystem::readIntAttributeAt(topology_fd, "physical_package_id", 10, 0)), 0);
+    thread.die = std::max(static_cast<int>(filesystem::readIntAttributeAt(topology_fd, "die_id", 10, 0)), 0);
+    thread.cluster = std::max(static_cast<int>(filesystem::readIntAttributeAt(topology_fd, "cluster_id", 10, 0)), 0);
+    thread.core = std::max(static_cast<int>(filesystem::readIntAttributeAt(topology_fd, "core_id", 10, cpu)), 0);
+    ::close(topology_fd);
+
+    auto& package = findOrAdd(topology.packages, thread.package);
+    auto& die = findOrAdd(package.dies, thread.die);
+    auto& cluster = findOrAdd(die.clusters, thread.cluster);
+    findOrAdd(cluster.cores, thread.core).cpus.push_back(cpu);
+  }
+  readPerformanceLevels(topology, cpus_fd);
+  ::close(cpus_fd);
+
+  readNumaNodes(topology);
+  return topology;
+}
+
+namespace {
+
+// "48K", the kernel always uses K but be tolerant
+int64_t parseCacheSize_Bytes(std::string_view value) {
+  const auto parsed = utils::consumeNumber<int64_t>(value);
+  if (!parsed) {
+    return -1;
+  }
+  const int64_t size = *parsed;
+  switch (value.empty() ? '\0' : value.front()) {
+    case 'K':
+      return size * 1024;
+    case 'M':
+      return size * 1024 * 1024;
+    case 'G':
+      return size * 1024 * 1024 * 1024;
+    default:
+      return size;
+  }
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+std::vector<CacheInfo> getCacheHierarchy() {
+  HWINFO_PROBE("cpu.caches");
+  std::vector<CacheInfo> caches;
+  const int cpus_fd = ::open(filesystem::rooted("/sys/devices/system/cpu").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (cpus_fd < 0) {
+    return caches;
+  }
+  char buffer[256];
+  for (const int cpu : readCpuListAt(cpus_fd, "online")) {
+    for (int index = 0;; ++index) {
+      const std::string name = "cpu" + std::to_string(cpu) + "/cache/index" + std::to_string(index);
+      const int cache_fd = ::openat(cpus_fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (cache_fd < 0) {
+        break;
+      }
+      CacheInfo cache;
+      cache.shared_cpus = readCpuListAt(cache_fd, "shared_cpu_list");
+      // every cache is listed by all CPUs sharing it, only the first of them adds it
+      if (!cache.shared_cpus.empty() && cache.shared_cpus.front() != cpu) {
+        ::close(cache_fd);
+        continue;
+      }
+      cache.level = static_cast<int>(filesystem::readIntAttributeAt(cache_fd, "level", 10, -1));
+      if (filesystem::readAttributeAt(cache_fd, "type", buffer, sizeof(buffer)) > 0) {
+        if (std::strcmp(buffer, "Data") == 0) {
+          cache.type = CacheInfo::Type::Data;
+        } else if (std::strcmp(buffer, "Instruction") == 0) {
+          cache.type = CacheInfo::Type::Instruction;
+        }
+      }
+      if (filesystem::readAttributeAt(cache_fd, "size", buffer, sizeof(buffer)) > 0) {
+        cache.size_Bytes = parseCacheSize_Bytes(buffer);
+      }
+      cache.line_size_Bytes = static_cast<int>(filesystem::readIntAttributeAt(cache_fd, "coherency_line_size", 10, -1));
+      cache.associativity = static_cast<int>(filesystem::readIntAttributeAt(cache_fd, "ways_of_associativity", 10, -1));
+      cache.sets = filesystem::readIntAttributeAt(cache_fd, "number_of_sets", 10, -1);
+      ::close(cache_fd);
+      caches.push_back(std::move(cache));
+    }
+  }
+  ::close(cpus_fd);
+  std::sort(caches.begin(), caches.end());
+  return caches;
+}
+
+#if !defined(HWINFO_X86)
+// _____________________________________________________________________________________________________________________
+CpuFeatures CpuFeatures::detect() {
+  CpuFeatures features;
+#if defined(__aarch64__)
+  // bits of asm/hwcap.h, spelled out because older headers lack the newer ones
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+  const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+  const std::pair<unsigned long, Feature> hwcap_bits[] = {
+      {1ul << 1, Feature::NEON},        {1ul << 3, Feature::ARM_AES},   {1ul << 4, Feature::ARM_PMULL},
+      {1ul << 5, Feature::ARM_SHA1},    {1ul << 6, Feature::ARM_SHA2},  {1ul << 7, Feature::ARM_CRC32},
+      {1ul << 8, Feature::ARM_ATOMICS}, {1ul << 10, Feature::ARM_FP16}, {1ul << 20, Feature::ARM_DOTPROD},
+      {1ul << 22, Feature::SVE}};
+  for (const auto& [bit, feature] : hwcap_bits) {
+    if (hwcap & bit) features.set(feature);
+  }
+  const std::pair<unsigned long, Feature> hwcap2_bits[] = {
+      {1ul << 1, Feature::SVE2}, {1ul << 13, Feature::ARM_I8MM}, {1ul << 14, Feature::ARM_BF16},
+      {1ul << 23, Feature::SME}};
+  for (const auto& [bit, feature] : hwcap2_bits) {
+    if (hwcap2 & bit) features.set(feature);
+  }
+#endif
+  return features;
+}
+#endif  // !HWINFO_X86
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_UNIX
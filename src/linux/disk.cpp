@@ -5,28 +5,37 @@
 
 #ifdef HWINFO_UNIX
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <sys/statvfs.h>
+#include <unistd.h>
 
+#include <cstdio>
 #include <fstream>
-#include <regex>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "hwinfo/disk.h"
 #include "hwinfo/utils/constants.h"
 #include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
 #include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
 
 namespace {
 // _____________________________________________________________________________________________________________________
-bool isPartition(const std::string& path) {
-  static const std::regex partitionRegex(R"((sd[a-z]|nvme\d+n\d+)p?\d+$)");
-  return std::regex_search(path, partitionRegex);
+bool isPartition(int block_fd) {
+  // the kernel exports the partition number only for partitions
+  return faccessat(block_fd, "partition", F_OK, 0) == 0;
 }
 
 // _____________________________________________________________________________________________________________________
 bool readFile(const std::string& path, std::string& outContent) {
   // Reads the file content and stores it in `outContent`. Returns true if successful, false otherwise.
   std::ifstream file(path);
+  HWINFO_COUNT_OPEN();
   if (!file) return false;
 
   std::getline(file, outContent);
@@ -35,16 +44,97 @@ bool readFile(const std::string& path, std::string& outContent) {
 }
 
 // _____________________________________________________________________________________________________________________
-std::string getMountPoint(const std::string& device) {
-  std::ifstream mounts("/proc/mounts");
-  std::string line, dev, mount_point;
-  while (std::getline(mounts, line)) {
-    std::istringstream iss(line);
-    if (iss >> dev >> mount_point && dev == device) {
-      return mount_point;
+std::string_view nextField(std::string_view& line) {
+  const size_t end = line.find(' ');
+  const std::string_view field = line.substr(0, end);
+  line.remove_prefix(end == std::string_view::npos ? line.size() : end + 1);
+  return field;
+}
+
+// _____________________________________________________________________________________________________________________
+std::string unescapeMountPoint(std::string_view escaped) {
+  // mountinfo encodes space, tab, newline and backslash as \ooo
+  std::string mount_point;
+  mount_point.reserve(escaped.size());
+  for (size_t i = 0; i < escaped.size(); ++i) {
+    if (escaped[i] == '\\' && i + 3 < escaped.size() && escaped[i + 1] >= '0' && escaped[i + 1] <= '3') {
+      mount_point.push_back(
+          static_cast<char>(((escaped[i + 1] - '0') << 6) | ((escaped[i + 2] - '0') << 3) | (escaped[i + 3] - '0')));
+      i += 3;
+    } else {
+      mount_point.push_back(escaped[i]);
+    }
+  }
+  return mount_point;
+}
+
+// _____________________________________________________________________________________________________________________
+std::unordered_map<std::string, std::vector<std::string>> getMountPoints() {
+  // "major:minor" -> all mount points of that block device, /proc/self/mountinfo is parsed once for all disks
+  HWINFO_PROBE("disk.mountinfo");
+  std::unordered_map<std::string, std::vector<std::string>> mount_points;
+  std::ifstream mountinfo(hwinfo::filesystem::rooted("/proc/self/mountinfo"));
+  HWINFO_COUNT_OPEN();
+  std::string line;
+  while (std::getline(mountinfo, line)) {
+    // mount ID, parent ID, major:minor, root, mount point, ...
+    std::string_view rest(line);
+    nextField(rest);
+    nextField(rest);
+    const std::string_view device = nextField(rest);
+    nextField(rest);
+    const std::string_view mount_point = nextField(rest);
+    // pseudo file systems (proc, overlay, tmpfs, ...) have major 0 and never match a block device
+    if (mount_point.empty() || device.compare(0, 2, "0:") == 0) {
+      continue;
+    }
+    mount_points[std::string(device)].push_back(unescapeMountPoint(mount_point));
+  }
+  return mount_points;
+}
+
+// _____________________________________________________________________________________________________________________
+void addMountPoints(int block_fd, const std::unordered_map<std::string, std::vector<std::string>>& mount_points,
+                    std::vector<std::string>& first_mount_points, std::vector<std::string>& volumes) {
+  char dev[32];
+  if (hwinfo::filesystem::readAttributeAt(block_fd, "dev", dev, sizeof(dev)) <= 0) {
+    return;
+  }
+  const auto it = mount_points.find(dev);
+  if (it == mount_points.end()) {
+    return;
+  }
+  // bind mounts share the file system, refresh() only needs one mount point per device
+  first_mount_points.push_back(it->second.front());
+  volumes.insert(volumes.end(), it->second.begin(), it->second.end());
+}
+
+// _____________________________________________________________________________________________________________________
+void collectMountPoints(int disk_fd, const std::unordered_map<std::string, std::vector<std::string>>& mount_points,
+                        std::vector<std::string>& first_mount_points, std::vector<std::string>& volumes) {
+  // the disk itself may hold a file system without partition table
+  addMountPoints(disk_fd, mount_points, first_mount_points, volumes);
+  // partitions are subdirectories of the disk directory
+  const int dir_fd = dup(disk_fd);
+  DIR* dir = dir_fd >= 0 ? fdopendir(dir_fd) : nullptr;
+  if (dir == nullptr) {
+    if (dir_fd >= 0) close(dir_fd);
+    return;
+  }
+  while (const dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] == '.' || (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN)) {
+      continue;
     }
+    const int part_fd = openat(disk_fd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (part_fd < 0) {
+      continue;
+    }
+    if (isPartition(part_fd)) {
+      addMountPoints(part_fd, mount_points, first_mount_points, volumes);
+    }
+    close(part_fd);
   }
-  return "/";
+  closedir(dir);
 }
 }  // anonymous namespace
 
@@ -81,6 +171,7 @@ std::string getDiskSerialNumber(const std::string& path) {
 // _____________________________________________________________________________________________________________________
 int64_t getDiskSize_Bytes(const std::string& path) {
   std::ifstream f(path + "/size");
+  HWINFO_COUNT_OPEN();
   if (f) {
     int64_t size;
     f >> size;
@@ -93,44 +184,161 @@ int64_t getDiskSize_Bytes(const std::string& path) {
 // _____________________________________________________________________________________________________________________
 int64_t getDiskFreeSize_Bytes(const std::string& path) {
   struct statvfs stat{};
+  HWINFO_COUNT_SYSCALL();
   if (statvfs(path.c_str(), &stat) == 0)
     return static_cast<int64_t>(stat.f_bsize) * static_cast<int64_t>(stat.f_bavail);
 
   return -1;
 }
 
+// _____________________________________________________________________________________________________________________
+int64_t getFreeSize_Bytes(const std::vector<std::string>& mount_points) {
+  HWINFO_PROBE("disk.statvfs");
+  int64_t free_size = -1;
+  for (const auto& mount_point : mount_points) {
+    const int64_t free = getDiskFreeSize_Bytes(mount_point);
+    if (free >= 0) free_size = (free_size < 0 ? 0 : free_size) + free;
+  }
+  return free_size;
+}
+
+// _____________________________________________________________________________________________________________________
+Disk::Mounts Disk::resolveMounts() const {
+  Mounts mounts;
+  // neither free space nor volumes were requested
+  if (!_mount_table) {
+    return mounts;
+  }
+  const int block_fd = open(_sysfs_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  HWINFO_COUNT_OPEN();
+  if (block_fd < 0) {
+    return mounts;
+  }
+  std::vector<std::string> volumes;
+  collectMountPoints(block_fd, _mount_table->get([] { return getMountPoints(); }), mounts.mount_points, volumes);
+  close(block_fd);
+  if (has_field(_fields, DiskFields::Free)) {
+    mounts.free_size_Bytes = getFreeSize_Bytes(mounts.mount_points);
+  }
+  if (has_field(_fields, DiskFields::Volumes)) {
+    mounts.volumes = std::move(volumes);
+  }
+  return mounts;
+}
+
+// _____________________________________________________________________________________________________________________
+bool Disk::refresh() {
+  const bool resolved = _mounts.ready();
+  Mounts& mounts = _mounts.get([this] { return resolveMounts(); });
+  if (!resolved && has_field(_fields, DiskFields::Free)) {
+    // just read by resolveMounts()
+    return mounts.free_size_Bytes >= 0;
+  }
+  const int64_t free_size = getFreeSize_Bytes(mounts.mount_points);
+  if (free_size < 0) {
+    return false;
+  }
+  mounts.free_size_Bytes = free_size;
+  return true;
+}
+
 // =====================================================================================================================
 // _____________________________________________________________________________________________________________________
-std::vector<Disk> getAllDisks() {
+std::vector<Disk> getAllDisks(DiskFields fields) {
+  HWINFO_PROBE("disk.sysfs");
   std::vector<Disk> disks;
-  const std::string base_path = "/sys/class/block/";
+  const std::string base_path = filesystem::rooted("/sys/class/block/");
+  const bool need_mounts = has_field(fields, DiskFields::Free | DiskFields::Volumes);
+  const bool need_identity = has_field(fields, DiskFields::Vendor | DiskFields::Model | DiskFields::Serial);
+  // mountinfo is parsed when the free space or the volumes of one of the disks are first accessed, for all of them
+  const auto mount_table = need_mounts ? std::make_shared<const utils::Lazy<Disk::MountTable>>() : nullptr;
 
   for (const auto& entry : filesystem::getDirectoryEntries(base_path)) {
     std::string path = base_path + entry;
-    if (!filesystem::exists(path) || isPartition(path)) continue;
+    const int block_fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (block_fd < 0) continue;
+    if (isPartition(block_fd)) {
+      close(block_fd);
+      continue;
+    }
 
     Disk disk;
-    disk._vendor = getDiskVendor(path);
-    disk._model = getDiskModel(path);
-    disk._serialNumber = getDiskSerialNumber(path);
-
-    // Check before get size because size is always define in /sys/class/block/...
-    if (disk._vendor == constants::UNKNOWN && disk._model == constants::UNKNOWN &&
-        disk._serialNumber == constants::UNKNOWN) {
+    if (need_identity) {
+      if (has_field(fields, DiskFields::Vendor)) disk._vendor = getDiskVendor(path);
+      if (has_field(fields, DiskFields::Model)) disk._model = getDiskModel(path);
+      if (has_field(fields, DiskFields::Serial)) disk._serialNumber = getDiskSerialNumber(path);
+      // Check before get size because size is always define in /sys/class/block/...
+      const auto unknown = [](const std::string& value) { return value.empty() || value == constants::UNKNOWN; };
+      if (unknown(disk._vendor) && unknown(disk._model) && unknown(disk._serialNumber)) {
+        close(block_fd);
+        continue;
+      }
+    } else if (faccessat(block_fd, "device", F_OK, 0) != 0) {
+      // without identity attributes, disks are recognized by their device link (loop and ram disks have none)
+      close(block_fd);
       continue;
     }
 
-    disk._size_Bytes = getDiskSize_Bytes(path);
+    if (has_field(fields, DiskFields::Capacity)) {
+      disk._size_Bytes = getDiskSize_Bytes(path);
+    }
 
-    auto mount_point = getMountPoint("/dev/" + entry);
-    disk._free_size_Bytes = getDiskFreeSize_Bytes(mount_point);
-    disk._volumes.push_back(std::move(mount_point));
+    if (need_mounts) {
+      disk._sysfs_path = path;
+      disk._fields = fields;
+      disk._mount_table = mount_table;
+    }
+    close(block_fd);
 
     disks.push_back(std::move(disk));
   }
 
   return disks;
 }
+
+// _____________________________________________________________________________________________________________________
+std::vector<DiskIOSampler::Counters> DiskIOSampler::read_counters() {
+  HWINFO_PROBE("disk.diskstats");
+  std::vector<Counters> counters;
+  FILE* file = fopen(filesystem::rooted("/proc/diskstats").c_str(), "re");
+  HWINFO_COUNT_OPEN();
+  if (file == nullptr) {
+    return counters;
+  }
+  char line[512];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    // major minor name, then reads merged sectors time_ms writes merged sectors time_ms in_flight io_time_ms
+    // weighted_ms (and discard/flush counters on newer kernels)
+    utils::Tokenizer columns(line);
+    std::string_view name;
+    if (!columns.skip(2) || !columns.next(name)) {
+      continue;
+    }
+    uint64_t values[11];
+    bool complete = true;
+    for (auto& value : values) {
+      const auto parsed = columns.nextNumber<uint64_t>();
+      complete = complete && parsed.has_value();
+      value = parsed.value_or(0);
+    }
+    if (!complete) {
+      continue;
+    }
+    Counters device;
+    device.name = std::string(name);
+    device.reads = static_cast<int64_t>(values[0]);
+    device.writes = static_cast<int64_t>(values[4]);
+    device.read_Bytes = static_cast<int64_t>(values[2]) * block_size;
+    device.write_Bytes = static_cast<int64_t>(values[6]) * block_size;
+    device.read_time_ms = static_cast<double>(values[3]);
+    device.write_time_ms = static_cast<double>(values[7]);
+    device.busy_time_ms = static_cast<double>(values[9]);
+    device.weighted_time_ms = static_cast<double>(values[10]);
+    counters.push_back(std::move(device));
+  }
+  fclose(file);
+  return counters;
+}
 }  // namespace hwinfo
 
 #endif  // HWINFO_UNIX
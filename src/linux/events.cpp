@@ -0,0 +1,192 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "hwinfo/events.h"
+
+namespace hwinfo {
+
+struct DeviceWatcher::Backend {
+  int uevent_fd{-1};
+  int route_fd{-1};
+  int stop_fd{-1};
+};
+
+namespace {
+
+int open_netlink(int protocol, uint32_t groups) {
+  const int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, protocol);
+  if (fd < 0) {
+    return -1;
+  }
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = groups;
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// A uevent is "<action>@<devpath>" followed by null terminated KEY=VALUE pairs.
+void parse_uevent(const char* buffer, size_t size, std::vector<DeviceEvent>& events) {
+  const char* end = buffer + size;
+  const char* at = static_cast<const char*>(std::memchr(buffer, '@', size));
+  if (at == nullptr) {
+    // libudev messages ("libudev\0...") are not sent to the kernel group
+    return;
+  }
+  const std::string action(buffer, at);
+  std::string subsystem, devtype, name;
+  for (const char* entry = buffer + std::strlen(buffer) + 1; entry < end; entry += std::strlen(entry) + 1) {
+    if (std::strncmp(entry, "SUBSYSTEM=", 10) == 0) {
+      subsystem = entry + 10;
+    } else if (std::strncmp(entry, "DEVTYPE=", 8) == 0) {
+      devtype = entry + 8;
+    } else if (std::strncmp(entry, "DEVNAME=", 8) == 0 && name.empty()) {
+      name = entry + 8;
+    } else if (std::strncmp(entry, "INTERFACE=", 10) == 0) {
+      name = entry + 10;
+    } else if (std::strncmp(entry, "POWER_SUPPLY_NAME=", 18) == 0) {
+      name = entry + 18;
+    }
+  }
+  DeviceEvent event;
+  if (subsystem == "block" && devtype == "disk") {
+    event.device_class = DeviceEvent::Class::Disk;
+  } else if (subsystem == "drm") {
+    event.device_class = DeviceEvent::Class::Monitor;
+  } else if (subsystem == "net") {
+    // link state and addresses are reported via rtnetlink, uevents only announce new and removed interfaces
+    if (action != "add" && action != "remove") return;
+    event.device_class = DeviceEvent::Class::Network;
+  } else if (subsystem == "power_supply") {
+    event.device_class = DeviceEvent::Class::PowerSource;
+  } else {
+    return;
+  }
+  if (action == "add") {
+    event.action = DeviceEvent::Action::Add;
+  } else if (action == "remove") {
+    event.action = DeviceEvent::Action::Remove;
+  } else if (action == "change") {
+    event.action = DeviceEvent::Action::Change;
+  } else {
+    // bind, unbind, move, online, offline
+    return;
+  }
+  if (name.empty()) {
+    const char* slash = std::strrchr(at + 1, '/');
+    name = slash != nullptr ? slash + 1 : at + 1;
+  }
+  event.name = std::move(name);
+  events.push_back(std::move(event));
+}
+
+void parse_route(const char* buffer, size_t size, std::vector<DeviceEvent>& events) {
+  int remaining = static_cast<int>(size);
+  for (auto* header = reinterpret_cast<const nlmsghdr*>(buffer); NLMSG_OK(header, remaining);
+       header = NLMSG_NEXT(header, remaining)) {
+    int index = 0;
+    switch (header->nlmsg_type) {
+      case RTM_NEWLINK:
+      case RTM_DELLINK:
+        index = static_cast<const ifinfomsg*>(NLMSG_DATA(header))->ifi_index;
+        break;
+      case RTM_NEWADDR:
+      case RTM_DELADDR:
+        index = static_cast<int>(static_cast<const ifaddrmsg*>(NLMSG_DATA(header))->ifa_index);
+        break;
+      default:
+        continue;
+    }
+    char name[IF_NAMESIZE] = {0};
+    if (if_indextoname(static_cast<unsigned>(index), name) == nullptr) {
+      // the interface is already gone, the uevent reports its removal
+      continue;
+    }
+    events.push_back({DeviceEvent::Class::Network, DeviceEvent::Action::Change, name});
+  }
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+void DeviceWatcher::BackendDeleter::operator()(Backend* backend) const {
+  for (const int fd : {backend->uevent_fd, backend->route_fd, backend->stop_fd}) {
+    if (fd >= 0) close(fd);
+  }
+  delete backend;
+}
+
+// _____________________________________________________________________________________________________________________
+DeviceWatcher::Backend* DeviceWatcher::open_backend() {
+  auto* backend = new Backend;
+  // group 1: kernel uevents (group 2 are the processed udev events, which require udevd)
+  backend->uevent_fd = open_netlink(NETLINK_KOBJECT_UEVENT, 1);
+  backend->route_fd = open_netlink(NETLINK_ROUTE, RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR);
+  backend->stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (backend->stop_fd < 0 || (backend->uevent_fd < 0 && backend->route_fd < 0)) {
+    BackendDeleter()(backend);
+    return nullptr;
+  }
+  return backend;
+}
+
+// _____________________________________________________________________________________________________________________
+bool DeviceWatcher::wait_events(Backend& backend, std::vector<DeviceEvent>& events) {
+  pollfd fds[3] = {{backend.stop_fd, POLLIN, 0}, {backend.uevent_fd, POLLIN, 0}, {backend.route_fd, POLLIN, 0}};
+  // uevents are at most 8 KiB, rtnetlink messages are batched into one datagram of up to a page
+  alignas(nlmsghdr) char buffer[16384];
+  while (events.empty()) {
+    // negative fds are ignored by poll()
+    if (poll(fds, 3, -1) < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    if (fds[0].revents != 0) {
+      return false;
+    }
+    if (fds[1].revents & POLLIN) {
+      ssize_t len;
+      while ((len = recv(backend.uevent_fd, buffer, sizeof(buffer) - 1, 0)) > 0) {
+        buffer[len] = '\0';
+        parse_uevent(buffer, static_cast<size_t>(len), events);
+      }
+    }
+    if (fds[2].revents & POLLIN) {
+      ssize_t len;
+      while ((len = recv(backend.route_fd, buffer, sizeof(buffer), 0)) > 0) {
+        parse_route(buffer, static_cast<size_t>(len), events);
+      }
+    }
+  }
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void DeviceWatcher::interrupt(Backend& backend) {
+  const uint64_t value = 1;
+  [[maybe_unused]] const ssize_t written = write(backend.stop_fd, &value, sizeof(value));
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
@@ -9,97 +9,165 @@
 #include "hwinfo/gpu.h"
 #include "hwinfo/utils/PCIMapper.h"
 #include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
 
 #ifdef USE_OCL
 #include "hwinfo/opencl/device.h"
 #endif
 
-#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <map>
 #include <string>
 #include <vector>
 
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
-std::string read_drm_by_path(const std::string& path) {
-  std::ifstream f_drm(path);
-  if (!f_drm) {
-    return "";
-  }
-  std::string ret;
-  getline(f_drm, ret);
-  return ret;
-}
+std::vector<GPU> getAllGPUs([[maybe_unused]] bool use_opencl) {
+  HWINFO_PROBE("gpu.sysfs");
+  std::vector<GPU> gpus{};
+  std::vector<PCIId> pci_ids;
 
-// _____________________________________________________________________________________________________________________
-std::vector<int> get_frequencies(const std::string drm_path) {
-  // {min, current, max}
-  std::vector<int> freqs(3);
-  try {
-    freqs[0] = std::stoi(read_drm_by_path(drm_path + "gt_min_freq_mhz"));
-  } catch (const std::invalid_argument& e) {
-    freqs[0] = -1;
-  }
-  try {
-    freqs[1] = std::stoi(read_drm_by_path(drm_path + "gt_cur_freq_mhz"));
-  } catch (const std::invalid_argument& e) {
-    freqs[0] = -1;
-  }
-  try {
-    freqs[2] = std::stoi(read_drm_by_path(drm_path + "gt_max_freq_mhz"));
-  } catch (const std::invalid_argument& e) {
-    freqs[0] = -1;
+  // only "cardN" entries are GPUs. Connectors (cardN-HDMI-A-1) and render nodes (renderDN) are skipped, several
+  // nodes of the same device are deduplicated by the resolved device path below.
+  std::vector<int> card_ids;
+  for (const auto& entry : filesystem::getDirectoryEntries(filesystem::rooted("/sys/class/drm"))) {
+    if (entry.size() <= 4 || entry.compare(0, 4, "card") != 0 ||
+        entry.find_first_not_of("0123456789", 4) != std::string::npos) {
+      continue;
+    }
+    if (const auto id = utils::toNumber<int>(std::string_view(entry).substr(4))) {
+      card_ids.push_back(*id);
+    }
   }
-  return freqs;
-}
+  std::sort(card_ids.begin(), card_ids.end());
 
-// _____________________________________________________________________________________________________________________
-std::vector<GPU> getAllGPUs() {
-  std::vector<GPU> gpus{};
-  PCIMapper pci = PCI::getMapper();
-  int id = 0;
-  while (true) {
+  std::vector<std::string> seen_devices;
+  char buffer[PATH_MAX];
+  for (const int id : card_ids) {
+    const std::string path(filesystem::rooted("/sys/class/drm/card") + std::to_string(id) + '/');
+    if (realpath((path + "device").c_str(), buffer) == nullptr) {
+      continue;
+    }
+    if (std::find(seen_devices.begin(), seen_devices.end(), buffer) != seen_devices.end()) {
+      continue;
+    }
+    seen_devices.emplace_back(buffer);
+    // the resolved device path ends with the PCI address, e.g. /sys/devices/pci0000:00/0000:00:01.0/0000:01:00.0
+    const char* slash = std::strrchr(buffer, '/');
+    std::string pci_bus_id(slash != nullptr ? slash + 1 : buffer);
+
+    // all attributes of a card are read relative to the card directory
+    const int card_fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (card_fd < 0) {
+      continue;
+    }
     GPU gpu;
     gpu._id = id;
-    std::string path("/sys/class/drm/card" + std::to_string(id) + '/');
-    if (!filesystem::exists(path)) {
-      if (id > 2) {
-        break;
-      }
-      id++;
-      continue;
+    gpu._pci_bus_id = std::move(pci_bus_id);
+    if (filesystem::readAttributeAt(card_fd, "device/vendor", buffer, sizeof(buffer)) > 0) {
+      gpu._vendor_id = buffer;
+    }
+    if (filesystem::readAttributeAt(card_fd, "device/device", buffer, sizeof(buffer)) > 0) {
+      gpu._device_id = buffer;
     }
-    gpu._vendor_id = read_drm_by_path(path + "device/vendor");
-    gpu._device_id = read_drm_by_path(path + "device/device");
+    gpu._frequency_MHz = filesystem::readIntAttributeAt(card_fd, "gt_max_freq_mhz", 10);
+    close(card_fd);
     if (gpu._vendor_id.empty() || gpu._device_id.empty()) {
-      id++;
       continue;
     }
-    const PCIVendor& vendor = pci[gpu._vendor_id];
-    const PCIDevice device = vendor[gpu._device_id];
-    gpu._vendor = vendor.vendor_name;
-    gpu._name = vendor[gpu._device_id].device_name;
-    auto frequencies = get_frequencies(path);
-    gpu._frequency_MHz = frequencies[2];
+    PCIId pci_id;
+    PCIMapper::parse_id(gpu._vendor_id, pci_id.vendor_id);
+    PCIMapper::parse_id(gpu._device_id, pci_id.device_id);
+    pci_ids.push_back(pci_id);
     gpus.push_back(std::move(gpu));
-    id++;
+  }
+  // resolve all names in one pass
+  const auto names = PCI::getMapper().resolve(pci_ids);
+  for (size_t i = 0; i < gpus.size(); ++i) {
+    gpus[i]._vendor = names[i].vendor.vendor_name;
+    gpus[i]._name = names[i].device.device_name;
   }
 #ifdef USE_OCL
-  auto cl_gpus = opencl_::DeviceManager::get_list<opencl_::Filter::GPU>();
-  for (auto& gpu : gpus) {
-    for (auto* cl_gpu : cl_gpus) {
-      if (cl_gpu->name().find(gpu._device_id)) {
-        gpu._driverVersion = cl_gpu->driver_version();
-        gpu._frequency_MHz = static_cast<int64_t>(cl_gpu->clock_frequency_MHz());
-        gpu._num_cores = static_cast<int>(cl_gpu->cores());
-        gpu._memory_Bytes = static_cast<int64_t>(cl_gpu->memory_Bytes());
+  if (use_opencl) {
+    HWINFO_PROBE("gpu.opencl");
+    // the OpenCL device list is queried once per process (DeviceManager singleton), match by PCI address
+    std::map<std::string, const opencl_::Device*> cl_by_bus_id;
+    for (const auto* cl_gpu : opencl_::DeviceManager::get_list<opencl_::Filter::GPU>()) {
+      if (!cl_gpu->pci_bus_id().empty()) {
+        cl_by_bus_id.emplace(cl_gpu->pci_bus_id(), cl_gpu);
+      }
+    }
+    for (auto& gpu : gpus) {
+      const auto it = cl_by_bus_id.find(gpu._pci_bus_id);
+      if (it == cl_by_bus_id.end()) {
+        continue;
       }
+      const auto* cl_gpu = it->second;
+      gpu._driverVersion = cl_gpu->driver_version();
+      gpu._frequency_MHz = static_cast<int64_t>(cl_gpu->clock_frequency_MHz());
+      gpu._num_cores = static_cast<int>(cl_gpu->cores());
+      gpu._memory_Bytes = static_cast<int64_t>(cl_gpu->memory_Bytes());
     }
   }
 #endif  // USE_OCL
   return gpus;
 }
 
+// =====================================================================================================================
+struct GPUMonitor::Sources {
+  filesystem::SysfsReader busy_percent;    // amdgpu
+  filesystem::SysfsReader vram_used;       // amdgpu, Bytes
+  filesystem::SysfsReader power_average;   // hwmon, micro Watt
+  filesystem::SysfsReader cur_freq_mhz;    // i915
+  filesystem::SysfsReader freq_input_hz;   // hwmon (amdgpu sclk), Hz
+};
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::SourcesDeleter::operator()(Sources* sources) const { delete sources; }
+
+// _____________________________________________________________________________________________________________________
+GPUMonitor::Sources* GPUMonitor::open_sources(int gpu_id) {
+  const std::string card_path(filesystem::rooted("/sys/class/drm/card") + std::to_string(gpu_id) + '/');
+  auto* sources = new Sources;
+  sources->busy_percent = filesystem::SysfsReader(card_path + "device/gpu_busy_percent");
+  sources->vram_used = filesystem::SysfsReader(card_path + "device/mem_info_vram_used");
+  sources->cur_freq_mhz = filesystem::SysfsReader(card_path + "gt_cur_freq_mhz");
+  for (const auto& hwmon : filesystem::getDirectoryEntries(card_path + "device/hwmon")) {
+    const std::string hwmon_path(card_path + "device/hwmon/" + hwmon + '/');
+    sources->power_average = filesystem::SysfsReader(hwmon_path + "power1_average");
+    sources->freq_input_hz = filesystem::SysfsReader(hwmon_path + "freq1_input");
+    break;
+  }
+  return sources;
+}
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::read_sources(Sources& sources, Sample& sample) {
+  HWINFO_PROBE("gpu.monitor");
+  if (const int64_t busy = sources.busy_percent.readInt(); busy >= 0) {
+    sample.utilisation = static_cast<double>(busy) / 100.0;
+  }
+  sample.memory_used_Bytes = sources.vram_used.readInt();
+  if (const int64_t power_uW = sources.power_average.readInt(); power_uW >= 0) {
+    sample.power_W = static_cast<double>(power_uW) / 1e6;
+  }
+  sample.frequency_MHz = sources.cur_freq_mhz.readInt();
+  if (sample.frequency_MHz < 0) {
+    if (const int64_t freq_Hz = sources.freq_input_hz.readInt(); freq_Hz >= 0) {
+      sample.frequency_MHz = freq_Hz / 1000000;
+    }
+  }
+}
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_UNIX
\ No newline at end of file
@@ -0,0 +1,244 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hwinfo/interrupts.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
+
+namespace hwinfo {
+
+namespace {
+
+using Source = InterruptSampler::Source;
+
+// Reads the whole procfs file at offset 0, the buffer grows until the content fits. In the steady state this is one
+// pread() per file: seq_file fills the whole user buffer in one call.
+bool readAll(int& fd, const char* path, std::vector<char>& buffer, size_t& size) {
+  if (fd < 0) {
+    fd = ::open(filesystem::rooted(path).c_str(), O_RDONLY | O_CLOEXEC);
+    HWINFO_COUNT_OPEN();
+    if (fd < 0) {
+      return false;
+    }
+  }
+  if (buffer.size() < 16 * 1024) {
+    buffer.resize(16 * 1024);
+  }
+  for (;;) {
+    ssize_t n;
+    do {
+      n = ::pread(fd, buffer.data(), buffer.size(), 0);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+      return false;
+    }
+    HWINFO_COUNT_READ(n);
+    if (static_cast<size_t>(n) < buffer.size()) {
+      size = static_cast<size_t>(n);
+      return true;
+    }
+    buffer.resize(buffer.size() * 2);
+  }
+}
+
+// "           CPU0       CPU1" -> {0, 1}
+std::vector<int> parseHeader(std::string_view line) {
+  std::vector<int> cpus;
+  utils::Tokenizer columns(line);
+  std::string_view column;
+  while (columns.next(column)) {
+    if (!utils::consumePrefix(column, "CPU")) continue;
+    if (const auto cpu = utils::toNumber<int>(column)) cpus.push_back(*cpu);
+  }
+  return cpus;
+}
+
+// "0000:01:00.0"
+bool isPCIAddress(std::string_view name) {
+  return name.size() == 12 && name[4] == ':' && name[7] == ':' && name[10] == '.';
+}
+
+// the last PCI function on the sysfs path of a device, e.g. of /sys/devices/pci0000:00/0000:00:03.0/virtio0
+std::string pciAddressOf(const std::string& device_link) {
+  char resolved[PATH_MAX];
+  if (realpath(device_link.c_str(), resolved) == nullptr) {
+    return {};
+  }
+  std::string_view path(resolved);
+  std::string_view address;
+  utils::Tokenizer components(path, "/");
+  std::string_view component;
+  while (components.next(component)) {
+    if (isPCIAddress(component)) address = component;
+  }
+  return std::string(address);
+}
+
+/**
+ * Maps the numbered IRQs to their PCI device and network interface: the MSI vectors (msi_irqs/<irq>) and legacy
+ * interrupt line (irq) of every PCI function, the interfaces with a PCI device somewhere on the path of their device
+ * link, and as fallbacks the "@pci:<address>" suffix (mlx5) or an interface name in the handler names (eth0-rx-0).
+ */
+void resolveDevices(std::vector<Source>& sources) {
+  HWINFO_PROBE("interrupts.devices");
+  std::unordered_map<int, std::string> irq_devices;
+  const std::string pci_path = filesystem::rooted("/sys/bus/pci/devices/");
+  for (const auto& address : filesystem::getDirectoryEntries(pci_path)) {
+    for (const auto& irq : filesystem::getDirectoryEntries(pci_path + address + "/msi_irqs")) {
+      if (const auto number = utils::toNumber<int>(irq)) irq_devices.emplace(*number, address);
+    }
+    const int64_t line = filesystem::SysfsReader(pci_path + address + "/irq").readInt();
+    if (line > 0) irq_devices.emplace(static_cast<int>(line), address);
+  }
+
+  const std::string net_path = filesystem::rooted("/sys/class/net/");
+  auto interfaces = filesystem::getDirectoryEntries(net_path);
+  std::sort(interfaces.begin(), interfaces.end());
+  std::unordered_map<std::string, std::string> device_interfaces;
+  for (const auto& interface : interfaces) {
+    const std::string address = pciAddressOf(net_path + interface + "/device");
+    if (!address.empty()) device_interfaces.emplace(address, interface);
+  }
+
+  for (auto& source : sources) {
+    source.pci_address.clear();
+    source.interface.clear();
+    if (source.kind != Source::Kind::Device) continue;
+    if (const auto irq = utils::toNumber<int>(source.name)) {
+      const auto it = irq_devices.find(*irq);
+      if (it != irq_devices.end()) source.pci_address = it->second;
+    }
+    const size_t suffix = source.description.find("@pci:");
+    if (source.pci_address.empty() && suffix != std::string::npos) {
+      const std::string_view address = std::string_view(source.description).substr(suffix + 5, 12);
+      if (isPCIAddress(address)) source.pci_address = std::string(address);
+    }
+    const auto it = device_interfaces.find(source.pci_address);
+    if (it != device_interfaces.end()) {
+      source.interface = it->second;
+      continue;
+    }
+    utils::Tokenizer handlers(source.description, " ,");
+    std::string_view handler;
+    while (source.interface.empty() && handlers.next(handler)) {
+      for (const auto& interface : interfaces) {
+        if (handler == interface || (handler.size() > interface.size() + 1 && handler[interface.size()] == '-' &&
+                                     handler.substr(0, interface.size()) == interface)) {
+          source.interface = interface;
+          break;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Parses one table of /proc/interrupts or /proc/softirqs into the rows starting at row. Rows that differ from the
+ * cached sources are overwritten and reported by setting changed. The counters of CPUs that are not in cpus (softirqs
+ * lists all possible CPUs) are dropped, rows with fewer values (ERR, MIS) are padded with 0.
+ */
+void parseTable(std::string_view content, Source::Kind kind, const std::vector<int>& cpus, std::vector<Source>& sources,
+                std::vector<uint64_t>& counts, size_t& row, bool& changed) {
+  std::string_view line;
+  if (!utils::nextLine(content, line)) {
+    return;
+  }
+  const auto table_cpus = parseHeader(line);
+  std::vector<int> columns(table_cpus.size(), -1);
+  for (size_t i = 0; i < table_cpus.size(); ++i) {
+    const auto it = std::find(cpus.begin(), cpus.end(), table_cpus[i]);
+    if (it != cpus.end()) columns[i] = static_cast<int>(it - cpus.begin());
+  }
+  while (utils::nextLine(content, line)) {
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos) continue;
+    const std::string_view name = utils::trim(line.substr(0, colon));
+    std::string_view rest = line.substr(colon + 1);
+    counts.resize((row + 1) * cpus.size(), 0);
+    uint64_t* values = counts.data() + row * cpus.size();
+    for (const int column : columns) {
+      const auto value = utils::consumeNumber<uint64_t>(rest);
+      if (!value) break;
+      if (column >= 0) values[column] = *value;
+    }
+    const std::string_view description = utils::trim(rest);
+    const Source::Kind row_kind =
+        kind == Source::Kind::Softirq || !utils::toNumber<int>(name) ? kind : Source::Kind::Device;
+    if (row >= sources.size()) {
+      sources.emplace_back();
+      changed = true;
+    }
+    Source& source = sources[row];
+    if (source.name != name || source.description != description || source.kind != row_kind) {
+      source.name.assign(name.data(), name.size());
+      source.description.assign(description.data(), description.size());
+      source.kind = row_kind;
+      changed = true;
+    }
+    ++row;
+  }
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+InterruptSampler::~InterruptSampler() {
+  if (_interrupts_fd >= 0) ::close(_interrupts_fd);
+  if (_softirqs_fd >= 0) ::close(_softirqs_fd);
+}
+
+// _____________________________________________________________________________________________________________________
+bool InterruptSampler::read_counters() {
+  HWINFO_PROBE("interrupts.proc");
+  size_t row = 0;
+  bool changed = false;
+  size_t size = 0;
+  const bool have_interrupts = readAll(_interrupts_fd, "/proc/interrupts", _buffer, size);
+  if (have_interrupts) {
+    const std::string_view content(_buffer.data(), size);
+    _cpus = parseHeader(content.substr(0, content.find('\n')));
+    std::fill(_counts.begin(), _counts.end(), 0);
+    parseTable(content, Source::Kind::Architecture, _cpus, _sources, _counts, row, changed);
+  }
+  if (readAll(_softirqs_fd, "/proc/softirqs", _buffer, size)) {
+    const std::string_view content(_buffer.data(), size);
+    if (!have_interrupts) {
+      _cpus = parseHeader(content.substr(0, content.find('\n')));
+      std::fill(_counts.begin(), _counts.end(), 0);
+    }
+    parseTable(content, Source::Kind::Softirq, _cpus, _sources, _counts, row, changed);
+  } else if (!have_interrupts) {
+    return false;
+  }
+  if (row != _sources.size()) {
+    _sources.resize(row);
+    changed = true;
+  }
+  _counts.resize(row * _cpus.size());
+  if (changed) {
+    resolveDevices(_sources);
+  }
+  return true;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
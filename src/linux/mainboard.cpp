@@ -10,17 +10,21 @@
 
 #include "hwinfo/mainboard.h"
 #include "hwinfo/utils/constants.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
 
 namespace hwinfo {
 
 std::string get_dmi_by_name(const std::string& name) {
   std::string value;
-  std::vector<std::string> candidates = {"/sys/devices/virtual/dmi/", "/sys/class/dmi/"};
+  std::vector<std::string> candidates = {filesystem::rooted("/sys/devices/virtual/dmi/"),
+                                         filesystem::rooted("/sys/class/dmi/")};
   for (const auto& path : candidates) {
     std::string full_path(path);
     full_path.append("id/");
     full_path.append(name);
     std::ifstream f(full_path);
+    HWINFO_COUNT_OPEN();
     if (f) {
       getline(f, value);
       if (!value.empty()) {
@@ -33,6 +37,11 @@ std::string get_dmi_by_name(const std::string& name) {
 
 // _____________________________________________________________________________________________________________________
 MainBoard::MainBoard() {
+  HWINFO_PROBE("mainboard.dmi");
+  if (fromSMBIOS()) {
+    return;
+  }
+  // the DMI table is only readable by root, the sysfs id attributes (except the serial) are world readable
   _vendor = get_dmi_by_name("board_vendor");
   _name = get_dmi_by_name("board_name");
   _version = get_dmi_by_name("board_version");
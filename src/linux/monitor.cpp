@@ -1,210 +1,215 @@
 #include "hwinfo/platform.h"
 
 #ifdef HWINFO_UNIX
-#include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <xf86drmMode.h>
 
-#include <cmath>
-#include <fstream>
-#include <iostream>
-#include <optional>
-#include <regex>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "hwinfo/monitor.h"
 #include "hwinfo/utils/constants.h"
+#include "hwinfo/utils/edid.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
 
 constexpr auto EDID_LENGTH = 128;
-
-namespace drm_util {
-class DRMDevice {
- public:
-  explicit DRMDevice(const std::string& path) : fd_(open(path.c_str(), O_RDWR)) {}
-
-  ~DRMDevice() {
-    if (fd_ >= 0) close(fd_);
-  }
-
-  [[nodiscard]] int getFD() const { return fd_; }
-  [[nodiscard]] bool isValid() const { return fd_ >= 0; }
-
- private:
-  int fd_;
-};
-
-// Get all available DRM card devices dynamically
-std::vector<std::string> getAvailableDRICards() {
-  const std::string dri_path = "/dev/dri/";
-  std::vector<std::string> dri_cards;
-
-  if (DIR* dir = opendir(dri_path.c_str())) {
-    const std::regex card_regex("^card[0-9]+$");
-    while (dirent* entry = readdir(dir)) {
-      if (std::regex_match(entry->d_name, card_regex)) {
-        dri_cards.emplace_back(dri_path + entry->d_name);
-      }
-    }
-    closedir(dir);
+// base block plus at most 255 extension blocks
+constexpr auto EDID_MAX_LENGTH = 256 * EDID_LENGTH;
+
+namespace drm_sysfs {
+// @return N of "cardN" or -1 if name is no card node
+int cardNumber(std::string_view name) {
+  if (name.size() <= 4 || name.substr(0, 4) != "card" || name.find_first_not_of("0123456789", 4) != name.npos) {
+    return -1;
   }
-  return dri_cards;
+  return hwinfo::utils::toNumber<int>(name.substr(4)).value_or(-1);
 }
 
-// Read EDID data from a file
-std::optional<std::vector<uint8_t>> readEDID(const std::string& path) {
-  std::ifstream file(path, std::ios::binary);
-  if (!file) return std::nullopt;
-
-  return std::vector<uint8_t>{std::istreambuf_iterator<char>(file), {}};
+// Names of the connector directories in /sys/class/drm (e.g. "card0-HDMI-A-1") per card, ordered by card number
+std::vector<std::vector<std::string>> getConnectorsByCard() {
+  std::map<int, std::vector<std::string>> cards;
+  for (const auto& entry : hwinfo::filesystem::getDirectoryEntries(hwinfo::filesystem::rooted("/sys/class/drm"))) {
+    const size_t dash = entry.find('-');
+    const int number = cardNumber(std::string_view(entry).substr(0, dash));
+    if (number < 0 || dash == std::string::npos) continue;
+    cards[number].push_back(entry);
+  }
+  std::vector<std::vector<std::string>> result;
+  result.reserve(cards.size());
+  for (auto& [number, connectors] : cards) {
+    std::sort(connectors.begin(), connectors.end());
+    result.push_back(std::move(connectors));
+  }
+  return result;
 }
 
-// Extract Vendor from EDID
-std::string getVendorFromEDID(const std::vector<uint8_t>& edid) {
-  if (edid.size() < EDID_LENGTH) return hwinfo::constants::UNKNOWN;
-
-  return {static_cast<char>(((edid[8] >> 2) & 0x1F) + 'A' - 1),
-          static_cast<char>(((edid[8] & 0x03) << 3 | (edid[9] >> 5)) + 'A' - 1),
-          static_cast<char>((edid[9] & 0x1F) + 'A' - 1)};
+// Reads the binary edid attribute of a connector directory. readAttributeAt() is not used, it strips trailing
+// newlines, which are valid EDID bytes.
+std::vector<uint8_t> readEDIDAt(int dir_fd) {
+  std::vector<uint8_t> edid;
+  const int fd = openat(dir_fd, "edid", O_RDONLY | O_CLOEXEC);
+  HWINFO_COUNT_OPEN();
+  if (fd < 0) return edid;
+  edid.resize(EDID_MAX_LENGTH);
+  size_t size = 0;
+  while (size < edid.size()) {
+    const ssize_t n = read(fd, edid.data() + size, edid.size() - size);
+    if (n <= 0) break;
+    HWINFO_COUNT_READ(n);
+    size += static_cast<size_t>(n);
+  }
+  close(fd);
+  edid.resize(size);
+  return edid;
 }
 
-// Extract Model & Serial from EDID
-std::pair<std::string, std::string> getModelAndSerialFromEDID(const std::vector<uint8_t>& edid) {
-  if (edid.size() < EDID_LENGTH) return {hwinfo::constants::UNKNOWN, hwinfo::constants::UNKNOWN};
-
-  std::string model = std::to_string((edid[11] << 8) | edid[10]);
-  std::string serialNumber = std::to_string(edid[12] | (edid[13] << 8) | (edid[14] << 16) | (edid[15] << 24));
-
-  return {model, serialNumber};
-}
+// Attributes of a monitor that only depend on its EDID
+struct EDIDInfo {
+  std::string vendor{hwinfo::constants::UNKNOWN};
+  std::string model{hwinfo::constants::UNKNOWN};
+  std::string serial_number{hwinfo::constants::UNKNOWN};
+  std::string resolution{hwinfo::constants::UNKNOWN};
+  std::string refresh_rate{hwinfo::constants::UNKNOWN};
+};
 
-std::pair<std::string, std::string> getResolutionAndRefreshRateFromEDID(const std::vector<uint8_t>& edid) {
-  if (edid.size() < EDID_LENGTH) {
-    return {hwinfo::constants::UNKNOWN, hwinfo::constants::UNKNOWN};
+// Parses edid, or returns the result of an earlier call with the same bytes. Monitors rarely change, so repeated
+// enumerations (e.g. on every hotplug event) skip the parsing.
+EDIDInfo parseEDID(const std::vector<uint8_t>& edid) {
+  struct Entry {
+    std::vector<uint8_t> edid;
+    EDIDInfo info;
+  };
+  // keyed by the FNV-1a hash of the EDID, an entry is only used if the bytes are equal as well
+  static std::mutex mutex;
+  static std::unordered_map<uint64_t, Entry> cache;
+  static constexpr size_t MAX_CACHE_ENTRIES = 64;
+
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const uint8_t byte : edid) {
+    hash = (hash ^ byte) * 0x100000001b3ull;
   }
-
-  // Read Active Pixels
-  const auto h_active = static_cast<uint16_t>(edid[56] | ((edid[58] & 0xF0) << 4));
-  const auto v_active = static_cast<uint16_t>(edid[59] | ((edid[61] & 0xF0) << 4));
-
-  if (h_active == 0 || v_active == 0) {
-    return {hwinfo::constants::UNKNOWN, hwinfo::constants::UNKNOWN};
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = cache.find(hash);
+    if (it != cache.end() && it->second.edid == edid) {
+      return it->second.info;
+    }
   }
-
-  // Generate Resolution String
-  std::string resolution = std::to_string(h_active) + "x" + std::to_string(v_active);
-
-  // Read Blank Pixels
-  const auto h_blank = static_cast<uint16_t>(edid[57] | ((edid[58] & 0x0F) << 8));
-  const auto v_blank = static_cast<uint16_t>(edid[60] | ((edid[61] & 0x0F) << 8));
-
-  // Read Pixel Clock (in 10 kHz units)
-  const auto pixel_clock = static_cast<uint16_t>(edid[54] | (edid[55] << 8));
-
-  // Check if pixel clock is valid
-  if (pixel_clock == 0) {
-    return {resolution, hwinfo::constants::UNKNOWN};
+  EDIDInfo info;
+  hwinfo::utils::EDID::Info decoded;
+  if (hwinfo::utils::EDID::parse(edid.data(), edid.size(), decoded)) {
+    if (decoded.manufacturer[0] != '\0') info.vendor = decoded.manufacturer;
+    // the monitor name descriptor if present, else the numeric product code
+    info.model = decoded.name[0] != '\0' ? std::string(decoded.name) : std::to_string(decoded.product_code);
+    if (decoded.serial_string[0] != '\0') {
+      info.serial_number = decoded.serial_string;
+    } else if (decoded.serial_number != 0) {
+      info.serial_number = std::to_string(decoded.serial_number);
+    }
+    if (decoded.preferred.valid()) {
+      info.resolution = std::to_string(decoded.preferred.h_active) + "x" + std::to_string(decoded.preferred.v_active);
+      if (const int64_t refresh_rate_mHz = decoded.preferred.refresh_rate_mHz(); refresh_rate_mHz > 0) {
+        info.refresh_rate = std::to_string((refresh_rate_mHz + 500) / 1000);
+      }
+    }
   }
 
-  // Calculate Refresh Rate (in Hz)
-  const double refresh_rate = (pixel_clock * 10000.0) / ((h_active + h_blank) * (v_active + v_blank));
-  std::string refreshRate = std::to_string(static_cast<int>(std::round(refresh_rate)));
-
-  return {resolution, refreshRate};
+  std::lock_guard<std::mutex> lock(mutex);
+  if (cache.size() >= MAX_CACHE_ENTRIES) {
+    cache.clear();
+  }
+  cache[hash] = {edid, info};
+  return info;
 }
 
-// Get Connector Type Name from DRM mode
-std::string getConnectorTypeName(uint32_t type) {
-  switch (type) {
-    case DRM_MODE_CONNECTOR_VGA:
-      return "VGA";
-    case DRM_MODE_CONNECTOR_DVII:
-      return "DVI-I";
-    case DRM_MODE_CONNECTOR_DVID:
-      return "DVI-D";
-    case DRM_MODE_CONNECTOR_DVIA:
-      return "DVI-A";
-    case DRM_MODE_CONNECTOR_Composite:
-      return "Composite";
-    case DRM_MODE_CONNECTOR_SVIDEO:
-      return "S-Video";
-    case DRM_MODE_CONNECTOR_LVDS:
-      return "LVDS";
-    case DRM_MODE_CONNECTOR_Component:
-      return "Component";
-    case DRM_MODE_CONNECTOR_9PinDIN:
-      return "9PinDIN";
-    case DRM_MODE_CONNECTOR_DisplayPort:
-      return "DP";
-    case DRM_MODE_CONNECTOR_HDMIA:
-      return "HDMI-A";
-    case DRM_MODE_CONNECTOR_HDMIB:
-      return "HDMI-B";
-    case DRM_MODE_CONNECTOR_TV:
-      return "TV";
-    case DRM_MODE_CONNECTOR_eDP:
-      return "eDP";
-    case DRM_MODE_CONNECTOR_VIRTUAL:
-      return "Virtual";
-    case DRM_MODE_CONNECTOR_DSI:
-      return "DSI";
-    default:
-      return hwinfo::constants::UNKNOWN;
+// Connected outputs of a card from /sys/class/drm/<connector>/{status,modes,edid}. No DRM ioctl is issued, so no
+// connector is probed: status and modes are what the kernel detected last.
+std::vector<hwinfo::Monitor> readCard(const std::vector<std::string>& connectors) {
+  HWINFO_PROBE("monitor.card");
+  std::vector<hwinfo::Monitor> monitors;
+  const std::string drm_path = hwinfo::filesystem::rooted("/sys/class/drm/");
+  char buffer[4096];
+  for (const auto& connector : connectors) {
+    const int dir_fd = open((drm_path + connector).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    HWINFO_COUNT_OPEN();
+    if (dir_fd < 0) continue;
+    if (hwinfo::filesystem::readAttributeAt(dir_fd, "status", buffer, sizeof(buffer)) < 0 ||
+        std::strcmp(buffer, "connected") != 0) {
+      close(dir_fd);
+      continue;
+    }
+    // one mode per line, the preferred one first
+    std::string_view preferred_mode;
+    if (hwinfo::filesystem::readAttributeAt(dir_fd, "modes", buffer, sizeof(buffer)) > 0) {
+      std::string_view modes(buffer);
+      hwinfo::utils::nextLine(modes, preferred_mode);
+    }
+    const auto edid = readEDIDAt(dir_fd);
+    close(dir_fd);
+    if (edid.empty() && preferred_mode.empty()) continue;
+
+    auto info = parseEDID(edid);
+    if (info.resolution == hwinfo::constants::UNKNOWN && !preferred_mode.empty()) {
+      // modes may carry an interlace suffix, e.g. "1920x1080i"
+      const auto resolution = preferred_mode.substr(0, preferred_mode.find_first_not_of("0123456789x"));
+      info.resolution = std::string(resolution);
+    }
+    monitors.emplace_back(std::move(info.vendor), std::move(info.model), std::move(info.resolution),
+                          std::move(info.refresh_rate), std::move(info.serial_number));
   }
+  return monitors;
 }
 
-}  // namespace drm_util
+}  // namespace drm_sysfs
 
 namespace hwinfo {
 
-// Get all connected monitors
+// _____________________________________________________________________________________________________________________
 std::vector<Monitor> getAllMonitors() {
-  std::vector<Monitor> monitors;
-
-  for (const auto& dri_path : drm_util::getAvailableDRICards()) {
-    drm_util::DRMDevice drmDevice(dri_path);
-    if (!drmDevice.isValid()) continue;
-
-    // Use smart pointer for drmModeRes with custom deleter
-    const std::unique_ptr<drmModeRes, decltype(&drmModeFreeResources)> res(drmModeGetResources(drmDevice.getFD()),
-                                                                           drmModeFreeResources);
-
-    if (!res) continue;
-
-    for (int i = 0; i < res->count_connectors; ++i) {
-      // Use smart pointer for drmModeConnector with custom deleter
-      const std::unique_ptr<drmModeConnector, decltype(&drmModeFreeConnector)> conn(
-          drmModeGetConnector(drmDevice.getFD(), res->connectors[i]), drmModeFreeConnector);
-
-      if (!conn) continue;
-
-      if (conn->connection == DRM_MODE_CONNECTED && conn->count_modes > 0) {
-        std::string connector_name = dri_path.substr(dri_path.find_last_of('/') + 1) + "-" +
-                                     drm_util::getConnectorTypeName(conn->connector_type) + "-" +
-                                     std::to_string(conn->connector_type_id);
-
-        std::string edid_path = "/sys/class/drm/" + connector_name + "/edid";
-        auto edidData = drm_util::readEDID(edid_path);
-
-        std::string vendor = edidData ? drm_util::getVendorFromEDID(*edidData) : constants::UNKNOWN;
-        auto [model, serialNumber] = edidData ? drm_util::getModelAndSerialFromEDID(*edidData)
-                                              : std::make_pair(constants::UNKNOWN, constants::UNKNOWN);
-
-        auto [drmResolution, drmRefreshRate] = drm_util::getResolutionAndRefreshRateFromEDID(*edidData);
-
-        // Determine resolution
-        std::string resolution = (drmResolution == constants::UNKNOWN) ? std::to_string(conn->modes[0].hdisplay) + "x" +
-                                                                             std::to_string(conn->modes[0].vdisplay)
-                                                                       : drmResolution;
-
-        // Determine refresh rate
-        std::string refreshRate =
-            (drmRefreshRate == constants::UNKNOWN) ? std::to_string(conn->modes[0].vrefresh) : drmRefreshRate;
-
-        monitors.emplace_back(vendor, model, resolution, refreshRate, serialNumber);
-      }
+  HWINFO_PROBE("monitor.sysfs");
+  const auto cards = drm_sysfs::getConnectorsByCard();
+
+  // cards are independent, every card but the first is read by a thread of its own. No exception may escape while
+  // workers are joinable, a card that could not be read is reported without monitors.
+  std::vector<std::vector<Monitor>> card_monitors(cards.size());
+  auto read_card = [&](size_t i) noexcept {
+    try {
+      card_monitors[i] = drm_sysfs::readCard(cards[i]);
+    } catch (...) {
     }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(cards.size());
+  for (size_t i = 1; i < cards.size(); ++i) {
+    try {
+      workers.emplace_back(read_card, i);
+    } catch (...) {
+      // no thread could be started (std::system_error, std::bad_alloc), read the card on this thread
+      read_card(i);
+    }
+  }
+  if (!cards.empty()) {
+    read_card(0);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::vector<Monitor> monitors;
+  for (auto& card : card_monitors) {
+    std::move(card.begin(), card.end(), std::back_inserter(monitors));
   }
   return monitors;
 }
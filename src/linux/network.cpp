@@ -1,216 +1,723 @@
 #include "hwinfo/platform.h"
 
 #ifdef HWINFO_UNIX
-#include <arpa/inet.h>
-#include <ifaddrs.h>
+// net/if.h has to come before the linux/ headers, they only skip their own if.h definitions in this order
 #include <net/if.h>
 
+#include <arpa/inet.h>
+#include <linux/if_arp.h>
+#include <linux/genetlink.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
-#include <filesystem>
-#include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "hwinfo/network.h"
 #include "hwinfo/utils/constants.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/sysfs.h"
 
 namespace hwinfo {
 
 namespace {
 
 /**
- * @brief Get a user-friendly description of the interface.
- *        Here it simply returns the interface name itself.
+ * @brief Attributes of one RTM_NEWLINK message.
  */
-std::string getDescription(const std::string& path) { return path; }
+struct LinkInfo {
+  int index{0};
+  unsigned short type{0};
+  std::string name;
+  std::string mac;
+  int mtu{-1};
+  uint8_t oper_state{IF_OPER_UNKNOWN};
+  // IFLA_INFO_KIND of virtual interfaces (e.g. "bridge", "tun", "veth"), empty for physical ones
+  std::string kind;
+  bool has_stats{false};
+  rtnl_link_stats64 stats{};
+};
+
+struct Addresses {
+  std::string ip4;
+  std::vector<std::string> ip6;
+};
 
 /**
- * @brief Returns the interface index as a string, or "<unknown>" if invalid.
+ * @brief Netlink socket (NETLINK_ROUTE or NETLINK_GENERIC) that sends a request and hands every message of the reply to
+ *        a handler.
  */
-std::string getInterfaceIndex(const std::string& iface) {
-  unsigned int index = if_nametoindex(iface.c_str());
-  return (index > 0) ? std::to_string(index) : constants::UNKNOWN;
-}
+class NetlinkSocket {
+ public:
+  explicit NetlinkSocket(int protocol = NETLINK_ROUTE) : _fd(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, protocol)) {
+    HWINFO_COUNT_SYSCALL();
+  }
+  ~NetlinkSocket() {
+    if (_fd >= 0) close(_fd);
+  }
+  NetlinkSocket(const NetlinkSocket&) = delete;
+  NetlinkSocket& operator=(const NetlinkSocket&) = delete;
+
+  bool valid() const { return _fd >= 0; }
+
+  /**
+   * @brief Sends request (a struct starting with nlmsghdr) and calls handler(const nlmsghdr*) for every reply message.
+   * @return false if the request could not be sent or the kernel answered with an error
+   */
+  template <typename Request, typename Handler>
+  bool request(Request& request, Handler&& handler) {
+    request.header.nlmsg_len = sizeof(Request);
+    request.header.nlmsg_seq = ++_seq;
+    HWINFO_COUNT_SYSCALL();
+    if (send(_fd, &request, sizeof(Request), 0) < 0) {
+      return false;
+    }
+    // dump replies are batched into datagrams of up to 32 KiB
+    std::vector<char> buffer(65536);
+    for (;;) {
+      const ssize_t len = recv(_fd, buffer.data(), buffer.size(), 0);
+      HWINFO_COUNT_SYSCALL();
+      HWINFO_COUNT_READ(len);
+      if (len < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      int remaining = static_cast<int>(len);
+      for (auto* header = reinterpret_cast<const nlmsghdr*>(buffer.data()); NLMSG_OK(header, remaining);
+           header = NLMSG_NEXT(header, remaining)) {
+        if (header->nlmsg_seq != _seq) {
+          continue;
+        }
+        if (header->nlmsg_type == NLMSG_DONE) {
+          return true;
+        }
+        if (header->nlmsg_type == NLMSG_ERROR) {
+          return static_cast<const nlmsgerr*>(NLMSG_DATA(header))->error == 0;
+        }
+        handler(header);
+        if (!(header->nlmsg_flags & NLM_F_MULTI)) {
+          return true;
+        }
+      }
+    }
+  }
 
-/**
- * @brief Reads MAC address from sysfs or returns "<unknown>" if unavailable.
- */
-std::string getMac(const std::string& iface) {
-  const std::string path = "/sys/class/net/" + iface + "/address";
-  std::ifstream ifs(path);
-  if (!ifs) {
-    return constants::UNKNOWN;
+ private:
+  int _fd;
+  uint32_t _seq{0};
+};
+
+struct LinkRequest {
+  nlmsghdr header;
+  ifinfomsg info;
+};
+
+struct AddressRequest {
+  nlmsghdr header;
+  ifaddrmsg info;
+};
+
+// ethtool netlink interface of linux/ethtool_netlink.h (kernel 5.6), spelled out because older headers lack it
+constexpr char ethtool_genl_name[] = "ethtool";
+constexpr uint8_t ethtool_genl_version = 1;
+constexpr uint8_t ethtool_msg_features_get = 11;
+constexpr uint8_t ethtool_msg_rings_get = 15;
+constexpr uint8_t ethtool_msg_channels_get = 17;
+// the header nest (attribute 1 of every reply) holds the interface index
+constexpr uint16_t ethtool_a_header = 1;
+constexpr uint16_t ethtool_a_header_dev_index = 1;
+enum : uint16_t {
+  ethtool_a_channels_rx_max = 2,
+  ethtool_a_channels_tx_max = 3,
+  ethtool_a_channels_combined_max = 5,
+  ethtool_a_channels_rx_count = 6,
+  ethtool_a_channels_tx_count = 7,
+  ethtool_a_channels_combined_count = 9,
+};
+enum : uint16_t {
+  ethtool_a_rings_rx_max = 2,
+  ethtool_a_rings_tx_max = 5,
+  ethtool_a_rings_rx = 6,
+  ethtool_a_rings_tx = 9,
+};
+constexpr uint16_t ethtool_a_features_active = 4;
+// verbose bitsets: a nest of bits with index, name and a value flag (only set bits are listed if nomask is present)
+constexpr uint16_t ethtool_a_bitset_nomask = 1;
+constexpr uint16_t ethtool_a_bitset_bits = 3;
+constexpr uint16_t ethtool_a_bitset_bits_bit = 1;
+constexpr uint16_t ethtool_a_bitset_bit_name = 2;
+constexpr uint16_t ethtool_a_bitset_bit_value = 3;
+
+struct FamilyRequest {
+  nlmsghdr header;
+  genlmsghdr genl;
+  nlattr name_attribute;
+  char name[sizeof(ethtool_genl_name)];
+};
+
+struct GenericRequest {
+  nlmsghdr header;
+  genlmsghdr genl;
+};
+
+// calls handler(type, data, length) for every netlink attribute in data, the nested flag is removed from the type
+template <typename Handler>
+void forEachAttribute(const char* data, size_t length, Handler&& handler) {
+  while (length >= NLA_HDRLEN) {
+    nlattr attribute;
+    std::memcpy(&attribute, data, sizeof(attribute));
+    if (attribute.nla_len < NLA_HDRLEN || attribute.nla_len > length) {
+      return;
+    }
+    handler(static_cast<uint16_t>(attribute.nla_type & NLA_TYPE_MASK), data + NLA_HDRLEN,
+            static_cast<size_t>(attribute.nla_len - NLA_HDRLEN));
+    const size_t step = NLA_ALIGN(attribute.nla_len);
+    if (step >= length) {
+      return;
+    }
+    data += step;
+    length -= step;
   }
+}
 
-  std::string mac;
-  std::getline(ifs, mac);
-  return mac.empty() ? constants::UNKNOWN : mac;
+uint32_t attributeU32(const char* data, size_t length) {
+  uint32_t value = 0;
+  if (length >= sizeof(value)) std::memcpy(&value, data, sizeof(value));
+  return value;
 }
 
-/**
- * @brief Generic IP address fetcher (IPv4 or IPv6).
- * @param iface   Interface name (e.g., "eth0").
- * @param family  Address family (AF_INET for IPv4, AF_INET6 for IPv6).
- * @return The first matching IP address as a string, or "<unknown>" if not found.
- */
-std::string getIp(const std::string& iface, int family) {
-  // Use RAII to ensure freeifaddrs is always called.
-  struct ifaddrs* rawAddrs = nullptr;
-  if (getifaddrs(&rawAddrs) == -1) {
+std::string format_mac(const unsigned char* data, size_t length) {
+  if (length == 0) {
     return constants::UNKNOWN;
   }
-  std::unique_ptr<struct ifaddrs, decltype(&freeifaddrs)> ifAddrs(rawAddrs, freeifaddrs);
-
-  for (auto* ifa = rawAddrs; ifa != nullptr; ifa = ifa->ifa_next) {
-    if (!ifa->ifa_addr || iface != ifa->ifa_name) {
-      continue;
-    }
-
-    if (ifa->ifa_addr->sa_family == family) {
-      char buffer[INET6_ADDRSTRLEN] = {0};
+  static constexpr char hex[] = "0123456789abcdef";
+  std::string mac;
+  mac.reserve(length * 3);
+  for (size_t i = 0; i < length; ++i) {
+    if (i > 0) mac.push_back(':');
+    mac.push_back(hex[data[i] >> 4]);
+    mac.push_back(hex[data[i] & 0x0f]);
+  }
+  return mac;
+}
 
-      if (family == AF_INET) {
-        auto* addr = reinterpret_cast<struct sockaddr_in*>(ifa->ifa_addr);
-        if (inet_ntop(AF_INET, &addr->sin_addr, buffer, sizeof(buffer))) {
-          return buffer;
-        }
-      } else if (family == AF_INET6) {
-        auto* addr = reinterpret_cast<struct sockaddr_in6*>(ifa->ifa_addr);
-        if (inet_ntop(AF_INET6, &addr->sin6_addr, buffer, sizeof(buffer))) {
-          // Here we exemplify preferring link-local if found (fe80::).
-          // Adjust logic if you need the first global address, etc.
-          if (std::strncmp(buffer, "fe80", 4) == 0) {
-            return buffer;
+LinkInfo parse_link(const nlmsghdr* header) {
+  LinkInfo link;
+  const auto* info = static_cast<const ifinfomsg*>(NLMSG_DATA(header));
+  link.index = info->ifi_index;
+  link.type = info->ifi_type;
+  int length = static_cast<int>(IFLA_PAYLOAD(header));
+  for (auto* attr = IFLA_RTA(info); RTA_OK(attr, length); attr = RTA_NEXT(attr, length)) {
+    const auto* data = static_cast<const unsigned char*>(RTA_DATA(attr));
+    switch (attr->rta_type) {
+      case IFLA_IFNAME:
+        link.name = reinterpret_cast<const char*>(data);
+        break;
+      case IFLA_ADDRESS:
+        link.mac = format_mac(data, RTA_PAYLOAD(attr));
+        break;
+      case IFLA_MTU:
+        link.mtu = static_cast<int>(*reinterpret_cast<const uint32_t*>(data));
+        break;
+      case IFLA_OPERSTATE:
+        link.oper_state = *data;
+        break;
+      case IFLA_STATS64:
+        // the attribute is only 4 byte aligned
+        std::memcpy(&link.stats, data, std::min<size_t>(sizeof(link.stats), RTA_PAYLOAD(attr)));
+        link.has_stats = true;
+        break;
+      case IFLA_LINKINFO: {
+        int nested_length = static_cast<int>(RTA_PAYLOAD(attr));
+        for (auto* nested = static_cast<const rtattr*>(RTA_DATA(attr)); RTA_OK(nested, nested_length);
+             nested = RTA_NEXT(nested, nested_length)) {
+          if (nested->rta_type == IFLA_INFO_KIND) {
+            link.kind = static_cast<const char*>(RTA_DATA(nested));
           }
-          // If you *only* want link-local, return immediately.
-          // Otherwise, you could store the address and keep searching
-          // in case you prefer global addresses. For now, we return
-          // upon finding link-local.
         }
+        break;
       }
+      default:
+        break;
     }
   }
+  return link;
+}
 
-  return constants::UNKNOWN;
+// Adds the address of an RTM_NEWADDR message to addresses (interface index -> addresses).
+void parse_address(const nlmsghdr* header, std::unordered_map<int, Addresses>& addresses) {
+  const auto* info = static_cast<const ifaddrmsg*>(NLMSG_DATA(header));
+  if (info->ifa_family != AF_INET && info->ifa_family != AF_INET6) {
+    return;
+  }
+  const void* address = nullptr;
+  int length = static_cast<int>(IFA_PAYLOAD(header));
+  for (auto* attr = IFA_RTA(info); RTA_OK(attr, length); attr = RTA_NEXT(attr, length)) {
+    // IFA_LOCAL is the local address of point-to-point links, where IFA_ADDRESS is the peer
+    if (attr->rta_type == IFA_LOCAL || (attr->rta_type == IFA_ADDRESS && address == nullptr)) {
+      address = RTA_DATA(attr);
+    }
+  }
+  char buffer[INET6_ADDRSTRLEN];
+  if (address == nullptr || inet_ntop(info->ifa_family, address, buffer, sizeof(buffer)) == nullptr) {
+    return;
+  }
+  auto& entry = addresses[static_cast<int>(info->ifa_index)];
+  if (info->ifa_family == AF_INET) {
+    if (entry.ip4.empty()) entry.ip4 = buffer;
+  } else {
+    entry.ip6.emplace_back(buffer);
+  }
+}
+
+// One RTM_GETADDR dump for all interfaces.
+std::unordered_map<int, Addresses> dump_addresses(NetlinkSocket& socket) {
+  std::unordered_map<int, Addresses> addresses;
+  AddressRequest request{};
+  request.header.nlmsg_type = RTM_GETADDR;
+  request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  request.info.ifa_family = AF_UNSPEC;
+  socket.request(request, [&](const nlmsghdr* header) {
+    if (header->nlmsg_type == RTM_NEWADDR) parse_address(header, addresses);
+  });
+  return addresses;
 }
 
 /**
- * @brief Helper to retrieve the IPv4 address of an interface.
+ * @brief The address reported by Network::ip6(): the link-local address (fe80::) if there is one, otherwise the first.
  */
-std::string getIp4(const std::string& iface) { return getIp(iface, AF_INET); }
+std::string preferredIp6(const std::vector<std::string>& ip6) {
+  for (const auto& address : ip6) {
+    if (address.compare(0, 4, "fe80") == 0) {
+      return address;
+    }
+  }
+  return ip6.empty() ? constants::UNKNOWN : ip6.front();
+}
+
+std::string operStateName(uint8_t state) {
+  switch (state) {
+    case IF_OPER_NOTPRESENT:
+      return "notpresent";
+    case IF_OPER_DOWN:
+      return "down";
+    case IF_OPER_LOWERLAYERDOWN:
+      return "lowerlayerdown";
+    case IF_OPER_TESTING:
+      return "testing";
+    case IF_OPER_DORMANT:
+      return "dormant";
+    case IF_OPER_UP:
+      return "up";
+    default:
+      return constants::UNKNOWN;
+  }
+}
+
+Network::Statistics toStatistics(const LinkInfo& link) {
+  Network::Statistics statistics;
+  if (link.has_stats) {
+    statistics.rx_bytes = static_cast<int64_t>(link.stats.rx_bytes);
+    statistics.tx_bytes = static_cast<int64_t>(link.stats.tx_bytes);
+    statistics.rx_packets = static_cast<int64_t>(link.stats.rx_packets);
+    statistics.tx_packets = static_cast<int64_t>(link.stats.tx_packets);
+    statistics.rx_errors = static_cast<int64_t>(link.stats.rx_errors);
+    statistics.tx_errors = static_cast<int64_t>(link.stats.tx_errors);
+    statistics.rx_dropped = static_cast<int64_t>(link.stats.rx_dropped);
+    statistics.tx_dropped = static_cast<int64_t>(link.stats.tx_dropped);
+  }
+  return statistics;
+}
+
+std::string speedPath(const std::string& iface) { return filesystem::rooted("/sys/class/net/") + iface + "/speed"; }
 
 /**
- * @brief Helper to retrieve the IPv6 address of an interface.
+ * @brief Link speed in Mbit/s from /sys/class/net/<if>/speed. rtnetlink does not report it, this is the only sysfs read
+ *        of the collector.
  */
-std::string getIp6(const std::string& iface) { return getIp(iface, AF_INET6); }
+int64_t getLinkSpeed_Mbps(filesystem::SysfsReader& speed_reader) {
+  // reading fails with EINVAL while the link is down, virtual interfaces report -1
+  const int64_t speed = speed_reader.readInt();
+  return speed > 0 ? speed : -1;
+}
 
 /**
- * @brief Attempts to determine the interface type:
- *        - WiFi
- *        - Loopback
- *        - USB Ethernet
- *        - Bridge
- *        - TUN/TAP
- *        - Ethernet
+ * @brief Determines the interface type:
+ *        - Loopback (ARPHRD_LOOPBACK)
+ *        - Bridge, TUN/TAP (rtnetlink link kind)
+ *        - WiFi (cfg80211 device)
+ *        - USB Ethernet (device below a USB controller)
+ *        - Ethernet (ARPHRD_ETHER)
  *        - <unknown> otherwise
  */
-std::string getInterfaceType(const std::string& iface) {
-  const std::string sysPath = "/sys/class/net/" + iface;
-
-  // Check for Wi-Fi interface
-  if (std::filesystem::exists(sysPath + "/wireless")) {
+std::string getInterfaceType(const LinkInfo& link) {
+  if (link.type == ARPHRD_LOOPBACK || link.name == "lo") {
+    return "Loopback";
+  }
+  if (link.kind == "bridge") {
+    return "Bridge";
+  }
+  if (link.kind == "tun") {
+    return "TUN/TAP";
+  }
+  if (!link.kind.empty()) {
+    // other virtual interfaces (veth, vlan, bond, ...) have no device below them
+    return link.type == ARPHRD_ETHER ? "Ethernet" : constants::UNKNOWN;
+  }
+  const std::string sys_path = filesystem::rooted("/sys/class/net/") + link.name;
+  if (access((sys_path + "/phy80211").c_str(), F_OK) == 0 || access((sys_path + "/wireless").c_str(), F_OK) == 0) {
     return "WiFi";
   }
-
-  // Check for Loopback
-  {
-    std::ifstream typeFile(sysPath + "/type");
-    int typeVal = 0;
-    if (typeFile.is_open()) {
-      typeFile >> typeVal;
-    }
-    if (typeVal == 772 || iface == "lo") {
-      return "Loopback";
-    }
-    // typeVal == 1 typically means Ethernet, but we check further below.
+  char device_path[PATH_MAX];
+  if (realpath((sys_path + "/device").c_str(), device_path) != nullptr && std::strstr(device_path, "/usb") != nullptr) {
+    return "USB Ethernet";
+  }
+  if (link.type == ARPHRD_ETHER) {
+    return "Ethernet";
   }
+  return constants::UNKNOWN;
+}
 
-  // Check for USB-based Ethernet via module path
-  {
-    std::error_code ec;
-    auto modulePath = std::filesystem::read_symlink(sysPath + "/device/driver/module", ec);
-    if (!ec && modulePath.string().find("usb") != std::string::npos) {
-      return "USB Ethernet";
+// the last PCI function on the sysfs path of a device (virtio NICs have a virtio device below the PCI function)
+std::string pciAddressOf(const std::string& device_link) {
+  char resolved[PATH_MAX];
+  if (realpath(device_link.c_str(), resolved) == nullptr) {
+    return {};
+  }
+  std::string_view path(resolved);
+  std::string_view address;
+  while (!path.empty()) {
+    const size_t slash = path.find('/');
+    const std::string_view component = path.substr(0, slash);
+    path.remove_prefix(slash == std::string_view::npos ? path.size() : slash + 1);
+    // domain:bus:device.function
+    if (component.size() == 12 && component[4] == ':' && component[7] == ':' && component[10] == '.') {
+      address = component;
     }
   }
+  return std::string(address);
+}
 
-  // Check for USB-based via device symlink
-  {
-    std::error_code ec;
-    auto deviceLink = std::filesystem::read_symlink(sysPath + "/device", ec);
-    if (!ec && deviceLink.string().find("usb") != std::string::npos) {
-      return "USB Ethernet";
-    }
+// Resolves the generic netlink family id of ethtool, 0 if the kernel has no ethtool netlink interface.
+uint16_t ethtoolFamily(NetlinkSocket& socket) {
+  FamilyRequest request{};
+  request.header.nlmsg_type = GENL_ID_CTRL;
+  request.header.nlmsg_flags = NLM_F_REQUEST;
+  request.genl.cmd = CTRL_CMD_GETFAMILY;
+  request.genl.version = 1;
+  request.name_attribute.nla_len = static_cast<uint16_t>(NLA_HDRLEN + sizeof(request.name));
+  request.name_attribute.nla_type = CTRL_ATTR_FAMILY_NAME;
+  std::memcpy(request.name, ethtool_genl_name, sizeof(request.name));
+  uint16_t family = 0;
+  socket.request(request, [&](const nlmsghdr* header) {
+    const char* data = static_cast<const char*>(NLMSG_DATA(header)) + GENL_HDRLEN;
+    forEachAttribute(data, header->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN), [&](uint16_t type, const char* value,
+                                                                                size_t length) {
+      if (type == CTRL_ATTR_FAMILY_ID && length >= sizeof(uint16_t)) std::memcpy(&family, value, sizeof(family));
+    });
+  });
+  return family;
+}
+
+/**
+ * Sends one ethtool dump request for all interfaces and calls handler(hardware, type, data, length) for every attribute
+ * of every reply, hardware being the entry of the interface in hardware (by interface index).
+ */
+template <typename Handler>
+void dumpEthtool(NetlinkSocket& socket, uint16_t family, uint8_t command,
+                 std::unordered_map<int, Network::Hardware>& hardware, Handler&& handler) {
+  GenericRequest request{};
+  request.header.nlmsg_type = family;
+  request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  request.genl.cmd = command;
+  request.genl.version = ethtool_genl_version;
+  socket.request(request, [&](const nlmsghdr* header) {
+    if (header->nlmsg_type != family || header->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) return;
+    const char* data = static_cast<const char*>(NLMSG_DATA(header)) + GENL_HDRLEN;
+    const size_t length = header->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    int index = 0;
+    forEachAttribute(data, length, [&](uint16_t type, const char* value, size_t value_length) {
+      if (type != ethtool_a_header) return;
+      forEachAttribute(value, value_length, [&](uint16_t nested, const char* field, size_t field_length) {
+        if (nested == ethtool_a_header_dev_index) index = static_cast<int>(attributeU32(field, field_length));
+      });
+    });
+    if (index <= 0) return;
+    auto& entry = hardware[index];
+    forEachAttribute(data, length, [&](uint16_t type, const char* value, size_t value_length) {
+      handler(entry, type, value, value_length);
+    });
+  });
+}
+
+// names of the bits set in a verbose ethtool bitset
+void parseBitset(const char* data, size_t length, std::vector<std::string>& names) {
+  bool nomask = false;
+  forEachAttribute(data, length, [&](uint16_t type, const char*, size_t) {
+    nomask = nomask || type == ethtool_a_bitset_nomask;
+  });
+  forEachAttribute(data, length, [&](uint16_t type, const char* bits, size_t bits_length) {
+    if (type != ethtool_a_bitset_bits) return;
+    forEachAttribute(bits, bits_length, [&](uint16_t bit_type, const char* bit, size_t bit_length) {
+      if (bit_type != ethtool_a_bitset_bits_bit) return;
+      std::string_view name;
+      bool value = nomask;
+      forEachAttribute(bit, bit_length, [&](uint16_t field, const char* field_data, size_t field_length) {
+        if (field == ethtool_a_bitset_bit_name && field_length > 0) {
+          name = std::string_view(field_data, strnlen(field_data, field_length));
+        } else if (field == ethtool_a_bitset_bit_value) {
+          value = true;
+        }
+      });
+      if (value && !name.empty()) names.emplace_back(name);
+    });
+  });
+}
+
+/**
+ * @brief Channels, rings and active features of all interfaces (by interface index) with one ethtool netlink dump
+ *        each. Interfaces whose driver does not implement a request are left out of its dump.
+ */
+std::unordered_map<int, Network::Hardware> dumpHardware() {
+  HWINFO_PROBE("network.ethtool");
+  std::unordered_map<int, Network::Hardware> hardware;
+  NetlinkSocket socket(NETLINK_GENERIC);
+  const uint16_t family = socket.valid() ? ethtoolFamily(socket) : 0;
+  if (family == 0) {
+    return hardware;
   }
+  dumpEthtool(socket, family, ethtool_msg_channels_get, hardware,
+              [](Network::Hardware& entry, uint16_t type, const char* data, size_t length) {
+                const int value = static_cast<int>(attributeU32(data, length));
+                switch (type) {
+                  case ethtool_a_channels_rx_max:
+                    entry.max_rx_channels = value;
+                    break;
+                  case ethtool_a_channels_tx_max:
+                    entry.max_tx_channels = value;
+                    break;
+                  case ethtool_a_channels_combined_max:
+                    entry.max_combined_channels = value;
+                    break;
+                  case ethtool_a_channels_rx_count:
+                    entry.rx_channels = value;
+                    break;
+                  case ethtool_a_channels_tx_count:
+                    entry.tx_channels = value;
+                    break;
+                  case ethtool_a_channels_combined_count:
+                    entry.combined_channels = value;
+                    break;
+                  default:
+                    break;
+                }
+              });
+  dumpEthtool(socket, family, ethtool_msg_rings_get, hardware,
+              [](Network::Hardware& entry, uint16_t type, const char* data, size_t length) {
+                const int64_t value = attributeU32(data, length);
+                switch (type) {
+                  case ethtool_a_rings_rx_max:
+                    entry.max_rx_ring_size = value;
+                    break;
+                  case ethtool_a_rings_tx_max:
+                    entry.max_tx_ring_size = value;
+                    break;
+                  case ethtool_a_rings_rx:
+                    entry.rx_ring_size = value;
+                    break;
+                  case ethtool_a_rings_tx:
+                    entry.tx_ring_size = value;
+                    break;
+                  default:
+                    break;
+                }
+              });
+  dumpEthtool(socket, family, ethtool_msg_features_get, hardware,
+              [](Network::Hardware& entry, uint16_t type, const char* data, size_t length) {
+                if (type == ethtool_a_features_active) parseBitset(data, length, entry.features);
+              });
+  return hardware;
+}
 
-  // Check for Bridge Interface
-  if (std::filesystem::exists(sysPath + "/bridge")) {
-    return "Bridge";
+/**
+ * @brief Adds the sysfs attributes of the device below an interface: driver, PCI address, NUMA node (of the PCI
+ *        function, virtio devices have none) and the number of RX and TX queues.
+ */
+void readDeviceAttributes(const std::string& iface, Network::Hardware& hardware) {
+  const std::string sys_path = filesystem::rooted("/sys/class/net/") + iface;
+  char buffer[PATH_MAX];
+  const ssize_t length = readlink((sys_path + "/device/driver").c_str(), buffer, sizeof(buffer) - 1);
+  if (length > 0) {
+    buffer[length] = '\0';
+    const char* slash = std::strrchr(buffer, '/');
+    hardware.driver = slash != nullptr ? slash + 1 : buffer;
   }
+  hardware.pci_address = pciAddressOf(sys_path + "/device");
+  const std::string numa_path = hardware.pci_address.empty()
+                                    ? sys_path + "/device/numa_node"
+                                    : filesystem::rooted("/sys/bus/pci/devices/") + hardware.pci_address + "/numa_node";
+  const int64_t numa_node = filesystem::SysfsReader(numa_path).readInt();
+  hardware.numa_node = numa_node >= 0 ? static_cast<int>(numa_node) : -1;
+  int rx_queues = 0;
+  int tx_queues = 0;
+  for (const auto& queue : filesystem::getDirectoryEntries(sys_path + "/queues")) {
+    if (queue.compare(0, 3, "rx-") == 0) rx_queues++;
+    if (queue.compare(0, 3, "tx-") == 0) tx_queues++;
+  }
+  if (rx_queues + tx_queues > 0) {
+    hardware.rx_queues = rx_queues;
+    hardware.tx_queues = tx_queues;
+  }
+}
 
-  // Check for TUN/TAP
-  if (std::filesystem::exists(sysPath + "/tun_flags")) {
-    return "TUN/TAP";
+}  // namespace
+
+/**
+ * @brief What refresh() keeps open between calls: one rtnetlink socket, the speed attribute and the interface index.
+ *        Copies of a Network share it, the mutex serializes their requests on the socket.
+ */
+struct Network::RefreshState {
+  explicit RefreshState(const std::string& iface) : speed(speedPath(iface)) {}
+
+  std::mutex mutex;
+  NetlinkSocket socket;
+  filesystem::SysfsReader speed;
+  int index{0};
+};
+
+// _____________________________________________________________________________________________________________________
+bool Network::refresh(NetworkFields fields) {
+  HWINFO_PROBE("network.refresh");
+  if (_interface.empty()) {
+    return false;
+  }
+  if (!_refresh_state) {
+    _refresh_state = std::make_shared<RefreshState>(_interface);
+  }
+  RefreshState& state = *_refresh_state;
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (!state.socket.valid()) {
+    return false;
+  }
+  // one RTM_GETLINK by index; the index is resolved again if the interface was recreated or renamed
+  const auto get_link = [&] {
+    LinkRequest request{};
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.info.ifi_family = AF_UNSPEC;
+    request.info.ifi_index = state.index;
+    bool found = false;
+    state.socket.request(request, [&](const nlmsghdr* header) {
+      if (header->nlmsg_type != RTM_NEWLINK) return;
+      const LinkInfo link = parse_link(header);
+      if (link.name != _interface) return;
+      if (has_field(fields, NetworkFields::Statistics)) _statistics = toStatistics(link);
+      if (has_field(fields, NetworkFields::Link)) {
+        _mtu = link.mtu;
+        _oper_state = operStateName(link.oper_state);
+      }
+      found = true;
+    });
+    return found;
+  };
+  if (state.index == 0 || !get_link()) {
+    state.index = static_cast<int>(if_nametoindex(_interface.c_str()));
+    if (state.index == 0 || !get_link()) {
+      state.index = 0;
+      return false;
+    }
+  }
+  if (has_field(fields, NetworkFields::Link)) {
+    _link_speed_Mbps = getLinkSpeed_Mbps(state.speed);
   }
 
-  // If none of the above checks matched, try reading "type" again:
-  {
-    std::ifstream typeFile(sysPath + "/type");
-    int typeVal = 0;
-    if (typeFile.is_open()) {
-      typeFile >> typeVal;
+  if (has_field(fields, NetworkFields::IP4 | NetworkFields::IP6)) {
+    // RTM_GETADDR cannot be filtered by interface in all kernels, this dumps the addresses of every interface
+    const auto addresses = dump_addresses(state.socket);
+    const auto it = addresses.find(state.index);
+    if (has_field(fields, NetworkFields::IP4)) {
+      _ip4 = (it != addresses.end() && !it->second.ip4.empty()) ? it->second.ip4 : constants::UNKNOWN;
     }
-    // 1 often represents a standard Ethernet interface.
-    if (typeVal == 1) {
-      return "Ethernet";
+    if (has_field(fields, NetworkFields::IP6)) {
+      _ip6_addresses = it != addresses.end() ? it->second.ip6 : std::vector<std::string>{};
+      _ip6 = preferredIp6(_ip6_addresses);
     }
   }
-
-  return constants::UNKNOWN;
+  return true;
 }
 
-}  // namespace
-
 /**
- * @brief Collect all network interfaces with their info (index, MAC, IP, etc.).
+ * @brief Collect all network interfaces with their info (index, MAC, IP, statistics, etc.) from one RTM_GETLINK and
+ *        one RTM_GETADDR dump, plus one ethtool dump each for channels, rings and features if Hardware is requested.
  */
-std::vector<Network> getAllNetworks() {
+std::vector<Network> getAllNetworks(NetworkFields fields) {
+  HWINFO_PROBE("network.rtnetlink");
   std::vector<Network> networks;
+  NetlinkSocket socket;
+  if (!socket.valid()) {
+    return networks;
+  }
 
-  // Use RAII to ensure freeifaddrs is always called.
-  ifaddrs* rawAddrs = nullptr;
-  if (getifaddrs(&rawAddrs) == -1) {
-    perror("getifaddrs");
+  LinkRequest request{};
+  request.header.nlmsg_type = RTM_GETLINK;
+  request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  request.info.ifi_family = AF_UNSPEC;
+  std::vector<LinkInfo> links;
+  if (!socket.request(request, [&](const nlmsghdr* header) {
+        if (header->nlmsg_type == RTM_NEWLINK) links.push_back(parse_link(header));
+      })) {
     return networks;
   }
-  std::unique_ptr<struct ifaddrs, decltype(&freeifaddrs)> ifAddrs(rawAddrs, freeifaddrs);
 
-  // Loop over all interfaces
-  for (auto* ifa = rawAddrs; ifa != nullptr; ifa = ifa->ifa_next) {
-    // We only care about AF_PACKET for physical interfaces (MAC-based).
-    if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_PACKET) {
-      continue;
-    }
+  const bool need_addresses = has_field(fields, NetworkFields::IP4 | NetworkFields::IP6);
+  const auto addresses = need_addresses ? dump_addresses(socket) : std::unordered_map<int, Addresses>{};
+  auto hardware = has_field(fields, NetworkFields::Hardware) ? dumpHardware()
+                                                             : std::unordered_map<int, Network::Hardware>{};
 
-    const std::string interfaceName = ifa->ifa_name;
+  networks.reserve(links.size());
+  for (const auto& link : links) {
     Network network;
-    network._index = getInterfaceIndex(interfaceName);
-    network._description = getDescription(interfaceName);
-    network._mac = getMac(interfaceName);
-    network._ip4 = getIp4(interfaceName);
-    network._ip6 = getIp6(interfaceName);
-    network._type = getInterfaceType(interfaceName);
-
+    network._interface = link.name;
+    if (has_field(fields, NetworkFields::Index)) network._index = std::to_string(link.index);
+    // the description simply is the interface name
+    if (has_field(fields, NetworkFields::Description)) network._description = link.name;
+    if (has_field(fields, NetworkFields::Mac)) network._mac = link.mac.empty() ? constants::UNKNOWN : link.mac;
+    if (need_addresses) {
+      const auto it = addresses.find(link.index);
+      if (has_field(fields, NetworkFields::IP4)) {
+        network._ip4 = (it != addresses.end() && !it->second.ip4.empty()) ? it->second.ip4 : constants::UNKNOWN;
+      }
+      if (has_field(fields, NetworkFields::IP6)) {
+        network._ip6_addresses = it != addresses.end() ? it->second.ip6 : std::vector<std::string>{};
+        network._ip6 = preferredIp6(network._ip6_addresses);
+      }
+    }
+    if (has_field(fields, NetworkFields::Type)) network._type = getInterfaceType(link);
+    if (has_field(fields, NetworkFields::Statistics)) network._statistics = toStatistics(link);
+    if (has_field(fields, NetworkFields::Link)) {
+      network._mtu = link.mtu;
+      network._oper_state = operStateName(link.oper_state);
+      filesystem::SysfsReader speed_reader(speedPath(link.name));
+      network._link_speed_Mbps = getLinkSpeed_Mbps(speed_reader);
+    }
+    if (has_field(fields, NetworkFields::Hardware)) {
+      const auto it = hardware.find(link.index);
+      if (it != hardware.end()) network._hardware = std::move(it->second);
+      readDeviceAttributes(link.name, network._hardware);
+    }
     networks.push_back(std::move(network));
   }
 
@@ -0,0 +1,182 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <fcntl.h>
+#include <linux/nvme_ioctl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hwinfo/nvme.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
+
+namespace hwinfo {
+
+namespace {
+
+constexpr uint8_t admin_get_log_page = 0x02;
+constexpr uint8_t admin_identify = 0x06;
+constexpr uint32_t identify_namespace = 0x00;
+constexpr uint32_t identify_controller = 0x01;
+constexpr uint32_t log_health = 0x02;
+constexpr uint32_t all_namespaces = 0xffffffff;
+constexpr uint32_t identify_size = 4096;
+constexpr uint32_t health_size = 512;
+
+// one admin command reading size bytes into data, the kernel maps the buffer for the transfer
+bool adminCommand(int fd, uint8_t opcode, uint32_t nsid, uint32_t cdw10, void* data, uint32_t size) {
+  nvme_admin_cmd command;
+  std::memset(&command, 0, sizeof(command));
+  command.opcode = opcode;
+  command.nsid = nsid;
+  command.addr = reinterpret_cast<uintptr_t>(data);
+  command.data_len = size;
+  command.cdw10 = cdw10;
+  HWINFO_COUNT_SYSCALL();
+  // the ioctl returns the NVMe status, which is positive if the controller rejected the command
+  return ioctl(fd, NVME_IOCTL_ADMIN_CMD, &command) == 0;
+}
+
+bool readHealthLog(int fd, uint8_t* data) {
+  // number of dwords minus one in bits 27:16, the log page in bits 7:0
+  const uint32_t cdw10 = ((health_size / 4 - 1) << 16) | log_health;
+  return adminCommand(fd, admin_get_log_page, all_namespaces, cdw10, data, health_size);
+}
+
+std::string readAttribute(int dir_fd, const char* name) {
+  char buffer[256];
+  if (filesystem::readAttributeAt(dir_fd, name, buffer, sizeof(buffer)) <= 0) {
+    return {};
+  }
+  return std::string(utils::trim(buffer));
+}
+
+// namespace id of a block device directory of the controller, e.g. "nvme0n1" or "nvme0c0n1" with native multipath
+uint32_t namespaceId(int ns_fd, std::string_view device) {
+  const int64_t nsid = filesystem::readIntAttributeAt(ns_fd, "nsid", 10);
+  if (nsid > 0) {
+    return static_cast<uint32_t>(nsid);
+  }
+  const size_t n = device.rfind('n');
+  std::string_view digits = device.substr(n + 1);
+  return utils::consumeNumber<uint32_t>(digits).value_or(0);
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+bool NvmeController::readHealth(Health& health) const {
+  HWINFO_PROBE("nvme.health");
+  HWINFO_COUNT_OPEN();
+  const int fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  alignas(8) uint8_t data[health_size];
+  const bool ok = readHealthLog(fd, data);
+  ::close(fd);
+  if (ok) {
+    health = parseHealth(data);
+  }
+  return ok;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<NvmeController> getAllNvmeControllers() {
+  HWINFO_PROBE("nvme.sysfs");
+  std::vector<NvmeController> controllers;
+  const std::string base_path = filesystem::rooted("/sys/class/nvme/");
+  std::vector<uint8_t> identify(identify_size);
+  alignas(8) uint8_t health[health_size];
+
+  for (const auto& entry : filesystem::getDirectoryEntries(base_path)) {
+    if (entry.compare(0, 4, "nvme") != 0) {
+      continue;
+    }
+    HWINFO_COUNT_OPEN();
+    const int dir_fd = ::open((base_path + entry).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+      continue;
+    }
+    NvmeController controller;
+    controller._name = entry;
+    controller._path = filesystem::rooted("/dev/" + entry);
+    // the identity sysfs keeps from the kernel's own Identify, used if the admin commands are not permitted
+    controller._model = readAttribute(dir_fd, "model");
+    controller._serialNumber = readAttribute(dir_fd, "serial");
+    controller._firmware = readAttribute(dir_fd, "firmware_rev");
+    controller._controller_id = static_cast<int>(filesystem::readIntAttributeAt(dir_fd, "cntlid", 10));
+    // fabrics controllers (TCP, RDMA, loop) have no PCI device
+    controller._vendor_id = static_cast<uint16_t>(filesystem::readIntAttributeAt(dir_fd, "device/vendor", 16, 0));
+    controller._subsystem_vendor_id =
+        static_cast<uint16_t>(filesystem::readIntAttributeAt(dir_fd, "device/subsystem_vendor", 16, 0));
+
+    HWINFO_COUNT_OPEN();
+    const int fd = ::open(controller._path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0 && adminCommand(fd, admin_identify, 0, identify_controller, identify.data(), identify_size)) {
+      controller.parseIdentifyController(identify.data());
+    }
+
+    // the namespaces are the block devices below the controller directory
+    for (const auto& name : filesystem::getDirectoryEntries(base_path + entry)) {
+      if (name.compare(0, entry.size(), entry) != 0 || name.find('n', entry.size()) == std::string::npos) {
+        continue;
+      }
+      HWINFO_COUNT_OPEN();
+      const int ns_fd = ::openat(dir_fd, name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (ns_fd < 0) {
+        continue;
+      }
+      const uint32_t nsid = namespaceId(ns_fd, name);
+      NvmeController::Namespace ns;
+      if (fd >= 0 && nsid != 0 &&
+          adminCommand(fd, admin_identify, nsid, identify_namespace, identify.data(), identify_size)) {
+        ns = NvmeController::parseIdentifyNamespace(identify.data());
+      } else {
+        // sysfs counts 512 byte sectors
+        const int64_t sectors = filesystem::readIntAttributeAt(ns_fd, "size", 10);
+        ns.size_Bytes = sectors >= 0 ? sectors * 512 : -1;
+        ns.block_size_Bytes = filesystem::readIntAttributeAt(ns_fd, "queue/logical_block_size", 10);
+      }
+      ns.id = nsid;
+      ns.device = name;
+      controller._namespaces.push_back(std::move(ns));
+      ::close(ns_fd);
+    }
+    std::sort(controller._namespaces.begin(), controller._namespaces.end(),
+              [](const NvmeController::Namespace& a, const NvmeController::Namespace& b) { return a.id < b.id; });
+
+    if (fd >= 0) {
+      if (readHealthLog(fd, health)) {
+        controller._health = NvmeController::parseHealth(health);
+      }
+      ::close(fd);
+    }
+    ::close(dir_fd);
+    controllers.push_back(std::move(controller));
+  }
+
+  // nvme10 after nvme9
+  std::sort(controllers.begin(), controllers.end(), [](const NvmeController& a, const NvmeController& b) {
+    return a.name().size() != b.name().size() ? a.name().size() < b.name().size() : a.name() < b.name();
+  });
+  return controllers;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
@@ -13,15 +13,18 @@
 
 #include "hwinfo/os.h"
 #include "hwinfo/utils/constants.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
 #include "hwinfo/utils/stringutils.h"
 
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
 OS::OS() {
+  HWINFO_PROBE("os.release");
   {  // name and version
     std::string line;
-    std::ifstream stream("/etc/os-release");
+    std::ifstream stream(filesystem::rooted("/etc/os-release"));
     if (!stream) {
       _name = "Linux";
       _version = constants::UNKNOWN;
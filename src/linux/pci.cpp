@@ -0,0 +1,87 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "hwinfo/pci.h"
+#include "hwinfo/utils/PCIMapper.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/sysfs.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+std::vector<PCIBusDevice> getAllPCIDevices() {
+  HWINFO_PROBE("pci.sysfs");
+  std::vector<PCIBusDevice> devices;
+  DIR* bus_dir = opendir(filesystem::rooted("/sys/bus/pci/devices").c_str());
+  if (bus_dir == nullptr) {
+    return devices;
+  }
+  const int bus_fd = dirfd(bus_dir);
+  char buffer[256];
+  while (const dirent* entry = readdir(bus_dir)) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    // the entries are symlinks into /sys/devices, openat follows them
+    const int dev_fd = openat(bus_fd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dev_fd < 0) {
+      continue;
+    }
+    PCIBusDevice device;
+    device._address = entry->d_name;
+    device._vendor_id = static_cast<uint16_t>(filesystem::readIntAttributeAt(dev_fd, "vendor", 16, 0));
+    device._device_id = static_cast<uint16_t>(filesystem::readIntAttributeAt(dev_fd, "device", 16, 0));
+    device._subvendor_id = static_cast<uint16_t>(filesystem::readIntAttributeAt(dev_fd, "subsystem_vendor", 16, 0));
+    device._subdevice_id = static_cast<uint16_t>(filesystem::readIntAttributeAt(dev_fd, "subsystem_device", 16, 0));
+    device._class_code = static_cast<uint32_t>(filesystem::readIntAttributeAt(dev_fd, "class", 16, 0));
+    device._numa_node = static_cast<int>(filesystem::readIntAttributeAt(dev_fd, "numa_node", 10, -1));
+    device._link_width = static_cast<int>(filesystem::readIntAttributeAt(dev_fd, "current_link_width", 10, -1));
+    if (filesystem::readAttributeAt(dev_fd, "current_link_speed", buffer, sizeof(buffer)) > 0) {
+      device._link_speed = buffer;
+    }
+    // driver is a symlink to /sys/bus/pci/drivers/<name>
+    const ssize_t len = readlinkat(dev_fd, "driver", buffer, sizeof(buffer) - 1);
+    if (len > 0) {
+      buffer[len] = '\0';
+      const char* slash = std::strrchr(buffer, '/');
+      device._driver = slash != nullptr ? slash + 1 : buffer;
+    }
+    close(dev_fd);
+    devices.push_back(std::move(device));
+  }
+  closedir(bus_dir);
+
+  std::sort(devices.begin(), devices.end(),
+            [](const PCIBusDevice& a, const PCIBusDevice& b) { return a._address < b._address; });
+
+  std::vector<PCIId> ids;
+  ids.reserve(devices.size());
+  for (const auto& device : devices) {
+    ids.push_back({device._vendor_id, device._device_id, device._subvendor_id, device._subdevice_id});
+  }
+  const auto names = PCI::getMapper().resolve(ids);
+  for (size_t i = 0; i < devices.size(); ++i) {
+    devices[i]._vendor = names[i].vendor.vendor_name;
+    devices[i]._name = names[i].device.device_name;
+    devices[i]._subsystem = names[i].subsystem.subsystem_name;
+  }
+  return devices;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
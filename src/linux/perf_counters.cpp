@@ -0,0 +1,195 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hwinfo/perf_counters.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/stringutils.h"
+
+namespace hwinfo {
+
+namespace {
+
+constexpr size_t num_events = 5;
+
+// in the order of PerfCounterSampler::Counters, the first event leads the group
+constexpr uint64_t events[num_events] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    // "usually last level cache misses" (perf_event_open(2)), a generic event every PMU driver maps
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    // not supported by most Intel cores, reported as -1 there
+    PERF_COUNT_HW_STALLED_CYCLES_BACKEND,
+};
+
+int openEvent(uint64_t config, int cpu, int group_fd, bool exclude_kernel) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.exclude_kernel = exclude_kernel ? 1 : 0;
+  attr.exclude_hv = exclude_kernel ? 1 : 0;
+  HWINFO_COUNT_OPEN();
+  // all tasks (pid -1) on one CPU
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, -1, cpu, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+// online CPUs from a list like "0-3,8", these are the live CPUs the events are opened on
+std::vector<int> onlineCpus() {
+  char buffer[4096];
+  HWINFO_COUNT_OPEN();
+  const int fd = ::open("/sys/devices/system/cpu/online", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return {};
+  }
+  const ssize_t size = ::read(fd, buffer, sizeof(buffer) - 1);
+  ::close(fd);
+  if (size <= 0) {
+    return {};
+  }
+  return utils::parseCpuList(std::string_view(buffer, static_cast<size_t>(size)));
+}
+
+std::string openError(int error) {
+  if (error == EACCES || error == EPERM) {
+    std::string paranoid;
+    char buffer[32];
+    HWINFO_COUNT_OPEN();
+    const int fd = ::open("/proc/sys/kernel/perf_event_paranoid", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      const ssize_t size = ::read(fd, buffer, sizeof(buffer));
+      ::close(fd);
+      if (size > 0) paranoid = utils::trim(std::string_view(buffer, static_cast<size_t>(size)));
+    }
+    if (paranoid.empty()) {
+      return "permission denied for CPU-wide counters (requires CAP_PERFMON)";
+    }
+    return "perf_event_paranoid is " + paranoid + " (CPU-wide counters require <= 0 or CAP_PERFMON)";
+  }
+  if (error == ENOENT || error == EOPNOTSUPP || error == ENODEV) {
+    return "no hardware counters (no PMU or a virtual machine without a virtual PMU)";
+  }
+  if (error == ENOSYS) {
+    return "perf_event_open() is not supported by the kernel";
+  }
+  return std::string("perf_event_open() failed: ") + std::strerror(error);
+}
+
+}  // namespace
+
+struct PerfCounterSampler::Backend {
+  struct Group {
+    int cpu{-1};
+    // fds[0] is the leader
+    std::vector<int> fds;
+    // position of each event in the values read from the group, -1 if it could not be opened
+    int slot[num_events]{-1, -1, -1, -1, -1};
+  };
+
+  std::vector<Group> groups;
+  // nr, time enabled, time running and one value per event
+  uint64_t buffer[3 + num_events];
+};
+
+// _____________________________________________________________________________________________________________________
+void PerfCounterSampler::BackendDeleter::operator()(Backend* backend) const {
+  for (const auto& group : backend->groups) {
+    for (const int fd : group.fds) {
+      ::close(fd);
+    }
+  }
+  delete backend;
+}
+
+// _____________________________________________________________________________________________________________________
+PerfCounterSampler::Backend* PerfCounterSampler::open_backend(std::string& error) {
+  HWINFO_PROBE("perf.open");
+  std::unique_ptr<Backend, BackendDeleter> backend(new Backend);
+  // some hypervisors and hardened kernels only allow user space counting, fall back once for all CPUs
+  bool exclude_kernel = false;
+  int leader_error = 0;
+  for (const int cpu : onlineCpus()) {
+    Backend::Group group;
+    group.cpu = cpu;
+    int leader = openEvent(events[0], cpu, -1, exclude_kernel);
+    if (leader < 0 && (errno == EACCES || errno == EPERM) && !exclude_kernel) {
+      exclude_kernel = true;
+      leader = openEvent(events[0], cpu, -1, exclude_kernel);
+    }
+    if (leader < 0) {
+      leader_error = errno;
+      // the same reason applies to every CPU, except for CPUs going offline meanwhile
+      if (leader_error != ENODEV && leader_error != ENXIO) break;
+      continue;
+    }
+    group.fds.push_back(leader);
+    group.slot[0] = 0;
+    for (size_t event = 1; event < num_events; ++event) {
+      const int fd = openEvent(events[event], cpu, leader, exclude_kernel);
+      if (fd >= 0) {
+        group.slot[event] = static_cast<int>(group.fds.size());
+        group.fds.push_back(fd);
+      }
+    }
+    backend->groups.push_back(std::move(group));
+  }
+  if (backend->groups.empty()) {
+    error = openError(leader_error != 0 ? leader_error : ENODEV);
+    return nullptr;
+  }
+  return backend.release();
+}
+
+// _____________________________________________________________________________________________________________________
+bool PerfCounterSampler::read_counters(Backend& backend, std::vector<int>& cpus, std::vector<Reading>& readings) {
+  HWINFO_PROBE("perf.read");
+  cpus.resize(backend.groups.size());
+  readings.resize(backend.groups.size());
+  bool any = false;
+  for (size_t i = 0; i < backend.groups.size(); ++i) {
+    const auto& group = backend.groups[i];
+    Reading& reading = readings[i];
+    reading = Reading{};
+    cpus[i] = group.cpu;
+    const ssize_t size = ::read(group.fds[0], backend.buffer, sizeof(backend.buffer));
+    if (size < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+      continue;
+    }
+    HWINFO_COUNT_READ(size);
+    const uint64_t count = backend.buffer[0];
+    reading.enabled_ns = backend.buffer[1];
+    reading.running_ns = backend.buffer[2];
+    for (size_t event = 0; event < num_events; ++event) {
+      const int slot = group.slot[event];
+      if (slot >= 0 && static_cast<uint64_t>(slot) < count) {
+        reading.values[event] = static_cast<int64_t>(backend.buffer[3 + slot]);
+      }
+    }
+    any = true;
+  }
+  return any;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
@@ -0,0 +1,229 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hwinfo/process.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/stringutils.h"
+
+namespace hwinfo {
+
+namespace {
+
+int64_t tickNs() {
+  static const int64_t tick_ns = 1000000000 / std::max<long>(sysconf(_SC_CLK_TCK), 1);
+  return tick_ns;
+}
+
+int64_t pageSize() {
+  static const int64_t page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+// the file is short (stat, status), one pread at offset 0 returns all of it
+std::string_view preadAll(int fd, char* buffer, size_t size) {
+  ssize_t n;
+  do {
+    n = ::pread(fd, buffer, size, 0);
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0) {
+    return {};
+  }
+  HWINFO_COUNT_READ(n);
+  return {buffer, static_cast<size_t>(n)};
+}
+
+/**
+ * Parses /proc/<pid>/stat or /proc/<pid>/task/<tid>/stat (see proc(5)). The command name is enclosed in parentheses
+ * and may contain spaces and parentheses itself, the other fields follow after the last ')'.
+ */
+bool parseStat(std::string_view content, ProcessStats& stats) {
+  const size_t open = content.find('(');
+  const size_t close = content.rfind(')');
+  if (open == std::string_view::npos || close == std::string_view::npos || close < open) {
+    return false;
+  }
+  stats.id = utils::toNumber<int64_t>(content.substr(0, open)).value_or(-1);
+  stats.name = std::string(content.substr(open + 1, close - open - 1));
+  utils::Tokenizer fields(content.substr(close + 1));
+  std::string_view field;
+  // field 3 (state) is the first one after the name
+  for (int index = 3; index <= 39 && fields.next(field); ++index) {
+    const int64_t value = utils::toNumber<int64_t>(field).value_or(-1);
+    switch (index) {
+      case 10:
+        stats.minor_faults = value;
+        break;
+      case 12:
+        stats.major_faults = value;
+        break;
+      case 14:
+        stats.user_time_ns = value < 0 ? -1 : value * tickNs();
+        break;
+      case 15:
+        stats.system_time_ns = value < 0 ? -1 : value * tickNs();
+        break;
+      case 20:
+        stats.num_threads = value;
+        break;
+      case 23:
+        stats.virtual_Bytes = value;
+        break;
+      case 24:
+        stats.rss_Bytes = value < 0 ? -1 : value * pageSize();
+        break;
+      case 39:
+        stats.cpu = static_cast<int>(value);
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+// the context switch counters of /proc/<pid>/task/<tid>/status
+void parseStatus(std::string_view content, ProcessStats& stats) {
+  std::string_view line;
+  while (utils::nextLine(content, line)) {
+    if (utils::consumePrefix(line, "voluntary_ctxt_switches:")) {
+      stats.voluntary_context_switches = utils::toNumber<int64_t>(line).value_or(-1);
+    } else if (utils::consumePrefix(line, "nonvoluntary_ctxt_switches:")) {
+      stats.involuntary_context_switches = utils::toNumber<int64_t>(line).value_or(-1);
+    }
+  }
+}
+
+int openAt(int dir_fd, const std::string& path) {
+  HWINFO_COUNT_OPEN();
+  return ::openat(dir_fd, path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+}  // namespace
+
+// /proc/self is the calling process, it is not taken from filesystem::root()
+struct ProcessSampler::Backend {
+  struct ThreadFiles {
+    int stat_fd{-1};
+    int status_fd{-1};
+    bool seen{false};
+  };
+
+  int stat_fd{-1};
+  DIR* tasks{nullptr};
+  std::unordered_map<int64_t, ThreadFiles> threads;
+};
+
+// _____________________________________________________________________________________________________________________
+void ProcessSampler::BackendDeleter::operator()(Backend* backend) const {
+  if (backend->stat_fd >= 0) ::close(backend->stat_fd);
+  if (backend->tasks) closedir(backend->tasks);
+  for (const auto& entry : backend->threads) {
+    if (entry.second.stat_fd >= 0) ::close(entry.second.stat_fd);
+    if (entry.second.status_fd >= 0) ::close(entry.second.status_fd);
+  }
+  delete backend;
+}
+
+// _____________________________________________________________________________________________________________________
+ProcessSampler::Backend* ProcessSampler::open_backend() {
+  auto* backend = new Backend;
+  HWINFO_COUNT_OPEN();
+  backend->stat_fd = ::open("/proc/self/stat", O_RDONLY | O_CLOEXEC);
+  return backend;
+}
+
+// _____________________________________________________________________________________________________________________
+bool ProcessSampler::read_counters(Backend& backend, ProcessStats& process, std::vector<ProcessStats>* threads) {
+  HWINFO_PROBE("process.self");
+  char buffer[4096];
+  bool read = false;
+  if (backend.stat_fd >= 0) {
+    read = parseStat(preadAll(backend.stat_fd, buffer, sizeof(buffer)), process);
+  }
+  // times in microseconds instead of the ticks of stat, and the context switches that stat does not have
+  rusage usage{};
+  HWINFO_COUNT_SYSCALL();
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    process.id = getpid();
+    process.user_time_ns = usage.ru_utime.tv_sec * 1000000000LL + usage.ru_utime.tv_usec * 1000LL;
+    process.system_time_ns = usage.ru_stime.tv_sec * 1000000000LL + usage.ru_stime.tv_usec * 1000LL;
+    process.minor_faults = usage.ru_minflt;
+    process.major_faults = usage.ru_majflt;
+    process.voluntary_context_switches = usage.ru_nvcsw;
+    process.involuntary_context_switches = usage.ru_nivcsw;
+    // KiB
+    process.peak_rss_Bytes = usage.ru_maxrss * 1024LL;
+    read = true;
+  }
+  if (threads == nullptr || !read) {
+    return read;
+  }
+
+  HWINFO_PROBE("process.threads");
+  if (backend.tasks == nullptr) {
+    HWINFO_COUNT_OPEN();
+    backend.tasks = opendir("/proc/self/task");
+    if (backend.tasks == nullptr) {
+      return read;
+    }
+  }
+  // rewinding rereads the directory, threads that started since the last sample appear
+  rewinddir(backend.tasks);
+  const int tasks_fd = dirfd(backend.tasks);
+  for (auto& entry : backend.threads) {
+    entry.second.seen = false;
+  }
+  while (const dirent* entry = readdir(backend.tasks)) {
+    const auto tid = utils::toNumber<int64_t>(entry->d_name);
+    if (!tid) continue;
+    auto it = backend.threads.find(*tid);
+    if (it == backend.threads.end()) {
+      const std::string directory(entry->d_name);
+      Backend::ThreadFiles files;
+      files.stat_fd = openAt(tasks_fd, directory + "/stat");
+      files.status_fd = openAt(tasks_fd, directory + "/status");
+      it = backend.threads.emplace(*tid, files).first;
+    }
+    ProcessStats thread;
+    // reads fail with ESRCH once the thread exited, the entry is dropped below
+    if (!parseStat(preadAll(it->second.stat_fd, buffer, sizeof(buffer)), thread)) continue;
+    parseStatus(preadAll(it->second.status_fd, buffer, sizeof(buffer)), thread);
+    thread.id = *tid;
+    thread.num_threads = -1;
+    thread.virtual_Bytes = -1;
+    thread.rss_Bytes = -1;
+    it->second.seen = true;
+    threads->push_back(std::move(thread));
+  }
+  for (auto it = backend.threads.begin(); it != backend.threads.end();) {
+    if (it->second.seen) {
+      ++it;
+      continue;
+    }
+    if (it->second.stat_fd >= 0) ::close(it->second.stat_fd);
+    if (it->second.status_fd >= 0) ::close(it->second.status_fd);
+    it = backend.threads.erase(it);
+  }
+  return read;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
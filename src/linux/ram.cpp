@@ -5,100 +5,550 @@
 
 #ifdef HWINFO_UNIX
 
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 
-#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "hwinfo/ram.h"
+#include "hwinfo/utils/cgroup.h"
 #include "hwinfo/utils/constants.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
 #include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
 
 namespace hwinfo {
 
-// _____________________________________________________________________________________________________________________
-struct MemInfo {
-  int64_t total{-1};
-  int64_t free{-1};
-  int64_t available{-1};
-};
+namespace {
+
+// FNV-1a, used to switch over the /proc/meminfo keys
+constexpr uint32_t hash(const char* key, size_t length) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < length; ++i) {
+    h = (h ^ static_cast<unsigned char>(key[i])) * 16777619u;
+  }
+  return h;
+}
+
+constexpr uint32_t operator""_key(const char* key, size_t length) { return hash(key, length); }
 
-void get_from_sysconf(MemInfo& mi) {
-  int64_t pages = sysconf(_SC_PHYS_PAGES);
-  int64_t available_pages = sysconf(_SC_AVPHYS_PAGES);
-  int64_t page_size = sysconf(_SC_PAGESIZE);
+void fromSysconf(MemoryStats& stats) {
+  const int64_t pages = sysconf(_SC_PHYS_PAGES);
+  const int64_t available_pages = sysconf(_SC_AVPHYS_PAGES);
+  const int64_t page_size = sysconf(_SC_PAGESIZE);
   if (pages > 0 && page_size > 0) {
-    mi.total = pages * page_size;
+    stats.total_Bytes = pages * page_size;
   }
   if (available_pages > 0 && page_size > 0) {
-    mi.available = available_pages * page_size;
+    stats.available_Bytes = available_pages * page_size;
   }
 }
 
-void set_value(std::string& line, int64_t* dst) {
-  auto split_line = utils::split(line, ":");
-  if (split_line.size() == 2) {
-    auto& value = split_line[1];
-    utils::strip(value);
-    auto space = value.find(' ');
-    if (space != std::string::npos) {
-      auto a = std::string(value.begin(), value.begin() + static_cast<int64_t>(space));
-      *dst = (std::stoll(a) * 1024);
+std::string pressureFile() {
+  const auto cgroup = cgroup::find("memory");
+  if (cgroup.version == 2 && !cgroup.is_root()) {
+    const std::string path = cgroup.path + "/memory.pressure";
+    if (filesystem::exists(path)) {
+      return path;
     }
   }
+  return filesystem::rooted("/proc/pressure/memory");
 }
 
-MemInfo parse_meminfo() {
-  MemInfo mi;
-  std::ifstream f_meminfo("/proc/meminfo");
-  if (!f_meminfo) {
-    get_from_sysconf(mi);
-  } else {
-    while (mi.total == -1 || mi.available == -1 || mi.free == -1) {
-      std::string line;
-      if (!std::getline(f_meminfo, line)) {
-        if (mi.total == -1 || mi.available == -1) {
-          get_from_sysconf(mi);
-        }
-        return mi;
-      }
-      if (utils::starts_with(line, "MemTotal")) {
-        set_value(line, &mi.total);
-      } else if (utils::starts_with(line, "MemFree")) {
-        set_value(line, &mi.free);
-      } else if (utils::starts_with(line, "MemAvailable")) {
-        set_value(line, &mi.available);
-      }
+constexpr const char* huge_pages_path = "/sys/kernel/mm/hugepages/";
+constexpr const char* node_path = "/sys/devices/system/node/";
+constexpr const char* thp_path = "/sys/kernel/mm/transparent_hugepage/";
+
+// page size of a hugepages directory like "hugepages-2048kB", -1 for other entries
+int64_t hugePageSize(std::string_view entry) {
+  if (!utils::consumePrefix(entry, "hugepages-")) {
+    return -1;
+  }
+  const auto size_kB = utils::consumeNumber<int64_t>(entry);
+  return size_kB && entry == "kB" ? *size_kB * 1024 : -1;
+}
+
+// the pools of a hugepages directory (system wide or of a node), ordered by page size
+std::vector<HugePagePool> readPools(const std::string& path, bool system) {
+  std::vector<HugePagePool> pools;
+  for (const auto& entry : filesystem::getDirectoryEntries(path)) {
+    HugePagePool pool;
+    pool.page_size_Bytes = hugePageSize(entry);
+    if (pool.page_size_Bytes <= 0) {
+      continue;
+    }
+    HWINFO_COUNT_OPEN();
+    const int dir_fd = ::open((path + entry).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+      continue;
+    }
+    pool.total = filesystem::readIntAttributeAt(dir_fd, "nr_hugepages", 10);
+    pool.free = filesystem::readIntAttributeAt(dir_fd, "free_hugepages", 10);
+    pool.surplus = filesystem::readIntAttributeAt(dir_fd, "surplus_hugepages", 10);
+    // reservations are only accounted system wide
+    if (system) {
+      pool.reserved = filesystem::readIntAttributeAt(dir_fd, "resv_hugepages", 10);
+    }
+    ::close(dir_fd);
+    pools.push_back(pool);
+  }
+  std::sort(pools.begin(), pools.end(),
+            [](const HugePagePool& a, const HugePagePool& b) { return a.page_size_Bytes < b.page_size_Bytes; });
+  return pools;
+}
+
+// the selected mode of a sysfs choice like "always [madvise] never"
+std::string selectedMode(const char* name) {
+  char buffer[128];
+  if (filesystem::readAttributeAt(AT_FDCWD, filesystem::rooted(std::string(thp_path) + name).c_str(), buffer,
+                                  sizeof(buffer)) <= 0) {
+    return {};
+  }
+  const std::string_view modes(buffer);
+  const size_t begin = modes.find('[');
+  const size_t end = modes.find(']', begin);
+  if (begin == std::string_view::npos || end == std::string_view::npos) {
+    return std::string(utils::trim(modes));
+  }
+  return std::string(modes.substr(begin + 1, end - begin - 1));
+}
+
+struct NodeMeminfo {
+  int64_t total_Bytes{-1};
+  int64_t free_Bytes{-1};
+  // of the default huge page size
+  int64_t huge_pages_free{-1};
+};
+
+// the meminfo attribute of a node directory, lines look like "Node 0 MemFree:         4872664 kB"
+NodeMeminfo readNodeMeminfo(int node_fd) {
+  NodeMeminfo meminfo;
+  char buffer[4096];
+  if (filesystem::readAttributeAt(node_fd, "meminfo", buffer, sizeof(buffer)) <= 0) {
+    return meminfo;
+  }
+  std::string_view content(buffer);
+  std::string_view line;
+  while (utils::nextLine(content, line)) {
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      continue;
+    }
+    std::string_view key = line.substr(0, colon);
+    key.remove_prefix(key.rfind(' ') + 1);
+    std::string_view rest = line.substr(colon + 1);
+    const auto value = utils::consumeNumber<int64_t>(rest);
+    if (!value) {
+      continue;
+    }
+    const int64_t bytes = utils::consumePrefix(rest, " kB") ? *value * 1024 : *value;
+    switch (hash(key.data(), key.size())) {
+      case "MemTotal"_key:
+        meminfo.total_Bytes = bytes;
+        break;
+      case "MemFree"_key:
+        meminfo.free_Bytes = bytes;
+        break;
+      case "HugePages_Free"_key:
+        meminfo.huge_pages_free = *value;
+        break;
+      default:
+        break;
+    }
+  }
+  return meminfo;
+}
+
+// Parses the content of /proc/meminfo into stats. Kernels without MemAvailable get the sysconf values.
+void parseMeminfo(std::string_view content, MemoryStats& stats) {
+  // lines look like "MemTotal:       16318440 kB" or "HugePages_Total:       0"
+  std::string_view line;
+  while (utils::nextLine(content, line)) {
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      continue;
+    }
+    std::string_view rest = line.substr(colon + 1);
+    const auto value = utils::consumeNumber<int64_t>(rest);
+    if (!value) {
+      continue;
     }
+    const int64_t bytes = utils::consumePrefix(rest, " kB") ? *value * 1024 : *value;
+    switch (hash(line.data(), colon)) {
+      case "MemTotal"_key:
+        stats.total_Bytes = bytes;
+        break;
+      case "MemFree"_key:
+        stats.free_Bytes = bytes;
+        break;
+      case "MemAvailable"_key:
+        stats.available_Bytes = bytes;
+        break;
+      case "Buffers"_key:
+        stats.buffers_Bytes = bytes;
+        break;
+      case "Cached"_key:
+        stats.cached_Bytes = bytes;
+        break;
+      case "Shmem"_key:
+        stats.shmem_Bytes = bytes;
+        break;
+      case "Dirty"_key:
+        stats.dirty_Bytes = bytes;
+        break;
+      case "SwapTotal"_key:
+        stats.swap_total_Bytes = bytes;
+        break;
+      case "SwapFree"_key:
+        stats.swap_free_Bytes = bytes;
+        break;
+      case "HugePages_Total"_key:
+        stats.huge_pages_total = *value;
+        break;
+      case "HugePages_Free"_key:
+        stats.huge_pages_free = *value;
+        break;
+      case "Hugepagesize"_key:
+        stats.huge_page_size_Bytes = bytes;
+        break;
+      default:
+        break;
+    }
+  }
+  if (stats.total_Bytes < 0 || stats.available_Bytes < 0) {
+    // kernels before 3.14 have no MemAvailable
+    MemoryStats fallback;
+    fromSysconf(fallback);
+    if (stats.total_Bytes < 0) stats.total_Bytes = fallback.total_Bytes;
+    if (stats.available_Bytes < 0) stats.available_Bytes = fallback.available_Bytes;
   }
-  return mi;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+MemoryStats Memory::snapshot() {
+  HWINFO_PROBE("ram.meminfo");
+  MemoryStats stats;
+  // /proc/meminfo has about 60 lines of at most ~30 characters
+  char buffer[8192];
+  ssize_t size = -1;
+  const int fd = open(filesystem::rooted("/proc/meminfo").c_str(), O_RDONLY | O_CLOEXEC);
+  HWINFO_COUNT_OPEN();
+  if (fd >= 0) {
+    size = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    HWINFO_COUNT_READ(size);
+  }
+  if (size <= 0) {
+    fromSysconf(stats);
+    return stats;
+  }
+  parseMeminfo(std::string_view(buffer, static_cast<size_t>(size)), stats);
+  return stats;
+}
+
+// _____________________________________________________________________________________________________________________
+MemorySampler::MemorySampler() : _fd(open(filesystem::rooted("/proc/meminfo").c_str(), O_RDONLY | O_CLOEXEC)) {
+  HWINFO_COUNT_OPEN();
 }
 
 // _____________________________________________________________________________________________________________________
-Memory::Memory() {
-  // TODO: get information for actual memory modules (DIMM)
+MemorySampler::~MemorySampler() {
+  if (_fd >= 0) close(_fd);
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryStats MemorySampler::sample() {
+  HWINFO_PROBE("ram.meminfo");
+  MemoryStats stats;
+  char buffer[8192];
+  const ssize_t size = _fd < 0 ? -1 : pread(_fd, buffer, sizeof(buffer) - 1, 0);
+  HWINFO_COUNT_READ(size);
+  if (size <= 0) {
+    fromSysconf(stats);
+    return stats;
+  }
+  parseMeminfo(std::string_view(buffer, static_cast<size_t>(size)), stats);
+  return stats;
+}
+
+// _____________________________________________________________________________________________________________________
+Memory::Memory(MemoryFields fields) {
+  if (has_field(fields, MemoryFields::Topology)) {
+    readTopology();
+  }
+  if (!has_field(fields, MemoryFields::Modules)) {
+    return;
+  }
+  HWINFO_PROBE("ram.modules");
+  if (modulesFromSMBIOS()) {
+    return;
+  }
+  // the DMI table is only readable by root, report a single module of the total size otherwise
   Module module;
   module.vendor = constants::UNKNOWN;
   module.name = constants::UNKNOWN;
   module.serial_number = constants::UNKNOWN;
   module.model = constants::UNKNOWN;
   module.id = 0;
-  module.total_Bytes = parse_meminfo().total;
+  module.total_Bytes = snapshot().total_Bytes;
   module.frequency_Hz = -1;
   _modules.push_back(module);
 }
 
 // _____________________________________________________________________________________________________________________
-int64_t Memory::free_Bytes() const {
-  auto meminfo = parse_meminfo();
-  return meminfo.free;
-}
+int64_t Memory::free_Bytes() const { return snapshot().free_Bytes; }
 
 // _____________________________________________________________________________________________________________________
 int64_t Memory::available_Bytes() const {
-  auto meminfo = parse_meminfo();
-  return meminfo.available;
+  const int64_t available = snapshot().available_Bytes;
+  const int64_t cgroup_available = limits().available_Bytes;
+  return (cgroup_available >= 0 && (available < 0 || cgroup_available < available)) ? cgroup_available : available;
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryLimits Memory::limits() {
+  HWINFO_PROBE("ram.cgroup");
+  MemoryLimits limits;
+  const auto cgroup = cgroup::find("memory");
+  if (cgroup.version == 0) {
+    return limits;
+  }
+  limits.cgroup_version = cgroup.version;
+  const bool v2 = cgroup.version == 2;
+
+  if (v2) {
+    // the root cgroup has no limit files, a child may be limited by any of its ancestors
+    for (std::string dir = cgroup.path; dir.size() > cgroup.mount_point.size(); dir.erase(dir.rfind('/'))) {
+      const int64_t limit = cgroup::readValue(dir + "/memory.max");
+      if (limit >= 0 && (limits.limit_Bytes < 0 || limit < limits.limit_Bytes)) {
+        limits.limit_Bytes = limit;
+      }
+    }
+    limits.usage_Bytes = cgroup::readValue(cgroup.path + "/memory.current");
+    limits.swap_limit_Bytes = cgroup::readValue(cgroup.path + "/memory.swap.max");
+  } else {
+    limits.limit_Bytes = cgroup::readValue(cgroup.path + "/memory.limit_in_bytes");
+    limits.usage_Bytes = cgroup::readValue(cgroup.path + "/memory.usage_in_bytes");
+    limits.swap_limit_Bytes = cgroup::readValue(cgroup.path + "/memory.memsw.limit_in_bytes");
+  }
+
+  // v1 reports the hierarchical values with a "total_" prefix
+  char buffer[8192];
+  if (filesystem::readAttributeAt(AT_FDCWD, (cgroup.path + "/memory.stat").c_str(), buffer, sizeof(buffer)) < 0) {
+    buffer[0] = '\0';
+  }
+  utils::Tokenizer tokens(buffer);
+  std::string_view key;
+  while (tokens.next(key)) {
+    const auto parsed = tokens.nextNumber<int64_t>();
+    if (!parsed) {
+      break;
+    }
+    const int64_t value = *parsed;
+    if (!v2 && key == "hierarchical_memory_limit") {
+      if (value < cgroup::v1_unlimited && (limits.limit_Bytes < 0 || value < limits.limit_Bytes)) {
+        limits.limit_Bytes = value;
+      }
+    } else if (key == (v2 ? "anon" : "total_rss")) {
+      limits.anon_Bytes = value;
+    } else if (key == (v2 ? "file" : "total_cache")) {
+      limits.file_Bytes = value;
+    } else if (key == (v2 ? "inactive_file" : "total_inactive_file")) {
+      limits.inactive_file_Bytes = value;
+    }
+  }
+
+  if (limits.limit_Bytes >= 0 && limits.usage_Bytes >= 0) {
+    const int64_t reclaimable = std::max<int64_t>(limits.inactive_file_Bytes, 0);
+    limits.available_Bytes = std::max<int64_t>(limits.limit_Bytes - limits.usage_Bytes + reclaimable, 0);
+    limits.available_Bytes = std::min(limits.available_Bytes, limits.limit_Bytes);
+  }
+  return limits;
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryPressure Memory::pressure() {
+  HWINFO_PROBE("ram.pressure");
+  MemoryPressure pressure;
+  FILE* file = fopen(pressureFile().c_str(), "re");
+  HWINFO_COUNT_OPEN();
+  if (file == nullptr) {
+    return pressure;
+  }
+  char kind[8];
+  MemoryPressure::Stall stall;
+  long long total;
+  // "some avg10=0.00 avg60=0.00 avg300=0.00 total=0", followed by the same for "full"
+  while (fscanf(file, "%7s avg10=%lf avg60=%lf avg300=%lf total=%lld", kind, &stall.avg10, &stall.avg60, &stall.avg300,
+                &total) == 5) {
+    stall.total_us = total;
+    if (std::strcmp(kind, "some") == 0) {
+      pressure.some = stall;
+    } else if (std::strcmp(kind, "full") == 0) {
+      pressure.full = stall;
+    }
+  }
+  fclose(file);
+  return pressure;
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryPressureTrigger::MemoryPressureTrigger(std::chrono::microseconds stall, std::chrono::microseconds window,
+                                             bool full) {
+  char trigger[64];
+  const int length = std::snprintf(trigger, sizeof(trigger), "%s %lld %lld", full ? "full" : "some",
+                                   static_cast<long long>(stall.count()), static_cast<long long>(window.count()));
+  // registering on the cgroup file needs write access to it, fall back to the system wide file
+  for (const std::string& path : {pressureFile(), filesystem::rooted("/proc/pressure/memory")}) {
+    _fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (_fd < 0) {
+      continue;
+    }
+    // the kernel expects the terminating null byte
+    if (write(_fd, trigger, static_cast<size_t>(length) + 1) >= 0) {
+      return;
+    }
+    close(_fd);
+    _fd = -1;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryPressureTrigger::~MemoryPressureTrigger() {
+  if (_fd >= 0) close(_fd);
+}
+
+// _____________________________________________________________________________________________________________________
+bool MemoryPressureTrigger::wait(std::chrono::milliseconds timeout) {
+  if (_fd < 0) {
+    return false;
+  }
+  pollfd fds{_fd, POLLPRI, 0};
+  int result;
+  do {
+    result = poll(&fds, 1, static_cast<int>(timeout.count()));
+  } while (result < 0 && errno == EINTR);
+  // POLLERR means the monitored cgroup was removed
+  return result > 0 && (fds.revents & POLLPRI) && !(fds.revents & POLLERR);
+}
+
+// _____________________________________________________________________________________________________________________
+bool Memory::refresh() {
+  const auto stats = snapshot();
+  _free_Bytes = stats.free_Bytes;
+  _available_Bytes = stats.available_Bytes;
+  const int64_t cgroup_available = limits().available_Bytes;
+  if (cgroup_available >= 0 && (_available_Bytes < 0 || cgroup_available < _available_Bytes)) {
+    _available_Bytes = cgroup_available;
+  }
+  if (!_topology.nodes.empty()) {
+    refreshNodes();
+  }
+  return _free_Bytes >= 0 || _available_Bytes >= 0;
+}
+
+// _____________________________________________________________________________________________________________________
+void Memory::readTopology() {
+  HWINFO_PROBE("ram.topology");
+  const MemoryStats stats = snapshot();
+  const int64_t page_size = sysconf(_SC_PAGESIZE);
+  _topology.page_size_Bytes = page_size > 0 ? page_size : -1;
+  _topology.thp_enabled = selectedMode("enabled");
+  _topology.thp_defrag = selectedMode("defrag");
+  _topology.thp_page_size_Bytes = filesystem::readIntAttributeAt(
+      AT_FDCWD, filesystem::rooted(std::string(thp_path) + "hpage_pmd_size").c_str(), 10);
+  _topology.default_huge_page_size_Bytes = stats.huge_page_size_Bytes;
+  _topology.huge_pages = readPools(filesystem::rooted(huge_pages_path), true);
+
+  const std::string base_path = filesystem::rooted(node_path);
+  char buffer[4096];
+  for (const auto& entry : filesystem::getDirectoryEntries(base_path)) {
+    std::string_view name(entry);
+    if (!utils::consumePrefix(name, "node")) {
+      continue;
+    }
+    const auto id = utils::toNumber<int>(name);
+    if (!id) {
+      continue;
+    }
+    HWINFO_COUNT_OPEN();
+    const int node_fd = ::open((base_path + entry).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (node_fd < 0) {
+      continue;
+    }
+    MemoryNode node;
+    node.id = *id;
+    // memory only nodes (e.g. CXL expanders) have an empty cpulist
+    if (filesystem::readAttributeAt(node_fd, "cpulist", buffer, sizeof(buffer)) > 0) {
+      node.cpus = utils::parseCpuList(buffer);
+    }
+    const auto meminfo = readNodeMeminfo(node_fd);
+    node.total_Bytes = meminfo.total_Bytes;
+    node.free_Bytes = meminfo.free_Bytes;
+    ::close(node_fd);
+    node.huge_pages = readPools(base_path + entry + "/hugepages/", false);
+    _topology.nodes.push_back(std::move(node));
+  }
+  std::sort(_topology.nodes.begin(), _topology.nodes.end(),
+            [](const MemoryNode& a, const MemoryNode& b) { return a.id < b.id; });
+
+  if (_topology.nodes.empty()) {
+    // kernels without CONFIG_NUMA have no node directories, all memory belongs to node 0
+    MemoryNode node;
+    node.id = 0;
+    if (filesystem::readAttributeAt(AT_FDCWD, filesystem::rooted("/sys/devices/system/cpu/online").c_str(), buffer,
+                                    sizeof(buffer)) > 0) {
+      node.cpus = utils::parseCpuList(buffer);
+    }
+    node.total_Bytes = stats.total_Bytes;
+    node.free_Bytes = stats.free_Bytes;
+    node.huge_pages = _topology.huge_pages;
+    _topology.nodes.push_back(std::move(node));
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void Memory::refreshNodes() {
+  HWINFO_PROBE("ram.nodes");
+  const std::string base_path = filesystem::rooted(node_path);
+  for (auto& node : _topology.nodes) {
+    const std::string node_dir = base_path + "node" + std::to_string(node.id);
+    HWINFO_COUNT_OPEN();
+    const int node_fd = ::open(node_dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    NodeMeminfo meminfo;
+    std::string pools_dir;
+    if (node_fd >= 0) {
+      meminfo = readNodeMeminfo(node_fd);
+      ::close(node_fd);
+      pools_dir = node_dir + "/hugepages/";
+    } else {
+      // the node 0 of a kernel without NUMA, see readTopology()
+      meminfo.free_Bytes = _free_Bytes;
+      pools_dir = filesystem::rooted(huge_pages_path);
+    }
+    node.free_Bytes = meminfo.free_Bytes;
+    for (auto& pool : node.huge_pages) {
+      // the node meminfo reports the free pages of the default size, the other pools need one read each
+      if (pool.page_size_Bytes == _topology.default_huge_page_size_Bytes && meminfo.huge_pages_free >= 0) {
+        pool.free = meminfo.huge_pages_free;
+      } else if (pool.total > 0) {
+        const std::string path = pools_dir + "hugepages-" + std::to_string(pool.page_size_Bytes / 1024) + "kB";
+        pool.free = filesystem::readIntAttributeAt(AT_FDCWD, (path + "/free_hugepages").c_str(), 10);
+      }
+    }
+  }
 }
 
 }  // namespace hwinfo
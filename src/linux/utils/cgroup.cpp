@@ -0,0 +1,116 @@
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "hwinfo/utils/cgroup.h"
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
+
+namespace hwinfo {
+namespace cgroup {
+
+namespace {
+
+std::string_view nextField(std::string_view& line) {
+  const size_t end = line.find(' ');
+  const std::string_view field = line.substr(0, end);
+  line.remove_prefix(end == std::string_view::npos ? line.size() : end + 1);
+  return field;
+}
+
+bool hasItem(const std::string& list, const std::string& item) {
+  return ("," + list + ",").find("," + item + ",") != std::string::npos;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+Controller find(const char* controller) {
+  // "0::/path" for the unified hierarchy, "4:memory:/path" (or "4:cpu,cpuacct:/path") for a v1 hierarchy
+  std::string v1_path, v2_path;
+  bool has_v1 = false, has_v2 = false;
+  std::ifstream cgroups(filesystem::rooted("/proc/self/cgroup"));
+  std::string line;
+  while (std::getline(cgroups, line)) {
+    const size_t first = line.find(':');
+    const size_t second = first == std::string::npos ? std::string::npos : line.find(':', first + 1);
+    if (second == std::string::npos) {
+      continue;
+    }
+    const std::string controllers = line.substr(first + 1, second - first - 1);
+    if (controllers.empty() && line.compare(0, first, "0") == 0) {
+      v2_path = line.substr(second + 1);
+      has_v2 = true;
+    } else if (hasItem(controllers, controller)) {
+      v1_path = line.substr(second + 1);
+      has_v1 = true;
+    }
+  }
+  if (!has_v1 && !has_v2) {
+    return {};
+  }
+
+  // "id parent major:minor root mount_point options [optional fields...] - fstype source super_options"
+  std::ifstream mountinfo(filesystem::rooted("/proc/self/mountinfo"));
+  while (std::getline(mountinfo, line)) {
+    std::string_view rest(line);
+    for (int i = 0; i < 3; ++i) nextField(rest);
+    const std::string_view root = nextField(rest);
+    const std::string_view mount_point = nextField(rest);
+    const size_t separator = rest.find(" - ");
+    if (separator == std::string_view::npos) {
+      continue;
+    }
+    rest.remove_prefix(separator + 3);
+    const std::string_view fstype = nextField(rest);
+    nextField(rest);
+    const bool v1 = has_v1 && fstype == "cgroup" && hasItem(std::string(rest), controller);
+    const bool v2 = !has_v1 && fstype == "cgroup2";
+    if (!v1 && !v2) {
+      continue;
+    }
+    Controller result;
+    result.version = v1 ? 1 : 2;
+    result.mount_point = filesystem::rooted(std::string(mount_point));
+    // the mount root is the cgroup namespace root or the cgroup bind mounted into a container
+    std::string path = v1 ? v1_path : v2_path;
+    if (root != "/" && path.compare(0, root.size(), root) == 0) {
+      path.erase(0, root.size());
+    }
+    result.path = result.mount_point + (path == "/" ? "" : path);
+    if (!filesystem::exists(result.path)) {
+      result.path = result.mount_point;
+    }
+    if (v2 && !result.is_root()) {
+      // the controller has to be enabled for the cgroup by its parent, cgroup.controllers is space separated
+      std::string enabled;
+      filesystem::SysfsReader(result.path + "/cgroup.controllers").read(enabled);
+      if ((" " + enabled + " ").find(std::string(" ") + controller + " ") == std::string::npos) {
+        return {};
+      }
+    }
+    return result;
+  }
+  return {};
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t readValue(const std::string& path) {
+  std::string value;
+  if (!filesystem::SysfsReader(path).read(value)) {
+    return -1;
+  }
+  // "max" (v2) is not a number
+  const int64_t number = utils::toNumber<int64_t>(value).value_or(-1);
+  return (number < 0 || number >= v1_unlimited) ? -1 : number;
+}
+
+}  // namespace cgroup
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
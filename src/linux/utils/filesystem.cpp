@@ -3,22 +3,54 @@
 #ifdef HWINFO_UNIX
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
-#include <fstream>
-#include <iterator>
-#include <limits>
-#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "hwinfo/cpu.h"
 #include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/sysfs.h"
 
 namespace hwinfo {
 namespace filesystem {
 
+namespace {
+
+std::string& rootStorage() {
+  static std::string root = [] {
+    const char* env = std::getenv("HWINFO_ROOT");
+    std::string value = env == nullptr ? "" : env;
+    while (!value.empty() && value.back() == '/') {
+      value.pop_back();
+    }
+    return value;
+  }();
+  return root;
+}
+
+}  // namespace
+
+void setRoot(std::string root) {
+  while (!root.empty() && root.back() == '/') {
+    root.pop_back();
+  }
+  rootStorage() = std::move(root);
+}
+
+const std::string& root() { return rootStorage(); }
+
+std::string rooted(const std::string& path) { return rootStorage().empty() ? path : rootStorage() + path; }
+
+std::string rooted(const char* path) { return rootStorage().empty() ? std::string(path) : rootStorage() + path; }
+
 bool exists(const std::string& path) {
   struct stat sb{};
   return stat(path.c_str(), &sb) == 0;
@@ -30,6 +62,7 @@ std::vector<std::string> getDirectoryEntries(const std::string& path) {
   DIR* dp = nullptr;
 
   dp = opendir(path.c_str());
+  HWINFO_COUNT_OPEN();
   if (dp != nullptr) {
     while ((entry = readdir(dp))) {
       if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
@@ -41,57 +74,141 @@ std::vector<std::string> getDirectoryEntries(const std::string& path) {
   return children;
 }
 
-int64_t get_specs_by_file_path(const std::string& path) {
-  std::string line;
-  std::ifstream stream(path);
-
-  if (!stream) {
-    return -1;
-  }
+int64_t get_specs_by_file_path(const std::string& path) { return SysfsReader(path).readInt(); }
 
-  getline(stream, line);
-  stream.close();
+namespace {
 
-  try {
-    return static_cast<int64_t>(std::stoll(line));
-  } catch (std::invalid_argument& e) {
-    return -1;
+/**
+ * Reads the whole file at path into buffer, reusing the capacity of buffer. procfs files report a size of 0, so the
+ * buffer is grown until the read returns less than the free space.
+ */
+bool read_file_into(const char* path, std::string& buffer) {
+  const int fd = open(path, O_RDONLY | O_CLOEXEC);
+  HWINFO_COUNT_OPEN();
+  if (fd < 0) {
+    return false;
+  }
+  if (buffer.capacity() < 4096) {
+    buffer.reserve(4096);
+  }
+  buffer.resize(buffer.capacity());
+  size_t size = 0;
+  while (true) {
+    const ssize_t n = read(fd, &buffer[size], buffer.size() - size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(fd);
+      buffer.clear();
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    size += static_cast<size_t>(n);
+    if (size == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
   }
+  close(fd);
+  HWINFO_COUNT_READ(size);
+  buffer.resize(size);
+  return true;
 }
 
-Jiffies get_jiffies(int index) {
-  std::ifstream filestat("/proc/stat");
-  if (!filestat.is_open()) {
-    return {};
+// Parses an unsigned decimal number at pos and advances pos behind it. Leading blanks are skipped.
+int64_t scan_int(const char*& pos, const char* end) {
+  while (pos < end && (*pos == ' ' || *pos == '\t')) {
+    ++pos;
+  }
+  int64_t value = 0;
+  while (pos < end && *pos >= '0' && *pos <= '9') {
+    value = value * 10 + (*pos - '0');
+    ++pos;
   }
+  return value;
+}
+
+// Parses the counters of one "cpu" line. pos must point behind the "cpu[N]" label.
+Jiffies scan_jiffies(const char*& pos, const char* end) {
+  Jiffies j(0, 0);
+  j.user = scan_int(pos, end);
+  j.nice = scan_int(pos, end);
+  j.system = scan_int(pos, end);
+  j.idle = scan_int(pos, end);
+  j.iowait = scan_int(pos, end);
+  j.irq = scan_int(pos, end);
+  j.softirq = scan_int(pos, end);
+  j.steal = scan_int(pos, end);
+  j.guest = scan_int(pos, end);
+  j.guest_nice = scan_int(pos, end);
+  // guest and guest_nice are already accounted in user and nice
+  j.working = j.user + j.nice + j.system;
+  j.all = j.working + j.idle + j.iowait + j.irq + j.softirq + j.steal;
+  return j;
+}
 
-  for (int i = 0; i < index; ++i) {
-    if (!filestat.ignore(std::numeric_limits<std::streamsize>::max(), '\n')) {
+// Calls on_cpu(cpu_index, jiffies) for every cpu line of /proc/stat, cpu_index is -1 for the aggregated line.
+template <typename Callback>
+bool for_each_cpu_line(Callback&& on_cpu) {
+  HWINFO_PROBE("cpu.stat");
+  thread_local std::string buffer;
+  if (!read_file_into(rooted("/proc/stat").c_str(), buffer)) {
+    return false;
+  }
+  const char* pos = buffer.data();
+  const char* end = pos + buffer.size();
+  // cpu lines are always at the beginning of the file
+  while (end - pos > 3 && pos[0] == 'c' && pos[1] == 'p' && pos[2] == 'u') {
+    pos += 3;
+    int cpu_index = -1;
+    if (*pos >= '0' && *pos <= '9') {
+      cpu_index = static_cast<int>(scan_int(pos, end));
+    }
+    if (!on_cpu(cpu_index, scan_jiffies(pos, end))) {
       break;
     }
+    pos = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+    if (pos == nullptr) {
+      break;
+    }
+    ++pos;
   }
-  std::string line;
-  std::getline(filestat, line);
-
-  std::istringstream iss(line);
-  std::vector<std::string> results(std::istream_iterator<std::string>{iss}, std::istream_iterator<std::string>());
-
-  const int64_t jiffies_0 = std::stol(results[1]);
-  const int64_t jiffies_1 = std::stol(results[2]);
-  const int64_t jiffies_2 = std::stol(results[3]);
-  const int64_t jiffies_3 = std::stol(results[4]);
-  const int64_t jiffies_4 = std::stol(results[5]);
-  const int64_t jiffies_5 = std::stol(results[6]);
-  const int64_t jiffies_6 = std::stol(results[7]);
-  const int64_t jiffies_7 = std::stol(results[8]);
-  const int64_t jiffies_8 = std::stol(results[9]);
-  const int64_t jiffies_9 = std::stol(results[10]);
-
-  int64_t all = jiffies_0 + jiffies_1 + jiffies_2 + jiffies_3 + jiffies_4 + jiffies_5 + jiffies_6 + jiffies_7 +
-                jiffies_8 + jiffies_9;
-  int64_t working = jiffies_0 + jiffies_1 + jiffies_2;
-
-  return {all, working};
+  return true;
+}
+
+}  // namespace
+
+Jiffies get_jiffies(int index) {
+  Jiffies result;
+  int line = 0;
+  for_each_cpu_line([&](int, const Jiffies& jiffies) {
+    if (line++ == index) {
+      result = jiffies;
+      return false;
+    }
+    return true;
+  });
+  return result;
+}
+
+bool get_all_jiffies(std::vector<Jiffies>& out) {
+  out.clear();
+  return for_each_cpu_line([&](int cpu_index, const Jiffies& jiffies) {
+    const size_t slot = static_cast<size_t>(cpu_index + 1);
+    if (slot >= out.size()) {
+      out.resize(slot + 1);
+    }
+    out[slot] = jiffies;
+    return true;
+  });
+}
+
+std::vector<Jiffies> get_all_jiffies() {
+  std::vector<Jiffies> jiffies;
+  get_all_jiffies(jiffies);
+  return jiffies;
 }
 
 }  // namespace filesystem
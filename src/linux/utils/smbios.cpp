@@ -0,0 +1,55 @@
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+
+#include "hwinfo/utils/filesystem.h"
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/smbios.h"
+
+namespace hwinfo {
+namespace utils {
+namespace SMBIOS {
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint8_t> read_table() {
+  HWINFO_PROBE("smbios.table");
+  std::vector<uint8_t> table;
+  // the structure table as exported by the kernel, readable by root only
+  const int fd = open(filesystem::rooted("/sys/firmware/dmi/tables/DMI").c_str(), O_RDONLY | O_CLOEXEC);
+  HWINFO_COUNT_OPEN();
+  if (fd < 0) {
+    return table;
+  }
+  size_t size = 0;
+  table.resize(16384);
+  for (;;) {
+    if (size == table.size()) {
+      table.resize(table.size() * 2);
+    }
+    const ssize_t len = read(fd, table.data() + size, table.size() - size);
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      break;
+    }
+    size += static_cast<size_t>(len);
+  }
+  close(fd);
+  HWINFO_COUNT_READ(size);
+  table.resize(size);
+  return table;
+}
+
+}  // namespace SMBIOS
+}  // namespace utils
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
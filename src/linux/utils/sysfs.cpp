@@ -0,0 +1,155 @@
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_UNIX
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "hwinfo/utils/instrumentation.h"
+#include "hwinfo/utils/stringutils.h"
+#include "hwinfo/utils/sysfs.h"
+
+namespace hwinfo {
+namespace filesystem {
+
+// sysfs attributes are at most one page large
+static constexpr size_t SYSFS_BUFFER_SIZE = 4096;
+
+// _____________________________________________________________________________________________________________________
+SysfsReader::SysfsReader(std::string path) : _path(std::move(path)) {}
+
+// _____________________________________________________________________________________________________________________
+SysfsReader::~SysfsReader() { close(); }
+
+// _____________________________________________________________________________________________________________________
+SysfsReader::SysfsReader(const SysfsReader& other) : _path(other._path) {}
+
+// _____________________________________________________________________________________________________________________
+SysfsReader::SysfsReader(SysfsReader&& other) noexcept : _path(std::move(other._path)), _fd(other._fd) {
+  other._fd = -1;
+}
+
+// _____________________________________________________________________________________________________________________
+SysfsReader& SysfsReader::operator=(const SysfsReader& other) {
+  if (this != &other) {
+    close();
+    _path = other._path;
+  }
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+SysfsReader& SysfsReader::operator=(SysfsReader&& other) noexcept {
+  if (this != &other) {
+    close();
+    _path = std::move(other._path);
+    _fd = other._fd;
+    other._fd = -1;
+  }
+  return *this;
+}
+
+// _____________________________________________________________________________________________________________________
+void SysfsReader::close() {
+  if (_fd >= 0) {
+    ::close(_fd);
+    _fd = -1;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t SysfsReader::readRaw(char* buffer, size_t size) {
+  // at most one reopen: ENODEV means the underlying device is gone and a new instance may have taken its place
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    if (_fd < 0) {
+      _fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+      HWINFO_COUNT_OPEN();
+      if (_fd < 0) {
+        return -1;
+      }
+    }
+    ssize_t n;
+    do {
+      n = ::pread(_fd, buffer, size, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n >= 0) {
+      HWINFO_COUNT_READ(n);
+      return n;
+    }
+    if (errno != ENODEV) {
+      return -1;
+    }
+    close();
+  }
+  return -1;
+}
+
+// _____________________________________________________________________________________________________________________
+bool SysfsReader::read(std::string& out) {
+  char buffer[SYSFS_BUFFER_SIZE];
+  const int64_t n = readRaw(buffer, sizeof(buffer));
+  if (n < 0) {
+    return false;
+  }
+  const auto* newline = static_cast<const char*>(std::memchr(buffer, '\n', static_cast<size_t>(n)));
+  out.assign(buffer, newline != nullptr ? static_cast<size_t>(newline - buffer) : static_cast<size_t>(n));
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t SysfsReader::readInt() {
+  char buffer[SYSFS_BUFFER_SIZE];
+  const int64_t n = readRaw(buffer, sizeof(buffer) - 1);
+  if (n <= 0) {
+    return -1;
+  }
+  std::string_view value(buffer, static_cast<size_t>(n));
+  return utils::consumeNumber<int64_t>(value).value_or(-1);
+}
+
+// _____________________________________________________________________________________________________________________
+ssize_t readAttributeAt(int dir_fd, const char* name, char* buffer, size_t size) {
+  if (size == 0) {
+    return -1;
+  }
+  const int fd = ::openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+  HWINFO_COUNT_OPEN();
+  if (fd < 0) {
+    return -1;
+  }
+  ssize_t n;
+  do {
+    n = ::read(fd, buffer, size - 1);
+  } while (n < 0 && errno == EINTR);
+  ::close(fd);
+  HWINFO_COUNT_READ(n);
+  if (n < 0) {
+    return -1;
+  }
+  while (n > 0 && buffer[n - 1] == '\n') {
+    --n;
+  }
+  buffer[n] = '\0';
+  return n;
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t readIntAttributeAt(int dir_fd, const char* name, int base, int64_t fallback) {
+  char buffer[64];
+  if (readAttributeAt(dir_fd, name, buffer, sizeof(buffer)) <= 0) {
+    return fallback;
+  }
+  std::string_view value(buffer);
+  return utils::consumeNumber<int64_t>(value, base).value_or(fallback);
+}
+
+}  // namespace filesystem
+}  // namespace hwinfo
+
+#endif  // HWINFO_UNIX
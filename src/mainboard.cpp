@@ -3,6 +3,8 @@
 
 #include "hwinfo/mainboard.h"
 
+#include "hwinfo/utils/smbios.h"
+
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
@@ -17,4 +19,17 @@ const std::string& MainBoard::version() const { return _version; }
 // _____________________________________________________________________________________________________________________
 const std::string& MainBoard::serialNumber() const { return _serialNumber; }
 
+// _____________________________________________________________________________________________________________________
+bool MainBoard::fromSMBIOS() {
+  const auto& baseboards = utils::SMBIOS::tables().baseboards;
+  if (baseboards.empty()) {
+    return false;
+  }
+  _vendor = baseboards.front().manufacturer;
+  _name = baseboards.front().product;
+  _version = baseboards.front().version;
+  _serialNumber = baseboards.front().serial_number;
+  return true;
+}
+
 }  // namespace hwinfo
@@ -1,5 +1,9 @@
 #include "hwinfo/network.h"
 
+#include <algorithm>
+#include <string>
+#include <string_view>
+
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
@@ -17,7 +21,30 @@ const std::string& Network::ip4() const { return _ip4; }
 // _____________________________________________________________________________________________________________________
 const std::string& Network::ip6() const { return _ip6; }
 
+// _____________________________________________________________________________________________________________________
+const std::vector<std::string>& Network::ip6Addresses() const { return _ip6_addresses; }
+
 // _____________________________________________________________________________________________________________________
 const std::string& Network::type() const { return _type; }
 
+// _____________________________________________________________________________________________________________________
+const Network::Statistics& Network::statistics() const { return _statistics; }
+
+// _____________________________________________________________________________________________________________________
+int Network::mtu() const { return _mtu; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& Network::operState() const { return _oper_state; }
+
+// _____________________________________________________________________________________________________________________
+int64_t Network::linkSpeed_Mbps() const { return _link_speed_Mbps; }
+
+// _____________________________________________________________________________________________________________________
+const Network::Hardware& Network::hardware() const { return _hardware; }
+
+// _____________________________________________________________________________________________________________________
+bool Network::Hardware::hasFeature(std::string_view name) const {
+  return std::find(features.begin(), features.end(), name) != features.end();
+}
+
 }  // namespace hwinfo
@@ -0,0 +1,190 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/nvme.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hwinfo {
+
+namespace {
+
+// NVMe data structures are little endian like every host hwinfo runs on, fields are loaded in place
+template <typename T>
+T load(const uint8_t* data, size_t offset) {
+  T value;
+  std::memcpy(&value, data + offset, sizeof(T));
+  return value;
+}
+
+// 128 bit counters of the health log and the capacities, saturated to int64_t
+int64_t load128(const uint8_t* data, size_t offset) {
+  const auto low = load<uint64_t>(data, offset);
+  const auto high = load<uint64_t>(data, offset + 8);
+  if (high != 0 || low > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  return static_cast<int64_t>(low);
+}
+
+// space padded ASCII fields like the serial number and the model
+std::string ascii(const uint8_t* data, size_t offset, size_t size) {
+  const char* begin = reinterpret_cast<const char*>(data + offset);
+  size_t length = size;
+  while (length > 0 && (begin[length - 1] == ' ' || begin[length - 1] == '\0')) --length;
+  size_t first = 0;
+  while (first < length && begin[first] == ' ') ++first;
+  return std::string(begin + first, length - first);
+}
+
+// temperatures are reported in Kelvin, 0 if not implemented
+double celsius(uint16_t kelvin) { return kelvin == 0 ? -1.0 : static_cast<double>(kelvin) - 273.15; }
+
+// data units of the health log count thousands of 512 byte blocks
+int64_t dataUnits_Bytes(int64_t units) {
+  constexpr int64_t unit_Bytes = 1000 * 512;
+  if (units > std::numeric_limits<int64_t>::max() / unit_Bytes) {
+    return std::numeric_limits<int64_t>::max();
+  }
+  return units * unit_Bytes;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+const std::string& NvmeController::name() const { return _name; }
+
+// _____________________________________________________________________________________________________________________
+uint16_t NvmeController::vendor_id() const { return _vendor_id; }
+
+// _____________________________________________________________________________________________________________________
+uint16_t NvmeController::subsystem_vendor_id() const { return _subsystem_vendor_id; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& NvmeController::model() const { return _model; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& NvmeController::serialNumber() const { return _serialNumber; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& NvmeController::firmware() const { return _firmware; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& NvmeController::version() const { return _version; }
+
+// _____________________________________________________________________________________________________________________
+int NvmeController::controller_id() const { return _controller_id; }
+
+// _____________________________________________________________________________________________________________________
+int64_t NvmeController::capacity_Bytes() const { return _capacity_Bytes; }
+
+// _____________________________________________________________________________________________________________________
+int64_t NvmeController::unallocated_Bytes() const { return _unallocated_Bytes; }
+
+// _____________________________________________________________________________________________________________________
+double NvmeController::warning_temperature_C() const { return _warning_temperature_C; }
+
+// _____________________________________________________________________________________________________________________
+double NvmeController::critical_temperature_C() const { return _critical_temperature_C; }
+
+// _____________________________________________________________________________________________________________________
+const std::vector<NvmeController::Namespace>& NvmeController::namespaces() const { return _namespaces; }
+
+// _____________________________________________________________________________________________________________________
+const NvmeController::Health& NvmeController::health() const { return _health; }
+
+// _____________________________________________________________________________________________________________________
+bool NvmeController::refresh() {
+  Health health;
+  if (!readHealth(health)) {
+    _health = Health{};
+    return false;
+  }
+  _health = std::move(health);
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void NvmeController::parseIdentifyController(const uint8_t* data) {
+  _vendor_id = load<uint16_t>(data, 0);
+  _subsystem_vendor_id = load<uint16_t>(data, 2);
+  _serialNumber = ascii(data, 4, 20);
+  _model = ascii(data, 24, 40);
+  _firmware = ascii(data, 64, 8);
+  _controller_id = load<uint16_t>(data, 78);
+  // major in bits 31:16, minor in 15:8 and tertiary in 7:0, 0 for controllers before NVMe 1.2
+  const auto version = load<uint32_t>(data, 80);
+  _version.clear();
+  if (version != 0) {
+    _version = std::to_string(version >> 16) + "." + std::to_string((version >> 8) & 0xff);
+    if ((version & 0xff) != 0) _version += "." + std::to_string(version & 0xff);
+  }
+  _warning_temperature_C = celsius(load<uint16_t>(data, 266));
+  _critical_temperature_C = celsius(load<uint16_t>(data, 268));
+  // the capacities are only reported with namespace management (OACS bit 3)
+  if ((load<uint16_t>(data, 256) & 0x8) != 0) {
+    _capacity_Bytes = load128(data, 280);
+    _unallocated_Bytes = load128(data, 296);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+NvmeController::Namespace NvmeController::parseIdentifyNamespace(const uint8_t* data) {
+  Namespace ns;
+  // the low bits of FLBAS select the LBA format, with more than 16 formats bits 6:5 extend the index
+  const uint8_t formats = data[25];
+  const uint8_t flbas = data[26];
+  const unsigned format = (flbas & 0xfu) | (formats >= 16 ? ((flbas >> 5u) & 0x3u) << 4u : 0u);
+  // LBA data size as a power of two, 0 if the format is not supported
+  const uint8_t lbads = data[128 + 4 * format + 2];
+  if (lbads >= 9 && lbads < 32) {
+    ns.block_size_Bytes = int64_t{1} << lbads;
+    ns.size_Bytes = static_cast<int64_t>(load<uint64_t>(data, 0)) * ns.block_size_Bytes;
+    ns.capacity_Bytes = static_cast<int64_t>(load<uint64_t>(data, 8)) * ns.block_size_Bytes;
+    ns.utilization_Bytes = static_cast<int64_t>(load<uint64_t>(data, 16)) * ns.block_size_Bytes;
+  }
+  const auto eui64 = load<uint64_t>(data, 120);
+  if (eui64 != 0) {
+    static constexpr char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < 8; ++i) {
+      ns.eui64 += digits[data[120 + i] >> 4];
+      ns.eui64 += digits[data[120 + i] & 0xf];
+    }
+  }
+  return ns;
+}
+
+// _____________________________________________________________________________________________________________________
+NvmeController::Health NvmeController::parseHealth(const uint8_t* data) {
+  Health health;
+  health.valid = true;
+  health.critical_warning = data[0];
+  health.temperature_C = celsius(load<uint16_t>(data, 1));
+  health.available_spare_percent = data[3];
+  health.available_spare_threshold_percent = data[4];
+  health.percentage_used = data[5];
+  health.read_Bytes = dataUnits_Bytes(load128(data, 32));
+  health.written_Bytes = dataUnits_Bytes(load128(data, 48));
+  health.host_read_commands = load128(data, 64);
+  health.host_write_commands = load128(data, 80);
+  health.controller_busy_minutes = load128(data, 96);
+  health.power_cycles = load128(data, 112);
+  health.power_on_hours = load128(data, 128);
+  health.unsafe_shutdowns = load128(data, 144);
+  health.media_errors = load128(data, 160);
+  health.error_log_entries = load128(data, 176);
+  health.warning_temperature_minutes = load<uint32_t>(data, 192);
+  health.critical_temperature_minutes = load<uint32_t>(data, 196);
+  for (size_t sensor = 0; sensor < 8; ++sensor) {
+    const auto kelvin = load<uint16_t>(data, 200 + 2 * sensor);
+    if (kelvin != 0) health.sensor_temperatures_C.push_back(celsius(kelvin));
+  }
+  return health;
+}
+
+}  // namespace hwinfo
@@ -4,17 +4,23 @@
 #include "hwinfo/opencl/device.h"
 
 #include <algorithm>
+#include <cstdio>
 
 namespace opencl_ {
 
 Device::Device(uint32_t id, cl::Device cl_device) : _cl_device(std::move(cl_device)), _id(id) {
+  // properties that never change are queried once, every getInfo call goes through the ICD loader
+  _type = _cl_device.getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU ? Type::CPU : Type::GPU;
+  _pci_bus_id = _query_pci_bus_id();
   _cores = _compute_cores();
-  _instructions_per_cycle = type() == Type::GPU ? 2 : 32;
+  _instructions_per_cycle = _type == Type::GPU ? 2 : 32;
 }
 Device::~Device() = default;
 
 Device::Device(Device&& device) noexcept
-    : _instructions_per_cycle(device._instructions_per_cycle),
+    : _type(device._type),
+      _pci_bus_id(std::move(device._pci_bus_id)),
+      _instructions_per_cycle(device._instructions_per_cycle),
       _cores(device._cores),
       _id(device._id),
       _intel_gt_4gb_buffer_required(device._intel_gt_4gb_buffer_required),
@@ -23,6 +29,8 @@ Device::Device(Device&& device) noexcept
 
 Device& Device::operator=(opencl_::Device&& device) noexcept {
   _cl_device = std::move(device._cl_device);
+  _type = device._type;
+  _pci_bus_id = std::move(device._pci_bus_id);
   _intel_gt_4gb_buffer_required = device._intel_gt_4gb_buffer_required;
   _id = device._id;
   _cores = device._cores;
@@ -63,12 +71,7 @@ uint64_t Device::cores() const { return _cores; }
 
 uint64_t Device::clock_frequency_MHz() const { return _cl_device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>(); }
 
-Device::Type Device::type() const {
-  if (_cl_device.getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_CPU) {
-    return Type::CPU;
-  }
-  return Type::GPU;
-}
+Device::Type Device::type() const { return _type; }
 
 uint64_t Device::fp64() const {
   return _cl_device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_fp64") != std::string::npos
@@ -98,6 +101,44 @@ uint64_t Device::estimated_flops() const {
 
 bool Device::intel_gt_4gb_buffer_required() const { return _intel_gt_4gb_buffer_required; }
 
+const std::string& Device::pci_bus_id() const { return _pci_bus_id; }
+
+std::string Device::_query_pci_bus_id() const {
+  const auto extensions = _cl_device.getInfo<CL_DEVICE_EXTENSIONS>();
+  cl_uint domain = 0, bus = 0, device = 0, function = 0;
+  bool found = false;
+#ifdef CL_DEVICE_PCI_BUS_INFO_KHR
+  if (extensions.find("cl_khr_pci_bus_info") != std::string::npos) {
+    cl_device_pci_bus_info_khr info{};
+    if (clGetDeviceInfo(_cl_device(), CL_DEVICE_PCI_BUS_INFO_KHR, sizeof(info), &info, nullptr) == CL_SUCCESS) {
+      domain = info.pci_domain;
+      bus = info.pci_bus;
+      device = info.pci_device;
+      function = info.pci_function;
+      found = true;
+    }
+  }
+#endif
+  if (!found && extensions.find("cl_nv_device_attribute_query") != std::string::npos) {
+    // CL_DEVICE_PCI_BUS_ID_NV and CL_DEVICE_PCI_SLOT_ID_NV (slot = device << 3 | function)
+    constexpr cl_device_info pci_bus_id_nv = 0x4008;
+    constexpr cl_device_info pci_slot_id_nv = 0x4009;
+    cl_uint slot = 0;
+    if (clGetDeviceInfo(_cl_device(), pci_bus_id_nv, sizeof(bus), &bus, nullptr) == CL_SUCCESS &&
+        clGetDeviceInfo(_cl_device(), pci_slot_id_nv, sizeof(slot), &slot, nullptr) == CL_SUCCESS) {
+      device = slot >> 3;
+      function = slot & 0x7;
+      found = true;
+    }
+  }
+  if (!found) {
+    return {};
+  }
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%04x:%02x:%02x.%x", domain, bus, device, function);
+  return buffer;
+}
+
 uint64_t Device::_compute_cores() {
   auto device_name = name();
   auto device_vendor = vendor();
@@ -0,0 +1,49 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/pci.h"
+
+#include <string>
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+const std::string& PCIBusDevice::address() const { return _address; }
+
+// _____________________________________________________________________________________________________________________
+uint16_t PCIBusDevice::vendor_id() const { return _vendor_id; }
+
+// _____________________________________________________________________________________________________________________
+uint16_t PCIBusDevice::device_id() const { return _device_id; }
+
+// _____________________________________________________________________________________________________________________
+uint16_t PCIBusDevice::subvendor_id() const { return _subvendor_id; }
+
+// _____________________________________________________________________________________________________________________
+uint16_t PCIBusDevice::subdevice_id() const { return _subdevice_id; }
+
+// _____________________________________________________________________________________________________________________
+uint32_t PCIBusDevice::class_code() const { return _class_code; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& PCIBusDevice::vendor() const { return _vendor; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& PCIBusDevice::name() const { return _name; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& PCIBusDevice::subsystem() const { return _subsystem; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& PCIBusDevice::driver() const { return _driver; }
+
+// _____________________________________________________________________________________________________________________
+int PCIBusDevice::numa_node() const { return _numa_node; }
+
+// _____________________________________________________________________________________________________________________
+const std::string& PCIBusDevice::link_speed() const { return _link_speed; }
+
+// _____________________________________________________________________________________________________________________
+int PCIBusDevice::link_width() const { return _link_width; }
+
+}  // namespace hwinfo
@@ -0,0 +1,98 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/perf_counters.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace hwinfo {
+
+namespace {
+
+// numerator / denominator scaled by factor, -1 if one of them is not available
+double ratio(int64_t numerator, int64_t denominator, double factor = 1.0) {
+  if (numerator < 0 || denominator <= 0) {
+    return -1.0;
+  }
+  return factor * static_cast<double>(numerator) / static_cast<double>(denominator);
+}
+
+void derive(PerfCounterSampler::Counters& counters) {
+  counters.ipc = ratio(counters.instructions, counters.cycles);
+  counters.cache_mpki = ratio(counters.cache_misses, counters.instructions, 1000.0);
+  counters.branch_mpki = ratio(counters.branch_misses, counters.instructions, 1000.0);
+  counters.stalled_ratio = ratio(counters.stalled_cycles, counters.cycles);
+}
+
+// adds an event count to a sum that is -1 while no CPU reported the event
+void accumulate(int64_t& sum, int64_t value) {
+  if (value >= 0) {
+    sum = sum < 0 ? value : sum + value;
+  }
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+PerfCounterSampler::PerfCounterSampler() : _backend(open_backend(_error)) {}
+
+// _____________________________________________________________________________________________________________________
+PerfCounterSampler::~PerfCounterSampler() = default;
+
+// _____________________________________________________________________________________________________________________
+PerfCounterSampler::Sample PerfCounterSampler::sample() {
+  Sample result;
+  const auto now = std::chrono::steady_clock::now();
+  if (!_backend || !read_counters(*_backend, _cpus, _readings)) {
+    return result;
+  }
+  const bool first = _last == std::chrono::steady_clock::time_point{} || _previous.size() != _readings.size();
+  result.interval_s = first ? 0.0 : std::chrono::duration<double>(now - _last).count();
+  _last = now;
+  if (first) {
+    _previous = _readings;
+    return result;
+  }
+
+  result.cpus.reserve(_readings.size());
+  double coverage = 0.0;
+  for (size_t i = 0; i < _readings.size(); ++i) {
+    const Reading& current = _readings[i];
+    const Reading& previous = _previous[i];
+    Counters counters;
+    counters.cpu = _cpus[i];
+    const bool valid = current.enabled_ns >= previous.enabled_ns && current.running_ns >= previous.running_ns;
+    const uint64_t enabled = valid ? current.enabled_ns - previous.enabled_ns : 0;
+    const uint64_t running = valid ? current.running_ns - previous.running_ns : 0;
+    // a group that was never scheduled in the interval (or whose CPU went offline) has no counts to scale
+    if (running > 0 && enabled >= running) {
+      counters.coverage = static_cast<double>(running) / static_cast<double>(enabled);
+      const double scale = static_cast<double>(enabled) / static_cast<double>(running);
+      int64_t* events[] = {&counters.cycles, &counters.instructions, &counters.cache_misses, &counters.branch_misses,
+                           &counters.stalled_cycles};
+      for (size_t event = 0; event < 5; ++event) {
+        if (current.values[event] >= previous.values[event] && previous.values[event] >= 0) {
+          *events[event] = static_cast<int64_t>(static_cast<double>(current.values[event] - previous.values[event]) *
+                                                scale);
+        }
+      }
+    }
+    derive(counters);
+    coverage += counters.coverage;
+
+    accumulate(result.total.cycles, counters.cycles);
+    accumulate(result.total.instructions, counters.instructions);
+    accumulate(result.total.cache_misses, counters.cache_misses);
+    accumulate(result.total.branch_misses, counters.branch_misses);
+    accumulate(result.total.stalled_cycles, counters.stalled_cycles);
+    result.cpus.push_back(counters);
+  }
+  result.total.coverage = result.cpus.empty() ? 0.0 : coverage / static_cast<double>(result.cpus.size());
+  derive(result.total);
+  _previous.swap(_readings);
+  return result;
+}
+
+}  // namespace hwinfo
@@ -0,0 +1,96 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/process.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hwinfo {
+
+namespace {
+
+// rate of a cumulative counter, -1 if one of the readings is not available or the counter went backwards
+double rate(int64_t previous, int64_t current, double seconds) {
+  if (previous < 0 || current < previous || seconds <= 0.0) {
+    return -1.0;
+  }
+  return static_cast<double>(current - previous) / seconds;
+}
+
+ProcessSampler::Usage usage(const ProcessStats& current, const ProcessStats* previous, double seconds) {
+  ProcessSampler::Usage result;
+  result.stats = current;
+  if (previous == nullptr) {
+    return result;
+  }
+  const double user = rate(previous->user_time_ns, current.user_time_ns, seconds * 1e9);
+  const double system = rate(previous->system_time_ns, current.system_time_ns, seconds * 1e9);
+  result.user_utilisation = user;
+  result.system_utilisation = system;
+  if (user >= 0 && system >= 0) {
+    result.cpu_utilisation = user + system;
+  }
+  result.minor_faults_per_s = rate(previous->minor_faults, current.minor_faults, seconds);
+  result.major_faults_per_s = rate(previous->major_faults, current.major_faults, seconds);
+  const double voluntary = rate(previous->voluntary_context_switches, current.voluntary_context_switches, seconds);
+  const double involuntary =
+      rate(previous->involuntary_context_switches, current.involuntary_context_switches, seconds);
+  if (voluntary >= 0 && involuntary >= 0) {
+    result.context_switches_per_s = voluntary + involuntary;
+  }
+  return result;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+ProcessStats ProcessStats::current() {
+  ProcessStats stats;
+  std::unique_ptr<ProcessSampler::Backend, ProcessSampler::BackendDeleter> backend(ProcessSampler::open_backend());
+  if (backend) {
+    ProcessSampler::read_counters(*backend, stats, nullptr);
+  }
+  return stats;
+}
+
+// _____________________________________________________________________________________________________________________
+ProcessSampler::ProcessSampler(bool threads) : _threads(threads), _backend(open_backend()) {}
+
+// _____________________________________________________________________________________________________________________
+ProcessSampler::~ProcessSampler() = default;
+
+// _____________________________________________________________________________________________________________________
+ProcessSampler::Sample ProcessSampler::sample() {
+  Sample result;
+  const auto now = std::chrono::steady_clock::now();
+  ProcessStats process;
+  std::vector<ProcessStats> threads;
+  if (!_backend || !read_counters(*_backend, process, _threads ? &threads : nullptr)) {
+    return result;
+  }
+  const bool first = _last == std::chrono::steady_clock::time_point{};
+  result.interval_s = first ? 0.0 : std::chrono::duration<double>(now - _last).count();
+  result.process = usage(process, first ? nullptr : &_previous, result.interval_s);
+
+  std::sort(threads.begin(), threads.end(), [](const ProcessStats& a, const ProcessStats& b) { return a.id < b.id; });
+  result.threads.reserve(threads.size());
+  // threads that started since the previous sample report their counters only, threads that exited are dropped
+  std::unordered_map<int64_t, ProcessStats> previous_threads;
+  previous_threads.reserve(threads.size());
+  for (auto& thread : threads) {
+    const auto it = _previous_threads.find(thread.id);
+    result.threads.push_back(usage(thread, it == _previous_threads.end() ? nullptr : &it->second, result.interval_s));
+    previous_threads.emplace(thread.id, std::move(thread));
+  }
+  _previous_threads = std::move(previous_threads);
+  _previous = std::move(process);
+  _last = now;
+  return result;
+}
+
+}  // namespace hwinfo
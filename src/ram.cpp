@@ -3,13 +3,21 @@
 
 #include "hwinfo/ram.h"
 
+#include "hwinfo/utils/smbios.h"
+
 namespace hwinfo {
 
+// _____________________________________________________________________________________________________________________
+Memory::Memory() : Memory(MemoryFields::All) {}
+
 // _____________________________________________________________________________________________________________________
 const std::vector<Memory::Module>& Memory::modules() const { return _modules; }
 
 // _____________________________________________________________________________________________________________________
 int64_t Memory::total_Bytes() const {
+  if (_modules.empty()) {
+    return -1;
+  }
   int64_t sum = 0;
   for (const auto& module : _modules) {
     sum += module.total_Bytes;
@@ -17,4 +25,41 @@ int64_t Memory::total_Bytes() const {
   return sum;
 }
 
+// _____________________________________________________________________________________________________________________
+bool Memory::modulesFromSMBIOS() {
+  int id = 0;
+  for (const auto& device : utils::SMBIOS::tables().memory_devices) {
+    // empty slots are listed with size 0
+    if (device.size_Bytes <= 0) {
+      continue;
+    }
+    Module module;
+    module.id = id++;
+    module.vendor = device.manufacturer;
+    module.name = device.manufacturer + " " + device.part_number;
+    module.model = device.part_number;
+    module.serial_number = device.serial_number;
+    module.total_Bytes = device.size_Bytes;
+    const int64_t speed_MTs = device.configured_speed_MTs > 0 ? device.configured_speed_MTs : device.speed_MTs;
+    module.frequency_Hz = speed_MTs > 0 ? speed_MTs * 1000 * 1000 : -1;
+    _modules.push_back(std::move(module));
+  }
+  return !_modules.empty();
+}
+
+// _____________________________________________________________________________________________________________________
+const MemoryTopology& Memory::topology() const { return _topology; }
+
+// _____________________________________________________________________________________________________________________
+int64_t Memory::lastFree_Bytes() const { return _free_Bytes; }
+
+// _____________________________________________________________________________________________________________________
+int64_t Memory::lastAvailable_Bytes() const { return _available_Bytes; }
+
+// _____________________________________________________________________________________________________________________
+bool MemoryPressureTrigger::valid() const { return _fd >= 0; }
+
+// _____________________________________________________________________________________________________________________
+int MemoryPressureTrigger::fd() const { return _fd; }
+
 }  // namespace hwinfo
@@ -0,0 +1,657 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/serialization.h"
+
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Format (all integers are unsigned LEB128 varints unless noted):
+ *
+ *   message  := "HWIS" version kind [base_hash: 8 bytes LE, diffs only] strings num_sections section*
+ *   strings  := count (length bytes)*
+ *   section  := id mode num_entries payload_length payload
+ *   record   := length field*
+ *   field    := key (id << 2 | type) value      type 0: zigzag varint integer, type 1: index into strings
+ *
+ * Full snapshots only use mode Records. Diffs use Records for replaced sections, Unchanged (no payload) for sections
+ * that are identical to the base and Patch, whose entries are either op Keep + index of the record in the base
+ * section or op Literal + record. Sections that are not part of a diff were removed.
+ */
+
+namespace hwinfo {
+
+namespace {
+
+constexpr char magic[4] = {'H', 'W', 'I', 'S'};
+constexpr uint32_t format_version = 1;
+
+enum Kind : uint64_t { Full = 0, Diff = 1 };
+enum Mode : uint64_t { Records = 0, Unchanged = 1, Patch = 2 };
+enum Op : uint64_t { Keep = 0, Literal = 1 };
+enum Type : uint64_t { Integer = 0, String = 1 };
+
+// _____________________________________________________________________________________________________________________
+void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+// _____________________________________________________________________________________________________________________
+bool readVarint(const uint8_t*& pos, const uint8_t* end, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+    const uint8_t byte = *pos++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+
+int64_t unzigzag(uint64_t value) { return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1)); }
+
+// FNV-1a, identifies the base of a diff
+uint64_t hashBytes(const std::vector<uint8_t>& data) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const uint8_t byte : data) {
+    hash = (hash ^ byte) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+struct Field {
+  uint16_t id;
+  Type type;
+  uint64_t value;
+};
+
+// _____________________________________________________________________________________________________________________
+bool readField(const uint8_t*& pos, const uint8_t* end, Field& field) {
+  uint64_t key;
+  if (!readVarint(pos, end, key) || !readVarint(pos, end, field.value)) {
+    return false;
+  }
+  field.id = static_cast<uint16_t>(key >> 2);
+  field.type = static_cast<Type>(key & 3);
+  return true;
+}
+
+struct RawSection {
+  uint64_t id;
+  uint64_t mode;
+  uint64_t num_entries;
+  const uint8_t* begin;
+  const uint8_t* end;
+};
+
+struct Message {
+  uint64_t version{0};
+  uint64_t kind{0};
+  uint64_t base_hash{0};
+  std::vector<std::string_view> strings;
+  std::vector<RawSection> sections;
+};
+
+// _____________________________________________________________________________________________________________________
+bool parseMessage(const uint8_t* data, size_t size, Message& message) {
+  const uint8_t* pos = data;
+  const uint8_t* end = data + size;
+  if (size < sizeof(magic) || std::memcmp(data, magic, sizeof(magic)) != 0) {
+    return false;
+  }
+  pos += sizeof(magic);
+  if (!readVarint(pos, end, message.version) || message.version == 0 || message.version > format_version ||
+      !readVarint(pos, end, message.kind) || message.kind > Diff) {
+    return false;
+  }
+  if (message.kind == Diff) {
+    if (end - pos < 8) {
+      return false;
+    }
+    for (int i = 0; i < 8; ++i) {
+      message.base_hash |= static_cast<uint64_t>(*pos++) << (8 * i);
+    }
+  }
+  uint64_t count;
+  if (!readVarint(pos, end, count) || count > static_cast<uint64_t>(end - pos)) {
+    return false;
+  }
+  message.strings.reserve(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t length;
+    if (!readVarint(pos, end, length) || length > static_cast<uint64_t>(end - pos)) {
+      return false;
+    }
+    message.strings.emplace_back(reinterpret_cast<const char*>(pos), length);
+    pos += length;
+  }
+  if (!readVarint(pos, end, count)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < count; ++i) {
+    RawSection section{};
+    uint64_t length;
+    if (!readVarint(pos, end, section.id) || !readVarint(pos, end, section.mode) ||
+        !readVarint(pos, end, section.num_entries) || !readVarint(pos, end, length) ||
+        length > static_cast<uint64_t>(end - pos)) {
+      return false;
+    }
+    section.begin = pos;
+    section.end = pos + length;
+    pos += length;
+    message.sections.push_back(section);
+  }
+  return pos == end;
+}
+
+// _____________________________________________________________________________________________________________________
+bool readRecord(const uint8_t*& pos, const uint8_t* end, const Message& message, std::vector<RecordView>& out) {
+  uint64_t length;
+  if (!readVarint(pos, end, length) || length > static_cast<uint64_t>(end - pos)) {
+    return false;
+  }
+  out.emplace_back(pos, length, message.strings.data(), message.strings.size());
+  pos += length;
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+bool equalRecords(const RecordView& a, const RecordView& b) {
+  const uint8_t* pos_a = a.data();
+  const uint8_t* end_a = pos_a + a.size();
+  const uint8_t* pos_b = b.data();
+  const uint8_t* end_b = pos_b + b.size();
+  Field field_a{};
+  Field field_b{};
+  while (pos_a < end_a && pos_b < end_b) {
+    if (!readField(pos_a, end_a, field_a) || !readField(pos_b, end_b, field_b) || field_a.id != field_b.id ||
+        field_a.type != field_b.type) {
+      return false;
+    }
+    // strings are compared by content, the indices belong to different string tables
+    if (field_a.type == String ? a.stringAt(field_a.value) != b.stringAt(field_b.value)
+                               : field_a.value != field_b.value) {
+      return false;
+    }
+  }
+  return pos_a == end_a && pos_b == end_b;
+}
+
+/**
+ * Builds a message section by section. Strings are interned on first use, records of other messages are re-encoded
+ * against the own string table.
+ */
+class Writer {
+ public:
+  explicit Writer(Kind kind, uint64_t base_hash = 0) : _kind(kind), _base_hash(base_hash) {}
+
+  void beginSection(SnapshotSection id, Mode mode) {
+    _section_id = static_cast<uint64_t>(id);
+    _mode = mode;
+    _num_entries = 0;
+    _payload.clear();
+  }
+
+  void endSection() {
+    writeVarint(_sections, _section_id);
+    writeVarint(_sections, _mode);
+    writeVarint(_sections, _num_entries);
+    writeVarint(_sections, _payload.size());
+    _sections.insert(_sections.end(), _payload.begin(), _payload.end());
+    ++_num_sections;
+  }
+
+  void beginRecord() { _record.clear(); }
+
+  void endRecord() {
+    if (_mode == Patch) {
+      writeVarint(_payload, Literal);
+    }
+    writeVarint(_payload, _record.size());
+    _payload.insert(_payload.end(), _record.begin(), _record.end());
+    ++_num_entries;
+  }
+
+  void keep(uint64_t index) {
+    writeVarint(_payload, Keep);
+    writeVarint(_payload, index);
+    ++_num_entries;
+  }
+
+  template <typename F>
+  void integer(F id, int64_t value) {
+    writeVarint(_record, static_cast<uint64_t>(id) << 2 | Integer);
+    writeVarint(_record, zigzag(value));
+  }
+
+  // empty strings are not stored, readers report them as absent which reads as empty as well
+  template <typename F>
+  void string(F id, std::string_view value) {
+    if (value.empty()) {
+      return;
+    }
+    writeVarint(_record, static_cast<uint64_t>(id) << 2 | String);
+    writeVarint(_record, intern(value));
+  }
+
+  void copy(const RecordView& record) {
+    beginRecord();
+    const uint8_t* pos = record.data();
+    const uint8_t* end = pos + record.size();
+    Field field{};
+    while (pos < end && readField(pos, end, field)) {
+      if (field.type == String) {
+        string(field.id, record.stringAt(field.value));
+      } else {
+        writeVarint(_record, static_cast<uint64_t>(field.id) << 2 | field.type);
+        writeVarint(_record, field.value);
+      }
+    }
+    endRecord();
+  }
+
+  std::vector<uint8_t> finish() {
+    std::vector<uint8_t> out(magic, magic + sizeof(magic));
+    writeVarint(out, format_version);
+    writeVarint(out, _kind);
+    if (_kind == Diff) {
+      for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(_base_hash >> (8 * i)));
+      }
+    }
+    writeVarint(out, _strings.size());
+    for (const auto& value : _strings) {
+      writeVarint(out, value.size());
+      out.insert(out.end(), value.begin(), value.end());
+    }
+    writeVarint(out, _num_sections);
+    out.insert(out.end(), _sections.begin(), _sections.end());
+    return out;
+  }
+
+ private:
+  uint64_t intern(std::string_view value) {
+    const auto it = _indices.find(value);
+    if (it != _indices.end()) {
+      return it->second;
+    }
+    // the deque keeps the addresses of its elements stable, the map keys view them
+    _strings.emplace_back(value);
+    _indices.emplace(_strings.back(), _strings.size() - 1);
+    return _strings.size() - 1;
+  }
+
+  Kind _kind;
+  uint64_t _base_hash;
+  std::deque<std::string> _strings;
+  std::unordered_map<std::string_view, uint64_t> _indices;
+  std::vector<uint8_t> _sections;
+  uint64_t _num_sections{0};
+  uint64_t _section_id{0};
+  Mode _mode{Records};
+  uint64_t _num_entries{0};
+  std::vector<uint8_t> _payload;
+  std::vector<uint8_t> _record;
+};
+
+// _____________________________________________________________________________________________________________________
+template <typename T, typename Fn>
+void writeSection(Writer& writer, SnapshotSection id, const std::vector<T>& items, Fn&& write) {
+  if (items.empty()) {
+    return;
+  }
+  writer.beginSection(id, Records);
+  for (const auto& item : items) {
+    writer.beginRecord();
+    write(item);
+    writer.endRecord();
+  }
+  writer.endSection();
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+RecordView::RecordView(const uint8_t* data, size_t size, const std::string_view* strings, size_t num_strings)
+    : _data(data), _size(size), _strings(strings), _num_strings(num_strings) {}
+
+// _____________________________________________________________________________________________________________________
+std::string_view RecordView::stringAt(uint64_t index) const {
+  return index < _num_strings ? _strings[index] : std::string_view();
+}
+
+// _____________________________________________________________________________________________________________________
+const uint8_t* RecordView::find(uint16_t id, size_t occurrence) const {
+  const uint8_t* pos = _data;
+  const uint8_t* end = _data + _size;
+  while (pos < end) {
+    const uint8_t* begin = pos;
+    Field field{};
+    if (!readField(pos, end, field)) {
+      return nullptr;
+    }
+    if (field.id == id && occurrence-- == 0) {
+      return begin;
+    }
+  }
+  return nullptr;
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t RecordView::integer(uint16_t id, int64_t fallback) const {
+  const uint8_t* pos = find(id, 0);
+  Field field{};
+  if (pos == nullptr || !readField(pos, _data + _size, field) || field.type != Integer) {
+    return fallback;
+  }
+  return unzigzag(field.value);
+}
+
+// _____________________________________________________________________________________________________________________
+std::string_view RecordView::string(uint16_t id) const {
+  const uint8_t* pos = find(id, 0);
+  Field field{};
+  if (pos == nullptr || !readField(pos, _data + _size, field) || field.type != String) {
+    return {};
+  }
+  return stringAt(field.value);
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<std::string_view> RecordView::strings(uint16_t id) const {
+  std::vector<std::string_view> values;
+  const uint8_t* pos = _data;
+  const uint8_t* end = _data + _size;
+  Field field{};
+  while (pos < end && readField(pos, end, field)) {
+    if (field.id == id && field.type == String) {
+      values.push_back(stringAt(field.value));
+    }
+  }
+  return values;
+}
+
+// _____________________________________________________________________________________________________________________
+SnapshotView::SnapshotView(const uint8_t* data, size_t size) {
+  Message message;
+  if (!parseMessage(data, size, message) || message.kind != Full) {
+    return;
+  }
+  _version = static_cast<uint32_t>(message.version);
+  // records point into the buffer of _strings, which is kept when the view is moved
+  _strings = std::move(message.strings);
+  for (const auto& raw : message.sections) {
+    if (raw.mode != Records) {
+      return;
+    }
+    std::vector<RecordView> records;
+    records.reserve(raw.num_entries);
+    const uint8_t* pos = raw.begin;
+    while (pos < raw.end) {
+      uint64_t length;
+      if (!readVarint(pos, raw.end, length) || length > static_cast<uint64_t>(raw.end - pos)) {
+        return;
+      }
+      records.emplace_back(pos, length, _strings.data(), _strings.size());
+      pos += length;
+    }
+    _sections.emplace_back(static_cast<SnapshotSection>(raw.id), std::move(records));
+  }
+  _valid = true;
+}
+
+// _____________________________________________________________________________________________________________________
+SnapshotView::SnapshotView(const std::vector<uint8_t>& data) : SnapshotView(data.data(), data.size()) {}
+
+// _____________________________________________________________________________________________________________________
+bool SnapshotView::valid() const { return _valid; }
+
+// _____________________________________________________________________________________________________________________
+uint32_t SnapshotView::version() const { return _version; }
+
+// _____________________________________________________________________________________________________________________
+const std::vector<RecordView>& SnapshotView::records(SnapshotSection section) const {
+  static const std::vector<RecordView> empty;
+  for (const auto& entry : _sections) {
+    if (entry.first == section) {
+      return entry.second;
+    }
+  }
+  return empty;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint8_t> serializeSnapshot(const Snapshot& snapshot) {
+  Writer writer(Full);
+  writeSection(writer, SnapshotSection::Cpu, snapshot.cpus, [&](const CPU& cpu) {
+    writer.integer(CpuField::Id, cpu.id());
+    writer.string(CpuField::Vendor, cpu.vendor());
+    writer.string(CpuField::Model, cpu.modelName());
+    writer.integer(CpuField::NumPhysicalCores, cpu.numPhysicalCores());
+    writer.integer(CpuField::NumLogicalCores, cpu.numLogicalCores());
+    writer.integer(CpuField::MaxClockSpeed_MHz, cpu.maxClockSpeed_MHz());
+    writer.integer(CpuField::RegularClockSpeed_MHz, cpu.regularClockSpeed_MHz());
+    writer.integer(CpuField::L1CacheSize_Bytes, cpu.L1CacheSize_Bytes());
+    writer.integer(CpuField::L2CacheSize_Bytes, cpu.L2CacheSize_Bytes());
+    writer.integer(CpuField::L3CacheSize_Bytes, cpu.L3CacheSize_Bytes());
+    for (const auto& flag : cpu.flags()) {
+      writer.string(CpuField::Flag, flag);
+    }
+  });
+  if (snapshot.os) {
+    const OS& os = *snapshot.os;
+    writer.beginSection(SnapshotSection::Os, Records);
+    writer.beginRecord();
+    writer.string(OsField::Name, os.name());
+    writer.string(OsField::Version, os.version());
+    writer.string(OsField::Kernel, os.kernel());
+    writer.integer(OsField::Bits, os.is64bit() ? 64 : 32);
+    writer.integer(OsField::LittleEndian, os.isLittleEndian() ? 1 : 0);
+    writer.endRecord();
+    writer.endSection();
+  }
+  writeSection(writer, SnapshotSection::Gpu, snapshot.gpus, [&](const GPU& gpu) {
+    writer.integer(GpuField::Id, gpu.id());
+    writer.string(GpuField::Vendor, gpu.vendor());
+    writer.string(GpuField::Name, gpu.name());
+    writer.string(GpuField::DriverVersion, gpu.driverVersion());
+    writer.integer(GpuField::Memory_Bytes, gpu.memory_Bytes());
+    writer.integer(GpuField::Frequency_MHz, gpu.frequency_MHz());
+    writer.integer(GpuField::NumCores, gpu.num_cores());
+    writer.string(GpuField::VendorId, gpu.vendor_id());
+    writer.string(GpuField::DeviceId, gpu.device_id());
+    writer.string(GpuField::PciBusId, gpu.pci_bus_id());
+  });
+  if (snapshot.ram) {
+    writer.beginSection(SnapshotSection::Memory, Records);
+    writer.beginRecord();
+    writer.integer(MemoryField::Total_Bytes, snapshot.ram->total_Bytes());
+    writer.endRecord();
+    writer.endSection();
+    writeSection(writer, SnapshotSection::MemoryModule, snapshot.ram->modules(), [&](const Memory::Module& module) {
+      writer.integer(MemoryModuleField::Id, module.id);
+      writer.string(MemoryModuleField::Vendor, module.vendor);
+      writer.string(MemoryModuleField::Name, module.name);
+      writer.string(MemoryModuleField::Model, module.model);
+      writer.string(MemoryModuleField::SerialNumber, module.serial_number);
+      writer.integer(MemoryModuleField::Total_Bytes, module.total_Bytes);
+      writer.integer(MemoryModuleField::Frequency_Hz, module.frequency_Hz);
+    });
+  }
+  if (snapshot.mainboard) {
+    const MainBoard& board = *snapshot.mainboard;
+    writer.beginSection(SnapshotSection::MainBoard, Records);
+    writer.beginRecord();
+    writer.string(MainBoardField::Vendor, board.vendor());
+    writer.string(MainBoardField::Name, board.name());
+    writer.string(MainBoardField::Version, board.version());
+    writer.string(MainBoardField::SerialNumber, board.serialNumber());
+    writer.endRecord();
+    writer.endSection();
+  }
+  writeSection(writer, SnapshotSection::Battery, snapshot.batteries, [&](const Battery& battery) {
+    writer.string(BatteryField::Vendor, battery.getVendor());
+    writer.string(BatteryField::Model, battery.getModel());
+    writer.string(BatteryField::SerialNumber, battery.getSerialNumber());
+    writer.string(BatteryField::Technology, battery.getTechnology());
+    writer.integer(BatteryField::EnergyFull, battery.getEnergyFull());
+  });
+  writeSection(writer, SnapshotSection::Disk, snapshot.disks, [&](const Disk& disk) {
+    writer.integer(DiskField::Id, disk.id());
+    writer.string(DiskField::Vendor, disk.vendor());
+    writer.string(DiskField::Model, disk.model());
+    writer.string(DiskField::SerialNumber, disk.serialNumber());
+    writer.integer(DiskField::Size_Bytes, disk.size_Bytes());
+    for (const auto& volume : disk.volumes()) {
+      writer.string(DiskField::Volume, volume);
+    }
+  });
+  writeSection(writer, SnapshotSection::Network, snapshot.networks, [&](const Network& network) {
+    writer.string(NetworkField::InterfaceIndex, network.interfaceIndex());
+    writer.string(NetworkField::Description, network.description());
+    writer.string(NetworkField::Mac, network.mac());
+    writer.string(NetworkField::IP4, network.ip4());
+    for (const auto& address : network.ip6Addresses()) {
+      writer.string(NetworkField::IP6, address);
+    }
+    writer.string(NetworkField::Type, network.type());
+    writer.integer(NetworkField::Mtu, network.mtu());
+    writer.integer(NetworkField::LinkSpeed_Mbps, network.linkSpeed_Mbps());
+    const auto& hardware = network.hardware();
+    writer.string(NetworkField::Driver, hardware.driver);
+    writer.string(NetworkField::PciAddress, hardware.pci_address);
+    writer.integer(NetworkField::NumaNode, hardware.numa_node);
+    writer.integer(NetworkField::RxQueues, hardware.rx_queues);
+    writer.integer(NetworkField::TxQueues, hardware.tx_queues);
+    writer.integer(NetworkField::CombinedChannels, hardware.combined_channels);
+    writer.integer(NetworkField::RxRingSize, hardware.rx_ring_size);
+    writer.integer(NetworkField::TxRingSize, hardware.tx_ring_size);
+    for (const auto& feature : hardware.features) {
+      writer.string(NetworkField::Feature, feature);
+    }
+  });
+  writeSection(writer, SnapshotSection::Monitor, snapshot.monitors, [&](const Monitor& monitor) {
+    writer.string(MonitorField::Vendor, monitor.vendor());
+    writer.string(MonitorField::Model, monitor.model());
+    writer.string(MonitorField::Resolution, monitor.resolution());
+    writer.string(MonitorField::RefreshRate, monitor.refreshRate());
+    writer.string(MonitorField::SerialNumber, monitor.serialNumber());
+  });
+  writeSection(writer, SnapshotSection::Pci, snapshot.pci_devices, [&](const PCIBusDevice& device) {
+    writer.string(PciField::Address, device.address());
+    writer.integer(PciField::VendorId, device.vendor_id());
+    writer.integer(PciField::DeviceId, device.device_id());
+    writer.integer(PciField::SubvendorId, device.subvendor_id());
+    writer.integer(PciField::SubdeviceId, device.subdevice_id());
+    writer.integer(PciField::ClassCode, device.class_code());
+    writer.string(PciField::Vendor, device.vendor());
+    writer.string(PciField::Name, device.name());
+    writer.string(PciField::Subsystem, device.subsystem());
+    writer.string(PciField::Driver, device.driver());
+    writer.integer(PciField::NumaNode, device.numa_node());
+    writer.string(PciField::LinkSpeed, device.link_speed());
+    writer.integer(PciField::LinkWidth, device.link_width());
+  });
+  return writer.finish();
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint8_t> diffSnapshots(const std::vector<uint8_t>& previous, const std::vector<uint8_t>& current) {
+  const SnapshotView base(previous);
+  Message message;
+  if (!base.valid() || !parseMessage(current.data(), current.size(), message) || message.kind != Full) {
+    return {};
+  }
+  Writer writer(Diff, hashBytes(previous));
+  std::vector<RecordView> records;
+  for (const auto& raw : message.sections) {
+    const auto id = static_cast<SnapshotSection>(raw.id);
+    records.clear();
+    for (const uint8_t* pos = raw.begin; pos < raw.end;) {
+      if (!readRecord(pos, raw.end, message, records)) {
+        return {};
+      }
+    }
+    const auto& base_records = base.records(id);
+    size_t num_kept = 0;
+    for (size_t i = 0; i < records.size() && i < base_records.size(); ++i) {
+      num_kept += equalRecords(records[i], base_records[i]) ? 1 : 0;
+    }
+    if (num_kept == records.size() && records.size() == base_records.size()) {
+      writer.beginSection(id, Unchanged);
+    } else if (num_kept == 0) {
+      writer.beginSection(id, Records);
+      for (const auto& record : records) {
+        writer.copy(record);
+      }
+    } else {
+      writer.beginSection(id, Patch);
+      for (size_t i = 0; i < records.size(); ++i) {
+        if (i < base_records.size() && equalRecords(records[i], base_records[i])) {
+          writer.keep(i);
+        } else {
+          writer.copy(records[i]);
+        }
+      }
+    }
+    writer.endSection();
+  }
+  return writer.finish();
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint8_t> applySnapshotDiff(const std::vector<uint8_t>& previous, const std::vector<uint8_t>& diff) {
+  const SnapshotView base(previous);
+  Message message;
+  if (!base.valid() || !parseMessage(diff.data(), diff.size(), message) || message.kind != Diff ||
+      message.base_hash != hashBytes(previous)) {
+    return {};
+  }
+  Writer writer(Full);
+  std::vector<RecordView> records;
+  for (const auto& raw : message.sections) {
+    const auto id = static_cast<SnapshotSection>(raw.id);
+    const auto& base_records = base.records(id);
+    writer.beginSection(id, Records);
+    if (raw.mode == Unchanged) {
+      for (const auto& record : base_records) {
+        writer.copy(record);
+      }
+    } else {
+      for (const uint8_t* pos = raw.begin; pos < raw.end;) {
+        uint64_t op = Literal;
+        if (raw.mode == Patch && !readVarint(pos, raw.end, op)) {
+          return {};
+        }
+        if (op == Keep) {
+          uint64_t index;
+          if (!readVarint(pos, raw.end, index) || index >= base_records.size()) {
+            return {};
+          }
+          writer.copy(base_records[index]);
+          continue;
+        }
+        records.clear();
+        if (!readRecord(pos, raw.end, message, records)) {
+          return {};
+        }
+        writer.copy(records.front());
+      }
+    }
+    writer.endSection();
+  }
+  return writer.finish();
+}
+
+}  // namespace hwinfo
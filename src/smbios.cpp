@@ -0,0 +1,183 @@
+#include "hwinfo/utils/smbios.h"
+
+#include <cstring>
+
+#include "hwinfo/utils/constants.h"
+#include "hwinfo/utils/stringutils.h"
+
+namespace hwinfo {
+namespace utils {
+namespace SMBIOS {
+
+namespace {
+
+constexpr uint8_t type_baseboard = 2;
+constexpr uint8_t type_processor = 4;
+constexpr uint8_t type_memory_device = 17;
+constexpr uint8_t type_end_of_table = 127;
+
+/**
+ * One structure: the formatted area of length() bytes followed by its string set.
+ */
+class Structure {
+ public:
+  Structure(const uint8_t* data, const uint8_t* strings, const uint8_t* end)
+      : _data(data), _strings(strings), _end(end) {}
+
+  uint8_t type() const { return _data[0]; }
+  uint8_t length() const { return _data[1]; }
+
+  // fields behind the formatted area were added by later SMBIOS versions and are not present
+  bool has(size_t offset, size_t size) const { return offset + size <= length(); }
+
+  template <typename T>
+  T read(size_t offset, T fallback) const {
+    if (!has(offset, sizeof(T))) {
+      return fallback;
+    }
+    T value;
+    std::memcpy(&value, _data + offset, sizeof(T));
+    return value;
+  }
+
+  // the string referenced by the (1-based) index at offset, constants::UNKNOWN if it is not set
+  std::string string(size_t offset) const {
+    uint8_t index = read<uint8_t>(offset, 0);
+    if (index == 0) {
+      return constants::UNKNOWN;
+    }
+    for (const uint8_t* s = _strings; s < _end && *s != '\0';) {
+      const auto* terminator = static_cast<const uint8_t*>(std::memchr(s, '\0', _end - s));
+      if (terminator == nullptr) {
+        break;
+      }
+      if (--index == 0) {
+        std::string value(reinterpret_cast<const char*>(s), terminator - s);
+        strip(value);
+        return value.empty() ? constants::UNKNOWN : value;
+      }
+      s = terminator + 1;
+    }
+    return constants::UNKNOWN;
+  }
+
+ private:
+  const uint8_t* _data;
+  const uint8_t* _strings;
+  const uint8_t* _end;
+};
+
+MemoryDevice parseMemoryDevice(const Structure& s) {
+  MemoryDevice device;
+  device.locator = s.string(0x10);
+  device.bank_locator = s.string(0x11);
+  device.manufacturer = s.string(0x17);
+  device.serial_number = s.string(0x18);
+  device.part_number = s.string(0x1A);
+
+  const uint16_t size = s.read<uint16_t>(0x0C, 0xFFFF);
+  if (size == 0x7FFF) {
+    // 32 GiB and more: extended size in MiB
+    const uint32_t extended = s.read<uint32_t>(0x1C, 0);
+    device.size_Bytes = static_cast<int64_t>(extended & 0x7FFFFFFF) << 20;
+  } else if (size != 0xFFFF) {
+    // bit 15 selects KiB instead of MiB
+    device.size_Bytes = (size & 0x8000) ? static_cast<int64_t>(size & 0x7FFF) << 10 : static_cast<int64_t>(size) << 20;
+  }
+
+  const auto speed = [&s](size_t offset, size_t extended_offset) -> int64_t {
+    const uint16_t value = s.read<uint16_t>(offset, 0);
+    if (value == 0xFFFF) {
+      const uint32_t extended = s.read<uint32_t>(extended_offset, 0);
+      return extended != 0 ? static_cast<int64_t>(extended) : -1;
+    }
+    return value != 0 ? static_cast<int64_t>(value) : -1;
+  };
+  device.speed_MTs = speed(0x15, 0x54);
+  device.configured_speed_MTs = speed(0x20, 0x58);
+  return device;
+}
+
+Processor parseProcessor(const Structure& s) {
+  Processor processor;
+  processor.socket = s.string(0x04);
+  processor.manufacturer = s.string(0x07);
+  processor.version = s.string(0x10);
+  const uint16_t max_speed = s.read<uint16_t>(0x14, 0);
+  const uint16_t current_speed = s.read<uint16_t>(0x16, 0);
+  processor.max_speed_MHz = max_speed != 0 ? max_speed : -1;
+  processor.current_speed_MHz = current_speed != 0 ? current_speed : -1;
+  processor.populated = (s.read<uint8_t>(0x18, 0) & 0x40) != 0;
+
+  // counts above 254 are stored in the 16 bit fields added with SMBIOS 3.0
+  const uint8_t cores = s.read<uint8_t>(0x23, 0);
+  const uint8_t threads = s.read<uint8_t>(0x25, 0);
+  const int cores2 = s.read<uint16_t>(0x2A, 0);
+  const int threads2 = s.read<uint16_t>(0x2E, 0);
+  processor.num_cores = cores == 0xFF && cores2 > 0 ? cores2 : (cores != 0 ? cores : -1);
+  processor.num_threads = threads == 0xFF && threads2 > 0 ? threads2 : (threads != 0 ? threads : -1);
+  return processor;
+}
+
+Baseboard parseBaseboard(const Structure& s) {
+  Baseboard board;
+  board.manufacturer = s.string(0x04);
+  board.product = s.string(0x05);
+  board.version = s.string(0x06);
+  board.serial_number = s.string(0x07);
+  return board;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+Tables parse(const uint8_t* data, size_t size) {
+  Tables tables;
+  const uint8_t* const end = data + size;
+  const uint8_t* p = data;
+  // every structure has a 4 byte header (type, length, handle)
+  while (end - p >= 4 && p[1] >= 4 && end - p >= p[1]) {
+    const uint8_t* strings = p + p[1];
+    // the string set ends with two null bytes (also if it is empty)
+    const uint8_t* next = strings;
+    while (end - next >= 2 && !(next[0] == '\0' && next[1] == '\0')) {
+      ++next;
+    }
+    if (end - next < 2) {
+      break;
+    }
+    const Structure structure(p, strings, next + 1);
+    switch (structure.type()) {
+      case type_memory_device:
+        tables.memory_devices.push_back(parseMemoryDevice(structure));
+        break;
+      case type_processor:
+        tables.processors.push_back(parseProcessor(structure));
+        break;
+      case type_baseboard:
+        tables.baseboards.push_back(parseBaseboard(structure));
+        break;
+      default:
+        break;
+    }
+    if (structure.type() == type_end_of_table) {
+      break;
+    }
+    p = next + 2;
+  }
+  return tables;
+}
+
+// _____________________________________________________________________________________________________________________
+const Tables& tables() {
+  // function local statics are initialized thread-safe
+  static const Tables tables = [] {
+    const auto raw = read_table();
+    return parse(raw.data(), raw.size());
+  }();
+  return tables;
+}
+
+}  // namespace SMBIOS
+}  // namespace utils
+}  // namespace hwinfo
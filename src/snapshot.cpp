@@ -0,0 +1,67 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "hwinfo/utils/instrumentation.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+Snapshot collect(const Options& options) {
+  HWINFO_PROBE("snapshot.collect");
+  Snapshot snapshot;
+  // every task writes a distinct member of snapshot, no synchronization needed
+  std::vector<std::function<void()>> tasks;
+  if (options.cpu) tasks.emplace_back([&] { snapshot.cpus = getAllCPUs(); });
+  if (options.os) tasks.emplace_back([&] { snapshot.os.emplace(); });
+  if (options.gpu) tasks.emplace_back([&] { snapshot.gpus = getAllGPUs(options.gpu_opencl); });
+  if (options.ram) tasks.emplace_back([&] { snapshot.ram.emplace(options.ram_fields); });
+  if (options.mainboard) tasks.emplace_back([&] { snapshot.mainboard.emplace(); });
+  if (options.battery) tasks.emplace_back([&] { snapshot.batteries = getAllBatteries(); });
+  if (options.disk) tasks.emplace_back([&] { snapshot.disks = getAllDisks(options.disk_fields); });
+  if (options.network) tasks.emplace_back([&] { snapshot.networks = getAllNetworks(options.network_fields); });
+  if (options.monitor) tasks.emplace_back([&] { snapshot.monitors = getAllMonitors(); });
+  if (options.pci) tasks.emplace_back([&] { snapshot.pci_devices = getAllPCIDevices(); });
+
+  size_t num_threads = options.num_threads;
+  if (num_threads == 0) {
+    num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, tasks.size());
+
+  std::atomic<size_t> next_task{0};
+  const auto worker = [&] {
+    for (size_t i = next_task++; i < tasks.size(); i = next_task++) {
+      try {
+        tasks[i]();
+      } catch (...) {
+        // a failing subsystem (e.g. WMI not available) stays empty and does not affect the others
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads);
+  for (size_t i = 1; i < num_threads; ++i) {
+    try {
+      workers.emplace_back(worker);
+    } catch (...) {
+      // no further thread could be started (std::system_error), the running workers and this thread take its tasks
+      break;
+    }
+  }
+  // the calling thread works as well
+  worker();
+  for (auto& thread : workers) {
+    thread.join();
+  }
+  return snapshot;
+}
+
+}  // namespace hwinfo
@@ -0,0 +1,218 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/utils/stringutils.h"
+
+#include <algorithm>
+#include <charconv>
+#include <clocale>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hwinfo {
+namespace utils {
+
+// _____________________________________________________________________________________________________________________
+bool replaceOnce(std::string& input, const std::string& from, const std::string& to) {
+  size_t start_pos = input.find(from);
+
+  if (start_pos == std::string::npos) return false;
+
+  input.replace(start_pos, from.length(), to);
+
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void replaceAll(std::string& input, const char from, const char to) {
+  std::replace(input.begin(), input.end(), from, to);
+}
+
+// _____________________________________________________________________________________________________________________
+void strip(std::string& input) {
+  if (input.empty()) {
+    return;
+  }
+  // optimization for input size == 1
+  if (input.size() == 1) {
+    if (input[0] == ' ' || input[0] == '\t' || input[0] == '\n') {
+      input = "";
+      return;
+    } else {
+      return;
+    }
+  }
+  size_t start_index = 0;
+  while (true) {
+    char c = input[start_index];
+    if (c != ' ' && c != '\t' && c != '\n') {
+      break;
+    }
+    start_index++;
+  }
+  size_t end_index = input.size() - 1;
+  while (true) {
+    char c = input[end_index];
+    if (c != ' ' && c != '\t' && c != '\n') {
+      break;
+    }
+    end_index--;
+  }
+  if (end_index < start_index) {
+    input.assign("");
+    return;
+  }
+  input.assign(input.begin() + start_index, input.begin() + end_index + 1);
+}
+
+// _____________________________________________________________________________________________________________________
+unsigned count_substring(const std::string& input, const std::string& substring) {
+  unsigned occurrences = 0;
+  std::string::size_type shift = 0;
+  while ((shift = input.find(substring, shift)) != std::string::npos) {
+    occurrences++;
+    shift += substring.size();
+  }
+  return occurrences;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<std::string> split(const std::string& input, const std::string& delimiter) {
+  std::vector<std::string> result;
+  size_t shift = 0;
+  while (true) {
+    size_t match = input.find(delimiter, shift);
+    result.emplace_back(input.substr(shift, match - shift));
+    if (match == std::string::npos) {
+      break;
+    }
+    shift = match + delimiter.size();
+  }
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<std::string> split(const std::string& input, const char delimiter) {
+  std::vector<std::string> result;
+  size_t shift = 0;
+  while (true) {
+    size_t match = input.find(delimiter, shift);
+    if (match == std::string::npos) {
+      break;
+    }
+    result.emplace_back(input.substr(shift, match - shift));
+    shift = match + 1;
+  }
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+std::string split_get_index(const std::string& input, const std::string& delimiter, int index) {
+  unsigned occ = count_substring(input, delimiter) + 1;
+  index = index < 0 ? static_cast<int>(occ + index) : index;
+  if (static_cast<int>(occ) <= index) {
+    return "";
+  }
+
+  std::string::size_type start_index = 0;
+  while (true) {
+    if (index == 0) {
+      break;
+    }
+    start_index = input.find(delimiter, start_index) + delimiter.size();
+    index--;
+  }
+  std::string::size_type end_index = input.find(delimiter, start_index);
+  if (end_index == std::string::npos) {
+    return {input.begin() + static_cast<int64_t>(start_index), input.end()};
+  }
+  return {input.begin() + static_cast<int64_t>(start_index), input.begin() + static_cast<int64_t>(end_index)};
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<int> parseCpuList(std::string_view list) {
+  std::vector<int> cpus;
+  while (const auto first = consumeNumber<int>(list)) {
+    int last = *first;
+    if (consumePrefix(list, "-")) {
+      last = consumeNumber<int>(list).value_or(*first);
+    }
+    for (int cpu = *first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+    if (!consumePrefix(list, ",")) {
+      break;
+    }
+  }
+  return cpus;
+}
+
+// _____________________________________________________________________________________________________________________
+size_t formatDouble(double value, char* buffer, size_t size) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  const auto result = std::to_chars(buffer, buffer + size, value);
+  if (result.ec != std::errc()) {
+    return 0;
+  }
+  return static_cast<size_t>(result.ptr - buffer);
+#else
+  // no std::to_chars for double (e.g. Apple clang): snprintf() writes the decimal point of LC_NUMERIC, replace it
+  const int length = std::snprintf(buffer, size, "%.17g", value);
+  if (length < 0 || static_cast<size_t>(length) >= size) {
+    return 0;
+  }
+  const std::string_view point = std::localeconv()->decimal_point;
+  if (!point.empty() && point != ".") {
+    char* found = std::search(buffer, buffer + length, point.begin(), point.end());
+    if (found != buffer + length) {
+      *found = '.';
+      std::memmove(found + 1, found + point.size(), static_cast<size_t>(buffer + length - found) - point.size());
+      return static_cast<size_t>(length) - point.size() + 1;
+    }
+  }
+  return static_cast<size_t>(length);
+#endif
+}
+
+// _____________________________________________________________________________________________________________________
+std::string wstring_to_string() { return ""; }
+
+// _____________________________________________________________________________________________________________________
+std::string wstring_to_std_string(const std::wstring& ws) {
+  std::string str_locale = std::setlocale(LC_ALL, "");
+  const wchar_t* wch_src = ws.c_str();
+
+#ifdef _MSC_VER
+  size_t n_dest_size;
+  wcstombs_s(&n_dest_size, nullptr, 0, wch_src, 0);
+  n_dest_size++;  // Increase by one for null terminator
+
+  char* ch_dest = new char[n_dest_size];
+  memset(ch_dest, 0, n_dest_size);
+
+  size_t n_convert_size;
+  wcstombs_s(&n_convert_size, ch_dest, n_dest_size, wch_src,
+             n_dest_size - 1);  // subtract one to ignore null terminator
+
+  std::string result_text = ch_dest;
+  delete[] ch_dest;
+#else
+  size_t n_dest_size = std::wcstombs(NULL, wch_src, 0) + 1;
+  char* ch_dest = new char[n_dest_size];
+  std::memset(ch_dest, 0, n_dest_size);
+  std::wcstombs(ch_dest, wch_src, n_dest_size);
+  std::string result_text = ch_dest;
+  delete[] ch_dest;
+#endif
+
+  std::setlocale(LC_ALL, str_locale.c_str());
+  return result_text;
+}
+
+}  // namespace utils
+}  // namespace hwinfo
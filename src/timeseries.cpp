@@ -0,0 +1,463 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/timeseries.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace hwinfo {
+
+namespace {
+
+int leadingZeros(uint64_t x) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse64(&index, x);
+  return 63 - static_cast<int>(index);
+#else
+  return __builtin_clzll(x);
+#endif
+}
+
+int trailingZeros(uint64_t x) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(x);
+#endif
+}
+
+uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+
+int64_t unzigzag(uint64_t value) { return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1)); }
+
+// Counter values: rounded and saturated, std::llround() is unspecified outside of the int64_t range
+uint64_t counterBits(double value) {
+  constexpr double limit = 9223372036854775808.0;  // 2^63
+  if (std::isnan(value)) {
+    return 0;
+  }
+  if (value >= limit) {
+    return static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+  }
+  if (value <= -limit) {
+    return static_cast<uint64_t>(std::numeric_limits<int64_t>::min());
+  }
+  return static_cast<uint64_t>(std::llround(value));
+}
+
+uint64_t doubleBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double bitsDouble(uint64_t bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// appends the lowest n bits of value, most significant bit first
+void writeBits(std::vector<uint64_t>& words, uint64_t& num_bits, uint64_t value, int n) {
+  if (n == 0) {
+    return;
+  }
+  if (n < 64) {
+    value &= (uint64_t{1} << n) - 1;
+  }
+  const int offset = static_cast<int>(num_bits % 64);
+  if (offset == 0) {
+    words.push_back(0);
+  }
+  const int free = 64 - offset;
+  if (n <= free) {
+    words.back() |= value << (free - n);
+  } else {
+    words.back() |= value >> (n - free);
+    words.push_back(value << (64 - (n - free)));
+  }
+  num_bits += n;
+}
+
+struct BitReader {
+  const uint64_t* words;
+  uint64_t position{0};
+
+  uint64_t read(int n) {
+    if (n == 0) {
+      return 0;
+    }
+    const uint64_t* word = words + position / 64;
+    const int offset = static_cast<int>(position % 64);
+    const int available = 64 - offset;
+    position += n;
+    if (n <= available) {
+      return (word[0] << offset) >> (64 - n);
+    }
+    // the value continues in the next word
+    const uint64_t high = (word[0] << offset) >> offset;
+    return (high << (n - available)) | (word[1] >> (64 - (n - available)));
+  }
+};
+
+// delta-of-delta: '0' for zero, otherwise a prefix selecting a 7, 9, 12, 32 or 64 bit zigzag encoded value
+void writeDelta(std::vector<uint64_t>& words, uint64_t& num_bits, int64_t delta) {
+  const uint64_t value = zigzag(delta);
+  if (value == 0) {
+    writeBits(words, num_bits, 0b0, 1);
+  } else if (value < (uint64_t{1} << 7)) {
+    writeBits(words, num_bits, 0b10, 2);
+    writeBits(words, num_bits, value, 7);
+  } else if (value < (uint64_t{1} << 9)) {
+    writeBits(words, num_bits, 0b110, 3);
+    writeBits(words, num_bits, value, 9);
+  } else if (value < (uint64_t{1} << 12)) {
+    writeBits(words, num_bits, 0b1110, 4);
+    writeBits(words, num_bits, value, 12);
+  } else if (value < (uint64_t{1} << 32)) {
+    writeBits(words, num_bits, 0b11110, 5);
+    writeBits(words, num_bits, value, 32);
+  } else {
+    writeBits(words, num_bits, 0b11111, 5);
+    writeBits(words, num_bits, value, 64);
+  }
+}
+
+int64_t readDelta(BitReader& reader) {
+  if (reader.read(1) == 0) {
+    return 0;
+  }
+  static constexpr int widths[] = {7, 9, 12, 32};
+  for (const int width : widths) {
+    if (reader.read(1) == 0) {
+      return unzigzag(reader.read(width));
+    }
+  }
+  return unzigzag(reader.read(64));
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+SeriesAggregate aggregate(const double* values, size_t count) {
+  SeriesAggregate result;
+  if (count == 0) {
+    return result;
+  }
+  // four independent accumulators break the dependency chain of the reduction
+  double mins[4] = {values[0], values[0], values[0], values[0]};
+  double maxs[4] = {values[0], values[0], values[0], values[0]};
+  double sums[4] = {0.0, 0.0, 0.0, 0.0};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    for (int j = 0; j < 4; ++j) {
+      const double value = values[i + j];
+      mins[j] = value < mins[j] ? value : mins[j];
+      maxs[j] = value > maxs[j] ? value : maxs[j];
+      sums[j] += value;
+    }
+  }
+  for (; i < count; ++i) {
+    mins[0] = values[i] < mins[0] ? values[i] : mins[0];
+    maxs[0] = values[i] > maxs[0] ? values[i] : maxs[0];
+    sums[0] += values[i];
+  }
+  result.count = count;
+  result.min = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+  result.max = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+  result.mean = ((sums[0] + sums[1]) + (sums[2] + sums[3])) / static_cast<double>(count);
+
+  // nearest rank, each nth_element only partitions the part above the previous percentile
+  std::vector<double> sorted(values, values + count);
+  const auto rank = [count](double p) {
+    const auto index = static_cast<size_t>(std::ceil(p * static_cast<double>(count)));
+    return index == 0 ? 0 : std::min(index, count) - 1;
+  };
+  size_t begin = 0;
+  double* percentiles[] = {&result.p50, &result.p90, &result.p99};
+  const double ranks[] = {0.5, 0.9, 0.99};
+  for (int j = 0; j < 3; ++j) {
+    const size_t index = rank(ranks[j]);
+    if (index >= begin) {
+      std::nth_element(sorted.begin() + static_cast<std::ptrdiff_t>(begin),
+                       sorted.begin() + static_cast<std::ptrdiff_t>(index), sorted.end());
+      begin = index + 1;
+    }
+    *percentiles[j] = sorted[index];
+  }
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+TimeSeries::TimeSeries(Encoding encoding) : _encoding(encoding) {}
+
+// _____________________________________________________________________________________________________________________
+void TimeSeries::append(int64_t timestamp_ms, double value) {
+  if (_blocks.empty() || _blocks.back().count == block_size) {
+    // every block starts with raw values and can be decoded on its own
+    _blocks.emplace_back();
+    Block& block = _blocks.back();
+    block.first_timestamp_ms = timestamp_ms;
+    _state = State{};
+    _state.timestamp_ms = timestamp_ms;
+    writeBits(block.bits, block.num_bits, static_cast<uint64_t>(timestamp_ms), 64);
+    if (_encoding == Encoding::Gauge) {
+      _state.value_bits = doubleBits(value);
+      writeBits(block.bits, block.num_bits, _state.value_bits, 64);
+    } else {
+      _state.counter = counterBits(value);
+      writeBits(block.bits, block.num_bits, _state.counter, 64);
+    }
+  } else {
+    Block& block = _blocks.back();
+    const int64_t delta_ms = timestamp_ms - _state.timestamp_ms;
+    writeDelta(block.bits, block.num_bits, delta_ms - _state.delta_ms);
+    _state.timestamp_ms = timestamp_ms;
+    _state.delta_ms = delta_ms;
+    if (_encoding == Encoding::Gauge) {
+      // XOR with the previous value: '0' if equal, '10' + the meaningful bits if they fit into the previous window,
+      // '11' + 5 bit leading zeros + 6 bit length + the meaningful bits otherwise
+      const uint64_t bits = doubleBits(value);
+      const uint64_t x = bits ^ _state.value_bits;
+      _state.value_bits = bits;
+      if (x == 0) {
+        writeBits(block.bits, block.num_bits, 0b0, 1);
+      } else {
+        const int leading = std::min(leadingZeros(x), 31);
+        const int trailing = trailingZeros(x);
+        if (_state.leading >= 0 && leading >= _state.leading && trailing >= _state.trailing) {
+          writeBits(block.bits, block.num_bits, 0b10, 2);
+          writeBits(block.bits, block.num_bits, x >> _state.trailing, 64 - _state.leading - _state.trailing);
+        } else {
+          const int meaningful = 64 - leading - trailing;
+          writeBits(block.bits, block.num_bits, 0b11, 2);
+          writeBits(block.bits, block.num_bits, static_cast<uint64_t>(leading), 5);
+          // 64 meaningful bits are stored as 0
+          writeBits(block.bits, block.num_bits, static_cast<uint64_t>(meaningful & 63), 6);
+          writeBits(block.bits, block.num_bits, x >> trailing, meaningful);
+          _state.leading = leading;
+          _state.trailing = trailing;
+        }
+      }
+    } else {
+      const uint64_t counter = counterBits(value);
+      const uint64_t counter_delta = counter - _state.counter;
+      writeDelta(block.bits, block.num_bits, static_cast<int64_t>(counter_delta - _state.counter_delta));
+      _state.counter = counter;
+      _state.counter_delta = counter_delta;
+    }
+  }
+  Block& block = _blocks.back();
+  block.last_timestamp_ms = timestamp_ms;
+  ++block.count;
+  ++_size;
+}
+
+// _____________________________________________________________________________________________________________________
+size_t TimeSeries::decode(int64_t from_ms, int64_t to_ms, std::vector<int64_t>& timestamps_ms,
+                          std::vector<double>& values) const {
+  size_t count = 0;
+  for (const auto& block : _blocks) {
+    if (block.last_timestamp_ms < from_ms) {
+      continue;
+    }
+    if (block.first_timestamp_ms >= to_ms) {
+      break;
+    }
+    BitReader reader{block.bits.data()};
+    auto timestamp_ms = static_cast<int64_t>(reader.read(64));
+    int64_t delta_ms = 0;
+    uint64_t value_bits = 0;
+    uint64_t counter = 0;
+    uint64_t counter_delta = 0;
+    int leading = 0;
+    int trailing = 0;
+    if (_encoding == Encoding::Gauge) {
+      value_bits = reader.read(64);
+    } else {
+      counter = reader.read(64);
+    }
+    for (uint32_t i = 0; i < block.count; ++i) {
+      if (i > 0) {
+        delta_ms += readDelta(reader);
+        timestamp_ms += delta_ms;
+        if (_encoding == Encoding::Gauge) {
+          if (reader.read(1) != 0) {
+            if (reader.read(1) != 0) {
+              leading = static_cast<int>(reader.read(5));
+              int meaningful = static_cast<int>(reader.read(6));
+              meaningful = meaningful == 0 ? 64 : meaningful;
+              trailing = 64 - leading - meaningful;
+            }
+            value_bits ^= reader.read(64 - leading - trailing) << trailing;
+          }
+        } else {
+          counter_delta += static_cast<uint64_t>(readDelta(reader));
+          counter += counter_delta;
+        }
+      }
+      if (timestamp_ms < from_ms) {
+        continue;
+      }
+      if (timestamp_ms >= to_ms) {
+        return count;
+      }
+      timestamps_ms.push_back(timestamp_ms);
+      values.push_back(_encoding == Encoding::Gauge ? bitsDouble(value_bits)
+                                                    : static_cast<double>(static_cast<int64_t>(counter)));
+      ++count;
+    }
+  }
+  return count;
+}
+
+// _____________________________________________________________________________________________________________________
+SeriesAggregate TimeSeries::aggregate(int64_t from_ms, int64_t to_ms) const {
+  std::vector<int64_t> timestamps_ms;
+  std::vector<double> values;
+  decode(from_ms, to_ms, timestamps_ms, values);
+  return hwinfo::aggregate(values.data(), values.size());
+}
+
+// _____________________________________________________________________________________________________________________
+void TimeSeries::dropBefore(int64_t timestamp_ms) {
+  // the last block holds the encoder state and is never dropped
+  while (_blocks.size() > 1 && _blocks.front().last_timestamp_ms < timestamp_ms) {
+    _size -= _blocks.front().count;
+    _blocks.pop_front();
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+TimeSeries::Encoding TimeSeries::encoding() const { return _encoding; }
+
+// _____________________________________________________________________________________________________________________
+size_t TimeSeries::size() const { return _size; }
+
+// _____________________________________________________________________________________________________________________
+int64_t TimeSeries::firstTimestamp_ms() const { return _blocks.empty() ? -1 : _blocks.front().first_timestamp_ms; }
+
+// _____________________________________________________________________________________________________________________
+int64_t TimeSeries::lastTimestamp_ms() const { return _blocks.empty() ? -1 : _blocks.back().last_timestamp_ms; }
+
+// _____________________________________________________________________________________________________________________
+size_t TimeSeries::memory_Bytes() const {
+  size_t bytes = 0;
+  for (const auto& block : _blocks) {
+    bytes += block.bits.size() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
+// _____________________________________________________________________________________________________________________
+TimeSeriesStore::TimeSeriesStore(std::chrono::milliseconds retention) : _retention(retention) {}
+
+// _____________________________________________________________________________________________________________________
+void TimeSeriesStore::append(const Record& record) {
+  const int64_t timestamp_ms = toTimestamp_ms(record.timestamp);
+  // utilisation and frequency records carry one value, the others four
+  const int num_values = record.metric == Metric::CpuUtilisation || record.metric == Metric::CpuFrequency ? 1 : 4;
+  for (int i = 0; i < num_values; ++i) {
+    if (record.values[i] < 0.0) {
+      continue;
+    }
+    const uint32_t series_key = key(record.metric, record.index, static_cast<uint8_t>(i));
+    auto& series = _series.emplace(series_key, encoding(record.metric)).first->second;
+    series.append(timestamp_ms, record.values[i]);
+    if (_retention.count() > 0) {
+      series.dropBefore(timestamp_ms - _retention.count());
+    }
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+const TimeSeries* TimeSeriesStore::series(Metric metric, uint16_t index, uint8_t value) const {
+  const auto it = _series.find(key(metric, index, value));
+  return it == _series.end() ? nullptr : &it->second;
+}
+
+// _____________________________________________________________________________________________________________________
+SeriesAggregate TimeSeriesStore::aggregate(Metric metric, uint16_t index, uint8_t value, TimePoint from,
+                                           TimePoint to) const {
+  const TimeSeries* column = series(metric, index, value);
+  if (column == nullptr) {
+    return {};
+  }
+  return column->aggregate(toTimestamp_ms(from), toTimestamp_ms(to));
+}
+
+// _____________________________________________________________________________________________________________________
+double TimeSeriesStore::rate(Metric metric, uint16_t index, uint8_t value, TimePoint from, TimePoint to) const {
+  const TimeSeries* column = series(metric, index, value);
+  if (column == nullptr) {
+    return -1.0;
+  }
+  std::vector<int64_t> timestamps_ms;
+  std::vector<double> values;
+  if (column->decode(toTimestamp_ms(from), toTimestamp_ms(to), timestamps_ms, values) < 2 ||
+      timestamps_ms.back() == timestamps_ms.front()) {
+    return -1.0;
+  }
+  double increase = 0.0;
+  for (size_t i = 1; i < values.size(); ++i) {
+    increase += values[i] >= values[i - 1] ? values[i] - values[i - 1] : values[i];
+  }
+  return increase * 1000.0 / static_cast<double>(timestamps_ms.back() - timestamps_ms.front());
+}
+
+// _____________________________________________________________________________________________________________________
+TimeSeries::Encoding TimeSeriesStore::encoding(Metric metric) {
+  switch (metric) {
+    case Metric::NetworkTotals:
+    case Metric::DiskIOTotals:
+    case Metric::ProcessTotals:
+      return TimeSeries::Encoding::Counter;
+    default:
+      return TimeSeries::Encoding::Gauge;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint16_t> TimeSeriesStore::indices(Metric metric) const {
+  std::vector<uint16_t> result;
+  const auto end = _series.upper_bound(key(metric, 0xffff, 0xff));
+  for (auto it = _series.lower_bound(key(metric, 0, 0)); it != end; ++it) {
+    const auto index = static_cast<uint16_t>((it->first >> 8) & 0xffff);
+    if (result.empty() || result.back() != index) {
+      result.push_back(index);
+    }
+  }
+  return result;
+}
+
+// _____________________________________________________________________________________________________________________
+size_t TimeSeriesStore::memory_Bytes() const {
+  size_t bytes = 0;
+  for (const auto& entry : _series) {
+    bytes += entry.second.memory_Bytes();
+  }
+  return bytes;
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t TimeSeriesStore::toTimestamp_ms(TimePoint time) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+// _____________________________________________________________________________________________________________________
+uint32_t TimeSeriesStore::key(Metric metric, uint16_t index, uint8_t value) {
+  return (static_cast<uint32_t>(metric) << 24) | (static_cast<uint32_t>(index) << 8) | value;
+}
+
+}  // namespace hwinfo
@@ -38,6 +38,20 @@ bool Battery::charging() const { return false; }
 // _____________________________________________________________________________________________________________________
 bool Battery::discharging() const { return false; }
 
+// _____________________________________________________________________________________________________________________
+double Battery::powerNow_W() const { return -1.0; }
+
+// _____________________________________________________________________________________________________________________
+bool Battery::refresh() {
+  if (_id < 0) {
+    return false;
+  }
+  _energyNow = energyNow();
+  _charging = charging();
+  _power_W = powerNow_W();
+  return true;
+}
+
 // =====================================================================================================================
 // _____________________________________________________________________________________________________________________
 std::vector<Battery> getAllBatteries() {
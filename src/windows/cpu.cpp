@@ -4,154 +4,584 @@
 #include "hwinfo/platform.h"
 
 #ifdef HWINFO_WINDOWS
+#include <Windows.h>
+#include <powerbase.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "hwinfo/cpu.h"
 #include "hwinfo/cpuid.h"
+#include "hwinfo/utils/pdh_wrapper.h"
 #include "hwinfo/utils/stringutils.h"
 #include "hwinfo/utils/wmi_wrapper.h"
 
+#pragma comment(lib, "PowrProf.lib")
+
 namespace hwinfo {
 
 // =====================================================================================================================
+namespace {
+
+// Fallback if PDH is not available: one WMI query per call. The instances are named "<group>,<number>" and
+// "<group>,_Total"/"_Total", the totals are skipped. The rows are not ordered, the value of "<group>,<number>" is
+// stored at index group * 64 + number like the logical CPUs of getCpuTopology().
+std::vector<double> query_processor_information(const std::wstring& field) {
+  const auto rows = utils::WMI::query_rows(L"Win32_PerfFormattedData_Counters_ProcessorInformation", {L"Name", field});
+  std::vector<double> values;
+  for (const auto& row : rows) {
+    const std::string name = utils::WMI::as_string(row[0], "");
+    std::string_view rest(name);
+    const auto group = utils::consumeNumber<int>(rest);
+    if (!group || !utils::consumePrefix(rest, ",")) {
+      continue;
+    }
+    const auto number = utils::toNumber<int>(rest);
+    if (!number || *group < 0 || *number < 0 || *number >= 64) {
+      continue;
+    }
+    const size_t cpu = static_cast<size_t>(*group) * 64 + static_cast<size_t>(*number);
+    if (cpu >= values.size()) values.resize(cpu + 1, -1.0);
+    values[cpu] = utils::WMI::as_double(row[1], -100.0) / 100.0;
+  }
+  return values;
+}
+
+// per logical processor relative performance ("% Processor Performance" / 100) of the calling thread's last sample
+std::vector<double> processor_performance() {
+  std::vector<double> performance;
+  auto* counters = utils::PDH::ProcessorCounters::get();
+  if (counters && counters->collect() && counters->performance(performance)) {
+    return performance;
+  }
+  return query_processor_information(L"PercentProcessorPerformance");
+}
+
+int64_t to_clock_speed(int64_t max_clock_speed_MHz, double performance) {
+  if (performance < 0) {
+    return -1;
+  }
+  return static_cast<int64_t>(static_cast<double>(max_clock_speed_MHz) * performance);
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+CPU::ClockSpeeds CPU::readClockSpeeds() const {
+  // getAllCPUs() sets the speeds from Win32_Processor
+  return {};
+}
+
 // _____________________________________________________________________________________________________________________
 int64_t CPU::currentClockSpeed_MHz(int thread_id) const {
-  auto data = utils::WMI::query<std::string>(L"Win32_PerfFormattedData_Counters_ProcessorInformation",
-                                             L"PercentProcessorPerformance");
-  if (data.empty()) {
+  const auto performance = processor_performance();
+  if (thread_id < 0 || static_cast<size_t>(thread_id) >= performance.size()) {
     return -1;
   }
-  double performance = std::stod(data[thread_id]) / 100;
-  return static_cast<int64_t>(static_cast<double>(_maxClockSpeed_MHz) * performance);
+  return to_clock_speed(maxClockSpeed_MHz(), performance[thread_id]);
 }
 
 // _____________________________________________________________________________________________________________________
 std::vector<int64_t> CPU::currentClockSpeed_MHz() const {
-  std::vector<int64_t> result;
-  result.reserve(_numLogicalCores);
-  auto data = utils::WMI::query<std::string>(L"Win32_PerfFormattedData_Counters_ProcessorInformation",
-                                             L"PercentProcessorPerformance");
-  if (data.empty()) {
-    result.resize(_numLogicalCores, -1);
-    return result;
+  const auto performance = processor_performance();
+  if (performance.empty()) {
+    return std::vector<int64_t>(_numLogicalCores, -1);
   }
-  for (auto& v : data) {
-    double performance = std::stod(v) / 100;
-    result.push_back(static_cast<int64_t>(static_cast<double>(_maxClockSpeed_MHz) * performance));
+  std::vector<int64_t> result;
+  result.reserve(performance.size());
+  const int64_t max_clock_speed_MHz = maxClockSpeed_MHz();
+  for (const double p : performance) {
+    result.push_back(to_clock_speed(max_clock_speed_MHz, p));
   }
   return result;
 }
 
+// _____________________________________________________________________________________________________________________
 double CPU::currentUtilisation() const {
-  auto res = utils::WMI::query<std::string>(L"Win32_PerfFormattedData_Counters_ProcessorInformation",
-                                            L"PercentProcessorUtility", L"Name=" + std::to_wstring(0) + L",_Total");
-  if (res.empty()) {
-    return -1.f;
+  const auto current = CpuSampler::snapshot();
+  if (current.empty()) {
+    return -1.0;
   }
-  return std::stod(res[0]);
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  _baseline.jiffies.resize(current.size());
+  const double utilisation = current[0].utilisation_since(_baseline.jiffies[0]);
+  _baseline.jiffies[0] = current[0];
+  return utilisation;
 }
 
+// _____________________________________________________________________________________________________________________
 double CPU::threadUtilisation(int thread_id) const {
-  auto data = utils::WMI::query<std::string>(L"Win32_PerfFormattedData_Counters_ProcessorInformation",
-                                             L"PercentProcessorUtility");
-  if (data.empty()) {
-    return -1.f;
-  }
-  std::string thread_value = data[thread_id];
-  if (thread_value.empty()) {
-    return -1.f;
+  const auto current = CpuSampler::snapshot();
+  if (thread_id < 0 || static_cast<size_t>(thread_id) + 1 >= current.size()) {
+    return -1.0;
   }
-  return std::stod(thread_value);
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  _baseline.jiffies.resize(current.size());
+  const double utilisation = current[thread_id + 1].utilisation_since(_baseline.jiffies[thread_id + 1]);
+  _baseline.jiffies[thread_id + 1] = current[thread_id + 1];
+  return utilisation;
 }
 
+// _____________________________________________________________________________________________________________________
 std::vector<double> CPU::threadsUtilisation() const {
-  std::vector<double> thread_utility;
-  thread_utility.reserve(_numLogicalCores);
-  auto data = utils::WMI::query<std::string>(L"Win32_PerfFormattedData_Counters_ProcessorInformation",
-                                             L"PercentProcessorUtility");
-  if (data.empty()) {
-    thread_utility.resize(_numLogicalCores, -1.f);
-    return thread_utility;
-  }
-  for (const auto& v : data) {
-    if (v.empty()) {
-      thread_utility.push_back(-1.f);
-    } else {
-      thread_utility.push_back(std::stod(v) / 100.f);
+  const auto current = CpuSampler::snapshot();
+  if (current.empty()) {
+    return std::vector<double>(_numLogicalCores, -1.0);
+  }
+  std::vector<double> utilisation;
+  utilisation.reserve(current.size() - 1);
+  std::lock_guard<std::mutex> lock(_baseline.mutex);
+  _baseline.jiffies.resize(current.size());
+  for (size_t i = 1; i < current.size(); ++i) {
+    utilisation.push_back(current[i].utilisation_since(_baseline.jiffies[i]));
+    _baseline.jiffies[i] = current[i];
+  }
+  return utilisation;
+}
+
+namespace {
+
+// documented for CallNtPowerInformation(ProcessorInformation, ...) but not declared in any SDK header
+struct ProcessorPowerInformation {
+  ULONG Number;
+  ULONG MaxMhz;
+  ULONG CurrentMhz;
+  ULONG MhzLimit;
+  ULONG MaxIdleState;
+  ULONG CurrentIdleState;
+};
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+FrequencySampler::FrequencySampler() {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  _last.resize(info.dwNumberOfProcessors);
+}
+
+// _____________________________________________________________________________________________________________________
+FrequencySampler::~FrequencySampler() = default;
+
+// _____________________________________________________________________________________________________________________
+size_t FrequencySampler::sample(int64_t* out_MHz, size_t size) {
+  // TODO: effective frequency from the "% Processor Performance" counter of the Processor Information PDH object
+  thread_local std::vector<ProcessorPowerInformation> power;
+  power.resize(_last.size());
+  const auto bytes = static_cast<ULONG>(power.size() * sizeof(ProcessorPowerInformation));
+  const bool ok = CallNtPowerInformation(ProcessorInformation, nullptr, 0, power.data(), bytes) == 0;
+  for (size_t cpu = 0; cpu < std::min(size, _last.size()); ++cpu) {
+    out_MHz[cpu] = ok ? static_cast<int64_t>(power[cpu].CurrentMhz) : -1;
+  }
+  return _last.size();
+}
+
+namespace {
+
+int64_t steadyTime_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+CpuSensors::CpuSensors() {
+  // the Energy Meter counters are opened once, the thermal zones are queried through the pooled WMI session
+  auto* meter = new utils::PDH::EnergyMeter();
+  _handle = reinterpret_cast<uintptr_t>(meter);
+  std::vector<int64_t> energy_uJ;
+  if (meter->valid()) {
+    meter->collect(energy_uJ);
+  }
+  // all thermal zones are reported as package 0, ACPI does not tell which zone belongs to which package
+  _packages.resize(std::max<size_t>(energy_uJ.size(), 1));
+  const int64_t now_ns = steadyTime_ns();
+  for (size_t package = 0; package < energy_uJ.size(); ++package) {
+    _packages[package].last_energy_uJ = energy_uJ[package];
+    _packages[package].last_time_ns = now_ns;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+CpuSensors::~CpuSensors() { delete reinterpret_cast<utils::PDH::EnergyMeter*>(_handle); }
+
+// _____________________________________________________________________________________________________________________
+double CpuSensors::packageTemperature_Celsius(int package) const {
+  if (package != 0) {
+    return -1.0;
+  }
+  namespace WMI = utils::WMI;
+  // temperatures are in tenths of Kelvin, the hottest zone is the closest to the package
+  double celsius = -1.0;
+  const auto update = [&](const WMI::Value& value) {
+    const int64_t decikelvin = WMI::as_int64(value, -1);
+    if (decikelvin > 0) celsius = std::max(celsius, static_cast<double>(decikelvin) / 10.0 - 273.15);
+  };
+  for (const auto& row :
+       WMI::query_rows(L"Win32_PerfFormattedData_Counters_ThermalZoneInformation", {L"HighPrecisionTemperature"})) {
+    update(row[0]);
+  }
+  if (celsius < 0.0) {
+    // the ACPI thermal zone class, readable by administrators only
+    for (const auto& row :
+         WMI::query_rows(L"MSAcpi_ThermalZoneTemperature", {L"CurrentTemperature"}, L"", L"ROOT\\WMI")) {
+      update(row[0]);
     }
   }
-  return thread_utility;
+  return celsius;
+}
+
+// _____________________________________________________________________________________________________________________
+double CpuSensors::packagePower_W(int package) {
+  auto* meter = reinterpret_cast<utils::PDH::EnergyMeter*>(_handle);
+  if (package < 0 || static_cast<size_t>(package) >= _packages.size() || meter == nullptr || !meter->valid()) {
+    return -1.0;
+  }
+  std::vector<int64_t> energy_uJ;
+  if (!meter->collect(energy_uJ) || static_cast<size_t>(package) >= energy_uJ.size()) {
+    return -1.0;
+  }
+  auto& p = _packages[package];
+  const int64_t current_uJ = energy_uJ[package];
+  const int64_t now_ns = steadyTime_ns();
+  const int64_t delta_uJ = current_uJ - p.last_energy_uJ;
+  const bool valid = current_uJ >= 0 && p.last_energy_uJ >= 0 && now_ns > p.last_time_ns && delta_uJ >= 0;
+  const double power_W = valid ? static_cast<double>(delta_uJ) * 1000.0 / static_cast<double>(now_ns - p.last_time_ns)
+                               : -1.0;
+  p.last_energy_uJ = current_uJ;
+  p.last_time_ns = now_ns;
+  return power_W;
+}
+
+namespace {
+
+// SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION of winternl.h, all times in 100 ns
+struct ProcessorPerformanceInformation {
+  LARGE_INTEGER IdleTime;
+  // includes the idle, DPC and interrupt time
+  LARGE_INTEGER KernelTime;
+  LARGE_INTEGER UserTime;
+  LARGE_INTEGER DpcTime;
+  LARGE_INTEGER InterruptTime;
+  ULONG InterruptCount;
+};
+
+constexpr ULONG system_processor_performance_information = 8;
+
+using NtQuerySystemInformationFn = LONG(WINAPI*)(ULONG, PVOID, ULONG, PULONG);
+using NtQuerySystemInformationExFn = LONG(WINAPI*)(ULONG, PVOID, ULONG, PVOID, ULONG, PULONG);
+
+// ntdll exports both functions since Windows 7 but the SDK has no import library entries for them
+template <typename Fn>
+Fn ntdll(const char* name) {
+  const HMODULE module = GetModuleHandleW(L"ntdll.dll");
+  return module ? reinterpret_cast<Fn>(reinterpret_cast<void*>(GetProcAddress(module, name))) : nullptr;
+}
+
+/**
+ * The counters of the active processors of one processor group. NtQuerySystemInformation() without the group as input
+ * only reports the group of the calling thread, i.e. at most 64 logical processors.
+ */
+bool queryGroup(WORD group, std::vector<ProcessorPerformanceInformation>& out) {
+  static const auto query = ntdll<NtQuerySystemInformationFn>("NtQuerySystemInformation");
+  static const auto query_ex = ntdll<NtQuerySystemInformationExFn>("NtQuerySystemInformationEx");
+  out.resize(GetActiveProcessorCount(group));
+  if (out.empty()) {
+    return false;
+  }
+  const auto size = static_cast<ULONG>(out.size() * sizeof(ProcessorPerformanceInformation));
+  ULONG returned = 0;
+  LONG status = -1;
+  if (query_ex) {
+    USHORT input = group;
+    status = query_ex(system_processor_performance_information, &input, sizeof(input), out.data(), size, &returned);
+  } else if (query && group == 0) {
+    status = query(system_processor_performance_information, out.data(), size, &returned);
+  }
+  if (status < 0) {
+    return false;
+  }
+  out.resize(returned / sizeof(ProcessorPerformanceInformation));
+  return true;
+}
+
+Jiffies toJiffies(const ProcessorPerformanceInformation& info) {
+  const int64_t idle = info.IdleTime.QuadPart;
+  const int64_t kernel = info.KernelTime.QuadPart;
+  const int64_t user = info.UserTime.QuadPart;
+  Jiffies jiffies(kernel + user, kernel + user - idle);
+  jiffies.user = user;
+  jiffies.idle = idle;
+  jiffies.irq = info.InterruptTime.QuadPart;
+  jiffies.softirq = info.DpcTime.QuadPart;
+  jiffies.system = std::max<int64_t>(kernel - idle - jiffies.irq - jiffies.softirq, 0);
+  return jiffies;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+std::vector<Jiffies> CpuSampler::snapshot() {
+  // one system call per processor group for all its logical processors. Logical processor <number> of group <group> is
+  // stored at index group * 64 + number + 1 like the CPUs of getCpuTopology(), unused numbers keep default Jiffies.
+  thread_local std::vector<ProcessorPerformanceInformation> buffer;
+  std::vector<Jiffies> jiffies(1);
+  Jiffies& total = jiffies[0];
+  total.all = total.working = 0;
+  const WORD groups = GetActiveProcessorGroupCount();
+  for (WORD group = 0; group < groups; ++group) {
+    if (!queryGroup(group, buffer)) continue;
+    jiffies.resize(std::max(jiffies.size(), static_cast<size_t>(group) * 64 + buffer.size() + 1));
+    for (size_t number = 0; number < buffer.size(); ++number) {
+      const Jiffies cpu = toJiffies(buffer[number]);
+      jiffies[static_cast<size_t>(group) * 64 + number + 1] = cpu;
+      total.all += cpu.all;
+      total.working += cpu.working;
+      total.user += cpu.user;
+      total.system += cpu.system;
+      total.idle += cpu.idle;
+      total.irq += cpu.irq;
+      total.softirq += cpu.softirq;
+    }
+  }
+  if (jiffies.size() == 1) {
+    return {};
+  }
+  return jiffies;
 }
 
 // =====================================================================================================================
 // _____________________________________________________________________________________________________________________
 std::vector<CPU> getAllCPUs() {
-  utils::WMI::_WMI wmi;
-  const std::wstring query_string(
-      L"SELECT Name, Manufacturer, NumberOfCores, NumberOfLogicalProcessors, MaxClockSpeed, L2CacheSize, L3CacheSize "
-      L"FROM Win32_Processor");
-  bool success = wmi.execute_query(query_string);
-  if (!success) {
+  namespace WMI = utils::WMI;
+  // cache sizes are reported per cache level, not per socket: query them once for all sockets, concurrently to the
+  // processor query
+  auto cache_rows = WMI::query_rows_async(L"Win32_CacheMemory", {L"MaxCacheSize"});
+  const auto rows = WMI::query_rows(L"Win32_Processor", {L"Name", L"Manufacturer", L"NumberOfCores",
+                                                         L"NumberOfLogicalProcessors", L"MaxClockSpeed"});
+  if (rows.empty()) {
     return {};
   }
-  std::vector<CPU> cpus;
+  std::vector<int64_t> cache_sizes;
+  for (const auto& row : cache_rows.get()) {
+    cache_sizes.push_back(WMI::as_int64(row[0], -1));
+  }
 
-  ULONG u_return = 0;
-  IWbemClassObject* obj = nullptr;
+  std::vector<CPU> cpus;
   int cpu_id = 0;
-  while (wmi.enumerator) {
-    wmi.enumerator->Next(WBEM_INFINITE, 1, &obj, &u_return);
-    if (!u_return) {
-      break;
-    }
+  for (const auto& row : rows) {
     CPU cpu;
     cpu._id = cpu_id++;
-    VARIANT vt_prop;
-    HRESULT hr;
-    hr = obj->Get(L"Name", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      cpu._modelName = utils::wstring_to_std_string(vt_prop.bstrVal);
+    cpu._modelName = WMI::as_string(row[0], cpu._modelName);
+    cpu._vendor = WMI::as_string(row[1], cpu._vendor);
+    cpu._numPhysicalCores = static_cast<int>(WMI::as_int64(row[2], cpu._numPhysicalCores));
+    cpu._numLogicalCores = static_cast<int>(WMI::as_int64(row[3], cpu._numLogicalCores));
+    // part of the same WMI row, no reason to defer it
+    const int64_t max_clock_speed_MHz = WMI::as_int64(row[4], -1);
+    cpu._clockSpeeds.set({max_clock_speed_MHz, max_clock_speed_MHz});
+    if (cache_sizes.size() >= 3) {
+      cpu._L1CacheSize_Bytes = cache_sizes[0];
+      cpu._L2CacheSize_Bytes = cache_sizes[1];
+      cpu._L3CacheSize_Bytes = cache_sizes[2];
+    } else {
+      cpu._L1CacheSize_Bytes = cpu._L2CacheSize_Bytes = cpu._L3CacheSize_Bytes = -1;
     }
-    hr = obj->Get(L"Manufacturer", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      cpu._vendor = utils::wstring_to_std_string(vt_prop.bstrVal);
+    cpus.push_back(std::move(cpu));
+  }
+  return cpus;
+}
+
+// _____________________________________________________________________________________________________________________
+CpuBudget getEffectiveCpuBudget() {
+  CpuBudget budget;
+  DWORD_PTR process_mask = 0, system_mask = 0;
+  if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+    // the mask only covers the processor group of the process
+    for (int cpu = 0; cpu < static_cast<int>(sizeof(DWORD_PTR) * 8); ++cpu) {
+      if (process_mask & (static_cast<DWORD_PTR>(1) << cpu)) budget.allowed_cpus.push_back(cpu);
     }
-    hr = obj->Get(L"NumberOfCores", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_I4)) {
-      cpu._numPhysicalCores = vt_prop.intVal;
+  }
+  // CPU rate limit of the job object of the process (containers, sandboxes); fails if the process is in no job
+  JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rate{};
+  if (QueryInformationJobObject(nullptr, JobObjectCpuRateControlInformation, &rate, sizeof(rate), nullptr) &&
+      (rate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_ENABLE) &&
+      !(rate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_WEIGHT_BASED)) {
+    // rates are 1/100 percent of the cycles of all processors of the machine
+    const DWORD limit =
+        (rate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_MIN_MAX_RATE) ? DWORD{rate.MaxRate} : rate.CpuRate;
+    const DWORD processors = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    if (limit > 0 && processors > 0) {
+      budget.quota_cpus = static_cast<double>(limit) * static_cast<double>(processors) / 10000.0;
     }
-    hr = obj->Get(L"NumberOfLogicalProcessors", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_I4)) {
-      cpu._numLogicalCores = vt_prop.intVal;
+  }
+
+  int effective = static_cast<int>(budget.allowed_cpus.size());
+  if (budget.quota_cpus > 0) {
+    effective = std::min(effective, static_cast<int>(std::ceil(budget.quota_cpus)));
+  }
+  budget.effective_cpus = std::max(effective, 1);
+  return budget;
+}
+
+namespace {
+
+// logical CPU numbers of a group affinity, numbered group * 64 + bit like the CPU sets of the Windows scheduler
+void appendCpus(const GROUP_AFFINITY& affinity, std::vector<int>& cpus) {
+  for (int bit = 0; bit < static_cast<int>(sizeof(KAFFINITY) * 8); ++bit) {
+    if (affinity.Mask & (static_cast<KAFFINITY>(1) << bit)) cpus.push_back(affinity.Group * 64 + bit);
+  }
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+CpuTopology getCpuTopology() {
+  CpuTopology topology;
+  DWORD size = 0;
+  GetLogicalProcessorInformationEx(RelationAll, nullptr, &size);
+  if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+    return topology;
+  }
+  std::vector<char> buffer(size);
+  if (!GetLogicalProcessorInformationEx(
+          RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &size)) {
+    return topology;
+  }
+
+  // the records are not ordered by relationship: collect packages, cores and nodes first, then link them by CPU
+  std::vector<std::vector<int>> packages;
+  std::vector<std::vector<int>> cores;
+  // higher classes are faster, all cores have class 0 on CPUs with only one core type
+  std::vector<int> efficiency_classes;
+  for (DWORD offset = 0; offset < size;) {
+    const auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+    std::vector<int> cpus;
+    if (info->Relationship == RelationProcessorPackage) {
+      for (WORD group = 0; group < info->Processor.GroupCount; ++group) {
+        appendCpus(info->Processor.GroupMask[group], cpus);
+      }
+      packages.push_back(std::move(cpus));
+    } else if (info->Relationship == RelationProcessorCore) {
+      appendCpus(info->Processor.GroupMask[0], cpus);
+      cores.push_back(std::move(cpus));
+      efficiency_classes.push_back(info->Processor.EfficiencyClass);
+    } else if (info->Relationship == RelationNumaNode) {
+      CpuTopology::NumaNode node;
+      node.id = static_cast<int>(info->NumaNode.NodeNumber);
+      appendCpus(info->NumaNode.GroupMask, node.cpus);
+      topology.numa_nodes.push_back(std::move(node));
     }
-    hr = obj->Get(L"MaxClockSpeed", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_I4)) {
-      cpu._maxClockSpeed_MHz = vt_prop.uintVal;
-      cpu._regularClockSpeed_MHz = vt_prop.uintVal;
+    offset += info->Size;
+  }
+
+  int max_cpu = -1;
+  for (const auto& cpus : packages) {
+    if (!cpus.empty()) max_cpu = std::max(max_cpu, cpus.back());
+  }
+  topology.threads.resize(static_cast<size_t>(max_cpu + 1));
+  for (size_t package = 0; package < packages.size(); ++package) {
+    CpuTopology::Package entry;
+    entry.id = static_cast<int>(package);
+    // Windows does not report dies and clusters separately
+    entry.dies.emplace_back();
+    entry.dies.back().clusters.emplace_back();
+    topology.packages.push_back(std::move(entry));
+    for (const int cpu : packages[package]) {
+      topology.threads[cpu].package = static_cast<int>(package);
+      topology.threads[cpu].die = 0;
+      topology.threads[cpu].cluster = 0;
     }
-    VariantClear(&vt_prop);
-    obj->Release();
-    auto cache{[&]() -> void {
-      auto data = utils::WMI::query<std::uint32_t>(L"Win32_CacheMemory", L"MaxCacheSize");
-      if (data.empty()) {
-        cpu._L1CacheSize_Bytes = cpu._L2CacheSize_Bytes = cpu._L3CacheSize_Bytes = -1;
-      }
-      try {
-        cpu._L1CacheSize_Bytes = data.at(0);
-        cpu._L2CacheSize_Bytes = data.at(1);
-        cpu._L3CacheSize_Bytes = data.at(2);
-      } catch (const std::exception& e) {
-        std::cout << "Exception in CPU Cache: " << e.what() << '\n';
-      }
-    }};
-    cache();
-    cpus.push_back(std::move(cpu));
   }
-  return cpus;
+  std::vector<int> classes = efficiency_classes;
+  std::sort(classes.begin(), classes.end(), std::greater<>());
+  classes.erase(std::unique(classes.begin(), classes.end()), classes.end());
+  for (size_t core = 0; core < cores.size(); ++core) {
+    if (cores[core].empty() || static_cast<size_t>(cores[core].front()) >= topology.threads.size()) continue;
+    const int package = topology.threads[cores[core].front()].package;
+    if (package < 0) continue;
+    for (const int cpu : cores[core]) {
+      topology.threads[cpu].core = static_cast<int>(core);
+    }
+    const auto level = std::find(classes.begin(), classes.end(), efficiency_classes[core]) - classes.begin();
+    topology.packages[package].dies[0].clusters[0].cores.push_back(
+        {static_cast<int>(core), cores[core], static_cast<int>(level)});
+  }
+  topology.assignPerformanceLevels(static_cast<int>(classes.size()));
+  for (const auto& node : topology.numa_nodes) {
+    for (const int cpu : node.cpus) {
+      if (static_cast<size_t>(cpu) < topology.threads.size()) topology.threads[cpu].numa_node = node.id;
+    }
+    // TODO: total memory per node and the node distances (SLIT) are not exposed by user mode APIs
+  }
+  return topology;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<CacheInfo> getCacheHierarchy() {
+  std::vector<CacheInfo> caches;
+  DWORD size = 0;
+  GetLogicalProcessorInformationEx(RelationCache, nullptr, &size);
+  if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+    return caches;
+  }
+  std::vector<char> buffer(size);
+  if (!GetLogicalProcessorInformationEx(
+          RelationCache, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &size)) {
+    return caches;
+  }
+  for (DWORD offset = 0; offset < size;) {
+    const auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+    offset += info->Size;
+    const CACHE_RELATIONSHIP& relation = info->Cache;
+    if (relation.Type == CacheTrace) {
+      continue;
+    }
+    CacheInfo cache;
+    cache.level = relation.Level;
+    cache.type = relation.Type == CacheData          ? CacheInfo::Type::Data
+                 : relation.Type == CacheInstruction ? CacheInfo::Type::Instruction
+                                                     : CacheInfo::Type::Unified;
+    cache.size_Bytes = relation.CacheSize;
+    cache.line_size_Bytes = relation.LineSize;
+    cache.associativity = relation.Associativity == CACHE_FULLY_ASSOCIATIVE ? 0 : relation.Associativity;
+    if (cache.associativity > 0 && cache.line_size_Bytes > 0) {
+      cache.sets = cache.size_Bytes / (static_cast<int64_t>(cache.associativity) * cache.line_size_Bytes);
+    }
+    // TODO: caches spanning several processor groups (GroupCount > 1, Windows 11 SDK) only report the first group
+    appendCpus(relation.GroupMask, cache.shared_cpus);
+    caches.push_back(std::move(cache));
+  }
+  std::sort(caches.begin(), caches.end());
+  return caches;
+}
+
+#if !defined(HWINFO_X86)
+// _____________________________________________________________________________________________________________________
+CpuFeatures CpuFeatures::detect() {
+  CpuFeatures features;
+  // NEON and FP are mandatory for Windows on ARM64
+  features.set(Feature::NEON);
+  if (IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE)) {
+    features.set(Feature::ARM_AES);
+    features.set(Feature::ARM_PMULL);
+    features.set(Feature::ARM_SHA1);
+    features.set(Feature::ARM_SHA2);
+  }
+  if (IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE)) features.set(Feature::ARM_CRC32);
+  if (IsProcessorFeaturePresent(PF_ARM_V81_ATOMIC_INSTRUCTIONS_AVAILABLE)) features.set(Feature::ARM_ATOMICS);
+#ifdef PF_ARM_V82_DP_INSTRUCTIONS_AVAILABLE
+  if (IsProcessorFeaturePresent(PF_ARM_V82_DP_INSTRUCTIONS_AVAILABLE)) features.set(Feature::ARM_DOTPROD);
+#endif
+  return features;
 }
+#endif  // !HWINFO_X86
 
 }  // namespace hwinfo
 
@@ -4,298 +4,390 @@
 #include "hwinfo/platform.h"
 
 #ifdef HWINFO_WINDOWS
-
+// clang-format off
+#include <Windows.h>
+#include <winioctl.h>
+#include <SetupAPI.h>
+// clang-format on
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <future>
+#include <memory>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "hwinfo/disk.h"
+#include "hwinfo/utils/constants.h"
 #include "hwinfo/utils/stringutils.h"
-#include "hwinfo/utils/wmi_wrapper.h"
+
+#pragma comment(lib, "Setupapi.lib")
 
 namespace hwinfo {
 
-// -----------------------------------------------------------------------------
-// Extracts the actual device path from a WMI reference string
-// Example: "Win32_DiskDrive=\"\\\\.\\PHYSICALDRIVE0\"" → "\\\\.\\PHYSICALDRIVE0"
-// -----------------------------------------------------------------------------
-std::wstring extractDevicePath(const std::wstring& wmiRefString) {
-  size_t startPos = wmiRefString.find(L"\"");
-  if (startPos == std::wstring::npos) {
-    return wmiRefString;
+namespace {
+
+// {53F56307-B6BF-11D0-94F2-00A0C91EFB8B}
+constexpr GUID disk_interface = {0x53f56307, 0xb6bf, 0x11d0, {0x94, 0xf2, 0x00, 0xa0, 0xc9, 0x1e, 0xfb, 0x8b}};
+
+/**
+ * DeviceIoControl on a handle opened with FILE_FLAG_OVERLAPPED. start() only issues the request, so the requests of
+ * all drives and volumes are in flight at the same time and wait() collects them afterwards.
+ */
+class OverlappedIoctl {
+ public:
+  explicit OverlappedIoctl(size_t buffer_size) : _buffer(buffer_size) {
+    _overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
   }
-  size_t endPos = wmiRefString.rfind(L"\"");
-  if (endPos == std::wstring::npos || endPos <= startPos) {
-    return wmiRefString;
+  ~OverlappedIoctl() {
+    if (_pending) {
+      CancelIoEx(_handle, &_overlapped);
+      wait();
+    }
+    if (_overlapped.hEvent != nullptr) CloseHandle(_overlapped.hEvent);
   }
-  return wmiRefString.substr(startPos + 1, endPos - startPos - 1);
-}
+  OverlappedIoctl(const OverlappedIoctl&) = delete;
+  OverlappedIoctl& operator=(const OverlappedIoctl&) = delete;
 
-// -----------------------------------------------------------------------------
-// Normalize backslashes in paths to ensure consistent formatting
-// Example: "\\\\.\\PHYSICALDRIVE0" → "\\.\PHYSICALDRIVE0"
-// -----------------------------------------------------------------------------
-std::wstring normalizeBackslashes(const std::wstring& path) {
-  std::wstring result;
-  bool lastWasBackslash = false;
-
-  for (wchar_t c : path) {
-    if (c == L'\\') {
-      if (!lastWasBackslash) {
-        result.push_back(c);
-      }
-      lastWasBackslash = true;
-    } else {
-      result.push_back(c);
-      lastWasBackslash = false;
+  void start(HANDLE handle, DWORD code, const void* input = nullptr, DWORD input_size = 0) {
+    if (_overlapped.hEvent == nullptr) {
+      return;
+    }
+    _handle = handle;
+    if (DeviceIoControl(handle, code, const_cast<void*>(input), input_size, _buffer.data(),
+                        static_cast<DWORD>(_buffer.size()), nullptr, &_overlapped) ||
+        GetLastError() == ERROR_IO_PENDING || GetLastError() == ERROR_MORE_DATA) {
+      _pending = true;
     }
   }
-  return result;
-};
 
-std::unordered_map<std::wstring, std::wstring> getPartitionToLogicalMapping() {
-  utils::WMI::_WMI wmi;
-  ULONG u_return = 0;
-  IWbemClassObject* obj = nullptr;
-
-  std::unordered_map<std::wstring, std::wstring> partitionToLogical;
-
-  // -------------------------------------------------------------------------
-  // Map logical drives to partitions
-  // -------------------------------------------------------------------------
-  if (wmi.execute_query(L"SELECT Antecedent, Dependent FROM Win32_LogicalDiskToPartition")) {
-    while (wmi.enumerator) {
-      wmi.enumerator->Next(WBEM_INFINITE, 1, &obj, &u_return);
-      if (!u_return || obj == nullptr) {
-        break;
-      }
-
-      VARIANT vtPartition, vtLogical;
-      VariantInit(&vtPartition);
-      VariantInit(&vtLogical);
-
-      if (SUCCEEDED(obj->Get(L"Antecedent", 0, &vtPartition, nullptr, nullptr)) &&
-          SUCCEEDED(obj->Get(L"Dependent", 0, &vtLogical, nullptr, nullptr))) {
-        if (V_VT(&vtPartition) == VT_BSTR && V_VT(&vtLogical) == VT_BSTR) {
-          std::wstring logicalDrive = vtLogical.bstrVal;
-          size_t startPos = logicalDrive.find(L"\"");
-          size_t endPos = logicalDrive.rfind(L"\"");
-
-          if (startPos != std::wstring::npos && endPos > startPos) {
-            partitionToLogical[vtPartition.bstrVal] = logicalDrive.substr(startPos + 1, endPos - startPos - 1);
-          }
-        }
-      }
-      VariantClear(&vtPartition);
-      VariantClear(&vtLogical);
-      obj->Release();
+  // blocks until the request completed, returns false if it failed or was never started
+  bool wait() {
+    if (!_pending) {
+      return _ok;
     }
+    _pending = false;
+    DWORD bytes = 0;
+    // ERROR_MORE_DATA still fills the fixed part of variable length outputs (e.g. the first disk extent)
+    _ok = GetOverlappedResult(_handle, &_overlapped, &bytes, TRUE) || GetLastError() == ERROR_MORE_DATA;
+    return _ok;
   }
 
-  return partitionToLogical;
-}
-
-std::unordered_map<std::wstring, std::wstring> getDiskToPartitionMapping() {
-  utils::WMI::_WMI wmi;
-  ULONG u_return = 0;
-  IWbemClassObject* obj = nullptr;
-
-  std::unordered_map<std::wstring, std::wstring> partitionToDisk;
-
-  // -------------------------------------------------------------------------
-  // Map partitions to physical disks
-  // -------------------------------------------------------------------------
-  if (wmi.execute_query(L"SELECT Antecedent, Dependent FROM Win32_DiskDriveToDiskPartition")) {
-    while (wmi.enumerator) {
-      wmi.enumerator->Next(WBEM_INFINITE, 1, &obj, &u_return);
-      if (!u_return || obj == nullptr) {
-        break;
-      }
+  template <typename T>
+  const T* data() const {
+    return reinterpret_cast<const T*>(_buffer.data());
+  }
+  size_t size() const { return _buffer.size(); }
+
+ private:
+  OVERLAPPED _overlapped{};
+  HANDLE _handle{INVALID_HANDLE_VALUE};
+  bool _pending{false};
+  bool _ok{false};
+  std::vector<BYTE> _buffer;
+};
 
-      VARIANT vtDisk, vtPartition;
-      VariantInit(&vtDisk);
-      VariantInit(&vtPartition);
+struct HandleCloser {
+  void operator()(HANDLE handle) const { CloseHandle(handle); }
+};
+using UniqueHandle = std::unique_ptr<void, HandleCloser>;
+
+/**
+ * Opens a device without any access rights. Such handles only accept IOCTLs that the storage stack answers from its
+ * own state, so opening and querying the device never spins up a sleeping disk.
+ */
+UniqueHandle openDevice(const std::wstring& path) {
+  HANDLE handle = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_OVERLAPPED, nullptr);
+  return UniqueHandle(handle == INVALID_HANDLE_VALUE ? nullptr : handle);
+}
 
-      if (SUCCEEDED(obj->Get(L"Antecedent", 0, &vtDisk, nullptr, nullptr)) &&
-          SUCCEEDED(obj->Get(L"Dependent", 0, &vtPartition, nullptr, nullptr))) {
-        if (V_VT(&vtDisk) == VT_BSTR && V_VT(&vtPartition) == VT_BSTR) {
-          partitionToDisk[vtPartition.bstrVal] = extractDevicePath(vtDisk.bstrVal);
-        }
-      }
-      VariantClear(&vtDisk);
-      VariantClear(&vtPartition);
-      obj->Release();
+/**
+ * @brief Lists the device paths of all present disk interfaces with one SetupAPI enumeration.
+ */
+std::vector<std::wstring> getDiskInterfacePaths() {
+  std::vector<std::wstring> paths;
+  HDEVINFO device_info = SetupDiGetClassDevsW(&disk_interface, nullptr, nullptr, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+  if (device_info == INVALID_HANDLE_VALUE) {
+    return paths;
+  }
+  SP_DEVICE_INTERFACE_DATA interface_data{};
+  interface_data.cbSize = sizeof(interface_data);
+  std::vector<BYTE> detail_buffer;
+  for (DWORD i = 0; SetupDiEnumDeviceInterfaces(device_info, nullptr, &disk_interface, i, &interface_data); ++i) {
+    DWORD required = 0;
+    SetupDiGetDeviceInterfaceDetailW(device_info, &interface_data, nullptr, 0, &required, nullptr);
+    if (required == 0) {
+      continue;
+    }
+    detail_buffer.assign(required, 0);
+    auto* detail = reinterpret_cast<SP_DEVICE_INTERFACE_DETAIL_DATA_W*>(detail_buffer.data());
+    detail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_W);
+    if (SetupDiGetDeviceInterfaceDetailW(device_info, &interface_data, detail, required, nullptr, nullptr)) {
+      paths.emplace_back(detail->DevicePath);
     }
   }
-
-  return partitionToDisk;
+  SetupDiDestroyDeviceInfoList(device_info);
+  return paths;
 }
 
-// -----------------------------------------------------------------------------
-// Computes free space for each physical disk
-// Gathers mappings: logical drive → partition → physical disk
-// -----------------------------------------------------------------------------
-std::unordered_map<std::wstring, uint64_t> computePhysicalFreeSpace(
-    const std::unordered_map<std::wstring, std::wstring>& partitionToLogical,
-    const std::unordered_map<std::wstring, std::wstring>& partitionToDisk) {
-  utils::WMI::_WMI wmi;
-  ULONG u_return = 0;
-  IWbemClassObject* obj = nullptr;
-
-  // Maps for tracking relationships
-  std::unordered_map<std::wstring, uint64_t> logicalDriveToFree;
-
-  // -------------------------------------------------------------------------
-  // Read logical disk free space
-  // -------------------------------------------------------------------------
-  if (wmi.execute_query(L"SELECT DeviceID, FreeSpace FROM Win32_LogicalDisk")) {
-    while (wmi.enumerator) {
-      wmi.enumerator->Next(WBEM_INFINITE, 1, &obj, &u_return);
-      if (!u_return || obj == nullptr) {
-        break;
-      }
+// reads a string at offset in a STORAGE_DEVICE_DESCRIPTOR, offset 0 means the device does not report it
+std::string descriptorString(const OverlappedIoctl& query, DWORD offset) {
+  if (offset == 0 || offset >= query.size()) {
+    return constants::UNKNOWN;
+  }
+  const char* begin = query.data<char>() + offset;
+  std::string value(begin, strnlen(begin, query.size() - offset));
+  utils::strip(value);
+  return value.empty() ? constants::UNKNOWN : value;
+}
 
-      VARIANT vtDeviceID, vtFreeSpace;
-      VariantInit(&vtDeviceID);
-      VariantInit(&vtFreeSpace);
+// mount points (drive letters or folders, without the trailing backslash) of the volumes on one disk
+struct DiskMounts {
+  // one mount point per volume, used for the free space
+  std::vector<std::string> mount_points;
+  // all mount points
+  std::vector<std::string> volumes;
+};
 
-      if (SUCCEEDED(obj->Get(L"DeviceID", 0, &vtDeviceID, nullptr, nullptr)) &&
-          SUCCEEDED(obj->Get(L"FreeSpace", 0, &vtFreeSpace, nullptr, nullptr))) {
-        if (V_VT(&vtDeviceID) == VT_BSTR && V_VT(&vtFreeSpace) == VT_BSTR) {
-          logicalDriveToFree[vtDeviceID.bstrVal] = std::stoll(utils::wstring_to_std_string(vtFreeSpace.bstrVal));
-        }
+/**
+ * Maps disk numbers to the mount points of the volumes on them. The volume extents of all volumes are queried in
+ * parallel.
+ */
+std::unordered_map<DWORD, DiskMounts> getDiskMountPoints() {
+  struct Volume {
+    std::vector<std::string> mount_points;
+    UniqueHandle handle;
+    // room for a volume spanning 16 disks
+    OverlappedIoctl extents{sizeof(VOLUME_DISK_EXTENTS) + 15 * sizeof(DISK_EXTENT)};
+  };
+  std::vector<std::unique_ptr<Volume>> volumes;
+
+  wchar_t volume_name[MAX_PATH];
+  HANDLE find = FindFirstVolumeW(volume_name, MAX_PATH);
+  if (find == INVALID_HANDLE_VALUE) {
+    return {};
+  }
+  do {
+    auto volume = std::make_unique<Volume>();
+    // a volume can be mounted at several paths, unmounted volumes are skipped without being opened
+    wchar_t paths[4 * MAX_PATH];
+    DWORD length = 0;
+    if (GetVolumePathNamesForVolumeNameW(volume_name, paths, sizeof(paths) / sizeof(paths[0]), &length)) {
+      for (const wchar_t* path = paths; *path != L'\0'; path += wcslen(path) + 1) {
+        std::string mount_point = utils::wstring_to_std_string(path);
+        if (!mount_point.empty() && mount_point.back() == '\\') mount_point.pop_back();
+        volume->mount_points.push_back(std::move(mount_point));
       }
-      VariantClear(&vtDeviceID);
-      VariantClear(&vtFreeSpace);
-      obj->Release();
     }
-  }
-
-  // -------------------------------------------------------------------------
-  // Aggregate free space for each physical disk
-  // -------------------------------------------------------------------------
-  std::unordered_map<std::wstring, uint64_t> physicalDiskToFree;
-
-  for (const auto& [partitionName, logicalDriveName] : partitionToLogical) {
-    auto diskIter = partitionToDisk.find(partitionName);
-    if (diskIter != partitionToDisk.end()) {
-      auto freeIter = logicalDriveToFree.find(logicalDriveName);
-      if (freeIter != logicalDriveToFree.end()) {
-        physicalDiskToFree[diskIter->second] += freeIter->second;
+    if (volume->mount_points.empty()) {
+      continue;
+    }
+    // the volume device is the GUID path without the trailing backslash
+    std::wstring device(volume_name);
+    if (!device.empty() && device.back() == L'\\') device.pop_back();
+    volume->handle = openDevice(device);
+    if (!volume->handle) {
+      continue;
+    }
+    volume->extents.start(volume->handle.get(), IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS);
+    volumes.push_back(std::move(volume));
+  } while (FindNextVolumeW(find, volume_name, MAX_PATH));
+  FindVolumeClose(find);
+
+  std::unordered_map<DWORD, DiskMounts> disk_mounts;
+  for (auto& volume : volumes) {
+    if (!volume->extents.wait()) {
+      continue;
+    }
+    const auto* extents = volume->extents.data<VOLUME_DISK_EXTENTS>();
+    const DWORD count =
+        std::min<DWORD>(extents->NumberOfDiskExtents,
+                        static_cast<DWORD>((volume->extents.size() - offsetof(VOLUME_DISK_EXTENTS, Extents)) /
+                                           sizeof(DISK_EXTENT)));
+    for (DWORD i = 0; i < count; ++i) {
+      const DWORD disk = extents->Extents[i].DiskNumber;
+      // a volume can have several extents on the same disk
+      const auto same_disk = [disk](const DISK_EXTENT& extent) { return extent.DiskNumber == disk; };
+      if (std::any_of(extents->Extents, extents->Extents + i, same_disk)) {
+        continue;
       }
+      auto& mounts = disk_mounts[disk];
+      mounts.mount_points.push_back(volume->mount_points.front());
+      mounts.volumes.insert(mounts.volumes.end(), volume->mount_points.begin(), volume->mount_points.end());
     }
   }
-
-  return physicalDiskToFree;
+  return disk_mounts;
 }
 
-std::unordered_map<std::wstring, std::vector<std::string>> getDiskToLogicalDrivesMapping(
-    const std::unordered_map<std::wstring, std::wstring>& partitionToLogical,
-    const std::unordered_map<std::wstring, std::wstring>& partitionToDisk) {
-  std::unordered_map<std::wstring, std::vector<std::string>> diskToLogicalDrives;
-
-  for (const auto& [partitionName, logicalDriveName] : partitionToLogical) {
-    auto diskIter = partitionToDisk.find(partitionName);
-    if (diskIter != partitionToDisk.end()) {
-      // Normalize the disk path for consistent comparison
-      auto normalizedDiskPath = normalizeBackslashes(diskIter->second);
-      // Add this logical drive to the list for this disk
-      diskToLogicalDrives[normalizedDiskPath].push_back(utils::wstring_to_std_string(logicalDriveName));
-    }
+// free space of mount_point or -1, GetDiskFreeSpaceEx has no overlapped variant
+int64_t getFreeSpace_Bytes(const std::string& mount_point) {
+  ULARGE_INTEGER free_bytes;
+  if (GetDiskFreeSpaceExA((mount_point + "\\").c_str(), nullptr, nullptr, &free_bytes)) {
+    return static_cast<int64_t>(free_bytes.QuadPart);
   }
-
-  return diskToLogicalDrives;
+  return -1;
 }
 
-// _____________________________________________________________________________________________________________________
-std::vector<Disk> getAllDisks() {
-  utils::WMI::_WMI wmi;
-  const std::wstring query_string(L"SELECT Model, Manufacturer, SerialNumber, Size, DeviceID FROM Win32_DiskDrive");
+}  // namespace
 
-  if (!wmi.execute_query(query_string)) {
-    return {};
-  }
-
-  std::vector<Disk> disks;
-
-  // Get all mappings upfront
-  auto partitionToLogical = getPartitionToLogicalMapping();
-  auto partitionToDisk = getDiskToPartitionMapping();
-  auto physicalFreeSize = computePhysicalFreeSpace(partitionToLogical, partitionToDisk);
-  auto diskToLogicalDrives = getDiskToLogicalDrivesMapping(partitionToLogical, partitionToDisk);
-
-  ULONG u_return = 0;
-  IWbemClassObject* obj = nullptr;
-  int disk_id = 0;
+// _____________________________________________________________________________________________________________________
+Disk::Mounts Disk::resolveMounts() const {
+  // getAllDisks() sets the mounts of the disks it found in the volume enumeration
+  return {};
+}
 
-  while (wmi.enumerator) {
-    wmi.enumerator->Next(WBEM_INFINITE, 1, &obj, &u_return);
-    if (!u_return || obj == nullptr) {
-      break;
+// _____________________________________________________________________________________________________________________
+bool Disk::refresh() {
+  // one GetDiskFreeSpaceEx call per mount point
+  Mounts& mounts = _mounts.get([this] { return resolveMounts(); });
+  int64_t free_size = 0;
+  bool success = false;
+  for (const auto& mount_point : mounts.mount_points) {
+    const int64_t free_bytes = getFreeSpace_Bytes(mount_point);
+    if (free_bytes >= 0) {
+      free_size += free_bytes;
+      success = true;
     }
+  }
+  if (success) {
+    mounts.free_size_Bytes = free_size;
+  }
+  return success;
+}
 
-    Disk disk;
-    disk._id = disk_id++;
-
-    VARIANT vt_prop;
-    HRESULT hr;
-
-    hr = obj->Get(L"Model", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      disk._model = utils::wstring_to_std_string(vt_prop.bstrVal);
+// _____________________________________________________________________________________________________________________
+std::vector<Disk> getAllDisks(DiskFields fields) {
+  struct Drive {
+    UniqueHandle handle;
+    OverlappedIoctl number{sizeof(STORAGE_DEVICE_NUMBER)};
+    OverlappedIoctl descriptor{1024};
+    OverlappedIoctl geometry{sizeof(DISK_GEOMETRY_EX) + sizeof(DISK_PARTITION_INFO) + sizeof(DISK_DETECTION_INFO)};
+    BOOL powered_on{TRUE};
+  };
+  const bool need_identity = has_field(fields, DiskFields::Vendor | DiskFields::Model | DiskFields::Serial);
+  const bool need_mounts = has_field(fields, DiskFields::Free | DiskFields::Volumes);
+
+  // issue the requests of all drives first, then collect the results
+  std::vector<std::unique_ptr<Drive>> drives;
+  for (const auto& path : getDiskInterfacePaths()) {
+    auto drive = std::make_unique<Drive>();
+    drive->handle = openDevice(path);
+    if (!drive->handle) {
+      continue;
     }
-    VariantClear(&vt_prop);
-
-    hr = obj->Get(L"Manufacturer", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      disk._vendor = utils::wstring_to_std_string(vt_prop.bstrVal);
+    HANDLE handle = drive->handle.get();
+    // answered from the device power state the storage stack keeps track of, the disk is not touched
+    GetDevicePowerState(handle, &drive->powered_on);
+    drive->number.start(handle, IOCTL_STORAGE_GET_DEVICE_NUMBER);
+    if (need_identity) {
+      STORAGE_PROPERTY_QUERY query{};
+      query.PropertyId = StorageDeviceProperty;
+      query.QueryType = PropertyStandardQuery;
+      drive->descriptor.start(handle, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query));
     }
-    VariantClear(&vt_prop);
-
-    hr = obj->Get(L"SerialNumber", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      disk._serialNumber = utils::wstring_to_std_string(vt_prop.bstrVal);
+    // a disk that is spun down would have to spin up to answer the geometry request
+    if (has_field(fields, DiskFields::Capacity) && drive->powered_on) {
+      drive->geometry.start(handle, IOCTL_DISK_GET_DRIVE_GEOMETRY_EX);
     }
-    VariantClear(&vt_prop);
+    drives.push_back(std::move(drive));
+  }
+  // runs while the drive requests are in flight
+  const auto disk_mounts = need_mounts ? getDiskMountPoints() : std::unordered_map<DWORD, DiskMounts>{};
 
-    hr = obj->Get(L"Size", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      disk._size_Bytes = std::stoll(utils::wstring_to_std_string(vt_prop.bstrVal));
+  std::vector<Disk> disks;
+  disks.reserve(drives.size());
+  std::vector<bool> powered_on;
+  for (auto& drive : drives) {
+    if (!drive->number.wait()) {
+      continue;
     }
-    VariantClear(&vt_prop);
-
-    // Get device ID and match with pre-computed mappings
-    hr = obj->Get(L"DeviceID", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      auto deviceIdW = vt_prop.bstrVal;
-      auto normalizedDeviceId = normalizeBackslashes(deviceIdW);
-      VariantClear(&vt_prop);
-
-      // Look up logical drives for this disk
-      auto logicalDrivesIter = diskToLogicalDrives.find(normalizedDeviceId);
-      if (logicalDrivesIter != diskToLogicalDrives.end()) {
-        // Add all logical drives to volumes
-        disk._volumes = logicalDrivesIter->second;
+    const auto* number = drive->number.data<STORAGE_DEVICE_NUMBER>();
+    Disk disk;
+    disk._id = static_cast<int>(number->DeviceNumber);
+    if (drive->descriptor.wait()) {
+      const auto* descriptor = drive->descriptor.data<STORAGE_DEVICE_DESCRIPTOR>();
+      if (has_field(fields, DiskFields::Vendor)) {
+        disk._vendor = descriptorString(drive->descriptor, descriptor->VendorIdOffset);
       }
-
-      // Look up free space
-      for (const auto& [rawKey, space] : physicalFreeSize) {
-        auto normRawKey = normalizeBackslashes(rawKey);
-        if (normRawKey == normalizedDeviceId) {
-          disk._free_size_Bytes = space;
-          break;  // Found the match, no need to continue
-        }
+      if (has_field(fields, DiskFields::Model)) {
+        disk._model = descriptorString(drive->descriptor, descriptor->ProductIdOffset);
+      }
+      if (has_field(fields, DiskFields::Serial)) {
+        disk._serialNumber = descriptorString(drive->descriptor, descriptor->SerialNumberOffset);
       }
     }
-
-    obj->Release();
+    if (drive->geometry.wait()) {
+      disk._size_Bytes = drive->geometry.data<DISK_GEOMETRY_EX>()->DiskSize.QuadPart;
+    }
+    if (const auto it = disk_mounts.find(number->DeviceNumber); it != disk_mounts.end()) {
+      Disk::Mounts mounts;
+      mounts.mount_points = it->second.mount_points;
+      if (has_field(fields, DiskFields::Volumes)) {
+        mounts.volumes = it->second.volumes;
+      }
+      disk._mounts.set(std::move(mounts));
+    }
+    powered_on.push_back(drive->powered_on != FALSE);
     disks.push_back(std::move(disk));
   }
 
+  if (has_field(fields, DiskFields::Free)) {
+    // one GetDiskFreeSpaceEx per drive, run concurrently. Volumes of sleeping disks are skipped.
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < disks.size(); ++i) {
+      if (powered_on[i] && !disks[i].mounts().mount_points.empty()) {
+        pending.push_back(std::async(std::launch::async, [&disk = disks[i]] { disk.refresh(); }));
+      }
+    }
+    for (auto& future : pending) {
+      future.wait();
+    }
+  }
+  std::sort(disks.begin(), disks.end(), [](const Disk& a, const Disk& b) { return a._id < b._id; });
   return disks;
 }
 
+// _____________________________________________________________________________________________________________________
+std::vector<DiskIOSampler::Counters> DiskIOSampler::read_counters() {
+  // physical drive numbers can have gaps after a device was removed, so probe a fixed range
+  constexpr int max_drives = 32;
+  std::vector<Counters> counters;
+  for (int i = 0; i < max_drives; ++i) {
+    const std::string name = "PhysicalDrive" + std::to_string(i);
+    // IOCTL_DISK_PERFORMANCE needs no access rights, so this works without elevation
+    HANDLE drive = CreateFileA(("\\\\.\\" + name).c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                               OPEN_EXISTING, 0, nullptr);
+    if (drive == INVALID_HANDLE_VALUE) {
+      continue;
+    }
+    DISK_PERFORMANCE performance{};
+    DWORD returned = 0;
+    const BOOL ok = DeviceIoControl(drive, IOCTL_DISK_PERFORMANCE, nullptr, 0, &performance, sizeof(performance),
+                                    &returned, nullptr);
+    CloseHandle(drive);
+    if (!ok) {
+      continue;
+    }
+    // all times are in 100 ns units
+    Counters device;
+    device.name = name;
+    device.reads = static_cast<int64_t>(performance.ReadCount);
+    device.writes = static_cast<int64_t>(performance.WriteCount);
+    device.read_Bytes = performance.BytesRead.QuadPart;
+    device.write_Bytes = performance.BytesWritten.QuadPart;
+    device.read_time_ms = static_cast<double>(performance.ReadTime.QuadPart) / 1e4;
+    device.write_time_ms = static_cast<double>(performance.WriteTime.QuadPart) / 1e4;
+    // QueryTime is a timestamp and IdleTime accumulates, their difference grows by the busy time
+    device.busy_time_ms = static_cast<double>(performance.QueryTime.QuadPart - performance.IdleTime.QuadPart) / 1e4;
+    device.weighted_time_ms = device.read_time_ms + device.write_time_ms;
+    counters.push_back(std::move(device));
+  }
+  return counters;
+}
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_WINDOWS
@@ -0,0 +1,169 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_WINDOWS
+// clang-format off
+#include <winsock2.h>
+#include <ws2ipdef.h>
+#include <iphlpapi.h>
+#include <netioapi.h>
+#include <Windows.h>
+#include <Dbt.h>
+// clang-format on
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hwinfo/events.h"
+#include "hwinfo/utils/stringutils.h"
+#pragma comment(lib, "iphlpapi.lib")
+
+namespace hwinfo {
+
+namespace {
+
+// state shared with the window procedure and the NotifyIpInterfaceChange callback
+struct WatcherState {
+  HWND window{nullptr};
+  HDEVNOTIFY disk_notification{nullptr};
+  HDEVNOTIFY monitor_notification{nullptr};
+  HANDLE ip_notification{nullptr};
+  DWORD thread_id{0};
+  // filled by the window procedure and by the NotifyIpInterfaceChange callback (which runs on a system thread)
+  std::mutex mutex;
+  std::vector<DeviceEvent> pending;
+};
+
+// {53F56307-B6BF-11D0-94F2-00A0C91EFB8B}
+constexpr GUID disk_interface = {0x53f56307, 0xb6bf, 0x11d0, {0x94, 0xf2, 0x00, 0xa0, 0xc9, 0x1e, 0xfb, 0x8b}};
+// {E6F07B5F-EE97-4A90-B076-33F57BF4EAA7}
+constexpr GUID monitor_interface = {0xe6f07b5f, 0xee97, 0x4a90, {0xb0, 0x76, 0x33, 0xf5, 0x7b, 0xf4, 0xea, 0xa7}};
+
+constexpr wchar_t window_class[] = L"hwinfo_DeviceWatcher";
+constexpr UINT wake_message = WM_APP + 1;
+
+void push_event(WatcherState* backend, DeviceEvent event);
+
+LRESULT CALLBACK window_procedure(HWND window, UINT message, WPARAM w_param, LPARAM l_param) {
+  if (message != WM_DEVICECHANGE || (w_param != DBT_DEVICEARRIVAL && w_param != DBT_DEVICEREMOVECOMPLETE)) {
+    return DefWindowProcW(window, message, w_param, l_param);
+  }
+  auto* header = reinterpret_cast<DEV_BROADCAST_HDR*>(l_param);
+  auto* backend = reinterpret_cast<WatcherState*>(GetWindowLongPtrW(window, GWLP_USERDATA));
+  if (header == nullptr || backend == nullptr || header->dbch_devicetype != DBT_DEVTYP_DEVICEINTERFACE) {
+    return TRUE;
+  }
+  auto* device = reinterpret_cast<DEV_BROADCAST_DEVICEINTERFACE_W*>(header);
+  DeviceEvent event;
+  if (IsEqualGUID(device->dbcc_classguid, disk_interface)) {
+    event.device_class = DeviceEvent::Class::Disk;
+  } else if (IsEqualGUID(device->dbcc_classguid, monitor_interface)) {
+    event.device_class = DeviceEvent::Class::Monitor;
+  } else {
+    return TRUE;
+  }
+  event.action = w_param == DBT_DEVICEARRIVAL ? DeviceEvent::Action::Add : DeviceEvent::Action::Remove;
+  event.name = utils::wstring_to_std_string(device->dbcc_name);
+  push_event(backend, std::move(event));
+  return TRUE;
+}
+
+VOID NETIOAPI_API_ ip_interface_changed(PVOID context, PMIB_IPINTERFACE_ROW row, MIB_NOTIFICATION_TYPE type) {
+  if (row == nullptr) {
+    // MibInitialNotification
+    return;
+  }
+  DeviceEvent event;
+  event.device_class = DeviceEvent::Class::Network;
+  event.action = type == MibAddInstance      ? DeviceEvent::Action::Add
+                 : type == MibDeleteInstance ? DeviceEvent::Action::Remove
+                                             : DeviceEvent::Action::Change;
+  // matches Network::interfaceIndex()
+  event.name = std::to_string(row->InterfaceIndex);
+  auto* backend = static_cast<WatcherState*>(context);
+  push_event(backend, std::move(event));
+  PostThreadMessageW(backend->thread_id, wake_message, 0, 0);
+}
+
+void push_event(WatcherState* backend, DeviceEvent event) {
+  std::lock_guard<std::mutex> lock(backend->mutex);
+  backend->pending.push_back(std::move(event));
+}
+
+HDEVNOTIFY register_interface(HWND window, const GUID& guid) {
+  DEV_BROADCAST_DEVICEINTERFACE_W filter{};
+  filter.dbcc_size = sizeof(filter);
+  filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+  filter.dbcc_classguid = guid;
+  return RegisterDeviceNotificationW(window, &filter, DEVICE_NOTIFY_WINDOW_HANDLE);
+}
+
+}  // namespace
+
+struct DeviceWatcher::Backend : WatcherState {};
+
+// _____________________________________________________________________________________________________________________
+void DeviceWatcher::BackendDeleter::operator()(Backend* backend) const {
+  if (backend->ip_notification) CancelMibChangeNotify2(backend->ip_notification);
+  if (backend->disk_notification) UnregisterDeviceNotification(backend->disk_notification);
+  if (backend->monitor_notification) UnregisterDeviceNotification(backend->monitor_notification);
+  if (backend->window) DestroyWindow(backend->window);
+  delete backend;
+}
+
+// _____________________________________________________________________________________________________________________
+DeviceWatcher::Backend* DeviceWatcher::open_backend() {
+  WNDCLASSEXW wc{};
+  wc.cbSize = sizeof(wc);
+  wc.lpfnWndProc = window_procedure;
+  wc.hInstance = GetModuleHandleW(nullptr);
+  wc.lpszClassName = window_class;
+  // fails with ERROR_CLASS_ALREADY_EXISTS for every watcher but the first, which is fine
+  RegisterClassExW(&wc);
+
+  auto* backend = new Backend;
+  backend->thread_id = GetCurrentThreadId();
+  // message-only window: receives WM_DEVICECHANGE for registered interfaces, is never shown
+  backend->window = CreateWindowExW(0, window_class, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, wc.hInstance, nullptr);
+  if (backend->window == nullptr) {
+    BackendDeleter()(backend);
+    return nullptr;
+  }
+  WatcherState* state = backend;
+  SetWindowLongPtrW(backend->window, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(state));
+  backend->disk_notification = register_interface(backend->window, disk_interface);
+  backend->monitor_notification = register_interface(backend->window, monitor_interface);
+  if (NotifyIpInterfaceChange(AF_UNSPEC, ip_interface_changed, state, FALSE, &backend->ip_notification) !=
+      NO_ERROR) {
+    backend->ip_notification = nullptr;
+  }
+  return backend;
+}
+
+// _____________________________________________________________________________________________________________________
+bool DeviceWatcher::wait_events(Backend& backend, std::vector<DeviceEvent>& events) {
+  MSG message;
+  while (events.empty()) {
+    const BOOL result = GetMessageW(&message, nullptr, 0, 0);
+    if (result <= 0) {
+      // WM_QUIT (interrupt) or error
+      return false;
+    }
+    TranslateMessage(&message);
+    DispatchMessageW(&message);
+    std::lock_guard<std::mutex> lock(backend.mutex);
+    events.swap(backend.pending);
+  }
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void DeviceWatcher::interrupt(Backend& backend) { PostThreadMessageW(backend.thread_id, WM_QUIT, 0, 0); }
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
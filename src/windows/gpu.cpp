@@ -6,13 +6,14 @@
 #ifdef HWINFO_WINDOWS
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
+#include <variant>
 #include <vector>
 
 #include "hwinfo/gpu.h"
 #include "hwinfo/utils/stringutils.h"
 #include "hwinfo/utils/wmi_wrapper.h"
-#pragma comment(lib, "wbemuuid.lib")
 
 #ifdef USE_OCL
 #include "hwinfo/opencl/device.h"
@@ -21,51 +22,37 @@
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
-std::vector<GPU> getAllGPUs() {
-  utils::WMI::_WMI wmi;
-  const std::wstring query_string(
-      L"SELECT Name, AdapterCompatibility, DriverVersion, AdapterRam, PNPDeviceID "
-      L"FROM WIN32_VideoController");
-  bool success = wmi.execute_query(query_string);
-  if (!success) {
-    return {};
+std::vector<GPU> getAllGPUs([[maybe_unused]] bool use_opencl) {
+  namespace WMI = utils::WMI;
+  // runs on the WMI worker, concurrently to the queries of the other inventory sections and the OpenCL enumeration
+  auto rows = WMI::query_rows_async(
+      L"Win32_VideoController", {L"Name", L"AdapterCompatibility", L"DriverVersion", L"AdapterRam", L"PNPDeviceID"});
+#ifdef USE_OCL
+  std::vector<opencl_::Device*> cl_gpus;
+  if (use_opencl) {
+    cl_gpus = opencl_::DeviceManager::get_list<opencl_::Filter::GPU>();
   }
+#endif
   std::vector<GPU> gpus;
-
-  ULONG u_return = 0;
-  IWbemClassObject* obj = nullptr;
   int gpu_id = 0;
-  while (wmi.enumerator) {
-    wmi.enumerator->Next(WBEM_INFINITE, 1, &obj, &u_return);
-    if (!u_return) {
-      break;
-    }
+  for (const auto& row : rows.get()) {
     GPU gpu;
     gpu._id = gpu_id++;
-    VARIANT vt_prop;
-    HRESULT hr;
-    hr = obj->Get(L"Name", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      gpu._name = utils::wstring_to_std_string(vt_prop.bstrVal);
+    gpu._name = WMI::as_string(row[0], gpu._name);
+    gpu._vendor = WMI::as_string(row[1], gpu._vendor);
+    gpu._driverVersion = WMI::as_string(row[2], gpu._driverVersion);
+    // uint32 property that WMI transports as VT_I4, adapters with 4 GiB or more wrap around
+    if (const auto* memory = std::get_if<int64_t>(&row[3])) {
+      gpu._memory_Bytes = static_cast<uint32_t>(*memory);
     }
-    hr = obj->Get(L"AdapterCompatibility", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      gpu._vendor = utils::wstring_to_std_string(vt_prop.bstrVal);
-    }
-    hr = obj->Get(L"DriverVersion", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      gpu._driverVersion = utils::wstring_to_std_string(vt_prop.bstrVal);
-    }
-    hr = obj->Get(L"AdapterRam", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_I4)) {
-      gpu._memory_Bytes = vt_prop.uintVal;
-    }
-    hr = obj->Get(L"PNPDeviceID", 0, &vt_prop, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      std::string ret = utils::wstring_to_std_string(vt_prop.bstrVal);
+    if (const auto* pnp_id = std::get_if<std::string>(&row[4])) {
+      std::string ret = *pnp_id;
+      std::vector<std::string> ids;
       if (utils::starts_with(ret, "PCI\\")) {
         utils::replaceOnce(ret, "PCI\\", "");
-        std::vector<std::string> ids = utils::split(ret, "&");
+        ids = utils::split(ret, "&");
+      }
+      if (ids.size() >= 2) {
         gpu._vendor_id = ids[0];
         utils::replaceOnce(gpu._vendor_id, "VEN_", "");
         gpu._device_id = ids[1];
@@ -75,20 +62,19 @@ std::vector<GPU> getAllGPUs() {
         gpu._device_id = "0";
       }
     }
-    VariantClear(&vt_prop);
-    obj->Release();
     gpus.push_back(std::move(gpu));
   }
 #ifdef USE_OCL
-  auto cl_gpus = opencl_::DeviceManager::get_list<opencl_::Filter::GPU>();
-  for (auto& gpu : gpus) {
-    for (auto* cl_gpu : cl_gpus) {
-      if (cl_gpu->name() == gpu.name()) {
-        gpu._driverVersion = cl_gpu->driver_version();
-        gpu._frequency_MHz = static_cast<int64_t>(cl_gpu->clock_frequency_MHz());
-        gpu._num_cores = static_cast<int>(cl_gpu->cores());
-        gpu._memory_Bytes = static_cast<int64_t>(cl_gpu->memory_Bytes());
-        break;
+  if (use_opencl) {
+    for (auto& gpu : gpus) {
+      for (auto* cl_gpu : cl_gpus) {
+        if (cl_gpu->name() == gpu.name()) {
+          gpu._driverVersion = cl_gpu->driver_version();
+          gpu._frequency_MHz = static_cast<int64_t>(cl_gpu->clock_frequency_MHz());
+          gpu._num_cores = static_cast<int>(cl_gpu->cores());
+          gpu._memory_Bytes = static_cast<int64_t>(cl_gpu->memory_Bytes());
+          break;
+        }
       }
     }
   }
@@ -96,6 +82,20 @@ std::vector<GPU> getAllGPUs() {
   return gpus;
 }
 
+// =====================================================================================================================
+struct GPUMonitor::Sources {};
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::SourcesDeleter::operator()(Sources* sources) const { delete sources; }
+
+// _____________________________________________________________________________________________________________________
+GPUMonitor::Sources* GPUMonitor::open_sources(int gpu_id) { return new Sources; }
+
+// _____________________________________________________________________________________________________________________
+void GPUMonitor::read_sources(Sources& sources, Sample& sample) {
+  // TODO: implement
+}
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_WINDOWS
@@ -0,0 +1,23 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_WINDOWS
+
+#include "hwinfo/interrupts.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+InterruptSampler::~InterruptSampler() = default;
+
+// _____________________________________________________________________________________________________________________
+bool InterruptSampler::read_counters() {
+  // TODO: only per-CPU totals are available (SystemProcessorPerformanceInformation InterruptCount, DpcCount)
+  return false;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
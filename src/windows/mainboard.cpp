@@ -8,45 +8,27 @@
 #include <string>
 
 #include "hwinfo/mainboard.h"
-#include "hwinfo/utils/stringutils.h"
 #include "hwinfo/utils/wmi_wrapper.h"
 
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
 MainBoard::MainBoard() {
-  utils::WMI::_WMI wmi;
-  const std::wstring query_string(L"SELECT Manufacturer, Product, Version, SerialNumber FROM Win32_BaseBoard");
-  bool success = wmi.execute_query(query_string);
-  if (!success) {
+  if (fromSMBIOS()) {
     return;
   }
-  ULONG u_return = 0;
-  IWbemClassObject* obj = nullptr;
-  wmi.enumerator->Next(WBEM_INFINITE, 1, &obj, &u_return);
-  if (!u_return) {
+  namespace WMI = utils::WMI;
+  // runs on the WMI worker, concurrently to the queries of the other inventory sections
+  const auto rows =
+      WMI::query_rows_async(L"Win32_BaseBoard", {L"Manufacturer", L"Product", L"Version", L"SerialNumber"}).get();
+  if (rows.empty()) {
     return;
   }
-  VARIANT vt_prop;
-  HRESULT hr;
-  hr = obj->Get(L"Manufacturer", 0, &vt_prop, nullptr, nullptr);
-  if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-    _vendor = utils::wstring_to_std_string(vt_prop.bstrVal);
-  }
-  hr = obj->Get(L"Product", 0, &vt_prop, nullptr, nullptr);
-  if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-    _name = utils::wstring_to_std_string(vt_prop.bstrVal);
-  }
-  hr = obj->Get(L"Version", 0, &vt_prop, nullptr, nullptr);
-  if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-    _version = utils::wstring_to_std_string(vt_prop.bstrVal);
-  }
-  hr = obj->Get(L"SerialNumber", 0, &vt_prop, nullptr, nullptr);
-  if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-    _serialNumber = utils::wstring_to_std_string(vt_prop.bstrVal);
-  }
-  VariantClear(&vt_prop);
-  obj->Release();
+  const auto& row = rows.front();
+  _vendor = WMI::as_string(row[0], _vendor);
+  _name = WMI::as_string(row[1], _name);
+  _version = WMI::as_string(row[2], _version);
+  _serialNumber = WMI::as_string(row[3], _serialNumber);
 }
 
 }  // namespace hwinfo
@@ -1,229 +1,274 @@
 #include "hwinfo/platform.h"
 
 #ifdef HWINFO_WINDOWS
-
+// clang-format off
+#include <winsock2.h>
+#include <ws2ipdef.h>
+#include <ws2tcpip.h>
+#include <iphlpapi.h>
+#include <netioapi.h>
+// clang-format on
+
+#include <cstdio>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "hwinfo/network.h"
 #include "hwinfo/utils/constants.h"
+#include "hwinfo/utils/instrumentation.h"
 #include "hwinfo/utils/stringutils.h"
-#include "hwinfo/utils/wmi_wrapper.h"
+#pragma comment(lib, "iphlpapi.lib")
+#pragma comment(lib, "ws2_32.lib")
 
 namespace hwinfo {
 
 namespace {
 
-inline std::string adapterTypeIDToString(unsigned short typeID, const std::wstring& name,
-                                         const std::wstring& pnpDeviceID /* optional */) {
-  switch (typeID) {
-    case 0:
-      if (name.find(L"Microsoft Hyper-V Network Adapter") != std::wstring::npos) return "Hyper-V Virtual Adapter";
-      if (name.find(L"Hyper-V") != std::wstring::npos) return "Hyper-V Virtual Adapter";
-      if (name.find(L"Kernel Debug") != std::wstring::npos) return "Kernel Debug Adapter";
-      if (name.find(L"Switch") != std::wstring::npos) return "Virtual Switch Adapter";
-      return "Ethernet";
-    case 9:
+/**
+ * @brief Interface type from the IANA ifType of the adapter, refined by its description for the virtual adapters
+ *        that register as Ethernet (Hyper-V, virtual switches, TAP-Windows, bridges, USB dongles).
+ */
+std::string adapterType(IFTYPE type, const std::wstring& description) {
+  switch (type) {
+    case IF_TYPE_SOFTWARE_LOOPBACK:
+      return "Loopback";
+    case IF_TYPE_IEEE80211:
       return "WiFi";
+    case IF_TYPE_ETHERNET_CSMACD:
+      if (description.find(L"Hyper-V") != std::wstring::npos) return "Hyper-V Virtual Adapter";
+      if (description.find(L"Kernel Debug") != std::wstring::npos) return "Kernel Debug Adapter";
+      if (description.find(L"TAP-Windows") != std::wstring::npos) return "TUN/TAP";
+      if (description.find(L"Bridge") != std::wstring::npos) return "Bridge";
+      if (description.find(L"Switch") != std::wstring::npos) return "Virtual Switch Adapter";
+      if (description.find(L"USB") != std::wstring::npos) return "USB Ethernet";
+      return "Ethernet";
+    case IF_TYPE_PROP_VIRTUAL:
+    case IF_TYPE_TUNNEL:
+      if (description.find(L"TAP-Windows") != std::wstring::npos || description.find(L"TUN") != std::wstring::npos) {
+        return "TUN/TAP";
+      }
+      break;
     default:
       break;
   }
-
-  if (name.find(L"Loopback") != std::wstring::npos) return "Loopback";
-  if (name.find(L"TAP-Windows") != std::wstring::npos || name.find(L"TUN") != std::wstring::npos) return "TUN/TAP";
-  if (name.find(L"Bridge") != std::wstring::npos) return "Bridge";
-  if (name.find(L"Hyper-V") != std::wstring::npos) return "Hyper-V Virtual Adapter";
-  if (pnpDeviceID.find(L"USB") != std::wstring::npos || name.find(L"USB") != std::wstring::npos) return "USB Ethernet";
-
   return constants::UNKNOWN;
 }
 
-/**
- * @brief Query Win32_NetworkAdapter for each adapter's Index and AdapterTypeID,
- *        build a map from adapter index -> string type (Ethernet, Wireless, etc.).
- */
-std::unordered_map<int, std::string> getWindowsAdapterTypes() {
-  std::unordered_map<int, std::string> adapterTypes;
-  utils::WMI::_WMI wmi;
-
-  const std::wstring queryString =
-      L"SELECT Index, AdapterTypeID, Name, PNPDeviceID, InterfaceIndex "
-      L"FROM Win32_NetworkAdapter";
-
-  if (!wmi.execute_query(queryString)) return adapterTypes;
-
-  IWbemClassObject* wbemObject = nullptr;
-  ULONG returnedCount = 0;
-
-  while (wmi.enumerator) {
-    HRESULT hr = wmi.enumerator->Next(WBEM_INFINITE, 1, &wbemObject, &returnedCount);
-    if (FAILED(hr) || !returnedCount) break;
-
-    VARIANT vtIndex, vtTypeID, vtName, vtPNPDeviceID, vtInterfaceIndex;
-    VariantInit(&vtIndex);
-    VariantInit(&vtTypeID);
-    VariantInit(&vtName);
-    VariantInit(&vtPNPDeviceID);
-    VariantInit(&vtInterfaceIndex);
-
-    HRESULT hrIndex = wbemObject->Get(L"Index", 0, &vtIndex, nullptr, nullptr);
-    HRESULT hrTypeID = wbemObject->Get(L"AdapterTypeID", 0, &vtTypeID, nullptr, nullptr);
-    HRESULT hrName = wbemObject->Get(L"Name", 0, &vtName, nullptr, nullptr);
-    HRESULT hrPNP = wbemObject->Get(L"PNPDeviceID", 0, &vtPNPDeviceID, nullptr, nullptr);
-    HRESULT hrInterfaceIndex = wbemObject->Get(L"InterfaceIndex", 0, &vtInterfaceIndex, nullptr, nullptr);
-
-    if (SUCCEEDED(hrIndex)) {
-      int index = static_cast<int>(vtIndex.ulVal);
-      unsigned short typeID = SUCCEEDED(hrTypeID) ? vtTypeID.uiVal : 0;
+const char* operStatusName(IF_OPER_STATUS status) {
+  switch (status) {
+    case IfOperStatusUp:
+      return "up";
+    case IfOperStatusDown:
+      return "down";
+    case IfOperStatusTesting:
+      return "testing";
+    case IfOperStatusDormant:
+      return "dormant";
+    case IfOperStatusNotPresent:
+      return "notpresent";
+    case IfOperStatusLowerLayerDown:
+      return "lowerlayerdown";
+    default:
+      return constants::UNKNOWN;
+  }
+}
 
-      std::wstring adapterName = SUCCEEDED(hrName) ? std::wstring(vtName.bstrVal, SysStringLen(vtName.bstrVal)) : L"";
-      std::wstring wpnpid =
-          SUCCEEDED(hrPNP) ? std::wstring(vtPNPDeviceID.bstrVal, SysStringLen(vtPNPDeviceID.bstrVal)) : L"";
+Network::Statistics toStatistics(const MIB_IF_ROW2& row) {
+  Network::Statistics statistics;
+  statistics.rx_bytes = static_cast<int64_t>(row.InOctets);
+  statistics.tx_bytes = static_cast<int64_t>(row.OutOctets);
+  statistics.rx_packets = static_cast<int64_t>(row.InUcastPkts + row.InNUcastPkts);
+  statistics.tx_packets = static_cast<int64_t>(row.OutUcastPkts + row.OutNUcastPkts);
+  statistics.rx_errors = static_cast<int64_t>(row.InErrors);
+  statistics.tx_errors = static_cast<int64_t>(row.OutErrors);
+  statistics.rx_dropped = static_cast<int64_t>(row.InDiscards);
+  statistics.tx_dropped = static_cast<int64_t>(row.OutDiscards);
+  return statistics;
+}
 
-      std::string typeStr = adapterTypeIDToString(typeID, adapterName, wpnpid);
+// ReceiveLinkSpeed is in bit/s, disconnected adapters report 0 or ULONG64_MAX
+int64_t linkSpeed_Mbps(const MIB_IF_ROW2& row) {
+  if (row.ReceiveLinkSpeed == 0 || row.ReceiveLinkSpeed == ~0ULL) {
+    return -1;
+  }
+  return static_cast<int64_t>(row.ReceiveLinkSpeed / 1000000);
+}
 
-      if (SUCCEEDED(hrInterfaceIndex) && vtInterfaceIndex.uintVal > 0) {
-        int interfaceIndex = static_cast<int>(vtInterfaceIndex.uintVal);
-        adapterTypes[interfaceIndex] = typeStr;
-      }
+/**
+ * @brief All adapters with their unicast addresses from a single GetAdaptersAddresses call. The buffer is kept per
+ *        thread and only grows, so repeated calls do not allocate once it fits. The result points into the buffer and
+ *        is valid until the next call on the same thread.
+ * @return nullptr if there are no adapters or the call failed
+ */
+const IP_ADAPTER_ADDRESSES* queryAdapters() {
+  HWINFO_PROBE("network.adapters");
+  // 8 byte elements for the alignment of IP_ADAPTER_ADDRESSES, 16 KiB as recommended by the documentation
+  thread_local std::vector<ULONGLONG> buffer(16 * 1024 / sizeof(ULONGLONG));
+  constexpr ULONG flags = GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER;
+  // adapters may be added between the size query and the call, retry a few times
+  for (int attempt = 0; attempt < 3; ++attempt) {
+    auto size = static_cast<ULONG>(buffer.size() * sizeof(ULONGLONG));
+    auto* adapters = reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data());
+    HWINFO_COUNT_SYSCALL();
+    const ULONG status = GetAdaptersAddresses(AF_UNSPEC, flags, nullptr, adapters, &size);
+    if (status == ERROR_SUCCESS) {
+      return adapters;
     }
+    if (status != ERROR_BUFFER_OVERFLOW) {
+      return nullptr;
+    }
+    buffer.resize((size + sizeof(ULONGLONG) - 1) / sizeof(ULONGLONG));
+  }
+  return nullptr;
+}
 
-    VariantClear(&vtIndex);
-    VariantClear(&vtTypeID);
-    VariantClear(&vtName);
-    VariantClear(&vtPNPDeviceID);
-    VariantClear(&vtInterfaceIndex);
+NET_IFINDEX interfaceIndex(const IP_ADAPTER_ADDRESSES& adapter) {
+  // IfIndex is 0 if IPv4 is disabled on the adapter
+  return adapter.IfIndex != 0 ? adapter.IfIndex : adapter.Ipv6IfIndex;
+}
 
-    wbemObject->Release();
+/**
+ * @brief The unicast addresses of an adapter. ip4 receives the first IPv4 address (<unknown> if there is none), all_ip6
+ *        all IPv6 addresses and ip6 the link-local one (or the first IPv6 address if there is no link-local address),
+ *        like the Linux backend.
+ */
+void readAddresses(const IP_ADAPTER_ADDRESSES& adapter, std::string& ip4, std::string& ip6,
+                   std::vector<std::string>& all_ip6) {
+  ip4.clear();
+  ip6.clear();
+  all_ip6.clear();
+  char text[INET6_ADDRSTRLEN];
+  for (const auto* address = adapter.FirstUnicastAddress; address; address = address->Next) {
+    const SOCKADDR* socket_address = address->Address.lpSockaddr;
+    if (socket_address == nullptr) continue;
+    if (socket_address->sa_family == AF_INET) {
+      const auto* in = reinterpret_cast<const sockaddr_in*>(socket_address);
+      if (ip4.empty() && inet_ntop(AF_INET, &in->sin_addr, text, sizeof(text))) ip4 = text;
+    } else if (socket_address->sa_family == AF_INET6) {
+      const auto* in6 = reinterpret_cast<const sockaddr_in6*>(socket_address);
+      if (!inet_ntop(AF_INET6, &in6->sin6_addr, text, sizeof(text))) continue;
+      all_ip6.emplace_back(text);
+      if (ip6.empty() && IN6_IS_ADDR_LINKLOCAL(&in6->sin6_addr)) ip6 = text;
+    }
   }
+  if (ip4.empty()) ip4 = constants::UNKNOWN;
+  if (ip6.empty() && !all_ip6.empty()) ip6 = all_ip6.front();
+}
 
-  return adapterTypes;
+// "00:15:5D:01:02:03" like Win32_NetworkAdapterConfiguration.MACAddress
+std::string macAddress(const IP_ADAPTER_ADDRESSES& adapter) {
+  if (adapter.PhysicalAddressLength == 0) {
+    return constants::UNKNOWN;
+  }
+  std::string mac;
+  char octet[4];
+  for (ULONG i = 0; i < adapter.PhysicalAddressLength; ++i) {
+    std::snprintf(octet, sizeof(octet), i == 0 ? "%02X" : ":%02X", adapter.PhysicalAddress[i]);
+    mac += octet;
+  }
+  return mac;
 }
+
 }  // namespace
 
 // _____________________________________________________________________________________________________________________
-std::vector<Network> getAllNetworks() {
-  auto adapterTypeMap = getWindowsAdapterTypes();
-
-  utils::WMI::_WMI wmi;
-  const std::wstring queryString =
-      L"SELECT InterfaceIndex, IPAddress, Description, MACAddress "
-      L"FROM Win32_NetworkAdapterConfiguration";
-
-  if (!wmi.execute_query(queryString)) {
-    return {};
+bool Network::refresh(NetworkFields fields) {
+  const auto index = utils::toNumber<NET_IFINDEX>(_interface);
+  if (!index) {
+    return false;
+  }
+  MIB_IF_ROW2 row{};
+  row.InterfaceIndex = *index;
+  HWINFO_COUNT_SYSCALL();
+  if (GetIfEntry2(&row) != NO_ERROR) {
+    return false;
+  }
+  if (has_field(fields, NetworkFields::Statistics)) _statistics = toStatistics(row);
+  if (has_field(fields, NetworkFields::Link)) {
+    _mtu = static_cast<int>(row.Mtu);
+    _oper_state = operStatusName(row.OperStatus);
+    _link_speed_Mbps = linkSpeed_Mbps(row);
+  }
+  // GetAdaptersAddresses lists every adapter, it is only called for addresses
+  if (!has_field(fields, NetworkFields::IP4 | NetworkFields::IP6)) {
+    return true;
+  }
+  for (const auto* adapter = queryAdapters(); adapter; adapter = adapter->Next) {
+    if (interfaceIndex(*adapter) == *index) {
+      readAddresses(*adapter, _ip4, _ip6, _ip6_addresses);
+      return true;
+    }
   }
+  return false;
+}
 
+/**
+ * @brief All adapters from one GetAdaptersAddresses call (identity and addresses) and, if statistics or link
+ *        attributes are requested, one GetIfTable2 call for the counters, MTU, state and speed of all interfaces.
+ */
+std::vector<Network> getAllNetworks(NetworkFields fields) {
+  HWINFO_PROBE("network.iphlpapi");
   std::vector<Network> networks;
-  IWbemClassObject* wbemObject = nullptr;
-  ULONG returnedCount = 0;
+  const IP_ADAPTER_ADDRESSES* adapters = queryAdapters();
+  if (adapters == nullptr) {
+    return networks;
+  }
 
-  while (wmi.enumerator) {
-    HRESULT hr = wmi.enumerator->Next(WBEM_INFINITE, 1, &wbemObject, &returnedCount);
-    if (FAILED(hr) || !returnedCount) {
-      break;
+  std::unordered_map<NET_IFINDEX, const MIB_IF_ROW2*> rows;
+  MIB_IF_TABLE2* table = nullptr;
+  if (has_field(fields, NetworkFields::Statistics | NetworkFields::Link)) {
+    HWINFO_COUNT_SYSCALL();
+    if (GetIfTable2(&table) == NO_ERROR) {
+      rows.reserve(table->NumEntries);
+      for (ULONG i = 0; i < table->NumEntries; ++i) {
+        rows.emplace(table->Table[i].InterfaceIndex, &table->Table[i]);
+      }
+    } else {
+      table = nullptr;
     }
+  }
 
+  for (const auto* adapter = adapters; adapter; adapter = adapter->Next) {
     Network network;
-    VARIANT vtProp;
-    VariantInit(&vtProp);
-
-    // --------------------------------------------------
-    //  InterfaceIndex
-    // --------------------------------------------------
-    hr = wbemObject->Get(L"InterfaceIndex", 0, &vtProp, nullptr, nullptr);
-    if (SUCCEEDED(hr)) {
-      network._index = std::to_string(vtProp.uintVal);
-    }
-    VariantClear(&vtProp);
-
-    // --------------------------------------------------
-    //  IPAddress (array of BSTR with IPv4 & IPv6)
-    // --------------------------------------------------
-    VariantInit(&vtProp);
-    hr = wbemObject->Get(L"IPAddress", 0, &vtProp, nullptr, nullptr);
-    if (SUCCEEDED(hr) && (vtProp.vt == (VT_ARRAY | VT_BSTR))) {
-      LONG lowerBound = 0, upperBound = 0;
-      SafeArrayGetLBound(vtProp.parray, 1, &lowerBound);
-      SafeArrayGetUBound(vtProp.parray, 1, &upperBound);
-
-      std::string ipv4, ipv6;
-      for (LONG i = lowerBound; i <= upperBound; ++i) {
-        BSTR bstrIp = nullptr;
-        if (SUCCEEDED(SafeArrayGetElement(vtProp.parray, &i, &bstrIp)) && bstrIp) {
-          std::wstring wsIp(bstrIp, SysStringLen(bstrIp));
-          std::string ip = utils::wstring_to_std_string(wsIp);
-
-          // Distinguish IPv6 vs IPv4
-          if (ip.find(':') != std::string::npos) {
-            // If you only want link-local IPv6, check for "fe80::".
-            if (ip.rfind("fe80::", 0) == 0) {
-              ipv6 = ip;
-            } else {
-              // If you want to capture a global IPv6 instead, handle it here.
-              // e.g., ipv6 = ip;
-            }
-          } else {
-            ipv4 = ip;
-          }
-          SysFreeString(bstrIp);
-        }
+    const NET_IFINDEX index = interfaceIndex(*adapter);
+    network._interface = std::to_string(index);
+    if (has_field(fields, NetworkFields::Index)) network._index = network._interface;
+    const std::wstring description = adapter->Description ? adapter->Description : L"";
+    if (has_field(fields, NetworkFields::Description)) network._description = utils::wstring_to_std_string(description);
+    if (has_field(fields, NetworkFields::Mac)) network._mac = macAddress(*adapter);
+    if (has_field(fields, NetworkFields::IP4 | NetworkFields::IP6)) {
+      std::string ip4;
+      readAddresses(*adapter, ip4, network._ip6, network._ip6_addresses);
+      if (has_field(fields, NetworkFields::IP4)) network._ip4 = std::move(ip4);
+      if (!has_field(fields, NetworkFields::IP6)) {
+        network._ip6.clear();
+        network._ip6_addresses.clear();
       }
-      network._ip4 = ipv4;
-      network._ip6 = ipv6;
-    }
-    VariantClear(&vtProp);
-
-    // --------------------------------------------------
-    //  Description
-    // --------------------------------------------------
-    VariantInit(&vtProp);
-    hr = wbemObject->Get(L"Description", 0, &vtProp, nullptr, nullptr);
-    if (SUCCEEDED(hr) && vtProp.vt == VT_BSTR) {
-      network._description = utils::wstring_to_std_string(vtProp.bstrVal);
     }
-    VariantClear(&vtProp);
-
-    // --------------------------------------------------
-    //  MACAddress
-    // --------------------------------------------------
-    VariantInit(&vtProp);
-    hr = wbemObject->Get(L"MACAddress", 0, &vtProp, nullptr, nullptr);
-    if (SUCCEEDED(hr) && vtProp.vt == VT_BSTR) {
-      network._mac = utils::wstring_to_std_string(vtProp.bstrVal);
-    }
-    VariantClear(&vtProp);
-
-    // --------------------------------------------------
-    //  Fill in the _type field using our adapterTypeMap
-    // --------------------------------------------------
-    if (!network._index.empty()) {
-      try {
-        int idx = std::stoi(network._index);
-        if (auto it = adapterTypeMap.find(idx); it != adapterTypeMap.end()) {
-          network._type = it->second;
-        } else {
-          network._type = constants::UNKNOWN;
-        }
-      } catch (...) {
-        // Could not parse index; leave type as unknown
-        network._type = constants::UNKNOWN;
+    if (has_field(fields, NetworkFields::Type)) network._type = adapterType(adapter->IfType, description);
+
+    const auto row = rows.find(index);
+    if (row != rows.end()) {
+      if (has_field(fields, NetworkFields::Statistics)) network._statistics = toStatistics(*row->second);
+      if (has_field(fields, NetworkFields::Link)) {
+        network._mtu = static_cast<int>(row->second->Mtu);
+        network._oper_state = operStatusName(row->second->OperStatus);
+        network._link_speed_Mbps = linkSpeed_Mbps(*row->second);
       }
-    } else {
-      network._type = constants::UNKNOWN;
+    } else if (has_field(fields, NetworkFields::Link)) {
+      network._oper_state = constants::UNKNOWN;
     }
-
-    // Release WMI object for this iteration
-    wbemObject->Release();
-    wbemObject = nullptr;
-
+    // TODO: Hardware via the NDIS OIDs (receive queues, offloads) and the PCI location of the adapter's PnP device
     networks.push_back(std::move(network));
   }
 
+  if (table) {
+    FreeMibTable(table);
+  }
   return networks;
 }
 
 }  // namespace hwinfo
 
-#endif  // HWINFO_WINDOWS
\ No newline at end of file
+#endif  // HWINFO_WINDOWS
@@ -0,0 +1,186 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_WINDOWS
+// clang-format off
+#include <Windows.h>
+#include <winioctl.h>
+#include <ntddscsi.h>
+// clang-format on
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hwinfo/nvme.h"
+#include "hwinfo/utils/stringutils.h"
+
+namespace hwinfo {
+
+namespace {
+
+constexpr DWORD identify_namespace = 0x00;
+constexpr DWORD identify_controller = 0x01;
+constexpr DWORD log_health = 0x02;
+constexpr DWORD identify_size = 4096;
+constexpr DWORD health_size = 512;
+
+struct HandleCloser {
+  void operator()(HANDLE handle) const { CloseHandle(handle); }
+};
+using UniqueHandle = std::unique_ptr<void, HandleCloser>;
+
+// protocol specific queries are passed to the controller and require read and write access (elevation)
+UniqueHandle openDrive(const std::string& path, DWORD access) {
+  HANDLE handle =
+      CreateFileA(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+  return UniqueHandle(handle == INVALID_HANDLE_VALUE ? nullptr : handle);
+}
+
+/**
+ * @brief One IOCTL_STORAGE_QUERY_PROPERTY for NVMe protocol data: an Identify structure (value: CNS, sub value:
+ *        namespace id) or a log page (value: log identifier). The query and the returned data share buffer.
+ * @return the size bytes of protocol data inside buffer, nullptr if the query failed
+ */
+const uint8_t* queryProtocolData(HANDLE drive, STORAGE_PROPERTY_ID property, STORAGE_PROTOCOL_NVME_DATA_TYPE type,
+                                 DWORD value, DWORD sub_value, DWORD size, std::vector<BYTE>& buffer) {
+  const size_t header = offsetof(STORAGE_PROPERTY_QUERY, AdditionalParameters) + sizeof(STORAGE_PROTOCOL_SPECIFIC_DATA);
+  buffer.assign(header + size, 0);
+  auto* query = reinterpret_cast<STORAGE_PROPERTY_QUERY*>(buffer.data());
+  auto* protocol = reinterpret_cast<STORAGE_PROTOCOL_SPECIFIC_DATA*>(query->AdditionalParameters);
+  query->PropertyId = property;
+  query->QueryType = PropertyStandardQuery;
+  protocol->ProtocolType = ProtocolTypeNvme;
+  protocol->DataType = type;
+  protocol->ProtocolDataRequestValue = value;
+  protocol->ProtocolDataRequestSubValue = sub_value;
+  protocol->ProtocolDataOffset = sizeof(STORAGE_PROTOCOL_SPECIFIC_DATA);
+  protocol->ProtocolDataLength = size;
+  DWORD returned = 0;
+  if (!DeviceIoControl(drive, IOCTL_STORAGE_QUERY_PROPERTY, buffer.data(), static_cast<DWORD>(buffer.size()),
+                       buffer.data(), static_cast<DWORD>(buffer.size()), &returned, nullptr)) {
+    return nullptr;
+  }
+  // the output starts with a STORAGE_PROTOCOL_DATA_DESCRIPTOR, the data follows at the returned offset
+  const auto* descriptor = reinterpret_cast<const STORAGE_PROTOCOL_DATA_DESCRIPTOR*>(buffer.data());
+  if (descriptor->Version != sizeof(STORAGE_PROTOCOL_DATA_DESCRIPTOR) ||
+      descriptor->Size != sizeof(STORAGE_PROTOCOL_DATA_DESCRIPTOR)) {
+    return nullptr;
+  }
+  const auto& data = descriptor->ProtocolSpecificData;
+  const size_t offset = offsetof(STORAGE_PROTOCOL_DATA_DESCRIPTOR, ProtocolSpecificData) + data.ProtocolDataOffset;
+  if (data.ProtocolDataOffset < sizeof(STORAGE_PROTOCOL_SPECIFIC_DATA) || data.ProtocolDataLength < size ||
+      offset + size > buffer.size()) {
+    return nullptr;
+  }
+  return buffer.data() + offset;
+}
+
+// reads a string at offset in a STORAGE_DEVICE_DESCRIPTOR, offset 0 means the device does not report it
+std::string descriptorString(const std::vector<BYTE>& buffer, DWORD offset) {
+  if (offset == 0 || offset >= buffer.size()) {
+    return {};
+  }
+  const char* begin = reinterpret_cast<const char*>(buffer.data()) + offset;
+  std::string value(begin, strnlen(begin, buffer.size() - offset));
+  utils::strip(value);
+  return value;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+bool NvmeController::readHealth(Health& health) const {
+  const auto drive = openDrive(_path, GENERIC_READ | GENERIC_WRITE);
+  if (!drive) {
+    return false;
+  }
+  std::vector<BYTE> buffer;
+  const uint8_t* data = queryProtocolData(drive.get(), StorageDeviceProtocolSpecificProperty, NVMeDataTypeLogPage,
+                                          log_health, 0, health_size, buffer);
+  if (data == nullptr) {
+    return false;
+  }
+  health = parseHealth(data);
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<NvmeController> getAllNvmeControllers() {
+  // physical drive numbers can have gaps after a device was removed, so probe a fixed range like DiskIOSampler.
+  // StorNVMe presents every namespace as its own drive, each drive is reported as one controller with one namespace.
+  constexpr int max_drives = 32;
+  std::vector<NvmeController> controllers;
+  std::vector<BYTE> buffer;
+  for (int i = 0; i < max_drives; ++i) {
+    const std::string name = "PhysicalDrive" + std::to_string(i);
+    const std::string path = "\\\\.\\" + name;
+    // the bus type and the identity need no access rights
+    const auto probe = openDrive(path, 0);
+    if (!probe) {
+      continue;
+    }
+    STORAGE_PROPERTY_QUERY query{};
+    query.PropertyId = StorageDeviceProperty;
+    query.QueryType = PropertyStandardQuery;
+    buffer.assign(1024, 0);
+    DWORD returned = 0;
+    if (!DeviceIoControl(probe.get(), IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query), buffer.data(),
+                         static_cast<DWORD>(buffer.size()), &returned, nullptr)) {
+      continue;
+    }
+    const auto* device = reinterpret_cast<const STORAGE_DEVICE_DESCRIPTOR*>(buffer.data());
+    if (device->BusType != BusTypeNvme) {
+      continue;
+    }
+    NvmeController controller;
+    controller._name = name;
+    controller._path = path;
+    controller._model = descriptorString(buffer, device->ProductIdOffset);
+    controller._serialNumber = descriptorString(buffer, device->SerialNumberOffset);
+    controller._firmware = descriptorString(buffer, device->ProductRevisionOffset);
+
+    NvmeController::Namespace ns;
+    ns.device = name;
+    // StorNVMe maps namespace n to LUN n - 1
+    SCSI_ADDRESS address{};
+    address.Length = sizeof(address);
+    ns.id = DeviceIoControl(probe.get(), IOCTL_SCSI_GET_ADDRESS, nullptr, 0, &address, sizeof(address), &returned,
+                            nullptr)
+                ? address.Lun + 1u
+                : 1u;
+
+    if (const auto drive = openDrive(path, GENERIC_READ | GENERIC_WRITE)) {
+      if (const uint8_t* data = queryProtocolData(drive.get(), StorageAdapterProtocolSpecificProperty,
+                                                  NVMeDataTypeIdentify, identify_controller, 0, identify_size,
+                                                  buffer)) {
+        controller.parseIdentifyController(data);
+      }
+      if (const uint8_t* data = queryProtocolData(drive.get(), StorageDeviceProtocolSpecificProperty,
+                                                  NVMeDataTypeIdentify, identify_namespace, ns.id, identify_size,
+                                                  buffer)) {
+        const uint32_t id = ns.id;
+        ns = NvmeController::parseIdentifyNamespace(data);
+        ns.id = id;
+        ns.device = name;
+      }
+      if (const uint8_t* data = queryProtocolData(drive.get(), StorageDeviceProtocolSpecificProperty,
+                                                  NVMeDataTypeLogPage, log_health, 0, health_size, buffer)) {
+        controller._health = NvmeController::parseHealth(data);
+      }
+    }
+    controller._namespaces.push_back(std::move(ns));
+    controllers.push_back(std::move(controller));
+  }
+  return controllers;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
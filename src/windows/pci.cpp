@@ -0,0 +1,23 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_WINDOWS
+
+#include <vector>
+
+#include "hwinfo/pci.h"
+
+namespace hwinfo {
+
+// _____________________________________________________________________________________________________________________
+std::vector<PCIBusDevice> getAllPCIDevices() {
+  std::vector<PCIBusDevice> devices{};
+  // TODO: implement
+  return devices;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
@@ -0,0 +1,32 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_WINDOWS
+
+#include <string>
+#include <vector>
+
+#include "hwinfo/perf_counters.h"
+
+namespace hwinfo {
+
+struct PerfCounterSampler::Backend {};
+
+// _____________________________________________________________________________________________________________________
+void PerfCounterSampler::BackendDeleter::operator()(Backend* backend) const { delete backend; }
+
+// _____________________________________________________________________________________________________________________
+PerfCounterSampler::Backend* PerfCounterSampler::open_backend(std::string& error) {
+  // TODO: per-core PMU counters are only exposed to kernel drivers and ETW (Windows Performance Recorder profiles)
+  error = "hardware counters are not available on Windows";
+  return nullptr;
+}
+
+// _____________________________________________________________________________________________________________________
+bool PerfCounterSampler::read_counters(Backend&, std::vector<int>&, std::vector<Reading>&) { return false; }
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
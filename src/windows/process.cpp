@@ -0,0 +1,138 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_WINDOWS
+#include <Windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hwinfo/process.h"
+#include "hwinfo/utils/instrumentation.h"
+#pragma comment(lib, "psapi.lib")
+
+namespace hwinfo {
+
+namespace {
+
+// FILETIME durations count 100 ns intervals
+int64_t toNs(const FILETIME& time) {
+  ULARGE_INTEGER value;
+  value.LowPart = time.dwLowDateTime;
+  value.HighPart = time.dwHighDateTime;
+  return static_cast<int64_t>(value.QuadPart) * 100;
+}
+
+std::string executableName() {
+  char path[MAX_PATH];
+  const DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+  if (length == 0 || length == MAX_PATH) {
+    return {};
+  }
+  const std::string full(path, length);
+  const size_t separator = full.find_last_of("\\/");
+  return separator == std::string::npos ? full : full.substr(separator + 1);
+}
+
+}  // namespace
+
+struct ProcessSampler::Backend {
+  std::string name;
+  // handles of the threads seen in the last sample, keyed by thread id
+  std::unordered_map<DWORD, HANDLE> threads;
+};
+
+// _____________________________________________________________________________________________________________________
+void ProcessSampler::BackendDeleter::operator()(Backend* backend) const {
+  for (const auto& entry : backend->threads) {
+    CloseHandle(entry.second);
+  }
+  delete backend;
+}
+
+// _____________________________________________________________________________________________________________________
+ProcessSampler::Backend* ProcessSampler::open_backend() {
+  auto* backend = new Backend;
+  backend->name = executableName();
+  return backend;
+}
+
+// _____________________________________________________________________________________________________________________
+bool ProcessSampler::read_counters(Backend& backend, ProcessStats& process, std::vector<ProcessStats>* threads) {
+  HWINFO_PROBE("process.self");
+  const HANDLE self = GetCurrentProcess();
+  process.id = static_cast<int64_t>(GetCurrentProcessId());
+  process.name = backend.name;
+  bool read = false;
+  FILETIME creation, exit, kernel, user;
+  HWINFO_COUNT_SYSCALL();
+  if (GetProcessTimes(self, &creation, &exit, &kernel, &user)) {
+    process.user_time_ns = toNs(user);
+    process.system_time_ns = toNs(kernel);
+    read = true;
+  }
+  PROCESS_MEMORY_COUNTERS_EX memory{};
+  HWINFO_COUNT_SYSCALL();
+  if (GetProcessMemoryInfo(self, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&memory), sizeof(memory))) {
+    process.rss_Bytes = static_cast<int64_t>(memory.WorkingSetSize);
+    process.peak_rss_Bytes = static_cast<int64_t>(memory.PeakWorkingSetSize);
+    // committed private memory, Windows does not report the reserved address space per process
+    process.virtual_Bytes = static_cast<int64_t>(memory.PrivateUsage);
+    // soft (working set) and hard (paged in) faults combined
+    process.minor_faults = static_cast<int64_t>(memory.PageFaultCount);
+    read = true;
+  }
+  // TODO: context switches per process are only available through NtQuerySystemInformation(SystemProcessInformation)
+  if (threads == nullptr || !read) {
+    return read;
+  }
+
+  HWINFO_PROBE("process.threads");
+  // the snapshot lists the threads of all processes
+  HWINFO_COUNT_SYSCALL();
+  const HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+  if (snapshot == INVALID_HANDLE_VALUE) {
+    return read;
+  }
+  std::unordered_map<DWORD, HANDLE> handles;
+  THREADENTRY32 entry{};
+  entry.dwSize = sizeof(entry);
+  for (BOOL found = Thread32First(snapshot, &entry); found; found = Thread32Next(snapshot, &entry)) {
+    if (entry.th32OwnerProcessID != static_cast<DWORD>(process.id)) continue;
+    HANDLE handle = nullptr;
+    const auto it = backend.threads.find(entry.th32ThreadID);
+    if (it != backend.threads.end()) {
+      handle = it->second;
+      backend.threads.erase(it);
+    } else {
+      handle = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, entry.th32ThreadID);
+      if (handle == nullptr) continue;
+    }
+    handles.emplace(entry.th32ThreadID, handle);
+    ProcessStats thread;
+    thread.id = static_cast<int64_t>(entry.th32ThreadID);
+    if (GetThreadTimes(handle, &creation, &exit, &kernel, &user)) {
+      thread.user_time_ns = toNs(user);
+      thread.system_time_ns = toNs(kernel);
+    }
+    threads->push_back(std::move(thread));
+  }
+  CloseHandle(snapshot);
+  // the remaining handles belong to threads that exited
+  for (const auto& stale : backend.threads) {
+    CloseHandle(stale.second);
+  }
+  backend.threads = std::move(handles);
+  process.num_threads = static_cast<int64_t>(threads->size());
+  return read;
+}
+
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
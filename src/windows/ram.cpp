@@ -5,18 +5,27 @@
 
 #ifdef HWINFO_WINDOWS
 #include <Windows.h>
+#include <psapi.h>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "hwinfo/ram.h"
 #include "hwinfo/utils/stringutils.h"
 #include "hwinfo/utils/wmi_wrapper.h"
+#pragma comment(lib, "psapi.lib")
 
 namespace hwinfo {
 
 // _____________________________________________________________________________________________________________________
-Memory::Memory() {
+Memory::Memory(MemoryFields fields) {
+  if (has_field(fields, MemoryFields::Topology)) {
+    readTopology();
+  }
+  if (!has_field(fields, MemoryFields::Modules) || modulesFromSMBIOS()) {
+    return;
+  }
   utils::WMI::_WMI wmi;
   const std::wstring query_string(
       L"SELECT Capacity, ConfiguredClockSpeed, Manufacturer, SerialNumber, PartNumber FROM Win32_PhysicalMemory");
@@ -50,7 +59,7 @@ Memory::Memory() {
     }
     hr = obj->Get(L"Capacity", 0, &vt_prop, nullptr, nullptr);
     if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_BSTR)) {
-      module.total_Bytes = std::stoll(utils::wstring_to_std_string(vt_prop.bstrVal));
+      module.total_Bytes = utils::toNumber<int64_t>(utils::wstring_to_std_string(vt_prop.bstrVal)).value_or(-1);
     }
     hr = obj->Get(L"ConfiguredClockSpeed", 0, &vt_prop, nullptr, nullptr);
     if (SUCCEEDED(hr) && (V_VT(&vt_prop) == VT_I4)) {
@@ -72,7 +81,8 @@ int64_t Memory::free_Bytes() const {
   if (res.empty()) {
     return -1;
   }
-  return std::stoll(res.front()) * 1024;
+  const auto free_KiB = utils::toNumber<int64_t>(res.front());
+  return free_KiB ? *free_KiB * 1024 : -1;
 }
 
 // _____________________________________________________________________________________________________________________
@@ -81,6 +91,127 @@ int64_t Memory::available_Bytes() const {
   return free_Bytes();
 }
 
+// _____________________________________________________________________________________________________________________
+MemoryStats Memory::snapshot() {
+  MemoryStats stats;
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (GlobalMemoryStatusEx(&status)) {
+    stats.total_Bytes = static_cast<int64_t>(status.ullTotalPhys);
+    stats.free_Bytes = static_cast<int64_t>(status.ullAvailPhys);
+    stats.available_Bytes = stats.free_Bytes;
+    // the commit limit is physical memory plus the page files
+    if (status.ullTotalPageFile >= status.ullTotalPhys) {
+      stats.swap_total_Bytes = static_cast<int64_t>(status.ullTotalPageFile - status.ullTotalPhys);
+    }
+  }
+  PERFORMANCE_INFORMATION performance;
+  performance.cb = sizeof(performance);
+  if (GetPerformanceInfo(&performance, sizeof(performance))) {
+    stats.cached_Bytes = static_cast<int64_t>(performance.SystemCache) * static_cast<int64_t>(performance.PageSize);
+  }
+  // TODO: swap usage (page file usage is only available per page file via NtQuerySystemInformation)
+  return stats;
+}
+
+// _____________________________________________________________________________________________________________________
+bool Memory::refresh() {
+  // a single syscall instead of the WMI query of free_Bytes()
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (!GlobalMemoryStatusEx(&status)) {
+    return false;
+  }
+  _free_Bytes = static_cast<int64_t>(status.ullAvailPhys);
+  _available_Bytes = _free_Bytes;
+  if (!_topology.nodes.empty()) {
+    refreshNodes();
+  }
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void Memory::readTopology() {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  _topology.page_size_Bytes = static_cast<int64_t>(info.dwPageSize);
+  // large pages are allocated on demand with SeLockMemoryPrivilege, there is no persistent pool to count
+  const SIZE_T large_page_size = GetLargePageMinimum();
+  if (large_page_size > 0) {
+    _topology.default_huge_page_size_Bytes = static_cast<int64_t>(large_page_size);
+    HugePagePool pool;
+    pool.page_size_Bytes = _topology.default_huge_page_size_Bytes;
+    _topology.huge_pages.push_back(pool);
+  }
+
+  ULONG highest = 0;
+  if (!GetNumaHighestNodeNumber(&highest)) {
+    highest = 0;
+  }
+  for (ULONG id = 0; id <= highest; ++id) {
+    MemoryNode node;
+    node.id = static_cast<int>(id);
+    // processors are numbered per group of at most 64
+    GROUP_AFFINITY affinity{};
+    if (GetNumaNodeProcessorMaskEx(static_cast<USHORT>(id), &affinity)) {
+      for (int bit = 0; bit < 64; ++bit) {
+        if ((affinity.Mask >> bit) & 1u) {
+          node.cpus.push_back(affinity.Group * 64 + bit);
+        }
+      }
+    }
+    node.huge_pages = _topology.huge_pages;
+    _topology.nodes.push_back(std::move(node));
+  }
+  // Windows reports the size of a node only through the SRAT, the total is known for a single node
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (_topology.nodes.size() == 1 && GlobalMemoryStatusEx(&status)) {
+    _topology.nodes.front().total_Bytes = static_cast<int64_t>(status.ullTotalPhys);
+  }
+  refreshNodes();
+}
+
+// _____________________________________________________________________________________________________________________
+void Memory::refreshNodes() {
+  for (auto& node : _topology.nodes) {
+    ULONGLONG available = 0;
+    node.free_Bytes = GetNumaAvailableMemoryNodeEx(static_cast<USHORT>(node.id), &available)
+                          ? static_cast<int64_t>(available)
+                          : -1;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryLimits Memory::limits() {
+  // TODO: implement (job object memory limits via QueryInformationJobObject)
+  return {};
+}
+
+// _____________________________________________________________________________________________________________________
+MemoryPressure Memory::pressure() {
+  // pressure stall information is Linux specific
+  return {};
+}
+
+// _____________________________________________________________________________________________________________________
+MemorySampler::MemorySampler() = default;
+
+// _____________________________________________________________________________________________________________________
+MemorySampler::~MemorySampler() = default;
+
+// _____________________________________________________________________________________________________________________
+MemoryStats MemorySampler::sample() { return Memory::snapshot(); }
+
+// _____________________________________________________________________________________________________________________
+MemoryPressureTrigger::MemoryPressureTrigger(std::chrono::microseconds, std::chrono::microseconds, bool) {}
+
+// _____________________________________________________________________________________________________________________
+MemoryPressureTrigger::~MemoryPressureTrigger() = default;
+
+// _____________________________________________________________________________________________________________________
+bool MemoryPressureTrigger::wait(std::chrono::milliseconds) { return false; }
+
 }  // namespace hwinfo
 
 #endif  // HWINFO_WINDOWS
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "hwinfo/utils/pdh_wrapper.h"
+
+#ifdef HWINFO_WINDOWS
+
+#include <PdhMsg.h>
+
+#include <cwchar>
+#include <memory>
+#include <vector>
+
+namespace hwinfo {
+namespace utils {
+namespace PDH {
+
+namespace {
+
+// Reads all instances of a wildcard counter. Instances are named "<group>,<number>" (plus "<group>,_Total" and
+// "_Total"), the value of "<group>,<number>" is stored at per_thread[group * 64 + number], -1 for unused numbers.
+bool read_instances(PDH_HCOUNTER counter, std::vector<double>& per_thread) {
+  DWORD size = 0;
+  DWORD count = 0;
+  PDH_STATUS status = PdhGetFormattedCounterArrayW(counter, PDH_FMT_DOUBLE | PDH_FMT_NOCAP100, &size, &count, nullptr);
+  if (status != PDH_MORE_DATA) {
+    return false;
+  }
+  std::unique_ptr<BYTE[]> buffer(new BYTE[size]);
+  auto* items = reinterpret_cast<PDH_FMT_COUNTERVALUE_ITEM_W*>(buffer.get());
+  status = PdhGetFormattedCounterArrayW(counter, PDH_FMT_DOUBLE | PDH_FMT_NOCAP100, &size, &count, items);
+  if (status != ERROR_SUCCESS) {
+    return false;
+  }
+  per_thread.clear();
+  for (DWORD i = 0; i < count; ++i) {
+    const wchar_t* name = items[i].szName;
+    const bool valid = items[i].FmtValue.CStatus == PDH_CSTATUS_VALID_DATA ||
+                       items[i].FmtValue.CStatus == PDH_CSTATUS_NEW_DATA;
+    const double value = valid ? items[i].FmtValue.doubleValue / 100.0 : -1.0;
+    const wchar_t* comma = std::wcschr(name, L',');
+    if (comma == nullptr || std::wcscmp(comma + 1, L"_Total") == 0) {
+      continue;
+    }
+    const long group = std::wcstol(name, nullptr, 10);
+    const long number = std::wcstol(comma + 1, nullptr, 10);
+    if (group < 0 || number < 0 || number >= 64) {
+      continue;
+    }
+    const size_t cpu = static_cast<size_t>(group) * 64 + static_cast<size_t>(number);
+    if (cpu >= per_thread.size()) per_thread.resize(cpu + 1, -1.0);
+    per_thread[cpu] = value;
+  }
+  return true;
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+ProcessorCounters::~ProcessorCounters() {
+  if (_query) {
+    PdhCloseQuery(_query);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+ProcessorCounters* ProcessorCounters::get() {
+  thread_local ProcessorCounters counters;
+  thread_local bool opened = counters.open();
+  return opened ? &counters : nullptr;
+}
+
+// _____________________________________________________________________________________________________________________
+bool ProcessorCounters::open() {
+  if (PdhOpenQueryW(nullptr, 0, &_query) != ERROR_SUCCESS) {
+    _query = nullptr;
+    return false;
+  }
+  // English names, so the counters are found on localized systems as well
+  if (PdhAddEnglishCounterW(_query, L"\\Processor Information(*)\\% Processor Performance", 0, &_performance) !=
+      ERROR_SUCCESS) {
+    PdhCloseQuery(_query);
+    _query = nullptr;
+    return false;
+  }
+  // rate counters need a first sample as reference
+  return PdhCollectQueryData(_query) == ERROR_SUCCESS;
+}
+
+// _____________________________________________________________________________________________________________________
+bool ProcessorCounters::collect() { return _query && PdhCollectQueryData(_query) == ERROR_SUCCESS; }
+
+// _____________________________________________________________________________________________________________________
+bool ProcessorCounters::performance(std::vector<double>& per_thread) const {
+  return read_instances(_performance, per_thread);
+}
+
+// _____________________________________________________________________________________________________________________
+EnergyMeter::EnergyMeter() {
+  if (PdhOpenQueryW(nullptr, 0, &_query) != ERROR_SUCCESS) {
+    _query = nullptr;
+    return;
+  }
+  if (PdhAddEnglishCounterW(_query, L"\\Energy Meter(*)\\Energy", 0, &_energy) != ERROR_SUCCESS) {
+    PdhCloseQuery(_query);
+    _query = nullptr;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+EnergyMeter::~EnergyMeter() {
+  if (_query) {
+    PdhCloseQuery(_query);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool EnergyMeter::collect(std::vector<int64_t>& energy_uJ) {
+  if (_query == nullptr || PdhCollectQueryData(_query) != ERROR_SUCCESS) {
+    return false;
+  }
+  DWORD size = 0;
+  DWORD count = 0;
+  if (PdhGetRawCounterArrayW(_energy, &size, &count, nullptr) != PDH_MORE_DATA) {
+    return false;
+  }
+  std::unique_ptr<BYTE[]> buffer(new BYTE[size]);
+  auto* items = reinterpret_cast<PDH_RAW_COUNTER_ITEM_W*>(buffer.get());
+  if (PdhGetRawCounterArrayW(_energy, &size, &count, items) != ERROR_SUCCESS) {
+    return false;
+  }
+  energy_uJ.clear();
+  // other instances are the DRAM, PP0 (cores) and PSYS domains
+  constexpr wchar_t prefix[] = L"RAPL_Package";
+  constexpr size_t prefix_length = sizeof(prefix) / sizeof(wchar_t) - 1;
+  for (DWORD i = 0; i < count; ++i) {
+    const wchar_t* name = items[i].szName;
+    if (std::wcsncmp(name, prefix, prefix_length) != 0) {
+      continue;
+    }
+    wchar_t* end = nullptr;
+    const long package = std::wcstol(name + prefix_length, &end, 10);
+    if (end == name + prefix_length || std::wcscmp(end, L"_PKG") != 0 || package < 0 || package >= 64) {
+      continue;
+    }
+    if (static_cast<size_t>(package) >= energy_uJ.size()) energy_uJ.resize(static_cast<size_t>(package) + 1, -1);
+    // 1 pWh = 3.6e-9 J = 3.6e-3 uJ
+    energy_uJ[static_cast<size_t>(package)] = items[i].RawValue.FirstValue * 36 / 10000;
+  }
+  return true;
+}
+
+}  // namespace PDH
+}  // namespace utils
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
@@ -0,0 +1,39 @@
+#include "hwinfo/platform.h"
+
+#ifdef HWINFO_WINDOWS
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "hwinfo/utils/smbios.h"
+
+namespace hwinfo {
+namespace utils {
+namespace SMBIOS {
+
+// _____________________________________________________________________________________________________________________
+std::vector<uint8_t> read_table() {
+  // 'RSMB' returns a RawSMBIOSData header (calling method, version, length) followed by the structure table
+  constexpr DWORD provider = 'RSMB';
+  constexpr size_t header_size = 8;
+  std::vector<uint8_t> buffer(GetSystemFirmwareTable(provider, 0, nullptr, 0));
+  if (buffer.size() <= header_size ||
+      GetSystemFirmwareTable(provider, 0, buffer.data(), static_cast<DWORD>(buffer.size())) != buffer.size()) {
+    return {};
+  }
+  uint32_t length;
+  std::memcpy(&length, buffer.data() + 4, sizeof(length));
+  if (length > buffer.size() - header_size) {
+    length = static_cast<uint32_t>(buffer.size() - header_size);
+  }
+  return {buffer.begin() + header_size, buffer.begin() + header_size + length};
+}
+
+}  // namespace SMBIOS
+}  // namespace utils
+}  // namespace hwinfo
+
+#endif  // HWINFO_WINDOWS
@@ -2,40 +2,598 @@
 
 #ifdef HWINFO_WINDOWS
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "hwinfo/utils/instrumentation.h"
 #include "hwinfo/utils/stringutils.h"
 
 namespace hwinfo {
 namespace utils {
 namespace WMI {
 
-_WMI::_WMI() {
-  auto res = CoInitializeSecurity(nullptr, -1, nullptr, nullptr, RPC_C_AUTHN_LEVEL_DEFAULT, RPC_C_IMP_LEVEL_IMPERSONATE,
-                                  nullptr, EOAC_NONE, nullptr);
-  res &= CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
-  res &= CoCreateInstance(CLSID_WbemLocator, nullptr, CLSCTX_INPROC_SERVER, IID_IWbemLocator, (LPVOID*)&locator);
-  if (locator) {
-    res &= locator->ConnectServer(_bstr_t("ROOT\\CIMV2"), nullptr, nullptr, nullptr, 0, nullptr, nullptr, &service);
-    if (service)
-      res &= CoSetProxyBlanket(service, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, nullptr, RPC_C_AUTHN_LEVEL_CALL,
-                               RPC_C_IMP_LEVEL_IMPERSONATE, nullptr, EOAC_NONE);
-  }
-  if (!SUCCEEDED(res)) {
+// _____________________________________________________________________________________________________________________
+Session::Session() {
+  // COM must be initialized once per thread. RPC_E_CHANGED_MODE means the host application already initialized this
+  // thread with another apartment model, which we can use as well (but must not uninitialize).
+  const HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+  _com_initialized = SUCCEEDED(hr);
+  // process wide, may only be called once. RPC_E_TOO_LATE is returned if the host application already did.
+  static std::once_flag security_initialized;
+  std::call_once(security_initialized, [] {
+    CoInitializeSecurity(nullptr, -1, nullptr, nullptr, RPC_C_AUTHN_LEVEL_DEFAULT, RPC_C_IMP_LEVEL_IMPERSONATE, nullptr,
+                         EOAC_NONE, nullptr);
+  });
+}
+
+// _____________________________________________________________________________________________________________________
+Session::~Session() {
+  reset();
+  if (_com_initialized) {
+    CoUninitialize();
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+Session& Session::get() {
+  thread_local Session session;
+  return session;
+}
+
+// _____________________________________________________________________________________________________________________
+IWbemServices* Session::connect(const wchar_t* name_space) {
+  if (_locator == nullptr) {
+    const HRESULT hr =
+        CoCreateInstance(CLSID_WbemLocator, nullptr, CLSCTX_INPROC_SERVER, IID_IWbemLocator, (LPVOID*)&_locator);
+    if (FAILED(hr) || _locator == nullptr) {
+      _locator = nullptr;
+      return nullptr;
+    }
+  }
+  IWbemServices* service = nullptr;
+  HRESULT hr = _locator->ConnectServer(_bstr_t(name_space), nullptr, nullptr, nullptr, 0, nullptr, nullptr, &service);
+  if (FAILED(hr) || service == nullptr) {
+    return nullptr;
+  }
+  hr = CoSetProxyBlanket(service, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, nullptr, RPC_C_AUTHN_LEVEL_CALL,
+                         RPC_C_IMP_LEVEL_IMPERSONATE, nullptr, EOAC_NONE);
+  if (FAILED(hr)) {
+    service->Release();
+    return nullptr;
+  }
+  _connections.push_back({name_space, service});
+  return service;
+}
+
+// _____________________________________________________________________________________________________________________
+IWbemServices* Session::service(const wchar_t* name_space) {
+  for (const auto& connection : _connections) {
+    if (connection.name_space == name_space) {
+      return connection.service;
+    }
+  }
+  return connect(name_space);
+}
+
+// _____________________________________________________________________________________________________________________
+void Session::reset() {
+  for (auto& connection : _connections) {
+    connection.service->Release();
+  }
+  _connections.clear();
+  if (_locator) {
+    _locator->Release();
+    _locator = nullptr;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+bool is_connection_error(HRESULT hr) {
+  switch (static_cast<uint32_t>(hr)) {
+    case static_cast<uint32_t>(RPC_E_DISCONNECTED):
+    case static_cast<uint32_t>(RPC_E_SERVERFAULT):
+    case static_cast<uint32_t>(WBEM_E_TRANSPORT_FAILURE):
+    case 0x800706BAu:  // RPC_S_SERVER_UNAVAILABLE
+    case 0x800706BEu:  // RPC_S_CALL_FAILED
+    case 0x800706BFu:  // RPC_S_CALL_FAILED_DNE
+      return true;
+    default:
+      return false;
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+_WMI::_WMI(const wchar_t* name_space) : name_space(name_space) {
+  service = Session::get().service(name_space);
+  if (service == nullptr) {
     throw std::runtime_error("error initializing WMI");
   }
 }
 
+// _____________________________________________________________________________________________________________________
 _WMI::~_WMI() {
-  if (locator) locator->Release();
-  if (service) service->Release();
-  CoUninitialize();
+  if (enumerator) enumerator->Release();
 }
 
+// _____________________________________________________________________________________________________________________
 bool _WMI::execute_query(const std::wstring& query) {
   if (service == nullptr) return false;
-  return SUCCEEDED(service->ExecQuery(bstr_t(L"WQL"), bstr_t(std::wstring(query.begin(), query.end()).c_str()),
-                                      WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, nullptr, &enumerator));
+  if (enumerator) {
+    enumerator->Release();
+    enumerator = nullptr;
+  }
+  HWINFO_COUNT_SYSCALL();
+  HRESULT hr = service->ExecQuery(bstr_t(L"WQL"), bstr_t(query.c_str()),
+                                  WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, nullptr, &enumerator);
+  if (is_connection_error(hr)) {
+    // the pooled connection is gone: reconnect once and retry
+    Session& session = Session::get();
+    session.reset();
+    service = session.service(name_space);
+    if (service == nullptr) return false;
+    hr = service->ExecQuery(bstr_t(L"WQL"), bstr_t(query.c_str()),
+                            WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, nullptr, &enumerator);
+  }
+  return SUCCEEDED(hr);
+}
+
+// _____________________________________________________________________________________________________________________
+static Value to_value(const VARIANT& v) {
+  switch (V_VT(&v)) {
+    case VT_BSTR:
+      return wstring_to_std_string(v.bstrVal);
+    case VT_BOOL:
+      return v.boolVal != VARIANT_FALSE;
+    case VT_I1:
+      return static_cast<int64_t>(v.cVal);
+    case VT_I2:
+      return static_cast<int64_t>(v.iVal);
+    case VT_I4:
+    case VT_INT:
+      return static_cast<int64_t>(v.lVal);
+    case VT_I8:
+      return static_cast<int64_t>(v.llVal);
+    case VT_UI1:
+      return static_cast<uint64_t>(v.bVal);
+    case VT_UI2:
+      return static_cast<uint64_t>(v.uiVal);
+    case VT_UI4:
+    case VT_UINT:
+      return static_cast<uint64_t>(v.ulVal);
+    case VT_UI8:
+      return static_cast<uint64_t>(v.ullVal);
+    case VT_R4:
+      return static_cast<double>(v.fltVal);
+    case VT_R8:
+      return v.dblVal;
+    default:
+      // VT_NULL, VT_EMPTY, arrays and objects
+      return std::monostate{};
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+static std::wstring select_query(const std::wstring& wmi_class, const std::vector<std::wstring>& fields,
+                                 const std::wstring& filter) {
+  std::wstring query_string(L"SELECT ");
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (i > 0) query_string.append(L", ");
+    query_string.append(fields[i]);
+  }
+  query_string.append(L" FROM " + wmi_class);
+  if (!filter.empty()) {
+    query_string.append(L" WHERE " + filter);
+  }
+  return query_string;
+}
+
+// _____________________________________________________________________________________________________________________
+static Row to_row(IWbemClassObject* object, const std::vector<std::wstring>& fields) {
+  Row row;
+  row.reserve(fields.size());
+  for (const auto& field : fields) {
+    VARIANT vt_prop;
+    VariantInit(&vt_prop);
+    if (SUCCEEDED(object->Get(field.c_str(), 0, &vt_prop, nullptr, nullptr))) {
+      row.push_back(to_value(vt_prop));
+    } else {
+      row.emplace_back(std::monostate{});
+    }
+    VariantClear(&vt_prop);
+  }
+  return row;
+}
+
+// _____________________________________________________________________________________________________________________
+std::vector<Row> query_rows(const std::wstring& wmi_class, const std::vector<std::wstring>& fields,
+                            const std::wstring& filter, const wchar_t* name_space) {
+  HWINFO_PROBE("wmi.query");
+  std::vector<Row> rows;
+  if (fields.empty()) {
+    return rows;
+  }
+  _WMI wmi(name_space);
+  if (!wmi.execute_query(select_query(wmi_class, fields, filter))) {
+    return rows;
+  }
+
+  constexpr ULONG batch_size = 32;
+  IWbemClassObject* objects[batch_size];
+  while (wmi.enumerator) {
+    ULONG u_return = 0;
+    const HRESULT hr = wmi.enumerator->Next(WBEM_INFINITE, batch_size, objects, &u_return);
+    HWINFO_COUNT_SYSCALL();
+    for (ULONG i = 0; i < u_return; ++i) {
+      rows.push_back(to_row(objects[i], fields));
+      objects[i]->Release();
+    }
+    // WBEM_S_FALSE: fewer objects than requested, the enumeration is complete
+    if (hr != WBEM_S_NO_ERROR) {
+      break;
+    }
+  }
+  return rows;
+}
+
+namespace {
+
+/**
+ * Receives the objects of an ExecQueryAsync call. WMI delivers them via Indicate() and signals the end of the query
+ * (success, failure or cancellation) with SetStatus(WBEM_STATUS_COMPLETE, ...).
+ */
+class RowSink : public IWbemObjectSink {
+ public:
+  explicit RowSink(const std::vector<std::wstring>& fields) : _fields(fields) {
+    _done = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  }
+  RowSink(const RowSink&) = delete;
+  RowSink& operator=(const RowSink&) = delete;
+
+  ULONG STDMETHODCALLTYPE AddRef() override { return ++_ref_count; }
+
+  ULONG STDMETHODCALLTYPE Release() override {
+    const ULONG count = --_ref_count;
+    if (count == 0) {
+      delete this;
+    }
+    return count;
+  }
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override {
+    if (riid == IID_IUnknown || riid == IID_IWbemObjectSink) {
+      *ppv = static_cast<IWbemObjectSink*>(this);
+      AddRef();
+      return WBEM_S_NO_ERROR;
+    }
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+  }
+
+  HRESULT STDMETHODCALLTYPE Indicate(LONG count, IWbemClassObject** objects) override {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (LONG i = 0; i < count; ++i) {
+      _rows.push_back(to_row(objects[i], _fields));
+    }
+    return WBEM_S_NO_ERROR;
+  }
+
+  HRESULT STDMETHODCALLTYPE SetStatus(LONG flags, HRESULT result, BSTR, IWbemClassObject*) override {
+    if (flags == WBEM_STATUS_COMPLETE) {
+      _result = result;
+      SetEvent(_done);
+    }
+    return WBEM_S_NO_ERROR;
+  }
+
+  HANDLE done() const { return _done; }
+  HRESULT result() const { return _result; }
+
+  std::vector<Row> take_rows() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return std::move(_rows);
+  }
+
+ private:
+  ~RowSink() {
+    if (_done) CloseHandle(_done);
+  }
+
+  std::atomic<ULONG> _ref_count{1};
+  std::vector<std::wstring> _fields;
+  std::mutex _mutex;
+  std::vector<Row> _rows;
+  HANDLE _done = nullptr;
+  std::atomic<HRESULT> _result{WBEM_E_FAILED};
+};
+
+struct AsyncJob {
+  std::wstring query;
+  std::vector<std::wstring> fields;
+  std::chrono::milliseconds timeout;
+  RowsCallback callback;
+};
+
+/**
+ * The one thread that runs all asynchronous queries on its pooled Session. ExecQueryAsync returns immediately, so the
+ * worker issues every queued query at once and waits for their sinks together: independent queries run concurrently
+ * in WMI over one connection instead of each paying for COM initialization and ConnectServer on a thread of its own.
+ * The wait pumps COM messages, which is required to receive the sink calls in a single-threaded apartment.
+ */
+class AsyncWorker {
+ public:
+  AsyncWorker() : _wake(CreateEventW(nullptr, FALSE, FALSE, nullptr)), _thread(&AsyncWorker::run, this) {}
+  AsyncWorker(const AsyncWorker&) = delete;
+  AsyncWorker& operator=(const AsyncWorker&) = delete;
+
+  // cancels the running queries, their callbacks and those of the queued ones report incomplete results
+  ~AsyncWorker() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    SetEvent(_wake);
+    _thread.join();
+    if (_wake) CloseHandle(_wake);
+  }
+
+  void submit(AsyncJob job) {
+    if (_wake == nullptr) {
+      if (job.callback) job.callback({}, false);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _queue.push_back(std::move(job));
+    }
+    SetEvent(_wake);
+  }
+
+ private:
+  struct Running {
+    RowSink* sink;
+    // referenced until the query finished, a reconnect of the session must not release it
+    IWbemServices* service;
+    std::chrono::steady_clock::time_point deadline;
+    RowsCallback callback;
+  };
+
+  static bool start(Session& session, AsyncJob& job, Running& running);
+  static void finish(Running& running, bool complete);
+  void run();
+
+  HANDLE _wake;
+  std::mutex _mutex;
+  std::deque<AsyncJob> _queue;
+  bool _stop = false;
+  std::thread _thread;
+};
+
+// _____________________________________________________________________________________________________________________
+bool AsyncWorker::start(Session& session, AsyncJob& job, Running& running) {
+  IWbemServices* service = session.service();
+  if (service == nullptr || job.fields.empty()) {
+    return false;
+  }
+  auto* sink = new RowSink(job.fields);
+  if (sink->done() == nullptr) {
+    sink->Release();
+    return false;
+  }
+  HWINFO_COUNT_SYSCALL();
+  HRESULT hr =
+      service->ExecQueryAsync(bstr_t(L"WQL"), bstr_t(job.query.c_str()), WBEM_FLAG_BIDIRECTIONAL, nullptr, sink);
+  if (is_connection_error(hr)) {
+    // the pooled connection is gone: reconnect once and retry
+    session.reset();
+    service = session.service();
+    hr = service ? service->ExecQueryAsync(bstr_t(L"WQL"), bstr_t(job.query.c_str()), WBEM_FLAG_BIDIRECTIONAL,
+                                           nullptr, sink)
+                 : WBEM_E_FAILED;
+  }
+  if (FAILED(hr)) {
+    sink->Release();
+    return false;
+  }
+  service->AddRef();
+  running.sink = sink;
+  running.service = service;
+  running.deadline = std::chrono::steady_clock::now() + job.timeout;
+  running.callback = std::move(job.callback);
+  return true;
+}
+
+// _____________________________________________________________________________________________________________________
+void AsyncWorker::finish(Running& running, bool complete) {
+  if (!complete) {
+    // WMI releases its reference to the sink after the cancellation
+    running.service->CancelAsyncCall(running.sink);
+  }
+  std::vector<Row> rows = running.sink->take_rows();
+  running.sink->Release();
+  running.service->Release();
+  if (running.callback) {
+    running.callback(std::move(rows), complete);
+  }
+}
+
+// _____________________________________________________________________________________________________________________
+void AsyncWorker::run() {
+  // without the event submit() fails every query right away
+  if (_wake == nullptr) {
+    return;
+  }
+  Session& session = Session::get();
+  std::vector<Running> running;
+  std::vector<HANDLE> handles;
+  while (true) {
+    std::deque<AsyncJob> jobs;
+    bool stop = false;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      stop = _stop;
+      if (stop) {
+        jobs.swap(_queue);
+      } else {
+        // one wait takes at most MAXIMUM_WAIT_OBJECTS handles including _wake, the rest stays queued
+        while (!_queue.empty() && running.size() + jobs.size() < static_cast<size_t>(MAXIMUM_WAIT_OBJECTS - 1)) {
+          jobs.push_back(std::move(_queue.front()));
+          _queue.pop_front();
+        }
+      }
+    }
+    if (stop) {
+      for (auto& query : running) {
+        finish(query, false);
+      }
+      for (auto& job : jobs) {
+        if (job.callback) job.callback({}, false);
+      }
+      return;
+    }
+    for (auto& job : jobs) {
+      Running query{};
+      if (start(session, job, query)) {
+        running.push_back(std::move(query));
+      } else if (job.callback) {
+        job.callback({}, false);
+      }
+    }
+
+    handles.assign(1, _wake);
+    auto next_deadline = std::chrono::steady_clock::time_point::max();
+    for (const auto& query : running) {
+      handles.push_back(query.sink->done());
+      next_deadline = std::min(next_deadline, query.deadline);
+    }
+    DWORD timeout_ms = INFINITE;
+    if (!running.empty()) {
+      const auto remaining =
+          std::chrono::ceil<std::chrono::milliseconds>(next_deadline - std::chrono::steady_clock::now());
+      timeout_ms = static_cast<DWORD>(std::max<int64_t>(remaining.count(), 0));
+    }
+    DWORD index = 0;
+    CoWaitForMultipleHandles(0, timeout_ms, static_cast<ULONG>(handles.size()), handles.data(), &index);
+
+    // complete the finished and the timed out queries, keep the others running
+    const auto now = std::chrono::steady_clock::now();
+    size_t kept = 0;
+    for (size_t i = 0; i < running.size(); ++i) {
+      Running& query = running[i];
+      if (WaitForSingleObject(query.sink->done(), 0) == WAIT_OBJECT_0) {
+        finish(query, SUCCEEDED(query.sink->result()));
+      } else if (now >= query.deadline) {
+        finish(query, false);
+      } else if (kept++ != i) {
+        running[kept - 1] = std::move(query);
+      }
+    }
+    running.erase(running.begin() + static_cast<std::ptrdiff_t>(kept), running.end());
+  }
+}
+
+// started by the first asynchronous query, stopped and joined by shutdown_async_queries() or at exit
+std::mutex worker_mutex;
+std::unique_ptr<AsyncWorker> worker;
+
+// _____________________________________________________________________________________________________________________
+void submit(AsyncJob job) {
+  std::lock_guard<std::mutex> lock(worker_mutex);
+  if (!worker) {
+    worker = std::make_unique<AsyncWorker>();
+  }
+  worker->submit(std::move(job));
+}
+
+}  // namespace
+
+// _____________________________________________________________________________________________________________________
+std::future<std::vector<Row>> query_rows_async(const std::wstring& wmi_class, const std::vector<std::wstring>& fields,
+                                               const std::wstring& filter, std::chrono::milliseconds timeout) {
+  auto promise = std::make_shared<std::promise<std::vector<Row>>>();
+  auto future = promise->get_future();
+  submit({select_query(wmi_class, fields, filter), fields, timeout,
+          [promise](std::vector<Row> rows, bool) { promise->set_value(std::move(rows)); }});
+  return future;
+}
+
+// _____________________________________________________________________________________________________________________
+void query_rows_async(const std::wstring& wmi_class, const std::vector<std::wstring>& fields,
+                      const std::wstring& filter, std::chrono::milliseconds timeout, RowsCallback callback) {
+  submit({select_query(wmi_class, fields, filter), fields, timeout, std::move(callback)});
+}
+
+// _____________________________________________________________________________________________________________________
+void shutdown_async_queries() {
+  std::unique_ptr<AsyncWorker> stopped;
+  {
+    std::lock_guard<std::mutex> lock(worker_mutex);
+    stopped = std::move(worker);
+  }
+  // stopped is joined outside of the lock as it goes out of scope, the callbacks of the cancelled queries may submit
+  // new ones
+}
+
+// _____________________________________________________________________________________________________________________
+std::string as_string(const Value& value, const std::string& fallback) {
+  if (const auto* str = std::get_if<std::string>(&value)) {
+    return *str;
+  }
+  if (const auto* i = std::get_if<int64_t>(&value)) {
+    return std::to_string(*i);
+  }
+  if (const auto* u = std::get_if<uint64_t>(&value)) {
+    return std::to_string(*u);
+  }
+  return fallback;
+}
+
+// _____________________________________________________________________________________________________________________
+int64_t as_int64(const Value& value, int64_t fallback) {
+  if (const auto* i = std::get_if<int64_t>(&value)) {
+    return *i;
+  }
+  if (const auto* u = std::get_if<uint64_t>(&value)) {
+    return static_cast<int64_t>(*u);
+  }
+  if (const auto* d = std::get_if<double>(&value)) {
+    return static_cast<int64_t>(*d);
+  }
+  if (const auto* str = std::get_if<std::string>(&value)) {
+    // (u)int64 properties are transported as strings
+    return toNumber<int64_t>(*str).value_or(fallback);
+  }
+  return fallback;
+}
+
+// _____________________________________________________________________________________________________________________
+double as_double(const Value& value, double fallback) {
+  if (const auto* d = std::get_if<double>(&value)) {
+    return *d;
+  }
+  if (std::holds_alternative<int64_t>(value) || std::holds_alternative<uint64_t>(value)) {
+    return static_cast<double>(as_int64(value));
+  }
+  if (const auto* str = std::get_if<std::string>(&value)) {
+    return toDouble(*str).value_or(fallback);
+  }
+  return fallback;
+}
+
+// _____________________________________________________________________________________________________________________
+bool as_bool(const Value& value, bool fallback) {
+  if (const auto* b = std::get_if<bool>(&value)) {
+    return *b;
+  }
+  return fallback;
 }
 
 template <>
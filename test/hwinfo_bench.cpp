@@ -0,0 +1,377 @@
+// Copyright Leon Freist
+// Author Leon Freist <freist@informatik.uni-freiburg.de>
+
+#include <benchmark/benchmark.h>
+#include <hwinfo/hwinfo.h>
+#include <hwinfo/utils/PCIMapper.h>
+#include <hwinfo/utils/ring_buffer.h>
+#include <hwinfo/utils/wmi_wrapper.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Micro-benchmarks measure single collectors and parsers, macro-benchmarks a full snapshot and one round of steady
+// state polling. Run with --benchmark_format=json (or the hwinfo_bench_json target) to track regressions.
+
+namespace {
+
+// === Micro-benchmarks: enumeration and parsing =======================================================================
+
+#ifdef HWINFO_UNIX
+// _____________________________________________________________________________________________________________________
+void BM_PCIMapperConstruction(benchmark::State& state) {
+  for (auto _ : state) {
+    hwinfo::PCIMapper mapper;
+    benchmark::DoNotOptimize(mapper.vendor_from_id(uint16_t{0x8086}));
+  }
+}
+BENCHMARK(BM_PCIMapperConstruction);
+
+// _____________________________________________________________________________________________________________________
+void BM_PCIMapperLookup(benchmark::State& state) {
+  const auto& mapper = hwinfo::PCI::getMapper();
+  for (auto _ : state) {
+    const auto vendor = mapper.vendor_from_id(uint16_t{0x10de});
+    benchmark::DoNotOptimize(vendor[uint16_t{0x2484}].device_name);
+  }
+}
+BENCHMARK(BM_PCIMapperLookup);
+
+// _____________________________________________________________________________________________________________________
+void BM_PCIMapperResolve(benchmark::State& state) {
+  const auto& mapper = hwinfo::PCI::getMapper();
+  std::vector<hwinfo::PCIId> ids;
+  for (const auto& device : hwinfo::getAllPCIDevices()) {
+    ids.push_back({device.vendor_id(), device.device_id(), device.subvendor_id(), device.subdevice_id()});
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mapper.resolve(ids));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ids.size()));
+}
+BENCHMARK(BM_PCIMapperResolve);
+#endif
+
+// _____________________________________________________________________________________________________________________
+void BM_CpuJiffies(benchmark::State& state) {
+  // CpuSampler::sample() is one read of the CPU time counters (/proc/stat on Linux) plus the deltas
+  hwinfo::CpuSampler sampler;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sampler.sample());
+  }
+}
+BENCHMARK(BM_CpuJiffies);
+
+// _____________________________________________________________________________________________________________________
+void BM_GetAllCPUs(benchmark::State& state) {
+  // includes parsing /proc/cpuinfo on Linux
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::getAllCPUs());
+  }
+}
+BENCHMARK(BM_GetAllCPUs)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_CpuFeatures(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::CpuFeatures::host().names());
+  }
+}
+BENCHMARK(BM_CpuFeatures);
+
+// _____________________________________________________________________________________________________________________
+void BM_CpuTopology(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::getCpuTopology());
+  }
+}
+BENCHMARK(BM_CpuTopology)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_MemorySnapshot(benchmark::State& state) {
+  // parses /proc/meminfo on Linux
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::Memory::snapshot());
+  }
+}
+BENCHMARK(BM_MemorySnapshot);
+
+// _____________________________________________________________________________________________________________________
+void BM_MemorySampler(benchmark::State& state) {
+  // one pread of the open /proc/meminfo on Linux
+  hwinfo::MemorySampler memory;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(memory.sample());
+  }
+}
+BENCHMARK(BM_MemorySampler);
+
+// _____________________________________________________________________________________________________________________
+void BM_Memory(benchmark::State& state) {
+  for (auto _ : state) {
+    hwinfo::Memory memory;
+    benchmark::DoNotOptimize(memory.total_Bytes());
+  }
+}
+BENCHMARK(BM_Memory)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_MemoryRefreshTopology(benchmark::State& state) {
+  // /proc/meminfo, the cgroup and one meminfo read per NUMA node
+  hwinfo::Memory memory(hwinfo::MemoryFields::Topology);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(memory.refresh());
+  }
+}
+BENCHMARK(BM_MemoryRefreshTopology);
+
+// _____________________________________________________________________________________________________________________
+void BM_GetAllDisks(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::getAllDisks());
+  }
+}
+BENCHMARK(BM_GetAllDisks)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_GetAllNetworks(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::getAllNetworks());
+  }
+}
+BENCHMARK(BM_GetAllNetworks)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_InterruptSample(benchmark::State& state) {
+  hwinfo::InterruptSampler sampler;
+  sampler.sample();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sampler.sample());
+  }
+}
+BENCHMARK(BM_InterruptSample)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_ProcessSample(benchmark::State& state) {
+  hwinfo::ProcessSampler sampler(state.range(0) != 0);
+  sampler.sample();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sampler.sample());
+  }
+}
+BENCHMARK(BM_ProcessSample)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_PerfCounterSample(benchmark::State& state) {
+  hwinfo::PerfCounterSampler sampler;
+  if (!sampler.available()) {
+    state.SkipWithError(sampler.error().c_str());
+    return;
+  }
+  sampler.sample();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sampler.sample());
+  }
+}
+BENCHMARK(BM_PerfCounterSample)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_GetAllGPUs(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::getAllGPUs(false));
+  }
+}
+BENCHMARK(BM_GetAllGPUs)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_GetAllNvmeControllers(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::getAllNvmeControllers());
+  }
+}
+BENCHMARK(BM_GetAllNvmeControllers)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_GetAllPCIDevices(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::getAllPCIDevices());
+  }
+}
+BENCHMARK(BM_GetAllPCIDevices)->Unit(benchmark::kMicrosecond);
+
+#ifdef HWINFO_WINDOWS
+// _____________________________________________________________________________________________________________________
+void BM_WMIQuery(benchmark::State& state) {
+  // the first query of a thread connects the Session, following queries reuse it
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::utils::WMI::query_rows(L"Win32_Processor", {L"Name", L"NumberOfCores"}));
+  }
+}
+BENCHMARK(BM_WMIQuery)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_WMIQueryAsync(benchmark::State& state) {
+  // the inventory queries of a snapshot, issued together to the worker and running concurrently on its Session
+  namespace WMI = hwinfo::utils::WMI;
+  for (auto _ : state) {
+    auto gpus = WMI::query_rows_async(L"Win32_VideoController", {L"Name", L"PNPDeviceID"});
+    auto board = WMI::query_rows_async(L"Win32_BaseBoard", {L"Manufacturer", L"Product"});
+    auto caches = WMI::query_rows_async(L"Win32_CacheMemory", {L"MaxCacheSize"});
+    benchmark::DoNotOptimize(gpus.get());
+    benchmark::DoNotOptimize(board.get());
+    benchmark::DoNotOptimize(caches.get());
+  }
+}
+BENCHMARK(BM_WMIQueryAsync)->Unit(benchmark::kMicrosecond);
+#endif
+
+// === Micro-benchmarks: data paths ====================================================================================
+
+// _____________________________________________________________________________________________________________________
+void BM_RingBuffer(benchmark::State& state) {
+  hwinfo::utils::RingBuffer<hwinfo::Record> buffer(1024);
+  hwinfo::Record record{};
+  for (auto _ : state) {
+    buffer.push(record);
+    buffer.pop(record);
+  }
+}
+BENCHMARK(BM_RingBuffer);
+
+// _____________________________________________________________________________________________________________________
+void BM_TimeSeriesAppend(benchmark::State& state) {
+  hwinfo::TimeSeries series;
+  int64_t timestamp_ms = 0;
+  double value = 0.0;
+  for (auto _ : state) {
+    series.append(timestamp_ms += 1000, value += 0.25);
+  }
+  state.counters["bytes_per_sample"] =
+      static_cast<double>(series.memory_Bytes()) / static_cast<double>(std::max<size_t>(1, series.size()));
+}
+BENCHMARK(BM_TimeSeriesAppend);
+
+// _____________________________________________________________________________________________________________________
+void BM_TimeSeriesAppendCounter(benchmark::State& state) {
+  // a cumulative byte counter as stored for Metric::NetworkTotals
+  hwinfo::TimeSeries series(hwinfo::TimeSeries::Encoding::Counter);
+  int64_t timestamp_ms = 0;
+  double value = 0.0;
+  for (auto _ : state) {
+    series.append(timestamp_ms += 1000, value += 125000.0);
+  }
+  state.counters["bytes_per_sample"] =
+      static_cast<double>(series.memory_Bytes()) / static_cast<double>(std::max<size_t>(1, series.size()));
+}
+BENCHMARK(BM_TimeSeriesAppendCounter);
+
+// _____________________________________________________________________________________________________________________
+void BM_TimeSeriesAggregate(benchmark::State& state) {
+  hwinfo::TimeSeries series;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    series.append(i * 1000, static_cast<double>(i % 100) / 100.0);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(series.aggregate(0, state.range(0) * 1000));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TimeSeriesAggregate)->Arg(600)->Arg(36000);
+
+// === Macro-benchmarks ================================================================================================
+
+// _____________________________________________________________________________________________________________________
+void BM_Snapshot(benchmark::State& state) {
+  hwinfo::Options options;
+  options.gpu_opencl = false;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::collect(options));
+  }
+}
+BENCHMARK(BM_Snapshot)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// _____________________________________________________________________________________________________________________
+void BM_SnapshotSerialize(benchmark::State& state) {
+  hwinfo::Options options;
+  options.gpu_opencl = false;
+  const auto snapshot = hwinfo::collect(options);
+  std::string json;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hwinfo::serializeSnapshot(snapshot));
+    json.clear();
+    hwinfo::JsonWriter writer(json);
+    // CPUs are skipped, their JSON includes a fresh utilisation and clock reading
+    for (const auto& disk : snapshot.disks) hwinfo::to_json(writer, disk);
+    for (const auto& network : snapshot.networks) hwinfo::to_json(writer, network);
+    for (const auto& device : snapshot.pci_devices) hwinfo::to_json(writer, device);
+  }
+}
+BENCHMARK(BM_SnapshotSerialize)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_ArenaSnapshot(benchmark::State& state) {
+  hwinfo::Options options;
+  options.gpu_opencl = false;
+  const auto snapshot = hwinfo::collect(options);
+  const auto serialized = hwinfo::serializeSnapshot(snapshot);
+  const hwinfo::SnapshotView view(serialized);
+  for (auto _ : state) {
+    // copy into an arena versus decoding the serialized form (what InventoryCache hands out)
+    benchmark::DoNotOptimize(hwinfo::ArenaSnapshot(snapshot));
+    benchmark::DoNotOptimize(hwinfo::ArenaSnapshot(view));
+  }
+}
+BENCHMARK(BM_ArenaSnapshot)->Unit(benchmark::kMicrosecond);
+
+// _____________________________________________________________________________________________________________________
+void BM_CapiCollect(benchmark::State& state) {
+  std::vector<hwinfo_network> networks;
+  std::vector<hwinfo_str> items;
+  for (auto _ : state) {
+    // what a binding does per snapshot: one call per subsystem and one copy of the string buffer
+    hwinfo_snapshot* snapshot = hwinfo_collect(HWINFO_SUBSYSTEM_CPU | HWINFO_SUBSYSTEM_NETWORK, 0);
+    networks.resize(hwinfo_get_networks(snapshot, nullptr, 0));
+    hwinfo_get_networks(snapshot, networks.data(), networks.size());
+    items.resize(hwinfo_get_list_items(snapshot, nullptr, 0));
+    hwinfo_get_list_items(snapshot, items.data(), items.size());
+    size_t size = 0;
+    const char* strings = hwinfo_strings(snapshot, &size);
+    benchmark::DoNotOptimize(std::string(strings, size));
+    hwinfo_snapshot_free(snapshot);
+  }
+}
+BENCHMARK(BM_CapiCollect)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// _____________________________________________________________________________________________________________________
+void BM_SteadyStatePolling(benchmark::State& state) {
+  // one round of what the Collector does per interval, with all handles already open
+  hwinfo::CpuSampler cpu;
+  hwinfo::FrequencySampler frequency;
+  std::vector<int64_t> frequencies_MHz;
+  hwinfo::MemorySampler memory;
+  hwinfo::DiskIOSampler disks;
+  auto networks = hwinfo::getAllNetworks(hwinfo::NetworkFields::Statistics);
+  std::vector<std::unique_ptr<hwinfo::GPUMonitor>> gpus;
+  for (const auto& gpu : hwinfo::getAllGPUs(false)) {
+    gpus.push_back(std::make_unique<hwinfo::GPUMonitor>(gpu, 1));
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cpu.sample());
+    frequency.sample(frequencies_MHz);
+    benchmark::DoNotOptimize(memory.sample());
+    benchmark::DoNotOptimize(disks.sample());
+    for (auto& network : networks) {
+      network.refresh(hwinfo::NetworkFields::Statistics);
+    }
+    for (auto& gpu : gpus) {
+      benchmark::DoNotOptimize(gpu->sample());
+    }
+  }
+}
+BENCHMARK(BM_SteadyStatePolling)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();